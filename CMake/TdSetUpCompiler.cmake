@@ -42,6 +42,24 @@ function(td_set_up_compiler)
     message(FATAL_ERROR "No C++14 support in the compiler. Please upgrade the compiler.")
   endif()
 
+  if (TD_ENABLE_COROUTINES)
+    if (MSVC)
+      set(STD20_FLAG /std:c++20)
+    elseif (WIN32 AND INTEL)
+      set(STD20_FLAG /Qstd=c++20)
+    else()
+      set(STD20_FLAG -std=c++20)
+    endif()
+    check_cxx_compiler_flag(${STD20_FLAG} HAVE_STD20)
+    if (NOT HAVE_STD20)
+      message(FATAL_ERROR "No C++20 support in the compiler, which is required for TD_ENABLE_COROUTINES.")
+    endif()
+    set(STD14_FLAG ${STD20_FLAG})
+    if (MSVC)
+      set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${STD20_FLAG}")
+    endif()
+  endif()
+
   if (MSVC)
     if (CMAKE_CXX_FLAGS_DEBUG MATCHES "/RTC1")
       string(REPLACE "/RTC1" " " CMAKE_CXX_FLAGS_DEBUG "${CMAKE_CXX_FLAGS_DEBUG}")
@@ -15,6 +15,9 @@
 #include "td/utils/Promise.h"
 #include "td/utils/SliceBuilder.h"
 
+#include <new>
+#include <utility>
+
 #if TD_MSVC
 #pragma comment(linker, "/STACK:16777216")
 #endif
@@ -324,9 +327,65 @@ class QueryBench final : public td::Benchmark {
   td::ActorOwn<ServerActor> server_;
 };
 
+struct EventPayload {
+  td::uint64 values[4];
+};
+
+// the same event as created by Event::from_lambda, but allocated with the global operator new
+template <class LambdaT>
+class HeapLambdaEvent final : public td::CustomEvent {
+ public:
+  explicit HeapLambdaEvent(LambdaT func) : f_(std::move(func)) {
+  }
+
+  static void *operator new(size_t size) {
+    return ::operator new(size);
+  }
+  static void operator delete(void *ptr, size_t size) noexcept {
+    ::operator delete(ptr);
+  }
+
+  void run(td::Actor *actor) final {
+    f_();
+  }
+
+ private:
+  LambdaT f_;
+};
+
+template <bool use_small_object_allocator>
+class CustomEventBench final : public td::Benchmark {
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "CustomEvent allocation " << (use_small_object_allocator ? "with" : "without") << " free lists";
+  }
+
+  void run(int n) final {
+    constexpr int BATCH_SIZE = 100;
+    td::vector<td::Event> events;
+    events.reserve(BATCH_SIZE);
+    for (int i = 0; i < n; i += BATCH_SIZE) {
+      for (int j = 0; j < BATCH_SIZE; j++) {
+        EventPayload payload{};
+        auto lambda = [payload] {
+          (void)payload;
+        };
+        if (use_small_object_allocator) {
+          events.push_back(td::Event::from_lambda(std::move(lambda)));
+        } else {
+          events.push_back(td::Event::custom(new HeapLambdaEvent<decltype(lambda)>(std::move(lambda))));
+        }
+      }
+      events.clear();
+    }
+  }
+};
+
 int main() {
   td::init_openssl_threads();
 
+  bench(CustomEventBench<true>());
+  bench(CustomEventBench<false>());
   bench(CreateActorBench());
   bench(RingBench<4>(504, 0));
   bench(RingBench<3>(504, 0));
@@ -0,0 +1,437 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/Client.h"
+#include "td/telegram/td_api.h"
+#include "td/telegram/td_json_client.h"
+
+#include "td/utils/common.h"
+#include "td/utils/format.h"
+#include "td/utils/JsonBuilder.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/Clocks.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Creates many clients in one process and sends them a mix of requests through the native ClientManager interface
+// and through the JSON interface. The requests are test requests, which are answered by Td before setTdlibParameters
+// is called, so neither network nor database is needed, and all the time is spent in MultiImplPool, Td and TdReceiver.
+
+namespace {
+
+enum class RequestType : td::int32 { Empty, SquareInt, String, VectorString };
+
+td::vector<RequestType> parse_request_mix(td::Slice mix) {
+  td::vector<RequestType> result;
+  for (auto part : td::full_split(mix, ',')) {
+    auto name_weight = td::split(part, ':');
+    auto weight = name_weight.second.empty() ? 1 : td::to_integer<int>(name_weight.second);
+    RequestType type;
+    if (name_weight.first == "empty") {
+      type = RequestType::Empty;
+    } else if (name_weight.first == "square") {
+      type = RequestType::SquareInt;
+    } else if (name_weight.first == "string") {
+      type = RequestType::String;
+    } else if (name_weight.first == "vector") {
+      type = RequestType::VectorString;
+    } else {
+      LOG(FATAL) << "Unknown request type " << name_weight.first;
+      UNREACHABLE();
+    }
+    for (int i = 0; i < weight; i++) {
+      result.push_back(type);
+    }
+  }
+  LOG_IF(FATAL, result.empty()) << "Request mix must be non-empty";
+  return result;
+}
+
+td::int32 get_square_argument(td::uint64 request_id) {
+  return static_cast<td::int32>(request_id % 1000);
+}
+
+td::string get_string_argument(td::uint64 request_id) {
+  return PSTRING() << "request " << request_id;
+}
+
+td::vector<td::string> get_vector_argument(td::uint64 request_id) {
+  return {"first", get_string_argument(request_id), "last"};
+}
+
+td::td_api::object_ptr<td::td_api::Function> create_request(RequestType type, td::uint64 request_id) {
+  switch (type) {
+    case RequestType::Empty:
+      return td::td_api::make_object<td::td_api::testCallEmpty>();
+    case RequestType::SquareInt:
+      return td::td_api::make_object<td::td_api::testSquareInt>(get_square_argument(request_id));
+    case RequestType::String:
+      return td::td_api::make_object<td::td_api::testCallString>(get_string_argument(request_id));
+    case RequestType::VectorString:
+      return td::td_api::make_object<td::td_api::testCallVectorString>(get_vector_argument(request_id));
+    default:
+      UNREACHABLE();
+      return nullptr;
+  }
+}
+
+void check_response(RequestType type, td::uint64 request_id, const td::td_api::Object *object) {
+  CHECK(object != nullptr);
+  switch (type) {
+    case RequestType::Empty:
+      CHECK(object->get_id() == td::td_api::ok::ID);
+      break;
+    case RequestType::SquareInt: {
+      CHECK(object->get_id() == td::td_api::testInt::ID);
+      auto x = get_square_argument(request_id);
+      CHECK(static_cast<const td::td_api::testInt *>(object)->value_ == x * x);
+      break;
+    }
+    case RequestType::String:
+      CHECK(object->get_id() == td::td_api::testString::ID);
+      CHECK(static_cast<const td::td_api::testString *>(object)->value_ == get_string_argument(request_id));
+      break;
+    case RequestType::VectorString:
+      CHECK(object->get_id() == td::td_api::testVectorString::ID);
+      CHECK(static_cast<const td::td_api::testVectorString *>(object)->value_ == get_vector_argument(request_id));
+      break;
+    default:
+      UNREACHABLE();
+  }
+}
+
+td::string create_json_request(RequestType type, td::uint64 request_id) {
+  switch (type) {
+    case RequestType::Empty:
+      return PSTRING() << "{\"@type\":\"testCallEmpty\",\"@extra\":" << request_id << '}';
+    case RequestType::SquareInt:
+      return PSTRING() << "{\"@type\":\"testSquareInt\",\"x\":" << get_square_argument(request_id)
+                       << ",\"@extra\":" << request_id << '}';
+    case RequestType::String:
+      return PSTRING() << "{\"@type\":\"testCallString\",\"x\":\"" << get_string_argument(request_id)
+                       << "\",\"@extra\":" << request_id << '}';
+    case RequestType::VectorString:
+      return PSTRING() << "{\"@type\":\"testCallVectorString\",\"x\":[\"first\",\""
+                       << get_string_argument(request_id) << "\",\"last\"],\"@extra\":" << request_id << '}';
+    default:
+      UNREACHABLE();
+      return td::string();
+  }
+}
+
+void check_json_response(RequestType type, td::uint64 request_id, td::Slice response) {
+  auto json = response.str();
+  auto r_value = td::json_decode(json);
+  LOG_CHECK(r_value.is_ok()) << r_value.error() << ' ' << response;
+  auto value = r_value.move_as_ok();
+  CHECK(value.type() == td::JsonValue::Type::Object);
+  auto &object = value.get_object();
+  auto object_type = object.get_required_string_field("@type").move_as_ok();
+  switch (type) {
+    case RequestType::Empty:
+      CHECK(object_type == "ok");
+      break;
+    case RequestType::SquareInt: {
+      CHECK(object_type == "testInt");
+      auto x = get_square_argument(request_id);
+      CHECK(object.get_required_int_field("value").move_as_ok() == x * x);
+      break;
+    }
+    case RequestType::String:
+      CHECK(object_type == "testString");
+      CHECK(object.get_required_string_field("value").move_as_ok() == get_string_argument(request_id));
+      break;
+    case RequestType::VectorString: {
+      CHECK(object_type == "testVectorString");
+      auto r_array = object.extract_required_field("value", td::JsonValue::Type::Array);
+      CHECK(r_array.is_ok());
+      td::vector<td::string> strings;
+      for (auto &element : r_array.ok().get_array()) {
+        CHECK(element.type() == td::JsonValue::Type::String);
+        strings.push_back(element.get_string().str());
+      }
+      CHECK(strings == get_vector_argument(request_id));
+      break;
+    }
+    default:
+      UNREACHABLE();
+  }
+}
+
+// returns 0 for updates
+td::uint64 get_json_request_id(const char *response) {
+  static const char EXTRA_KEY[] = "\"@extra\":";
+  auto extra = std::strstr(response, EXTRA_KEY);
+  if (extra == nullptr) {
+    return 0;
+  }
+  return td::to_integer<td::uint64>(td::Slice(extra + sizeof(EXTRA_KEY) - 1, std::strchr(extra, '}')));
+}
+
+td::uint64 get_resident_size() {
+  auto r_mem_stat = td::mem_stat();
+  if (r_mem_stat.is_error()) {
+    return 0;
+  }
+  return r_mem_stat.ok().resident_size_;
+}
+
+struct BenchmarkOptions {
+  size_t request_count = 100000;
+  size_t in_flight_count = 1;
+  td::vector<RequestType> request_mix;
+};
+
+struct BenchmarkResult {
+  size_t client_count = 0;
+  size_t request_count = 0;
+  double total_time = 0.0;
+  td::vector<double> latencies;
+  td::uint64 memory_per_client = 0;
+};
+
+// schedules requests to the clients and matches responses to them; request identifiers start from 1
+class RequestScheduler {
+ public:
+  RequestScheduler(size_t client_count, const BenchmarkOptions &options)
+      : client_count_(client_count)
+      , requests_per_client_(td::max(options.request_count / client_count, static_cast<size_t>(1)))
+      , request_mix_(options.request_mix)
+      , sent_requests_(client_count, 0) {
+    auto request_count = client_count_ * requests_per_client_;
+    request_client_.resize(request_count + 1);
+    send_time_.resize(request_count + 1);
+    latencies_.reserve(request_count);
+  }
+
+  size_t get_request_count() const {
+    return client_count_ * requests_per_client_;
+  }
+
+  bool is_finished() const {
+    return latencies_.size() == get_request_count();
+  }
+
+  // calls send_request(client_index, request_type, request_id) if the client has more requests to send
+  template <class F>
+  void send_next(size_t client_index, F &&send_request) {
+    if (sent_requests_[client_index] == requests_per_client_) {
+      return;
+    }
+    sent_requests_[client_index]++;
+    auto request_id = ++last_request_id_;
+    request_client_[request_id] = client_index;
+    send_time_[request_id] = td::Clocks::monotonic();
+    send_request(client_index, get_request_type(request_id), request_id);
+  }
+
+  // returns index of the client, which received the response
+  size_t on_response(td::uint64 request_id) {
+    CHECK(request_id != 0 && request_id <= last_request_id_);
+    latencies_.push_back(td::Clocks::monotonic() - send_time_[request_id]);
+    return request_client_[request_id];
+  }
+
+  RequestType get_request_type(td::uint64 request_id) const {
+    return request_mix_[request_id % request_mix_.size()];
+  }
+
+  td::vector<double> move_latencies() {
+    return std::move(latencies_);
+  }
+
+ private:
+  size_t client_count_;
+  size_t requests_per_client_;
+  const td::vector<RequestType> &request_mix_;
+  td::vector<size_t> sent_requests_;
+  td::vector<size_t> request_client_;
+  td::vector<double> send_time_;
+  td::vector<double> latencies_;
+  td::uint64 last_request_id_ = 0;
+};
+
+BenchmarkResult run_native_benchmark(size_t client_count, const BenchmarkOptions &options) {
+  BenchmarkResult result;
+  result.client_count = client_count;
+
+  td::ClientManager client_manager;
+  auto start_resident_size = get_resident_size();
+  td::vector<td::ClientManager::ClientId> client_ids;
+  for (size_t i = 0; i < client_count; i++) {
+    client_ids.push_back(client_manager.create_client_id());
+  }
+
+  // clients are created lazily on the first request
+  const td::uint64 INIT_REQUEST_ID = static_cast<td::uint64>(1) << 62;
+  for (auto client_id : client_ids) {
+    client_manager.send(client_id, INIT_REQUEST_ID, td::td_api::make_object<td::td_api::testCallEmpty>());
+  }
+  size_t inited_client_count = 0;
+  while (inited_client_count < client_count) {
+    auto response = client_manager.receive(10.0);
+    if (response.request_id == INIT_REQUEST_ID) {
+      inited_client_count++;
+    }
+  }
+  result.memory_per_client = (td::max(get_resident_size(), start_resident_size) - start_resident_size) / client_count;
+
+  RequestScheduler scheduler(client_count, options);
+  result.request_count = scheduler.get_request_count();
+  auto send_request = [&](size_t client_index, RequestType type, td::uint64 request_id) {
+    client_manager.send(client_ids[client_index], request_id, create_request(type, request_id));
+  };
+  auto start_time = td::Clocks::monotonic();
+  for (size_t i = 0; i < options.in_flight_count; i++) {
+    for (size_t client_index = 0; client_index < client_count; client_index++) {
+      scheduler.send_next(client_index, send_request);
+    }
+  }
+  while (!scheduler.is_finished()) {
+    for (auto &response : client_manager.receive_batch(10.0, 1000)) {
+      if (response.request_id == 0) {
+        continue;
+      }
+      check_response(scheduler.get_request_type(response.request_id), response.request_id, response.object.get());
+      scheduler.send_next(scheduler.on_response(response.request_id), send_request);
+    }
+  }
+  result.total_time = td::Clocks::monotonic() - start_time;
+  result.latencies = scheduler.move_latencies();
+
+  // all clients are closed in the destructor of the ClientManager
+  return result;
+}
+
+BenchmarkResult run_json_benchmark(size_t client_count, const BenchmarkOptions &options) {
+  BenchmarkResult result;
+  result.client_count = client_count;
+
+  auto start_resident_size = get_resident_size();
+  td::vector<int> client_ids;
+  for (size_t i = 0; i < client_count; i++) {
+    client_ids.push_back(td_create_client_id());
+  }
+
+  const td::string init_request = "{\"@type\":\"testCallEmpty\",\"@extra\":\"init\"}";
+  for (auto client_id : client_ids) {
+    td_send(client_id, init_request.c_str());
+  }
+  size_t inited_client_count = 0;
+  while (inited_client_count < client_count) {
+    auto response = td_receive(10.0);
+    if (response != nullptr && std::strstr(response, "\"@extra\":\"init\"") != nullptr) {
+      inited_client_count++;
+    }
+  }
+  result.memory_per_client = (td::max(get_resident_size(), start_resident_size) - start_resident_size) / client_count;
+
+  RequestScheduler scheduler(client_count, options);
+  result.request_count = scheduler.get_request_count();
+  auto send_request = [&](size_t client_index, RequestType type, td::uint64 request_id) {
+    td_send(client_ids[client_index], create_json_request(type, request_id).c_str());
+  };
+  auto start_time = td::Clocks::monotonic();
+  for (size_t i = 0; i < options.in_flight_count; i++) {
+    for (size_t client_index = 0; client_index < client_count; client_index++) {
+      scheduler.send_next(client_index, send_request);
+    }
+  }
+  while (!scheduler.is_finished()) {
+    auto response = td_receive(10.0);
+    if (response == nullptr) {
+      continue;
+    }
+    auto request_id = get_json_request_id(response);
+    if (request_id == 0) {
+      continue;
+    }
+    check_json_response(scheduler.get_request_type(request_id), request_id, td::Slice(response));
+    scheduler.send_next(scheduler.on_response(request_id), send_request);
+  }
+  result.total_time = td::Clocks::monotonic() - start_time;
+  result.latencies = scheduler.move_latencies();
+
+  // JSON clients can be destroyed only by closing them
+  for (auto client_id : client_ids) {
+    td_send(client_id, "{\"@type\":\"close\"}");
+  }
+  size_t closed_client_count = 0;
+  while (closed_client_count < client_count) {
+    auto response = td_receive(10.0);
+    if (response != nullptr && std::strstr(response, "\"authorizationStateClosed\"") != nullptr) {
+      closed_client_count++;
+    }
+  }
+  return result;
+}
+
+void print_result(td::Slice api, BenchmarkResult &&result) {
+  auto &latencies = result.latencies;
+  std::sort(latencies.begin(), latencies.end());
+  auto get_percentile = [&](size_t percent) {
+    return latencies.empty() ? 0.0 : latencies[(latencies.size() - 1) * percent / 100];
+  };
+  LOG(PLAIN) << api << ": " << result.client_count << " clients, " << result.request_count << " requests in "
+             << td::format::as_time(result.total_time) << ", "
+             << static_cast<td::uint64>(static_cast<double>(result.request_count) / result.total_time)
+             << " requests/s, latency p50 " << td::format::as_time(get_percentile(50)) << ", p90 "
+             << td::format::as_time(get_percentile(90)) << ", p99 " << td::format::as_time(get_percentile(99))
+             << ", max " << td::format::as_time(get_percentile(100)) << ", "
+             << td::format::as_size(result.memory_per_client) << " per client";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  td::ClientManager::execute(td::td_api::make_object<td::td_api::setLogVerbosityLevel>(1));
+
+  td::string client_counts = "1,10,100,1000,10000";
+  td::string request_mix = "empty:4,square:2,string:1,vector:1";
+  td::string api = "all";
+  BenchmarkOptions options;
+  for (int i = 1; i < argc; i++) {
+    td::Slice arg(argv[i]);
+    if (arg == "--clients" && i + 1 < argc) {
+      client_counts = argv[++i];
+    } else if (arg == "--requests" && i + 1 < argc) {
+      options.request_count = td::to_integer<size_t>(td::Slice(argv[++i]));
+    } else if (arg == "--in-flight" && i + 1 < argc) {
+      options.in_flight_count = td::max(td::to_integer<size_t>(td::Slice(argv[++i])), static_cast<size_t>(1));
+    } else if (arg == "--mix" && i + 1 < argc) {
+      request_mix = argv[++i];
+    } else if (arg == "--api" && i + 1 < argc) {
+      api = argv[++i];
+    } else {
+      LOG(PLAIN) << "Usage: bench_client_manager [--clients <comma-separated client counts>] [--requests "
+                    "<request count per run>] [--in-flight <concurrent requests per client>] [--mix "
+                    "<type:weight,...>, where type is one of empty, square, string, vector] [--api native|json|all]";
+      return 1;
+    }
+  }
+  LOG_IF(FATAL, api != "native" && api != "json" && api != "all") << "Unsupported API " << api;
+  options.request_mix = parse_request_mix(request_mix);
+
+  for (auto client_count_str : td::full_split(td::Slice(client_counts), ',')) {
+    auto client_count = td::to_integer<size_t>(client_count_str);
+    if (client_count == 0) {
+      continue;
+    }
+    if (api != "json") {
+      print_result("native", run_native_benchmark(client_count, options));
+    }
+    if (api != "native") {
+      print_result("json", run_json_benchmark(client_count, options));
+    }
+  }
+  return 0;
+}
@@ -6,14 +6,19 @@
 //
 #include "td/utils/benchmark.h"
 
+#include "td/utils/AesCtrByteFlow.h"
+#include "td/utils/buffer.h"
+#include "td/utils/ByteFlow.h"
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
+#include "td/utils/logging.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/UInt.h"
 
+#include <openssl/aes.h>
 #include <openssl/evp.h>
 #include <openssl/sha.h>
 
@@ -92,6 +97,48 @@ class SHA256ShortBench final : public td::Benchmark {
   }
 };
 
+class SHA256PairShortBench final : public td::Benchmark {
+ public:
+  alignas(64) unsigned char data[SHORT_DATA_SIZE];
+
+  std::string get_description() const final {
+    return PSTRING() << "SHA256 pair [" << SHORT_DATA_SIZE - 12 << "B]";
+  }
+
+  void start_up() final {
+    std::fill(std::begin(data), std::end(data), static_cast<unsigned char>(123));
+  }
+
+  void run(int n) final {
+    unsigned char md1[32];
+    unsigned char md2[32];
+    for (int i = 0; i < n; i++) {
+      td::sha256_pair(td::Slice(data, SHORT_DATA_SIZE - 12), td::Slice(data + 12, SHORT_DATA_SIZE - 12),
+                      td::MutableSlice(md1, 32), td::MutableSlice(md2, 32));
+    }
+  }
+};
+
+class SHA256Bench final : public td::Benchmark {
+ public:
+  alignas(64) unsigned char data[DATA_SIZE];
+
+  std::string get_description() const final {
+    return PSTRING() << "SHA256 [" << (DATA_SIZE >> 10) << "KB]";
+  }
+
+  void start_up() final {
+    std::fill(std::begin(data), std::end(data), static_cast<unsigned char>(123));
+  }
+
+  void run(int n) final {
+    unsigned char md[32];
+    for (int i = 0; i < n; i++) {
+      td::sha256(td::Slice(data, DATA_SIZE), td::MutableSlice(md, 32));
+    }
+  }
+};
+
 class SHA512ShortBench final : public td::Benchmark {
  public:
   alignas(64) unsigned char data[SHORT_DATA_SIZE];
@@ -259,6 +306,91 @@ class AesCtrBench final : public td::Benchmark {
   }
 };
 
+class AesIgeDecryptEvpBench final : public td::Benchmark {
+ public:
+  alignas(64) unsigned char data[DATA_SIZE];
+  td::UInt256 key;
+  td::UInt256 iv;
+
+  std::string get_description() const final {
+    return PSTRING() << "AES IGE EVP per block decrypt [" << (DATA_SIZE >> 10) << "KB]";
+  }
+
+  void start_up() final {
+    std::fill(std::begin(data), std::end(data), static_cast<unsigned char>(123));
+    td::Random::secure_bytes(key.raw, sizeof(key));
+    td::Random::secure_bytes(iv.raw, sizeof(iv));
+  }
+
+  void run(int n) final {
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    EVP_DecryptInit_ex(ctx, EVP_aes_256_ecb(), nullptr, key.raw, nullptr);
+    EVP_CIPHER_CTX_set_padding(ctx, 0);
+
+    unsigned char encrypted_iv[AES_BLOCK_SIZE];
+    unsigned char plaintext_iv[AES_BLOCK_SIZE];
+    std::copy(iv.raw, iv.raw + AES_BLOCK_SIZE, encrypted_iv);
+    std::copy(iv.raw + AES_BLOCK_SIZE, iv.raw + 2 * AES_BLOCK_SIZE, plaintext_iv);
+    for (int i = 0; i < n; i++) {
+      for (int offset = 0; offset < DATA_SIZE; offset += AES_BLOCK_SIZE) {
+        unsigned char encrypted[AES_BLOCK_SIZE];
+        std::copy(data + offset, data + offset + AES_BLOCK_SIZE, encrypted);
+        for (int j = 0; j < AES_BLOCK_SIZE; j++) {
+          plaintext_iv[j] ^= encrypted[j];
+        }
+        int len = 0;
+        EVP_DecryptUpdate(ctx, plaintext_iv, &len, plaintext_iv, AES_BLOCK_SIZE);
+        CHECK(len == AES_BLOCK_SIZE);
+        for (int j = 0; j < AES_BLOCK_SIZE; j++) {
+          plaintext_iv[j] ^= encrypted_iv[j];
+        }
+        std::copy(plaintext_iv, plaintext_iv + AES_BLOCK_SIZE, data + offset);
+        std::copy(encrypted, encrypted + AES_BLOCK_SIZE, encrypted_iv);
+      }
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+  }
+};
+
+class AesCtrByteFlowBench final : public td::Benchmark {
+ public:
+  static constexpr int CHUNK_SIZE = 1 << 10;
+  alignas(64) unsigned char data[DATA_SIZE];
+  td::UInt256 key;
+  td::UInt128 iv;
+
+  std::string get_description() const final {
+    return PSTRING() << "AES CTR ByteFlow [" << (DATA_SIZE >> 10) << "KB by " << (CHUNK_SIZE >> 10) << "KB]";
+  }
+
+  void start_up() final {
+    std::fill(std::begin(data), std::end(data), static_cast<unsigned char>(123));
+    td::Random::secure_bytes(key.raw, sizeof(key));
+    td::Random::secure_bytes(iv.raw, sizeof(iv));
+  }
+
+  void run(int n) final {
+    td::ChainBufferWriter input_writer;
+    auto input = input_writer.extract_reader();
+    td::ByteFlowSource source(&input);
+    td::AesCtrByteFlow aes_ctr_byte_flow;
+    aes_ctr_byte_flow.init(key, iv);
+    td::ByteFlowSink sink;
+    source >> aes_ctr_byte_flow >> sink;
+
+    for (int i = 0; i < n; i++) {
+      for (int offset = 0; offset < DATA_SIZE; offset += CHUNK_SIZE) {
+        input_writer.append(td::Slice(data + offset, CHUNK_SIZE));
+      }
+      source.wakeup();
+      auto output = sink.get_output();
+      CHECK(output->size() == static_cast<size_t>(DATA_SIZE));
+      output->advance(output->size());
+    }
+  }
+};
+
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
 class AesCtrOpenSSLBench final : public td::Benchmark {
  public:
@@ -488,8 +620,34 @@ class Crc64Bench final : public td::Benchmark {
   }
 };
 
+static void bench_throughput(td::Benchmark &&b, size_t data_size, double max_time = 1.0) {
+  int n = 1;
+  double pass_time = 0;
+  while (pass_time < max_time && n < (1 << 30)) {
+    n *= 2;
+    pass_time = td::bench_n(b, n).first;
+  }
+  auto description = b.get_description();
+  std::string pad;
+  if (description.size() < 40) {
+    pad = std::string(40 - description.size(), ' ');
+  }
+  LOG(ERROR) << "Throughput [" << pad << description << "]: "
+             << td::StringBuilder::FixedDouble(static_cast<double>(data_size) * n / pass_time * 1e-9, 3) << " GB/s";
+}
+
 int main() {
   td::init_openssl_threads();
+  bench_throughput(AesIgeEncryptBench(), DATA_SIZE);
+  bench_throughput(AesIgeDecryptBench(), DATA_SIZE);
+  bench_throughput(AesIgeDecryptEvpBench(), DATA_SIZE);
+  bench_throughput(AesCbcEncryptBench(), DATA_SIZE);
+  bench_throughput(AesCbcDecryptBench(), DATA_SIZE);
+  bench_throughput(AesCtrBench(), DATA_SIZE);
+  bench_throughput(AesCtrByteFlowBench(), DATA_SIZE);
+  bench_throughput(SHA256Bench(), DATA_SIZE);
+
+
   td::bench(AesCtrBench());
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
   td::bench(AesCtrOpenSSLBench());
@@ -501,6 +659,8 @@ int main() {
   td::bench(AesIgeShortBench<false>());
   td::bench(AesIgeEncryptBench());
   td::bench(AesIgeDecryptBench());
+  td::bench(AesIgeDecryptEvpBench());
+  td::bench(AesCtrByteFlowBench());
   td::bench(AesEcbBench());
 
   td::bench(Pbkdf2Bench());
@@ -517,6 +677,8 @@ int main() {
 #endif
   td::bench(SHA1ShortBench());
   td::bench(SHA256ShortBench());
+  td::bench(SHA256PairShortBench());
+  td::bench(SHA256Bench());
   td::bench(SHA512ShortBench());
   td::bench(HmacSha256ShortBench());
   td::bench(HmacSha512ShortBench());
@@ -10,13 +10,13 @@
 #include "td/utils/base64.h"
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
+#include "td/utils/crypto.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
 
 #include <map>
-
-#if TD_LINUX || TD_ANDROID || TD_TIZEN
-#include <semaphore.h>
-#endif
+#include <mutex>
 
 static td::int32 g = 3;
 static td::string prime_base64 =
@@ -25,48 +25,136 @@ static td::string prime_base64 =
     "WC2xF40WnGvEZbDW_5yjko_vW5rk5Bj8Feg-vqD4f6n_Xu1wBQ3tKEn0e_lZ2VaFDOkphR8NgRX2NbEF7i5OFdBLJFS_b0-t8DSxBAMRnNjjuS_MW"
     "w";
 
+class FakeDhCallback final : public td::mtproto::DhCallback {
+ public:
+  int is_good_prime(td::Slice prime_str) const final {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = cache_.find(prime_str.str());
+    if (it == cache_.end()) {
+      return -1;
+    }
+    return it->second;
+  }
+  void add_good_prime(td::Slice prime_str) const final {
+    std::lock_guard<std::mutex> guard(mutex_);
+    cache_[prime_str.str()] = 1;
+  }
+  void add_bad_prime(td::Slice prime_str) const final {
+    std::lock_guard<std::mutex> guard(mutex_);
+    cache_[prime_str.str()] = 0;
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  mutable std::map<td::string, int> cache_;
+};
+
+static void run_handshakes(int n, td::Slice prime, td::mtproto::DhCallback *dh_callback) {
+  td::mtproto::DhHandshake a;
+  td::mtproto::DhHandshake b;
+  for (int i = 0; i < n; i += 2) {
+    a.set_config(g, prime);
+    b.set_config(g, prime);
+    b.set_g_a(a.get_g_b());
+    a.set_g_a(b.get_g_b());
+    a.run_checks(true, dh_callback).ensure();
+    b.run_checks(true, dh_callback).ensure();
+    auto a_key = a.gen_key();
+    auto b_key = b.gen_key();
+    CHECK(a_key.first == b_key.first);
+  }
+}
+
 class HandshakeBench final : public td::Benchmark {
   td::string get_description() const final {
     return "Handshake";
   }
 
-  class FakeDhCallback final : public td::mtproto::DhCallback {
-   public:
-    int is_good_prime(td::Slice prime_str) const final {
-      auto it = cache.find(prime_str.str());
-      if (it == cache.end()) {
-        return -1;
-      }
-      return it->second;
+  FakeDhCallback dh_callback;
+
+  void run(int n) final {
+    auto prime = td::base64url_decode(prime_base64).move_as_ok();
+    td::mtproto::DhHandshake::check_config(g, prime, &dh_callback).ensure();
+    run_handshakes(n, prime, &dh_callback);
+  }
+};
+
+class ParallelHandshakeBench final : public td::Benchmark {
+ public:
+  explicit ParallelHandshakeBench(int thread_count) : thread_count_(thread_count) {
+  }
+
+ private:
+  int thread_count_;
+  FakeDhCallback dh_callback;
+
+  td::string get_description() const final {
+    return PSTRING() << "Handshake with " << thread_count_ << " threads";
+  }
+
+  void run(int n) final {
+    auto prime = td::base64url_decode(prime_base64).move_as_ok();
+    td::mtproto::DhHandshake::check_config(g, prime, &dh_callback).ensure();
+    td::vector<td::thread> threads;
+    for (int i = 0; i < thread_count_; i++) {
+      threads.emplace_back([&] { run_handshakes((n + thread_count_ - 1) / thread_count_, prime, &dh_callback); });
     }
-    void add_good_prime(td::Slice prime_str) const final {
-      cache[prime_str.str()] = 1;
+    for (auto &thread : threads) {
+      thread.join();
     }
-    void add_bad_prime(td::Slice prime_str) const final {
-      cache[prime_str.str()] = 0;
+  }
+};
+
+class DhCheckConfigBench final : public td::Benchmark {
+ public:
+  explicit DhCheckConfigBench(bool use_cache) : use_cache_(use_cache) {
+  }
+
+ private:
+  bool use_cache_;
+  td::string prime_;
+  FakeDhCallback dh_callback;
+
+  td::string get_description() const final {
+    return PSTRING() << "DH config check " << (use_cache_ ? "with" : "without") << " prime cache";
+  }
+
+  void start_up() final {
+    prime_ = td::base64url_decode(prime_base64).move_as_ok();
+    td::mtproto::DhHandshake::check_config(g, prime_, &dh_callback).ensure();
+  }
+
+  void run(int n) final {
+    for (int i = 0; i < n; i++) {
+      if (use_cache_) {
+        td::mtproto::DhHandshake::check_config(g, prime_, &dh_callback).ensure();
+      } else {
+        FakeDhCallback empty_dh_callback;
+        td::mtproto::DhHandshake::check_config(g, prime_, &empty_dh_callback).ensure();
+      }
     }
-    mutable std::map<td::string, int> cache;
-  } dh_callback;
+  }
+};
+
+class PqFactorizeBench final : public td::Benchmark {
+  td::string get_description() const final {
+    return "pq_factorize";
+  }
 
   void run(int n) final {
-    td::mtproto::DhHandshake a;
-    td::mtproto::DhHandshake b;
-    auto prime = td::base64url_decode(prime_base64).move_as_ok();
-    td::mtproto::DhHandshake::check_config(g, prime, &dh_callback).ensure();
-    for (int i = 0; i < n; i += 2) {
-      a.set_config(g, prime);
-      b.set_config(g, prime);
-      b.set_g_a(a.get_g_b());
-      a.set_g_a(b.get_g_b());
-      a.run_checks(true, &dh_callback).ensure();
-      b.run_checks(true, &dh_callback).ensure();
-      auto a_key = a.gen_key();
-      auto b_key = b.gen_key();
-      CHECK(a_key.first == b_key.first);
+    td::uint64 result = 0;
+    for (int i = 0; i < n; i++) {
+      result += td::pq_factorize(static_cast<td::uint64>(1724114033281923457ull));
     }
+    CHECK(result == static_cast<td::uint64>(n) * 1229739323);
   }
 };
 
 int main() {
   td::bench(HandshakeBench());
+  td::bench(ParallelHandshakeBench(2));
+  td::bench(ParallelHandshakeBench(4));
+  td::bench(DhCheckConfigBench(false));
+  td::bench(DhCheckConfigBench(true));
+  td::bench(PqFactorizeBench());
 }
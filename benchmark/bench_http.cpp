@@ -13,9 +13,12 @@
 
 #include "td/utils/buffer.h"
 #include "td/utils/BufferedFd.h"
+#include "td/utils/common.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
 #include "td/utils/port/IPAddress.h"
 #include "td/utils/port/SocketFd.h"
+#include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
 #include <atomic>
@@ -24,6 +27,11 @@
 std::atomic<int> counter;
 
 class HttpClient final : public td::HttpOutboundConnection::Callback {
+ public:
+  explicit HttpClient(int pipeline_depth) : pipeline_depth_(pipeline_depth) {
+  }
+
+ private:
   void start_up() final {
     td::IPAddress addr;
     addr.init_ipv4_port("127.0.0.1", 8082).ensure();
@@ -44,15 +52,20 @@ class HttpClient final : public td::HttpOutboundConnection::Callback {
   }
 
   void loop() final {
-    if (cnt_-- < 0) {
+    while (active_query_count_ < pipeline_depth_ && cnt_ > 0) {
+      cnt_--;
+      active_query_count_++;
+      send_closure(connection_, &td::HttpOutboundConnection::write_next, td::BufferSlice("GET / HTTP/1.1\r\n\r\n"));
+      send_closure(connection_, &td::HttpOutboundConnection::write_ok);
+      LOG(INFO) << "SEND";
+    }
+    if (active_query_count_ == 0) {
       return stop();
     }
-    send_closure(connection_, &td::HttpOutboundConnection::write_next, td::BufferSlice("GET / HTTP/1.1\r\n\r\n"));
-    send_closure(connection_, &td::HttpOutboundConnection::write_ok);
-    LOG(INFO) << "SEND";
   }
 
   void handle(td::unique_ptr<td::HttpQuery> result) final {
+    active_query_count_--;
     loop();
   }
 
@@ -61,14 +74,18 @@ class HttpClient final : public td::HttpOutboundConnection::Callback {
   }
 
   td::ActorOwn<td::HttpOutboundConnection> connection_;
+  int pipeline_depth_ = 1;
+  int active_query_count_ = 0;
   int cnt_ = 0;
 };
 
-int main() {
+int main(int argc, char *argv[]) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  // number of queries, which are sent by a client without waiting for responses
+  int pipeline_depth = argc > 1 ? td::max(td::to_integer<int>(td::Slice(argv[1])), 1) : 1;
   auto scheduler = td::make_unique<td::ConcurrentScheduler>(0, 0);
-  scheduler->create_actor_unsafe<HttpClient>(0, "Client1").release();
-  scheduler->create_actor_unsafe<HttpClient>(0, "Client2").release();
+  scheduler->create_actor_unsafe<HttpClient>(0, "Client1", pipeline_depth).release();
+  scheduler->create_actor_unsafe<HttpClient>(0, "Client2", pipeline_depth).release();
   scheduler->start();
   while (scheduler->run_main(10)) {
     // empty
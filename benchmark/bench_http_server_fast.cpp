@@ -14,7 +14,9 @@
 
 #include "td/utils/buffer.h"
 #include "td/utils/BufferedFd.h"
+#include "td/utils/common.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
 #include "td/utils/port/detail/PollableFd.h"
 #include "td/utils/port/SocketFd.h"
 #include "td/utils/Slice.h"
@@ -82,16 +84,24 @@ class HttpEchoConnection final : public td::Actor {
   }
 };
 
-const int N = 8;
 class Server final : public td::TcpListener::Callback {
  public:
+  // accepted connections are distributed between schedulers 1..scheduler_count,
+  // or handled by the current scheduler if scheduler_count == 0
+  explicit Server(int scheduler_count) : scheduler_count_(scheduler_count) {
+  }
+
   void start_up() final {
     listener_ =
         td::create_actor<td::TcpListener>("Listener", 8082, td::ActorOwn<td::TcpListener::Callback>(actor_id(this)));
   }
   void accept(td::SocketFd fd) final {
+    if (scheduler_count_ == 0) {
+      td::create_actor<HttpEchoConnection>("HttpEchoConnection", std::move(fd)).release();
+      return;
+    }
     pos_++;
-    auto scheduler_id = pos_ % (N != 0 ? N : 1) + (N != 0);
+    auto scheduler_id = pos_ % scheduler_count_ + 1;
     td::create_actor_on_scheduler<HttpEchoConnection>("HttpEchoConnection", scheduler_id, std::move(fd)).release();
   }
   void hangup() final {
@@ -101,13 +111,24 @@ class Server final : public td::TcpListener::Callback {
 
  private:
   td::ActorOwn<td::TcpListener> listener_;
+  int scheduler_count_;
   int pos_{0};
 };
 
-int main() {
+int main(int argc, char *argv[]) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
-  auto scheduler = td::make_unique<td::ConcurrentScheduler>(N, 0);
-  scheduler->create_actor_unsafe<Server>(0, "Server").release();
+  int threads_n = argc > 1 ? td::max(td::to_integer<int>(td::Slice(argv[1])), 0) : 8;
+  bool use_reuse_port = argc > 2 && td::Slice(argv[2]) == "reuseport";
+  auto scheduler = td::make_unique<td::ConcurrentScheduler>(threads_n, 0);
+  if (use_reuse_port) {
+    // each scheduler has its own listener on the same port and the kernel balances connections between them,
+    // because server sockets are opened with SO_REUSEPORT
+    for (int scheduler_id = threads_n == 0 ? 0 : 1; scheduler_id <= threads_n; scheduler_id++) {
+      scheduler->create_actor_unsafe<Server>(scheduler_id, "Server", 0).release();
+    }
+  } else {
+    scheduler->create_actor_unsafe<Server>(0, "Server", threads_n).release();
+  }
   scheduler->start();
   while (scheduler->run_main(10)) {
     // empty
@@ -0,0 +1,645 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/ChannelId.h"
+#include "td/telegram/ChatId.h"
+#include "td/telegram/DialogDb.h"
+#include "td/telegram/DialogId.h"
+#include "td/telegram/files/FileData.h"
+#include "td/telegram/files/FileData.hpp"
+#include "td/telegram/files/FileDb.h"
+#include "td/telegram/files/FileLocation.h"
+#include "td/telegram/files/FileLocation.hpp"
+#include "td/telegram/files/FileType.h"
+#include "td/telegram/FolderId.h"
+#include "td/telegram/logevent/LogEvent.h"
+#include "td/telegram/MessageDb.h"
+#include "td/telegram/MessageId.h"
+#include "td/telegram/MessageSearchFilter.h"
+#include "td/telegram/NotificationId.h"
+#include "td/telegram/ServerMessageId.h"
+#include "td/telegram/StoryDb.h"
+#include "td/telegram/StoryFullId.h"
+#include "td/telegram/StoryId.h"
+#include "td/telegram/StoryListId.h"
+#include "td/telegram/UserId.h"
+#include "td/telegram/Version.h"
+
+#include "td/db/binlog/Binlog.h"
+#include "td/db/BinlogKeyValue.h"
+#include "td/db/DbKey.h"
+#include "td/db/SqliteConnectionSafe.h"
+#include "td/db/SqliteDb.h"
+#include "td/db/SqliteKeyValue.h"
+#include "td/db/SqliteKeyValueSafe.h"
+
+#include "td/actor/ConcurrentScheduler.h"
+
+#include "td/utils/benchmark.h"
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/Clocks.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Random.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Status.h"
+#include "td/utils/Time.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
+
+#include <cmath>
+#include <limits>
+#include <memory>
+
+// Generates a database with the shape of a large account through the real database interfaces and runs benchmarks
+// of the typical database queries over it. Message counts in chats, word frequencies and message kinds are skewed
+// like in real accounts: a few chats contain most messages, a few words are used in most messages.
+
+struct LargeAccountOptions {
+  td::string path = "large_account.sqlite";
+  td::int32 dialog_count = 50000;
+  td::int64 message_count = 10000000;
+  td::int32 file_count = 1000000;
+  td::int32 story_count = 100000;
+  bool reuse = false;
+  bool run_gc = true;
+};
+
+struct LargeAccountDialog {
+  td::DialogId dialog_id;
+  td::int32 message_count = 0;
+  td::int32 last_message_date = 0;
+};
+
+static constexpr td::int32 WORD_COUNT = 50000;
+static constexpr td::int32 GENERATED_DAYS = 3 * 365;
+
+static td::int32 get_base_date() {
+  static const td::int32 base_date = static_cast<td::int32>(td::Clocks::system()) - GENERATED_DAYS * 86400;
+  return base_date;
+}
+
+// chat identifiers and message counts depend only on the options, so they are the same for a reused database
+static td::vector<LargeAccountDialog> get_large_account_dialogs(const LargeAccountOptions &options) {
+  CHECK(options.dialog_count > 0);
+  td::vector<double> weights(options.dialog_count);
+  double total_weight = 0.0;
+  for (td::int32 i = 0; i < options.dialog_count; i++) {
+    weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), 0.9);
+    total_weight += weights[i];
+  }
+
+  td::vector<LargeAccountDialog> dialogs(options.dialog_count);
+  for (td::int32 i = 0; i < options.dialog_count; i++) {
+    auto &dialog = dialogs[i];
+    auto id = static_cast<td::int64>(i + 1);
+    switch (i % 10) {
+      case 0:
+      case 1:
+        dialog.dialog_id = td::DialogId(td::ChatId(id));
+        break;
+      case 2:
+      case 3:
+        dialog.dialog_id = td::DialogId(td::ChannelId(id));
+        break;
+      default:
+        dialog.dialog_id = td::DialogId(td::UserId(id));
+        break;
+    }
+    dialog.message_count =
+        td::max(static_cast<td::int32>(static_cast<double>(options.message_count) * weights[i] / total_weight), 1);
+    // less active chats stopped receiving messages earlier
+    auto inactivity_time = static_cast<td::int64>(i) * (GENERATED_DAYS * 86400 / 2) / options.dialog_count;
+    dialog.last_message_date = get_base_date() + GENERATED_DAYS * 86400 - static_cast<td::int32>(inactivity_time);
+  }
+  return dialogs;
+}
+
+static td::int32 get_message_date(const LargeAccountDialog &dialog, td::int32 message_index) {
+  auto first_message_date = get_base_date();
+  auto duration = static_cast<td::int64>(dialog.last_message_date - first_message_date);
+  return first_message_date + static_cast<td::int32>(duration * (message_index + 1) / dialog.message_count);
+}
+
+static td::MessageId get_message_id(td::int32 message_index) {
+  return td::MessageId(td::ServerMessageId(message_index + 1));
+}
+
+static td::string get_random_word() {
+  // nested random calls make small word numbers much more probable
+  return PSTRING() << "word" << td::Random::fast(0, td::Random::fast(0, td::Random::fast(0, WORD_COUNT - 1)));
+}
+
+// the serialized message starts like a real one, so that the database can extract message date from it
+static td::BufferSlice get_message_data(td::MessageId message_id, td::UserId sender_user_id, td::int32 date,
+                                        size_t content_size) {
+  const size_t header_size = 4 + 8 + 8 + 4;
+  td::BufferSlice data(header_size + content_size);
+  td::TlStorerUnsafe storer(data.as_mutable_slice().ubegin());
+  storer.store_int(1 << 10);
+  storer.store_long(message_id.get());
+  storer.store_long(sender_user_id.get());
+  storer.store_int(date);
+  auto content = data.as_mutable_slice().substr(header_size);
+  for (size_t i = 0; i < content.size(); i++) {
+    content[i] = static_cast<char>(td::Random::fast(0, 15));
+  }
+  return data;
+}
+
+static td::MessageDbNewMessage get_random_message(const LargeAccountDialog &dialog, td::int32 message_index,
+                                                  td::int64 &next_search_id, td::int32 &next_unique_message_id) {
+  td::MessageDbNewMessage message;
+  auto message_id = get_message_id(message_index);
+  message.message_full_id = {dialog.dialog_id, message_id};
+  if (dialog.dialog_id.get_type() != td::DialogType::Channel) {
+    message.unique_message_id = td::ServerMessageId(++next_unique_message_id);
+  }
+  auto sender_user_id = dialog.dialog_id.get_type() == td::DialogType::User
+                            ? td::UserId(static_cast<td::int64>(td::Random::fast(0, 1) == 0 ? 1 : 100000000))
+                            : td::UserId(static_cast<td::int64>(td::Random::fast(1, 10000)));
+  message.sender_dialog_id = td::DialogId(sender_user_id);
+  message.random_id = static_cast<td::int64>(td::Random::fast_uint64() & 0x7FFFFFFFFFFFFFFF);
+
+  size_t content_size = 40;
+  auto kind = td::Random::fast(0, 99);
+  if (kind < 20) {
+    message.index_mask |= td::message_search_filter_index_mask(td::MessageSearchFilter::Photo) |
+                          td::message_search_filter_index_mask(td::MessageSearchFilter::PhotoAndVideo);
+    content_size += 250;
+  } else if (kind < 25) {
+    message.index_mask |= td::message_search_filter_index_mask(td::MessageSearchFilter::Video) |
+                          td::message_search_filter_index_mask(td::MessageSearchFilter::PhotoAndVideo);
+    content_size += 300;
+  } else if (kind < 29) {
+    message.index_mask |= td::message_search_filter_index_mask(td::MessageSearchFilter::Document);
+    content_size += 200;
+  } else if (kind < 31) {
+    message.index_mask |= td::message_search_filter_index_mask(td::MessageSearchFilter::VoiceNote) |
+                          td::message_search_filter_index_mask(td::MessageSearchFilter::VoiceAndVideoNote);
+    content_size += 150;
+  } else if (kind < 33) {
+    message.index_mask |= td::message_search_filter_index_mask(td::MessageSearchFilter::Animation);
+    content_size += 250;
+  } else if (kind < 34) {
+    message.index_mask |= td::message_search_filter_index_mask(td::MessageSearchFilter::Audio);
+    content_size += 200;
+  }
+
+  // most media messages have no caption
+  if (kind >= 34 || td::Random::fast(0, 3) == 0) {
+    auto word_count = td::Random::fast(1, td::Random::fast(1, 60));
+    for (int i = 0; i < word_count; i++) {
+      if (i > 0) {
+        message.text += ' ';
+      }
+      message.text += get_random_word();
+    }
+    if (td::Random::fast(0, 99) < 8) {
+      message.text += PSTRING() << " https://t.me/c" << td::Random::fast(1, 100000);
+      message.index_mask |= td::message_search_filter_index_mask(td::MessageSearchFilter::Url);
+      content_size += 32;
+    }
+    if (td::Random::fast(0, 99) < 3) {
+      message.index_mask |= td::message_search_filter_index_mask(td::MessageSearchFilter::Mention);
+      content_size += 16;
+    }
+    content_size += message.text.size();
+    auto entity_count = td::Random::fast(0, td::Random::fast(0, 5));
+    content_size += entity_count * 16;
+    message.search_id = ++next_search_id;
+  }
+
+  message.data = get_message_data(message_id, sender_user_id, get_message_date(dialog, message_index), content_size);
+  return message;
+}
+
+class LargeAccount {
+ public:
+  explicit LargeAccount(LargeAccountOptions options)
+      : options_(std::move(options)), dialogs_(get_large_account_dialogs(options_)) {
+  }
+
+  void open() {
+    if (!options_.reuse) {
+      td::SqliteDb::destroy(options_.path).ignore();
+      td::Binlog::destroy(get_binlog_path()).ignore();
+    }
+    sql_connection_ = std::make_shared<td::SqliteConnectionSafe>(options_.path, td::DbKey::empty());
+    auto &db = sql_connection_->get();
+    db.exec("PRAGMA encoding=\"UTF-8\"").ensure();
+    db.exec("PRAGMA journal_mode=WAL").ensure();
+    db.exec("PRAGMA synchronous=NORMAL").ensure();
+    db.exec("PRAGMA temp_store=MEMORY").ensure();
+    db.exec("PRAGMA secure_delete=1").ensure();
+
+    binlog_pmc_.init(get_binlog_path()).ensure();
+    bool was_dialog_db_created = false;
+    db.exec("BEGIN TRANSACTION").ensure();
+    auto user_version = db.user_version().move_as_ok();
+    init_dialog_db(db, user_version, binlog_pmc_, was_dialog_db_created).ensure();
+    init_message_db(db, user_version).ensure();
+    init_story_db(db, user_version).ensure();
+    init_file_db(db, user_version).ensure();
+    db.set_user_version(td::current_db_version()).ensure();
+    db.exec("COMMIT TRANSACTION").ensure();
+
+    message_db_ = td::create_message_db_sync(sql_connection_);
+    dialog_db_ = td::create_dialog_db_sync(sql_connection_);
+    story_db_ = td::create_story_db_sync(sql_connection_);
+  }
+
+  void generate(td::ConcurrentScheduler &scheduler) {
+    if (options_.reuse) {
+      LOG(PLAIN) << "Reuse database " << options_.path;
+      return;
+    }
+    auto start_time = td::Time::now();
+    generate_messages();
+    LOG(PLAIN) << "Generated " << message_count_ << " messages in " << td::Time::now() - start_time << " seconds";
+
+    start_time = td::Time::now();
+    generate_dialogs();
+    LOG(PLAIN) << "Generated " << dialogs_.size() << " chats in " << td::Time::now() - start_time << " seconds";
+
+    start_time = td::Time::now();
+    generate_stories();
+    LOG(PLAIN) << "Generated " << options_.story_count << " stories in " << td::Time::now() - start_time << " seconds";
+
+    start_time = td::Time::now();
+    generate_files(scheduler);
+    LOG(PLAIN) << "Generated " << options_.file_count << " files in " << td::Time::now() - start_time << " seconds";
+
+    LOG(PLAIN) << "Database size is " << message_db_->get().get_database_size() << " bytes";
+  }
+
+  void close() {
+    message_db_.reset();
+    dialog_db_.reset();
+    story_db_.reset();
+    sql_connection_->close();
+    sql_connection_.reset();
+    binlog_pmc_.close();
+  }
+
+  const td::vector<LargeAccountDialog> &get_dialogs() const {
+    return dialogs_;
+  }
+
+  // returns a chat index with probability proportional to the number of messages in the chat
+  size_t get_random_active_dialog_index() const {
+    return td::Random::fast(0, td::Random::fast(0, td::Random::fast(0, static_cast<int>(dialogs_.size()) - 1)));
+  }
+
+  td::MessageDbSyncInterface &message_db() {
+    return message_db_->get();
+  }
+
+  td::DialogDbSyncInterface &dialog_db() {
+    return dialog_db_->get();
+  }
+
+  td::StoryDbSyncInterface &story_db() {
+    return story_db_->get();
+  }
+
+  td::SqliteKeyValue &file_kv() {
+    if (file_kv_safe_ == nullptr) {
+      file_kv_safe_ = std::make_shared<td::SqliteKeyValueSafe>("files", sql_connection_);
+    }
+    return file_kv_safe_->get();
+  }
+
+ private:
+  LargeAccountOptions options_;
+  td::vector<LargeAccountDialog> dialogs_;
+  td::int64 message_count_ = 0;
+
+  std::shared_ptr<td::SqliteConnectionSafe> sql_connection_;
+  td::BinlogKeyValue<td::Binlog> binlog_pmc_;
+  std::shared_ptr<td::MessageDbSyncSafeInterface> message_db_;
+  std::shared_ptr<td::DialogDbSyncSafeInterface> dialog_db_;
+  std::shared_ptr<td::StoryDbSyncSafeInterface> story_db_;
+  std::shared_ptr<td::SqliteKeyValueSafe> file_kv_safe_;
+
+  td::string get_binlog_path() const {
+    return options_.path + ".binlog";
+  }
+
+  void generate_messages() {
+    auto &message_db = message_db_->get();
+    td::int64 next_search_id = 0;
+    td::int32 next_unique_message_id = 0;
+    td::vector<td::MessageDbNewMessage> messages;
+    auto flush = [&] {
+      message_db.begin_write_transaction().ensure();
+      message_db.add_messages(std::move(messages));
+      message_db.commit_transaction().ensure();
+      messages.clear();
+    };
+    for (auto &dialog : dialogs_) {
+      for (td::int32 i = 0; i < dialog.message_count; i++) {
+        messages.push_back(get_random_message(dialog, i, next_search_id, next_unique_message_id));
+        if (messages.size() == 10000) {
+          message_count_ += static_cast<td::int64>(messages.size());
+          flush();
+          if (message_count_ % 1000000 == 0) {
+            LOG(PLAIN) << "Generated " << message_count_ << " messages";
+          }
+        }
+      }
+    }
+    message_count_ += static_cast<td::int64>(messages.size());
+    flush();
+  }
+
+  void generate_dialogs() {
+    auto &dialog_db = dialog_db_->get();
+    dialog_db.begin_write_transaction().ensure();
+    for (size_t i = 0; i < dialogs_.size(); i++) {
+      auto &dialog = dialogs_[i];
+      auto folder_id = td::FolderId(td::Random::fast(0, 9) == 0 ? 1 : 0);
+      auto order = (static_cast<td::int64>(dialog.last_message_date) << 32) + static_cast<td::int64>(i);
+      auto data = td::BufferSlice(td::Random::fast(500, td::Random::fast(500, 4000)));
+      dialog_db.add_dialog(dialog.dialog_id, folder_id, order, std::move(data), {});
+      if (i % 1000 == 999) {
+        dialog_db.commit_transaction().ensure();
+        dialog_db.begin_write_transaction().ensure();
+      }
+    }
+    dialog_db.commit_transaction().ensure();
+  }
+
+  void generate_stories() {
+    auto &story_db = story_db_->get();
+    auto now = static_cast<td::int32>(td::Clocks::system());
+    auto story_dialog_count = td::max(td::min(static_cast<int>(dialogs_.size()), options_.story_count / 20), 1);
+    story_db.begin_write_transaction().ensure();
+    for (td::int32 i = 0; i < options_.story_count; i++) {
+      auto dialog_id = dialogs_[i % story_dialog_count].dialog_id;
+      auto story_id = td::StoryId(i / story_dialog_count + 1);
+      // most stored stories have already expired
+      auto expires_at = now + td::Random::fast(-7 * 86400, 86400);
+      story_db.add_story({dialog_id, story_id}, expires_at, td::NotificationId(),
+                         td::BufferSlice(td::Random::fast(300, 1500)));
+      if (i % 1000 == 999) {
+        story_db.commit_transaction().ensure();
+        story_db.begin_write_transaction().ensure();
+      }
+    }
+    for (td::int32 i = 0; i < story_dialog_count; i++) {
+      story_db.add_active_stories(dialogs_[i].dialog_id, td::StoryListId::main(),
+                                  static_cast<td::int64>(story_dialog_count - i), td::BufferSlice(100));
+    }
+    story_db.commit_transaction().ensure();
+  }
+
+  void generate_files(td::ConcurrentScheduler &scheduler) {
+    bool is_closed = false;
+    {
+      auto guard = scheduler.get_main_guard();
+      auto file_db = td::create_file_db(sql_connection_, 0);
+      for (td::int32 i = 0; i < options_.file_count; i++) {
+        auto file_type = i % 3 == 0 ? td::FileType::Video : td::FileType::Photo;
+        td::FileData file_data;
+        file_data.owner_dialog_id_ = dialogs_[get_random_active_dialog_index()].dialog_id;
+        file_data.size_ = td::Random::fast(10000, td::Random::fast(10000, 50000000));
+        file_data.local_ = td::LocalFileLocation(file_type, PSTRING() << "file_" << i << ".jpg",
+                                                 static_cast<td::uint64>(i + 1) * 1000000000);
+        file_db->set_file_data(file_db->get_next_file_db_id(), file_data, false, true, false);
+        if (i % 10000 == 9999) {
+          scheduler.run_main(0);
+        }
+      }
+      file_db->close(td::PromiseCreator::lambda([&is_closed](td::Unit) { is_closed = true; }));
+    }
+    while (!is_closed) {
+      scheduler.run_main(10);
+    }
+  }
+};
+
+class HistoryScrollBench final : public td::Benchmark {
+ public:
+  explicit HistoryScrollBench(LargeAccount &account) : account_(account) {
+  }
+  td::string get_description() const final {
+    return "LargeAccountHistoryScroll";
+  }
+  void run(int n) final {
+    auto &message_db = account_.message_db();
+    for (int i = 0; i < n; i++) {
+      auto &dialog = account_.get_dialogs()[account_.get_random_active_dialog_index()];
+      td::MessageDbMessagesQuery query;
+      query.dialog_id = dialog.dialog_id;
+      query.from_message_id = td::MessageId::max();
+      query.limit = 50;
+      for (int page = 0; page < 10; page++) {
+        auto messages = message_db.get_messages(query);
+        if (messages.size() <= 1) {
+          break;
+        }
+        query.from_message_id = messages.back().message_id;
+      }
+    }
+  }
+
+ private:
+  LargeAccount &account_;
+};
+
+class FtsSearchBench final : public td::Benchmark {
+ public:
+  FtsSearchBench(LargeAccount &account, bool in_dialog) : account_(account), in_dialog_(in_dialog) {
+  }
+  td::string get_description() const final {
+    return PSTRING() << "LargeAccountFtsSearch" << (in_dialog_ ? "InChat" : "");
+  }
+  void run(int n) final {
+    auto &message_db = account_.message_db();
+    for (int i = 0; i < n; i++) {
+      td::MessageDbFtsQuery query;
+      query.query = get_random_word();
+      if (in_dialog_) {
+        query.dialog_id = account_.get_dialogs()[account_.get_random_active_dialog_index()].dialog_id;
+      }
+      query.limit = 50;
+      for (int page = 0; page < 3; page++) {
+        auto result = message_db.get_messages_fts(query);
+        if (result.next_search_id <= 1) {
+          break;
+        }
+        query.from_search_id = result.next_search_id;
+      }
+    }
+  }
+
+ private:
+  LargeAccount &account_;
+  bool in_dialog_;
+};
+
+class DialogListBench final : public td::Benchmark {
+ public:
+  explicit DialogListBench(LargeAccount &account) : account_(account) {
+  }
+  td::string get_description() const final {
+    return "LargeAccountDialogList";
+  }
+  void run(int n) final {
+    auto &dialog_db = account_.dialog_db();
+    for (int i = 0; i < n; i++) {
+      auto order = std::numeric_limits<td::int64>::max();
+      td::DialogId dialog_id;
+      while (true) {
+        auto result = dialog_db.get_dialogs(td::FolderId::main(), order, dialog_id, 100);
+        if (result.dialogs.empty()) {
+          break;
+        }
+        order = result.next_order;
+        dialog_id = result.next_dialog_id;
+      }
+    }
+  }
+
+ private:
+  LargeAccount &account_;
+};
+
+// the database part of storage optimization, which reads all files from the file database
+class FileDbScanBench final : public td::Benchmark {
+ public:
+  explicit FileDbScanBench(LargeAccount &account) : account_(account) {
+  }
+  td::string get_description() const final {
+    return "LargeAccountFileDbScan";
+  }
+  void run(int n) final {
+    for (int i = 0; i < n; i++) {
+      td::int64 total_size = 0;
+      account_.file_kv().get_by_range("file0", "file:", [&](td::Slice key, td::Slice value) {
+        if (value.substr(0, 2) == "@@") {
+          return true;
+        }
+        td::log_event::WithVersion<td::TlParser> parser(value);
+        td::FileData data;
+        data.parse(parser, false);
+        parser.get_status().ensure();
+        total_size += data.size_;
+        return true;
+      });
+      CHECK(total_size > 0);
+    }
+  }
+
+ private:
+  LargeAccount &account_;
+};
+
+// deletes old messages and expired stories like the database garbage collector; the data can't be reused afterwards
+static void run_gc(LargeAccount &account) {
+  auto start_time = td::Time::now();
+  auto &message_db = account.message_db();
+  auto max_date = get_base_date() + GENERATED_DAYS * 86400 / 2;
+  td::int64 deleted_message_count = 0;
+  td::DialogId dialog_id;
+  while (true) {
+    dialog_id = message_db.get_next_message_dialog_id(dialog_id);
+    if (!dialog_id.is_valid()) {
+      break;
+    }
+    while (true) {
+      message_db.begin_write_transaction().ensure();
+      auto result = message_db.delete_old_dialog_messages(dialog_id, max_date, 1000);
+      message_db.commit_transaction().ensure();
+      deleted_message_count += result.deleted_count;
+      if (!result.has_more) {
+        break;
+      }
+    }
+  }
+  LOG(PLAIN) << "Deleted " << deleted_message_count << " old messages in " << td::Time::now() - start_time
+             << " seconds";
+
+  start_time = td::Time::now();
+  auto &story_db = account.story_db();
+  auto now = static_cast<td::int32>(td::Clocks::system());
+  size_t deleted_story_count = 0;
+  while (true) {
+    auto stories = story_db.get_expiring_stories(now, 1000);
+    if (stories.empty()) {
+      break;
+    }
+    story_db.begin_write_transaction().ensure();
+    for (auto &story : stories) {
+      story_db.delete_story(story.story_full_id_);
+    }
+    story_db.commit_transaction().ensure();
+    deleted_story_count += stories.size();
+  }
+  LOG(PLAIN) << "Deleted " << deleted_story_count << " expired stories in " << td::Time::now() - start_time
+             << " seconds";
+
+  start_time = td::Time::now();
+  message_db.vacuum_incrementally(std::numeric_limits<td::int32>::max());
+  LOG(PLAIN) << "Vacuumed database in " << td::Time::now() - start_time << " seconds; database size is "
+             << message_db.get_database_size() << " bytes";
+}
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
+
+  LargeAccountOptions options;
+  for (int i = 1; i < argc; i++) {
+    td::Slice arg(argv[i]);
+    if (arg == "--path" && i + 1 < argc) {
+      options.path = argv[++i];
+    } else if (arg == "--dialogs" && i + 1 < argc) {
+      options.dialog_count = td::max(td::to_integer<td::int32>(td::Slice(argv[++i])), 1);
+    } else if (arg == "--messages" && i + 1 < argc) {
+      options.message_count = td::to_integer<td::int64>(td::Slice(argv[++i]));
+    } else if (arg == "--files" && i + 1 < argc) {
+      options.file_count = td::to_integer<td::int32>(td::Slice(argv[++i]));
+    } else if (arg == "--stories" && i + 1 < argc) {
+      options.story_count = td::to_integer<td::int32>(td::Slice(argv[++i]));
+    } else if (arg == "--reuse") {
+      options.reuse = true;
+    } else if (arg == "--no-gc") {
+      options.run_gc = false;
+    } else {
+      LOG(PLAIN) << "Usage: bench_large_account [--path <database path>] [--dialogs <chat count>] [--messages "
+                    "<message count>] [--files <file count>] [--stories <story count>] [--reuse] [--no-gc]\n"
+                    "--reuse skips generation and uses the database, generated earlier with the same options\n"
+                    "--no-gc skips the garbage collection pass, which changes the database";
+      return 1;
+    }
+  }
+
+  td::ConcurrentScheduler scheduler(0, 0);
+  scheduler.start();
+
+  LargeAccount account(options);
+  account.open();
+  account.generate(scheduler);
+
+  td::bench(HistoryScrollBench(account));
+  td::bench(FtsSearchBench(account, false));
+  td::bench(FtsSearchBench(account, true));
+  td::bench(DialogListBench(account));
+  if (options.file_count > 0) {
+    td::bench(FileDbScanBench(account));
+  }
+  if (options.run_gc) {
+    run_gc(account);
+  }
+
+  account.close();
+  scheduler.finish();
+  return 0;
+}
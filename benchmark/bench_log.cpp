@@ -4,6 +4,7 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "td/utils/AsyncFileLog.h"
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
@@ -11,6 +12,7 @@
 #include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <ostream>
 #include <streambuf>
 #include <string>
@@ -150,8 +152,41 @@ class LogWriteBench final : public td::Benchmark {
   }
 };
 
+class AsyncFileLogWriteBench final : public td::Benchmark {
+ protected:
+  std::string file_name_;
+  td::unique_ptr<td::AsyncFileLog> log_;
+  td::LogInterface *old_log_interface_ = nullptr;
+
+ public:
+  std::string get_description() const final {
+    return "td_log to AsyncFileLog";
+  }
+
+  void start_up() final {
+    file_name_ = create_tmp_file();
+    log_ = td::make_unique<td::AsyncFileLog>();
+    log_->init(file_name_, std::numeric_limits<td::int64>::max(), false).ensure();
+    old_log_interface_ = td::log_interface;
+    td::log_interface = log_.get();
+  }
+
+  void run(int n) final {
+    for (int i = 0; i < n; i++) {
+      LOG(ERROR) << "This is just for test" << 987654321;
+    }
+  }
+
+  void tear_down() final {
+    td::log_interface = old_log_interface_;
+    log_ = nullptr;
+    unlink(file_name_.c_str());
+  }
+};
+
 int main() {
   td::bench(LogWriteBench());
+  td::bench(AsyncFileLogWriteBench());
 #if TD_ANDROID
   td::bench(ALogWriteBench());
 #endif
@@ -4,13 +4,22 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "td/telegram/MessageEntity.h"
 #include "td/telegram/td_api.h"
+#include "td/telegram/td_api_json.h"
 #include "td/telegram/telegram_api.h"
 #include "td/telegram/telegram_api.hpp"
 
 #include "td/utils/algorithm.h"
+#include "td/utils/base64.h"
 #include "td/utils/benchmark.h"
+#include "td/utils/buffer.h"
 #include "td/utils/common.h"
+#include "td/utils/format.h"
+#include "td/utils/Gzip.h"
+#include "td/utils/Heap.h"
+#include "td/utils/Hints.h"
+#include "td/utils/JsonBuilder.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/EventFd.h"
@@ -19,13 +28,21 @@
 #include "td/utils/port/RwMutex.h"
 #include "td/utils/port/Stat.h"
 #include "td/utils/port/thread.h"
+#include "td/utils/Promise.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/SmallObjectAllocator.h"
 #include "td/utils/StackAllocator.h"
 #include "td/utils/Status.h"
+#include "td/utils/Storer.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/ThreadSafeCounter.h"
+#include "td/utils/Time.h"
+#include "td/utils/TimerWheel.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
+#include "td/utils/utf8.h"
 
 #if !TD_WINDOWS
 #include <unistd.h>
@@ -126,6 +143,254 @@ BENCH(TlToStringMessage, "TL to_string message") {
   td::do_not_optimize_away(res);
 }
 
+// parses a typical mix of updates received from the server
+class TlFetchUpdatesBench final : public td::Benchmark {
+  static constexpr int UPDATE_COUNT = 1000;
+  td::BufferSlice data_;
+
+  td::string get_description() const final {
+    return "TL fetch of an update mix";
+  }
+
+  static void store_int_vector(td::TlStorerUnsafe &storer, int size) {
+    storer.store_int(static_cast<td::int32>(0x1cb5c415));
+    storer.store_int(size);
+    for (int i = 0; i < size; i++) {
+      storer.store_int(1000 + i);
+    }
+  }
+
+  void start_up() final {
+    td::BufferSlice buffer(UPDATE_COUNT * 64);
+    td::TlStorerUnsafe storer(buffer.as_mutable_slice().ubegin());
+    td::Random::Xorshift128plus rnd(123);
+    for (int i = 0; i < UPDATE_COUNT; i++) {
+      switch (rnd.fast(0, 5)) {
+        case 0:
+          storer.store_int(td::telegram_api::updateUserStatus::ID);
+          storer.store_long(123456000112);
+          storer.store_int(td::telegram_api::userStatusOnline::ID);
+          storer.store_int(1699999999);
+          break;
+        case 1:
+          storer.store_int(td::telegram_api::updateDeleteMessages::ID);
+          store_int_vector(storer, 3);
+          storer.store_int(1000 + i);
+          storer.store_int(1);
+          break;
+        case 2:
+          storer.store_int(td::telegram_api::updateMessageID::ID);
+          storer.store_int(1000 + i);
+          storer.store_long(1234567890123456789);
+          break;
+        case 3:
+          storer.store_int(td::telegram_api::updateReadChannelInbox::ID);
+          storer.store_int(0);
+          storer.store_long(1234567890);
+          storer.store_int(1000 + i);
+          storer.store_int(10);
+          storer.store_int(1000 + i);
+          break;
+        case 4:
+          storer.store_int(td::telegram_api::updateDeleteChannelMessages::ID);
+          storer.store_long(1234567890);
+          store_int_vector(storer, 2);
+          storer.store_int(1000 + i);
+          storer.store_int(1);
+          break;
+        case 5:
+          storer.store_int(td::telegram_api::updateChannelTooLong::ID);
+          storer.store_int(0);
+          storer.store_long(1234567890);
+          break;
+      }
+    }
+    buffer.truncate(static_cast<size_t>(storer.get_buf() - buffer.as_slice().ubegin()));
+    data_ = std::move(buffer);
+  }
+
+  void run(int n) final {
+    size_t result = 0;
+    for (int i = 0; i < n; i++) {
+      td::TlBufferParser parser(&data_);
+      for (int j = 0; j < UPDATE_COUNT; j++) {
+        result += td::telegram_api::Update::fetch(parser) != nullptr;
+      }
+      parser.fetch_end();
+      CHECK(parser.get_error() == nullptr);
+    }
+    CHECK(result == static_cast<size_t>(n) * UPDATE_COUNT);
+  }
+};
+
+// parses a messages.messages response with a batch of text messages
+class TlFetchMessagesBench final : public td::Benchmark {
+  static constexpr int MESSAGE_COUNT = 100;
+  td::BufferSlice data_;
+
+  td::string get_description() const final {
+    return PSTRING() << "TL fetch of messages.messages with " << MESSAGE_COUNT << " messages";
+  }
+
+  void start_up() final {
+    td::string text(200, 'a');
+    td::BufferSlice buffer(MESSAGE_COUNT * (text.size() + 200) + 100);
+    td::TlStorerUnsafe storer(buffer.as_mutable_slice().ubegin());
+    storer.store_int(td::telegram_api::messages_messages::ID);
+    storer.store_int(static_cast<td::int32>(0x1cb5c415));
+    storer.store_int(MESSAGE_COUNT);
+    for (int i = 0; i < MESSAGE_COUNT; i++) {
+      storer.store_int(td::telegram_api::message::ID);
+      storer.store_int(256 | 128 | 1024);  // from_id, entities, views and forwards
+      storer.store_int(0);
+      storer.store_int(1000 + i);
+      storer.store_int(td::telegram_api::peerUser::ID);
+      storer.store_long(123456000112);
+      storer.store_int(td::telegram_api::peerChannel::ID);
+      storer.store_long(1234567890);
+      storer.store_int(1699999999 + i);
+      storer.store_string(text);
+      storer.store_int(static_cast<td::int32>(0x1cb5c415));
+      storer.store_int(3);
+      for (int j = 0; j < 3; j++) {
+        storer.store_int(td::telegram_api::messageEntityBold::ID);
+        storer.store_int(j * 10);
+        storer.store_int(5);
+      }
+      storer.store_int(100 + i);
+      storer.store_int(i);
+    }
+    for (int i = 0; i < 2; i++) {  // chats and users
+      storer.store_int(static_cast<td::int32>(0x1cb5c415));
+      storer.store_int(0);
+    }
+    buffer.truncate(static_cast<size_t>(storer.get_buf() - buffer.as_slice().ubegin()));
+    data_ = std::move(buffer);
+  }
+
+  void run(int n) final {
+    size_t result = 0;
+    for (int i = 0; i < n; i++) {
+      td::TlBufferParser parser(&data_);
+      auto messages = td::telegram_api::messages_Messages::fetch(parser);
+      parser.fetch_end();
+      CHECK(parser.get_error() == nullptr);
+      result += static_cast<const td::telegram_api::messages_messages *>(messages.get())->messages_.size();
+    }
+    CHECK(result == static_cast<size_t>(n) * MESSAGE_COUNT);
+  }
+};
+
+constexpr int TlFetchMessagesBench::MESSAGE_COUNT;
+
+// parses an updates.difference response with a batch of text messages and their senders
+class TlFetchUpdatesDifferenceBench final : public td::Benchmark {
+  static constexpr int MESSAGE_COUNT = 100;
+  static constexpr int USER_COUNT = 20;
+  td::BufferSlice data_;
+
+  td::string get_description() const final {
+    return PSTRING() << "TL fetch of updates.difference with " << MESSAGE_COUNT << " messages and " << USER_COUNT
+                     << " users";
+  }
+
+  void start_up() final {
+    td::string text(100, 'a');
+    td::BufferSlice buffer(MESSAGE_COUNT * (text.size() + 200) + USER_COUNT * 100 + 100);
+    td::TlStorerUnsafe storer(buffer.as_mutable_slice().ubegin());
+    storer.store_int(td::telegram_api::updates_difference::ID);
+    storer.store_int(static_cast<td::int32>(0x1cb5c415));
+    storer.store_int(MESSAGE_COUNT);
+    for (int i = 0; i < MESSAGE_COUNT; i++) {
+      storer.store_int(td::telegram_api::message::ID);
+      storer.store_int(256 | 128 | 1024 | 32768);  // from_id, entities, views and forwards, edit_date
+      storer.store_int(0);
+      storer.store_int(1000 + i);
+      storer.store_int(td::telegram_api::peerUser::ID);
+      storer.store_long(123456000000 + i % USER_COUNT);
+      storer.store_int(td::telegram_api::peerUser::ID);
+      storer.store_long(123456000112);
+      storer.store_int(1699999999 + i);
+      storer.store_string(text);
+      storer.store_int(static_cast<td::int32>(0x1cb5c415));
+      storer.store_int(2);
+      for (int j = 0; j < 2; j++) {
+        storer.store_int(td::telegram_api::messageEntityBold::ID);
+        storer.store_int(j * 10);
+        storer.store_int(5);
+      }
+      storer.store_int(100 + i);
+      storer.store_int(i);
+      storer.store_int(1700000000 + i);
+    }
+    for (int i = 0; i < 3; i++) {  // new_encrypted_messages, other_updates and chats
+      storer.store_int(static_cast<td::int32>(0x1cb5c415));
+      storer.store_int(0);
+    }
+    storer.store_int(static_cast<td::int32>(0x1cb5c415));
+    storer.store_int(USER_COUNT);
+    for (int i = 0; i < USER_COUNT; i++) {
+      storer.store_int(td::telegram_api::user::ID);
+      storer.store_int(1 | 2 | 4 | 8 | 64);  // access_hash, first_name, last_name, username and status
+      storer.store_int(0);
+      storer.store_long(123456000000 + i);
+      storer.store_long(1234567890123456789);
+      storer.store_string(td::Slice("First"));
+      storer.store_string(td::Slice("Last"));
+      storer.store_string(td::Slice("username"));
+      storer.store_int(td::telegram_api::userStatusRecently::ID);
+      storer.store_int(0);
+    }
+    storer.store_int(td::telegram_api::updates_state::ID);
+    for (int i = 0; i < 5; i++) {
+      storer.store_int(1000 + i);
+    }
+    buffer.truncate(static_cast<size_t>(storer.get_buf() - buffer.as_slice().ubegin()));
+    data_ = std::move(buffer);
+  }
+
+  void run(int n) final {
+    size_t result = 0;
+    for (int i = 0; i < n; i++) {
+      td::TlBufferParser parser(&data_);
+      auto difference = td::telegram_api::updates_Difference::fetch(parser);
+      parser.fetch_end();
+      CHECK(parser.get_error() == nullptr);
+      result += static_cast<const td::telegram_api::updates_difference *>(difference.get())->new_messages_.size();
+    }
+    CHECK(result == static_cast<size_t>(n) * MESSAGE_COUNT);
+  }
+};
+
+constexpr int TlFetchUpdatesDifferenceBench::MESSAGE_COUNT;
+constexpr int TlFetchUpdatesDifferenceBench::USER_COUNT;
+
+BENCH(TlToJsonMessages, "TL to JSON messages") {
+  auto x = td::td_api::make_object<td::td_api::messages>();
+  x->total_count_ = 100;
+  for (int i = 0; i < 100; i++) {
+    auto message = td::td_api::make_object<td::td_api::message>();
+    message->id_ = 123456000111 + i * 1048576;
+    message->sender_id_ = td::td_api::make_object<td::td_api::messageSenderUser>(123456000112);
+    message->chat_id_ = -1001234567890;
+    message->date_ = 1699999999 + i;
+    td::string text;
+    for (int j = 0; j <= i % 10; j++) {
+      text += "The quick brown fox jumps over the lazy dog.\nСъешь же ещё этих мягких французских булок \"🦊\" ";
+    }
+    auto formatted_text = td::td_api::make_object<td::td_api::formattedText>();
+    formatted_text->text_ = std::move(text);
+    message->content_ = td::td_api::make_object<td::td_api::messageText>(std::move(formatted_text), nullptr, nullptr);
+    x->messages_.push_back(std::move(message));
+  }
+
+  std::size_t res = 0;
+  for (int i = 0; i < n; i++) {
+    res += td::json_encode<td::string>(td::ToJson(*x)).size();
+  }
+  td::do_not_optimize_away(res);
+}
+
 #if !TD_EVENTFD_UNSUPPORTED
 BENCH(EventFd, "EventFd") {
   td::EventFd fd;
@@ -188,6 +453,64 @@ BENCH(Time, "Clocks::monotonic") {
   td::do_not_optimize_away(res);
 }
 */
+
+BENCH(TimeNow, "Time::now") {
+  double res = 0;
+  for (int i = 0; i < n; i++) {
+    res += td::Time::now();
+  }
+  td::do_not_optimize_away(res);
+}
+
+static td::string get_random_bytes(size_t size) {
+  td::string result(size, '\0');
+  for (auto &c : result) {
+    c = static_cast<char>(td::Random::fast_uint32() & 255);
+  }
+  return result;
+}
+
+BENCH(Base64Encode, "base64_encode 1000 bytes") {
+  auto data = get_random_bytes(1000);
+  std::size_t res = 0;
+  for (int i = 0; i < n; i++) {
+    res += td::base64_encode(data).size();
+  }
+  td::do_not_optimize_away(res);
+}
+
+BENCH(Base64Decode, "base64_decode 1000 bytes") {
+  auto data = td::base64_encode(get_random_bytes(1000));
+  std::size_t res = 0;
+  for (int i = 0; i < n; i++) {
+    res += td::base64_decode(data).ok().size();
+  }
+  td::do_not_optimize_away(res);
+}
+
+BENCH(PromiseSmall, "PromiseCreator::lambda with free lists") {
+  td::int64 res = 0;
+  for (int i = 0; i < n; i++) {
+    auto promise = td::PromiseCreator::lambda([&res, i](td::int64 value) { res += value + i; });
+    auto moved_promise = std::move(promise);
+    moved_promise.set_value(1);
+  }
+  td::do_not_optimize_away(res);
+}
+
+BENCH(PromiseHeap, "PromiseCreator::lambda with heap allocation") {
+  td::int64 res = 0;
+  // the capture is too big for SmallObjectAllocator
+  std::array<td::int64, td::SmallObjectAllocator::MAX_SIZE / sizeof(td::int64)> big_capture{};
+  for (int i = 0; i < n; i++) {
+    auto promise = td::PromiseCreator::lambda([&res, i, big_capture](td::int64 value) {
+      res += value + i + big_capture[0];
+    });
+    auto moved_promise = std::move(promise);
+    moved_promise.set_value(1);
+  }
+  td::do_not_optimize_away(res);
+}
 #if !TD_WINDOWS
 class PipeBench final : public td::Benchmark {
  public:
@@ -752,9 +1075,318 @@ BENCH(AnyOfTd, "any_of td") {
   td::do_not_optimize_away(res);
 }
 
+// prefix search over contacts-like names; memory usage per key is logged once during start_up
+class HintsBench final : public td::Benchmark {
+  static constexpr int KEY_COUNT = 100000;
+  td::Hints hints_;
+  td::vector<td::string> queries_;
+
+  td::string get_description() const final {
+    return PSTRING() << "Hints search among " << KEY_COUNT << " keys";
+  }
+
+  static td::string gen_word(td::Random::Xorshift128plus &rnd) {
+    td::string result(static_cast<size_t>(rnd.fast(3, 10)), ' ');
+    for (auto &c : result) {
+      c = static_cast<char>('a' + rnd.fast(0, 25));
+    }
+    return result;
+  }
+
+  void start_up() final {
+    td::Random::Xorshift128plus rnd(123);
+    hints_ = td::Hints();
+    auto r_old_mem_stat = td::mem_stat();
+    for (int i = 1; i <= KEY_COUNT; i++) {
+      hints_.add(i, PSLICE() << gen_word(rnd) << ' ' << gen_word(rnd));
+      hints_.set_rating(i, -i);
+    }
+    auto r_new_mem_stat = td::mem_stat();
+    if (r_old_mem_stat.is_ok() && r_new_mem_stat.is_ok()) {
+      auto memory = r_new_mem_stat.ok().resident_size_ - r_old_mem_stat.ok().resident_size_;
+      LOG(ERROR) << "Hints uses " << td::format::as_size(memory) << " for " << KEY_COUNT << " keys, "
+                 << memory / KEY_COUNT << " bytes per key";
+    }
+
+    queries_.clear();
+    for (int i = 0; i < 1000; i++) {
+      queries_.push_back(gen_word(rnd).substr(0, static_cast<size_t>(rnd.fast(1, 3))));
+    }
+  }
+
+  void run(int n) final {
+    size_t result = 0;
+    for (int i = 0; i < n; i++) {
+      result += hints_.search(queries_[static_cast<size_t>(i) % queries_.size()], 10).first;
+    }
+    td::do_not_optimize_away(result);
+  }
+};
+
+constexpr int HintsBench::KEY_COUNT;
+
+// validation and UTF-16 length computation of a long message text
+class Utf8Bench final : public td::Benchmark {
+  bool is_ascii_;
+  td::string text_;
+
+  td::string get_description() const final {
+    return PSTRING() << "UTF-8 check and UTF-16 length of " << (is_ascii_ ? "ASCII" : "mixed") << " text";
+  }
+
+  void start_up() final {
+    text_.clear();
+    while (text_.size() < 4096) {
+      text_ += is_ascii_ ? "The quick brown fox jumps over the lazy dog. " : "The quick brown fox съешь же ещё 🦊 ";
+    }
+  }
+
+  void run(int n) final {
+    size_t result = 0;
+    for (int i = 0; i < n; i++) {
+      result += td::check_utf8(text_) + td::utf8_utf16_length(text_);
+    }
+    td::do_not_optimize_away(result);
+  }
+
+ public:
+  explicit Utf8Bench(bool is_ascii) : is_ascii_(is_ascii) {
+  }
+};
+
+template <class TimeoutQueueT>
+class TimeoutQueueBench final : public td::Benchmark {
+  static constexpr int NODE_COUNT = 10000;
+  const char *name_;
+
+  td::string get_description() const final {
+    return PSTRING() << "TimeoutQueue " << name_;
+  }
+  void run(int n) final {
+    td::vector<td::HeapNode> nodes(NODE_COUNT);
+    TimeoutQueueT timeout_queue;
+    td::Random::Xorshift128plus rnd(123);
+    double now = 0.0;
+    for (int i = 0; i < n; i++) {
+      now += 1e-4;
+      auto &node = nodes[static_cast<size_t>(rnd() % NODE_COUNT)];
+      auto timeout = now + static_cast<double>(rnd() % 10000) * 1e-3;
+      if (node.in_heap()) {
+        timeout_queue.fix(timeout, &node);
+      } else {
+        timeout_queue.insert(timeout, &node);
+      }
+      while (!timeout_queue.empty() && timeout_queue.top_key() < now) {
+        timeout_queue.pop();
+      }
+    }
+    td::do_not_optimize_away(timeout_queue.size());
+  }
+
+ public:
+  explicit TimeoutQueueBench(const char *name) : name_(name) {
+  }
+};
+
+#if TD_HAVE_ZLIB
+// compresses a typical TL query the same way as NetQueryCreator does
+class GzencodeQueryBench final : public td::Benchmark {
+ public:
+  explicit GzencodeQueryBench(bool reuse_stream) : reuse_stream_(reuse_stream) {
+  }
+
+  size_t get_saved_size() const {
+    return saved_size_;
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "gzencode query of size " << query_.size() << (reuse_stream_ ? " with" : " without")
+                     << " stream reuse";
+  }
+
+ private:
+  bool reuse_stream_;
+  td::string query_;
+  size_t saved_size_ = 0;
+
+  static td::BufferSlice gzencode_without_reuse(td::Slice s, double max_compression_ratio) {
+    td::Gzip gzip;
+    gzip.init_encode().ensure();
+    gzip.set_input(s);
+    gzip.close_input();
+    td::BufferWriter message{static_cast<size_t>(static_cast<double>(s.size()) * max_compression_ratio)};
+    gzip.set_output(message.prepare_append());
+    auto r_state = gzip.run();
+    if (r_state.is_error() || r_state.ok() != td::Gzip::State::Done) {
+      return td::BufferSlice();
+    }
+    message.confirm_append(gzip.flush_output());
+    return message.as_buffer_slice();
+  }
+
+  td::BufferSlice encode() const {
+    return reuse_stream_ ? td::gzencode(query_, 0.9) : gzencode_without_reuse(query_, 0.9);
+  }
+
+  void start_up() final {
+    td::vector<td::telegram_api::object_ptr<td::telegram_api::InputMessage>> message_ids;
+    for (int i = 0; i < 100; i++) {
+      message_ids.push_back(td::telegram_api::make_object<td::telegram_api::inputMessageID>(1000000 + i * 3));
+    }
+    td::telegram_api::messages_getMessages function(std::move(message_ids));
+    auto storer = td::DefaultStorer<td::telegram_api::Function>(function);
+    query_.resize(storer.size());
+    storer.store(td::MutableSlice(query_).ubegin());
+    auto compressed = encode();
+    CHECK(!compressed.empty());
+    saved_size_ = query_.size() - compressed.size();
+  }
+
+  void run(int n) final {
+    size_t result = 0;
+    for (int i = 0; i < n; i++) {
+      result += encode().size();
+    }
+    td::do_not_optimize_away(result);
+  }
+};
+
+static void bench_cpu_per_saved_kilobyte(GzencodeQueryBench &&b, double max_time = 1.0) {
+  int n = 1;
+  double pass_time = 0;
+  while (pass_time < max_time && n < (1 << 30)) {
+    n *= 2;
+    pass_time = td::bench_n(b, n).first;
+  }
+  auto description = b.get_description();
+  std::string pad;
+  if (description.size() < 40) {
+    pad = std::string(40 - description.size(), ' ');
+  }
+  auto time_per_query = pass_time / n;
+  LOG(ERROR) << "Bench [" << pad << description << "]: " << td::format::as_time(time_per_query) << " per query, "
+             << td::format::as_time(time_per_query * 1024 / static_cast<double>(b.get_saved_size()))
+             << " per saved KB";
+}
+#endif
+
+// inputs are similar to the ones in test/message_entities.cpp
+class FindEntitiesBench final : public td::Benchmark {
+ public:
+  explicit FindEntitiesBench(bool has_entities) : has_entities_(has_entities) {
+  }
+
+ private:
+  bool has_entities_;
+  td::vector<td::string> texts_;
+
+  td::string get_description() const final {
+    return PSTRING() << "find_entities " << (has_entities_ ? "with entities" : "in plain text");
+  }
+
+  void start_up() final {
+    texts_.clear();
+    if (has_entities_) {
+      texts_.push_back("Hi @android_omnibox, say hello to @gif and t.me/username, or mail to a@example.com!");
+      texts_.push_back("/start@bot and /help: see https://telegram.org/faq#general-questions for #details");
+      texts_.push_back("Jump to 1:23:45 or 12:34 and pay 4242 4242 4242 4242 for $TON at tg://resolve?domain=a");
+      texts_.push_back(
+          "Channel post with several paragraphs.\nFirst one has a link to www.example.org/path?query=1 and #tag, "
+          "the second mentions @durov and #hashtag2, the last one has a cashtag $USD and an e-mail test@test.com.");
+    } else {
+      texts_.push_back("Hello, how are you doing today");
+      texts_.push_back("Привет, как дела? Всё хорошо");
+      td::string long_text;
+      for (int i = 0; i < 20; i++) {
+        long_text += "a long message in a group chat without any special characters, but with commas and spaces ";
+      }
+      texts_.push_back(long_text);
+    }
+  }
+
+  void run(int n) final {
+    size_t entity_count = 0;
+    for (int i = 0; i < n; i++) {
+      for (auto &text : texts_) {
+        entity_count += td::find_entities(text, false, false).size();
+      }
+    }
+    td::do_not_optimize_away(entity_count);
+  }
+};
+
+class ParseMarkupBench final : public td::Benchmark {
+ public:
+  explicit ParseMarkupBench(bool is_html) : is_html_(is_html) {
+  }
+
+ private:
+  bool is_html_;
+  td::vector<td::string> texts_;
+
+  td::string get_description() const final {
+    return PSTRING() << (is_html_ ? "parse_html" : "parse_markdown_v2");
+  }
+
+  void start_up() final {
+    texts_.clear();
+    td::string long_text;
+    for (int i = 0; i < 20; i++) {
+      long_text += "a long message in a group chat without any formatting, but with commas and spaces ";
+    }
+    texts_.push_back(long_text);
+    texts_.push_back("Привет, как дела? Всё хорошо");
+    if (is_html_) {
+      texts_.push_back("<b>bold</b> and <i>italic &amp; more</i>, <a href=\"https://telegram.org/\">link</a> and "
+                       "<code>some code</code> followed by a long enough unformatted tail of the message");
+    } else {
+      texts_.push_back("*bold* and _italic \\& more_, [link](https://telegram.org/) and `some code` followed by "
+                       "a long enough unformatted tail of the message");
+    }
+  }
+
+  void run(int n) final {
+    size_t entity_count = 0;
+    for (int i = 0; i < n; i++) {
+      for (auto text : texts_) {
+        auto r_entities = is_html_ ? td::parse_html(text) : td::parse_markdown_v2(text);
+        entity_count += r_entities.ok().size();
+      }
+    }
+    td::do_not_optimize_away(entity_count);
+  }
+};
+
 int main() {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(DEBUG));
 
+#if TD_HAVE_ZLIB
+  bench_cpu_per_saved_kilobyte(GzencodeQueryBench(false));
+  bench_cpu_per_saved_kilobyte(GzencodeQueryBench(true));
+#endif
+
+  td::bench(TimeoutQueueBench<td::KHeap<double>>("KHeap"));
+  td::bench(TimeoutQueueBench<td::TimerWheel>("TimerWheel"));
+
+  td::bench(HintsBench());
+
+  td::bench(FindEntitiesBench(false));
+  td::bench(FindEntitiesBench(true));
+
+  td::bench(ParseMarkupBench(false));
+  td::bench(ParseMarkupBench(true));
+
+  td::bench(Utf8Bench(true));
+  td::bench(Utf8Bench(false));
+
+  td::bench(TimeNowBench());
+
+  td::bench(Base64EncodeBench());
+  td::bench(Base64DecodeBench());
+
+  td::bench(PromiseSmallBench());
+  td::bench(PromiseHeapBench());
+
   td::bench(AnyOfStdBench());
   td::bench(AnyOfTdBench());
 
@@ -766,6 +1398,10 @@ int main() {
 
   td::bench(TlToStringUpdateFileBench());
   td::bench(TlToStringMessageBench());
+  td::bench(TlToJsonMessagesBench());
+  td::bench(TlFetchUpdatesBench());
+  td::bench(TlFetchMessagesBench());
+  td::bench(TlFetchUpdatesDifferenceBench());
 
   td::bench(DuplicateCheckerBenchEvenOdd<IdDuplicateCheckerNew<1000>>());
   td::bench(DuplicateCheckerBenchEvenOdd<IdDuplicateCheckerNew<300>>());
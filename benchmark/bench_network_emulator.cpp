@@ -0,0 +1,399 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "NetworkEmulator.h"
+
+#include "td/net/TcpListener.h"
+
+#include "td/actor/actor.h"
+#include "td/actor/ConcurrentScheduler.h"
+
+#include "td/utils/as.h"
+#include "td/utils/buffer.h"
+#include "td/utils/BufferedFd.h"
+#include "td/utils/common.h"
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/port/IPAddress.h"
+#include "td/utils/port/SocketFd.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Status.h"
+#include "td/utils/Time.h"
+
+#include <algorithm>
+
+// Runs transport scenarios through the in-process network emulator under several network profiles.
+// Frames emulate MTProto packets: each request frame contains the size of the response frame, which the server sends.
+// The scenarios reproduce the traffic shape of query packing into containers, parallel file part downloads and
+// reconnections, so their results depend only on the emulated network conditions.
+
+// size of auth_key_id, msg_key, salt, session_id, msg_id, seq_no and length of an encrypted MTProto packet
+static constexpr size_t ENCRYPTED_PACKET_OVERHEAD = 56;
+// size of msg_id, seq_no and length of a message in a container
+static constexpr size_t CONTAINER_MESSAGE_OVERHEAD = 16;
+static constexpr size_t CONTAINER_OVERHEAD = 8;
+
+static size_t get_padded_size(size_t size) {
+  return (size + 15) / 16 * 16;
+}
+
+class FrameServerConnection final : public td::Actor {
+ public:
+  explicit FrameServerConnection(td::SocketFd fd) : fd_(std::move(fd)) {
+  }
+
+ private:
+  td::BufferedFd<td::SocketFd> fd_;
+
+  void start_up() final {
+    td::Scheduler::subscribe(fd_.get_poll_info().extract_pollable_fd(this));
+  }
+
+  void tear_down() final {
+    td::Scheduler::unsubscribe_before_close(fd_.get_poll_info().get_pollable_fd_ref());
+    fd_.close();
+  }
+
+  void hangup() final {
+    stop();
+  }
+
+  void loop() final {
+    auto status = [&] {
+      td::sync_with_poll(fd_);
+      TRY_STATUS(fd_.flush_read());
+      auto &input = fd_.input_buffer();
+      while (input.size() >= 8) {
+        char header[8];
+        input.clone().advance(8, td::MutableSlice(header, 8));
+        auto frame_size = static_cast<size_t>(td::as<td::int32>(header));
+        if (input.size() < 4 + frame_size) {
+          break;
+        }
+        auto response_size = static_cast<size_t>(td::as<td::int32>(header + 4));
+        input.advance(4 + frame_size);
+
+        td::BufferSlice response(4 + response_size);
+        std::fill(response.as_mutable_slice().begin(), response.as_mutable_slice().end(), '\0');
+        td::as<td::int32>(response.as_mutable_slice().begin()) = static_cast<td::int32>(response_size);
+        fd_.output_buffer().append(std::move(response));
+      }
+      TRY_STATUS(fd_.flush_write());
+      if (td::can_close_local(fd_)) {
+        return td::Status::Error("Connection closed");
+      }
+      return td::Status::OK();
+    }();
+    if (status.is_error()) {
+      stop();
+    }
+  }
+};
+
+class FrameServer final : public td::TcpListener::Callback {
+ public:
+  explicit FrameServer(int port) : port_(port) {
+  }
+
+  void accept(td::SocketFd fd) final {
+    connections_.push_back(td::create_actor<FrameServerConnection>("FrameServerConnection", std::move(fd)));
+  }
+
+ private:
+  int port_;
+  td::ActorOwn<td::TcpListener> listener_;
+  td::vector<td::ActorOwn<FrameServerConnection>> connections_;
+
+  void start_up() final {
+    listener_ = td::create_actor<td::TcpListener>("FrameServerListener", port_, actor_shared(this), "127.0.0.1");
+  }
+
+  void hangup() final {
+    listener_.reset();
+    connections_.clear();
+    stop();
+  }
+};
+
+struct FrameScenario {
+  size_t frame_count = 1;
+  size_t window = 1;  // maximum number of frames waiting for a response
+  size_t request_size = 0;
+  size_t response_size = 0;
+};
+
+// sends frames over a new connection and returns the time till all responses are received
+class FrameClient final : public td::Actor {
+ public:
+  FrameClient(td::IPAddress address, FrameScenario scenario, td::Promise<double> promise)
+      : address_(std::move(address)), scenario_(scenario), promise_(std::move(promise)) {
+  }
+
+ private:
+  td::IPAddress address_;
+  FrameScenario scenario_;
+  td::Promise<double> promise_;
+  td::BufferedFd<td::SocketFd> fd_;
+  double start_time_ = 0.0;
+  size_t sent_count_ = 0;
+  size_t received_count_ = 0;
+
+  void start_up() final {
+    start_time_ = td::Time::now();
+    auto r_fd = td::SocketFd::open(address_);
+    if (r_fd.is_error()) {
+      promise_.set_error(r_fd.move_as_error());
+      return stop();
+    }
+    fd_ = td::BufferedFd<td::SocketFd>(r_fd.move_as_ok());
+    td::Scheduler::subscribe(fd_.get_poll_info().extract_pollable_fd(this));
+    loop();
+  }
+
+  void tear_down() final {
+    if (!fd_.empty()) {
+      td::Scheduler::unsubscribe_before_close(fd_.get_poll_info().get_pollable_fd_ref());
+      fd_.close();
+    }
+  }
+
+  void loop() final {
+    auto status = loop_impl();
+    if (status.is_error()) {
+      promise_.set_error(std::move(status));
+      return stop();
+    }
+    if (received_count_ == scenario_.frame_count) {
+      promise_.set_value(td::Time::now() - start_time_);
+      return stop();
+    }
+  }
+
+  td::Status loop_impl() {
+    td::sync_with_poll(fd_);
+    TRY_STATUS(fd_.flush_read());
+    auto &input = fd_.input_buffer();
+    while (input.size() >= 4) {
+      char header[4];
+      input.clone().advance(4, td::MutableSlice(header, 4));
+      auto frame_size = static_cast<size_t>(td::as<td::int32>(header));
+      if (input.size() < 4 + frame_size) {
+        break;
+      }
+      input.advance(4 + frame_size);
+      received_count_++;
+    }
+    while (sent_count_ < scenario_.frame_count && sent_count_ - received_count_ < scenario_.window) {
+      auto request_size = td::max(scenario_.request_size, static_cast<size_t>(4));
+      td::BufferSlice request(4 + request_size);
+      std::fill(request.as_mutable_slice().begin(), request.as_mutable_slice().end(), '\0');
+      td::as<td::int32>(request.as_mutable_slice().begin()) = static_cast<td::int32>(request_size);
+      td::as<td::int32>(request.as_mutable_slice().begin() + 4) = static_cast<td::int32>(scenario_.response_size);
+      fd_.output_buffer().append(std::move(request));
+      sent_count_++;
+    }
+    TRY_STATUS(fd_.flush_write());
+    if (td::can_close_local(fd_)) {
+      return td::Status::Error("Connection closed");
+    }
+    return td::Status::OK();
+  }
+};
+
+struct ScenarioRun {
+  td::string description;
+  FrameScenario scenario;
+  size_t repeat_count = 1;  // number of sequential connections
+  size_t payload_size = 0;  // useful data size per connection
+};
+
+class BenchmarkRunner final : public td::Actor {
+ public:
+  BenchmarkRunner(int port, td::vector<td::NetworkProfile> profiles, td::vector<ScenarioRun> runs)
+      : port_(port), profiles_(std::move(profiles)), runs_(std::move(runs)) {
+  }
+
+ private:
+  int port_;
+  td::vector<td::NetworkProfile> profiles_;
+  td::vector<ScenarioRun> runs_;
+  size_t profile_pos_ = 0;
+  size_t run_pos_ = 0;
+  size_t repeat_pos_ = 0;
+  double total_time_ = 0.0;
+  td::ActorOwn<FrameServer> server_;
+  td::ActorOwn<td::NetworkEmulator> emulator_;
+  td::ActorOwn<FrameClient> client_;
+
+  int get_emulator_port() const {
+    return port_ + 1 + static_cast<int>(profile_pos_);
+  }
+
+  void start_up() final {
+    server_ = td::create_actor<FrameServer>("FrameServer", port_);
+    start_profile();
+  }
+
+  void start_profile() {
+    if (profile_pos_ == profiles_.size()) {
+      server_.reset();
+      td::Scheduler::instance()->finish();
+      return stop();
+    }
+    td::IPAddress server_address;
+    server_address.init_ipv4_port("127.0.0.1", port_).ensure();
+    emulator_ = td::create_actor<td::NetworkEmulator>("NetworkEmulator", get_emulator_port(), server_address,
+                                                      profiles_[profile_pos_], td::ActorShared<>());
+    run_pos_ = 0;
+    repeat_pos_ = 0;
+    total_time_ = 0.0;
+    // give the listeners time to start
+    set_timeout_in(0.1);
+  }
+
+  void timeout_expired() final {
+    start_client();
+  }
+
+  void start_client() {
+    td::IPAddress emulator_address;
+    emulator_address.init_ipv4_port("127.0.0.1", get_emulator_port()).ensure();
+    client_ = td::create_actor<FrameClient>(
+        "FrameClient", emulator_address, runs_[run_pos_].scenario,
+        td::PromiseCreator::lambda([actor_id = actor_id(this)](td::Result<double> r_time) {
+          send_closure(actor_id, &BenchmarkRunner::on_client_finished, std::move(r_time));
+        }));
+  }
+
+  void on_client_finished(td::Result<double> r_time) {
+    client_.reset();
+    auto &run = runs_[run_pos_];
+    if (r_time.is_error()) {
+      LOG(ERROR) << run.description << " failed: " << r_time.error();
+    } else {
+      total_time_ += r_time.ok();
+    }
+    if (++repeat_pos_ < run.repeat_count) {
+      return start_client();
+    }
+
+    auto &profile = profiles_[profile_pos_];
+    auto time = total_time_ / static_cast<double>(run.repeat_count);
+    LOG(PLAIN) << profile.name << ": " << run.description << ": " << td::format::as_time(time)
+               << (run.payload_size == 0 ? td::string()
+                                         : PSTRING() << ", " << td::format::as_size(static_cast<td::int64>(
+                                                                    static_cast<double>(run.payload_size) / time))
+                                                     << "/s");
+    repeat_pos_ = 0;
+    total_time_ = 0.0;
+    if (++run_pos_ < runs_.size()) {
+      return start_client();
+    }
+    emulator_.reset();
+    profile_pos_++;
+    start_profile();
+  }
+};
+
+static td::vector<ScenarioRun> get_scenario_runs(size_t query_count) {
+  td::vector<ScenarioRun> runs;
+
+  // SessionConnection sends either one query per encrypted packet or packs several queries into a container
+  const size_t query_size = 64;
+  const size_t answer_size = 32;
+  for (size_t queries_per_container : {1, 8, 32, 128}) {
+    ScenarioRun run;
+    run.description = PSTRING() << query_count << " queries, " << queries_per_container << " per packet";
+    auto packet_count = (query_count + queries_per_container - 1) / queries_per_container;
+    auto get_packet_size = [queries_per_container](size_t message_size) {
+      if (queries_per_container == 1) {
+        return get_padded_size(ENCRYPTED_PACKET_OVERHEAD + message_size);
+      }
+      return get_padded_size(ENCRYPTED_PACKET_OVERHEAD + CONTAINER_OVERHEAD +
+                             queries_per_container * (CONTAINER_MESSAGE_OVERHEAD + message_size));
+    };
+    run.scenario.frame_count = packet_count;
+    run.scenario.window = packet_count;
+    run.scenario.request_size = get_packet_size(query_size);
+    run.scenario.response_size = get_packet_size(answer_size);
+    runs.push_back(std::move(run));
+  }
+
+  // ResourceManager limits the number of file parts, which are downloaded simultaneously
+  const size_t part_size = 128 << 10;
+  const size_t part_count = 32;
+  for (size_t window : {1, 2, 4, 8, 16}) {
+    ScenarioRun run;
+    run.description = PSTRING() << "download of " << part_count << " parts, " << window << " in flight";
+    run.scenario.frame_count = part_count;
+    run.scenario.window = window;
+    run.scenario.request_size = get_padded_size(ENCRYPTED_PACKET_OVERHEAD + 64);
+    run.scenario.response_size = get_padded_size(ENCRYPTED_PACKET_OVERHEAD + 32 + part_size);
+    run.payload_size = part_count * part_size;
+    runs.push_back(std::move(run));
+  }
+
+  // ConnectionCreator opens a new connection and waits for the first answer before the connection is used
+  {
+    ScenarioRun run;
+    run.description = "reconnect and first ping";
+    run.scenario.request_size = get_padded_size(ENCRYPTED_PACKET_OVERHEAD + 20);
+    run.scenario.response_size = get_padded_size(ENCRYPTED_PACKET_OVERHEAD + 28);
+    run.repeat_count = 10;
+    runs.push_back(std::move(run));
+  }
+  return runs;
+}
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+
+  int port = 20010;
+  size_t query_count = 10000;
+  td::string profile_names = "datacenter,mobile,satellite";
+  for (int i = 1; i < argc; i++) {
+    td::Slice arg(argv[i]);
+    if (arg == "--port" && i + 1 < argc) {
+      port = td::to_integer<int>(td::Slice(argv[++i]));
+    } else if (arg == "--queries" && i + 1 < argc) {
+      query_count = td::max(td::to_integer<size_t>(td::Slice(argv[++i])), static_cast<size_t>(1));
+    } else if (arg == "--profiles" && i + 1 < argc) {
+      profile_names = argv[++i];
+    } else {
+      LOG(PLAIN) << "Usage: bench_network_emulator [--port <first local port to use>] [--queries <query count>] "
+                    "[--profiles <comma-separated list of datacenter, mobile, satellite>]";
+      return 1;
+    }
+  }
+
+  td::vector<td::NetworkProfile> profiles;
+  for (auto name : td::full_split(td::Slice(profile_names), ',')) {
+    if (name == "datacenter") {
+      profiles.push_back(td::NetworkProfile::datacenter());
+    } else if (name == "mobile") {
+      profiles.push_back(td::NetworkProfile::mobile());
+    } else if (name == "satellite") {
+      profiles.push_back(td::NetworkProfile::satellite());
+    } else {
+      LOG(PLAIN) << "Unknown network profile " << name;
+      return 1;
+    }
+  }
+
+  td::ConcurrentScheduler scheduler(0, 0);
+  scheduler.create_actor_unsafe<BenchmarkRunner>(0, "BenchmarkRunner", port, std::move(profiles),
+                                                 get_scenario_runs(query_count))
+      .release();
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+  return 0;
+}
@@ -7,11 +7,13 @@
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
+#include "td/utils/MpmcQueue.h"
 #include "td/utils/MpscPollableQueue.h"
 #include "td/utils/port/sleep.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/queue.h"
 #include "td/utils/Random.h"
+#include "td/utils/SliceBuilder.h"
 
 // TODO: check system calls
 // TODO: all return values must be checked
@@ -882,11 +884,82 @@ static void test_queue() {
 #endif
 */
 
+#if !TD_THREAD_UNSUPPORTED
+class MpmcQueueBenchmark final : public td::Benchmark {
+  const size_t writers_n;
+  const size_t readers_n;
+  const size_t bulk_size;
+
+ public:
+  MpmcQueueBenchmark(size_t writers_n, size_t readers_n, size_t bulk_size)
+      : writers_n(writers_n), readers_n(readers_n), bulk_size(bulk_size) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "MpmcQueue(" << writers_n << " writers, " << readers_n << " readers, bulk size " << bulk_size
+                     << ")";
+  }
+
+  void run(int n) final {
+    td::MpmcQueue<qvalue_t> queue(writers_n + readers_n);
+    auto values_per_writer = (static_cast<size_t>(n) + writers_n - 1) / writers_n;
+    auto total_values = values_per_writer * writers_n;
+    std::atomic<size_t> popped_count{0};
+    td::vector<td::thread> threads;
+    for (size_t i = 0; i < readers_n; i++) {
+      threads.emplace_back([&, thread_id = i] {
+        td::vector<qvalue_t> values;
+        qvalue_t value;
+        while (popped_count.load(MODE) != total_values) {
+          size_t count = 0;
+          if (bulk_size == 1) {
+            count = queue.try_pop(value, thread_id) ? 1 : 0;
+          } else {
+            count = queue.try_pop_bulk(values, bulk_size, thread_id);
+            values.clear();
+          }
+          if (count == 0) {
+            td::usleep_for(1);
+          } else {
+            popped_count.fetch_add(count, MODE);
+          }
+        }
+      });
+    }
+    for (size_t i = 0; i < writers_n; i++) {
+      threads.emplace_back([&, thread_id = readers_n + i] {
+        td::vector<qvalue_t> values;
+        for (size_t j = 0; j < values_per_writer; j++) {
+          if (bulk_size == 1) {
+            queue.push(static_cast<qvalue_t>(j), thread_id);
+            continue;
+          }
+          values.push_back(static_cast<qvalue_t>(j));
+          if (values.size() == bulk_size || j + 1 == values_per_writer) {
+            queue.push_bulk(values, thread_id);
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+};
+#endif
+
 int main() {
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
   // test_queue();
 #endif
 
+#if !TD_THREAD_UNSUPPORTED
+  td::bench(MpmcQueueBenchmark(1, 1, 1));
+  td::bench(MpmcQueueBenchmark(1, 1, 16));
+  td::bench(MpmcQueueBenchmark(4, 4, 1));
+  td::bench(MpmcQueueBenchmark(4, 4, 16));
+#endif
+
 #if TD_PORT_POSIX
   // td::bench(RingBenchmark<SemQueue>());
   // td::bench(RingBenchmark<td::PollQueue<qvalue_t>>());
@@ -23,6 +23,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Random.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 
 #include <memory>
@@ -107,7 +108,207 @@ class MessageDbBench final : public td::Benchmark {
   }
 };
 
+class MessageDbSyncBench final : public td::Benchmark {
+ public:
+  explicit MessageDbSyncBench(bool use_batch) : use_batch_(use_batch) {
+  }
+  td::string get_description() const final {
+    return PSTRING() << "MessageDbSync" << (use_batch_ ? "Batch" : "");
+  }
+  void start_up() final {
+    td::string sql_db_name = "testdb_sync.sqlite";
+    sql_connection_ = std::make_shared<td::SqliteConnectionSafe>(sql_db_name, td::DbKey::empty());
+    auto &db = sql_connection_->get();
+    init_db(db).ensure();
+    db.exec("BEGIN TRANSACTION").ensure();
+    // version == 0 ==> db will be destroyed
+    init_message_db(db, 0).ensure();
+    db.exec("COMMIT TRANSACTION").ensure();
+    message_db_sync_safe_ = td::create_message_db_sync(sql_connection_);
+  }
+  void run(int n) final {
+    auto &message_db = message_db_sync_safe_->get();
+    for (int i = 0; i < n; i += 100) {
+      td::vector<td::MessageDbNewMessage> messages;
+      auto dialog_id = td::DialogId(td::UserId(static_cast<td::int64>(td::Random::fast(1, 100))));
+      auto message_id_raw = td::Random::fast(1, 100000);
+      for (int j = 0; j < 100; j++) {
+        td::MessageDbNewMessage message;
+        message.message_full_id = {dialog_id, td::MessageId{td::ServerMessageId{message_id_raw + j}}};
+        message.unique_message_id = td::ServerMessageId{i + j + 1};
+        message.sender_dialog_id = td::DialogId(td::UserId(static_cast<td::int64>(td::Random::fast(1, 1000))));
+        message.random_id = i + j + 1;
+        message.data = td::BufferSlice(td::Random::fast(100, 299));
+        messages.push_back(std::move(message));
+      }
+
+      message_db.begin_write_transaction().ensure();
+      if (use_batch_) {
+        message_db.add_messages(std::move(messages));
+      } else {
+        for (auto &message : messages) {
+          message_db.add_message(message.message_full_id, message.unique_message_id, message.sender_dialog_id,
+                                 message.random_id, message.ttl_expires_at, message.index_mask, message.search_id,
+                                 std::move(message.text), message.notification_id, message.top_thread_message_id,
+                                 std::move(message.data));
+        }
+      }
+      message_db.commit_transaction().ensure();
+    }
+  }
+  void tear_down() final {
+    message_db_sync_safe_.reset();
+    sql_connection_->close_and_destroy();
+    sql_connection_.reset();
+  }
+
+ private:
+  bool use_batch_;
+  std::shared_ptr<td::SqliteConnectionSafe> sql_connection_;
+  std::shared_ptr<td::MessageDbSyncSafeInterface> message_db_sync_safe_;
+};
+
+class MessageDbFtsBench final : public td::Benchmark {
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "MessageDbFts" << MESSAGE_COUNT;
+  }
+  void start_up() final {
+    td::string sql_db_name = "testdb_fts.sqlite";
+    sql_connection_ = std::make_shared<td::SqliteConnectionSafe>(sql_db_name, td::DbKey::empty());
+    auto &db = sql_connection_->get();
+    init_db(db).ensure();
+    db.exec("BEGIN TRANSACTION").ensure();
+    // version == 0 ==> db will be destroyed
+    init_message_db(db, 0).ensure();
+    db.exec("COMMIT TRANSACTION").ensure();
+    message_db_sync_safe_ = td::create_message_db_sync(sql_connection_);
+
+    // word frequencies are skewed to have both common and rare words
+    auto &message_db = message_db_sync_safe_->get();
+    for (int i = 0; i < MESSAGE_COUNT; i += 1000) {
+      td::vector<td::MessageDbNewMessage> messages;
+      for (int j = i; j < i + 1000; j++) {
+        td::MessageDbNewMessage message;
+        message.message_full_id = {td::DialogId(td::UserId(static_cast<td::int64>(j % 100 + 1))),
+                                   td::MessageId{td::ServerMessageId{j + 1}}};
+        message.search_id = j + 1;
+        for (int k = 0; k < 10; k++) {
+          message.text += PSTRING() << " word" << td::Random::fast(0, td::Random::fast(0, WORD_COUNT - 1));
+        }
+        message.data = td::BufferSlice(td::Random::fast(100, 299));
+        messages.push_back(std::move(message));
+      }
+      message_db.begin_write_transaction().ensure();
+      message_db.add_messages(std::move(messages));
+      message_db.commit_transaction().ensure();
+    }
+  }
+  void run(int n) final {
+    auto &message_db = message_db_sync_safe_->get();
+    for (int i = 0; i < n; i++) {
+      td::MessageDbFtsQuery query;
+      query.query = PSTRING() << "word" << td::Random::fast(0, 9);
+      if (i % 2 == 0) {
+        query.dialog_id = td::DialogId(td::UserId(static_cast<td::int64>(td::Random::fast(1, 100))));
+      }
+      query.limit = 50;
+      for (int page = 0; page < 5; page++) {
+        auto result = message_db.get_messages_fts(query);
+        if (result.next_search_id <= 1) {
+          break;
+        }
+        query.from_search_id = result.next_search_id;
+      }
+    }
+  }
+  void tear_down() final {
+    message_db_sync_safe_.reset();
+    sql_connection_->close_and_destroy();
+    sql_connection_.reset();
+  }
+
+ private:
+  static constexpr int MESSAGE_COUNT = 100000;
+  static constexpr int WORD_COUNT = 10000;
+
+  std::shared_ptr<td::SqliteConnectionSafe> sql_connection_;
+  std::shared_ptr<td::MessageDbSyncSafeInterface> message_db_sync_safe_;
+};
+
+constexpr int MessageDbFtsBench::MESSAGE_COUNT;
+
+class MessageDbCompressionBench final : public td::Benchmark {
+ public:
+  explicit MessageDbCompressionBench(bool use_compression) : use_compression_(use_compression) {
+  }
+  td::string get_description() const final {
+    return PSTRING() << "MessageDbRead" << (use_compression_ ? "Compressed" : "");
+  }
+  void start_up() final {
+    td::string sql_db_name = "testdb_compression.sqlite";
+    sql_connection_ = std::make_shared<td::SqliteConnectionSafe>(sql_db_name, td::DbKey::empty());
+    auto &db = sql_connection_->get();
+    init_db(db).ensure();
+    db.exec("BEGIN TRANSACTION").ensure();
+    // version == 0 ==> db will be destroyed
+    init_message_db(db, 0).ensure();
+    db.exec("COMMIT TRANSACTION").ensure();
+    message_db_sync_safe_ = td::create_message_db_sync(sql_connection_);
+
+    // serialized messages share most of their structure, so the data consists of common parts and random fields
+    auto &message_db = message_db_sync_safe_->get();
+    message_db.set_data_compression(use_compression_);
+    for (int i = 0; i < MESSAGE_COUNT; i += 1000) {
+      td::vector<td::MessageDbNewMessage> messages;
+      for (int j = i; j < i + 1000; j++) {
+        td::string data;
+        for (int k = 0; k < 8; k++) {
+          data += PSTRING() << "field" << k << td::Random::fast(0, 1 << k);
+          data += td::string(td::Random::fast(4, 16), static_cast<char>(k));
+        }
+        td::MessageDbNewMessage message;
+        message.message_full_id = {td::DialogId(td::UserId(static_cast<td::int64>(j % 100 + 1))),
+                                   td::MessageId{td::ServerMessageId{j + 1}}};
+        message.data = td::BufferSlice(data);
+        messages.push_back(std::move(message));
+      }
+      message_db.begin_write_transaction().ensure();
+      message_db.add_messages(std::move(messages));
+      message_db.commit_transaction().ensure();
+    }
+    LOG(WARNING) << get_description() << ": database size is " << message_db.get_database_size();
+  }
+  void run(int n) final {
+    auto &message_db = message_db_sync_safe_->get();
+    for (int i = 0; i < n; i++) {
+      auto j = td::Random::fast(0, MESSAGE_COUNT - 1);
+      message_db
+          .get_message({td::DialogId(td::UserId(static_cast<td::int64>(j % 100 + 1))),
+                        td::MessageId{td::ServerMessageId{j + 1}}})
+          .ensure();
+    }
+  }
+  void tear_down() final {
+    message_db_sync_safe_.reset();
+    sql_connection_->close_and_destroy();
+    sql_connection_.reset();
+  }
+
+ private:
+  static constexpr int MESSAGE_COUNT = 100000;
+
+  bool use_compression_;
+  std::shared_ptr<td::SqliteConnectionSafe> sql_connection_;
+  std::shared_ptr<td::MessageDbSyncSafeInterface> message_db_sync_safe_;
+};
+
 int main() {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
   td::bench(MessageDbBench());
+  td::bench(MessageDbSyncBench(false));
+  td::bench(MessageDbSyncBench(true));
+  td::bench(MessageDbFtsBench());
+  td::bench(MessageDbCompressionBench(false));
+  td::bench(MessageDbCompressionBench(true));
 }
@@ -0,0 +1,117 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/mtproto/ProxySecret.h"
+#include "td/mtproto/TcpTransport.h"
+#include "td/mtproto/TlsReaderByteFlow.h"
+
+#include "td/utils/benchmark.h"
+#include "td/utils/buffer.h"
+#include "td/utils/ByteFlow.h"
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+
+static td::mtproto::ProxySecret get_tls_secret() {
+  return td::mtproto::ProxySecret::from_binary(
+             "\xee"
+             "0123456789secret"
+             "www.google.com")
+      .move_as_ok();
+}
+
+class TlsWriteBench final : public td::Benchmark {
+ public:
+  explicit TlsWriteBench(size_t message_size) : message_size_(message_size) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "TlsWrite " << message_size_;
+  }
+
+  void run(int n) final {
+    td::ChainBufferWriter input_writer;
+    auto input = input_writer.extract_reader();
+    td::ChainBufferWriter output_writer;
+    auto output = output_writer.extract_reader();
+    td::mtproto::tcp::ObfuscatedTransport transport(2, get_tls_secret());
+    transport.init(&input, &output_writer);
+
+    size_t total_size = 0;
+    for (int i = 0; i < n; i++) {
+      td::BufferWriter message(message_size_, transport.max_prepend_size(), transport.max_append_size());
+      transport.write(std::move(message), false);
+      output.sync_with_writer();
+      total_size += output.size();
+      output.advance(output.size());
+    }
+    td::do_not_optimize_away(total_size);
+  }
+
+ private:
+  size_t message_size_;
+};
+
+class TlsReadBench final : public td::Benchmark {
+ public:
+  explicit TlsReadBench(size_t chunk_size) : chunk_size_(chunk_size) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "TlsRead " << chunk_size_;
+  }
+
+  void start_up() final {
+    // records of maximum size, like in a big server response
+    td::string record(2878 + 5, 'a');
+    record[0] = '\x17';
+    record[1] = '\x03';
+    record[2] = '\x03';
+    record[3] = static_cast<char>((2878 >> 8) & 0xff);
+    record[4] = static_cast<char>(2878 & 0xff);
+    data_.clear();
+    while (data_.size() < (1 << 20)) {
+      data_ += record;
+    }
+  }
+
+  void run(int n) final {
+    td::ChainBufferWriter input_writer;
+    auto input = input_writer.extract_reader();
+    td::ByteFlowSource source(&input);
+    td::mtproto::TlsReaderByteFlow tls_reader;
+    td::ByteFlowSink sink;
+    source >> tls_reader >> sink;
+
+    size_t total_size = 0;
+    for (int i = 0; i < n; i++) {
+      td::Slice data = data_;
+      while (!data.empty()) {
+        auto chunk = data.substr(0, chunk_size_);
+        data.remove_prefix(chunk.size());
+        input_writer.append(chunk);
+        source.wakeup();
+        auto output = sink.get_output();
+        total_size += output->size();
+        output->advance(output->size());
+      }
+    }
+    td::do_not_optimize_away(total_size);
+  }
+
+ private:
+  size_t chunk_size_;
+  td::string data_;
+};
+
+int main() {
+  td::bench(TlsWriteBench(100));
+  td::bench(TlsWriteBench(16 << 10));
+  td::bench(TlsWriteBench(512 << 10));
+  td::bench(TlsReadBench(1 << 10));
+  td::bench(TlsReadBench(16 << 10));
+  td::bench(TlsReadBench(256 << 10));
+}
@@ -0,0 +1,95 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/benchmark.h"
+#include "td/utils/buffer.h"
+#include "td/utils/BufferedUdp.h"
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/IPAddress.h"
+#include "td/utils/port/PollFlags.h"
+#include "td/utils/port/UdpSocketFd.h"
+#include "td/utils/SliceBuilder.h"
+
+class UdpBench final : public td::Benchmark {
+ public:
+  UdpBench(size_t batch_size, bool use_send_offload)
+      : batch_size_(batch_size), use_send_offload_(use_send_offload) {
+  }
+
+  std::string get_description() const final {
+    return PSTRING() << "UDP loopback, batch size = " << batch_size_ << (use_send_offload_ ? ", send offload" : "");
+  }
+
+  void start_up() final {
+    address_.init_ipv4_port("127.0.0.1", RECEIVER_PORT).ensure();
+    td::IPAddress sender_address;
+    sender_address.init_ipv4_port("127.0.0.1", SENDER_PORT).ensure();
+
+    receiver_ = td::make_unique<td::BufferedUdp>(td::UdpSocketFd::open(address_).move_as_ok());
+    receiver_->maximize_rcv_buffer().ensure();
+    receiver_->set_batch_size(batch_size_);
+
+    sender_ = td::make_unique<td::BufferedUdp>(td::UdpSocketFd::open(sender_address).move_as_ok());
+    sender_->maximize_snd_buffer().ensure();
+    sender_->set_batch_size(batch_size_);
+    if (use_send_offload_) {
+      auto status = sender_->enable_send_offload();
+      if (status.is_error()) {
+        LOG(ERROR) << status;
+      }
+    }
+  }
+
+  void run(int n) final {
+    size_t received_count = 0;
+    for (int i = 0; i < n; i += CHUNK_SIZE) {
+      for (int j = 0; j < CHUNK_SIZE; j++) {
+        sender_->send(td::UdpMessage{address_, td::BufferSlice(DATAGRAM_SIZE), td::Status::OK()});
+      }
+      sender_->get_poll_info().add_flags(td::PollFlags::Write());
+      sender_->flush_send().ensure();
+
+      receiver_->get_poll_info().add_flags(td::PollFlags::Read());
+      while (true) {
+        auto r_message = receiver_->receive();
+        LOG_IF(FATAL, r_message.is_error()) << r_message.error();
+        if (!r_message.ok()) {
+          break;
+        }
+        received_count++;
+      }
+    }
+    if (received_count < static_cast<size_t>(n) * 9 / 10) {
+      LOG(ERROR) << "Received only " << received_count << " out of " << n << " datagrams";
+    }
+  }
+
+  void tear_down() final {
+    receiver_ = nullptr;
+    sender_ = nullptr;
+  }
+
+ private:
+  static constexpr int RECEIVER_PORT = 31457;
+  static constexpr int SENDER_PORT = 31458;
+  static constexpr int CHUNK_SIZE = 256;
+  static constexpr size_t DATAGRAM_SIZE = 1200;
+
+  size_t batch_size_;
+  bool use_send_offload_;
+  td::IPAddress address_;
+  td::unique_ptr<td::BufferedUdp> receiver_;
+  td::unique_ptr<td::BufferedUdp> sender_;
+};
+
+int main() {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
+  for (size_t batch_size : {1, 16, 64}) {
+    td::bench(UdpBench(batch_size, false));
+    td::bench(UdpBench(batch_size, true));
+  }
+}
@@ -0,0 +1,320 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/td_api.h"
+#include "td/telegram/td_api_json.h"
+#include "td/telegram/telegram_api.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/format.h"
+#include "td/utils/JsonBuilder.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/Clocks.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/Random.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
+
+#include <algorithm>
+
+// Replays a stream of telegram_api::Updates through the path from the received bytes to the JSON strings,
+// which are returned to a client: the updates are parsed, converted to td_api updates and serialized.
+// The stream is either synthetic or read from a file, which consists of records of the form
+// <little-endian int32 size><serialized telegram_api::Updates>.
+
+namespace {
+
+struct UpdateStream {
+  td::BufferSlice data;
+  td::vector<td::BufferSlice> records;
+  size_t expected_message_count = 0;
+  size_t expected_user_status_count = 0;
+};
+
+void store_record(td::string &data, td::Slice record) {
+  auto size = static_cast<td::uint32>(record.size());
+  for (int i = 0; i < 4; i++) {
+    data += static_cast<char>((size >> (8 * i)) & 0xFF);
+  }
+  data.append(record.begin(), record.size());
+}
+
+td::string generate_updates(size_t update_count) {
+  static const td::Slice TEXTS[] = {
+      "ok", "See you tomorrow!",
+      "The quick brown fox jumps over the lazy dog.\nСъешь же ещё этих мягких французских булок \"🦊\""};
+
+  td::string data;
+  td::Random::Xorshift128plus rnd(123);
+  td::int32 pts = 1;
+  for (size_t i = 0; i < update_count; i++) {
+    td::string text;
+    auto repeat_count = rnd.fast(1, 4);
+    for (int j = 0; j < repeat_count; j++) {
+      text += TEXTS[rnd.fast(0, 2)].str();
+    }
+
+    alignas(4) unsigned char buf[1024];
+    td::TlStorerUnsafe storer(buf);
+    auto message_id = static_cast<td::int32>(i + 1);
+    auto date = static_cast<td::int32>(1700000000 + i);
+    switch (rnd.fast(0, 3)) {
+      case 0:
+      case 1:
+        storer.store_int(td::telegram_api::updateShortMessage::ID);
+        storer.store_int(0);
+        storer.store_int(message_id);
+        storer.store_long(123456000 + rnd.fast(0, 100));
+        storer.store_string(td::Slice(text));
+        storer.store_int(pts++);
+        storer.store_int(1);
+        storer.store_int(date);
+        break;
+      case 2:
+        storer.store_int(td::telegram_api::updateShortChatMessage::ID);
+        storer.store_int(0);
+        storer.store_int(message_id);
+        storer.store_long(123456000 + rnd.fast(0, 100));
+        storer.store_long(4000000 + rnd.fast(0, 10));
+        storer.store_string(td::Slice(text));
+        storer.store_int(pts++);
+        storer.store_int(1);
+        storer.store_int(date);
+        break;
+      case 3:
+        storer.store_int(td::telegram_api::updateShort::ID);
+        storer.store_int(td::telegram_api::updateUserStatus::ID);
+        storer.store_long(123456000 + rnd.fast(0, 100));
+        if (rnd.fast(0, 1) == 0) {
+          storer.store_int(td::telegram_api::userStatusOnline::ID);
+          storer.store_int(date + 300);
+        } else {
+          storer.store_int(td::telegram_api::userStatusOffline::ID);
+          storer.store_int(date - 60);
+        }
+        storer.store_int(date);
+        break;
+    }
+    store_record(data, td::Slice(buf, storer.get_buf()));
+  }
+  return data;
+}
+
+td::Result<UpdateStream> parse_update_stream(td::BufferSlice data) {
+  UpdateStream result;
+  td::Slice left = data.as_slice();
+  while (!left.empty()) {
+    if (left.size() < 4) {
+      return td::Status::Error("Truncated record size");
+    }
+    td::uint32 size = 0;
+    for (int i = 0; i < 4; i++) {
+      size |= static_cast<td::uint32>(static_cast<unsigned char>(left[i])) << (8 * i);
+    }
+    left.remove_prefix(4);
+    if (size > left.size() || size % 4 != 0) {
+      return td::Status::Error(PSLICE() << "Invalid record size " << size);
+    }
+    auto record = left.substr(0, size);
+    left.remove_prefix(size);
+
+    td::TlParser parser(record);
+    switch (parser.fetch_int()) {
+      case td::telegram_api::updateShortMessage::ID:
+      case td::telegram_api::updateShortChatMessage::ID:
+        result.expected_message_count++;
+        break;
+      case td::telegram_api::updateShort::ID:
+        if (parser.fetch_int() == td::telegram_api::updateUserStatus::ID) {
+          result.expected_user_status_count++;
+        }
+        break;
+      default:
+        break;
+    }
+    result.records.push_back(data.from_slice(record));
+  }
+  result.data = std::move(data);
+  return std::move(result);
+}
+
+td::td_api::object_ptr<td::td_api::updateNewMessage> get_update_new_message(td::int64 chat_id, td::int64 sender_user_id,
+                                                                            td::int32 message_id, td::int32 date,
+                                                                            bool is_outgoing, td::string &&text) {
+  auto message = td::td_api::make_object<td::td_api::message>();
+  message->id_ = static_cast<td::int64>(message_id) << 20;
+  message->sender_id_ = td::td_api::make_object<td::td_api::messageSenderUser>(sender_user_id);
+  message->chat_id_ = chat_id;
+  message->is_outgoing_ = is_outgoing;
+  message->date_ = date;
+  auto formatted_text = td::td_api::make_object<td::td_api::formattedText>();
+  formatted_text->text_ = std::move(text);
+  message->content_ = td::td_api::make_object<td::td_api::messageText>(std::move(formatted_text), nullptr, nullptr);
+  return td::td_api::make_object<td::td_api::updateNewMessage>(std::move(message));
+}
+
+td::td_api::object_ptr<td::td_api::UserStatus> get_user_status_object(
+    td::tl_object_ptr<td::telegram_api::UserStatus> &&status) {
+  switch (status->get_id()) {
+    case td::telegram_api::userStatusOnline::ID:
+      return td::td_api::make_object<td::td_api::userStatusOnline>(
+          static_cast<const td::telegram_api::userStatusOnline *>(status.get())->expires_);
+    case td::telegram_api::userStatusOffline::ID:
+      return td::td_api::make_object<td::td_api::userStatusOffline>(
+          static_cast<const td::telegram_api::userStatusOffline *>(status.get())->was_online_);
+    default:
+      return td::td_api::make_object<td::td_api::userStatusEmpty>();
+  }
+}
+
+// converts the updates to td_api updates in the same way as the corresponding managers do it without any state
+void get_td_api_updates(td::tl_object_ptr<td::telegram_api::Updates> &&updates_ptr,
+                        td::vector<td::td_api::object_ptr<td::td_api::Update>> &result) {
+  switch (updates_ptr->get_id()) {
+    case td::telegram_api::updateShortMessage::ID: {
+      auto updates = td::move_tl_object_as<td::telegram_api::updateShortMessage>(updates_ptr);
+      result.push_back(get_update_new_message(updates->user_id_, updates->out_ ? 0 : updates->user_id_, updates->id_,
+                                              updates->date_, updates->out_, std::move(updates->message_)));
+      break;
+    }
+    case td::telegram_api::updateShortChatMessage::ID: {
+      auto updates = td::move_tl_object_as<td::telegram_api::updateShortChatMessage>(updates_ptr);
+      result.push_back(get_update_new_message(-updates->chat_id_, updates->from_id_, updates->id_, updates->date_,
+                                              updates->out_, std::move(updates->message_)));
+      break;
+    }
+    case td::telegram_api::updateShort::ID: {
+      auto updates = td::move_tl_object_as<td::telegram_api::updateShort>(updates_ptr);
+      if (updates->update_->get_id() == td::telegram_api::updateUserStatus::ID) {
+        auto update = td::move_tl_object_as<td::telegram_api::updateUserStatus>(updates->update_);
+        result.push_back(td::td_api::make_object<td::td_api::updateUserStatus>(
+            update->user_id_, get_user_status_object(std::move(update->status_))));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+td::uint64 get_resident_size() {
+  auto r_mem_stat = td::mem_stat();
+  if (r_mem_stat.is_error()) {
+    return 0;
+  }
+  return r_mem_stat.ok().resident_size_;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
+
+  size_t update_count = 1000000;
+  td::string input_path;
+  td::string output_path;
+  for (int i = 1; i < argc; i++) {
+    td::Slice arg(argv[i]);
+    if (arg == "--count" && i + 1 < argc) {
+      update_count = td::to_integer<size_t>(td::Slice(argv[++i]));
+    } else if (arg == "--save" && i + 1 < argc) {
+      output_path = argv[++i];
+    } else if (arg[0] != '-' && input_path.empty()) {
+      input_path = arg.str();
+    } else {
+      LOG(PLAIN) << "Usage: bench_updates [--count <synthetic update count>] [--save <path>] [<recorded updates>]";
+      return 1;
+    }
+  }
+
+  td::BufferSlice data;
+  if (input_path.empty()) {
+    auto synthetic_data = generate_updates(update_count);
+    if (!output_path.empty()) {
+      td::write_file(output_path, synthetic_data).ensure();
+    }
+    data = td::BufferSlice(synthetic_data);
+  } else {
+    auto r_data = td::read_file(input_path);
+    LOG_IF(FATAL, r_data.is_error()) << "Can't read " << input_path << ": " << r_data.error();
+    data = r_data.move_as_ok();
+  }
+  auto r_stream = parse_update_stream(std::move(data));
+  LOG_IF(FATAL, r_stream.is_error()) << "Invalid update stream: " << r_stream.error();
+  auto stream = r_stream.move_as_ok();
+
+  auto start_resident_size = get_resident_size();
+  td::vector<double> latencies;
+  latencies.reserve(stream.records.size());
+  td::vector<td::td_api::object_ptr<td::td_api::Update>> td_api_updates;
+  size_t message_count = 0;
+  size_t user_status_count = 0;
+  size_t json_size = 0;
+  size_t failed_count = 0;
+
+  auto start_time = td::Clocks::monotonic();
+  for (auto &record : stream.records) {
+    auto update_start_time = td::Clocks::monotonic();
+    td::TlBufferParser parser(&record);
+    auto updates = td::telegram_api::Updates::fetch(parser);
+    parser.fetch_end();
+    if (parser.get_error() != nullptr) {
+      failed_count++;
+      continue;
+    }
+
+    get_td_api_updates(std::move(updates), td_api_updates);
+    for (auto &update : td_api_updates) {
+      auto json = td::json_encode<td::string>(td::ToJson(*update));
+      switch (update->get_id()) {
+        case td::td_api::updateNewMessage::ID:
+          CHECK(td::begins_with(json, "{\"@type\":\"updateNewMessage\""));
+          message_count++;
+          break;
+        case td::td_api::updateUserStatus::ID:
+          CHECK(td::begins_with(json, "{\"@type\":\"updateUserStatus\""));
+          user_status_count++;
+          break;
+        default:
+          UNREACHABLE();
+      }
+      json_size += json.size();
+    }
+    td_api_updates.clear();
+    latencies.push_back(td::Clocks::monotonic() - update_start_time);
+  }
+  auto total_time = td::Clocks::monotonic() - start_time;
+  auto end_resident_size = get_resident_size();
+
+  if (failed_count != 0) {
+    LOG(ERROR) << "Failed to parse " << failed_count << " out of " << stream.records.size() << " records";
+  }
+  LOG_IF(FATAL, message_count != stream.expected_message_count)
+      << "Received " << message_count << " updateNewMessage instead of " << stream.expected_message_count;
+  LOG_IF(FATAL, user_status_count != stream.expected_user_status_count)
+      << "Received " << user_status_count << " updateUserStatus instead of " << stream.expected_user_status_count;
+
+  std::sort(latencies.begin(), latencies.end());
+  auto get_percentile = [&](size_t percent) {
+    return latencies.empty() ? 0.0 : latencies[(latencies.size() - 1) * percent / 100];
+  };
+  LOG(PLAIN) << "Replayed " << stream.records.size() << " updates to " << message_count << " new messages and "
+             << user_status_count << " user statuses with " << td::format::as_size(json_size) << " of JSON";
+  auto updates_per_second = static_cast<td::uint64>(static_cast<double>(stream.records.size()) / total_time);
+  LOG(PLAIN) << td::format::as_time(total_time) << ", " << updates_per_second << " updates/s, median latency "
+             << td::format::as_time(get_percentile(50)) << ", p99 latency " << td::format::as_time(get_percentile(99))
+             << ", max latency " << td::format::as_time(get_percentile(100));
+  LOG(PLAIN) << "Resident size " << td::format::as_size(end_resident_size) << " (+"
+             << td::format::as_size(end_resident_size > start_resident_size ? end_resident_size - start_resident_size
+                                                                            : 0)
+             << " during replay)";
+  return 0;
+}
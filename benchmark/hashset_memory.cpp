@@ -170,11 +170,12 @@ void print_memory_stats(td::Slice name) {
 template <class KeyT, class ValueT, class HashT = td::Hash<KeyT>, class EqT = std::equal_to<KeyT>>
 using FlatHashMapImpl = td::FlatHashTable<td::MapNode<KeyT, ValueT>, HashT, EqT>;
 
-#define FOR_EACH_TABLE(F) \
-  F(FlatHashMapImpl)      \
-  F(folly::F14FastMap)    \
-  F(absl::flat_hash_map)  \
-  F(std::unordered_map)   \
+#define FOR_EACH_TABLE(F)  \
+  F(FlatHashMapImpl)       \
+  F(td::FlatHashMapChunks) \
+  F(folly::F14FastMap)     \
+  F(absl::flat_hash_map)   \
+  F(std::unordered_map)    \
   F(std::map)
 #define BENCHMARK_MEMORY(T) print_memory_stats<T>(#T);
 
@@ -8,7 +8,70 @@
 
 #include "td/utils/port/platform.h"
 
-#if (TD_DARWIN || TD_LINUX) && defined(USE_MEMPROF)
+#if (TD_DARWIN || TD_LINUX) && defined(USE_MEMPROF) && defined(USE_MEMPROF_SAMPLED)
+#include "td/utils/HeapProfiler.h"
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <dlfcn.h>
+
+// allocations are only reported to td::HeapProfiler, which samples them if enabled at runtime
+
+bool is_memprof_on() {
+  return false;
+}
+void dump_alloc(const std::function<void(const AllocInfo &)> &func) {
+}
+double get_fast_backtrace_success_rate() {
+  return 0;
+}
+std::size_t get_ht_size() {
+  return 0;
+}
+
+extern "C" {
+
+#if TD_DARWIN
+#define MEMPROF_GET_OLD_FUNCTION(name)                   \
+  static void *name##_void = dlsym(RTLD_NEXT, #name);    \
+  static auto name##_old = *reinterpret_cast<decltype(name) **>(&name##_void)
+#else
+#define MEMPROF_GET_OLD_FUNCTION(name)   \
+  extern decltype(name) __libc_##name; \
+  static auto name##_old = __libc_##name
+#endif
+
+void *malloc(std::size_t size) {
+  MEMPROF_GET_OLD_FUNCTION(malloc);
+  void *result = malloc_old(size);
+  td::HeapProfiler::on_allocation(result, size);
+  return result;
+}
+
+void free(void *data_void) {
+  MEMPROF_GET_OLD_FUNCTION(free);
+  td::HeapProfiler::on_deallocation(data_void);
+  free_old(data_void);
+}
+
+void *calloc(std::size_t size_a, std::size_t size_b) {
+  MEMPROF_GET_OLD_FUNCTION(calloc);
+  void *result = calloc_old(size_a, size_b);
+  td::HeapProfiler::on_allocation(result, size_a * size_b);
+  return result;
+}
+
+void *realloc(void *ptr, std::size_t size) {
+  MEMPROF_GET_OLD_FUNCTION(realloc);
+  td::HeapProfiler::on_deallocation(ptr);
+  void *result = realloc_old(ptr, size);
+  td::HeapProfiler::on_allocation(result, size);
+  return result;
+}
+}
+
+#elif (TD_DARWIN || TD_LINUX) && defined(USE_MEMPROF)
 #include <algorithm>
 #include <atomic>
 #include <cstddef>
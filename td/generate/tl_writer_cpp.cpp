@@ -196,10 +196,16 @@ std::string TD_TL_writer_cpp::gen_full_fetch_class_name(const tl::tl_tree_type *
       }
     }
   }
+  std::string result;
   if (expected_constructor_id == 0) {
-    return gen_fetch_class_name(tree_type);
+    result = gen_fetch_class_name(tree_type);
+  } else {
+    result = "TlFetchBoxed<" + gen_fetch_class_name(tree_type) + ", " + int_to_string(expected_constructor_id) + ">";
+  }
+  if (is_optional_object_type(t)) {
+    return "TlFetchOptional<" + result + ">";
   }
-  return "TlFetchBoxed<" + gen_fetch_class_name(tree_type) + ", " + int_to_string(expected_constructor_id) + ">";
+  return result;
 }
 
 std::string TD_TL_writer_cpp::gen_type_fetch(const std::string &field_name, const tl::tl_tree_type *tree_type,
@@ -207,8 +213,74 @@ std::string TD_TL_writer_cpp::gen_type_fetch(const std::string &field_name, cons
   return gen_full_fetch_class_name(tree_type) + "::parse(p)";
 }
 
+int TD_TL_writer_cpp::get_fixed_field_size(const tl::arg &a) const {
+  if (a.type->get_type() != tl::NODE_TYPE_TYPE || a.exist_var_num != -1 || (a.flags & tl::FLAG_EXCL)) {
+    return 0;
+  }
+  auto fetch_class_name = gen_full_fetch_class_name(static_cast<const tl::tl_tree_type *>(a.type));
+  if (fetch_class_name == "TlFetchInt") {
+    return 4;
+  }
+  if (fetch_class_name == "TlFetchLong" || fetch_class_name == "TlFetchDouble") {
+    return 8;
+  }
+  if (fetch_class_name == "TlFetchInt128") {
+    return 16;
+  }
+  if (fetch_class_name == "TlFetchInt256") {
+    return 32;
+  }
+  return 0;
+}
+
+std::string TD_TL_writer_cpp::gen_fields_fetch(const tl::tl_combinator *t, std::vector<tl::var_description> &vars,
+                                               bool flat, int parser_type, int &field_num) const {
+  // length of consecutive fixed-size fields is checked once and the fields are fetched without checks
+  // after a failed check the parser reads from TlParser::empty_data, so the total length must not exceed its size
+  const int MAX_CHECKED_LENGTH = 32;
+
+  std::string result;
+  std::size_t i = 0;
+  while (i < t->args.size()) {
+    std::size_t end = i;
+    int checked_length = 0;
+    while (end < t->args.size()) {
+      int size = get_fixed_field_size(t->args[end]);
+      if (size == 0 || checked_length + size > MAX_CHECKED_LENGTH) {
+        break;
+      }
+      checked_length += size;
+      end++;
+    }
+    if (end < i + 2) {
+      end = i + 1;
+      checked_length = -1;
+    }
+    for (; i < end; i++) {
+      std::string field_fetch = gen_field_fetch_impl(field_num, t->args[i], vars, flat, parser_type, checked_length);
+      if (!field_fetch.empty()) {
+        result += field_fetch;
+        field_num++;
+      }
+      if (checked_length > 0) {
+        checked_length = 0;
+      }
+    }
+  }
+  return result;
+}
+
 std::string TD_TL_writer_cpp::gen_field_fetch(int field_num, const tl::arg &a, std::vector<tl::var_description> &vars,
                                               bool flat, int parser_type) const {
+  return gen_field_fetch_impl(field_num, a, vars, flat, parser_type, -1);
+}
+
+// checked_length == -1 means that the field is fetched with a length check
+// checked_length == 0 means that the length of the field has already been checked
+// checked_length > 0 means that the specified length is checked before the field is fetched without a check
+std::string TD_TL_writer_cpp::gen_field_fetch_impl(int field_num, const tl::arg &a,
+                                                   std::vector<tl::var_description> &vars, bool flat, int parser_type,
+                                                   int checked_length) const {
   assert(parser_type >= 0);
   std::string field_name = (parser_type == 0 ? (field_num == 0 ? ": " : ", ") : "res->") + gen_field_name(a.name);
 
@@ -248,6 +320,9 @@ std::string TD_TL_writer_cpp::gen_field_fetch(int field_num, const tl::arg &a, s
   }
 
   std::string res = "  ";
+  if (checked_length > 0 && parser_type != 0) {
+    res += "p.check_len(" + int_to_string(checked_length) + ");\n  ";
+  }
   if (a.exist_var_num != -1) {
     res += "if (" + gen_var_name(vars[a.exist_var_num]) + " & " + int_to_string(1 << a.exist_var_bit) + ") { ";
   }
@@ -275,7 +350,16 @@ std::string TD_TL_writer_cpp::gen_field_fetch(int field_num, const tl::arg &a, s
 
   assert(a.type->get_type() == tl::NODE_TYPE_TYPE);
   const tl::tl_tree_type *tree_type = static_cast<tl::tl_tree_type *>(a.type);
-  res += gen_type_fetch(field_name, tree_type, vars, parser_type);
+  if (checked_length < 0) {
+    res += gen_type_fetch(field_name, tree_type, vars, parser_type);
+  } else {
+    assert(a.exist_var_num == -1);
+    std::string type_fetch = gen_full_fetch_class_name(tree_type) + "::parse_unsafe(p)";
+    if (checked_length > 0 && parser_type == 0) {
+      type_fetch = "(p.check_len(" + int_to_string(checked_length) + "), " + type_fetch + ")";
+    }
+    res += type_fetch;
+  }
   if (store_to_var_num) {
     res += ") < 0) { FAIL(\"Variable of type # can't be negative\"); }";
   } else {
@@ -372,6 +456,14 @@ std::string TD_TL_writer_cpp::gen_store_class_name(const tl::tl_tree_type *tree_
 
 std::string TD_TL_writer_cpp::gen_full_store_class_name(const tl::tl_tree_type *tree_type) const {
   const tl::tl_type *t = tree_type->type;
+  if (is_optional_object_type(t)) {
+    return "TlStoreOptional<" + gen_full_store_class_name_impl(tree_type) + ">";
+  }
+  return gen_full_store_class_name_impl(tree_type);
+}
+
+std::string TD_TL_writer_cpp::gen_full_store_class_name_impl(const tl::tl_tree_type *tree_type) const {
+  const tl::tl_type *t = tree_type->type;
 
   assert(!(t->flags & tl::FLAG_DEFAULT_CONSTRUCTOR));  // Not supported yet
 
@@ -397,6 +489,12 @@ std::string TD_TL_writer_cpp::gen_full_store_class_name(const tl::tl_tree_type *
   return "";
 }
 
+bool TD_TL_writer_cpp::is_optional_object_type(const tl::tl_type *t) const {
+  // object fields of td_api objects can be empty, so the binary client interface prefixes them with a presence flag
+  return tl_name == "td_api" && t->name != "#" && !is_built_in_simple_type(t->name) &&
+         !is_built_in_complex_type(t->name);
+}
+
 std::string TD_TL_writer_cpp::gen_type_store(const std::string &field_name, const tl::tl_tree_type *tree_type,
                                              const std::vector<tl::var_description> &vars, int storer_type) const {
   if (storer_type == 0) {
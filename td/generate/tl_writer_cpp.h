@@ -25,6 +25,15 @@ class TD_TL_writer_cpp : public TD_TL_writer {
 
   std::string gen_full_store_class_name(const tl::tl_tree_type *tree_type) const;
 
+  std::string gen_full_store_class_name_impl(const tl::tl_tree_type *tree_type) const;
+
+  bool is_optional_object_type(const tl::tl_type *t) const;
+
+  int get_fixed_field_size(const tl::arg &a) const;
+
+  std::string gen_field_fetch_impl(int field_num, const tl::arg &a, std::vector<tl::var_description> &vars, bool flat,
+                                   int parser_type, int checked_length) const;
+
   std::vector<std::string> ext_include;
 
  protected:
@@ -65,6 +74,8 @@ class TD_TL_writer_cpp : public TD_TL_writer {
 
   std::string gen_field_fetch(int field_num, const tl::arg &a, std::vector<tl::var_description> &vars, bool flat,
                               int parser_type) const override;
+  std::string gen_fields_fetch(const tl::tl_combinator *t, std::vector<tl::var_description> &vars, bool flat,
+                               int parser_type, int &field_num) const override;
   std::string gen_field_store(const tl::arg &a, std::vector<tl::var_description> &vars, bool flat,
                               int storer_type) const override;
   std::string gen_type_fetch(const std::string &field_name, const tl::tl_tree_type *tree_type,
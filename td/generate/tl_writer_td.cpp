@@ -104,6 +104,11 @@ std::vector<std::string> TD_TL_writer::get_parsers() const {
   } else if (tl_name == "mtproto_api" || tl_name == "secret_api") {
     parsers.push_back("TlParser");
   }
+#ifndef TD_ENABLE_JNI
+  if (tl_name == "td_api") {
+    parsers.push_back("TlParser");  // for the binary client interface
+  }
+#endif
   return parsers;
 }
 
@@ -113,6 +118,12 @@ std::vector<std::string> TD_TL_writer::get_storers() const {
     storers.push_back("TlStorerCalcLength");
     storers.push_back("TlStorerUnsafe");
   }
+#ifndef TD_ENABLE_JNI
+  if (tl_name == "td_api") {
+    storers.push_back("TlStorerCalcLength");  // for the binary client interface
+    storers.push_back("TlStorerUnsafe");
+  }
+#endif
   storers.push_back("TlStorerToString");
   return storers;
 }
@@ -34,6 +34,9 @@ class Transport final : public IStreamTransport {
   void write(BufferWriter &&message, bool quick_ack) final;
   bool can_read() const final;
   bool can_write() const final;
+  void set_max_pipelined_query_count(size_t max_pipelined_query_count) final {
+    max_pipelined_query_count_ = max(max_pipelined_query_count, static_cast<size_t>(1));
+  }
   void init(ChainBufferReader *input, ChainBufferWriter *output) final {
     reader_.init(input);
     output_ = output;
@@ -51,7 +54,9 @@ class Transport final : public IStreamTransport {
   HttpReader reader_;
   HttpQuery http_query_;
   ChainBufferWriter *output_ = nullptr;
-  enum { Write, Read } turn_ = Write;
+  // requests are pipelined over the same keep-alive connection; responses are received in the order of requests
+  size_t pending_response_count_ = 0;
+  size_t max_pipelined_query_count_ = 1;
 };
 
 }  // namespace http
@@ -27,6 +27,8 @@ class IStreamTransport {
   virtual void write(BufferWriter &&message, bool quick_ack) = 0;
   virtual bool can_read() const = 0;
   virtual bool can_write() const = 0;
+  // maximum number of written messages, which can wait for a response; ignored by transports without responses
+  virtual void set_max_pipelined_query_count(size_t max_pipelined_query_count) = 0;
   virtual void init(ChainBufferReader *input, ChainBufferWriter *output) = 0;
   virtual size_t max_prepend_size() const = 0;
   virtual size_t max_append_size() const = 0;
@@ -55,6 +55,10 @@ class RawConnectionDefault final : public RawConnection {
     return transport_->can_write();
   }
 
+  void set_max_pipelined_query_count(size_t max_pipelined_query_count) final {
+    transport_->set_max_pipelined_query_count(max_pipelined_query_count);
+  }
+
   TransportType get_transport_type() const final {
     return transport_->get_type();
   }
@@ -83,6 +87,7 @@ class RawConnectionDefault final : public RawConnection {
 
     auto packet_size = packet.size();
     transport_->write(std::move(packet), use_quick_ack);
+    packet_count_++;
     return packet_size;
   }
 
@@ -94,6 +99,7 @@ class RawConnectionDefault final : public RawConnection {
 
     LOG(INFO) << "Send handshake packet: " << format::as_hex_dump<4>(packet.as_slice());
     transport_->write(std::move(packet), false);
+    packet_count_++;
   }
 
   PollableFdInfo &get_poll_info() final {
@@ -104,6 +110,13 @@ class RawConnectionDefault final : public RawConnection {
     return stats_callback_.get();
   }
 
+  WriteStatistics get_write_statistics() const final {
+    WriteStatistics result;
+    result.packet_count = packet_count_;
+    result.write_syscall_count = socket_fd_.get_write_syscall_count();
+    return result;
+  }
+
   // NB: After first returned error, all subsequent calls will return error too.
   Status flush(const AuthKey &auth_key, Callback &callback) final {
     auto status = do_flush(auth_key, callback);
@@ -121,7 +134,8 @@ class RawConnectionDefault final : public RawConnection {
   }
 
   void close() final {
-    LOG(DEBUG) << "Close raw connection " << this;
+    LOG(DEBUG) << "Close raw connection " << this << " after sending " << packet_count_ << " packets using "
+               << socket_fd_.get_write_syscall_count() << " write calls";
     transport_.reset();
     socket_fd_.close();
   }
@@ -137,6 +151,7 @@ class RawConnectionDefault final : public RawConnection {
   PublicFields extra_;
   BufferedFd<SocketFd> socket_fd_;
   unique_ptr<IStreamTransport> transport_;
+  uint64 packet_count_ = 0;
   FlatHashMap<uint32, uint64> quick_ack_to_token_;
   bool has_error_{false};
 
@@ -295,6 +310,9 @@ class RawConnectionHttp final : public RawConnection {
     return mode_ == Send;
   }
 
+  void set_max_pipelined_query_count(size_t max_pipelined_query_count) final {
+  }
+
   TransportType get_transport_type() const final {
     return mtproto::TransportType{mtproto::TransportType::Http, 0, mtproto::ProxySecret()};
   }
@@ -331,6 +349,14 @@ class RawConnectionHttp final : public RawConnection {
     return stats_callback_.get();
   }
 
+  WriteStatistics get_write_statistics() const final {
+    // every packet is sent in a separate HTTP request
+    WriteStatistics result;
+    result.packet_count = sent_packet_count_;
+    result.write_syscall_count = sent_packet_count_;
+    return result;
+  }
+
   // NB: After first returned error, all subsequent calls will return error too.
   Status flush(const AuthKey &auth_key, Callback &callback) final {
     auto status = do_flush(auth_key, callback);
@@ -371,6 +397,7 @@ class RawConnectionHttp final : public RawConnection {
   ConnectionManager::ConnectionToken connection_token_;
   std::shared_ptr<MpscPollableQueue<Result<BufferSlice>>> answers_;
   std::vector<BufferSlice> to_send_;
+  uint64 sent_packet_count_ = 0;
 
   void on_read(size_t size, Callback &callback) {
     if (size <= 0) {
@@ -451,6 +478,7 @@ class RawConnectionHttp final : public RawConnection {
   Status flush_write() {
     for (auto &packet : to_send_) {
       TRY_STATUS(do_send(packet.as_slice()));
+      sent_packet_count_++;
       if (packet.size() > 0 && stats_callback_) {
         stats_callback_->on_write(packet.size());
       }
@@ -47,6 +47,7 @@ class RawConnection {
   virtual void set_connection_token(ConnectionManager::ConnectionToken connection_token) = 0;
 
   virtual bool can_send() const = 0;
+  virtual void set_max_pipelined_query_count(size_t max_pipelined_query_count) = 0;
   virtual TransportType get_transport_type() const = 0;
   virtual size_t send_crypto(const Storer &storer, uint64 session_id, int64 salt, const AuthKey &auth_key,
                              uint64 quick_ack_token) = 0;
@@ -55,6 +56,13 @@ class RawConnection {
   virtual PollableFdInfo &get_poll_info() = 0;
   virtual StatsCallback *stats_callback() = 0;
 
+  struct WriteStatistics {
+    uint64 packet_count{0};
+    uint64 write_syscall_count{0};
+  };
+  // returns the number of sent packets and the number of system calls made to write them
+  virtual WriteStatistics get_write_statistics() const = 0;
+
   class Callback {
    public:
     Callback() = default;
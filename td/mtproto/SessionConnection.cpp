@@ -247,6 +247,7 @@ Status SessionConnection::on_packet_rpc_result(const MsgInfo &info, Slice packet
     return Status::Error("Receive an update in rpc_result");
   }
   VLOG(mtproto) << "Receive result for request with " << MessageId(req_msg_id) << ' ' << info;
+  on_query_answered(MessageId(req_msg_id));
 
   if (info.message_id.get() < req_msg_id - (static_cast<uint64>(15) << 32)) {
     reset_server_time_difference(info.message_id);
@@ -351,6 +352,7 @@ Status SessionConnection::on_packet(const MsgInfo &info,
       LOG(WARNING) << bad_info << ": MessageId is too high. Session will be closed";
       // All this queries will be re-sent by parent
       to_send_.clear();
+      to_send_size_ = 0;
       reset_server_time_difference(info.message_id);
       callback_->on_session_failed(Status::Error("MessageId is too high"));
       return Status::Error("MessageId is too high");
@@ -594,6 +596,7 @@ Status SessionConnection::on_main_packet(const PacketInfo &packet_info, Slice pa
 }
 
 void SessionConnection::on_message_failed(MessageId message_id, Status status) {
+  on_query_answered(message_id);
   callback_->on_message_failed(message_id, std::move(status));
 
   sent_destroy_auth_key_ = false;
@@ -763,6 +766,10 @@ SessionConnection::SessionConnection(Mode mode, unique_ptr<RawConnection> raw_co
     , auth_data_(auth_data) {
   CHECK(raw_connection_);
   CHECK(auth_data_ != nullptr);
+  if (mode_ == Mode::Http) {
+    // long poll connection must have at most one pending http_wait, but other queries can be pipelined
+    raw_connection_->set_max_pipelined_query_count(HTTP_MAX_PIPELINED_QUERY_COUNT);
+  }
 }
 
 PollableFdInfo &SessionConnection::get_poll_info() {
@@ -816,11 +823,18 @@ Result<MessageId> SessionConnection::send_query(BufferSlice buffer, bool gzip_fl
     message_id = auth_data_->next_message_id(Time::now_cached());
   }
   auto seq_no = auth_data_->next_seq_no(true);
+  auto query_size = buffer.size();
+  update_query_target(query_size);
   if (to_send_.empty()) {
-    send_before(Time::now_cached() + QUERY_DELAY);
+    send_before(Time::now_cached() + get_query_delay());
   }
   to_send_.push_back(MtprotoQuery{message_id, seq_no, std::move(buffer), gzip_flag, std::move(invoke_after_message_ids),
                                   use_quick_ack});
+  to_send_size_ += query_size;
+  if (target_query_count_ > 1 && (to_send_.size() >= target_query_count_ || to_send_size_ >= MAX_CONTAINER_SIZE)) {
+    // the container is full enough, there is no reason to wait for more queries
+    send_before(Time::now_cached());
+  }
   VLOG(mtproto) << "Invoke query with " << message_id << " and seq_no " << seq_no << " of size "
                 << to_send_.back().packet.size() << " after " << invoke_after_message_ids
                 << (use_quick_ack ? " with quick ack" : "");
@@ -945,12 +959,11 @@ void SessionConnection::flush_packet() {
     }
   }
 
-  static constexpr size_t MAX_QUERY_COUNT = 1000;
   size_t send_till = 0;
   size_t send_size = 0;
   if (has_salt) {
-    // send at most MAX_QUERY_COUNT queries, of total size up to 2^15
-    while (send_till < to_send_.size() && send_till < MAX_QUERY_COUNT && send_size < (1 << 15)) {
+    // send at most MAX_CONTAINER_QUERY_COUNT queries, of total size up to MAX_CONTAINER_SIZE
+    while (send_till < to_send_.size() && send_till < MAX_CONTAINER_QUERY_COUNT && send_size < MAX_CONTAINER_SIZE) {
       send_size += to_send_[send_till].packet.size();
       send_till++;
     }
@@ -958,10 +971,13 @@ void SessionConnection::flush_packet() {
   vector<MtprotoQuery> queries;
   if (send_till == to_send_.size()) {
     queries = std::move(to_send_);
+    to_send_.clear();
+    to_send_size_ = 0;
   } else if (send_till != 0) {
     queries.reserve(send_till);
     std::move(to_send_.begin(), to_send_.begin() + send_till, std::back_inserter(queries));
     to_send_.erase(to_send_.begin(), to_send_.begin() + send_till);
+    to_send_size_ -= send_size;
   }
 
   bool destroy_auth_key = need_destroy_auth_key_ && !sent_destroy_auth_key_;
@@ -1005,8 +1021,9 @@ void SessionConnection::flush_packet() {
   // no more than 8192 message identifiers per container..
   auto to_resend_answer = cut_tail(to_resend_answer_message_ids_, 8192, "resend_answer");
   MessageId resend_answer_message_id;
-  CHECK(queries.size() <= MAX_QUERY_COUNT);
-  auto to_cancel_answer = cut_tail(to_cancel_answer_message_ids_, MAX_QUERY_COUNT - queries.size(), "cancel_answer");
+  CHECK(queries.size() <= MAX_CONTAINER_QUERY_COUNT);
+  auto to_cancel_answer =
+      cut_tail(to_cancel_answer_message_ids_, MAX_CONTAINER_QUERY_COUNT - queries.size(), "cancel_answer");
   auto to_get_state_info = cut_tail(to_get_state_info_message_ids_, 8192, "get_state_info");
   MessageId get_state_info_message_id;
   auto to_ack = cut_tail(to_ack_message_ids_, 8192, "ack");
@@ -1040,6 +1057,20 @@ void SessionConnection::flush_packet() {
     last_ping_message_id_ = ping_message_id;
   }
 
+  if (!queries.empty()) {
+    container_statistics_.packet_count++;
+    container_statistics_.query_count += queries.size();
+    container_statistics_.query_size += send_size;
+    if (inflight_query_sizes_.size() < MAX_TRACKED_INFLIGHT_QUERIES) {
+      for (auto &query : queries) {
+        auto size = query.packet.size();
+        if (inflight_query_sizes_.emplace(query.message_id, size).second) {
+          inflight_query_size_ += size;
+        }
+      }
+    }
+  }
+
   if (container_message_id != MessageId()) {
     auto message_ids = transform(queries, [](const MtprotoQuery &x) { return x.message_id; });
 
@@ -1070,6 +1101,45 @@ void SessionConnection::send_before(double tm) {
   }
 }
 
+void SessionConnection::update_query_target(size_t query_size) {
+  auto now = Time::now_cached();
+  if (last_query_at_ != 0) {
+    auto interval = clamp(now - last_query_at_, 0.0, 1.0);
+    query_interval_ += (interval - query_interval_) * 0.25;
+  }
+  last_query_at_ = now;
+  average_query_size_ += (static_cast<double>(query_size) - average_query_size_) * 0.25;
+
+  // the number of queries expected to arrive during the longest allowed delay, limited by the container size
+  auto expected_query_count = MAX_QUERY_DELAY / max(query_interval_, 1e-6);
+  auto max_query_count = static_cast<double>(MAX_CONTAINER_SIZE) / max(average_query_size_, 1.0);
+  target_query_count_ = static_cast<size_t>(
+      clamp(min(expected_query_count, max_query_count), 1.0, static_cast<double>(MAX_CONTAINER_QUERY_COUNT)));
+}
+
+double SessionConnection::get_query_delay() const {
+  if (target_query_count_ <= 1) {
+    // isolated queries are sent as soon as possible
+    return QUERY_DELAY;
+  }
+
+  // wait for the expected queries, but no more than a small part of RTT;
+  // if there are many bytes in flight, then the connection is busy anyway and waiting is cheaper
+  auto rtt_part = inflight_query_size_ >= MAX_CONTAINER_SIZE ? 0.1 : 0.05;
+  auto max_delay = clamp(raw_connection_->extra().rtt * rtt_part, QUERY_DELAY, MAX_QUERY_DELAY);
+  return clamp(query_interval_ * static_cast<double>(target_query_count_), QUERY_DELAY, max_delay);
+}
+
+void SessionConnection::on_query_answered(MessageId message_id) {
+  auto it = inflight_query_sizes_.find(message_id);
+  if (it == inflight_query_sizes_.end()) {
+    return;
+  }
+  CHECK(inflight_query_size_ >= it->second);
+  inflight_query_size_ -= it->second;
+  inflight_query_sizes_.erase(it);
+}
+
 Status SessionConnection::do_flush() {
   LOG_CHECK(raw_connection_) << was_moved_ << ' ' << state_ << ' ' << static_cast<int32>(mode_) << ' '
                              << connected_flag_ << ' ' << is_main_ << ' ' << need_destroy_auth_key_ << ' '
@@ -114,12 +114,36 @@ class SessionConnection final
 
   double flush(SessionConnection::Callback *callback);
 
+  struct ContainerStatistics {
+    uint64 packet_count = 0;  // number of sent packets with at least one query
+    uint64 query_count = 0;
+    uint64 query_size = 0;
+
+    void add(const ContainerStatistics &other) {
+      packet_count += other.packet_count;
+      query_count += other.query_count;
+      query_size += other.query_size;
+    }
+
+    // average part of the maximum container size, which was used by queries
+    double get_fill_ratio() const {
+      if (packet_count == 0) {
+        return 0.0;
+      }
+      return static_cast<double>(query_size) / static_cast<double>(packet_count * MAX_CONTAINER_SIZE);
+    }
+  };
+  const ContainerStatistics &get_container_statistics() const {
+    return container_statistics_;
+  }
+
   // NB: Do not call force_close after on_closed callback
   void force_close(SessionConnection::Callback *callback);
 
  private:
   static constexpr int ACK_DELAY = 30;                  // 30s
   static constexpr double QUERY_DELAY = 0.001;          // 0.001s
+  static constexpr double MAX_QUERY_DELAY = 0.01;       // 0.01s
   static constexpr double RESEND_ANSWER_DELAY = 0.001;  // 0.001s
 
   struct MsgInfo {
@@ -159,8 +183,14 @@ class SessionConnection final
   }
   static constexpr int HTTP_MAX_AFTER = 10;  // 0.01s
   static constexpr int HTTP_MAX_DELAY = 30;  // 0.03s
+  static constexpr size_t HTTP_MAX_PIPELINED_QUERY_COUNT = 4;
+
+  static constexpr size_t MAX_CONTAINER_QUERY_COUNT = 1000;
+  static constexpr size_t MAX_CONTAINER_SIZE = 1 << 15;
+  static constexpr size_t MAX_TRACKED_INFLIGHT_QUERIES = 4096;
 
   vector<MtprotoQuery> to_send_;
+  size_t to_send_size_ = 0;
   vector<MessageId> to_ack_message_ids_;
   double force_send_at_ = 0;
 
@@ -195,6 +225,19 @@ class SessionConnection final
 
   double flush_packet_at_ = 0;
 
+  // adaptive query packing: during bursts queries are delayed to be sent in fewer containers
+  double last_query_at_ = 0;
+  double query_interval_ = 1.0;  // smoothed interval between queries
+  double average_query_size_ = 0.0;
+  size_t target_query_count_ = 1;
+
+  // queries, which were sent, but weren't answered yet; queries from failed containers are re-sent by the parent
+  // with new message identifiers, so the estimate can be slightly bigger than the real value
+  FlatHashMap<MessageId, size_t, MessageIdHash> inflight_query_sizes_;
+  size_t inflight_query_size_ = 0;
+
+  ContainerStatistics container_statistics_;
+
   double last_get_future_salt_at_ = 0;
   enum { Init, Run, Fail, Closed } state_;
   Mode mode_;
@@ -262,6 +305,9 @@ class SessionConnection final
   void send_ack(MessageId message_id);
   void send_crypto(const Storer &storer, uint64 quick_ack_token);
   void send_before(double tm);
+  void update_query_target(size_t query_size);
+  double get_query_delay() const;
+  void on_query_answered(MessageId message_id);
   bool may_ping() const;
   bool must_ping() const;
   bool must_flush_packet();
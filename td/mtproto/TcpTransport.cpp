@@ -173,22 +173,48 @@ void ObfuscatedTransport::do_write_main(BufferWriter &&message) {
 void ObfuscatedTransport::do_write_tls(BufferWriter &&message) {
   CHECK(header_.size() <= MAX_TLS_PACKET_LENGTH);
   if (message.size() + header_.size() > MAX_TLS_PACKET_LENGTH) {
-    auto buffer_slice = message.as_buffer_slice();
-    auto slice = buffer_slice.as_slice();
-    while (!slice.empty()) {
-      auto buf = buffer_slice.from_slice(slice.substr(0, MAX_TLS_PACKET_LENGTH - header_.size()));
-      slice.remove_prefix(buf.size());
-      BufferBuilder builder;
-      builder.append(std::move(buf));
-      do_write_tls(std::move(builder));
-    }
-    return;
+    return do_write_tls_records(message.as_slice());
   }
 
   BufferBuilder builder(std::move(message));
   do_write_tls(std::move(builder));
 }
 
+void ObfuscatedTransport::do_write_tls_records(Slice message) {
+  // write all records to a single buffer to avoid separate allocation and copying of each record
+  size_t total_size = header_.size() + message.size();
+  size_t record_count = (total_size + MAX_TLS_PACKET_LENGTH - 1) / MAX_TLS_PACKET_LENGTH;
+  size_t result_size = total_size + 5 * record_count + (is_first_tls_packet_ ? 6 : 0);
+  BufferWriter writer(result_size, 0, 0);
+  MutableSlice dest = writer.as_mutable_slice();
+  auto append = [&dest](Slice slice) {
+    dest.copy_from(slice);
+    dest.remove_prefix(slice.size());
+  };
+
+  if (is_first_tls_packet_) {
+    is_first_tls_packet_ = false;
+    append(Slice("\x14\x03\x03\x00\x01\x01"));
+  }
+  while (!message.empty()) {
+    auto size = min(message.size() + header_.size(), static_cast<size_t>(MAX_TLS_PACKET_LENGTH));
+    char buf[] = "\x17\x03\x03\x00\x00";
+    buf[3] = static_cast<char>((size >> 8) & 0xff);
+    buf[4] = static_cast<char>(size & 0xff);
+    append(Slice(buf, 5));
+    if (!header_.empty()) {
+      append(header_);
+      size -= header_.size();
+      header_ = {};
+    }
+    append(message.substr(0, size));
+    message.remove_prefix(size);
+  }
+  CHECK(dest.empty());
+
+  do_write(writer.as_buffer_slice());
+}
+
 void ObfuscatedTransport::do_write_tls(BufferBuilder &&builder) {
   if (!header_.empty()) {
     builder.prepend(header_);
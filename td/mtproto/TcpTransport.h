@@ -74,6 +74,8 @@ class OldTransport final : public IStreamTransport {
   bool can_write() const final {
     return true;
   }
+  void set_max_pipelined_query_count(size_t max_pipelined_query_count) final {
+  }
 
   size_t max_prepend_size() const final {
     return 4;
@@ -120,6 +122,8 @@ class ObfuscatedTransport final : public IStreamTransport {
   bool can_write() const final {
     return true;
   }
+  void set_max_pipelined_query_count(size_t max_pipelined_query_count) final {
+  }
 
   size_t max_prepend_size() const final {
     size_t res = 4;
@@ -170,6 +174,7 @@ class ObfuscatedTransport final : public IStreamTransport {
 
   void do_write_tls(BufferWriter &&message);
   void do_write_tls(BufferBuilder &&builder);
+  void do_write_tls_records(Slice message);
   void do_write_main(BufferWriter &&message);
   void do_write(BufferSlice &&message);
 };
@@ -13,27 +13,51 @@ namespace td {
 namespace mtproto {
 
 bool TlsReaderByteFlow::loop() {
-  if (input_->size() < 5) {
-    set_need_size(5);
-    return false;
-  }
+  // process all complete records at once to avoid repeated wakeups of the next flow
+  bool result = false;
+  while (true) {
+    if (input_->size() < 5) {
+      set_need_size(5);
+      return on_input_exhausted(result);
+    }
 
-  auto it = input_->clone();
-  uint8 buf[5];
-  it.advance(5, MutableSlice(buf, 5));
-  if (Slice(buf, 3) != Slice("\x17\x03\x03")) {
-    close_input(Status::Error("Invalid bytes at the beginning of a packet (emulated tls)"));
-    return false;
-  }
-  size_t len = (buf[3] << 8) | buf[4];
-  if (it.size() < len) {
-    set_need_size(5 + len);
-    return false;
+    uint8 buf[5];
+    auto ready = input_->prepare_read();
+    if (ready.size() >= 5) {
+      MutableSlice(buf, 5).copy_from(ready.substr(0, 5));
+    } else {
+      auto it = input_->clone();
+      it.advance(5, MutableSlice(buf, 5));
+    }
+    if (Slice(buf, 3) != Slice("\x17\x03\x03")) {
+      close_input(Status::Error("Invalid bytes at the beginning of a packet (emulated tls)"));
+      return false;
+    }
+    size_t len = (buf[3] << 8) | buf[4];
+    if (input_->size() < 5 + len) {
+      set_need_size(5 + len);
+      return on_input_exhausted(result);
+    }
+
+    // copy record data to a big contiguous buffer instead of creating a new buffer chain node for each record
+    input_->advance(5);
+    while (len > 0) {
+      auto data = input_->prepare_read();
+      data.truncate(len);
+      output_.append(data, 1 << 14);
+      input_->confirm_read(data.size());
+      len -= data.size();
+    }
+    result = true;
   }
+}
 
-  output_.append(it.cut_head(len));
-  *input_ = std::move(it);
-  return true;
+bool TlsReaderByteFlow::on_input_exhausted(bool result) {
+  if (!is_input_active_) {
+    // end of input stream
+    finish(input_->empty() ? Status::OK() : Status::Error("Unexpected end of stream (emulated tls)"));
+  }
+  return result;
 }
 
 }  // namespace mtproto
@@ -14,6 +14,9 @@ namespace mtproto {
 class TlsReaderByteFlow final : public ByteFlowBase {
  public:
   bool loop() final;
+
+ private:
+  bool on_input_exhausted(bool result);
 };
 
 }  // namespace mtproto
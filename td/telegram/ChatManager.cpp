@@ -22,6 +22,7 @@
 #include "td/telegram/InputGroupCallId.h"
 #include "td/telegram/logevent/LogEvent.h"
 #include "td/telegram/logevent/LogEventHelper.h"
+#include "td/telegram/MemoryStatistics.h"
 #include "td/telegram/MessageSender.h"
 #include "td/telegram/MessagesManager.h"
 #include "td/telegram/MessageTtl.h"
@@ -8897,6 +8898,14 @@ tl_object_ptr<td_api::supergroupFullInfo> ChatManager::get_supergroup_full_info_
       channel_full->migrated_from_max_message_id.get());
 }
 
+void ChatManager::memory_stats(MemoryStatistics &statistics) const {
+  Slice manager_name = "ChatManager";
+  statistics.add_hash_map<ChatId, Chat>(manager_name, "chat", chats_.calc_size());
+  statistics.add_hash_map<ChatId, ChatFull>(manager_name, "chat_full", chats_full_.calc_size());
+  statistics.add_hash_map<ChannelId, Channel>(manager_name, "channel", channels_.calc_size());
+  statistics.add_hash_map<ChannelId, ChannelFull>(manager_name, "channel_full", channels_full_.calc_size());
+}
+
 void ChatManager::get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const {
   for (auto chat_id : unknown_chats_) {
     if (!have_chat(chat_id)) {
@@ -54,6 +54,7 @@
 namespace td {
 
 struct BinlogEvent;
+class MemoryStatistics;
 struct MinChannel;
 class Td;
 
@@ -383,6 +384,8 @@ class ChatManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void memory_stats(MemoryStatistics &statistics) const;
+
  private:
   struct Chat {
     string title;
@@ -6,6 +6,7 @@
 //
 #include "td/telegram/Client.h"
 
+#include "td/telegram/SharedServerDataCache.h"
 #include "td/telegram/Td.h"
 #include "td/telegram/TdCallback.h"
 
@@ -18,14 +19,17 @@
 #include "td/utils/ExitGuard.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/FlatHashSet.h"
+#include "td/utils/LockStatistics.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/MpscPollableQueue.h"
+#include "td/utils/port/numa.h"
 #include "td/utils/port/RwMutex.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
 #include "td/utils/utf8.h"
 
 #include <algorithm>
@@ -37,6 +41,24 @@
 
 namespace td {
 
+struct ClientThreadConfiguration {
+  static constexpr int32 DEFAULT_ADDITIONAL_THREAD_COUNT = 3;
+
+  int32 instance_count = 0;
+  int32 additional_thread_count = DEFAULT_ADDITIONAL_THREAD_COUNT;
+  uint64 thread_affinity_mask = 0;
+  bool bind_to_numa_nodes = false;
+
+  static int32 get_thread_count(int32 additional_thread_count) {
+    return 1 + additional_thread_count + 1 /* IOCP */;
+  }
+};
+
+constexpr int32 ClientThreadConfiguration::DEFAULT_ADDITIONAL_THREAD_COUNT;
+
+static std::mutex client_thread_configuration_mutex;
+static ClientThreadConfiguration client_thread_configuration;
+
 #if TD_THREAD_UNSUPPORTED || TD_EVENTFD_UNSUPPORTED
 class TdReceiver {
  public:
@@ -92,12 +114,14 @@ class ClientManager::Impl final {
     return client_id;
   }
 
-  void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request) {
+  void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request,
+            bool is_high_priority) {
     if (pending_clients_.erase(client_id) != 0) {
       if (tds_.empty()) {
         CHECK(concurrent_scheduler_ == nullptr);
         CHECK(options_.net_query_stats == nullptr);
         options_.net_query_stats = std::make_shared<NetQueryStats>();
+        options_.shared_server_data_cache = std::make_shared<SharedServerDataCache>();
         concurrent_scheduler_ = make_unique<ConcurrentScheduler>(0, 0);
         concurrent_scheduler_->start();
       }
@@ -163,6 +187,7 @@ class ClientManager::Impl final {
         CHECK(options_.net_query_stats.use_count() == 1);
         CHECK(options_.net_query_stats->get_count() == 0);
         options_.net_query_stats = nullptr;
+        options_.shared_server_data_cache = nullptr;
         concurrent_scheduler_->finish();
         concurrent_scheduler_ = nullptr;
         reset_to_empty(tds_);
@@ -171,6 +196,18 @@ class ClientManager::Impl final {
     return response;
   }
 
+  vector<Response> receive_batch(double timeout, size_t max_count) {
+    vector<Response> responses;
+    while (responses.size() < max_count) {
+      auto response = receive(responses.empty() ? timeout : 0.0);
+      if (response.object == nullptr) {
+        break;
+      }
+      responses.push_back(std::move(response));
+    }
+    return responses;
+  }
+
   Impl() = default;
   Impl(const Impl &) = delete;
   Impl &operator=(const Impl &) = delete;
@@ -212,11 +249,12 @@ class ClientManager::Impl final {
 
 class Client::Impl final {
  public:
-  Impl() : client_id_(impl_.create_client_id()) {
+  // the client is always run on the thread calling receive
+  explicit Impl(bool /*run_inline*/) : client_id_(impl_.create_client_id()) {
   }
 
   void send(Request request) {
-    impl_.send(client_id_, request.id, std::move(request.function));
+    impl_.send(client_id_, request.id, std::move(request.function), false);
   }
 
   Response receive(double timeout) {
@@ -253,10 +291,15 @@ class MultiTd final : public Actor {
   }
 
   void send(ClientManager::ClientId client_id, ClientManager::RequestId request_id,
-            td_api::object_ptr<td_api::Function> &&request) {
+            td_api::object_ptr<td_api::Function> &&request, bool is_high_priority) {
     auto &td = tds_[client_id];
     CHECK(!td.empty());
-    send_closure(td, &Td::request, request_id, std::move(request));
+    if (is_high_priority) {
+      auto event = Event::delayed_closure(&Td::request, request_id, std::move(request));
+      send_event(td, std::move(event.set_high_priority()));
+    } else {
+      send_closure(td, &Td::request, request_id, std::move(request));
+    }
   }
 
   void close(int32 td_id) {
@@ -295,6 +338,19 @@ class TdReceiver {
     return response;
   }
 
+  void receive_batch(double timeout, size_t max_count, vector<ClientManager::Response> &responses) {
+    VLOG(td_requests) << "Begin to wait for a batch of at most " << max_count << " updates with timeout " << timeout;
+    auto is_locked = receive_lock_.exchange(true);
+    if (is_locked) {
+      LOG(FATAL) << "Receive must not be called simultaneously from two different threads, but this has just "
+                    "happened. Call it from a fixed thread, dedicated for updates and response processing.";
+    }
+    receive_batch_unlocked(clamp(timeout, 0.0, 1000000.0), max_count, responses);
+    is_locked = receive_lock_.exchange(false);
+    CHECK(is_locked);
+    VLOG(td_requests) << "End to wait for updates, returning " << responses.size() << " objects";
+  }
+
   unique_ptr<TdCallback> create_callback(ClientManager::ClientId client_id) {
     class Callback final : public TdCallback {
      public:
@@ -341,29 +397,68 @@ class TdReceiver {
       return output_queue_->reader_get_unsafe();
     }
     if (timeout != 0) {
-      output_queue_->reader_get_event_fd().wait(static_cast<int>(timeout * 1000));
+      wait_output_queue(timeout);
       return receive_unlocked(0);
     }
     return {0, 0, nullptr};
   }
+
+  void wait_output_queue(double timeout) {
+#if TD_HAVE_LOCK_STATISTICS
+    static LockStatistics statistics("TdReceiver");
+    statistics.on_lock();
+    auto start_time = Time::now();
+    output_queue_->reader_get_event_fd().wait(static_cast<int>(timeout * 1000));
+    statistics.on_contention(1, Time::now() - start_time);
+#else
+    output_queue_->reader_get_event_fd().wait(static_cast<int>(timeout * 1000));
+#endif
+  }
+
+  void receive_batch_unlocked(double timeout, size_t max_count, vector<ClientManager::Response> &responses) {
+    while (responses.size() < max_count) {
+      if (output_queue_ready_cnt_ == 0) {
+        output_queue_ready_cnt_ = output_queue_->reader_wait_nonblock();
+      }
+      if (output_queue_ready_cnt_ > 0) {
+        output_queue_ready_cnt_--;
+        responses.push_back(output_queue_->reader_get_unsafe());
+        continue;
+      }
+      if (timeout == 0 || !responses.empty()) {
+        return;
+      }
+      wait_output_queue(timeout);
+      timeout = 0;
+    }
+  }
 };
 
 class MultiImpl {
  public:
-  static constexpr int32 ADDITIONAL_THREAD_COUNT = 3;
-
-  explicit MultiImpl(std::shared_ptr<NetQueryStats> net_query_stats) {
-    concurrent_scheduler_ = std::make_shared<ConcurrentScheduler>(ADDITIONAL_THREAD_COUNT, 0);
+  MultiImpl(std::shared_ptr<NetQueryStats> net_query_stats,
+            std::shared_ptr<SharedServerDataCache> shared_server_data_cache, int32 additional_thread_count,
+            uint64 thread_affinity_mask, int32 numa_node) {
+    concurrent_scheduler_ = std::make_shared<ConcurrentScheduler>(additional_thread_count, thread_affinity_mask);
+    if (numa_node >= 0) {
+      concurrent_scheduler_->enable_numa_binding(numa_node);
+    }
     concurrent_scheduler_->start();
 
     {
       auto guard = concurrent_scheduler_->get_main_guard();
       Td::Options options;
       options.net_query_stats = std::move(net_query_stats);
+      options.shared_server_data_cache = std::move(shared_server_data_cache);
       multi_td_ = create_actor<MultiTd>("MultiTd", std::move(options));
     }
 
     scheduler_thread_ = thread([concurrent_scheduler = concurrent_scheduler_] {
+#if TD_HAVE_THREAD_AFFINITY
+      if (concurrent_scheduler->get_scheduler_affinity_mask(0) != 0) {
+        thread::set_affinity_mask(this_thread::get_id(), concurrent_scheduler->get_scheduler_affinity_mask(0)).ignore();
+      }
+#endif
       while (concurrent_scheduler->run_main(10)) {
       }
     });
@@ -382,7 +477,9 @@ class MultiImpl {
   void create(int32 td_id, unique_ptr<TdCallback> callback) {
     LOG(INFO) << "Initialize client " << td_id;
     auto guard = concurrent_scheduler_->get_send_guard();
-    send_closure(multi_td_, &MultiTd::create, td_id, std::move(callback));
+    // high-priority requests must not overtake creation of the client
+    auto event = Event::delayed_closure(&MultiTd::create, td_id, std::move(callback));
+    send_event(multi_td_, std::move(event.set_high_priority()));
   }
 
   static bool is_valid_client_id(int32 client_id) {
@@ -390,9 +487,18 @@ class MultiImpl {
   }
 
   void send(ClientManager::ClientId client_id, ClientManager::RequestId request_id,
-            td_api::object_ptr<td_api::Function> &&request) {
+            td_api::object_ptr<td_api::Function> &&request, bool is_high_priority) {
     auto guard = concurrent_scheduler_->get_send_guard();
-    send_closure(multi_td_, &MultiTd::send, client_id, request_id, std::move(request));
+    if (is_high_priority) {
+      auto event = Event::delayed_closure(&MultiTd::send, client_id, request_id, std::move(request), true);
+      send_event(multi_td_, std::move(event.set_high_priority()));
+    } else {
+      send_closure(multi_td_, &MultiTd::send, client_id, request_id, std::move(request), false);
+    }
+  }
+
+  double get_busy_time() const {
+    return concurrent_scheduler_->get_busy_time();
   }
 
   void close(ClientManager::ClientId client_id) {
@@ -423,9 +529,13 @@ class MultiImpl {
   static std::atomic<uint32> current_id_;
 };
 
-constexpr int32 MultiImpl::ADDITIONAL_THREAD_COUNT;
 std::atomic<uint32> MultiImpl::current_id_{1};
 
+static ClientThreadConfiguration get_client_thread_configuration() {
+  std::lock_guard<std::mutex> guard(client_thread_configuration_mutex);
+  return client_thread_configuration;
+}
+
 class MultiImplPool {
  public:
   std::shared_ptr<MultiImpl> get() {
@@ -433,21 +543,46 @@ class MultiImplPool {
     if (impls_.empty()) {
       init_openssl_threads();
 
-      auto max_client_threads = clamp(thread::hardware_concurrency(), 8u, 20u) * 5 / 4;
+      configuration_ = get_client_thread_configuration();
+      auto thread_count = static_cast<uint32>(
+          ClientThreadConfiguration::get_thread_count(configuration_.additional_thread_count));
+      auto max_client_threads = static_cast<uint32>(configuration_.instance_count);
+      if (max_client_threads == 0) {
+        max_client_threads = clamp(thread::hardware_concurrency(), 8u, 20u) * 5 / 4;
 #if TD_OPENBSD
-      max_client_threads = td::min(max_client_threads, 4u);
+        max_client_threads = td::min(max_client_threads, 4u);
 #endif
+        max_client_threads = td::min(max_client_threads, (TD_MAX_THREAD_COUNT - 1) / thread_count);
+      }
       impls_.resize(max_client_threads);
-      CHECK(impls_.size() * (1 + MultiImpl::ADDITIONAL_THREAD_COUNT + 1 /* IOCP */) < 128);
+      CHECK(impls_.size() * thread_count < TD_MAX_THREAD_COUNT);
 
       net_query_stats_ = std::make_shared<NetQueryStats>();
+      shared_server_data_cache_ = std::make_shared<SharedServerDataCache>();
+      numa_node_count_ = configuration_.bind_to_numa_nodes ? get_numa_node_cpu_masks().size() : 0;
     }
-    auto &impl = *std::min_element(impls_.begin(), impls_.end(),
-                                   [](auto &a, auto &b) { return a.lock().use_count() < b.lock().use_count(); });
-    auto result = impl.lock();
+    update_loads();
+    auto &info = *std::min_element(impls_.begin(), impls_.end(), [](const MultiImplInfo &a, const MultiImplInfo &b) {
+      auto a_rank = a.get_load_rank();
+      auto b_rank = b.get_load_rank();
+      if (a_rank != b_rank) {
+        return a_rank < b_rank;
+      }
+      return a.impl.use_count() < b.impl.use_count();
+    });
+    auto result = info.impl.lock();
     if (!result) {
-      result = std::make_shared<MultiImpl>(net_query_stats_);
-      impl = result;
+      // instance groups are spread between NUMA nodes, so that all threads of a group share the same node
+      int32 numa_node = -1;
+      if (numa_node_count_ > 1) {
+        numa_node = static_cast<int32>(static_cast<size_t>(&info - &impls_[0]) % numa_node_count_);
+      }
+      result = std::make_shared<MultiImpl>(net_query_stats_, shared_server_data_cache_,
+                                           configuration_.additional_thread_count, configuration_.thread_affinity_mask,
+                                           numa_node);
+      info.impl = result;
+      info.busy_time = 0.0;
+      info.load = 0.0;
     }
     return result;
   }
@@ -458,24 +593,69 @@ class MultiImplPool {
       return;
     }
 
-    for (auto &impl : impls_) {
-      if (impl.lock().use_count() != 0) {
+    for (auto &info : impls_) {
+      if (info.impl.lock().use_count() != 0) {
         return;
       }
     }
     reset_to_empty(impls_);
+    last_load_update_time_ = 0.0;
 
     CHECK(net_query_stats_.use_count() == 1);
     CHECK(net_query_stats_->get_count() == 0);
     net_query_stats_ = nullptr;
+    shared_server_data_cache_ = nullptr;
   }
 
  private:
+  static constexpr double LOAD_UPDATE_PERIOD = 1.0;
+  static constexpr double LOAD_GRANULARITY = 0.1;
+
+  struct MultiImplInfo {
+    std::weak_ptr<MultiImpl> impl;
+    double busy_time = 0.0;
+    double load = 0.0;  // smoothed number of threads busy with event processing
+
+    int64 get_load_rank() const {
+      return static_cast<int64>(load / LOAD_GRANULARITY);
+    }
+  };
+
   std::mutex mutex_;
-  std::vector<std::weak_ptr<MultiImpl>> impls_;
+  std::vector<MultiImplInfo> impls_;
   std::shared_ptr<NetQueryStats> net_query_stats_;
+  std::shared_ptr<SharedServerDataCache> shared_server_data_cache_;
+  ClientThreadConfiguration configuration_;
+  size_t numa_node_count_ = 0;
+  double last_load_update_time_ = 0.0;
+
+  void update_loads() {
+    auto now = Time::now();
+    auto passed_time = now - last_load_update_time_;
+    if (passed_time < LOAD_UPDATE_PERIOD) {
+      return;
+    }
+    bool is_first_update = last_load_update_time_ == 0.0;
+    last_load_update_time_ = now;
+    for (auto &info : impls_) {
+      auto impl = info.impl.lock();
+      if (impl == nullptr) {
+        info.busy_time = 0.0;
+        info.load = 0.0;
+        continue;
+      }
+      auto busy_time = impl->get_busy_time();
+      if (!is_first_update) {
+        info.load = 0.5 * info.load + 0.5 * (busy_time - info.busy_time) / passed_time;
+      }
+      info.busy_time = busy_time;
+    }
+  }
 };
 
+constexpr double MultiImplPool::LOAD_UPDATE_PERIOD;
+constexpr double MultiImplPool::LOAD_GRANULARITY;
+
 class ClientManager::Impl final {
  public:
   ClientId create_client_id() {
@@ -488,7 +668,8 @@ class ClientManager::Impl final {
     return client_id;
   }
 
-  void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request) {
+  void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request,
+            bool is_high_priority) {
     auto lock = impls_mutex_.lock_read().move_as_ok();
     if (!MultiImpl::is_valid_client_id(client_id)) {
       receiver_.add_response(client_id, request_id,
@@ -515,11 +696,26 @@ class ClientManager::Impl final {
       receiver_.add_response(client_id, request_id, td_api::make_object<td_api::error>(500, "Request aborted"));
       return;
     }
-    it->second.impl->send(client_id, request_id, std::move(request));
+    it->second.impl->send(client_id, request_id, std::move(request), is_high_priority);
   }
 
   Response receive(double timeout) {
     auto response = receiver_.receive(timeout, true);
+    process_response(response);
+    return response;
+  }
+
+  vector<Response> receive_batch(double timeout, size_t max_count) {
+    vector<Response> responses;
+    receiver_.receive_batch(timeout, max_count, responses);
+    for (auto &response : responses) {
+      process_response(response);
+    }
+    td::remove_if(responses, [](const Response &response) { return response.object == nullptr; });
+    return responses;
+  }
+
+  void process_response(Response &response) {
     if (response.request_id == 0 && response.object != nullptr &&
         response.object->get_id() == td_api::updateAuthorizationState::ID &&
         static_cast<const td_api::updateAuthorizationState *>(response.object.get())->authorization_state_->get_id() ==
@@ -546,7 +742,6 @@ class ClientManager::Impl final {
         pool_.try_clear();
       }
     }
-    return response;
   }
 
   void close_impl(ClientId client_id) {
@@ -591,9 +786,150 @@ class ClientManager::Impl final {
   TdReceiver receiver_;
 };
 
+// runs the main scheduler with the Td instance on the thread calling receive;
+// only the database, file and slow network requests are processed by additional scheduler threads
+class InlineClientImpl {
+ public:
+  explicit InlineClientImpl(int32 additional_thread_count) {
+    Td::Options options;
+    options.net_query_stats = std::make_shared<NetQueryStats>();
+    options.shared_server_data_cache = std::make_shared<SharedServerDataCache>();
+    concurrent_scheduler_ = make_unique<ConcurrentScheduler>(additional_thread_count, 0);
+    concurrent_scheduler_->start();
+
+    auto guard = concurrent_scheduler_->get_main_guard();
+    td_ = create_actor<Td>("Td", create_callback(), std::move(options));
+  }
+
+  // can be called from any thread
+  void send(uint64 request_id, td_api::object_ptr<td_api::Function> &&function) {
+    {
+      std::lock_guard<std::mutex> guard(requests_mutex_);
+      requests_.push_back({request_id, std::move(function)});
+    }
+    concurrent_scheduler_->wakeup();
+  }
+
+  Client::Response receive(double timeout) {
+    auto is_locked = receive_lock_.exchange(true);
+    if (is_locked) {
+      LOG(FATAL) << "Receive is called after Client destroy, or simultaneously from different threads";
+    }
+    auto response = receive_unlocked(Timestamp::in(clamp(timeout, 0.0, 1000000.0)));
+    is_locked = receive_lock_.exchange(false);
+    CHECK(is_locked);
+    return response;
+  }
+
+  InlineClientImpl(const InlineClientImpl &) = delete;
+  InlineClientImpl &operator=(const InlineClientImpl &) = delete;
+  InlineClientImpl(InlineClientImpl &&) = delete;
+  InlineClientImpl &operator=(InlineClientImpl &&) = delete;
+  ~InlineClientImpl() {
+    {
+      auto guard = concurrent_scheduler_->get_main_guard();
+      td_.reset();
+    }
+    while (!is_td_closed_ && !ExitGuard::is_exited()) {
+      concurrent_scheduler_->run_main(0.1);
+    }
+    concurrent_scheduler_->finish();
+  }
+
+ private:
+  struct Request {
+    uint64 id;
+    td_api::object_ptr<td_api::Function> function;
+  };
+  std::mutex requests_mutex_;
+  vector<Request> requests_;
+  vector<Request> sent_requests_;
+
+  // accessed only from the thread running the main scheduler
+  std::queue<Client::Response> responses_;
+  bool is_td_closed_ = false;
+
+  std::atomic<bool> receive_lock_{false};
+  unique_ptr<ConcurrentScheduler> concurrent_scheduler_;
+  ActorOwn<Td> td_;
+
+  unique_ptr<TdCallback> create_callback() {
+    class Callback final : public TdCallback {
+     public:
+      explicit Callback(InlineClientImpl *impl) : impl_(impl) {
+      }
+      void on_result(uint64 id, td_api::object_ptr<td_api::Object> result) final {
+        add_response(id, std::move(result));
+      }
+      void on_error(uint64 id, td_api::object_ptr<td_api::error> error) final {
+        add_response(id, std::move(error));
+      }
+      Callback(const Callback &) = delete;
+      Callback &operator=(const Callback &) = delete;
+      Callback(Callback &&) = delete;
+      Callback &operator=(Callback &&) = delete;
+      ~Callback() final {
+        impl_->is_td_closed_ = true;
+      }
+
+     private:
+      InlineClientImpl *impl_;
+
+      void add_response(uint64 id, td_api::object_ptr<td_api::Object> object) {
+        Client::Response response;
+        response.id = id;
+        response.object = std::move(object);
+        impl_->responses_.push(std::move(response));
+        // return from the main scheduler as soon as possible to pass the response to the caller
+        Scheduler::instance()->yield();
+      }
+    };
+    return td::make_unique<Callback>(this);
+  }
+
+  void flush_requests() {
+    {
+      std::lock_guard<std::mutex> guard(requests_mutex_);
+      if (requests_.empty()) {
+        return;
+      }
+      std::swap(requests_, sent_requests_);
+    }
+    auto guard = concurrent_scheduler_->get_main_guard();
+    for (auto &request : sent_requests_) {
+      send_closure_later(td_, &Td::request, request.id, std::move(request.function));
+    }
+    sent_requests_.clear();
+  }
+
+  Client::Response receive_unlocked(Timestamp timeout) {
+    bool is_first = true;
+    while (true) {
+      flush_requests();
+      if (!responses_.empty()) {
+        auto response = std::move(responses_.front());
+        responses_.pop();
+        return response;
+      }
+      if (is_td_closed_ || (!is_first && timeout.is_in_past())) {
+        return {0, nullptr};
+      }
+      is_first = false;
+      concurrent_scheduler_->run_main(timeout);
+    }
+  }
+};
+
 class Client::Impl final {
  public:
-  Impl() {
+  explicit Impl(bool run_inline) {
+    if (run_inline) {
+      auto additional_thread_count = get_client_thread_configuration().additional_thread_count;
+      LOG(INFO) << "Create inline client with " << additional_thread_count << " additional threads";
+      inline_impl_ = make_unique<InlineClientImpl>(additional_thread_count);
+      return;
+    }
+
     static MultiImplPool pool;
     multi_impl_ = pool.get();
     td_id_ = MultiImpl::create_id();
@@ -607,10 +943,16 @@ class Client::Impl final {
       return;
     }
 
-    multi_impl_->send(td_id_, request.id, std::move(request.function));
+    if (inline_impl_ != nullptr) {
+      return inline_impl_->send(request.id, std::move(request.function));
+    }
+    multi_impl_->send(td_id_, request.id, std::move(request.function), false);
   }
 
   Response receive(double timeout) {
+    if (inline_impl_ != nullptr) {
+      return inline_impl_->receive(timeout);
+    }
     auto response = receiver_.receive(timeout, false);
 
     Response old_response;
@@ -625,6 +967,9 @@ class Client::Impl final {
   Impl &operator=(Impl &&) = delete;
   ~Impl() {
     LOG(INFO) << "Destroy Client";
+    if (inline_impl_ != nullptr) {
+      return;
+    }
     multi_impl_->close(td_id_);
     while (!ExitGuard::is_exited()) {
       auto response = receiver_.receive(0.1, false);
@@ -637,12 +982,16 @@ class Client::Impl final {
  private:
   std::shared_ptr<MultiImpl> multi_impl_;
   TdReceiver receiver_;
+  unique_ptr<InlineClientImpl> inline_impl_;
 
-  int32 td_id_;
+  int32 td_id_ = 0;
 };
 #endif
 
-Client::Client() : impl_(std::make_unique<Impl>()) {
+Client::Client() : impl_(std::make_unique<Impl>(false)) {
+}
+
+Client::Client(bool run_inline) : impl_(std::make_unique<Impl>(run_inline)) {
 }
 
 void Client::send(Request &&request) {
@@ -672,13 +1021,22 @@ ClientManager::ClientId ClientManager::create_client_id() {
 }
 
 void ClientManager::send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request) {
-  impl_->send(client_id, request_id, std::move(request));
+  impl_->send(client_id, request_id, std::move(request), false);
+}
+
+void ClientManager::send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request,
+                         bool is_high_priority) {
+  impl_->send(client_id, request_id, std::move(request), is_high_priority);
 }
 
 ClientManager::Response ClientManager::receive(double timeout) {
   return impl_->receive(timeout);
 }
 
+std::vector<ClientManager::Response> ClientManager::receive_batch(double timeout, std::size_t max_count) {
+  return impl_->receive_batch(timeout, max_count);
+}
+
 td_api::object_ptr<td_api::Object> ClientManager::execute(td_api::object_ptr<td_api::Function> &&request) {
   return Td::static_request(std::move(request));
 }
@@ -713,6 +1071,31 @@ void ClientManager::set_log_message_callback(int max_verbosity_level, LogMessage
   }
 }
 
+bool ClientManager::set_thread_configuration(std::int32_t instance_count, std::int32_t additional_thread_count,
+                                             std::uint64_t thread_affinity_mask, bool bind_to_numa_nodes) {
+  if (additional_thread_count == -1) {
+    additional_thread_count = ClientThreadConfiguration::DEFAULT_ADDITIONAL_THREAD_COUNT;
+  }
+  if (instance_count < 0 || additional_thread_count < 0 || additional_thread_count >= TD_MAX_THREAD_COUNT) {
+    return false;
+  }
+  auto thread_count = ClientThreadConfiguration::get_thread_count(additional_thread_count);
+  if (thread_count >= TD_MAX_THREAD_COUNT || instance_count > (TD_MAX_THREAD_COUNT - 1) / thread_count) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> guard(client_thread_configuration_mutex);
+  client_thread_configuration.instance_count = instance_count;
+  client_thread_configuration.additional_thread_count = additional_thread_count;
+  client_thread_configuration.thread_affinity_mask = thread_affinity_mask;
+  client_thread_configuration.bind_to_numa_nodes = bind_to_numa_nodes;
+  return true;
+}
+
+void ClientManager::set_fast_shutdown(bool is_enabled) {
+  Td::set_fast_shutdown(is_enabled);
+}
+
 ClientManager::ClientManager(ClientManager &&) noexcept = default;
 ClientManager &ClientManager::operator=(ClientManager &&) noexcept = default;
 ClientManager::~ClientManager() = default;
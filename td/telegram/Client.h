@@ -11,8 +11,10 @@
 #include "td/telegram/td_api.h"
 #include "td/telegram/td_api.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace td {
 
@@ -86,6 +88,18 @@ class ClientManager final {
    */
   void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request);
 
+  /**
+   * Sends request to TDLib with the specified priority. May be called from any thread.
+   * High-priority requests are delivered to the TDLib instance before ordinary requests, which are still waiting
+   * in the queue, so they can be processed before previously sent ordinary requests.
+   * \param[in] client_id TDLib client instance identifier.
+   * \param[in] request_id Request identifier. Must be non-zero.
+   * \param[in] request Request to TDLib.
+   * \param[in] is_high_priority Pass true to send a latency-sensitive request with a high priority.
+   */
+  void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request,
+            bool is_high_priority);
+
   /**
    * A response to a request, or an incoming update from TDLib.
    */
@@ -115,6 +129,19 @@ class ClientManager final {
    */
   Response receive(double timeout);
 
+  /**
+   * Receives up to max_count incoming updates and responses to requests from TDLib at once. May be called from any
+   * thread, but must not be called simultaneously from two different threads or simultaneously with
+   * ClientManager::receive.
+   * Waits for at most timeout seconds only if there are no available responses, and then returns all already available
+   * responses without additional waiting.
+   * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+   * \param[in] max_count The maximum number of returned responses. Must be positive.
+   * \return Incoming updates and responses to requests in the order they were received. May be empty
+   *         if the timeout expires.
+   */
+  std::vector<Response> receive_batch(double timeout, std::size_t max_count);
+
   /**
    * Synchronously executes a TDLib request.
    * A request can be executed synchronously, only if it is documented with "Can be called synchronously".
@@ -144,6 +171,35 @@ class ClientManager final {
    */
   static void set_log_message_callback(int max_verbosity_level, LogMessageCallbackPtr callback);
 
+  /**
+   * Changes the thread configuration used for TDLib instances. Affects only instance groups, which will be started
+   * after the call, so it must be called before the first request is sent to a TDLib instance to affect all instances.
+   * May be called from any thread.
+   * \param[in] instance_count The maximum number of instance groups, each having its own main thread and own
+   *                           additional worker threads, among which TDLib instances are distributed.
+   *                           Pass 0 to choose the number depending on the number of CPU cores.
+   * \param[in] additional_thread_count The number of additional worker threads in each instance group.
+   *                                    Pass -1 to use the default number of threads. Threads after the first three
+   *                                    are used for CPU-heavy cryptography of authorization key generation.
+   * \param[in] thread_affinity_mask CPU affinity mask for all threads of instance groups; pass 0 to leave it unchanged.
+   * \param[in] bind_to_numa_nodes Pass true to bind all threads of each instance group to CPUs of one NUMA node,
+   *                               spreading instance groups between NUMA nodes. Ignored on systems with one NUMA node.
+   *                               Only CPUs and NUMA nodes with identifiers less than 64 are used.
+   * \return True, if the configuration was changed. False, if the configuration would require more threads than
+   *         supported by TDLib, which can be adjusted by rebuilding TDLib with a larger TD_MAX_THREAD_COUNT.
+   */
+  static bool set_thread_configuration(std::int32_t instance_count, std::int32_t additional_thread_count,
+                                       std::uint64_t thread_affinity_mask, bool bind_to_numa_nodes = false);
+
+  /**
+   * Enables or disables fast shutdown mode for all TDLib instances, which will be closed after the call. The instances
+   * still save all persistent data on closing, but in the mode the memory used by their in-memory objects isn't freed,
+   * which substantially speeds up closing of instances with a lot of data. Must be enabled only before the process
+   * termination, for example, before destroying the ClientManager. May be called from any thread.
+   * \param[in] is_enabled Pass true to enable fast shutdown mode and false to disable it.
+   */
+  static void set_fast_shutdown(bool is_enabled);
+
   /**
    * Destroys the client manager and all TDLib client instances managed by it.
    */
@@ -211,6 +267,16 @@ class Client final {
    */
   Client();
 
+  /**
+   * Creates a new TDLib client, which can run the TDLib instance on the thread calling Client::receive.
+   * In this mode Client::receive drives the TDLib instance until a response or an update is received, or the timeout
+   * expires, so it must be called regularly even if no responses are expected. Requests still can be sent from any
+   * thread. Only database, file and some network requests are processed by additional internal threads, the number
+   * of which can be changed using ClientManager::set_thread_configuration.
+   * \param[in] run_inline Pass true to run the TDLib instance on the thread calling Client::receive.
+   */
+  explicit Client(bool run_inline);
+
   /**
    * A request to the TDLib.
    */
@@ -12,10 +12,14 @@
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/JsonBuilder.h"
+#include "td/utils/logging.h"
+#include "td/utils/Parser.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/SliceBuilder.h"
-#include "td/utils/StackAllocator.h"
+#include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
 
 #include <utility>
 
@@ -26,6 +30,38 @@ static td_api::object_ptr<td_api::Function> get_return_error_function(Slice erro
   return td_api::make_object<td_api::testReturnError>(std::move(error));
 }
 
+// returns verbatim text of the top-level "@extra" field value without building a JsonValue for it
+static Result<string> get_raw_extra(MutableSlice request) {
+  const int32 MAX_DEPTH = 100;
+  Parser parser(request);
+  parser.skip_whitespaces();
+  if (!parser.try_skip('{')) {
+    return Status::Error("Expected a JSON object");
+  }
+  parser.skip_whitespaces();
+  while (parser.peek_char() == '"') {
+    auto key_begin = parser.ptr();
+    TRY_STATUS(json_string_skip(parser));
+    Slice key(key_begin, parser.ptr());
+    parser.skip_whitespaces();
+    if (!parser.try_skip(':')) {
+      return Status::Error("':' expected");
+    }
+    parser.skip_whitespaces();
+    auto value_begin = parser.ptr();
+    TRY_STATUS(do_json_skip(parser, MAX_DEPTH));
+    if (key == Slice("\"@extra\"")) {
+      return string(value_begin, parser.ptr());
+    }
+    parser.skip_whitespaces();
+    if (!parser.try_skip(',')) {
+      break;
+    }
+    parser.skip_whitespaces();
+  }
+  return string();
+}
+
 static std::pair<td_api::object_ptr<td_api::Function>, string> to_request(Slice request) {
   auto request_str = request.str();
   auto r_json_value = json_decode(request_str);
@@ -41,7 +77,16 @@ static std::pair<td_api::object_ptr<td_api::Function>, string> to_request(Slice
 
   string extra;
   if (json_value.get_object().has_field("@extra")) {
-    extra = json_encode<string>(json_value.get_object().extract_field("@extra"));
+    auto extra_value = json_value.get_object().extract_field("@extra");
+    // json_decode has modified request_str in place, so a new copy of the request is scanned
+    auto extra_request_str = request.str();
+    auto r_extra = get_raw_extra(extra_request_str);
+    if (r_extra.is_ok() && !r_extra.ok().empty()) {
+      extra = r_extra.move_as_ok();
+    } else {
+      // the field name contains escape sequences, so fall back to re-encoding of the value
+      extra = json_encode<string>(extra_value);
+    }
   }
 
   td_api::object_ptr<td_api::Function> func;
@@ -53,9 +98,19 @@ static std::pair<td_api::object_ptr<td_api::Function>, string> to_request(Slice
   return std::make_pair(std::move(func), std::move(extra));
 }
 
-static string from_response(const td_api::Object &object, const string &extra, int client_id) {
-  auto buf = StackAllocator::alloc(1 << 18);
-  JsonBuilder jb(StringBuilder(buf.as_slice(), true), -1);
+static TD_THREAD_LOCAL string *current_output;
+
+// all responses are serialized directly to a reusable thread-local buffer, which grows to fit the largest response
+static JsonBuilder create_output_builder() {
+  constexpr size_t MIN_OUTPUT_BUFFER_SIZE = 1 << 18;
+  init_thread_local<string>(current_output);
+  if (current_output->size() < MIN_OUTPUT_BUFFER_SIZE) {
+    current_output->resize(MIN_OUTPUT_BUFFER_SIZE);
+  }
+  return JsonBuilder(StringBuilder(MutableSlice(&(*current_output)[0], current_output->size()), true), -1);
+}
+
+static void append_response(JsonBuilder &jb, const td_api::Object &object, const string &extra, int client_id) {
   jb.enter_value() << ToJson(object);
   auto &sb = jb.string_builder();
   auto slice = sb.as_cslice();
@@ -68,23 +123,47 @@ static string from_response(const td_api::Object &object, const string &extra, i
     sb << ",\"@client_id\":" << client_id;
   }
   sb << '}';
-  return sb.as_cslice().str();
 }
 
-static TD_THREAD_LOCAL string *current_output;
+static const char *finish_output(JsonBuilder &jb) {
+  auto slice = jb.string_builder().as_cslice();
+  if (slice.begin() != current_output->data()) {
+    // the output didn't fit in the buffer; keep the enlarged buffer for subsequent responses
+    current_output->assign(slice.begin(), slice.size());
+    return current_output->c_str();
+  }
+  return slice.c_str();
+}
 
-static const char *store_string(string str) {
-  init_thread_local<string>(current_output);
-  *current_output = std::move(str);
-  return current_output->c_str();
+static const char *store_response(const td_api::Object &object, const string &extra, int client_id) {
+  auto jb = create_output_builder();
+  append_response(jb, object, extra, client_id);
+  return finish_output(jb);
+}
+
+void ClientJsonExtraStorage::add(std::uint64_t request_id, std::string &&extra) {
+  auto &shard = get_shard(request_id);
+  std::lock_guard<std::mutex> guard(shard.mutex_);
+  shard.extra_[request_id] = std::move(extra);
+}
+
+std::string ClientJsonExtraStorage::extract(std::uint64_t request_id) {
+  auto &shard = get_shard(request_id);
+  std::lock_guard<std::mutex> guard(shard.mutex_);
+  auto it = shard.extra_.find(request_id);
+  if (it == shard.extra_.end()) {
+    return string();
+  }
+  auto result = std::move(it->second);
+  shard.extra_.erase(it);
+  return result;
 }
 
 void ClientJson::send(Slice request) {
   auto parsed_request = to_request(request);
   std::uint64_t extra_id = extra_id_.fetch_add(1, std::memory_order_relaxed);
   if (!parsed_request.second.empty()) {
-    std::lock_guard<std::mutex> guard(mutex_);
-    extra_[extra_id] = std::move(parsed_request.second);
+    extra_.add(extra_id, std::move(parsed_request.second));
   }
   client_.send(Client::Request{extra_id, std::move(parsed_request.first)});
 }
@@ -97,28 +176,22 @@ const char *ClientJson::receive(double timeout) {
 
   string extra;
   if (response.id != 0) {
-    std::lock_guard<std::mutex> guard(mutex_);
-    auto it = extra_.find(response.id);
-    if (it != extra_.end()) {
-      extra = std::move(it->second);
-      extra_.erase(it);
-    }
+    extra = extra_.extract(response.id);
   }
-  return store_string(from_response(*response.object, extra, 0));
+  return store_response(*response.object, extra, 0);
 }
 
 const char *ClientJson::execute(Slice request) {
   auto parsed_request = to_request(request);
-  return store_string(from_response(*Client::execute(Client::Request{0, std::move(parsed_request.first)}).object,
-                                    parsed_request.second, 0));
+  return store_response(*Client::execute(Client::Request{0, std::move(parsed_request.first)}).object,
+                        parsed_request.second, 0);
 }
 
 static ClientManager *get_manager() {
   return ClientManager::get_manager_singleton();
 }
 
-static std::mutex extra_mutex;
-static FlatHashMap<int64, string> extra;
+static ClientJsonExtraStorage extra;
 static std::atomic<uint64> extra_id{1};
 
 int json_create_client_id() {
@@ -129,8 +202,7 @@ void json_send(int client_id, Slice request) {
   auto parsed_request = to_request(request);
   auto request_id = extra_id.fetch_add(1, std::memory_order_relaxed);
   if (!parsed_request.second.empty()) {
-    std::lock_guard<std::mutex> guard(extra_mutex);
-    extra[request_id] = std::move(parsed_request.second);
+    extra.add(request_id, std::move(parsed_request.second));
   }
   get_manager()->send(client_id, request_id, std::move(parsed_request.first));
 }
@@ -143,20 +215,157 @@ const char *json_receive(double timeout) {
 
   string extra_str;
   if (response.request_id != 0) {
-    std::lock_guard<std::mutex> guard(extra_mutex);
-    auto it = extra.find(response.request_id);
-    if (it != extra.end()) {
-      extra_str = std::move(it->second);
-      extra.erase(it);
+    extra_str = extra.extract(response.request_id);
+  }
+  return store_response(*response.object, extra_str, response.client_id);
+}
+
+const char *json_receive_batch(double timeout, int max_count) {
+  if (max_count <= 0) {
+    return nullptr;
+  }
+  auto responses = get_manager()->receive_batch(timeout, static_cast<size_t>(max_count));
+  if (responses.empty()) {
+    return nullptr;
+  }
+
+  auto jb = create_output_builder();
+  auto &sb = jb.string_builder();
+  sb << '[';
+  bool is_first = true;
+  for (auto &response : responses) {
+    CHECK(response.object != nullptr);
+    string extra_str;
+    if (response.request_id != 0) {
+      extra_str = extra.extract(response.request_id);
     }
+    if (!is_first) {
+      sb << ',';
+    }
+    is_first = false;
+    append_response(jb, *response.object, extra_str, response.client_id);
   }
-  return store_string(from_response(*response.object, extra_str, response.client_id));
+  sb << ']';
+  return finish_output(jb);
+}
+
+ClientJsonSharedQueue::ClientJsonSharedQueue(SharedMemoryQueue &&queue) : queue_(std::move(queue)) {
+}
+
+bool ClientJsonSharedQueue::try_push(Slice response) {
+  // big responses and updates are pushed in parts; if only some of them fit, then the rest is pushed from pending_
+  return queue_.try_push(response);
+}
+
+int ClientJsonSharedQueue::flush_pending() {
+  int pushed_count = 0;
+  while (!pending_.empty() && try_push(pending_.front())) {
+    pending_.pop();
+    pushed_count++;
+  }
+  return pushed_count;
+}
+
+int ClientJsonSharedQueue::receive(double timeout, int max_count) {
+  auto pushed_count = flush_pending();
+  if (!pending_.empty() || pushed_count >= max_count) {
+    return pushed_count;
+  }
+
+  auto responses = get_manager()->receive_batch(timeout, static_cast<size_t>(max_count - pushed_count));
+  for (auto &response : responses) {
+    string extra_str;
+    if (response.request_id != 0) {
+      extra_str = extra.extract(response.request_id);
+    }
+    auto jb = create_output_builder();
+    append_response(jb, *response.object, extra_str, response.client_id);
+    auto json = jb.string_builder().as_cslice();
+    if (pending_.empty() && try_push(json)) {
+      pushed_count++;
+    } else {
+      pending_.push(json.str());
+    }
+  }
+  return pushed_count;
+}
+
+const char *ClientJsonSharedQueue::pop() {
+  init_thread_local<string>(current_output);
+  if (!queue_.try_pop(*current_output)) {
+    return nullptr;
+  }
+  return current_output->c_str();
 }
 
 const char *json_execute(Slice request) {
   auto parsed_request = to_request(request);
-  return store_string(
-      from_response(*ClientManager::execute(std::move(parsed_request.first)), parsed_request.second, 0));
+  return store_response(*ClientManager::execute(std::move(parsed_request.first)), parsed_request.second, 0);
+}
+
+// returns an error only if the request has no request identifier, to which an error response can be sent
+static Result<std::pair<uint64, td_api::object_ptr<td_api::Function>>> to_binary_request(Slice request) {
+  if (request.size() < sizeof(int64)) {
+    return Status::Error("Binary request is too short");
+  }
+  TlParser parser(request);
+  auto request_id = static_cast<uint64>(parser.fetch_long());
+  auto function = td_api::Function::fetch(parser);
+  parser.fetch_end();
+  if (parser.get_error() != nullptr) {
+    return std::make_pair(request_id, get_return_error_function(PSLICE() << "Failed to parse binary request: "
+                                                                         << parser.get_status().message()));
+  }
+  CHECK(function != nullptr);
+  return std::make_pair(request_id, std::move(function));
+}
+
+static Slice store_binary_response(const td_api::Object &object, uint64 request_id, int client_id) {
+  TlStorerCalcLength calc_length;
+  calc_length.store_int(client_id);
+  calc_length.store_long(static_cast<int64>(request_id));
+  calc_length.store_int(object.get_id());
+  object.store(calc_length);
+
+  init_thread_local<string>(current_output);
+  auto length = calc_length.get_length();
+  if (current_output->size() < length) {
+    current_output->resize(length);
+  }
+  auto data = MutableSlice(&(*current_output)[0], length);
+  TlStorerUnsafe storer(data.ubegin());
+  storer.store_int(client_id);
+  storer.store_long(static_cast<int64>(request_id));
+  storer.store_int(object.get_id());
+  object.store(storer);
+  CHECK(storer.get_buf() == data.uend());
+  return data;
+}
+
+void binary_send(int client_id, Slice request) {
+  auto r_parsed_request = to_binary_request(request);
+  if (r_parsed_request.is_error()) {
+    return;
+  }
+  auto parsed_request = r_parsed_request.move_as_ok();
+  get_manager()->send(client_id, parsed_request.first, std::move(parsed_request.second));
+}
+
+Slice binary_receive(double timeout) {
+  auto response = get_manager()->receive(timeout);
+  if (!response.object) {
+    return Slice();
+  }
+  return store_binary_response(*response.object, response.request_id, response.client_id);
+}
+
+Slice binary_execute(Slice request) {
+  auto r_parsed_request = to_binary_request(request);
+  if (r_parsed_request.is_error()) {
+    return Slice();
+  }
+  auto parsed_request = r_parsed_request.move_as_ok();
+  return store_binary_response(*ClientManager::execute(std::move(parsed_request.second)), parsed_request.first, 0);
 }
 
 }  // namespace td
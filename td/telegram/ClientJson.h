@@ -9,15 +9,42 @@
 #include "td/telegram/Client.h"
 
 #include "td/utils/FlatHashMap.h"
+#include "td/utils/port/platform.h"
+#include "td/utils/SharedMemoryQueue.h"
 #include "td/utils/Slice.h"
+#include "td/utils/VectorQueue.h"
 
+#include <array>
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <mutex>
 #include <string>
 
 namespace td {
 
+// stores "@extra" of sent requests until the corresponding responses are received
+class ClientJsonExtraStorage {
+ public:
+  void add(std::uint64_t request_id, std::string &&extra);
+
+  std::string extract(std::uint64_t request_id);
+
+ private:
+  // requests are sharded by their identifier to reduce contention between sender and receiver threads
+  static constexpr std::size_t SHARD_COUNT = 64;
+  struct Shard {
+    std::mutex mutex_;
+    FlatHashMap<std::uint64_t, std::string> extra_;
+    char padding_[TD_CONCURRENCY_PAD];
+  };
+  std::array<Shard, SHARD_COUNT> shards_;
+
+  Shard &get_shard(std::uint64_t request_id) {
+    return shards_[request_id % SHARD_COUNT];
+  }
+};
+
 // TODO can be removed in TDLib 2.0
 class ClientJson final {
  public:
@@ -29,17 +56,46 @@ class ClientJson final {
 
  private:
   Client client_;
-  std::mutex mutex_;  // for extra_
-  FlatHashMap<std::int64_t, std::string> extra_;
+  ClientJsonExtraStorage extra_;
   std::atomic<std::uint64_t> extra_id_{1};
 };
 
+// forwards JSON-serialized responses received through the shared ClientManager to another process
+class ClientJsonSharedQueue final {
+ public:
+  explicit ClientJsonSharedQueue(SharedMemoryQueue &&queue);
+
+  // producer side; returns the number of responses pushed to the queue
+  int receive(double timeout, int max_count);
+
+  // consumer side; returns nullptr if the queue is empty
+  const char *pop();
+
+ private:
+  SharedMemoryQueue queue_;
+  VectorQueue<std::string> pending_;  // responses which didn't fit in the queue yet
+
+  bool try_push(Slice response);
+
+  int flush_pending();
+};
+
 int json_create_client_id();
 
 void json_send(int client_id, Slice request);
 
 const char *json_receive(double timeout);
 
+const char *json_receive_batch(double timeout, int max_count);
+
 const char *json_execute(Slice request);
 
+// binary requests consist of a 64-bit request identifier followed by a boxed TL-serialized td_api::Function
+void binary_send(int client_id, Slice request);
+
+// binary responses consist of a 32-bit client identifier, a 64-bit request identifier and a boxed td_api::Object
+Slice binary_receive(double timeout);
+
+Slice binary_execute(Slice request);
+
 }  // namespace td
@@ -0,0 +1,76 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashSet.h"
+#include "td/utils/HashTableUtils.h"
+
+namespace td {
+
+// chooses objects, which can be removed from memory and reloaded from the database later,
+// and remembers them to be able to enumerate all known objects
+// an object must have a mutable field is_recently_used, which is set to true on every access
+template <class KeyT, class HashT = Hash<KeyT>>
+class ColdObjectEvictor {
+ public:
+  // no more than MAX_EVICTED_OBJECT_COUNT_MULTIPLIER * max_object_count objects are evicted at the same time
+  static constexpr size_t MAX_EVICTED_OBJECT_COUNT_MULTIPLIER = 10;
+
+  // returns keys of the objects to be removed from memory; they are considered evicted after the call
+  // objects, which weren't accessed since the previous call, are chosen first;
+  // for other objects the access flag is cleared to give them the second chance
+  template <class MapT, class CanEvictT>
+  vector<KeyT> evict(MapT &objects, size_t max_object_count, const CanEvictT &can_evict) {
+    auto object_count = objects.calc_size();
+    auto max_evicted_object_count = max_object_count * MAX_EVICTED_OBJECT_COUNT_MULTIPLIER;
+    if (object_count <= max_object_count || evicted_keys_.size() >= max_evicted_object_count) {
+      return {};
+    }
+
+    auto need_evict_count = min(object_count - max_object_count, max_evicted_object_count - evicted_keys_.size());
+    vector<KeyT> result;
+    objects.foreach([&](const KeyT &key, auto &object) {
+      if (result.size() < need_evict_count && !object->is_recently_used && can_evict(key, object.get())) {
+        result.push_back(key);
+      }
+      object->is_recently_used = false;
+    });
+    for (auto &key : result) {
+      evicted_keys_.insert(key);
+    }
+    return result;
+  }
+
+  bool is_evicted(const KeyT &key) const {
+    return !evicted_keys_.empty() && evicted_keys_.count(key) > 0;
+  }
+
+  // must be called when the object is loaded to memory again; returns true, if the object was evicted
+  bool on_load(const KeyT &key) {
+    return !evicted_keys_.empty() && evicted_keys_.erase(key) > 0;
+  }
+
+  size_t size() const {
+    return evicted_keys_.size();
+  }
+
+  template <class F>
+  void foreach(const F &f) const {
+    for (auto &key : evicted_keys_) {
+      f(key);
+    }
+  }
+
+ private:
+  FlatHashSet<KeyT, HashT> evicted_keys_;
+};
+
+template <class KeyT, class HashT>
+constexpr size_t ColdObjectEvictor<KeyT, HashT>::MAX_EVICTED_OBJECT_COUNT_MULTIPLIER;
+
+}  // namespace td
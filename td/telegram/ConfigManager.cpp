@@ -22,6 +22,7 @@
 #include "td/telegram/net/NetType.h"
 #include "td/telegram/net/PublicRsaKeySharedMain.h"
 #include "td/telegram/net/Session.h"
+#include "td/telegram/net/SharedNetConfig.h"
 #include "td/telegram/OptionManager.h"
 #include "td/telegram/Premium.h"
 #include "td/telegram/ReactionType.h"
@@ -928,6 +929,27 @@ void ConfigManager::request_config(bool reopen_sessions) {
     return;
   }
 
+  if (!reopen_sessions && use_shared_config()) {
+    auto value = SharedNetConfig::get_value(get_shared_config_key(), shared_config_version_);
+    switch (value.state) {
+      case SharedNetConfig::State::Ready:
+        if (apply_shared_config(std::move(value))) {
+          return;
+        }
+        break;
+      case SharedNetConfig::State::Pending:
+        // another client is requesting the same config; wait for its result
+        expire_time_ = Timestamp::in(1.0);
+        set_timeout_in(expire_time_.in());
+        return;
+      case SharedNetConfig::State::Absent:
+        is_shared_config_requested_ = true;
+        break;
+      default:
+        UNREACHABLE();
+    }
+  }
+
   lazy_request_flood_control_.add_event(Time::now());
   request_config_from_dc_impl(DcId::main(), reopen_sessions);
 }
@@ -1183,7 +1205,15 @@ void ConfigManager::on_result(NetQueryPtr net_query) {
   CHECK(token == 8 || token == 9);
   CHECK(config_sent_cnt_ > 0);
   config_sent_cnt_--;
-  auto r_config = fetch_result<telegram_api::help_getConfig>(std::move(net_query));
+  BufferSlice config_data;
+  Result<telegram_api::object_ptr<telegram_api::config>> r_config;
+  if (net_query->is_error()) {
+    r_config = net_query->move_as_error();
+  } else {
+    config_data = net_query->move_as_ok();
+    r_config = fetch_result<telegram_api::help_getConfig>(config_data);
+  }
+  on_shared_config_request_finished(std::move(config_data), r_config.is_ok() ? r_config.ok().get() : nullptr);
   if (r_config.is_error()) {
     if (!G()->close_flag()) {
       LOG(WARNING) << "Failed to get config: " << r_config.error();
@@ -1202,6 +1232,51 @@ void ConfigManager::on_result(NetQueryPtr net_query) {
   }
 }
 
+bool ConfigManager::use_shared_config() {
+  return G()->get_option_boolean("use_shared_network_config");
+}
+
+string ConfigManager::get_shared_config_key() {
+  // the config depends on the DC and on the parameters passed in initConnection
+  return PSTRING() << "config:" << G()->is_test_dc() << ':'
+                   << G()->net_query_dispatcher().get_main_dc_id().get_raw_id() << ':'
+                   << G()->mtproto_header().get_default_header();
+}
+
+bool ConfigManager::apply_shared_config(SharedNetConfig::Value value) {
+  CHECK(value.state == SharedNetConfig::State::Ready);
+  auto r_config = fetch_result<telegram_api::help_getConfig>(value.data);
+  if (r_config.is_error()) {
+    LOG(ERROR) << "Failed to parse shared config: " << r_config.error();
+    return false;
+  }
+  LOG(INFO) << "Use shared config of version " << value.version;
+  shared_config_version_ = value.version;
+  on_dc_options_update(DcOptions());
+  process_config(r_config.move_as_ok());
+
+  // the config expires simultaneously for all clients, so wait a little after the expiration to allow one of them
+  // to reload it for others
+  save_config_expire(Timestamp::at(value.expires_at));
+  expire_time_ = Timestamp::at(value.expires_at + Random::fast(0, 1000) * 0.001);
+  set_timeout_at(expire_time_.at());
+  return true;
+}
+
+void ConfigManager::on_shared_config_request_finished(BufferSlice config_data, const telegram_api::config *config) {
+  bool is_shared_config_requested = is_shared_config_requested_;
+  is_shared_config_requested_ = false;
+  if (config != nullptr && use_shared_config() &&
+      G()->net_query_dispatcher().get_main_dc_id().get_value() == config->this_dc_) {
+    auto expires_at = Time::now() + clamp(config->expires_ - config->date_, 60, 86400);
+    shared_config_version_ = SharedNetConfig::set_value(get_shared_config_key(), std::move(config_data), expires_at);
+    return;
+  }
+  if (is_shared_config_requested) {
+    SharedNetConfig::on_request_failed(get_shared_config_key());
+  }
+}
+
 void ConfigManager::save_dc_options_update(const DcOptions &dc_options) {
   if (dc_options.dc_options.empty()) {
     G()->td_db()->get_binlog_pmc()->erase("dc_options_update");
@@ -9,6 +9,7 @@
 #include "td/telegram/net/DcId.h"
 #include "td/telegram/net/DcOptions.h"
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/SharedNetConfig.h"
 #include "td/telegram/SuggestedAction.h"
 #include "td/telegram/td_api.h"
 #include "td/telegram/telegram_api.h"
@@ -104,6 +105,9 @@ class ConfigManager final : public NetQueryCallback {
   int ref_cnt_{1};
   Timestamp expire_time_;
 
+  int64 shared_config_version_ = 0;
+  bool is_shared_config_requested_ = false;
+
   FloodControlStrict lazy_request_flood_control_;
 
   vector<Promise<Unit>> reget_config_queries_;
@@ -135,6 +139,11 @@ class ConfigManager final : public NetQueryCallback {
   void request_config_from_dc_impl(DcId dc_id, bool reopen_sessions);
   void process_config(tl_object_ptr<telegram_api::config> config);
 
+  static bool use_shared_config();
+  static string get_shared_config_key();
+  bool apply_shared_config(SharedNetConfig::Value value);
+  void on_shared_config_request_finished(BufferSlice config_data, const telegram_api::config *config);
+
   void try_request_app_config();
 
   void process_app_config(telegram_api::object_ptr<telegram_api::JSONValue> &config);
@@ -0,0 +1,55 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/actor/actor.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Status.h"
+
+#include <memory>
+#include <utility>
+
+namespace td {
+
+// runs read-only database queries on its own scheduler, which has a separate SQLite connection
+template <class SyncDbSafeT, class SyncDbT>
+class DbReader final : public Actor {
+ public:
+  explicit DbReader(std::shared_ptr<SyncDbSafeT> sync_db_safe) : sync_db_safe_(std::move(sync_db_safe)) {
+  }
+
+  // f is called with SyncDbT * on the scheduler of the reader and must return T or Result<T>
+  template <class T, class F>
+  static void send_query(ActorId<DbReader> reader, Promise<T> &&promise, F &&f) {
+    send_closure(reader, &DbReader::run_query,
+                 PromiseCreator::lambda([promise = std::move(promise), f = std::forward<F>(f)](
+                                            Result<SyncDbT *> r_sync_db) mutable {
+                   if (r_sync_db.is_error()) {
+                     return promise.set_error(r_sync_db.move_as_error());
+                   }
+                   promise.set_result(f(r_sync_db.ok()));
+                 }));
+  }
+
+  void run_query(Promise<SyncDbT *> query) {
+    CHECK(sync_db_safe_ != nullptr);
+    query.set_value(&sync_db_safe_->get());
+  }
+
+  void close(Promise<Unit> promise) {
+    sync_db_safe_.reset();
+    promise.set_value(Unit());
+    stop();
+  }
+
+ private:
+  std::shared_ptr<SyncDbSafeT> sync_db_safe_;
+};
+
+}  // namespace td
@@ -17,27 +17,45 @@ void DelayDispatcher::send_with_callback(NetQueryPtr query, ActorShared<NetQuery
 
 void DelayDispatcher::send_with_callback_and_delay(NetQueryPtr query, ActorShared<NetQueryCallback> callback,
                                                    double delay) {
-  queue_.push({std::move(query), std::move(callback), delay});
+  auto priority = query->priority();
+  queues_[priority].push({std::move(query), std::move(callback), delay});
   loop();
 }
 
+DelayDispatcher::Query DelayDispatcher::pop_query() {
+  CHECK(!queues_.empty());
+  auto it = queues_.begin();
+  auto query = std::move(it->second.front());
+  it->second.pop();
+  if (it->second.empty()) {
+    queues_.erase(it);
+  }
+  return query;
+}
+
+template <class F>
+void DelayDispatcher::for_each_query(F &&f) {
+  while (!queues_.empty()) {
+    f(pop_query());
+  }
+}
+
 void DelayDispatcher::loop() {
   if (!wakeup_at_.is_in_past()) {
     set_timeout_at(wakeup_at_.at());
     return;
   }
 
-  if (queue_.empty()) {
+  if (queues_.empty()) {
     return;
   }
 
-  auto query = std::move(queue_.front());
-  queue_.pop();
+  auto query = pop_query();
   G()->net_query_dispatcher().dispatch_with_callback(std::move(query.net_query), std::move(query.callback));
 
   wakeup_at_ = Timestamp::in(query.delay);
 
-  if (queue_.empty()) {
+  if (queues_.empty()) {
     return;
   }
 
@@ -45,21 +63,15 @@ void DelayDispatcher::loop() {
 }
 
 void DelayDispatcher::close_silent() {
-  while (!queue_.empty()) {
-    auto query = std::move(queue_.front());
-    queue_.pop();
-    query.net_query->clear();
-  }
+  for_each_query([](Query &&query) { query.net_query->clear(); });
   stop();
 }
 
 void DelayDispatcher::tear_down() {
-  while (!queue_.empty()) {
-    auto query = std::move(queue_.front());
-    queue_.pop();
+  for_each_query([](Query &&query) {
     query.net_query->set_error(Global::request_aborted_error());
     send_closure(std::move(query.callback), &NetQueryCallback::on_result, std::move(query.net_query));
-  }
+  });
   parent_.reset();
 }
 
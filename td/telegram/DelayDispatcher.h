@@ -10,14 +10,19 @@
 
 #include "td/actor/actor.h"
 
+#include "td/utils/common.h"
 #include "td/utils/Time.h"
 
+#include <functional>
+#include <map>
 #include <queue>
 
 namespace td {
 
+// Queries with bigger NetQuery::priority() are sent first; queries with the same priority are sent in FIFO order
 class DelayDispatcher final : public Actor {
  public:
+  // sends queries one by one with the specified delay after each query
   DelayDispatcher(double default_delay, ActorShared<> parent)
       : default_delay_(default_delay), parent_(std::move(parent)) {
   }
@@ -33,11 +38,17 @@ class DelayDispatcher final : public Actor {
     ActorShared<NetQueryCallback> callback;
     double delay;
   };
-  std::queue<Query> queue_;
+  std::map<int32, std::queue<Query>, std::greater<int32>> queues_;  // priority -> queries
   Timestamp wakeup_at_;
   double default_delay_;
+
   ActorShared<> parent_;
 
+  Query pop_query();
+
+  template <class F>
+  void for_each_query(F &&f);
+
   void loop() final;
   void tear_down() final;
 };
@@ -6,6 +6,7 @@
 //
 #include "td/telegram/DialogDb.h"
 
+#include "td/telegram/DbReader.h"
 #include "td/telegram/Version.h"
 
 #include "td/db/SqliteConnectionSafe.h"
@@ -328,8 +329,8 @@ std::shared_ptr<DialogDbSyncSafeInterface> create_dialog_db_sync(
 
 class DialogDbAsync final : public DialogDbAsyncInterface {
  public:
-  DialogDbAsync(std::shared_ptr<DialogDbSyncSafeInterface> sync_db, int32 scheduler_id) {
-    impl_ = create_actor_on_scheduler<Impl>("DialogDbActor", scheduler_id, std::move(sync_db));
+  DialogDbAsync(std::shared_ptr<DialogDbSyncSafeInterface> sync_db, int32 scheduler_id, int32 read_scheduler_id) {
+    impl_ = create_actor_on_scheduler<Impl>("DialogDbActor", scheduler_id, std::move(sync_db), read_scheduler_id);
   }
 
   void add_dialog(DialogId dialog_id, FolderId folder_id, int64 order, BufferSlice data,
@@ -370,9 +371,12 @@ class DialogDbAsync final : public DialogDbAsyncInterface {
   }
 
  private:
+  using Reader = DbReader<DialogDbSyncSafeInterface, DialogDbSyncInterface>;
+
   class Impl final : public Actor {
    public:
-    explicit Impl(std::shared_ptr<DialogDbSyncSafeInterface> sync_db_safe) : sync_db_safe_(std::move(sync_db_safe)) {
+    Impl(std::shared_ptr<DialogDbSyncSafeInterface> sync_db_safe, int32 read_scheduler_id)
+        : sync_db_safe_(std::move(sync_db_safe)), read_scheduler_id_(read_scheduler_id) {
     }
 
     void add_dialog(DialogId dialog_id, FolderId folder_id, int64 order, BufferSlice data,
@@ -412,15 +416,20 @@ class DialogDbAsync final : public DialogDbAsyncInterface {
 
     void get_dialogs(FolderId folder_id, int64 order, DialogId dialog_id, int32 limit,
                      Promise<DialogDbGetDialogsResult> promise) {
-      add_read_query();
-      promise.set_value(sync_db_->get_dialogs(folder_id, order, dialog_id, limit));
+      add_long_read_query(std::move(promise), [folder_id, order, dialog_id, limit](DialogDbSyncInterface *sync_db) {
+        return sync_db->get_dialogs(folder_id, order, dialog_id, limit);
+      });
     }
 
     void close(Promise<Unit> promise) {
       do_flush();
       sync_db_safe_.reset();
       sync_db_ = nullptr;
-      promise.set_value(Unit());
+      if (reader_.empty()) {
+        promise.set_value(Unit());
+      } else {
+        send_closure(reader_, &Reader::close, std::move(promise));
+      }
       stop();
     }
 
@@ -432,6 +441,8 @@ class DialogDbAsync final : public DialogDbAsyncInterface {
    private:
     std::shared_ptr<DialogDbSyncSafeInterface> sync_db_safe_;
     DialogDbSyncInterface *sync_db_ = nullptr;
+    int32 read_scheduler_id_ = -1;
+    ActorOwn<Reader> reader_;
 
     static constexpr size_t MAX_PENDING_QUERIES_COUNT{50};
     static constexpr double MAX_PENDING_QUERIES_DELAY{0.01};
@@ -459,6 +470,16 @@ class DialogDbAsync final : public DialogDbAsyncInterface {
       do_flush();
     }
 
+    // the query is run by the reader, if any, after all previous writes are committed
+    template <class T, class F>
+    void add_long_read_query(Promise<T> &&promise, F &&f) {
+      do_flush();
+      if (reader_.empty()) {
+        return promise.set_result(f(sync_db_));
+      }
+      Reader::send_query(reader_.get(), std::move(promise), std::forward<F>(f));
+    }
+
     void do_flush() {
       if (pending_writes_.empty()) {
         return;
@@ -476,14 +497,17 @@ class DialogDbAsync final : public DialogDbAsyncInterface {
 
     void start_up() final {
       sync_db_ = &sync_db_safe_->get();
+      if (read_scheduler_id_ != -1) {
+        reader_ = create_actor_on_scheduler<Reader>("DialogDbReader", read_scheduler_id_, sync_db_safe_);
+      }
     }
   };
   ActorOwn<Impl> impl_;
 };
 
 std::shared_ptr<DialogDbAsyncInterface> create_dialog_db_async(std::shared_ptr<DialogDbSyncSafeInterface> sync_db,
-                                                               int32 scheduler_id) {
-  return std::make_shared<DialogDbAsync>(std::move(sync_db), scheduler_id);
+                                                               int32 scheduler_id, int32 read_scheduler_id) {
+  return std::make_shared<DialogDbAsync>(std::move(sync_db), scheduler_id, read_scheduler_id);
 }
 
 }  // namespace td
@@ -104,7 +104,8 @@ Status drop_dialog_db(SqliteDb &db, int version) TD_WARN_UNUSED_RESULT;
 std::shared_ptr<DialogDbSyncSafeInterface> create_dialog_db_sync(
     std::shared_ptr<SqliteConnectionSafe> sqlite_connection);
 
+// long read-only queries are run on read_scheduler_id if it isn't -1
 std::shared_ptr<DialogDbAsyncInterface> create_dialog_db_async(std::shared_ptr<DialogDbSyncSafeInterface> sync_db,
-                                                               int32 scheduler_id = -1);
+                                                               int32 scheduler_id = -1, int32 read_scheduler_id = -1);
 
 }  // namespace td
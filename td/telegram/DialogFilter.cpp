@@ -757,7 +757,7 @@ vector<FolderId> DialogFilter::get_folder_ids() const {
   return {FolderId::main(), FolderId::archive()};
 }
 
-bool DialogFilter::need_dialog(const Td *td, const DialogFilterDialogInfo &dialog_info) const {
+bool DialogFilter::need_dialog(const DialogFilterDialogInfo &dialog_info) const {
   auto dialog_id = dialog_info.dialog_id_;
   if (is_dialog_included(dialog_id)) {
     return true;
@@ -765,16 +765,13 @@ bool DialogFilter::need_dialog(const Td *td, const DialogFilterDialogInfo &dialo
   if (InputDialogId::contains(excluded_dialog_ids_, dialog_id)) {
     return false;
   }
-  if (dialog_id.get_type() == DialogType::SecretChat) {
-    auto user_id = td->user_manager_->get_secret_chat_user_id(dialog_id.get_secret_chat_id());
-    if (user_id.is_valid()) {
-      auto user_dialog_id = DialogId(user_id);
-      if (is_dialog_included(user_dialog_id)) {
-        return true;
-      }
-      if (InputDialogId::contains(excluded_dialog_ids_, user_dialog_id)) {
-        return false;
-      }
+  auto user_dialog_id = dialog_info.secret_chat_user_dialog_id_;
+  if (user_dialog_id.is_valid()) {
+    if (is_dialog_included(user_dialog_id)) {
+      return true;
+    }
+    if (InputDialogId::contains(excluded_dialog_ids_, user_dialog_id)) {
+      return false;
     }
   }
   if (!dialog_info.has_unread_mentions_) {
@@ -789,30 +786,19 @@ bool DialogFilter::need_dialog(const Td *td, const DialogFilterDialogInfo &dialo
     return false;
   }
   switch (dialog_id.get_type()) {
-    case DialogType::User: {
-      auto user_id = dialog_id.get_user_id();
-      if (td->user_manager_->is_user_bot(user_id)) {
+    case DialogType::User:
+    case DialogType::SecretChat:
+      if (dialog_info.is_bot_) {
         return include_bots_;
       }
-      if (user_id == td->user_manager_->get_my_id() || td->user_manager_->is_user_contact(user_id)) {
+      if (dialog_info.is_contact_) {
         return include_contacts_;
       }
       return include_non_contacts_;
-    }
     case DialogType::Chat:
       return include_groups_;
     case DialogType::Channel:
-      return td->chat_manager_->is_broadcast_channel(dialog_id.get_channel_id()) ? include_channels_ : include_groups_;
-    case DialogType::SecretChat: {
-      auto user_id = td->user_manager_->get_secret_chat_user_id(dialog_id.get_secret_chat_id());
-      if (td->user_manager_->is_user_bot(user_id)) {
-        return include_bots_;
-      }
-      if (td->user_manager_->is_user_contact(user_id)) {
-        return include_contacts_;
-      }
-      return include_non_contacts_;
-    }
+      return dialog_info.is_broadcast_ ? include_channels_ : include_groups_;
     default:
       UNREACHABLE();
       return false;
@@ -100,7 +100,7 @@ class DialogFilter {
 
   vector<FolderId> get_folder_ids() const;
 
-  bool need_dialog(const Td *td, const DialogFilterDialogInfo &dialog_info) const;
+  bool need_dialog(const DialogFilterDialogInfo &dialog_info) const;
 
   static vector<DialogFilterId> get_dialog_filter_ids(const vector<unique_ptr<DialogFilter>> &dialog_filters,
                                                       int32 main_dialog_list_position);
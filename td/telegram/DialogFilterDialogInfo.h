@@ -19,6 +19,12 @@ struct DialogFilterDialogInfo {
   bool has_unread_mentions_ = false;
   bool is_muted_ = false;
   bool has_unread_messages_ = false;
+
+  // chat type-dependent facts, which are calculated once for all chat folders
+  DialogId secret_chat_user_dialog_id_;
+  bool is_bot_ = false;
+  bool is_contact_ = false;
+  bool is_broadcast_ = false;
 };
 
 }  // namespace td
@@ -761,7 +761,7 @@ bool DialogFilterManager::need_dialog_in_filter(DialogFilterId dialog_filter_id,
                                                 const DialogFilterDialogInfo &dialog_info) const {
   const auto *dialog_filter = get_dialog_filter(dialog_filter_id);
   CHECK(dialog_filter != nullptr);
-  return dialog_filter->need_dialog(td_, dialog_info);
+  return dialog_filter->need_dialog(dialog_info);
 }
 
 bool DialogFilterManager::is_dialog_pinned(DialogFilterId dialog_filter_id, DialogId dialog_id) const {
@@ -0,0 +1,49 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/DialogListPrefetch.h"
+
+#include "td/utils/logging.h"
+
+namespace td {
+
+DialogListPrefetch::RequestResult DialogListPrefetch::on_request(DialogDate offset, double now,
+                                                                 Promise<Unit> &promise) {
+  if (offset != offset_) {
+    return RequestResult::Miss;
+  }
+  if (page_ == nullptr) {
+    if (!waiting_promise_) {
+      waiting_promise_ = std::move(promise);
+    } else {
+      // the same page is requested again; both requests wait for it
+      waiting_promise_ = PromiseCreator::lambda([first_promise = std::move(waiting_promise_),
+                                                 second_promise = std::move(promise)](Result<Unit> result) mutable {
+        if (result.is_error()) {
+          first_promise.set_error(result.error().clone());
+          second_promise.set_error(result.move_as_error());
+        } else {
+          first_promise.set_value(Unit());
+          second_promise.set_value(Unit());
+        }
+      });
+    }
+    return RequestResult::Wait;
+  }
+  if (receive_time_ <= now - EXPIRE_TIME) {
+    return RequestResult::Miss;
+  }
+  return RequestResult::UsePage;
+}
+
+void DialogListPrefetch::set_page(Page &&page, double now) {
+  CHECK(page != nullptr);
+  CHECK(!waiting_promise_);
+  page_ = std::move(page);
+  receive_time_ = now;
+}
+
+}  // namespace td
@@ -0,0 +1,61 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/DialogDate.h"
+#include "td/telegram/telegram_api.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Promise.h"
+
+namespace td {
+
+// the next page of a chat list, which is requested while the previous page is being processed
+class DialogListPrefetch {
+ public:
+  using Page = telegram_api::object_ptr<telegram_api::messages_Dialogs>;
+
+  static constexpr double EXPIRE_TIME = 5.0;  // seconds
+
+  enum class RequestResult : int32 { Wait, UsePage, Miss };
+
+  explicit DialogListPrefetch(DialogDate offset) : offset_(offset) {
+  }
+
+  DialogDate get_offset() const {
+    return offset_;
+  }
+
+  bool is_received() const {
+    return page_ != nullptr;
+  }
+
+  // tries to answer a request of the page with the given offset:
+  // Wait - the page isn't received yet, and the promise was moved to wait for it;
+  // UsePage - the page was received recently and must be extracted by the caller;
+  // Miss - the prefetched page can't be used for the request
+  RequestResult on_request(DialogDate offset, double now, Promise<Unit> &promise);
+
+  // returns promise of the requests waiting for the page, which were combined into one
+  Promise<Unit> extract_waiting_promise() {
+    return std::move(waiting_promise_);
+  }
+
+  void set_page(Page &&page, double now);
+
+  Page extract_page() {
+    return std::move(page_);
+  }
+
+ private:
+  DialogDate offset_ = MIN_DIALOG_DATE;
+  Page page_;
+  double receive_time_ = 0.0;
+  Promise<Unit> waiting_promise_;
+};
+
+}  // namespace td
@@ -276,7 +276,13 @@ class DownloadManagerImpl final : public DownloadManager {
 
   void update_file_download_state(FileId internal_file_id, int64 downloaded_size, int64 size, int64 expected_size,
                                   bool is_paused) final {
-    if (!callback_ || !is_database_loaded_) {
+    if (!callback_) {
+      return;
+    }
+    if (on_prefetched_file_download_state(internal_file_id, downloaded_size, size, is_paused)) {
+      return;
+    }
+    if (!is_database_loaded_) {
       return;
     }
     LOG(INFO) << "Update file download state for file " << internal_file_id << " of size " << size << '/'
@@ -321,6 +327,46 @@ class DownloadManagerImpl final : public DownloadManager {
     on_file_viewed(file_info.download_id);
   }
 
+  void prefetch_files(DialogId dialog_id, vector<FileId> file_ids) final {
+    if (!callback_ || G()->close_flag()) {
+      return;
+    }
+
+    auto &prefetched_files = prefetched_files_[dialog_id];
+    vector<PrefetchedFile> new_prefetched_files;
+    for (auto &prefetched_file : prefetched_files) {
+      if (td::contains(file_ids, prefetched_file.file_id)) {
+        new_prefetched_files.push_back(prefetched_file);
+      } else {
+        LOG(INFO) << "Cancel prefetching of file " << prefetched_file.file_id << " in " << dialog_id;
+        forget_prefetched_file(prefetched_file.internal_file_id);
+      }
+    }
+    for (auto file_id : file_ids) {
+      if (std::any_of(
+              new_prefetched_files.begin(), new_prefetched_files.end(),
+              [file_id](const PrefetchedFile &prefetched_file) { return prefetched_file.file_id == file_id; })) {
+        continue;
+      }
+      LOG(INFO) << "Prefetch file " << file_id << " in " << dialog_id;
+      PrefetchedFile prefetched_file;
+      prefetched_file.file_id = file_id;
+      prefetched_file.internal_file_id = callback_->dup_file_id(file_id);
+      if (!prefetched_file.internal_file_id.is_valid()) {
+        continue;
+      }
+      prefetched_file_dialog_ids_[prefetched_file.internal_file_id] = dialog_id;
+      callback_->start_file(prefetched_file.internal_file_id, FileManager::BACKGROUND_DOWNLOAD_PRIORITY,
+                            actor_shared(this, ++last_link_token_));
+      new_prefetched_files.push_back(prefetched_file);
+    }
+    if (new_prefetched_files.empty()) {
+      prefetched_files_.erase(dialog_id);
+    } else {
+      prefetched_files = std::move(new_prefetched_files);
+    }
+  }
+
  private:
   unique_ptr<Callback> callback_;
   struct FileInfo {
@@ -344,6 +390,13 @@ class DownloadManagerImpl final : public DownloadManager {
   FlatHashMap<FileId, int64, FileIdHash> by_file_id_;
   FlatHashMap<FileId, int64, FileIdHash> by_internal_file_id_;
   FlatHashMap<int64, unique_ptr<FileInfo>> files_;
+
+  struct PrefetchedFile {
+    FileId file_id;
+    FileId internal_file_id;
+  };
+  FlatHashMap<DialogId, vector<PrefetchedFile>, DialogIdHash> prefetched_files_;
+  FlatHashMap<FileId, DialogId, FileIdHash> prefetched_file_dialog_ids_;
   std::set<int64> completed_download_ids_;
   FlatHashSet<int64> unviewed_completed_download_ids_;
   Hints hints_;
@@ -601,6 +654,38 @@ class DownloadManagerImpl final : public DownloadManager {
     return Status::OK();
   }
 
+  bool on_prefetched_file_download_state(FileId internal_file_id, int64 downloaded_size, int64 size, bool is_paused) {
+    auto it = prefetched_file_dialog_ids_.find(internal_file_id);
+    if (it == prefetched_file_dialog_ids_.end()) {
+      return false;
+    }
+    if (!is_paused && (size == 0 || downloaded_size != size)) {
+      return true;
+    }
+
+    // the file was downloaded or the download has failed
+    auto dialog_id = it->second;
+    LOG(INFO) << "Finish prefetching of file " << internal_file_id << " in " << dialog_id;
+    auto prefetched_files_it = prefetched_files_.find(dialog_id);
+    CHECK(prefetched_files_it != prefetched_files_.end());
+    auto &prefetched_files = prefetched_files_it->second;
+    td::remove_if(prefetched_files, [internal_file_id](const PrefetchedFile &prefetched_file) {
+      return prefetched_file.internal_file_id == internal_file_id;
+    });
+    if (prefetched_files.empty()) {
+      prefetched_files_.erase(prefetched_files_it);
+    }
+    forget_prefetched_file(internal_file_id);
+    return true;
+  }
+
+  void forget_prefetched_file(FileId internal_file_id) {
+    bool is_erased = prefetched_file_dialog_ids_.erase(internal_file_id) > 0;
+    CHECK(is_erased);
+    // the download is stopped before the file identifier is forgotten
+    callback_->forget_dup_file_id(internal_file_id);
+  }
+
   void timeout_expired() final {
     clear_counters();
   }
@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/telegram/DialogId.h"
 #include "td/telegram/files/FileId.h"
 #include "td/telegram/files/FileManager.h"
 #include "td/telegram/files/FileSourceId.h"
@@ -71,6 +72,7 @@ class DownloadManager : public Actor {
     virtual void pause_file(FileId file_id) = 0;
     virtual void delete_file(FileId file_id) = 0;
     virtual FileId dup_file_id(FileId file_id) = 0;
+    virtual void forget_dup_file_id(FileId file_id) = 0;
 
     virtual void get_file_search_text(FileId file_id, FileSourceId file_source_id, Promise<string> &&promise) = 0;
 
@@ -107,6 +109,10 @@ class DownloadManager : public Actor {
   virtual void update_file_download_state(FileId internal_file_id, int64 downloaded_size, int64 size,
                                           int64 expected_size, bool is_paused) = 0;
   virtual void update_file_viewed(FileId file_id, FileSourceId file_source_id) = 0;
+
+  // downloads the files at the lowest priority without adding them to the download list;
+  // prefetching of the files previously passed for the chat, which aren't in the list, is cancelled
+  virtual void prefetch_files(DialogId dialog_id, vector<FileId> file_ids) = 0;
 };
 
 }  // namespace td
@@ -66,6 +66,10 @@ FileId DownloadManagerCallback::dup_file_id(FileId file_id) {
   return td_->file_manager_->dup_file_id(file_id, "DownloadManagerCallback");
 }
 
+void DownloadManagerCallback::forget_dup_file_id(FileId file_id) {
+  send_closure_later(td_->file_manager_actor_, &FileManager::forget_dup_file_id, file_id, "DownloadManagerCallback");
+}
+
 void DownloadManagerCallback::get_file_search_text(FileId file_id, FileSourceId file_source_id,
                                                    Promise<string> &&promise) {
   send_closure(td_->file_reference_manager_actor_, &FileReferenceManager::get_file_search_text, file_source_id,
@@ -46,6 +46,8 @@ class DownloadManagerCallback final : public DownloadManager::Callback {
 
   FileId dup_file_id(FileId file_id) final;
 
+  void forget_dup_file_id(FileId file_id) final;
+
   void get_file_search_text(FileId file_id, FileSourceId file_source_id, Promise<string> &&promise) final;
 
   FileView get_sync_file_view(FileId file_id) final;
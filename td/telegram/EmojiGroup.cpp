@@ -14,6 +14,8 @@
 
 namespace td {
 
+static constexpr double EMOJI_GROUP_LIST_RELOAD_PERIOD = 3600.0;
+
 EmojiGroup::EmojiGroup(telegram_api::object_ptr<telegram_api::EmojiGroup> &&emoji_group_ptr) {
   switch (emoji_group_ptr->get_id()) {
     case telegram_api::emojiGroup::ID: {
@@ -64,7 +66,7 @@ EmojiGroupList::EmojiGroupList(string used_language_codes, int32 hash,
                               [](telegram_api::object_ptr<telegram_api::EmojiGroup> &&emoji_group) {
                                 return EmojiGroup(std::move(emoji_group));
                               }))
-    , next_reload_time_(Time::now() + 3600) {
+    , next_reload_time_(Time::now() + EMOJI_GROUP_LIST_RELOAD_PERIOD) {
 }
 
 td_api::object_ptr<td_api::emojiCategories> EmojiGroupList::get_emoji_categories_object(
@@ -87,7 +89,11 @@ bool EmojiGroupList::is_expired() const {
 }
 
 void EmojiGroupList::update_next_reload_time() {
-  next_reload_time_ = Time::now() + 3600;
+  next_reload_time_ = Time::now() + EMOJI_GROUP_LIST_RELOAD_PERIOD;
+}
+
+void EmojiGroupList::set_receive_time(double receive_time) {
+  next_reload_time_ = receive_time + EMOJI_GROUP_LIST_RELOAD_PERIOD;
 }
 
 vector<CustomEmojiId> EmojiGroupList::get_icon_custom_emoji_ids() const {
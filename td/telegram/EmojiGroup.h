@@ -67,6 +67,9 @@ class EmojiGroupList {
 
   void update_next_reload_time();
 
+  // must be called for lists received by another client
+  void set_receive_time(double receive_time);
+
   vector<CustomEmojiId> get_icon_custom_emoji_ids() const;
 
   template <class StorerT>
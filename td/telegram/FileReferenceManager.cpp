@@ -325,13 +325,24 @@ void FileReferenceManager::send_query(Destination dest, FileSourceId file_source
     send_closure(file_manager_actor_id, &FileManager::on_file_reference_repaired, dest.node_id, file_source_id,
                  std::move(result), std::move(new_promise));
   });
+  send_file_source_query(file_source_id, std::move(promise));
+}
+
+void FileReferenceManager::send_file_source_query(FileSourceId file_source_id, Promise<Unit> promise) {
+  auto &promises = file_source_query_promises_[file_source_id];
+  promises.push_back(std::move(promise));
+  if (promises.size() > 1) {
+    VLOG(file_references) << "Wait for the running repair query from " << file_source_id;
+    return;
+  }
+  promise = PromiseCreator::lambda([actor_id = actor_id(this), file_source_id](Result<Unit> result) {
+    send_closure(actor_id, &FileReferenceManager::on_file_source_query_result, file_source_id, std::move(result));
+  });
+
   auto index = static_cast<size_t>(file_source_id.get()) - 1;
   CHECK(index < file_sources_.size());
   file_sources_[index].visit(overloaded(
-      [&](const FileSourceMessage &source) {
-        send_closure_later(G()->messages_manager(), &MessagesManager::get_message_from_server, source.message_full_id,
-                           std::move(promise), "FileSourceMessage", nullptr);
-      },
+      [&](const FileSourceMessage &source) { get_message_from_server(source.message_full_id, std::move(promise)); },
       [&](const FileSourceUserPhoto &source) {
         send_closure_later(G()->user_manager(), &UserManager::reload_user_profile_photo, source.user_id,
                            source.photo_id, std::move(promise));
@@ -411,6 +422,54 @@ void FileReferenceManager::send_query(Destination dest, FileSourceId file_source
       }));
 }
 
+void FileReferenceManager::on_file_source_query_result(FileSourceId file_source_id, Result<Unit> result) {
+  auto it = file_source_query_promises_.find(file_source_id);
+  CHECK(it != file_source_query_promises_.end());
+  auto promises = std::move(it->second);
+  file_source_query_promises_.erase(it);
+
+  for (auto &promise : promises) {
+    if (result.is_ok()) {
+      promise.set_value(Unit());
+    } else {
+      promise.set_error(result.error().clone());
+    }
+  }
+}
+
+void FileReferenceManager::get_message_from_server(MessageFullId message_full_id, Promise<Unit> promise) {
+  pending_message_full_ids_.push_back(message_full_id);
+  pending_message_promises_.push_back(std::move(promise));
+  if (pending_message_full_ids_.size() == 1) {
+    // wait for other repair requests, which are already in the queue
+    send_closure_later(actor_id(this), &FileReferenceManager::flush_pending_messages);
+  }
+}
+
+void FileReferenceManager::flush_pending_messages() {
+  auto message_full_ids = std::move(pending_message_full_ids_);
+  auto promises = std::move(pending_message_promises_);
+  reset_to_empty(pending_message_full_ids_);
+  reset_to_empty(pending_message_promises_);
+  if (message_full_ids.empty()) {
+    return;
+  }
+
+  VLOG(file_references) << "Get " << message_full_ids.size() << " messages to repair file references";
+  constexpr size_t MAX_MESSAGE_BATCH_SIZE = 100;
+  get_messages_in_batches(std::move(message_full_ids), std::move(promises), MAX_MESSAGE_BATCH_SIZE,
+                          [](vector<MessageFullId> message_full_ids, Promise<Unit> promise) {
+                            if (message_full_ids.size() == 1) {
+                              send_closure_later(G()->messages_manager(), &MessagesManager::get_message_from_server,
+                                                 message_full_ids[0], std::move(promise), "FileSourceMessage", nullptr);
+                            } else {
+                              send_closure_later(G()->messages_manager(), &MessagesManager::get_messages_from_server,
+                                                 std::move(message_full_ids), std::move(promise),
+                                                 "FileSourceMessages", nullptr);
+                            }
+                          });
+}
+
 FileReferenceManager::Destination FileReferenceManager::on_query_result(Destination dest, FileSourceId file_source_id,
                                                                         Status status, int32 sub) {
   if (G()->close_flag()) {
@@ -23,6 +23,7 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
@@ -80,6 +81,43 @@ class FileReferenceManager final : public Actor {
 
   static void reload_photo(PhotoSizeSource source, Promise<Unit> promise);
 
+  // requests the messages through get_messages in batches of at most max_batch_size messages;
+  // messages from a failed batch are requested one by one, so an inaccessible message can't affect others
+  template <class GetMessagesT>
+  static void get_messages_in_batches(vector<MessageFullId> message_full_ids, vector<Promise<Unit>> promises,
+                                      size_t max_batch_size, GetMessagesT get_messages) {
+    CHECK(message_full_ids.size() == promises.size());
+    CHECK(max_batch_size > 0);
+    for (size_t i = 0; i < message_full_ids.size(); i += max_batch_size) {
+      auto end = min(i + max_batch_size, message_full_ids.size());
+      vector<MessageFullId> batch_message_full_ids(message_full_ids.begin() + i, message_full_ids.begin() + end);
+      vector<Promise<Unit>> batch_promises;
+      for (size_t j = i; j < end; j++) {
+        batch_promises.push_back(std::move(promises[j]));
+      }
+      if (batch_promises.size() == 1) {
+        get_messages(std::move(batch_message_full_ids), std::move(batch_promises[0]));
+        continue;
+      }
+
+      auto promise = PromiseCreator::lambda([message_full_ids = batch_message_full_ids,
+                                             promises = std::move(batch_promises),
+                                             get_messages](Result<Unit> result) mutable {
+        if (result.is_ok()) {
+          for (auto &promise : promises) {
+            promise.set_value(Unit());
+          }
+          return;
+        }
+
+        for (size_t j = 0; j < promises.size(); j++) {
+          get_messages(vector<MessageFullId>{message_full_ids[j]}, std::move(promises[j]));
+        }
+      });
+      get_messages(std::move(batch_message_full_ids), std::move(promise));
+    }
+  }
+
   bool add_file_source(NodeId node_id, FileSourceId file_source_id);
 
   vector<FileSourceId> get_some_file_sources(NodeId node_id);
@@ -200,12 +238,23 @@ class FileReferenceManager final : public Actor {
 
   WaitFreeHashMap<NodeId, unique_ptr<Node>, FileIdHash> nodes_;
 
+  // promises of running repair queries for each file source, which are shared between all files from the source
+  FlatHashMap<FileSourceId, vector<Promise<Unit>>, FileSourceIdHash> file_source_query_promises_;
+
+  // messages, which will be requested from the server together
+  vector<MessageFullId> pending_message_full_ids_;
+  vector<Promise<Unit>> pending_message_promises_;  // promises for the corresponding pending_message_full_ids_
+
   ActorShared<> parent_;
 
   Node &add_node(NodeId node_id);
 
   void run_node(NodeId node);
   void send_query(Destination dest, FileSourceId file_source_id);
+  void send_file_source_query(FileSourceId file_source_id, Promise<Unit> promise);
+  void on_file_source_query_result(FileSourceId file_source_id, Result<Unit> result);
+  void get_message_from_server(MessageFullId message_full_id, Promise<Unit> promise);
+  void flush_pending_messages();
   Destination on_query_result(Destination dest, FileSourceId file_source_id, Status status, int32 sub = 0);
 
   template <class T>
@@ -31,6 +31,16 @@ Global::Global() {
   database_scheduler_id_ = min(current_scheduler_id + 1, max_scheduler_id);
   gc_scheduler_id_ = min(current_scheduler_id + 2, max_scheduler_id);
   slow_net_scheduler_id_ = min(current_scheduler_id + 3, max_scheduler_id);
+  if (current_scheduler_id + 4 <= max_scheduler_id) {
+    file_io_scheduler_id_ = current_scheduler_id + 4;
+    // the file I/O scheduler is shared with cryptography only if there are no other additional threads
+    first_crypto_scheduler_id_ = min(current_scheduler_id + 5, max_scheduler_id);
+    crypto_scheduler_count_ = max_scheduler_id - first_crypto_scheduler_id_ + 1;
+  } else {
+    file_io_scheduler_id_ = slow_net_scheduler_id_;
+    first_crypto_scheduler_id_ = slow_net_scheduler_id_;
+    crypto_scheduler_count_ = 1;
+  }
 }
 
 Global::~Global() = default;
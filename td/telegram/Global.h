@@ -60,6 +60,7 @@ class LinkManager;
 class MessageImportManager;
 class MessagesManager;
 class NetQueryDispatcher;
+class NetRequestStats;
 class NotificationManager;
 class NotificationSettingsManager;
 class OptionManager;
@@ -561,10 +562,31 @@ class Global final : public ActorContext {
     return gc_scheduler_id_;
   }
 
+  // returns scheduler for long read-only database queries, or -1 if they must be run on the database scheduler
+  int32 get_database_read_scheduler_id() const {
+    return gc_scheduler_id_ != database_scheduler_id_ ? gc_scheduler_id_ : -1;
+  }
+
   int32 get_slow_net_scheduler_id() const {
     return slow_net_scheduler_id_;
   }
 
+  // returns scheduler for blocking writes of downloaded file parts; the first additional thread after the first three
+  // is used for it if available, otherwise the slow net scheduler, on which files are loaded, is used
+  int32 get_file_io_scheduler_id() const {
+    return file_io_scheduler_id_;
+  }
+
+  // returns one of the schedulers for CPU-heavy handshake cryptography; additional threads after the file I/O scheduler
+  // are used for it if available, otherwise the file I/O or the slow net scheduler is used
+  int32 get_crypto_scheduler_id() {
+    if (crypto_scheduler_count_ <= 1) {
+      return first_crypto_scheduler_id_;
+    }
+    auto pos = next_crypto_scheduler_pos_.fetch_add(1, std::memory_order_relaxed);
+    return first_crypto_scheduler_id_ + static_cast<int32>(pos % static_cast<uint32>(crypto_scheduler_count_));
+  }
+
   DcId get_webfile_dc_id() const;
 
   std::shared_ptr<DhConfig> get_dh_config() {
@@ -587,7 +609,8 @@ class Global final : public ActorContext {
   }
 
   static Status request_aborted_error() {
-    return Status::Error(500, "Request aborted");
+    static const Status error = Status::StaticError(500, "Request aborted");
+    return error.clone();
   }
 
   template <class T>
@@ -634,6 +657,13 @@ class Global final : public ActorContext {
     net_stats_file_callbacks_ = std::move(callbacks);
   }
 
+  NetRequestStats *get_net_request_stats() const {
+    return net_request_stats_.get();
+  }
+  void set_net_request_stats(std::shared_ptr<NetRequestStats> request_stats) {
+    net_request_stats_ = std::move(request_stats);
+  }
+
   int64 get_location_access_hash(double latitude, double longitude);
 
   void add_location_access_hash(double latitude, double longitude, int64 access_hash);
@@ -708,6 +738,10 @@ class Global final : public ActorContext {
   int32 database_scheduler_id_ = 0;
   int32 gc_scheduler_id_ = 0;
   int32 slow_net_scheduler_id_ = 0;
+  int32 file_io_scheduler_id_ = 0;
+  int32 first_crypto_scheduler_id_ = 0;
+  int32 crypto_scheduler_count_ = 1;
+  std::atomic<uint32> next_crypto_scheduler_pos_{0};
 
   std::atomic<bool> store_all_files_in_files_directory_{false};
 
@@ -725,6 +759,7 @@ class Global final : public ActorContext {
 #endif
 
   std::vector<std::shared_ptr<NetStatsCallback>> net_stats_file_callbacks_;
+  std::shared_ptr<NetRequestStats> net_request_stats_;
 
   ActorId<StateManager> state_manager_;
 
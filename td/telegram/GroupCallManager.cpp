@@ -953,6 +953,7 @@ struct GroupCallManager::GroupCall {
 
 struct GroupCallManager::GroupCallParticipants {
   vector<GroupCallParticipant> participants;
+  FlatHashMap<DialogId, size_t, DialogIdHash> participant_positions;  // position of each participant in participants
   string next_offset;
   GroupCallParticipantOrder min_order = GroupCallParticipantOrder::max();
   bool joined_date_asc = false;
@@ -966,6 +967,48 @@ struct GroupCallManager::GroupCallParticipants {
   };
   std::map<int32, PendingUpdates> pending_version_updates_;
   std::map<int32, PendingUpdates> pending_mute_updates_;
+
+  GroupCallParticipant *get_participant(DialogId dialog_id) {
+    auto it = participant_positions.find(dialog_id);
+    if (it == participant_positions.end()) {
+      return nullptr;
+    }
+    return &participants[it->second];
+  }
+
+  GroupCallParticipant *get_self_participant() {
+    for (auto &participant : participants) {
+      if (participant.is_self) {
+        return &participant;
+      }
+    }
+    return nullptr;
+  }
+
+  void add_participant(GroupCallParticipant &&participant) {
+    CHECK(participant.dialog_id.is_valid());
+    participant_positions[participant.dialog_id] = participants.size();
+    participants.push_back(std::move(participant));
+  }
+
+  void change_participant_dialog_id(DialogId old_dialog_id, DialogId new_dialog_id) {
+    auto it = participant_positions.find(old_dialog_id);
+    CHECK(it != participant_positions.end());
+    auto position = it->second;
+    participant_positions.erase(it);
+    participant_positions[new_dialog_id] = position;
+  }
+
+  // the last participant is moved to the place of the removed participant
+  void remove_participant(size_t position) {
+    CHECK(position < participants.size());
+    participant_positions.erase(participants[position].dialog_id);
+    if (position + 1 != participants.size()) {
+      participants[position] = std::move(participants.back());
+      participant_positions[participants[position].dialog_id] = position;
+    }
+    participants.pop_back();
+  }
 };
 
 struct GroupCallManager::GroupCallRecentSpeakers {
@@ -1703,19 +1746,9 @@ GroupCallParticipant *GroupCallManager::get_group_call_participant(GroupCallPart
     return nullptr;
   }
   if (dialog_id == td_->dialog_manager_->get_my_dialog_id()) {
-    for (auto &group_call_participant : group_call_participants->participants) {
-      if (group_call_participant.is_self) {
-        return &group_call_participant;
-      }
-    }
-  } else {
-    for (auto &group_call_participant : group_call_participants->participants) {
-      if (group_call_participant.dialog_id == dialog_id) {
-        return &group_call_participant;
-      }
-    }
+    return group_call_participants->get_self_participant();
   }
-  return nullptr;
+  return group_call_participants->get_participant(dialog_id);
 }
 
 void GroupCallManager::on_update_group_call_participants(
@@ -2128,11 +2161,11 @@ void GroupCallManager::process_group_call_participants(
   if (is_sync) {
     auto *group_call_participants = add_group_call_participants(input_group_call_id);
     auto &group_participants = group_call_participants->participants;
-    for (auto participant_it = group_participants.begin(); participant_it != group_participants.end();) {
-      auto &participant = *participant_it;
+    for (size_t i = 0; i < group_participants.size();) {
+      auto &participant = group_participants[i];
       if (old_participant_dialog_ids.count(participant.dialog_id) == 0) {
         // successfully synced old user
-        ++participant_it;
+        i++;
         continue;
       }
 
@@ -2141,7 +2174,7 @@ void GroupCallManager::process_group_call_participants(
           participant.order = min_order;
           send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participants self");
         }
-        ++participant_it;
+        i++;
         continue;
       }
 
@@ -2153,7 +2186,7 @@ void GroupCallManager::process_group_call_participants(
       }
       on_remove_group_call_participant(input_group_call_id, participant.dialog_id);
       group_call_participants->local_unmuted_video_count -= participant.get_has_video();
-      participant_it = group_participants.erase(participant_it);
+      group_call_participants->remove_participant(i);
     }
     if (group_call_participants->min_order < min_order) {
       // if previously known more users, adjust min_order
@@ -2255,54 +2288,59 @@ std::pair<int32, int32> GroupCallManager::process_group_call_participant(InputGr
   bool can_self_unmute = get_group_call_can_self_unmute(input_group_call_id);
   bool can_manage = can_manage_group_call(input_group_call_id);
   auto *participants = add_group_call_participants(input_group_call_id);
-  for (size_t i = 0; i < participants->participants.size(); i++) {
-    auto &old_participant = participants->participants[i];
-    if (old_participant.dialog_id == participant.dialog_id || (old_participant.is_self && participant.is_self)) {
-      if (participant.joined_date == 0) {
-        LOG(INFO) << "Remove " << old_participant;
-        if (old_participant.order.is_valid()) {
-          send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participant remove");
-        }
-        on_remove_group_call_participant(input_group_call_id, old_participant.dialog_id);
-        remove_recent_group_call_speaker(input_group_call_id, old_participant.dialog_id);
-        int32 unmuted_video_diff = -old_participant.get_has_video();
-        participants->local_unmuted_video_count += unmuted_video_diff;
-        participants->participants.erase(participants->participants.begin() + i);
-        return {-1, unmuted_video_diff};
+  auto *found_participant = participants->get_participant(participant.dialog_id);
+  if (found_participant == nullptr && participant.is_self) {
+    found_participant = participants->get_self_participant();
+  }
+  if (found_participant != nullptr) {
+    auto &old_participant = *found_participant;
+    if (participant.joined_date == 0) {
+      LOG(INFO) << "Remove " << old_participant;
+      if (old_participant.order.is_valid()) {
+        send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participant remove");
       }
+      on_remove_group_call_participant(input_group_call_id, old_participant.dialog_id);
+      remove_recent_group_call_speaker(input_group_call_id, old_participant.dialog_id);
+      int32 unmuted_video_diff = -old_participant.get_has_video();
+      participants->local_unmuted_video_count += unmuted_video_diff;
+      participants->remove_participant(static_cast<size_t>(&old_participant - &participants->participants[0]));
+      return {-1, unmuted_video_diff};
+    }
 
-      if (old_participant.version > participant.version) {
-        LOG(INFO) << "Ignore outdated update of " << old_participant.dialog_id;
-        return {0, 0};
-      }
+    if (old_participant.version > participant.version) {
+      LOG(INFO) << "Ignore outdated update of " << old_participant.dialog_id;
+      return {0, 0};
+    }
 
-      if (old_participant.dialog_id != participant.dialog_id) {
-        on_remove_group_call_participant(input_group_call_id, old_participant.dialog_id);
-        on_add_group_call_participant(input_group_call_id, participant.dialog_id);
-      }
+    if (old_participant.dialog_id != participant.dialog_id) {
+      on_remove_group_call_participant(input_group_call_id, old_participant.dialog_id);
+      on_add_group_call_participant(input_group_call_id, participant.dialog_id);
+    }
 
-      participant.update_from(old_participant);
+    participant.update_from(old_participant);
 
-      participant.is_just_joined = false;
-      participant.order = get_real_participant_order(can_self_unmute, participant, participants);
-      update_group_call_participant_can_be_muted(can_manage, participants, participant);
+    participant.is_just_joined = false;
+    participant.order = get_real_participant_order(can_self_unmute, participant, participants);
+    update_group_call_participant_can_be_muted(can_manage, participants, participant);
 
-      LOG(INFO) << "Edit " << old_participant << " to " << participant;
-      if (old_participant != participant && (old_participant.order.is_valid() || participant.order.is_valid())) {
-        send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participant edit");
-        if (old_participant.dialog_id != participant.dialog_id) {
-          // delete old self-participant; shouldn't affect correct apps
-          old_participant.order = GroupCallParticipantOrder();
-          send_update_group_call_participant(input_group_call_id, old_participant,
-                                             "process_group_call_participant edit self");
-        }
+    LOG(INFO) << "Edit " << old_participant << " to " << participant;
+    if (old_participant != participant && (old_participant.order.is_valid() || participant.order.is_valid())) {
+      send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participant edit");
+      if (old_participant.dialog_id != participant.dialog_id) {
+        // delete old self-participant; shouldn't affect correct apps
+        old_participant.order = GroupCallParticipantOrder();
+        send_update_group_call_participant(input_group_call_id, old_participant,
+                                           "process_group_call_participant edit self");
       }
-      on_participant_speaking_in_group_call(input_group_call_id, participant);
-      int32 unmuted_video_diff = participant.get_has_video() - old_participant.get_has_video();
-      participants->local_unmuted_video_count += unmuted_video_diff;
-      old_participant = std::move(participant);
-      return {0, unmuted_video_diff};
     }
+    on_participant_speaking_in_group_call(input_group_call_id, participant);
+    int32 unmuted_video_diff = participant.get_has_video() - old_participant.get_has_video();
+    participants->local_unmuted_video_count += unmuted_video_diff;
+    if (old_participant.dialog_id != participant.dialog_id) {
+      participants->change_participant_dialog_id(old_participant.dialog_id, participant.dialog_id);
+    }
+    old_participant = std::move(participant);
+    return {0, unmuted_video_diff};
   }
 
   if (participant.joined_date == 0) {
@@ -2322,7 +2360,7 @@ std::pair<int32, int32> GroupCallManager::process_group_call_participant(InputGr
   participant.is_just_joined = false;
   participants->local_unmuted_video_count += participant.get_has_video();
   update_group_call_participant_can_be_muted(can_manage, participants, participant);
-  participants->participants.push_back(std::move(participant));
+  participants->add_participant(std::move(participant));
   if (participants->participants.back().order.is_valid()) {
     send_update_group_call_participant(input_group_call_id, participants->participants.back(),
                                        "process_group_call_participant add");
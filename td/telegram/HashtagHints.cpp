@@ -32,13 +32,34 @@ void HashtagHints::start_up() {
   }
 }
 
+void HashtagHints::timeout_expired() {
+  save_to_db();
+}
+
+void HashtagHints::tear_down() {
+  if (need_save_to_db_) {
+    save_to_db();
+  }
+}
+
+void HashtagHints::save_to_db() {
+  need_save_to_db_ = false;
+  cancel_timeout();
+  G()->td_db()->get_sqlite_pmc()->set(
+      get_key(), serialize(keys_to_strings(hints_.search_empty(MAX_SAVED_HASHTAGS).second)), Promise<Unit>());
+}
+
 void HashtagHints::hashtag_used(const string &hashtag) {
   if (!sync_with_db_) {
     return;
   }
   hashtag_used_impl(hashtag);
-  G()->td_db()->get_sqlite_pmc()->set(get_key(), serialize(keys_to_strings(hints_.search_empty(101).second)),
-                                      Promise<Unit>());
+
+  // hashtags are often used in bursts, so save them once after all changes
+  need_save_to_db_ = true;
+  if (!has_timeout()) {
+    set_timeout_in(DB_SYNC_DELAY);
+  }
 }
 
 void HashtagHints::remove_hashtag(string hashtag, Promise<Unit> promise) {
@@ -51,8 +72,7 @@ void HashtagHints::remove_hashtag(string hashtag, Promise<Unit> promise) {
   auto key = Hash<string>()(hashtag);
   if (hints_.has_key(key)) {
     hints_.remove(key);
-    G()->td_db()->get_sqlite_pmc()->set(get_key(), serialize(keys_to_strings(hints_.search_empty(101).second)),
-                                        Promise<Unit>());
+    save_to_db();
     promise.set_value(Unit());  // set promise explicitly, because sqlite_pmc waits for too long before setting promise
   } else {
     promise.set_value(Unit());
@@ -64,7 +84,7 @@ void HashtagHints::clear(Promise<Unit> promise) {
     return promise.set_value(Unit());
   }
   hints_ = {};
-  G()->td_db()->get_sqlite_pmc()->set(get_key(), serialize(vector<string>()), Promise<Unit>());
+  save_to_db();
   promise.set_value(Unit());
 }
 
@@ -28,10 +28,14 @@ class HashtagHints final : public Actor {
   void query(const string &prefix, int32 limit, Promise<vector<string>> promise);
 
  private:
+  static constexpr int32 DB_SYNC_DELAY = 5;  // seconds
+  static constexpr int32 MAX_SAVED_HASHTAGS = 101;
+
   string mode_;
   Hints hints_;
   char first_character_ = '#';
   bool sync_with_db_ = false;
+  bool need_save_to_db_ = false;
   int64 counter_ = 0;
 
   ActorShared<> parent_;
@@ -40,6 +44,12 @@ class HashtagHints final : public Actor {
 
   void start_up() final;
 
+  void timeout_expired() final;
+
+  void tear_down() final;
+
+  void save_to_db();
+
   void hashtag_used_impl(const string &hashtag);
   void from_db(Result<string> data, bool dummy);
   vector<string> keys_to_strings(const vector<int64> &keys);
@@ -123,7 +123,7 @@ class InlineQueriesManager final : public Actor {
   void tear_down() final;
 
   int32 recently_used_bots_loaded_ = 0;  // 0 - not loaded, 1 - load request was sent, 2 - loaded
-  MultiPromiseActor resolve_recent_inline_bots_multipromise_{"ResolveRecentInlineBotsMultiPromiseActor"};
+  MultiPromiseCounter resolve_recent_inline_bots_multipromise_{"ResolveRecentInlineBotsMultiPromiseCounter", this};
 
   vector<UserId> recently_used_bot_user_ids_;
 
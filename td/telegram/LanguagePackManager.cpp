@@ -7,6 +7,7 @@
 #include "td/telegram/LanguagePackManager.h"
 
 #include "td/telegram/Global.h"
+#include "td/telegram/LanguagePackSnapshot.h"
 #include "td/telegram/misc.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
 #include "td/telegram/Td.h"
@@ -21,6 +22,7 @@
 #include "td/utils/FlatHashSet.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/path.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 
@@ -62,6 +64,8 @@ struct LanguagePackManager::Language {
   FlatHashMap<string, string> ordinary_strings_;
   FlatHashMap<string, unique_ptr<PluralizedString>> pluralized_strings_;
   FlatHashSet<string> deleted_strings_;
+  unique_ptr<LanguagePackSnapshot> snapshot_;  // strings from the database; overridden by the strings above
+  string snapshot_path_;
   SqliteKeyValue kv_;  // usages must be guarded by database_->mutex_
 };
 
@@ -664,6 +668,9 @@ LanguagePackManager::Language *LanguagePackManager::add_language(LanguageDatabas
       language->version_ = load_database_language_version(&language->kv_);
       language->key_count_ = load_database_language_key_count(&language->kv_);
       language->base_language_code_ = load_database_language_base_language_code(&language->kv_);
+      if (!database->path_.empty() && !is_custom_language_code(language_code)) {
+        language->snapshot_path_ = PSTRING() << database->path_ << '.' << language_pack << '.' << language_code;
+      }
       LOG(INFO) << "Loaded language " << language_code << " with version " << language->version_.load()
                 << ", key count " << language->key_count_.load() << " and base language "
                 << language->base_language_code_;
@@ -675,7 +682,19 @@ LanguagePackManager::Language *LanguagePackManager::add_language(LanguageDatabas
 
 bool LanguagePackManager::language_has_string_unsafe(const Language *language, const string &key) {
   return language->ordinary_strings_.count(key) != 0 || language->pluralized_strings_.count(key) != 0 ||
-         language->deleted_strings_.count(key) != 0;
+         language->deleted_strings_.count(key) != 0 ||
+         (language->snapshot_ != nullptr && !language->snapshot_->get(key).empty());
+}
+
+bool LanguagePackManager::is_snapshot_string_visible_unsafe(const Language *language, const string &key) {
+  if (language->snapshot_ == nullptr) {
+    return false;
+  }
+  auto has_newer_string = [language](const string &string_key) {
+    return language->ordinary_strings_.count(string_key) != 0 ||
+           language->pluralized_strings_.count(string_key) != 0 || language->deleted_strings_.count(string_key) != 0;
+  };
+  return !language->snapshot_->get_visible(key, has_newer_string).empty();
 }
 
 bool LanguagePackManager::language_has_strings(Language *language, const vector<string> &keys) {
@@ -744,6 +763,30 @@ bool LanguagePackManager::load_language_strings(LanguageDatabase *database, Lang
       return false;
     }
 
+    if (language->version_ != -1 && !language->snapshot_path_.empty()) {
+      auto r_snapshot =
+          LanguagePackSnapshot::open(language->snapshot_path_, language->version_, language->key_count_);
+      if (r_snapshot.is_error()) {
+        LOG(INFO) << "Create language pack snapshot: " << r_snapshot.error();
+        vector<std::pair<string, string>> strings;
+        for (auto &str : language->kv_.get_all()) {
+          if (str.first[0] != '!') {
+            strings.emplace_back(str.first, std::move(str.second));
+          }
+        }
+        language->snapshot_ = LanguagePackSnapshot::create(language->snapshot_path_, language->version_,
+                                                           language->key_count_, std::move(strings));
+      } else {
+        language->snapshot_ = r_snapshot.move_as_ok();
+      }
+      LOG(DEBUG) << "Use language pack snapshot with " << language->snapshot_->size() << " strings";
+
+      // the strings loaded earlier are kept, because they aren't older than the strings from the database
+      language->was_loaded_full_ = true;
+      language->is_full_ = true;
+      return true;
+    }
+
     auto all_strings = language->kv_.get_all();
     for (auto &str : all_strings) {
       if (str.first[0] == '!') {
@@ -815,6 +858,22 @@ td_api::object_ptr<td_api::languagePackString> LanguagePackManager::get_language
   return td_api::make_object<td_api::languagePackString>(key, get_language_pack_string_value_object());
 }
 
+td_api::object_ptr<td_api::LanguagePackStringValue>
+LanguagePackManager::get_language_pack_string_value_object_from_database(Slice value) {
+  CHECK(!value.empty());
+  if (value[0] == '1') {
+    return get_language_pack_string_value_object(value.substr(1).str());
+  }
+  if (value[0] == '2') {
+    auto all = full_split(value.substr(1), '\x00');
+    if (all.size() == 6) {
+      return td_api::make_object<td_api::languagePackStringValuePluralized>(
+          all[0].str(), all[1].str(), all[2].str(), all[3].str(), all[4].str(), all[5].str());
+    }
+  }
+  return get_language_pack_string_value_object();
+}
+
 td_api::object_ptr<td_api::LanguagePackStringValue> LanguagePackManager::get_language_pack_string_value_object(
     const Language *language, const string &key) {
   CHECK(language != nullptr);
@@ -826,6 +885,13 @@ td_api::object_ptr<td_api::LanguagePackStringValue> LanguagePackManager::get_lan
   if (pluralized_it != language->pluralized_strings_.end()) {
     return get_language_pack_string_value_object(*pluralized_it->second);
   }
+  if (language->snapshot_ != nullptr) {
+    auto value = language->snapshot_->get_visible(
+        key, [language](const string &string_key) { return language->deleted_strings_.count(string_key) != 0; });
+    if (!value.empty()) {
+      return get_language_pack_string_value_object_from_database(value);
+    }
+  }
   LOG_IF(ERROR, !language->is_full_ && language->deleted_strings_.count(key) == 0) << "Have no string for key " << key;
   return get_language_pack_string_value_object();
 }
@@ -848,6 +914,15 @@ td_api::object_ptr<td_api::languagePackStrings> LanguagePackManager::get_languag
     for (auto &str : language->pluralized_strings_) {
       strings.push_back(get_language_pack_string_object(str.first, *str.second));
     }
+    if (language->snapshot_ != nullptr) {
+      for (size_t i = 0; i < language->snapshot_->size(); i++) {
+        auto key = language->snapshot_->get_key(i).str();
+        if (is_snapshot_string_visible_unsafe(language, key)) {
+          auto value = get_language_pack_string_value_object_from_database(language->snapshot_->get_value(i));
+          strings.push_back(td_api::make_object<td_api::languagePackString>(std::move(key), std::move(value)));
+        }
+      }
+    }
   } else {
     for (auto &key : keys) {
       strings.push_back(get_language_pack_string_object(language, key));
@@ -1382,9 +1457,10 @@ void LanguagePackManager::on_get_language_pack_strings(
               LOG(ERROR) << "Receive invalid key \"" << str->key_ << '"';
               break;
             }
+            auto is_in_snapshot = is_snapshot_string_visible_unsafe(language, str->key_);
             auto it = language->ordinary_strings_.find(str->key_);
             if (it == language->ordinary_strings_.end()) {
-              key_count_delta++;
+              key_count_delta += !is_in_snapshot;
               it = language->ordinary_strings_.emplace(str->key_, std::move(str->value_)).first;
             } else {
               it->second = std::move(str->value_);
@@ -1406,9 +1482,10 @@ void LanguagePackManager::on_get_language_pack_strings(
             auto value = td::make_unique<PluralizedString>(std::move(str->zero_value_), std::move(str->one_value_),
                                                            std::move(str->two_value_), std::move(str->few_value_),
                                                            std::move(str->many_value_), std::move(str->other_value_));
+            auto is_in_snapshot = is_snapshot_string_visible_unsafe(language, str->key_);
             auto it = language->pluralized_strings_.find(str->key_);
             if (it == language->pluralized_strings_.end()) {
-              key_count_delta++;
+              key_count_delta += !is_in_snapshot;
               it = language->pluralized_strings_.emplace(str->key_, std::move(value)).first;
             } else {
               it->second = std::move(value);
@@ -1431,6 +1508,7 @@ void LanguagePackManager::on_get_language_pack_strings(
               LOG(ERROR) << "Receive invalid key \"" << str->key_ << '"';
               break;
             }
+            key_count_delta -= static_cast<int32>(is_snapshot_string_visible_unsafe(language, str->key_));
             key_count_delta -= static_cast<int32>(language->ordinary_strings_.erase(str->key_));
             key_count_delta -= static_cast<int32>(language->pluralized_strings_.erase(str->key_));
             language->deleted_strings_.insert(str->key_);
@@ -1466,7 +1544,9 @@ void LanguagePackManager::on_get_language_pack_strings(
       if (keys.empty() && !is_diff) {
         CHECK(new_database_version >= 0);
         language->is_full_ = true;
-        language->deleted_strings_.clear();
+        if (language->snapshot_ == nullptr) {
+          language->deleted_strings_.clear();
+        }
       }
       new_is_full = language->is_full_;
 
@@ -1856,6 +1936,10 @@ Status LanguagePackManager::do_delete_language(const string &language_code) {
   language->ordinary_strings_.clear();
   language->pluralized_strings_.clear();
   language->deleted_strings_.clear();
+  language->snapshot_ = nullptr;
+  if (!language->snapshot_path_.empty()) {
+    unlink(language->snapshot_path_).ignore();
+  }
 
   if (!pack->pack_kv_.empty()) {
     pack->pack_kv_.erase(language_code);
@@ -116,6 +116,8 @@ class LanguagePackManager final : public NetQueryCallback {
   static Language *add_language(LanguageDatabase *database, const string &language_pack, const string &language_code);
 
   static bool language_has_string_unsafe(const Language *language, const string &key);
+
+  static bool is_snapshot_string_visible_unsafe(const Language *language, const string &key);
   static bool language_has_strings(Language *language, const vector<string> &keys);
 
   static void load_language_string_unsafe(Language *language, const string &key, const string &value);
@@ -126,6 +128,9 @@ class LanguagePackManager final : public NetQueryCallback {
       const PluralizedString &value);
   static td_api::object_ptr<td_api::LanguagePackStringValue> get_language_pack_string_value_object();
 
+  static td_api::object_ptr<td_api::LanguagePackStringValue> get_language_pack_string_value_object_from_database(
+      Slice value);
+
   static td_api::object_ptr<td_api::languagePackString> get_language_pack_string_object(const string &key,
                                                                                         const string &value);
   static td_api::object_ptr<td_api::languagePackString> get_language_pack_string_object(const string &key,
@@ -0,0 +1,187 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/LanguagePackSnapshot.h"
+
+#include "td/utils/filesystem.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/Random.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace td {
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[4] = {'T', 'D', 'L', 'S'};
+constexpr int32 SNAPSHOT_FORMAT_VERSION = 1;
+
+struct SnapshotHeader {
+  char magic[4];
+  int32 format_version;
+  int32 version;
+  int32 key_count;
+  uint32 entry_count;
+};
+
+}  // namespace
+
+Result<unique_ptr<LanguagePackSnapshot>> LanguagePackSnapshot::open(CSlice path, int32 version, int32 key_count) {
+  TRY_RESULT(fd, FileFd::open(path, FileFd::Read));
+  auto r_mapping = MemoryMapping::create_from_file(fd);
+  fd.close();
+  if (r_mapping.is_error()) {
+    return r_mapping.move_as_error();
+  }
+  auto mapping = td::make_unique<MemoryMapping>(r_mapping.move_as_ok());
+  auto data = mapping->as_slice();
+  unique_ptr<LanguagePackSnapshot> result(new LanguagePackSnapshot(std::move(mapping), string()));
+  TRY_STATUS(result->init(data, version, key_count));
+  return std::move(result);
+}
+
+unique_ptr<LanguagePackSnapshot> LanguagePackSnapshot::create(CSlice path, int32 version, int32 key_count,
+                                                              vector<std::pair<string, string>> strings) {
+  auto data = serialize(version, key_count, std::move(strings));
+  auto status = atomic_write_file(path, data, PSLICE() << path << '.' << Random::fast_uint32() << ".tmp");
+  if (status.is_ok()) {
+    auto r_snapshot = open(path, version, key_count);
+    if (r_snapshot.is_ok()) {
+      return r_snapshot.move_as_ok();
+    }
+    status = r_snapshot.move_as_error();
+  }
+  LOG(INFO) << "Keep language pack snapshot " << path << " in memory: " << status;
+
+  unique_ptr<LanguagePackSnapshot> result(new LanguagePackSnapshot(nullptr, std::move(data)));
+  result->init(result->data_, version, key_count).ensure();
+  return result;
+}
+
+Slice LanguagePackSnapshot::get_key(size_t pos) const {
+  auto entry = get_entry(pos);
+  return strings_.substr(entry.key_offset, entry.key_size);
+}
+
+Slice LanguagePackSnapshot::get_value(size_t pos) const {
+  auto entry = get_entry(pos);
+  return strings_.substr(entry.value_offset, entry.value_size);
+}
+
+Slice LanguagePackSnapshot::get(Slice key) const {
+  size_t left = 0;
+  size_t right = entry_count_;
+  while (left < right) {
+    auto middle = left + (right - left) / 2;
+    auto middle_key = get_key(middle);
+    if (middle_key < key) {
+      left = middle + 1;
+    } else if (key < middle_key) {
+      right = middle;
+    } else {
+      return get_value(middle);
+    }
+  }
+  return Slice();
+}
+
+LanguagePackSnapshot::Entry LanguagePackSnapshot::get_entry(size_t pos) const {
+  CHECK(pos < entry_count_);
+  Entry entry;
+  std::memcpy(&entry, entries_.data() + pos * sizeof(Entry), sizeof(Entry));
+  return entry;
+}
+
+Status LanguagePackSnapshot::init(Slice data, int32 version, int32 key_count) {
+  SnapshotHeader header;
+  if (data.size() < sizeof(header)) {
+    return Status::Error("Language pack snapshot is too small");
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+      header.format_version != SNAPSHOT_FORMAT_VERSION) {
+    return Status::Error("Language pack snapshot has wrong format");
+  }
+  if (header.version != version || header.key_count != key_count) {
+    return Status::Error(PSLICE() << "Language pack snapshot has version " << header.version << " and key count "
+                                  << header.key_count << " instead of " << version << " and " << key_count);
+  }
+  data.remove_prefix(sizeof(header));
+  if (data.size() / sizeof(Entry) < header.entry_count) {
+    return Status::Error("Language pack snapshot is truncated");
+  }
+
+  entries_ = data.substr(0, header.entry_count * sizeof(Entry));
+  strings_ = data.substr(entries_.size());
+  entry_count_ = header.entry_count;
+  for (size_t i = 0; i < entry_count_; i++) {
+    auto entry = get_entry(i);
+    if (entry.key_offset > strings_.size() || entry.key_size > strings_.size() - entry.key_offset ||
+        entry.value_offset > strings_.size() || entry.value_size > strings_.size() - entry.value_offset) {
+      entry_count_ = 0;
+      return Status::Error("Language pack snapshot has invalid entry");
+    }
+    if (entry.key_size == 0 || (i > 0 && !(get_key(i - 1) < get_key(i)))) {
+      entry_count_ = 0;
+      return Status::Error("Language pack snapshot has unsorted keys");
+    }
+  }
+  return Status::OK();
+}
+
+string LanguagePackSnapshot::serialize(int32 version, int32 key_count, vector<std::pair<string, string>> &&strings) {
+  std::sort(strings.begin(), strings.end(),
+            [](const std::pair<string, string> &lhs, const std::pair<string, string> &rhs) {
+              return Slice(lhs.first) < Slice(rhs.first);
+            });
+  strings.erase(std::unique(strings.begin(), strings.end(),
+                            [](const std::pair<string, string> &lhs, const std::pair<string, string> &rhs) {
+                              return lhs.first == rhs.first;
+                            }),
+                strings.end());
+
+  size_t strings_size = 0;
+  for (auto &str : strings) {
+    strings_size += str.first.size() + str.second.size();
+  }
+  CHECK(strings_size <= std::numeric_limits<uint32>::max());
+
+  SnapshotHeader header;
+  std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.format_version = SNAPSHOT_FORMAT_VERSION;
+  header.version = version;
+  header.key_count = key_count;
+  header.entry_count = narrow_cast<uint32>(strings.size());
+
+  string result(sizeof(header) + strings.size() * sizeof(Entry) + strings_size, '\0');
+  std::memcpy(&result[0], &header, sizeof(header));
+  auto entries_ptr = &result[sizeof(header)];
+  auto strings_begin = entries_ptr + strings.size() * sizeof(Entry);
+  auto strings_ptr = strings_begin;
+  for (auto &str : strings) {
+    Entry entry;
+    entry.key_offset = static_cast<uint32>(strings_ptr - strings_begin);
+    entry.key_size = static_cast<uint32>(str.first.size());
+    std::memcpy(strings_ptr, str.first.data(), str.first.size());
+    strings_ptr += str.first.size();
+    entry.value_offset = static_cast<uint32>(strings_ptr - strings_begin);
+    entry.value_size = static_cast<uint32>(str.second.size());
+    std::memcpy(strings_ptr, str.second.data(), str.second.size());
+    strings_ptr += str.second.size();
+
+    std::memcpy(entries_ptr, &entry, sizeof(entry));
+    entries_ptr += sizeof(entry);
+  }
+  CHECK(strings_ptr == &result[0] + result.size());
+  return result;
+}
+
+}  // namespace td
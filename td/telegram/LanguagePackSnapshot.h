@@ -0,0 +1,86 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/port/MemoryMapping.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+#include <utility>
+
+namespace td {
+
+// immutable sorted list of language pack strings in the database format, which is memory-mapped from a file,
+// so the same strings are shared between all clients using the same language pack database
+class LanguagePackSnapshot {
+ public:
+  LanguagePackSnapshot(const LanguagePackSnapshot &) = delete;
+  LanguagePackSnapshot &operator=(const LanguagePackSnapshot &) = delete;
+  LanguagePackSnapshot(LanguagePackSnapshot &&) = delete;
+  LanguagePackSnapshot &operator=(LanguagePackSnapshot &&) = delete;
+  ~LanguagePackSnapshot() = default;
+
+  // opens the snapshot if it exists and has the specified version and key count
+  static Result<unique_ptr<LanguagePackSnapshot>> open(CSlice path, int32 version, int32 key_count);
+
+  // saves the strings to the file and opens the snapshot; strings doesn't need to be sorted
+  // if the file can't be written or mapped, the snapshot is kept in memory
+  static unique_ptr<LanguagePackSnapshot> create(CSlice path, int32 version, int32 key_count,
+                                                 vector<std::pair<string, string>> strings);
+
+  size_t size() const {
+    return entry_count_;
+  }
+
+  Slice get_key(size_t pos) const;
+
+  Slice get_value(size_t pos) const;
+
+  // returns the value in the database format or an empty slice if there is no such key
+  Slice get(Slice key) const;
+
+  // returns the value of an existing string in the database format or an empty slice if there is no such string,
+  // the string is deleted, or it is overridden by newer strings, for which has_newer_string returns true
+  template <class F>
+  Slice get_visible(const string &key, const F &has_newer_string) const {
+    if (has_newer_string(key)) {
+      return Slice();
+    }
+    auto value = get(key);
+    if (value.empty() || (value[0] != '1' && value[0] != '2')) {
+      return Slice();
+    }
+    return value;
+  }
+
+ private:
+  struct Entry {
+    uint32 key_offset;
+    uint32 key_size;
+    uint32 value_offset;
+    uint32 value_size;
+  };
+
+  unique_ptr<MemoryMapping> mapping_;
+  string data_;  // used if there is no mapping_
+  Slice entries_;
+  Slice strings_;
+  size_t entry_count_ = 0;
+
+  LanguagePackSnapshot(unique_ptr<MemoryMapping> &&mapping, string &&data)
+      : mapping_(std::move(mapping)), data_(std::move(data)) {
+  }
+
+  Entry get_entry(size_t pos) const;
+
+  Status init(Slice data, int32 version, int32 key_count);
+
+  static string serialize(int32 version, int32 key_count, vector<std::pair<string, string>> &&strings);
+};
+
+}  // namespace td
@@ -32,6 +32,7 @@
 #include "td/utils/algorithm.h"
 #include "td/utils/ExitGuard.h"
 #include "td/utils/FileLog.h"
+#include "td/utils/FlightRecorderLog.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/NullLog.h"
@@ -48,6 +49,8 @@ static std::mutex logging_mutex;
 static FileLog file_log;
 static TsLog ts_log(&file_log);
 static NullLog null_log;
+static FlightRecorderLog flight_recorder_log;
+static int recording_verbosity_level = 0;
 static ExitGuard exit_guard;
 
 #define ADD_TAG(tag) \
@@ -60,6 +63,21 @@ static const std::map<Slice, int *> log_tags{
     ADD_TAG(file_gc),     ADD_TAG(config_recoverer), ADD_TAG(dns_resolver),  ADD_TAG(file_references)};
 #undef ADD_TAG
 
+static LogInterface *get_current_log_interface() {
+  if (recording_verbosity_level != 0) {
+    return flight_recorder_log.get_log();
+  }
+  return log_interface;
+}
+
+static void set_current_log_interface(LogInterface *new_log_interface) {
+  if (recording_verbosity_level != 0) {
+    flight_recorder_log.set_log(new_log_interface);
+  } else {
+    log_interface = new_log_interface;
+  }
+}
+
 Status Logging::set_current_stream(td_api::object_ptr<td_api::LogStream> stream) {
   if (stream == nullptr) {
     return Status::Error("Log stream must be non-empty");
@@ -68,7 +86,7 @@ Status Logging::set_current_stream(td_api::object_ptr<td_api::LogStream> stream)
   std::lock_guard<std::mutex> lock(logging_mutex);
   switch (stream->get_id()) {
     case td_api::logStreamDefault::ID:
-      log_interface = default_log_interface;
+      set_current_log_interface(default_log_interface);
       return Status::OK();
     case td_api::logStreamFile::ID: {
       auto file_stream = td_api::move_object_as<td_api::logStreamFile>(stream);
@@ -80,11 +98,11 @@ Status Logging::set_current_stream(td_api::object_ptr<td_api::LogStream> stream)
 
       TRY_STATUS(file_log.init(file_stream->path_, max_log_file_size, redirect_stderr));
       std::atomic_thread_fence(std::memory_order_release);  // better than nothing
-      log_interface = &ts_log;
+      set_current_log_interface(&ts_log);
       return Status::OK();
     }
     case td_api::logStreamEmpty::ID:
-      log_interface = &null_log;
+      set_current_log_interface(&null_log);
       return Status::OK();
     default:
       UNREACHABLE();
@@ -94,13 +112,14 @@ Status Logging::set_current_stream(td_api::object_ptr<td_api::LogStream> stream)
 
 Result<td_api::object_ptr<td_api::LogStream>> Logging::get_current_stream() {
   std::lock_guard<std::mutex> lock(logging_mutex);
-  if (log_interface == default_log_interface) {
+  auto current_log_interface = get_current_log_interface();
+  if (current_log_interface == default_log_interface) {
     return td_api::make_object<td_api::logStreamDefault>();
   }
-  if (log_interface == &null_log) {
+  if (current_log_interface == &null_log) {
     return td_api::make_object<td_api::logStreamEmpty>();
   }
-  if (log_interface == &ts_log) {
+  if (current_log_interface == &ts_log) {
     return td_api::make_object<td_api::logStreamFile>(file_log.get_path().str(), file_log.get_rotate_threshold(),
                                                       file_log.get_redirect_stderr());
   }
@@ -110,7 +129,12 @@ Result<td_api::object_ptr<td_api::LogStream>> Logging::get_current_stream() {
 Status Logging::set_verbosity_level(int new_verbosity_level) {
   std::lock_guard<std::mutex> lock(logging_mutex);
   if (0 <= new_verbosity_level && new_verbosity_level <= VERBOSITY_NAME(NEVER)) {
-    SET_VERBOSITY_LEVEL(VERBOSITY_NAME(FATAL) + new_verbosity_level);
+    if (recording_verbosity_level != 0) {
+      flight_recorder_log.set_log_verbosity_level(VERBOSITY_NAME(FATAL) + new_verbosity_level);
+      SET_VERBOSITY_LEVEL(VERBOSITY_NAME(FATAL) + max(new_verbosity_level, recording_verbosity_level));
+    } else {
+      SET_VERBOSITY_LEVEL(VERBOSITY_NAME(FATAL) + new_verbosity_level);
+    }
     return Status::OK();
   }
 
@@ -119,9 +143,49 @@ Status Logging::set_verbosity_level(int new_verbosity_level) {
 
 int Logging::get_verbosity_level() {
   std::lock_guard<std::mutex> lock(logging_mutex);
+  if (recording_verbosity_level != 0) {
+    return flight_recorder_log.get_log_verbosity_level();
+  }
   return GET_VERBOSITY_LEVEL();
 }
 
+Status Logging::set_recording_verbosity_level(int new_verbosity_level) {
+  if (new_verbosity_level < 0 || new_verbosity_level > VERBOSITY_NAME(NEVER)) {
+    return Status::Error("Wrong new verbosity level specified");
+  }
+
+  std::lock_guard<std::mutex> lock(logging_mutex);
+  if (new_verbosity_level == recording_verbosity_level) {
+    return Status::OK();
+  }
+  if (new_verbosity_level == 0) {
+    auto verbosity_level = flight_recorder_log.get_log_verbosity_level();
+    log_interface = flight_recorder_log.get_log();
+    SET_VERBOSITY_LEVEL(verbosity_level);
+    flight_recorder_log.clear();
+    recording_verbosity_level = 0;
+    return Status::OK();
+  }
+
+  if (recording_verbosity_level == 0) {
+    flight_recorder_log.set_log(log_interface);
+    flight_recorder_log.set_log_verbosity_level(GET_VERBOSITY_LEVEL());
+    std::atomic_thread_fence(std::memory_order_release);
+    log_interface = &flight_recorder_log;
+  }
+  recording_verbosity_level = new_verbosity_level;
+  SET_VERBOSITY_LEVEL(
+      max(flight_recorder_log.get_log_verbosity_level(), VERBOSITY_NAME(FATAL) + recording_verbosity_level));
+  return Status::OK();
+}
+
+void Logging::dump_recorded_messages() {
+  std::lock_guard<std::mutex> lock(logging_mutex);
+  if (recording_verbosity_level != 0) {
+    flight_recorder_log.dump();
+  }
+}
+
 vector<string> Logging::get_tags() {
   return transform(log_tags, [](auto &tag) { return tag.first.str(); });
 }
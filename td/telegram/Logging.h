@@ -24,6 +24,10 @@ class Logging {
 
   static int get_verbosity_level();
 
+  static Status set_recording_verbosity_level(int new_verbosity_level);
+
+  static void dump_recorded_messages();
+
   static vector<string> get_tags();
 
   static Status set_tag_verbosity_level(Slice tag, int new_verbosity_level);
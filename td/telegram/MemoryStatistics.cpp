@@ -0,0 +1,56 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/MemoryStatistics.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/format.h"
+#include "td/utils/misc.h"
+#include "td/utils/SliceBuilder.h"
+
+namespace td {
+
+void MemoryStatistics::add(Slice manager_name, Slice container_name, size_t object_count, size_t estimated_size) {
+  Entry entry;
+  entry.manager_name = manager_name.str();
+  entry.container_name = container_name.str();
+  entry.object_count = object_count;
+  entry.estimated_size = estimated_size;
+  entries_.push_back(std::move(entry));
+}
+
+size_t MemoryStatistics::get_total_size() const {
+  size_t result = 0;
+  for (auto &entry : entries_) {
+    result += entry.estimated_size;
+  }
+  return result;
+}
+
+string MemoryStatistics::get_text() const {
+  vector<string> lines;
+  for (size_t i = 0; i < entries_.size(); i++) {
+    if (i == 0 || entries_[i].manager_name != entries_[i - 1].manager_name) {
+      lines.push_back(entries_[i].manager_name + ':');
+    }
+    auto &entry = entries_[i];
+    lines.back() += PSTRING() << ' ' << tag(entry.container_name + "_count", entry.object_count)
+                              << tag(entry.container_name + "_size", format::as_size(entry.estimated_size));
+  }
+  lines.push_back(PSTRING() << "Total: " << tag("estimated_size", format::as_size(get_total_size())));
+  return implode(lines, '\n');
+}
+
+td_api::object_ptr<td_api::memoryStatistics> MemoryStatistics::get_memory_statistics_object() const {
+  auto entries = transform(entries_, [](const Entry &entry) {
+    return td_api::make_object<td_api::memoryStatisticsEntry>(entry.manager_name, entry.container_name,
+                                                              static_cast<int64>(entry.object_count),
+                                                              static_cast<int64>(entry.estimated_size));
+  });
+  return td_api::make_object<td_api::memoryStatistics>(get_text(), std::move(entries));
+}
+
+}  // namespace td
@@ -0,0 +1,50 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/td_api.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+namespace td {
+
+// approximate memory usage of the main containers; must be cheap to collect
+class MemoryStatistics {
+ public:
+  // estimated_size must include container overhead, but may exclude variable-length data owned by the objects
+  void add(Slice manager_name, Slice container_name, size_t object_count, size_t estimated_size);
+
+  // adds a hash table, which maps keys of type KeyT to unique_ptr<T>
+  template <class KeyT, class T>
+  void add_hash_map(Slice manager_name, Slice container_name, size_t object_count) {
+    add(manager_name, container_name, object_count, object_count * get_hash_map_node_size<KeyT, T>());
+  }
+
+  size_t get_total_size() const;
+
+  td_api::object_ptr<td_api::memoryStatistics> get_memory_statistics_object() const;
+
+ private:
+  struct Entry {
+    string manager_name;
+    string container_name;
+    size_t object_count = 0;
+    size_t estimated_size = 0;
+  };
+  vector<Entry> entries_;
+
+  template <class KeyT, class T>
+  static constexpr size_t get_hash_map_node_size() {
+    // hash tables are kept at most half full
+    return sizeof(T) + 2 * (sizeof(KeyT) + sizeof(void *));
+  }
+
+  string get_text() const;
+};
+
+}  // namespace td
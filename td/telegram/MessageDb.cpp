@@ -6,6 +6,7 @@
 //
 #include "td/telegram/MessageDb.h"
 
+#include "td/telegram/DbReader.h"
 #include "td/telegram/logevent/LogEvent.h"
 #include "td/telegram/UserId.h"
 #include "td/telegram/Version.h"
@@ -17,8 +18,12 @@
 #include "td/actor/actor.h"
 #include "td/actor/SchedulerLocalStorage.h"
 
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/format.h"
+#include "td/utils/Gzip.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/Clocks.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
@@ -41,6 +46,66 @@ namespace td {
 static constexpr int32 MESSAGE_DB_INDEX_COUNT = 30;
 static constexpr int32 MESSAGE_DB_INDEX_COUNT_OLD = 9;
 
+// in the deferred mode new messages are added to messages_fts_pending and are indexed later in batches
+static Status create_fts_insert_trigger(SqliteDb &db, bool use_deferred_indexing) {
+  if (use_deferred_indexing) {
+    return db.exec(
+        "CREATE TRIGGER IF NOT EXISTS trigger_fts_insert_pending AFTER INSERT ON messages WHEN NEW.search_id IS NOT "
+        "NULL BEGIN INSERT OR IGNORE INTO messages_fts_pending VALUES(NEW.search_id); END");
+  }
+  return db.exec(
+      "CREATE TRIGGER IF NOT EXISTS trigger_fts_insert AFTER INSERT ON messages WHEN NEW.search_id IS NOT NULL"
+      " BEGIN INSERT INTO messages_fts(rowid, text) VALUES(NEW.search_id, NEW.text); END");
+}
+
+static Status drop_fts_insert_trigger(SqliteDb &db, bool use_deferred_indexing) {
+  if (use_deferred_indexing) {
+    return db.exec("DROP TRIGGER IF EXISTS trigger_fts_insert_pending");
+  }
+  return db.exec("DROP TRIGGER IF EXISTS trigger_fts_insert");
+}
+
+// compressed message data consists of the magic, format version, dictionary identifier and original size as varints,
+// followed by a raw deflate stream; uncompressed data begins with a small log event version and can't match the magic
+static const char COMPRESSED_MESSAGE_DATA_MAGIC[] = "\xfftdz";
+static constexpr size_t COMPRESSED_MESSAGE_DATA_MAGIC_SIZE = 4;
+static constexpr uint8 COMPRESSED_MESSAGE_DATA_VERSION = 1;
+
+static void store_varint(string &to, uint64 value) {
+  while (value >= 0x80) {
+    to += static_cast<char>((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  to += static_cast<char>(value);
+}
+
+static Result<uint64> parse_varint(Slice &from) {
+  uint64 value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (from.empty()) {
+      break;
+    }
+    auto c = static_cast<uint8>(from[0]);
+    from.remove_prefix(1);
+    value |= static_cast<uint64>(c & 0x7F) << shift;
+    if ((c & 0x80) == 0) {
+      return value;
+    }
+  }
+  return Status::Error("Invalid varint");
+}
+
+static bool is_compressed_message_data(Slice data) {
+  return begins_with(data, Slice(COMPRESSED_MESSAGE_DATA_MAGIC, COMPRESSED_MESSAGE_DATA_MAGIC_SIZE));
+}
+
+// all messages with search_id are scheduled for indexing from scratch
+static Status rebuild_fts_index(SqliteDb &db) {
+  TRY_STATUS(db.exec("INSERT INTO messages_fts(messages_fts) VALUES('delete-all')"));
+  return db.exec(
+      "INSERT OR IGNORE INTO messages_fts_pending SELECT search_id FROM messages WHERE search_id IS NOT NULL");
+}
+
 // NB: must happen inside a transaction
 Status init_message_db(SqliteDb &db, int32 version) {
   LOG(INFO) << "Init message database " << tag("version", version);
@@ -71,21 +136,20 @@ Status init_message_db(SqliteDb &db, int32 version) {
     TRY_STATUS(
         db.exec("CREATE VIRTUAL TABLE IF NOT EXISTS messages_fts USING fts5(text, content='messages', "
                 "content_rowid='search_id', tokenize = \"unicode61 remove_diacritics 0 tokenchars '\a'\")"));
+    TRY_STATUS(db.exec("CREATE TABLE IF NOT EXISTS messages_fts_pending (search_id INTEGER PRIMARY KEY)"));
+
+    // messages are changed using INSERT OR REPLACE, which runs delete triggers for the replaced message only if
+    // recursive_triggers is enabled, so it must be enabled for every connection used to change the messages
+    // messages from messages_fts_pending aren't indexed yet, so they must not be deleted from the index
     TRY_STATUS(db.exec(
-        "CREATE TRIGGER IF NOT EXISTS trigger_fts_delete BEFORE DELETE ON messages WHEN OLD.search_id IS NOT NULL"
-        " BEGIN INSERT INTO messages_fts(messages_fts, rowid, text) VALUES(\'delete\', OLD.search_id, OLD.text); END"));
+        "CREATE TRIGGER IF NOT EXISTS trigger_fts_delete BEFORE DELETE ON messages WHEN OLD.search_id IS NOT NULL AND "
+        "OLD.search_id NOT IN (SELECT search_id FROM messages_fts_pending) BEGIN INSERT INTO messages_fts(messages_fts, "
+        "rowid, text) VALUES(\'delete\', OLD.search_id, OLD.text); END"));
     TRY_STATUS(db.exec(
-        "CREATE TRIGGER IF NOT EXISTS trigger_fts_insert AFTER INSERT ON messages WHEN NEW.search_id IS NOT NULL"
-        " BEGIN INSERT INTO messages_fts(rowid, text) VALUES(NEW.search_id, NEW.text); END"));
-    //TRY_STATUS(db.exec(
-    //"CREATE TRIGGER IF NOT EXISTS trigger_fts_update AFTER UPDATE ON messages WHEN NEW.search_id IS NOT NULL OR "
-    //"OLD.search_id IS NOT NULL"
-    //" BEGIN "
-    //"INSERT INTO messages_fts(messages_fts, rowid, text) VALUES(\'delete\', OLD.search_id, OLD.text); "
-    //"INSERT INTO messages_fts(rowid, text) VALUES(NEW.search_id, NEW.text); "
-    //" END"));
+        "CREATE TRIGGER IF NOT EXISTS trigger_fts_delete_pending AFTER DELETE ON messages WHEN OLD.search_id IS NOT "
+        "NULL BEGIN DELETE FROM messages_fts_pending WHERE search_id = OLD.search_id; END"));
 
-    return Status::OK();
+    return create_fts_insert_trigger(db, false);
   };
   auto add_call_index = [&db] {
     for (int i = static_cast<int>(MessageSearchFilter::Call) - 1; i < static_cast<int>(MessageSearchFilter::MissedCall);
@@ -100,6 +164,10 @@ Status init_message_db(SqliteDb &db, int32 version) {
         "CREATE INDEX IF NOT EXISTS message_by_notification_id ON messages (dialog_id, notification_id) WHERE "
         "notification_id IS NOT NULL");
   };
+  auto add_data_dictionaries_table = [&db] {
+    return db.exec(
+        "CREATE TABLE IF NOT EXISTS message_data_dictionaries (dictionary_id INTEGER PRIMARY KEY, data BLOB)");
+  };
   auto add_scheduled_messages_table = [&db] {
     TRY_STATUS(
         db.exec("CREATE TABLE IF NOT EXISTS scheduled_messages (dialog_id INT8, message_id INT8, "
@@ -140,6 +208,8 @@ Status init_message_db(SqliteDb &db, int32 version) {
 
     TRY_STATUS(add_scheduled_messages_table());
 
+    TRY_STATUS(add_data_dictionaries_table());
+
     version = current_db_version();
   }
   if (version < static_cast<int32>(DbVersion::AddMessageDbMediaIndex)) {
@@ -167,6 +237,15 @@ Status init_message_db(SqliteDb &db, int32 version) {
   if (version < static_cast<int32>(DbVersion::AddMessageThreadSupport)) {
     TRY_STATUS(db.exec("ALTER TABLE messages ADD COLUMN top_thread_message_id INT8"));
   }
+  if (version < static_cast<int32>(DbVersion::AddMessageFtsPendingTable)) {
+    // the existing index is kept; it can contain texts of replaced messages, which can be removed only by an explicit
+    // rebuild_fts_index, because it is too slow to reindex all messages during the upgrade
+    TRY_STATUS(db.exec("DROP TRIGGER IF EXISTS trigger_fts_delete"));
+    TRY_STATUS(add_fts());
+  }
+  if (version < static_cast<int32>(DbVersion::AddMessageDataDictionaries)) {
+    TRY_STATUS(add_data_dictionaries_table());
+  }
   return Status::OK();
 }
 
@@ -184,9 +263,17 @@ class MessageDbImpl final : public MessageDbSyncInterface {
   }
 
   Status init() {
+    // needed to remove replaced messages from the full-text search index
+    TRY_STATUS(db_.exec("PRAGMA recursive_triggers = ON"));
+
     TRY_RESULT_ASSIGN(
         add_message_stmt_,
         db_.get_statement("INSERT OR REPLACE INTO messages VALUES(?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12)"));
+    string add_messages_query = "INSERT OR REPLACE INTO messages VALUES";
+    for (size_t i = 0; i < ADD_MESSAGES_BATCH_SIZE; i++) {
+      add_messages_query += i == 0 ? "(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)" : ", (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+    }
+    TRY_RESULT_ASSIGN(add_messages_stmt_, db_.get_statement(add_messages_query));
     TRY_RESULT_ASSIGN(delete_message_stmt_,
                       db_.get_statement("DELETE FROM messages WHERE dialog_id = ?1 AND message_id = ?2"));
     TRY_RESULT_ASSIGN(delete_all_dialog_messages_stmt_,
@@ -220,10 +307,38 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     TRY_RESULT_ASSIGN(get_messages_from_notification_id_stmt_,
                       db_.get_statement("SELECT data, message_id FROM messages WHERE dialog_id = ?1 AND "
                                         "notification_id < ?2 ORDER BY notification_id DESC LIMIT ?3"));
-    TRY_RESULT_ASSIGN(get_messages_fts_stmt_,
-                      db_.get_statement("SELECT dialog_id, message_id, data, search_id FROM messages WHERE search_id "
-                                        "IN (SELECT rowid FROM messages_fts WHERE messages_fts MATCH ?1 AND rowid < ?2 "
-                                        "ORDER BY rowid DESC LIMIT ?3) ORDER BY search_id DESC"));
+    TRY_RESULT_ASSIGN(get_fts_search_ids_stmt_,
+                      db_.get_statement("SELECT rowid FROM messages_fts WHERE messages_fts MATCH ?1 AND rowid < ?2 "
+                                        "ORDER BY rowid DESC LIMIT ?3"));
+    TRY_RESULT_ASSIGN(get_messages_by_search_id_stmt_,
+                      db_.get_statement("SELECT dialog_id, message_id, data FROM messages WHERE search_id = ?1"));
+    TRY_RESULT_ASSIGN(index_pending_fts_messages_stmt_,
+                      db_.get_statement("INSERT INTO messages_fts(rowid, text) SELECT search_id, text FROM messages "
+                                        "WHERE search_id IN (SELECT search_id FROM messages_fts_pending ORDER BY "
+                                        "search_id LIMIT ?1)"));
+    TRY_RESULT_ASSIGN(delete_pending_fts_messages_stmt_,
+                      db_.get_statement("DELETE FROM messages_fts_pending WHERE search_id IN (SELECT search_id FROM "
+                                        "messages_fts_pending ORDER BY search_id LIMIT ?1)"));
+    TRY_RESULT_ASSIGN(has_pending_fts_messages_stmt_,
+                      db_.get_statement("SELECT search_id FROM messages_fts_pending LIMIT 1"));
+    TRY_RESULT_ASSIGN(get_data_dictionary_stmt_,
+                      db_.get_statement("SELECT data FROM message_data_dictionaries WHERE dictionary_id = ?1"));
+    TRY_RESULT_ASSIGN(
+        get_last_data_dictionary_stmt_,
+        db_.get_statement("SELECT dictionary_id FROM message_data_dictionaries ORDER BY dictionary_id DESC LIMIT 1"));
+    TRY_RESULT_ASSIGN(add_data_dictionary_stmt_,
+                      db_.get_statement("INSERT INTO message_data_dictionaries (data) VALUES(?1)"));
+    TRY_RESULT_ASSIGN(get_data_samples_stmt_,
+                      db_.get_statement("SELECT data FROM messages ORDER BY rowid DESC LIMIT ?1"));
+    TRY_RESULT_ASSIGN(get_next_message_dialog_id_stmt_,
+                      db_.get_statement("SELECT dialog_id FROM messages WHERE dialog_id > ?1 ORDER BY dialog_id LIMIT 1"));
+    {
+      TRY_RESULT(stmt, db_.get_statement("SELECT count(*) FROM sqlite_master WHERE type='trigger' AND "
+                                         "name='trigger_fts_insert_pending'"));
+      TRY_STATUS(stmt.step());
+      CHECK(stmt.has_row());
+      use_deferred_fts_indexing_ = stmt.view_int32(0) != 0;
+    }
 
     for (int32 i = 0; i < MESSAGE_DB_INDEX_COUNT; i++) {
       TRY_RESULT_ASSIGN(
@@ -256,7 +371,8 @@ class MessageDbImpl final : public MessageDbSyncInterface {
           get_calls_stmts_[pos],
           db_.get_statement(
               PSLICE()
-              << "SELECT dialog_id, message_id, data FROM messages WHERE unique_message_id < ?1 AND (index_mask & "
+              << "SELECT dialog_id, message_id, data, unique_message_id FROM messages WHERE unique_message_id < ?1 AND "
+                 "(index_mask & "
               << (1 << i) << ") != 0 ORDER BY unique_message_id DESC LIMIT ?2"));
     }
 
@@ -290,80 +406,44 @@ class MessageDbImpl final : public MessageDbSyncInterface {
   void add_message(MessageFullId message_full_id, ServerMessageId unique_message_id, DialogId sender_dialog_id,
                    int64 random_id, int32 ttl_expires_at, int32 index_mask, int64 search_id, string text,
                    NotificationId notification_id, MessageId top_thread_message_id, BufferSlice data) final {
-    LOG(INFO) << "Add " << message_full_id << " to database";
-    auto dialog_id = message_full_id.get_dialog_id();
-    auto message_id = message_full_id.get_message_id();
-    LOG_CHECK(dialog_id.is_valid()) << dialog_id << ' ' << message_id << ' ' << message_full_id;
-    CHECK(message_id.is_valid());
+    MessageDbNewMessage message;
+    message.message_full_id = message_full_id;
+    message.unique_message_id = unique_message_id;
+    message.sender_dialog_id = sender_dialog_id;
+    message.random_id = random_id;
+    message.ttl_expires_at = ttl_expires_at;
+    message.index_mask = index_mask;
+    message.search_id = search_id;
+    message.text = std::move(text);
+    message.notification_id = notification_id;
+    message.top_thread_message_id = top_thread_message_id;
+    message.data = std::move(data);
+
     SCOPE_EXIT {
       add_message_stmt_.reset();
     };
-    add_message_stmt_.bind_int64(1, dialog_id.get()).ensure();
-    add_message_stmt_.bind_int64(2, message_id.get()).ensure();
-
-    if (unique_message_id.is_valid()) {
-      add_message_stmt_.bind_int32(3, unique_message_id.get()).ensure();
-    } else {
-      add_message_stmt_.bind_null(3).ensure();
-    }
-
-    if (sender_dialog_id.is_valid()) {
-      add_message_stmt_.bind_int64(4, sender_dialog_id.get()).ensure();
-    } else {
-      add_message_stmt_.bind_null(4).ensure();
-    }
-
-    if (random_id != 0) {
-      add_message_stmt_.bind_int64(5, random_id).ensure();
-    } else {
-      add_message_stmt_.bind_null(5).ensure();
-    }
-
-    add_message_stmt_.bind_blob(6, data.as_slice()).ensure();
-
-    if (ttl_expires_at != 0) {
-      add_message_stmt_.bind_int32(7, ttl_expires_at).ensure();
-    } else {
-      add_message_stmt_.bind_null(7).ensure();
-    }
+    bind_message(add_message_stmt_, 0, message);
+    add_message_stmt_.step().ensure();
+  }
 
-    if (index_mask != 0) {
-      add_message_stmt_.bind_int32(8, index_mask).ensure();
-    } else {
-      add_message_stmt_.bind_null(8).ensure();
-    }
-    if (search_id != 0) {
-      // add dialog_id to text
-      text += PSTRING() << " \a" << dialog_id.get();
-      if (index_mask != 0) {
-        for (int i = 0; i < MESSAGE_DB_INDEX_COUNT; i++) {
-          if ((index_mask & (1 << i))) {
-            text += PSTRING() << " \a\a" << i;
-          }
-        }
+  void add_messages(vector<MessageDbNewMessage> messages) final {
+    size_t pos = 0;
+    for (; pos + ADD_MESSAGES_BATCH_SIZE <= messages.size(); pos += ADD_MESSAGES_BATCH_SIZE) {
+      SCOPE_EXIT {
+        add_messages_stmt_.reset();
+      };
+      for (size_t i = 0; i < ADD_MESSAGES_BATCH_SIZE; i++) {
+        bind_message(add_messages_stmt_, static_cast<int>(i) * MESSAGE_PARAMETER_COUNT, messages[pos + i]);
       }
-      add_message_stmt_.bind_int64(9, search_id).ensure();
-    } else {
-      text = "";
-      add_message_stmt_.bind_null(9).ensure();
-    }
-    if (!text.empty()) {
-      add_message_stmt_.bind_string(10, text).ensure();
-    } else {
-      add_message_stmt_.bind_null(10).ensure();
-    }
-    if (notification_id.is_valid()) {
-      add_message_stmt_.bind_int32(11, notification_id.get()).ensure();
-    } else {
-      add_message_stmt_.bind_null(11).ensure();
+      add_messages_stmt_.step().ensure();
     }
-    if (top_thread_message_id.is_valid()) {
-      add_message_stmt_.bind_int64(12, top_thread_message_id.get()).ensure();
-    } else {
-      add_message_stmt_.bind_null(12).ensure();
+    for (; pos < messages.size(); pos++) {
+      SCOPE_EXIT {
+        add_message_stmt_.reset();
+      };
+      bind_message(add_message_stmt_, 0, messages[pos]);
+      add_message_stmt_.step().ensure();
     }
-
-    add_message_stmt_.step().ensure();
   }
 
   void add_scheduled_message(MessageFullId message_full_id, BufferSlice data) final {
@@ -384,6 +464,7 @@ class MessageDbImpl final : public MessageDbSyncInterface {
       add_scheduled_message_stmt_.bind_null(3).ensure();
     }
 
+    data = encode_data(std::move(data));
     add_scheduled_message_stmt_.bind_blob(4, data.as_slice()).ensure();
 
     add_scheduled_message_stmt_.step().ensure();
@@ -463,16 +544,17 @@ class MessageDbImpl final : public MessageDbSyncInterface {
       return Status::Error("Not found");
     }
     MessageId received_message_id(stmt.view_int64(0));
-    Slice data = stmt.view_blob(1);
+    auto data = decode_data(stmt.view_blob(1));
     if (is_scheduled_server) {
       CHECK(received_message_id.is_scheduled());
       CHECK(received_message_id.is_scheduled_server());
       CHECK(received_message_id.get_scheduled_server_message_id() == message_id.get_scheduled_server_message_id());
     } else {
       LOG_CHECK(received_message_id == message_id)
-          << received_message_id << ' ' << message_id << ' ' << get_message_info(received_message_id, data, true).first;
+          << received_message_id << ' ' << message_id << ' '
+          << get_message_info(received_message_id, data.as_slice(), true).first;
     }
-    return MessageDbDialogMessage{received_message_id, BufferSlice(data)};
+    return MessageDbDialogMessage{received_message_id, std::move(data)};
   }
 
   Result<MessageDbMessage> get_message_by_unique_message_id(ServerMessageId unique_message_id) final {
@@ -489,7 +571,7 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     }
     DialogId dialog_id(get_message_by_unique_message_id_stmt_.view_int64(0));
     MessageId message_id(get_message_by_unique_message_id_stmt_.view_int64(1));
-    return MessageDbMessage{dialog_id, message_id, BufferSlice(get_message_by_unique_message_id_stmt_.view_blob(2))};
+    return MessageDbMessage{dialog_id, message_id, decode_data(get_message_by_unique_message_id_stmt_.view_blob(2))};
   }
 
   Result<MessageDbDialogMessage> get_message_by_random_id(DialogId dialog_id, int64 random_id) final {
@@ -503,7 +585,7 @@ class MessageDbImpl final : public MessageDbSyncInterface {
       return Status::Error("Not found");
     }
     MessageId message_id(get_message_by_random_id_stmt_.view_int64(0));
-    return MessageDbDialogMessage{message_id, BufferSlice(get_message_by_random_id_stmt_.view_blob(1))};
+    return MessageDbDialogMessage{message_id, decode_data(get_message_by_random_id_stmt_.view_blob(1))};
   }
 
   Result<MessageDbDialogMessage> get_dialog_message_by_date(DialogId dialog_id, MessageId first_message_id,
@@ -581,7 +663,7 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     while (get_expiring_messages_stmt_.has_row()) {
       DialogId dialog_id(get_expiring_messages_stmt_.view_int64(0));
       MessageId message_id(get_expiring_messages_stmt_.view_int64(1));
-      BufferSlice data(get_expiring_messages_stmt_.view_blob(2));
+      auto data = decode_data(get_expiring_messages_stmt_.view_blob(2));
       messages.push_back(MessageDbMessage{dialog_id, message_id, std::move(data)});
       get_expiring_messages_stmt_.step().ensure();
     }
@@ -604,16 +686,16 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     stmt.step().ensure();
     int32 current_day = std::numeric_limits<int32>::max();
     while (stmt.has_row()) {
-      auto data_slice = stmt.view_blob(0);
+      auto data = decode_data(stmt.view_blob(0));
       MessageId message_id(stmt.view_int64(1));
-      auto info = get_message_info(message_id, data_slice, false);
+      auto info = get_message_info(message_id, data.as_slice(), false);
       auto day = (query.tz_offset + info.second) / 86400;
       if (day >= current_day) {
         CHECK(!total_counts.empty());
         total_counts.back()++;
       } else {
         current_day = day;
-        messages.push_back(MessageDbDialogMessage{message_id, BufferSlice(data_slice)});
+        messages.push_back(MessageDbDialogMessage{message_id, std::move(data)});
         total_counts.push_back(1);
       }
       stmt.step().ensure();
@@ -679,9 +761,9 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     vector<MessageDbDialogMessage> result;
     stmt.step().ensure();
     while (stmt.has_row()) {
-      auto data_slice = stmt.view_blob(0);
+      auto data = decode_data(stmt.view_blob(0));
       MessageId message_id(stmt.view_int64(1));
-      result.push_back(MessageDbDialogMessage{message_id, BufferSlice(data_slice)});
+      result.push_back(MessageDbDialogMessage{message_id, std::move(data)});
       LOG(INFO) << "Load " << message_id << " in " << dialog_id << " from database";
       stmt.step().ensure();
     }
@@ -736,10 +818,11 @@ class MessageDbImpl final : public MessageDbSyncInterface {
   }
 
   MessageDbFtsResult get_messages_fts(MessageDbFtsQuery query) final {
-    SCOPE_EXIT {
-      get_messages_fts_stmt_.reset();
-    };
+    return get_messages_fts(std::move(query), nullptr);
+  }
 
+  // if search_ids isn't null, search identifiers of the found messages are appended to it
+  MessageDbFtsResult get_messages_fts(MessageDbFtsQuery query, vector<int64> *search_ids) {
     LOG(INFO) << tag("query", query.query) << query.dialog_id << tag("filter", query.filter)
               << tag("from_search_id", query.from_search_id) << tag("limit", query.limit);
     string words = prepare_query(query.query);
@@ -755,27 +838,60 @@ class MessageDbImpl final : public MessageDbSyncInterface {
       words += PSTRING() << " \"\a\a" << message_search_filter_index(query.filter) << "\"";
     }
 
-    auto &stmt = get_messages_fts_stmt_;
-    stmt.bind_string(1, words).ensure();
     if (query.from_search_id == 0) {
       query.from_search_id = std::numeric_limits<int64>::max();
     }
-    stmt.bind_int64(2, query.from_search_id).ensure();
-    stmt.bind_int32(3, query.limit).ensure();
+    if (query.limit <= 0) {
+      return {};
+    }
+
+    // found search identifiers are prefetched for several pages and cached until the next page is requested
+    FtsCacheEntry entry;
+    bool is_cached = false;
+    auto now = Time::now();
+    for (auto it = fts_cache_.begin(); it != fts_cache_.end(); ++it) {
+      if (it->words == words && it->next_search_id == query.from_search_id && it->expires_at > now) {
+        entry = std::move(*it);
+        fts_cache_.erase(it);
+        is_cached = true;
+        break;
+      }
+    }
+    if (!is_cached) {
+      entry.words = std::move(words);
+      entry.next_search_id = query.from_search_id;
+      entry.is_complete = false;
+    }
+
     MessageDbFtsResult result;
-    auto status = stmt.step();
-    if (status.is_error()) {
-      LOG(ERROR) << status;
-      return result;
+    while (static_cast<int32>(result.messages.size()) < query.limit) {
+      if (entry.next_pos == entry.search_ids.size()) {
+        if (entry.is_complete) {
+          break;
+        }
+        auto status = load_fts_search_ids(entry, query.limit * FTS_PREFETCH_PAGE_COUNT);
+        if (status.is_error()) {
+          LOG(ERROR) << status;
+          return result;
+        }
+        continue;
+      }
+
+      // the message could have been deleted after the search
+      auto search_id = entry.search_ids[entry.next_pos++];
+      entry.next_search_id = search_id;
+      get_messages_by_search_id(search_id, result.messages, search_ids);
     }
-    while (stmt.has_row()) {
-      DialogId dialog_id(stmt.view_int64(0));
-      MessageId message_id(stmt.view_int64(1));
-      auto data_slice = stmt.view_blob(2);
-      auto search_id = stmt.view_int64(3);
-      result.next_search_id = search_id;
-      result.messages.push_back(MessageDbMessage{dialog_id, message_id, BufferSlice(data_slice)});
-      stmt.step().ensure();
+
+    if (entry.next_pos == entry.search_ids.size() && entry.is_complete) {
+      result.next_search_id = 1;
+    } else {
+      result.next_search_id = entry.next_search_id;
+      entry.expires_at = now + FTS_CACHE_TIME;
+      if (fts_cache_.size() == FTS_CACHE_SIZE) {
+        fts_cache_.erase(fts_cache_.begin());
+      }
+      fts_cache_.push_back(std::move(entry));
     }
     return result;
   }
@@ -787,6 +903,11 @@ class MessageDbImpl final : public MessageDbSyncInterface {
   }
 
   MessageDbCallsResult get_calls(MessageDbCallsQuery query) final {
+    return get_calls(query, nullptr);
+  }
+
+  // if unique_message_ids isn't null, unique message identifiers of the found messages are appended to it
+  MessageDbCallsResult get_calls(MessageDbCallsQuery query, vector<int32> *unique_message_ids) {
     int32 pos;
     if (query.filter == MessageSearchFilter::Call) {
       pos = 0;
@@ -809,13 +930,137 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     while (stmt.has_row()) {
       DialogId dialog_id(stmt.view_int64(0));
       MessageId message_id(stmt.view_int64(1));
-      auto data_slice = stmt.view_blob(2);
-      result.messages.push_back(MessageDbMessage{dialog_id, message_id, BufferSlice(data_slice)});
+      auto data = decode_data(stmt.view_blob(2));
+      result.messages.push_back(MessageDbMessage{dialog_id, message_id, std::move(data)});
+      if (unique_message_ids != nullptr) {
+        unique_message_ids->push_back(stmt.view_int32(3));
+      }
       stmt.step().ensure();
     }
     return result;
   }
 
+  void set_fts_options(bool use_deferred_indexing, int32 automerge) final {
+    if (use_deferred_indexing != use_deferred_fts_indexing_) {
+      LOG(INFO) << "Change deferred message indexing to " << use_deferred_indexing;
+      drop_fts_insert_trigger(db_, use_deferred_fts_indexing_).ensure();
+      create_fts_insert_trigger(db_, use_deferred_indexing).ensure();
+      use_deferred_fts_indexing_ = use_deferred_indexing;
+    }
+    db_.exec(PSLICE() << "INSERT INTO messages_fts(messages_fts, rank) VALUES('automerge', " << automerge << ')')
+        .ensure();
+  }
+
+  bool has_pending_fts_messages() final {
+    SCOPE_EXIT {
+      has_pending_fts_messages_stmt_.reset();
+    };
+    has_pending_fts_messages_stmt_.step().ensure();
+    return has_pending_fts_messages_stmt_.has_row();
+  }
+
+  bool index_pending_fts_messages(int32 limit) final {
+    {
+      SCOPE_EXIT {
+        index_pending_fts_messages_stmt_.reset();
+      };
+      index_pending_fts_messages_stmt_.bind_int32(1, limit).ensure();
+      index_pending_fts_messages_stmt_.step().ensure();
+    }
+    {
+      SCOPE_EXIT {
+        delete_pending_fts_messages_stmt_.reset();
+      };
+      delete_pending_fts_messages_stmt_.bind_int32(1, limit).ensure();
+      delete_pending_fts_messages_stmt_.step().ensure();
+    }
+    return has_pending_fts_messages();
+  }
+
+  void rebuild_fts_index() final {
+    td::rebuild_fts_index(db_).ensure();
+  }
+
+  void optimize_fts_index() final {
+    db_.exec("INSERT INTO messages_fts(messages_fts) VALUES('optimize')").ensure();
+  }
+
+  DialogId get_next_message_dialog_id(DialogId after_dialog_id) final {
+    SCOPE_EXIT {
+      get_next_message_dialog_id_stmt_.reset();
+    };
+    get_next_message_dialog_id_stmt_.bind_int64(1, after_dialog_id.get()).ensure();
+    get_next_message_dialog_id_stmt_.step().ensure();
+    if (!get_next_message_dialog_id_stmt_.has_row()) {
+      return DialogId();
+    }
+    return DialogId(get_next_message_dialog_id_stmt_.view_int64(0));
+  }
+
+  MessageDbPrunedMessages delete_old_dialog_messages(DialogId dialog_id, int32 max_date, int32 limit) final {
+    CHECK(limit > 0);
+    auto messages = get_messages_inner(get_messages_stmt_.asc_stmt_, dialog_id, 0, limit + 1);
+    size_t pos = 0;
+    while (pos + 1 < messages.size() && get_message_info(messages[pos]).second < max_date) {
+      pos++;
+    }
+
+    MessageDbPrunedMessages result;
+    if (pos == 0) {
+      return result;
+    }
+    LOG(INFO) << "Delete " << pos << " old messages in " << dialog_id << " from database";
+    delete_all_dialog_messages(dialog_id, messages[pos - 1].message_id);
+    result.deleted_count = static_cast<int32>(pos);
+    result.first_kept_message_id = messages[pos].message_id;
+    result.has_more = static_cast<int32>(pos) == limit;
+    return result;
+  }
+
+  int64 get_database_size() final {
+    auto get_pragma_value = [&](CSlice pragma) -> int64 {
+      auto r_stmt = db_.get_statement(pragma);
+      if (r_stmt.is_error()) {
+        return 0;
+      }
+      auto stmt = r_stmt.move_as_ok();
+      if (stmt.step().is_error() || !stmt.has_row()) {
+        return 0;
+      }
+      return stmt.view_int64(0);
+    };
+    return get_pragma_value("PRAGMA page_count") * get_pragma_value("PRAGMA page_size");
+  }
+
+  void vacuum_incrementally(int32 page_count) final {
+    db_.exec(PSLICE() << "PRAGMA incremental_vacuum(" << page_count << ')').ensure();
+  }
+
+  Status enable_incremental_vacuum() final {
+    auto get_auto_vacuum = [&]() -> Result<int32> {
+      TRY_RESULT(stmt, db_.get_statement("PRAGMA auto_vacuum"));
+      TRY_STATUS(stmt.step());
+      if (!stmt.has_row()) {
+        return Status::Error("Failed to get auto_vacuum");
+      }
+      return stmt.view_int32(0);
+    };
+    TRY_RESULT(auto_vacuum, get_auto_vacuum());
+    if (auto_vacuum == 2) {
+      return Status::OK();
+    }
+    LOG(WARNING) << "Enable incremental vacuum for the message database";
+    TRY_STATUS(db_.exec("PRAGMA auto_vacuum=INCREMENTAL"));
+    return db_.exec("VACUUM");
+  }
+
+  void set_data_compression(bool use_data_compression) final {
+    use_data_compression_ = use_data_compression;
+    if (use_data_compression_ && current_data_dictionary_id_ == 0) {
+      train_data_dictionary();
+    }
+  }
+
   Status begin_write_transaction() final {
     return db_.begin_write_transaction();
   }
@@ -824,9 +1069,142 @@ class MessageDbImpl final : public MessageDbSyncInterface {
   }
 
  private:
+  static constexpr int MESSAGE_PARAMETER_COUNT = 12;
+  static constexpr size_t ADD_MESSAGES_BATCH_SIZE = 16;
+
+  static constexpr int32 FTS_PREFETCH_PAGE_COUNT = 4;
+  static constexpr double FTS_CACHE_TIME = 60.0;
+  static constexpr size_t FTS_CACHE_SIZE = 4;
+
+  struct FtsCacheEntry {
+    string words;
+    int64 next_search_id = 0;  // the last returned search identifier
+    vector<int64> search_ids;  // in decreasing order
+    size_t next_pos = 0;
+    bool is_complete = true;  // there are no found identifiers after search_ids
+    double expires_at = 0.0;
+  };
+  vector<FtsCacheEntry> fts_cache_;
+
+  Status load_fts_search_ids(FtsCacheEntry &entry, int32 limit) {
+    auto &stmt = get_fts_search_ids_stmt_;
+    SCOPE_EXIT {
+      stmt.reset();
+    };
+    stmt.bind_string(1, entry.words).ensure();
+    stmt.bind_int64(2, entry.next_search_id).ensure();
+    stmt.bind_int32(3, limit).ensure();
+
+    entry.search_ids.clear();
+    entry.next_pos = 0;
+    TRY_STATUS(stmt.step());
+    while (stmt.has_row()) {
+      entry.search_ids.push_back(stmt.view_int64(0));
+      TRY_STATUS(stmt.step());
+    }
+    entry.is_complete = static_cast<int32>(entry.search_ids.size()) < limit;
+    return Status::OK();
+  }
+
+  void get_messages_by_search_id(int64 search_id, vector<MessageDbMessage> &messages, vector<int64> *search_ids) {
+    auto &stmt = get_messages_by_search_id_stmt_;
+    SCOPE_EXIT {
+      stmt.reset();
+    };
+    stmt.bind_int64(1, search_id).ensure();
+    stmt.step().ensure();
+    while (stmt.has_row()) {
+      DialogId dialog_id(stmt.view_int64(0));
+      MessageId message_id(stmt.view_int64(1));
+      auto data = decode_data(stmt.view_blob(2));
+      messages.push_back(MessageDbMessage{dialog_id, message_id, std::move(data)});
+      if (search_ids != nullptr) {
+        search_ids->push_back(search_id);
+      }
+      stmt.step().ensure();
+    }
+  }
+
+  // binds the message to the parameters with numbers from first_parameter + 1 to first_parameter + 12;
+  // the message must not be changed until the statement is reset
+  void bind_message(SqliteStatement &stmt, int first_parameter, MessageDbNewMessage &message) {
+    LOG(INFO) << "Add " << message.message_full_id << " to database";
+    auto dialog_id = message.message_full_id.get_dialog_id();
+    auto message_id = message.message_full_id.get_message_id();
+    LOG_CHECK(dialog_id.is_valid()) << dialog_id << ' ' << message_id << ' ' << message.message_full_id;
+    CHECK(message_id.is_valid());
+    auto &text = message.text;
+    stmt.bind_int64(first_parameter + 1, dialog_id.get()).ensure();
+    stmt.bind_int64(first_parameter + 2, message_id.get()).ensure();
+
+    if (message.unique_message_id.is_valid()) {
+      stmt.bind_int32(first_parameter + 3, message.unique_message_id.get()).ensure();
+    } else {
+      stmt.bind_null(first_parameter + 3).ensure();
+    }
+
+    if (message.sender_dialog_id.is_valid()) {
+      stmt.bind_int64(first_parameter + 4, message.sender_dialog_id.get()).ensure();
+    } else {
+      stmt.bind_null(first_parameter + 4).ensure();
+    }
+
+    if (message.random_id != 0) {
+      stmt.bind_int64(first_parameter + 5, message.random_id).ensure();
+    } else {
+      stmt.bind_null(first_parameter + 5).ensure();
+    }
+
+    message.data = encode_data(std::move(message.data));
+    stmt.bind_blob(first_parameter + 6, message.data.as_slice()).ensure();
+
+    if (message.ttl_expires_at != 0) {
+      stmt.bind_int32(first_parameter + 7, message.ttl_expires_at).ensure();
+    } else {
+      stmt.bind_null(first_parameter + 7).ensure();
+    }
+
+    if (message.index_mask != 0) {
+      stmt.bind_int32(first_parameter + 8, message.index_mask).ensure();
+    } else {
+      stmt.bind_null(first_parameter + 8).ensure();
+    }
+    if (message.search_id != 0) {
+      // add dialog_id to text
+      text += PSTRING() << " \a" << dialog_id.get();
+      if (message.index_mask != 0) {
+        for (int i = 0; i < MESSAGE_DB_INDEX_COUNT; i++) {
+          if ((message.index_mask & (1 << i))) {
+            text += PSTRING() << " \a\a" << i;
+          }
+        }
+      }
+      stmt.bind_int64(first_parameter + 9, message.search_id).ensure();
+    } else {
+      text = "";
+      stmt.bind_null(first_parameter + 9).ensure();
+    }
+    if (!text.empty()) {
+      stmt.bind_string(first_parameter + 10, text).ensure();
+    } else {
+      stmt.bind_null(first_parameter + 10).ensure();
+    }
+    if (message.notification_id.is_valid()) {
+      stmt.bind_int32(first_parameter + 11, message.notification_id.get()).ensure();
+    } else {
+      stmt.bind_null(first_parameter + 11).ensure();
+    }
+    if (message.top_thread_message_id.is_valid()) {
+      stmt.bind_int64(first_parameter + 12, message.top_thread_message_id.get()).ensure();
+    } else {
+      stmt.bind_null(first_parameter + 12).ensure();
+    }
+  }
+
   SqliteDb db_;
 
   SqliteStatement add_message_stmt_;
+  SqliteStatement add_messages_stmt_;
 
   SqliteStatement delete_message_stmt_;
   SqliteStatement delete_all_dialog_messages_stmt_;
@@ -849,7 +1227,180 @@ class MessageDbImpl final : public MessageDbSyncInterface {
   std::array<GetMessagesStmt, MESSAGE_DB_INDEX_COUNT> get_messages_from_index_stmts_;
   std::array<SqliteStatement, 2> get_calls_stmts_;
 
-  SqliteStatement get_messages_fts_stmt_;
+  SqliteStatement get_fts_search_ids_stmt_;
+  SqliteStatement get_messages_by_search_id_stmt_;
+  SqliteStatement index_pending_fts_messages_stmt_;
+  SqliteStatement delete_pending_fts_messages_stmt_;
+  SqliteStatement has_pending_fts_messages_stmt_;
+  bool use_deferred_fts_indexing_ = false;
+
+  SqliteStatement get_next_message_dialog_id_stmt_;
+
+  static constexpr size_t MIN_COMPRESSED_DATA_SIZE = 64;
+  static constexpr int32 DATA_DICTIONARY_SAMPLE_COUNT = 2000;
+  static constexpr size_t MIN_DATA_DICTIONARY_SAMPLE_COUNT = 100;
+  static constexpr size_t MAX_DATA_DICTIONARY_SAMPLE_SIZE = 1024;
+  static constexpr size_t MAX_DATA_DICTIONARY_SIZE = 32768;  // deflate window size
+  static constexpr int32 DATA_DICTIONARY_TRAINING_PERIOD = 1000;
+
+  SqliteStatement get_data_dictionary_stmt_;
+  SqliteStatement get_last_data_dictionary_stmt_;
+  SqliteStatement add_data_dictionary_stmt_;
+  SqliteStatement get_data_samples_stmt_;
+  bool use_data_compression_ = false;
+  int64 current_data_dictionary_id_ = 0;
+  int32 data_dictionary_training_counter_ = 0;
+  FlatHashMap<int64, string> data_dictionaries_;
+
+  Result<Slice> get_data_dictionary(int64 dictionary_id) {
+    if (dictionary_id == 0) {
+      return Slice();
+    }
+    auto it = data_dictionaries_.find(dictionary_id);
+    if (it != data_dictionaries_.end()) {
+      return Slice(it->second);
+    }
+
+    // dictionaries are never changed, but can be added by another connection
+    auto &stmt = get_data_dictionary_stmt_;
+    SCOPE_EXIT {
+      stmt.reset();
+    };
+    stmt.bind_int64(1, dictionary_id).ensure();
+    TRY_STATUS(stmt.step());
+    if (!stmt.has_row()) {
+      return Status::Error("Dictionary not found");
+    }
+    auto &dictionary = data_dictionaries_[dictionary_id];
+    dictionary = stmt.view_blob(0).str();
+    return Slice(dictionary);
+  }
+
+  // the dictionary is built from recent messages, so that their common parts are encoded with short back references
+  void train_data_dictionary() {
+    data_dictionary_training_counter_ = 0;
+    {
+      auto &stmt = get_last_data_dictionary_stmt_;
+      SCOPE_EXIT {
+        stmt.reset();
+      };
+      stmt.step().ensure();
+      if (stmt.has_row()) {
+        current_data_dictionary_id_ = stmt.view_int64(0);
+        return;
+      }
+    }
+
+    vector<BufferSlice> samples;
+    size_t total_size = 0;
+    {
+      auto &stmt = get_data_samples_stmt_;
+      SCOPE_EXIT {
+        stmt.reset();
+      };
+      stmt.bind_int32(1, DATA_DICTIONARY_SAMPLE_COUNT).ensure();
+      stmt.step().ensure();
+      while (stmt.has_row() && total_size < MAX_DATA_DICTIONARY_SIZE) {
+        auto data = decode_data(stmt.view_blob(0));
+        if (!data.empty() && data.size() <= MAX_DATA_DICTIONARY_SAMPLE_SIZE) {
+          total_size += data.size();
+          samples.push_back(std::move(data));
+        }
+        stmt.step().ensure();
+      }
+    }
+    if (samples.size() < MIN_DATA_DICTIONARY_SAMPLE_COUNT) {
+      return;
+    }
+
+    // the newest samples are placed at the end of the dictionary
+    string dictionary;
+    for (auto it = samples.rbegin(); it != samples.rend(); ++it) {
+      dictionary += it->as_slice().str();
+    }
+    if (dictionary.size() > MAX_DATA_DICTIONARY_SIZE) {
+      dictionary = dictionary.substr(dictionary.size() - MAX_DATA_DICTIONARY_SIZE);
+    }
+    {
+      auto &stmt = add_data_dictionary_stmt_;
+      SCOPE_EXIT {
+        stmt.reset();
+      };
+      stmt.bind_blob(1, dictionary).ensure();
+      stmt.step().ensure();
+    }
+    {
+      auto &stmt = get_last_data_dictionary_stmt_;
+      SCOPE_EXIT {
+        stmt.reset();
+      };
+      stmt.step().ensure();
+      CHECK(stmt.has_row());
+      current_data_dictionary_id_ = stmt.view_int64(0);
+    }
+    LOG(INFO) << "Create message data dictionary " << current_data_dictionary_id_ << " of size " << dictionary.size()
+              << " from " << samples.size() << " messages";
+    data_dictionaries_[current_data_dictionary_id_] = std::move(dictionary);
+  }
+
+  BufferSlice encode_data(BufferSlice data) {
+    if (!use_data_compression_ || data.size() < MIN_COMPRESSED_DATA_SIZE) {
+      return data;
+    }
+    if (current_data_dictionary_id_ == 0 && ++data_dictionary_training_counter_ >= DATA_DICTIONARY_TRAINING_PERIOD) {
+      train_data_dictionary();
+    }
+    auto r_dictionary = get_data_dictionary(current_data_dictionary_id_);
+    if (r_dictionary.is_error()) {
+      LOG(ERROR) << "Failed to load message data dictionary " << current_data_dictionary_id_ << ": "
+                 << r_dictionary.error();
+      current_data_dictionary_id_ = 0;
+      return data;
+    }
+
+    string header(COMPRESSED_MESSAGE_DATA_MAGIC, COMPRESSED_MESSAGE_DATA_MAGIC_SIZE);
+    header += static_cast<char>(COMPRESSED_MESSAGE_DATA_VERSION);
+    store_varint(header, static_cast<uint64>(current_data_dictionary_id_));
+    store_varint(header, data.size());
+    if (header.size() + 1 >= data.size()) {
+      return data;
+    }
+    auto compressed = deflate_with_dictionary(data.as_slice(), r_dictionary.ok(), data.size() - header.size() - 1);
+    if (compressed.empty()) {
+      return data;
+    }
+    BufferSlice result(header.size() + compressed.size());
+    result.as_mutable_slice().copy_from(header);
+    result.as_mutable_slice().substr(header.size()).copy_from(compressed.as_slice());
+    return result;
+  }
+
+  Result<BufferSlice> decode_compressed_data(Slice data) {
+    data.remove_prefix(COMPRESSED_MESSAGE_DATA_MAGIC_SIZE);
+    if (data.empty() || static_cast<uint8>(data[0]) != COMPRESSED_MESSAGE_DATA_VERSION) {
+      return Status::Error("Unsupported format version");
+    }
+    data.remove_prefix(1);
+    TRY_RESULT(dictionary_id, parse_varint(data));
+    TRY_RESULT(size, parse_varint(data));
+    if (size > (static_cast<uint64>(1) << 30)) {
+      return Status::Error("Invalid data size");
+    }
+    TRY_RESULT(dictionary, get_data_dictionary(static_cast<int64>(dictionary_id)));
+    return inflate_with_dictionary(data, dictionary, static_cast<size_t>(size));
+  }
+
+  BufferSlice decode_data(Slice data) {
+    if (!is_compressed_message_data(data)) {
+      return BufferSlice(data);
+    }
+    auto r_data = decode_compressed_data(data);
+    if (r_data.is_error()) {
+      LOG(ERROR) << "Failed to decode message data: " << r_data.error();
+      return BufferSlice();
+    }
+    return r_data.move_as_ok();
+  }
 
   SqliteStatement add_scheduled_message_stmt_;
   SqliteStatement get_scheduled_message_stmt_;
@@ -857,8 +1408,8 @@ class MessageDbImpl final : public MessageDbSyncInterface {
   SqliteStatement delete_scheduled_message_stmt_;
   SqliteStatement delete_scheduled_server_message_stmt_;
 
-  static vector<MessageDbDialogMessage> get_messages_impl(GetMessagesStmt &stmt, DialogId dialog_id,
-                                                          MessageId from_message_id, int32 offset, int32 limit) {
+  vector<MessageDbDialogMessage> get_messages_impl(GetMessagesStmt &stmt, DialogId dialog_id, MessageId from_message_id,
+                                                   int32 offset, int32 limit) {
     LOG_CHECK(dialog_id.is_valid()) << dialog_id;
     CHECK(from_message_id.is_valid());
 
@@ -909,8 +1460,8 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     return right;
   }
 
-  static vector<MessageDbDialogMessage> get_messages_inner(SqliteStatement &stmt, DialogId dialog_id,
-                                                           int64 from_message_id, int32 limit) {
+  vector<MessageDbDialogMessage> get_messages_inner(SqliteStatement &stmt, DialogId dialog_id, int64 from_message_id,
+                                                    int32 limit) {
     SCOPE_EXIT {
       stmt.reset();
     };
@@ -923,9 +1474,9 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     vector<MessageDbDialogMessage> result;
     stmt.step().ensure();
     while (stmt.has_row()) {
-      auto data_slice = stmt.view_blob(0);
+      auto data = decode_data(stmt.view_blob(0));
       MessageId message_id(stmt.view_int64(1));
-      result.push_back(MessageDbDialogMessage{message_id, BufferSlice(data_slice)});
+      result.push_back(MessageDbDialogMessage{message_id, std::move(data)});
       LOG(INFO) << "Loaded " << message_id << " in " << dialog_id << " from database";
       stmt.step().ensure();
     }
@@ -963,6 +1514,286 @@ class MessageDbImpl final : public MessageDbSyncInterface {
   }
 };
 
+// messages of a dialog are stored in the shard chosen by the dialog identifier;
+// queries not restricted to a dialog are sent to all shards and their results are merged
+class MessageDbShardedImpl final : public MessageDbSyncInterface {
+ public:
+  explicit MessageDbShardedImpl(vector<unique_ptr<MessageDbImpl>> shards) : shards_(std::move(shards)) {
+    CHECK(!shards_.empty());
+  }
+
+  void add_message(MessageFullId message_full_id, ServerMessageId unique_message_id, DialogId sender_dialog_id,
+                   int64 random_id, int32 ttl_expires_at, int32 index_mask, int64 search_id, string text,
+                   NotificationId notification_id, MessageId top_thread_message_id, BufferSlice data) final {
+    get_shard(message_full_id.get_dialog_id())
+        .add_message(message_full_id, unique_message_id, sender_dialog_id, random_id, ttl_expires_at, index_mask,
+                     search_id, std::move(text), notification_id, top_thread_message_id, std::move(data));
+  }
+
+  void add_messages(vector<MessageDbNewMessage> messages) final {
+    vector<vector<MessageDbNewMessage>> shard_messages(shards_.size());
+    for (auto &message : messages) {
+      shard_messages[get_shard_index(message.message_full_id.get_dialog_id())].push_back(std::move(message));
+    }
+    for (size_t i = 0; i < shards_.size(); i++) {
+      if (!shard_messages[i].empty()) {
+        shards_[i]->add_messages(std::move(shard_messages[i]));
+      }
+    }
+  }
+
+  void add_scheduled_message(MessageFullId message_full_id, BufferSlice data) final {
+    get_shard(message_full_id.get_dialog_id()).add_scheduled_message(message_full_id, std::move(data));
+  }
+
+  void delete_message(MessageFullId message_full_id) final {
+    get_shard(message_full_id.get_dialog_id()).delete_message(message_full_id);
+  }
+
+  void delete_all_dialog_messages(DialogId dialog_id, MessageId from_message_id) final {
+    get_shard(dialog_id).delete_all_dialog_messages(dialog_id, from_message_id);
+  }
+
+  void delete_dialog_messages_by_sender(DialogId dialog_id, DialogId sender_dialog_id) final {
+    get_shard(dialog_id).delete_dialog_messages_by_sender(dialog_id, sender_dialog_id);
+  }
+
+  Result<MessageDbDialogMessage> get_message(MessageFullId message_full_id) final {
+    return get_shard(message_full_id.get_dialog_id()).get_message(message_full_id);
+  }
+
+  Result<MessageDbMessage> get_message_by_unique_message_id(ServerMessageId unique_message_id) final {
+    if (!unique_message_id.is_valid()) {
+      return Status::Error("Invalid unique_message_id");
+    }
+    for (auto &shard : shards_) {
+      auto r_message = shard->get_message_by_unique_message_id(unique_message_id);
+      if (r_message.is_ok()) {
+        return r_message;
+      }
+    }
+    return Status::Error("Not found");
+  }
+
+  Result<MessageDbDialogMessage> get_message_by_random_id(DialogId dialog_id, int64 random_id) final {
+    return get_shard(dialog_id).get_message_by_random_id(dialog_id, random_id);
+  }
+
+  Result<MessageDbDialogMessage> get_dialog_message_by_date(DialogId dialog_id, MessageId first_message_id,
+                                                            MessageId last_message_id, int32 date) final {
+    return get_shard(dialog_id).get_dialog_message_by_date(dialog_id, first_message_id, last_message_id, date);
+  }
+
+  MessageDbCalendar get_dialog_message_calendar(MessageDbDialogCalendarQuery query) final {
+    return get_shard(query.dialog_id).get_dialog_message_calendar(std::move(query));
+  }
+
+  Result<MessageDbMessagePositions> get_dialog_sparse_message_positions(
+      MessageDbGetDialogSparseMessagePositionsQuery query) final {
+    return get_shard(query.dialog_id).get_dialog_sparse_message_positions(std::move(query));
+  }
+
+  vector<MessageDbDialogMessage> get_messages(MessageDbMessagesQuery query) final {
+    return get_shard(query.dialog_id).get_messages(std::move(query));
+  }
+
+  vector<MessageDbDialogMessage> get_scheduled_messages(DialogId dialog_id, int32 limit) final {
+    return get_shard(dialog_id).get_scheduled_messages(dialog_id, limit);
+  }
+
+  vector<MessageDbDialogMessage> get_messages_from_notification_id(DialogId dialog_id,
+                                                                   NotificationId from_notification_id,
+                                                                   int32 limit) final {
+    return get_shard(dialog_id).get_messages_from_notification_id(dialog_id, from_notification_id, limit);
+  }
+
+  vector<MessageDbMessage> get_expiring_messages(int32 expires_till, int32 limit) final {
+    // the order of expiring messages isn't specified, so they can be taken from shards one by one
+    vector<MessageDbMessage> messages;
+    for (auto &shard : shards_) {
+      if (static_cast<int32>(messages.size()) >= limit) {
+        break;
+      }
+      auto shard_messages =
+          shard->get_expiring_messages(expires_till, limit - static_cast<int32>(messages.size()));
+      std::move(shard_messages.begin(), shard_messages.end(), std::back_inserter(messages));
+    }
+    return messages;
+  }
+
+  MessageDbCallsResult get_calls(MessageDbCallsQuery query) final {
+    vector<std::pair<int32, MessageDbMessage>> found_messages;
+    for (auto &shard : shards_) {
+      vector<int32> unique_message_ids;
+      auto shard_result = shard->get_calls(query, &unique_message_ids);
+      CHECK(unique_message_ids.size() == shard_result.messages.size());
+      for (size_t i = 0; i < unique_message_ids.size(); i++) {
+        found_messages.emplace_back(unique_message_ids[i], std::move(shard_result.messages[i]));
+      }
+    }
+    std::stable_sort(found_messages.begin(), found_messages.end(),
+                     [](const auto &lhs, const auto &rhs) { return lhs.first > rhs.first; });
+
+    MessageDbCallsResult result;
+    for (auto &found_message : found_messages) {
+      if (static_cast<int32>(result.messages.size()) >= query.limit) {
+        break;
+      }
+      result.messages.push_back(std::move(found_message.second));
+    }
+    return result;
+  }
+
+  MessageDbFtsResult get_messages_fts(MessageDbFtsQuery query) final {
+    if (query.dialog_id.is_valid()) {
+      return get_shard(query.dialog_id).get_messages_fts(std::move(query));
+    }
+
+    // every shard returns its first limit messages, so the first limit merged messages are the first globally
+    bool is_complete = true;
+    vector<std::pair<int64, MessageDbMessage>> found_messages;
+    for (auto &shard : shards_) {
+      vector<int64> search_ids;
+      auto shard_result = shard->get_messages_fts(query, &search_ids);
+      CHECK(search_ids.size() == shard_result.messages.size());
+      if (shard_result.next_search_id != 1) {
+        is_complete = false;
+      }
+      for (size_t i = 0; i < search_ids.size(); i++) {
+        found_messages.emplace_back(search_ids[i], std::move(shard_result.messages[i]));
+      }
+    }
+    std::stable_sort(found_messages.begin(), found_messages.end(),
+                     [](const auto &lhs, const auto &rhs) { return lhs.first > rhs.first; });
+
+    // messages with the same search identifier must be returned together, because the next page starts after it
+    MessageDbFtsResult result;
+    size_t pos = 0;
+    while (pos < found_messages.size() &&
+           (static_cast<int32>(result.messages.size()) < query.limit ||
+            (pos > 0 && found_messages[pos].first == found_messages[pos - 1].first))) {
+      result.next_search_id = found_messages[pos].first;
+      result.messages.push_back(std::move(found_messages[pos].second));
+      pos++;
+    }
+    if (pos == found_messages.size() && is_complete) {
+      result.next_search_id = 1;
+    }
+    return result;
+  }
+
+  void set_fts_options(bool use_deferred_indexing, int32 automerge) final {
+    for (auto &shard : shards_) {
+      shard->set_fts_options(use_deferred_indexing, automerge);
+    }
+  }
+
+  bool has_pending_fts_messages() final {
+    for (auto &shard : shards_) {
+      if (shard->has_pending_fts_messages()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool index_pending_fts_messages(int32 limit) final {
+    for (auto &shard : shards_) {
+      if (shard->has_pending_fts_messages()) {
+        shard->index_pending_fts_messages(limit);
+        return has_pending_fts_messages();
+      }
+    }
+    return false;
+  }
+
+  void rebuild_fts_index() final {
+    for (auto &shard : shards_) {
+      shard->rebuild_fts_index();
+    }
+  }
+
+  void optimize_fts_index() final {
+    for (auto &shard : shards_) {
+      shard->optimize_fts_index();
+    }
+  }
+
+  DialogId get_next_message_dialog_id(DialogId after_dialog_id) final {
+    DialogId result;
+    for (auto &shard : shards_) {
+      auto dialog_id = shard->get_next_message_dialog_id(after_dialog_id);
+      if (dialog_id.is_valid() && (!result.is_valid() || dialog_id.get() < result.get())) {
+        result = dialog_id;
+      }
+    }
+    return result;
+  }
+
+  MessageDbPrunedMessages delete_old_dialog_messages(DialogId dialog_id, int32 max_date, int32 limit) final {
+    return get_shard(dialog_id).delete_old_dialog_messages(dialog_id, max_date, limit);
+  }
+
+  int64 get_database_size() final {
+    int64 result = 0;
+    for (auto &shard : shards_) {
+      result += shard->get_database_size();
+    }
+    return result;
+  }
+
+  void vacuum_incrementally(int32 page_count) final {
+    for (auto &shard : shards_) {
+      shard->vacuum_incrementally(page_count);
+    }
+  }
+
+  Status enable_incremental_vacuum() final {
+    for (auto &shard : shards_) {
+      TRY_STATUS(shard->enable_incremental_vacuum());
+    }
+    return Status::OK();
+  }
+
+  void set_data_compression(bool use_data_compression) final {
+    for (auto &shard : shards_) {
+      shard->set_data_compression(use_data_compression);
+    }
+  }
+
+  // transactions in unchanged shards are empty, so their commit doesn't write anything
+  Status begin_write_transaction() final {
+    for (auto &shard : shards_) {
+      TRY_STATUS(shard->begin_write_transaction());
+    }
+    return Status::OK();
+  }
+  Status commit_transaction() final {
+    for (auto &shard : shards_) {
+      TRY_STATUS(shard->commit_transaction());
+    }
+    return Status::OK();
+  }
+
+ private:
+  vector<unique_ptr<MessageDbImpl>> shards_;
+
+  size_t get_shard_index(DialogId dialog_id) const {
+    return get_message_db_shard_index(dialog_id, shards_.size());
+  }
+
+  MessageDbImpl &get_shard(DialogId dialog_id) {
+    return *shards_[get_shard_index(dialog_id)];
+  }
+};
+
+size_t get_message_db_shard_index(DialogId dialog_id, size_t shard_count) {
+  CHECK(shard_count > 0);
+  // the function must never change, because it defines placement of already stored messages
+  auto hash = static_cast<uint64>(dialog_id.get()) * static_cast<uint64>(0x9E3779B97F4A7C15);
+  return static_cast<size_t>((hash >> 32) % shard_count);
+}
+
 std::shared_ptr<MessageDbSyncSafeInterface> create_message_db_sync(
     std::shared_ptr<SqliteConnectionSafe> sqlite_connection) {
   class MessageDbSyncSafe final : public MessageDbSyncSafeInterface {
@@ -982,10 +1813,37 @@ std::shared_ptr<MessageDbSyncSafeInterface> create_message_db_sync(
   return std::make_shared<MessageDbSyncSafe>(std::move(sqlite_connection));
 }
 
+std::shared_ptr<MessageDbSyncSafeInterface> create_message_db_sync(
+    vector<std::shared_ptr<SqliteConnectionSafe>> sqlite_connections) {
+  CHECK(!sqlite_connections.empty());
+  if (sqlite_connections.size() == 1) {
+    return create_message_db_sync(std::move(sqlite_connections[0]));
+  }
+  class MessageDbShardedSyncSafe final : public MessageDbSyncSafeInterface {
+   public:
+    explicit MessageDbShardedSyncSafe(vector<std::shared_ptr<SqliteConnectionSafe>> sqlite_connections)
+        : lsls_db_([safe_connections = std::move(sqlite_connections)] {
+          vector<unique_ptr<MessageDbImpl>> shards;
+          for (auto &safe_connection : safe_connections) {
+            shards.push_back(td::make_unique<MessageDbImpl>(safe_connection->get().clone()));
+          }
+          return td::make_unique<MessageDbShardedImpl>(std::move(shards));
+        }) {
+    }
+    MessageDbSyncInterface &get() final {
+      return *lsls_db_.get();
+    }
+
+   private:
+    LazySchedulerLocalStorage<unique_ptr<MessageDbSyncInterface>> lsls_db_;
+  };
+  return std::make_shared<MessageDbShardedSyncSafe>(std::move(sqlite_connections));
+}
+
 class MessageDbAsync final : public MessageDbAsyncInterface {
  public:
-  MessageDbAsync(std::shared_ptr<MessageDbSyncSafeInterface> sync_db, int32 scheduler_id) {
-    impl_ = create_actor_on_scheduler<Impl>("MessageDbActor", scheduler_id, std::move(sync_db));
+  MessageDbAsync(std::shared_ptr<MessageDbSyncSafeInterface> sync_db, int32 scheduler_id, int32 read_scheduler_id) {
+    impl_ = create_actor_on_scheduler<Impl>("MessageDbActor", scheduler_id, std::move(sync_db), read_scheduler_id);
   }
 
   void add_message(MessageFullId message_full_id, ServerMessageId unique_message_id, DialogId sender_dialog_id,
@@ -1055,6 +1913,27 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
     send_closure_later(impl_, &Impl::get_expiring_messages, expires_till, limit, std::move(promise));
   }
 
+  void set_fts_options(bool use_deferred_indexing, int32 automerge) final {
+    send_closure_later(impl_, &Impl::set_fts_options, use_deferred_indexing, automerge);
+  }
+
+  void rebuild_fts_index(Promise<> promise) final {
+    send_closure_later(impl_, &Impl::rebuild_fts_index, std::move(promise));
+  }
+
+  void optimize_fts_index(Promise<> promise) final {
+    send_closure_later(impl_, &Impl::optimize_fts_index, std::move(promise));
+  }
+
+  void set_data_compression(bool use_data_compression) final {
+    send_closure_later(impl_, &Impl::set_data_compression, use_data_compression);
+  }
+
+  void set_retention_policy(MessageDbRetentionPolicy policy,
+                            std::shared_ptr<MessageDbRetentionCallback> callback) final {
+    send_closure_later(impl_, &Impl::set_retention_policy, policy, std::move(callback));
+  }
+
   void close(Promise<> promise) final {
     send_closure_later(impl_, &Impl::close, std::move(promise));
   }
@@ -1064,22 +1943,36 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
   }
 
  private:
+  using Reader = DbReader<MessageDbSyncSafeInterface, MessageDbSyncInterface>;
+
   class Impl final : public Actor {
    public:
-    explicit Impl(std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe) : sync_db_safe_(std::move(sync_db_safe)) {
+    Impl(std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe, int32 read_scheduler_id)
+        : sync_db_safe_(std::move(sync_db_safe)), read_scheduler_id_(read_scheduler_id) {
     }
     void add_message(MessageFullId message_full_id, ServerMessageId unique_message_id, DialogId sender_dialog_id,
                      int64 random_id, int32 ttl_expires_at, int32 index_mask, int64 search_id, string text,
                      NotificationId notification_id, MessageId top_thread_message_id, BufferSlice data,
                      Promise<> promise) {
-      add_write_query([this, message_full_id, unique_message_id, sender_dialog_id, random_id, ttl_expires_at,
-                       index_mask, search_id, text = std::move(text), notification_id, top_thread_message_id,
-                       data = std::move(data), promise = std::move(promise)](Unit) mutable {
-        sync_db_->add_message(message_full_id, unique_message_id, sender_dialog_id, random_id, ttl_expires_at,
-                              index_mask, search_id, std::move(text), notification_id, top_thread_message_id,
-                              std::move(data));
-        on_write_result(std::move(promise));
-      });
+      // consecutive messages are added to the database with a multi-row insert
+      MessageDbNewMessage message;
+      message.message_full_id = message_full_id;
+      message.unique_message_id = unique_message_id;
+      message.sender_dialog_id = sender_dialog_id;
+      message.random_id = random_id;
+      message.ttl_expires_at = ttl_expires_at;
+      message.index_mask = index_mask;
+      message.search_id = search_id;
+      message.text = std::move(text);
+      message.notification_id = notification_id;
+      message.top_thread_message_id = top_thread_message_id;
+      message.data = std::move(data);
+      if (search_id != 0) {
+        has_new_fts_messages_ = true;
+      }
+      pending_new_messages_.push_back(std::move(message));
+      pending_new_message_promises_.push_back(std::move(promise));
+      on_pending_write_added();
     }
     void add_scheduled_message(MessageFullId message_full_id, BufferSlice data, Promise<> promise) {
       add_write_query([this, message_full_id, promise = std::move(promise), data = std::move(data)](Unit) mutable {
@@ -1131,19 +2024,22 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
     }
 
     void get_dialog_message_calendar(MessageDbDialogCalendarQuery query, Promise<MessageDbCalendar> promise) {
-      add_read_query();
-      promise.set_value(sync_db_->get_dialog_message_calendar(std::move(query)));
+      add_long_read_query(std::move(promise), [query = std::move(query)](MessageDbSyncInterface *sync_db) mutable {
+        return sync_db->get_dialog_message_calendar(std::move(query));
+      });
     }
 
     void get_dialog_sparse_message_positions(MessageDbGetDialogSparseMessagePositionsQuery query,
                                              Promise<MessageDbMessagePositions> promise) {
-      add_read_query();
-      promise.set_result(sync_db_->get_dialog_sparse_message_positions(std::move(query)));
+      add_long_read_query(std::move(promise), [query = std::move(query)](MessageDbSyncInterface *sync_db) mutable {
+        return sync_db->get_dialog_sparse_message_positions(std::move(query));
+      });
     }
 
     void get_messages(MessageDbMessagesQuery query, Promise<vector<MessageDbDialogMessage>> promise) {
-      add_read_query();
-      promise.set_value(sync_db_->get_messages(std::move(query)));
+      add_long_read_query(std::move(promise), [query = std::move(query)](MessageDbSyncInterface *sync_db) mutable {
+        return sync_db->get_messages(std::move(query));
+      });
     }
     void get_scheduled_messages(DialogId dialog_id, int32 limit, Promise<vector<MessageDbDialogMessage>> promise) {
       add_read_query();
@@ -1155,23 +2051,68 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
       promise.set_value(sync_db_->get_messages_from_notification_id(dialog_id, from_notification_id, limit));
     }
     void get_calls(MessageDbCallsQuery query, Promise<MessageDbCallsResult> promise) {
-      add_read_query();
-      promise.set_value(sync_db_->get_calls(std::move(query)));
+      add_long_read_query(std::move(promise), [query = std::move(query)](MessageDbSyncInterface *sync_db) mutable {
+        return sync_db->get_calls(std::move(query));
+      });
     }
     void get_messages_fts(MessageDbFtsQuery query, Promise<MessageDbFtsResult> promise) {
-      add_read_query();
-      promise.set_value(sync_db_->get_messages_fts(std::move(query)));
+      add_long_read_query(std::move(promise), [query = std::move(query)](MessageDbSyncInterface *sync_db) mutable {
+        return sync_db->get_messages_fts(std::move(query));
+      });
     }
     void get_expiring_messages(int32 expires_till, int32 limit, Promise<vector<MessageDbMessage>> promise) {
       add_read_query();
       promise.set_value(sync_db_->get_expiring_messages(expires_till, limit));
     }
 
+    void set_fts_options(bool use_deferred_indexing, int32 automerge) {
+      use_deferred_fts_indexing_ = use_deferred_indexing;
+      add_write_query([this, use_deferred_indexing, automerge](Unit) {
+        sync_db_->set_fts_options(use_deferred_indexing, automerge);
+      });
+    }
+
+    void rebuild_fts_index(Promise<> promise) {
+      add_write_query([this, promise = std::move(promise)](Unit) mutable {
+        sync_db_->rebuild_fts_index();
+        need_optimize_fts_index_ = true;
+        on_write_result(std::move(promise));
+      });
+      on_fts_messages_added();
+    }
+
+    void optimize_fts_index(Promise<> promise) {
+      add_write_query([this, promise = std::move(promise)](Unit) mutable {
+        sync_db_->optimize_fts_index();
+        on_write_result(std::move(promise));
+      });
+    }
+
+    void set_data_compression(bool use_data_compression) {
+      add_write_query([this, use_data_compression](Unit) { sync_db_->set_data_compression(use_data_compression); });
+    }
+
+    void set_retention_policy(MessageDbRetentionPolicy policy, std::shared_ptr<MessageDbRetentionCallback> callback) {
+      retention_policy_ = policy;
+      retention_callback_ = std::move(callback);
+      if (!retention_policy_.is_enabled()) {
+        retention_at_ = 0;
+        is_retention_pass_active_ = false;
+      } else if (retention_at_ == 0) {
+        retention_at_ = Time::now() + RETENTION_START_DELAY;
+      }
+      update_timeout();
+    }
+
     void close(Promise<> promise) {
       do_flush();
       sync_db_safe_.reset();
       sync_db_ = nullptr;
-      promise.set_value(Unit());
+      if (reader_.empty()) {
+        promise.set_value(Unit());
+      } else {
+        send_closure(reader_, &Reader::close, std::move(promise));
+      }
       stop();
     }
 
@@ -1183,32 +2124,241 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
    private:
     std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe_;
     MessageDbSyncInterface *sync_db_ = nullptr;
+    int32 read_scheduler_id_ = -1;
+    ActorOwn<Reader> reader_;
 
     static constexpr size_t MAX_PENDING_QUERIES_COUNT{50};
     static constexpr double MAX_PENDING_QUERIES_DELAY{0.01};
 
+    static constexpr int32 FTS_INDEX_BATCH_SIZE{1000};
+    static constexpr double FTS_INDEX_IDLE_DELAY{1.0};
+    static constexpr double FTS_INDEX_MAX_DELAY{10.0};
+    static constexpr double FTS_INDEX_BATCH_DELAY{0.05};
+
+    bool use_deferred_fts_indexing_ = false;
+    bool has_pending_fts_messages_ = false;
+    bool has_new_fts_messages_ = false;  // there are new messages with search_id since the last flush
+    bool need_optimize_fts_index_ = false;
+    double fts_index_at_ = 0;
+    double fts_index_deadline_ = 0;
+
+    static constexpr int32 RETENTION_BATCH_SIZE{100};
+    static constexpr int32 RETENTION_MAX_BATCH_DIALOG_COUNT{100};
+    static constexpr double RETENTION_START_DELAY{60.0};
+    static constexpr double RETENTION_BATCH_DELAY{0.1};
+    static constexpr double RETENTION_PASS_PERIOD{3600.0};
+    static constexpr int32 RETENTION_VACUUM_PAGE_COUNT{1000};
+    static constexpr int32 RETENTION_MAX_SIZE_MAX_AGE{365 * 86400};
+    static constexpr int32 RETENTION_MIN_SIZE_MAX_AGE{86400};
+
+    MessageDbRetentionPolicy retention_policy_;
+    std::shared_ptr<MessageDbRetentionCallback> retention_callback_;
+    double retention_at_ = 0;
+    bool is_retention_pass_active_ = false;
+    DialogId retention_dialog_id_;  // the last processed chat in the current pass
+    bool has_more_old_messages_ = false;
+    int32 size_max_age_ = 0;  // age limit for all chats, applied while the database is too big
+    bool is_database_too_big_ = false;
+    int32 retention_pass_deleted_count_ = 0;
+    bool is_incremental_vacuum_checked_ = false;
+
     //NB: order is important, destructor of pending_writes_ will change finished_writes_
     vector<Promise<Unit>> finished_writes_;
     vector<Promise<Unit>> pending_writes_;  // TODO use Action
+    vector<MessageDbNewMessage> pending_new_messages_;
+    vector<Promise<Unit>> pending_new_message_promises_;
     double wakeup_at_ = 0;
 
+    void flush_new_messages() {
+      if (pending_new_messages_.empty()) {
+        return;
+      }
+      pending_writes_.push_back(PromiseCreator::lambda([this, messages = std::move(pending_new_messages_),
+                                                        promises = std::move(pending_new_message_promises_)](
+                                                           Unit) mutable {
+        sync_db_->add_messages(std::move(messages));
+        for (auto &promise : promises) {
+          on_write_result(std::move(promise));
+        }
+      }));
+      pending_new_messages_.clear();
+      pending_new_message_promises_.clear();
+    }
+
     template <class F>
     void add_write_query(F &&f) {
+      flush_new_messages();
       pending_writes_.push_back(PromiseCreator::lambda(std::forward<F>(f)));
-      if (pending_writes_.size() > MAX_PENDING_QUERIES_COUNT) {
+      on_pending_write_added();
+    }
+    void on_pending_write_added() {
+      if (pending_writes_.size() + pending_new_messages_.size() > MAX_PENDING_QUERIES_COUNT) {
         do_flush();
-        wakeup_at_ = 0;
       } else if (wakeup_at_ == 0) {
         wakeup_at_ = Time::now_cached() + MAX_PENDING_QUERIES_DELAY;
       }
-      if (wakeup_at_ != 0) {
-        set_timeout_at(wakeup_at_);
+      update_timeout();
+    }
+    void update_timeout() {
+      double timeout_at = wakeup_at_;
+      if (has_pending_fts_messages_ && (timeout_at == 0 || fts_index_at_ < timeout_at)) {
+        timeout_at = fts_index_at_;
+      }
+      if (retention_at_ != 0 && (timeout_at == 0 || retention_at_ < timeout_at)) {
+        timeout_at = retention_at_;
+      }
+      if (timeout_at == 0) {
+        cancel_timeout();
+      } else {
+        set_timeout_at(timeout_at);
+      }
+    }
+
+    // pending messages are indexed after FTS_INDEX_IDLE_DELAY without writes, but no later than FTS_INDEX_MAX_DELAY
+    void on_fts_messages_added() {
+      auto now = Time::now();
+      if (!has_pending_fts_messages_) {
+        has_pending_fts_messages_ = true;
+        fts_index_deadline_ = now + FTS_INDEX_MAX_DELAY;
+      }
+      fts_index_at_ = min(now + FTS_INDEX_IDLE_DELAY, fts_index_deadline_);
+      update_timeout();
+    }
+    void index_pending_fts_messages() {
+      sync_db_->begin_write_transaction().ensure();
+      has_pending_fts_messages_ = sync_db_->index_pending_fts_messages(FTS_INDEX_BATCH_SIZE);
+      if (!has_pending_fts_messages_ && need_optimize_fts_index_) {
+        need_optimize_fts_index_ = false;
+        sync_db_->optimize_fts_index();
+      }
+      sync_db_->commit_transaction().ensure();
+      if (has_pending_fts_messages_) {
+        fts_index_at_ = Time::now() + FTS_INDEX_BATCH_DELAY;
+        fts_index_deadline_ = fts_index_at_;
+      }
+    }
+
+    int32 get_retention_max_age(DialogType dialog_type) const {
+      int32 max_age = 0;
+      switch (dialog_type) {
+        case DialogType::User:
+        case DialogType::SecretChat:
+          max_age = retention_policy_.private_chat_max_age;
+          break;
+        case DialogType::Chat:
+          max_age = retention_policy_.group_max_age;
+          break;
+        case DialogType::Channel:
+          max_age = retention_policy_.channel_max_age;
+          break;
+        case DialogType::None:
+        default:
+          break;
+      }
+      if (size_max_age_ > 0 && (max_age == 0 || size_max_age_ < max_age)) {
+        max_age = size_max_age_;
+      }
+      return max_age;
+    }
+
+    // while the database is bigger than the limit, the age limit for all chats is halved after every pass
+    void start_retention_pass() {
+      auto max_size = retention_policy_.max_database_size;
+      auto size = max_size > 0 ? sync_db_->get_database_size() : 0;
+      is_database_too_big_ = max_size > 0 && size > max_size;
+      if (is_database_too_big_) {
+        size_max_age_ =
+            size_max_age_ == 0 ? RETENTION_MAX_SIZE_MAX_AGE : max(size_max_age_ / 2, RETENTION_MIN_SIZE_MAX_AGE);
+        LOG(INFO) << "Message database size is " << size << " instead of " << max_size << ", delete messages older than "
+                  << size_max_age_ << " seconds";
+      } else if (size <= max_size / 4 * 3) {
+        size_max_age_ = 0;
+      }
+      is_retention_pass_active_ = true;
+      retention_dialog_id_ = DialogId(std::numeric_limits<int64>::min());
+      has_more_old_messages_ = false;
+      retention_pass_deleted_count_ = 0;
+    }
+
+    // the database is converted before the first pass, so that the freed pages can be returned to the file system
+    void enable_incremental_vacuum() {
+      if (is_incremental_vacuum_checked_) {
+        return;
+      }
+      is_incremental_vacuum_checked_ = true;
+      auto status = sync_db_->enable_incremental_vacuum();
+      if (status.is_error()) {
+        LOG(ERROR) << "Failed to enable incremental vacuum: " << status;
       }
     }
+
+    void prune_old_messages() {
+      enable_incremental_vacuum();
+      if (!is_retention_pass_active_) {
+        start_retention_pass();
+      }
+
+      auto now = static_cast<int32>(Clocks::system());
+      vector<std::pair<DialogId, MessageId>> pruned_dialogs;
+      int32 deleted_count = 0;
+      sync_db_->begin_write_transaction().ensure();
+      for (int32 i = 0; i < RETENTION_MAX_BATCH_DIALOG_COUNT && deleted_count < RETENTION_BATCH_SIZE; i++) {
+        if (!has_more_old_messages_) {
+          retention_dialog_id_ = sync_db_->get_next_message_dialog_id(retention_dialog_id_);
+          if (!retention_dialog_id_.is_valid()) {
+            is_retention_pass_active_ = false;
+            break;
+          }
+        }
+        has_more_old_messages_ = false;
+        auto max_age = get_retention_max_age(retention_dialog_id_.get_type());
+        if (max_age <= 0) {
+          continue;
+        }
+        auto pruned_messages = sync_db_->delete_old_dialog_messages(retention_dialog_id_, now - max_age,
+                                                                   RETENTION_BATCH_SIZE - deleted_count);
+        if (pruned_messages.deleted_count > 0) {
+          deleted_count += pruned_messages.deleted_count;
+          pruned_dialogs.emplace_back(retention_dialog_id_, pruned_messages.first_kept_message_id);
+        }
+        has_more_old_messages_ = pruned_messages.has_more;
+      }
+      if (deleted_count > 0) {
+        retention_pass_deleted_count_ += deleted_count;
+        sync_db_->vacuum_incrementally(RETENTION_VACUUM_PAGE_COUNT);
+      }
+      sync_db_->commit_transaction().ensure();
+
+      if (retention_callback_ != nullptr) {
+        for (auto &pruned_dialog : pruned_dialogs) {
+          retention_callback_->on_messages_pruned(pruned_dialog.first, pruned_dialog.second);
+        }
+      }
+
+      // the next pass is started immediately if the database is still too big and the age limit can be decreased
+      if (is_retention_pass_active_ ||
+          (is_database_too_big_ && (retention_pass_deleted_count_ > 0 || size_max_age_ > RETENTION_MIN_SIZE_MAX_AGE))) {
+        retention_at_ = Time::now() + RETENTION_BATCH_DELAY;
+      } else {
+        retention_at_ = Time::now() + RETENTION_PASS_PERIOD;
+      }
+    }
+
     void add_read_query() {
       do_flush();
     }
+
+    // the query is run by the reader, if any, after all previous writes are committed
+    template <class T, class F>
+    void add_long_read_query(Promise<T> &&promise, F &&f) {
+      do_flush();
+      if (reader_.empty()) {
+        return promise.set_result(f(sync_db_));
+      }
+      Reader::send_query(reader_.get(), std::move(promise), std::forward<F>(f));
+    }
     void do_flush() {
+      flush_new_messages();
       if (pending_writes_.empty()) {
         return;
       }
@@ -1216,22 +2366,42 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
       set_promises(pending_writes_);
       sync_db_->commit_transaction().ensure();
       set_promises(finished_writes_);
-      cancel_timeout();
+      wakeup_at_ = 0;
+      // the indexer is kicked only if the flushed messages could be added to messages_fts_pending
+      if (use_deferred_fts_indexing_ && has_new_fts_messages_) {
+        on_fts_messages_added();
+      } else {
+        update_timeout();
+      }
+      has_new_fts_messages_ = false;
     }
     void timeout_expired() final {
       do_flush();
+      if (has_pending_fts_messages_ && Time::now() >= fts_index_at_) {
+        index_pending_fts_messages();
+      }
+      if (retention_at_ != 0 && Time::now() >= retention_at_) {
+        prune_old_messages();
+      }
+      update_timeout();
     }
 
     void start_up() final {
       sync_db_ = &sync_db_safe_->get();
+      if (read_scheduler_id_ != -1) {
+        reader_ = create_actor_on_scheduler<Reader>("MessageDbReader", read_scheduler_id_, sync_db_safe_);
+      }
+      if (sync_db_->has_pending_fts_messages()) {
+        on_fts_messages_added();
+      }
     }
   };
   ActorOwn<Impl> impl_;
 };
 
 std::shared_ptr<MessageDbAsyncInterface> create_message_db_async(std::shared_ptr<MessageDbSyncSafeInterface> sync_db,
-                                                                 int32 scheduler_id) {
-  return std::make_shared<MessageDbAsync>(std::move(sync_db), scheduler_id);
+                                                                 int32 scheduler_id, int32 read_scheduler_id) {
+  return std::make_shared<MessageDbAsync>(std::move(sync_db), scheduler_id, read_scheduler_id);
 }
 
 }  // namespace td
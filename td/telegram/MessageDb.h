@@ -97,6 +97,49 @@ struct MessageDbCallsResult {
   vector<MessageDbMessage> messages;
 };
 
+struct MessageDbNewMessage {
+  MessageFullId message_full_id;
+  ServerMessageId unique_message_id;
+  DialogId sender_dialog_id;
+  int64 random_id{0};
+  int32 ttl_expires_at{0};
+  int32 index_mask{0};
+  int64 search_id{0};
+  string text;
+  NotificationId notification_id;
+  MessageId top_thread_message_id;
+  BufferSlice data;
+};
+
+struct MessageDbPrunedMessages {
+  int32 deleted_count{0};
+  MessageId first_kept_message_id;
+  bool has_more{false};
+};
+
+// all limits are disabled if zero
+struct MessageDbRetentionPolicy {
+  int64 max_database_size{0};
+  int32 private_chat_max_age{0};  // in seconds; used also for secret chats
+  int32 group_max_age{0};
+  int32 channel_max_age{0};  // used for supergroups and channels
+
+  bool is_enabled() const {
+    return max_database_size > 0 || private_chat_max_age > 0 || group_max_age > 0 || channel_max_age > 0;
+  }
+};
+
+class MessageDbRetentionCallback {
+ public:
+  MessageDbRetentionCallback() = default;
+  MessageDbRetentionCallback(const MessageDbRetentionCallback &) = delete;
+  MessageDbRetentionCallback &operator=(const MessageDbRetentionCallback &) = delete;
+  virtual ~MessageDbRetentionCallback() = default;
+
+  // all messages in the chat before first_kept_message_id were deleted from the database
+  virtual void on_messages_pruned(DialogId dialog_id, MessageId first_kept_message_id) = 0;
+};
+
 class MessageDbSyncInterface {
  public:
   MessageDbSyncInterface() = default;
@@ -107,6 +150,7 @@ class MessageDbSyncInterface {
   virtual void add_message(MessageFullId message_full_id, ServerMessageId unique_message_id, DialogId sender_dialog_id,
                            int64 random_id, int32 ttl_expires_at, int32 index_mask, int64 search_id, string text,
                            NotificationId notification_id, MessageId top_thread_message_id, BufferSlice data) = 0;
+  virtual void add_messages(vector<MessageDbNewMessage> messages) = 0;
   virtual void add_scheduled_message(MessageFullId message_full_id, BufferSlice data) = 0;
 
   virtual void delete_message(MessageFullId message_full_id) = 0;
@@ -134,6 +178,26 @@ class MessageDbSyncInterface {
   virtual MessageDbCallsResult get_calls(MessageDbCallsQuery query) = 0;
   virtual MessageDbFtsResult get_messages_fts(MessageDbFtsQuery query) = 0;
 
+  virtual void set_fts_options(bool use_deferred_indexing, int32 automerge) = 0;
+  virtual bool has_pending_fts_messages() = 0;
+  // indexes up to limit pending messages; returns true if there are more pending messages
+  virtual bool index_pending_fts_messages(int32 limit) = 0;
+  virtual void rebuild_fts_index() = 0;
+  virtual void optimize_fts_index() = 0;
+
+  // returns the first chat with stored messages after after_dialog_id, or an invalid identifier if there is none
+  virtual DialogId get_next_message_dialog_id(DialogId after_dialog_id) = 0;
+  // deletes up to limit oldest messages in the chat sent before max_date; the last message is never deleted
+  virtual MessageDbPrunedMessages delete_old_dialog_messages(DialogId dialog_id, int32 max_date, int32 limit) = 0;
+  virtual int64 get_database_size() = 0;
+  // returns up to page_count free pages to the file system if incremental vacuum is enabled
+  virtual void vacuum_incrementally(int32 page_count) = 0;
+  // switches the database to incremental vacuum; runs VACUUM if needed, so must be called outside of a transaction
+  virtual Status enable_incremental_vacuum() = 0;
+
+  // new messages are compressed with a dictionary trained on stored messages; all formats can be always read
+  virtual void set_data_compression(bool use_data_compression) = 0;
+
   virtual Status begin_write_transaction() = 0;
   virtual Status commit_transaction() = 0;
 };
@@ -189,6 +253,18 @@ class MessageDbAsyncInterface {
 
   virtual void get_expiring_messages(int32 expires_till, int32 limit, Promise<vector<MessageDbMessage>> promise) = 0;
 
+  // in the deferred mode new messages are indexed for full-text search in background when the database is idle
+  virtual void set_fts_options(bool use_deferred_indexing, int32 automerge) = 0;
+  // the index is rebuilt in background; found messages can be incomplete until the rebuild is finished
+  virtual void rebuild_fts_index(Promise<> promise) = 0;
+  virtual void optimize_fts_index(Promise<> promise) = 0;
+
+  virtual void set_data_compression(bool use_data_compression) = 0;
+
+  // old messages are deleted in background in small transactions; the callback is called for each changed chat
+  virtual void set_retention_policy(MessageDbRetentionPolicy policy,
+                                    std::shared_ptr<MessageDbRetentionCallback> callback) = 0;
+
   virtual void close(Promise<> promise) = 0;
   virtual void force_flush() = 0;
 };
@@ -199,7 +275,14 @@ Status drop_message_db(SqliteDb &db, int version) TD_WARN_UNUSED_RESULT;
 std::shared_ptr<MessageDbSyncSafeInterface> create_message_db_sync(
     std::shared_ptr<SqliteConnectionSafe> sqlite_connection);
 
+// the first connection is the main database; messages are partitioned between the connections by dialog identifier
+std::shared_ptr<MessageDbSyncSafeInterface> create_message_db_sync(
+    vector<std::shared_ptr<SqliteConnectionSafe>> sqlite_connections);
+
+size_t get_message_db_shard_index(DialogId dialog_id, size_t shard_count);
+
+// long read-only queries are run on read_scheduler_id if it isn't -1
 std::shared_ptr<MessageDbAsyncInterface> create_message_db_async(std::shared_ptr<MessageDbSyncSafeInterface> sync_db,
-                                                                 int32 scheduler_id = -1);
+                                                                 int32 scheduler_id = -1, int32 read_scheduler_id = -1);
 
 }  // namespace td
@@ -1678,8 +1678,40 @@ static void fix_entity_offsets(Slice text, vector<MessageEntity> &entities) {
   }
 }
 
+static constexpr uint32 MENTION_TRIGGER = 1 << 0;
+static constexpr uint32 BOT_COMMAND_TRIGGER = 1 << 1;
+static constexpr uint32 HASHTAG_TRIGGER = 1 << 2;
+static constexpr uint32 CASHTAG_TRIGGER = 1 << 3;
+static constexpr uint32 COLON_TRIGGER = 1 << 4;
+static constexpr uint32 DOT_TRIGGER = 1 << 5;
+static constexpr uint32 BANK_CARD_NUMBER_TRIGGER = 1 << 6;
+
+// returns a mask of entity kinds, a first character of which is present in the text;
+// all entity matchers start from an ASCII character, so the other matchers can be skipped
+// the loop is branchless, so it can be vectorized by the compiler
+static uint32 get_entity_trigger_mask(Slice text) {
+  uint32 mask = 0;
+  size_t digit_count = 0;
+  for (auto c : text) {
+    auto uc = static_cast<unsigned char>(c);
+    mask |= (uc == '@' ? MENTION_TRIGGER : 0) | (uc == '/' ? BOT_COMMAND_TRIGGER : 0) |
+            (uc == '#' ? HASHTAG_TRIGGER : 0) | (uc == '$' ? CASHTAG_TRIGGER : 0) | (uc == ':' ? COLON_TRIGGER : 0) |
+            (uc == '.' ? DOT_TRIGGER : 0);
+    digit_count += static_cast<size_t>(static_cast<unsigned char>(uc - '0') < 10);
+  }
+  // bank card numbers contain at least 13 digits
+  if (digit_count >= 13) {
+    mask |= BANK_CARD_NUMBER_TRIGGER;
+  }
+  return mask;
+}
+
 vector<MessageEntity> find_entities(Slice text, bool skip_bot_commands, bool skip_media_timestamps) {
   vector<MessageEntity> entities;
+  auto trigger_mask = get_entity_trigger_mask(text);
+  if (trigger_mask == 0) {
+    return entities;
+  }
 
   auto add_entities = [&entities, &text](MessageEntity::Type type, vector<Slice> (*find_entities_f)(Slice)) mutable {
     auto new_entities = find_entities_f(text);
@@ -1689,23 +1721,35 @@ vector<MessageEntity> find_entities(Slice text, bool skip_bot_commands, bool ski
       entities.emplace_back(type, offset, length);
     }
   };
-  add_entities(MessageEntity::Type::Mention, find_mentions);
-  if (!skip_bot_commands) {
+  if ((trigger_mask & MENTION_TRIGGER) != 0) {
+    add_entities(MessageEntity::Type::Mention, find_mentions);
+  }
+  if (!skip_bot_commands && (trigger_mask & BOT_COMMAND_TRIGGER) != 0) {
     add_entities(MessageEntity::Type::BotCommand, find_bot_commands);
   }
-  add_entities(MessageEntity::Type::Hashtag, find_hashtags);
-  add_entities(MessageEntity::Type::Cashtag, find_cashtags);
+  if ((trigger_mask & HASHTAG_TRIGGER) != 0) {
+    add_entities(MessageEntity::Type::Hashtag, find_hashtags);
+  }
+  if ((trigger_mask & CASHTAG_TRIGGER) != 0) {
+    add_entities(MessageEntity::Type::Cashtag, find_cashtags);
+  }
   // TODO find_phone_numbers
-  add_entities(MessageEntity::Type::BankCardNumber, find_bank_card_numbers);
-  add_entities(MessageEntity::Type::Url, find_tg_urls);
-  auto urls = find_urls(text);
-  for (auto &url : urls) {
-    auto type = url.second ? MessageEntity::Type::EmailAddress : MessageEntity::Type::Url;
-    auto offset = narrow_cast<int32>(url.first.begin() - text.begin());
-    auto length = narrow_cast<int32>(url.first.size());
-    entities.emplace_back(type, offset, length);
-  }
-  if (!skip_media_timestamps) {
+  if ((trigger_mask & BANK_CARD_NUMBER_TRIGGER) != 0) {
+    add_entities(MessageEntity::Type::BankCardNumber, find_bank_card_numbers);
+  }
+  if ((trigger_mask & COLON_TRIGGER) != 0) {
+    add_entities(MessageEntity::Type::Url, find_tg_urls);
+  }
+  if ((trigger_mask & DOT_TRIGGER) != 0) {
+    auto urls = find_urls(text);
+    for (auto &url : urls) {
+      auto type = url.second ? MessageEntity::Type::EmailAddress : MessageEntity::Type::Url;
+      auto offset = narrow_cast<int32>(url.first.begin() - text.begin());
+      auto length = narrow_cast<int32>(url.first.size());
+      entities.emplace_back(type, offset, length);
+    }
+  }
+  if (!skip_media_timestamps && (trigger_mask & COLON_TRIGGER) != 0) {
     auto media_timestamps = find_media_timestamps(text);
     for (auto &entity : media_timestamps) {
       auto offset = narrow_cast<int32>(entity.first.begin() - text.begin());
@@ -1981,6 +2025,23 @@ Result<vector<MessageEntity>> parse_markdown(string &text) {
   return std::move(entities);
 }
 
+// a set of ASCII characters with a constant-time membership check
+class ParserCharacterSet {
+ public:
+  explicit ParserCharacterSet(Slice characters) {
+    for (auto c : characters) {
+      is_contained_[static_cast<unsigned char>(c)] = true;
+    }
+  }
+
+  bool contains(unsigned char c) const {
+    return is_contained_[c];
+  }
+
+ private:
+  bool is_contained_[256] = {};
+};
+
 Result<vector<MessageEntity>> parse_markdown_v2(string &text) {
   size_t result_size = 0;
   vector<MessageEntity> entities;
@@ -2018,27 +2079,40 @@ Result<vector<MessageEntity>> parse_markdown_v2(string &text) {
       continue;
     }
 
-    Slice reserved_characters("_*[]()~`>#+-=|{}.!\n");
+    // reserved characters and the escape character, which stop a run of ordinary characters
+    static const ParserCharacterSet default_stop_characters("_*[]()~`>#+-=|{}.!\n\\");
+    static const ParserCharacterSet code_stop_characters("`\\");
+    const ParserCharacterSet *stop_characters = &default_stop_characters;
     if (!nested_entities.empty()) {
       switch (nested_entities.back().type) {
         case MessageEntity::Type::Code:
         case MessageEntity::Type::Pre:
         case MessageEntity::Type::PreCode:
-          reserved_characters = Slice("`");
+          stop_characters = &code_stop_characters;
           break;
         default:
           break;
       }
     }
 
-    if (reserved_characters.find(text[i]) == Slice::npos) {
-      if (is_utf8_character_first_code_unit(c)) {
-        utf16_offset += 1 + (c >= 0xf0);  // >= 4 bytes in symbol => surrogate pair
-        if (c != '\r') {
-          can_start_blockquote = false;
+    if (c == '\\' || !stop_characters->contains(c)) {
+      // copy the whole run of ordinary characters at once
+      auto run_begin = i;
+      do {
+        c = static_cast<unsigned char>(text[i]);
+        if (is_utf8_character_first_code_unit(c)) {
+          utf16_offset += 1 + (c >= 0xf0);  // >= 4 bytes in symbol => surrogate pair
+          if (c != '\r') {
+            can_start_blockquote = false;
+          }
         }
+        i++;
+      } while (i < text.size() && !stop_characters->contains(static_cast<unsigned char>(text[i])));
+      if (result_size != run_begin) {
+        std::memmove(&text[result_size], &text[run_begin], i - run_begin);
       }
-      text[result_size++] = text[i];
+      result_size += i - run_begin;
+      i--;  // i will be incremented in for
       continue;
     }
 
@@ -3251,10 +3325,20 @@ Result<vector<MessageEntity>> parse_html(string &str) {
       }
     }
     if (c != '<') {
-      if (is_utf8_character_first_code_unit(c)) {
-        utf16_offset += 1 + (c >= 0xf0);  // >= 4 bytes in symbol => surrogate pair
+      // copy the whole run of characters without tags and HTML entities at once
+      auto run_begin = i;
+      do {
+        c = static_cast<unsigned char>(text[i]);
+        if (is_utf8_character_first_code_unit(c)) {
+          utf16_offset += 1 + (c >= 0xf0);  // >= 4 bytes in symbol => surrogate pair
+        }
+        i++;
+      } while (i < str_size && text[i] != '&' && text[i] != '<');
+      if (result_end != result_begin + run_begin) {
+        std::memmove(result_end, text + run_begin, i - run_begin);
       }
-      *result_end++ = c;
+      result_end += i - run_begin;
+      i--;  // i will be incremented in for
       continue;
     }
 
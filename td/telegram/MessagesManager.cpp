@@ -45,6 +45,7 @@
 #include "td/telegram/LinkManager.h"
 #include "td/telegram/Location.h"
 #include "td/telegram/logevent/LogEvent.h"
+#include "td/telegram/MemoryStatistics.h"
 #include "td/telegram/MessageContent.h"
 #include "td/telegram/MessageDb.h"
 #include "td/telegram/MessageEntity.h"
@@ -80,6 +81,7 @@
 #include "td/telegram/SavedMessagesManager.h"
 #include "td/telegram/SecretChatsManager.h"
 #include "td/telegram/SponsoredMessageManager.h"
+#include "td/telegram/StartupProfiler.h"
 #include "td/telegram/StickerType.h"
 #include "td/telegram/StoryId.h"
 #include "td/telegram/StoryManager.h"
@@ -627,11 +629,12 @@ class ExportChannelMessageLinkQuery final : public Td::ResultHandler {
 };
 
 class GetDialogListQuery final : public Td::ResultHandler {
+  Promise<telegram_api::object_ptr<telegram_api::messages_Dialogs>> promise_;
   FolderId folder_id_;
-  Promise<Unit> promise_;
 
  public:
-  explicit GetDialogListQuery(Promise<Unit> &&promise) : promise_(std::move(promise)) {
+  explicit GetDialogListQuery(Promise<telegram_api::object_ptr<telegram_api::messages_Dialogs>> &&promise)
+      : promise_(std::move(promise)) {
   }
 
   void send(FolderId folder_id, int32 offset_date, ServerMessageId offset_message_id, DialogId offset_dialog_id,
@@ -656,30 +659,11 @@ class GetDialogListQuery final : public Td::ResultHandler {
 
     auto ptr = result_ptr.move_as_ok();
     LOG(INFO) << "Receive chats from chat list of " << folder_id_ << ": " << to_string(ptr);
-    switch (ptr->get_id()) {
-      case telegram_api::messages_dialogs::ID: {
-        auto dialogs = move_tl_object_as<telegram_api::messages_dialogs>(ptr);
-        td_->user_manager_->on_get_users(std::move(dialogs->users_), "GetDialogListQuery");
-        td_->chat_manager_->on_get_chats(std::move(dialogs->chats_), "GetDialogListQuery");
-        td_->messages_manager_->on_get_dialogs(folder_id_, std::move(dialogs->dialogs_),
-                                               narrow_cast<int32>(dialogs->dialogs_.size()),
-                                               std::move(dialogs->messages_), std::move(promise_));
-        break;
-      }
-      case telegram_api::messages_dialogsSlice::ID: {
-        auto dialogs = move_tl_object_as<telegram_api::messages_dialogsSlice>(ptr);
-        td_->user_manager_->on_get_users(std::move(dialogs->users_), "GetDialogListQuery slice");
-        td_->chat_manager_->on_get_chats(std::move(dialogs->chats_), "GetDialogListQuery slice");
-        td_->messages_manager_->on_get_dialogs(folder_id_, std::move(dialogs->dialogs_), max(dialogs->count_, 0),
-                                               std::move(dialogs->messages_), std::move(promise_));
-        break;
-      }
-      case telegram_api::messages_dialogsNotModified::ID:
-        LOG(ERROR) << "Receive " << to_string(ptr);
-        return on_error(Status::Error(500, "Receive wrong server response messages.dialogsNotModified"));
-      default:
-        UNREACHABLE();
+    if (ptr->get_id() == telegram_api::messages_dialogsNotModified::ID) {
+      LOG(ERROR) << "Receive " << to_string(ptr);
+      return on_error(Status::Error(500, "Receive wrong server response messages.dialogsNotModified"));
     }
+    promise_.set_value(std::move(ptr));
   }
 
   void on_error(Status status) final {
@@ -4210,11 +4194,12 @@ class MessagesManager::UploadThumbnailCallback final : public FileManager::Uploa
 
 template <class StorerT>
 void MessagesManager::Message::store(StorerT &storer) const {
+  const auto &send_info = get_send_info();
   using td::store;
   bool has_sender = sender_user_id.is_valid();
   bool has_edit_date = edit_date > 0;
   bool has_random_id = random_id != 0;
-  bool is_reply_to_random_id = reply_to_random_id != 0;
+  bool is_reply_to_random_id = send_info.reply_to_random_id != 0;
   bool is_via_bot = via_bot_user_id.is_valid();
   bool has_view_count = view_count > 0;
   bool has_reply_markup = reply_markup != nullptr;
@@ -4224,8 +4209,9 @@ void MessagesManager::Message::store(StorerT &storer) const {
   bool has_send_date = message_id.is_yet_unsent() && send_date != 0;
   bool has_flags2 = true;
   bool has_notification_id = notification_id.is_valid();
-  bool has_send_error_code = send_error_code != 0;
-  bool has_real_forward_from = real_forward_from_dialog_id.is_valid() && real_forward_from_message_id.is_valid();
+  bool has_send_error_code = send_info.send_error_code != 0;
+  bool has_real_forward_from =
+      send_info.real_forward_from_dialog_id.is_valid() && send_info.real_forward_from_message_id.is_valid();
   bool has_legacy_layer = legacy_layer != 0;
   bool has_restriction_reasons = !restriction_reasons.empty();
   bool has_forward_count = forward_count > 0;
@@ -4236,7 +4222,7 @@ void MessagesManager::Message::store(StorerT &storer) const {
   bool has_local_thread_message_ids = !local_thread_message_ids.empty();
   bool has_linked_top_thread_message_id = linked_top_thread_message_id.is_valid();
   bool has_interaction_info_update_date = interaction_info_update_date != 0;
-  bool has_send_emoji = !send_emoji.empty();
+  bool has_send_emoji = !send_info.send_emoji.empty();
   bool has_ttl_period = ttl_period != 0;
   bool has_max_reply_media_timestamp = max_reply_media_timestamp >= 0;
   bool are_message_media_timestamp_entities_found = true;
@@ -4245,11 +4231,12 @@ void MessagesManager::Message::store(StorerT &storer) const {
   bool has_available_reactions_generation = available_reactions_generation != 0;
   bool has_history_generation = history_generation != 0;
   bool is_reply_to_story = reply_to_story_full_id != StoryFullId();
-  bool has_input_reply_to = !message_id.is_any_server() && input_reply_to.is_valid();
+  bool has_input_reply_to = !message_id.is_any_server() && send_info.input_reply_to.is_valid();
   bool has_replied_message_info = !replied_message_info.is_empty();
   bool has_forward_info = forward_info != nullptr;
   bool has_saved_messages_topic_id = saved_messages_topic_id.is_valid();
-  bool has_initial_top_thread_message_id = !message_id.is_any_server() && initial_top_thread_message_id.is_valid();
+  bool has_initial_top_thread_message_id =
+      !message_id.is_any_server() && send_info.initial_top_thread_message_id.is_valid();
   bool has_sender_boost_count = sender_boost_count != 0;
   bool has_via_business_bot_user_id = via_business_bot_user_id.is_valid();
   bool has_effect_id = effect_id.is_valid();
@@ -4363,11 +4350,11 @@ void MessagesManager::Message::store(StorerT &storer) const {
     store(forward_info, storer);
   }
   if (has_real_forward_from) {
-    store(real_forward_from_dialog_id, storer);
-    store(real_forward_from_message_id, storer);
+    store(send_info.real_forward_from_dialog_id, storer);
+    store(send_info.real_forward_from_message_id, storer);
   }
   if (is_reply_to_random_id) {
-    store(reply_to_random_id, storer);
+    store(send_info.reply_to_random_id, storer);
   }
   if (is_via_bot) {
     store(via_bot_user_id, storer);
@@ -4386,10 +4373,10 @@ void MessagesManager::Message::store(StorerT &storer) const {
     store_time(ttl_expires_at, storer);
   }
   if (has_send_error_code) {
-    store(send_error_code, storer);
-    store(send_error_message, storer);
-    if (send_error_code == 429) {
-      store_time(try_resend_at, storer);
+    store(send_info.send_error_code, storer);
+    store(send_info.send_error_message, storer);
+    if (send_info.send_error_code == 429) {
+      store_time(send_info.try_resend_at, storer);
     }
   }
   if (has_author_signature) {
@@ -4426,7 +4413,7 @@ void MessagesManager::Message::store(StorerT &storer) const {
     store(interaction_info_update_date, storer);
   }
   if (has_send_emoji) {
-    store(send_emoji, storer);
+    store(send_info.send_emoji, storer);
   }
   store_message_content(content.get(), storer);
   if (has_reply_markup) {
@@ -4451,7 +4438,7 @@ void MessagesManager::Message::store(StorerT &storer) const {
     store(reply_to_story_full_id, storer);
   }
   if (has_input_reply_to) {
-    store(input_reply_to, storer);
+    store(send_info.input_reply_to, storer);
   }
   if (has_replied_message_info) {
     store(replied_message_info, storer);
@@ -4460,7 +4447,7 @@ void MessagesManager::Message::store(StorerT &storer) const {
     store(saved_messages_topic_id, storer);
   }
   if (has_initial_top_thread_message_id) {
-    store(initial_top_thread_message_id, storer);
+    store(send_info.initial_top_thread_message_id, storer);
   }
   if (has_sender_boost_count) {
     store(sender_boost_count, storer);
@@ -4690,15 +4677,15 @@ void MessagesManager::Message::parse(ParserT &parser) {
         std::move(forward_origin), forward_date, std::move(last_message_info), std::move(psa_type), legacy_is_imported);
   }
   if (has_real_forward_from) {
-    parse(real_forward_from_dialog_id, parser);
-    parse(real_forward_from_message_id, parser);
+    parse(edit_send_info().real_forward_from_dialog_id, parser);
+    parse(edit_send_info().real_forward_from_message_id, parser);
   }
   MessageId legacy_reply_to_message_id;
   if (legacy_is_reply) {
     parse(legacy_reply_to_message_id, parser);
   }
   if (is_reply_to_random_id) {
-    parse(reply_to_random_id, parser);
+    parse(edit_send_info().reply_to_random_id, parser);
   }
   if (is_via_bot) {
     parse(via_bot_user_id, parser);
@@ -4717,10 +4704,10 @@ void MessagesManager::Message::parse(ParserT &parser) {
     parse_time(ttl_expires_at, parser);
   }
   if (has_send_error_code) {
-    parse(send_error_code, parser);
-    parse(send_error_message, parser);
-    if (send_error_code == 429) {
-      parse_time(try_resend_at, parser);
+    parse(edit_send_info().send_error_code, parser);
+    parse(edit_send_info().send_error_message, parser);
+    if (edit_send_info().send_error_code == 429) {
+      parse_time(edit_send_info().try_resend_at, parser);
     }
   }
   if (has_author_signature) {
@@ -4761,7 +4748,7 @@ void MessagesManager::Message::parse(ParserT &parser) {
     parse(interaction_info_update_date, parser);
   }
   if (has_send_emoji) {
-    parse(send_emoji, parser);
+    parse(edit_send_info().send_emoji, parser);
   }
   parse_message_content(content, parser);
   if (has_reply_markup) {
@@ -4786,12 +4773,12 @@ void MessagesManager::Message::parse(ParserT &parser) {
     parse(reply_to_story_full_id, parser);
   }
   if (has_input_reply_to) {
-    parse(input_reply_to, parser);
+    parse(edit_send_info().input_reply_to, parser);
   } else if (!message_id.is_any_server()) {
     if (reply_to_story_full_id.is_valid()) {
-      input_reply_to = MessageInputReplyTo(reply_to_story_full_id);
+      edit_send_info().input_reply_to = MessageInputReplyTo(reply_to_story_full_id);
     } else if (legacy_reply_to_message_id.is_valid()) {
-      input_reply_to = MessageInputReplyTo{legacy_reply_to_message_id, DialogId(), MessageQuote()};
+      edit_send_info().input_reply_to = MessageInputReplyTo{legacy_reply_to_message_id, DialogId(), MessageQuote()};
     }
   }
   if (has_replied_message_info) {
@@ -4803,7 +4790,7 @@ void MessagesManager::Message::parse(ParserT &parser) {
     parse(saved_messages_topic_id, parser);
   }
   if (has_initial_top_thread_message_id) {
-    parse(initial_top_thread_message_id, parser);
+    parse(edit_send_info().initial_top_thread_message_id, parser);
   }
   if (has_sender_boost_count) {
     parse(sender_boost_count, parser);
@@ -5548,16 +5535,21 @@ MessagesManager::MessagesManager(Td *td, ActorShared<> parent)
 }
 
 MessagesManager::~MessagesManager() {
+  // dialogs are destroyed on another scheduler, so they must be removed from the list beforehand
+  while (!dialog_message_cache_lru_list_.empty()) {
+    dialog_message_cache_lru_list_.get_next()->remove();
+  }
   Scheduler::instance()->destroy_on_scheduler(
       G()->get_gc_scheduler_id(), ttl_nodes_, ttl_heap_, being_sent_messages_, update_message_ids_,
       update_scheduled_message_ids_, message_id_to_dialog_id_, last_clear_history_message_id_to_dialog_id_, dialogs_,
       postponed_chat_read_inbox_updates_, found_public_dialogs_, found_on_server_dialogs_, message_embedding_codes_[0],
       message_embedding_codes_[1], message_to_replied_media_timestamp_messages_,
       story_to_replied_media_timestamp_messages_, notification_group_id_to_dialog_id_, pending_get_channel_differences_,
-      active_get_channel_differences_, get_channel_difference_to_log_event_id_, channel_get_difference_retry_timeouts_,
-      is_channel_difference_finished_, expected_channel_pts_, expected_channel_max_message_id_,
-      dialog_bot_command_message_ids_, message_full_id_to_file_source_id_, last_outgoing_forwarded_message_date_,
-      dialog_viewed_messages_, previous_repaired_read_inbox_max_message_id_, failed_to_load_dialogs_);
+      prioritized_pending_get_channel_differences_, active_get_channel_differences_,
+      get_channel_difference_to_log_event_id_, channel_get_difference_retry_timeouts_, is_channel_difference_finished_,
+      expected_channel_pts_, expected_channel_max_message_id_, dialog_bot_command_message_ids_,
+      message_full_id_to_file_source_id_, last_outgoing_forwarded_message_date_, dialog_viewed_messages_,
+      previous_repaired_read_inbox_max_message_id_, failed_to_load_dialogs_);
 }
 
 MessagesManager::AddDialogData::AddDialogData(int32 dependent_dialog_count, unique_ptr<Message> &&last_message,
@@ -7838,16 +7830,20 @@ void MessagesManager::queue_message_reactions_reload(MessageFullId message_full_
   CHECK(dialog_id.is_valid());
   auto message_id = message_full_id.get_message_id();
   CHECK(message_id.is_valid());
-  being_reloaded_reactions_[dialog_id].message_ids.insert(message_id);
+  auto &reactions_to_reload = being_reloaded_reactions_[dialog_id];
+  reactions_to_reload.message_ids.insert(message_id);
+  reactions_to_reload.viewed_message_ids.erase(message_id);
   try_reload_message_reactions(dialog_id, false);
 }
 
 void MessagesManager::queue_message_reactions_reload(DialogId dialog_id, const vector<MessageId> &message_ids) {
   LOG(INFO) << "Queue reload of reactions in " << message_ids << " in " << dialog_id;
-  auto &message_ids_to_reload = being_reloaded_reactions_[dialog_id].message_ids;
+  auto &reactions_to_reload = being_reloaded_reactions_[dialog_id];
   for (auto &message_id : message_ids) {
     CHECK(message_id.is_valid());
-    message_ids_to_reload.insert(message_id);
+    if (reactions_to_reload.message_ids.insert(message_id).second) {
+      reactions_to_reload.viewed_message_ids.insert(message_id);
+    }
   }
   try_reload_message_reactions(dialog_id, false);
 }
@@ -7889,6 +7885,7 @@ void MessagesManager::try_reload_message_reactions(DialogId dialog_id, bool is_f
   }
   for (auto message_id : message_ids) {
     it->second.message_ids.erase(message_id);
+    it->second.viewed_message_ids.erase(message_id);
   }
   reload_message_reactions(td_, dialog_id, std::move(message_ids));
 }
@@ -8363,7 +8360,7 @@ void MessagesManager::do_send_media(DialogId dialog_id, const Message *m, int32
 
   auto input_media =
       get_message_content_input_media(content, media_pos, td_, std::move(input_file), std::move(input_thumbnail),
-                                      file_id, thumbnail_file_id, m->ttl, m->send_emoji, true);
+                                      file_id, thumbnail_file_id, m->ttl, m->get_send_info().send_emoji, true);
   LOG_CHECK(input_media != nullptr) << to_string(get_message_object(dialog_id, m, "do_send_media")) << ' ' << media_pos
                                     << ' ' << have_input_file << ' ' << have_input_thumbnail << ' ' << file_id << ' '
                                     << thumbnail_file_id << ' ' << m->ttl;
@@ -10211,6 +10208,31 @@ void MessagesManager::on_failed_scheduled_message_deletion(DialogId dialog_id, c
   load_dialog_scheduled_messages(dialog_id, false, 0, Promise<Unit>());
 }
 
+void MessagesManager::on_message_db_messages_pruned(DialogId dialog_id, MessageId first_kept_message_id) {
+  if (G()->close_flag() || td_->auth_manager_->is_bot()) {
+    return;
+  }
+  Dialog *d = get_dialog_force(dialog_id, "on_message_db_messages_pruned");
+  if (d == nullptr) {
+    return;
+  }
+
+  // the database has no messages before first_kept_message_id anymore
+  if (d->have_full_history) {
+    d->have_full_history = false;
+    d->have_full_history_source = 0;
+    on_dialog_updated(dialog_id, "on_message_db_messages_pruned");
+  }
+  if (d->first_database_message_id.is_valid() && d->first_database_message_id < first_kept_message_id) {
+    if (d->last_database_message_id.is_valid() && first_kept_message_id <= d->last_database_message_id) {
+      set_dialog_first_database_message_id(d, first_kept_message_id, "on_message_db_messages_pruned");
+    } else {
+      set_dialog_first_database_message_id(d, MessageId(), "on_message_db_messages_pruned 2");
+      set_dialog_last_database_message_id(d, MessageId(), "on_message_db_messages_pruned 2");
+    }
+  }
+}
+
 MessagesManager::CanDeleteDialog MessagesManager::can_delete_dialog(const Dialog *d) const {
   if (is_dialog_sponsored(d)) {
     auto chat_source = sponsored_dialog_source_.get_chat_source_object();
@@ -10802,10 +10824,22 @@ void MessagesManager::unload_dialog(DialogId dialog_id, int32 delay) {
 
   bool has_left_to_unload_messages = false;
   auto to_unload_message_ids = find_unloadable_messages(d, G()->unix_time() - delay, has_left_to_unload_messages);
+  unload_dialog_messages(d, to_unload_message_ids);
+
+  if (has_left_to_unload_messages) {
+    LOG(DEBUG) << "Need to unload more messages in " << dialog_id;
+    pending_unload_dialog_timeout_.add_timeout_in(
+        d->dialog_id.get(),
+        to_unload_message_ids.size() >= MAX_UNLOADED_MESSAGES ? 1.0 : get_next_unload_dialog_delay(d));
+  } else {
+    d->has_unload_timeout = false;
+  }
+}
 
+void MessagesManager::unload_dialog_messages(Dialog *d, const vector<MessageId> &message_ids) {
   vector<int64> unloaded_message_ids;
   vector<unique_ptr<Message>> unloaded_messages;
-  for (auto message_id : to_unload_message_ids) {
+  for (auto message_id : message_ids) {
     auto message = unload_message(d, message_id);
     CHECK(message != nullptr);
     if (message->is_update_sent) {
@@ -10817,7 +10851,7 @@ void MessagesManager::unload_dialog(DialogId dialog_id, int32 delay) {
     Scheduler::instance()->destroy_on_scheduler(G()->get_gc_scheduler_id(), unloaded_messages);
   }
 
-  if (!to_unload_message_ids.empty() && !G()->use_message_database() && !d->is_empty) {
+  if (!message_ids.empty() && !G()->use_message_database() && !d->is_empty) {
     d->have_full_history = false;
     d->have_full_history_source = 0;
   }
@@ -10825,20 +10859,104 @@ void MessagesManager::unload_dialog(DialogId dialog_id, int32 delay) {
   if (!unloaded_message_ids.empty()) {
     send_closure_later(
         G()->td(), &Td::send_update,
-        td_api::make_object<td_api::updateDeleteMessages>(get_chat_id_object(dialog_id, "updateDeleteMessages"),
+        td_api::make_object<td_api::updateDeleteMessages>(get_chat_id_object(d->dialog_id, "updateDeleteMessages"),
                                                           std::move(unloaded_message_ids), false, true));
   }
+}
 
-  if (has_left_to_unload_messages) {
-    LOG(DEBUG) << "Need to unload more messages in " << dialog_id;
-    pending_unload_dialog_timeout_.add_timeout_in(
-        d->dialog_id.get(),
-        to_unload_message_ids.size() >= MAX_UNLOADED_MESSAGES ? 1.0 : get_next_unload_dialog_delay(d));
+int64 MessagesManager::get_message_cache_max_size() const {
+  return td_->option_manager_->get_option_integer("message_cache_max_size");
+}
+
+void MessagesManager::on_dialog_message_cache_access(Dialog *d) {
+  auto &node = d->message_cache_node;
+  if (node.lru_list_ == nullptr) {
+    node.dialog_id_ = d->dialog_id;
+    node.lru_list_ = &dialog_message_cache_lru_list_;
   } else {
-    d->has_unload_timeout = false;
+    node.remove();
+  }
+  dialog_message_cache_lru_list_.put_back(&node);
+
+  auto max_size = get_message_cache_max_size();
+  if (max_size > 0 && loaded_message_count_ > max_size && loaded_message_count_ > min_message_count_to_reduce_cache_ &&
+      !is_message_cache_reduce_scheduled_ && is_message_unload_enabled()) {
+    is_message_cache_reduce_scheduled_ = true;
+    send_closure_later(actor_id(this), &MessagesManager::reduce_message_cache);
+  }
+}
+
+void MessagesManager::touch_dialog_message_cache_node(const Dialog *d) {
+  auto &node = d->message_cache_node;
+  if (node.lru_list_ != nullptr) {
+    node.remove();
+    node.lru_list_->put_back(&node);
+  }
+}
+
+void MessagesManager::reduce_message_cache() {
+  is_message_cache_reduce_scheduled_ = false;
+  if (G()->close_flag() || !is_message_unload_enabled()) {
+    return;
+  }
+  auto max_size = get_message_cache_max_size();
+  if (max_size <= 0 || loaded_message_count_ <= max_size) {
+    min_message_count_to_reduce_cache_ = 0;
+    return;
+  }
+
+  // unload messages from the least recently used dialogs until 90% of the limit is used;
+  // processed dialogs are moved to the end of the list, so each dialog is checked at most once
+  auto target_size = max_size - max_size / 10;
+  auto unload_before_date = G()->unix_time();
+  size_t unloaded_message_count = 0;
+  DialogId first_dialog_id;
+  while (loaded_message_count_ > target_size && unloaded_message_count < MAX_UNLOADED_MESSAGES) {
+    auto *node = dialog_message_cache_lru_list_.next;
+    if (node == &dialog_message_cache_lru_list_) {
+      break;
+    }
+    auto dialog_id = static_cast<DialogMessageCacheNode *>(node)->dialog_id_;
+    if (dialog_id == first_dialog_id) {
+      break;
+    }
+    if (!first_dialog_id.is_valid()) {
+      first_dialog_id = dialog_id;
+    }
+    node->remove();
+    dialog_message_cache_lru_list_.put_back(node);
+
+    Dialog *d = get_dialog(dialog_id);
+    CHECK(d != nullptr);
+    bool has_left_to_unload_messages = false;
+    auto message_ids = find_unloadable_messages(d, unload_before_date, has_left_to_unload_messages);
+    unloaded_message_count += message_ids.size();
+    unload_dialog_messages(d, message_ids);
+  }
+  LOG(INFO) << "Unloaded " << unloaded_message_count << " messages to reduce message cache to "
+            << loaded_message_count_;
+
+  if (loaded_message_count_ <= target_size) {
+    min_message_count_to_reduce_cache_ = 0;
+  } else if (unloaded_message_count >= MAX_UNLOADED_MESSAGES) {
+    is_message_cache_reduce_scheduled_ = true;
+    send_closure_later(actor_id(this), &MessagesManager::reduce_message_cache);
+  } else {
+    // all remaining messages can't be unloaded now; try again after enough new messages are added
+    min_message_count_to_reduce_cache_ = loaded_message_count_ + max(max_size / 10, static_cast<int64>(1));
   }
 }
 
+void MessagesManager::memory_stats(MemoryStatistics &statistics) const {
+  Slice manager_name = "MessagesManager";
+  statistics.add_hash_map<DialogId, Dialog>(manager_name, "dialog", dialogs_.calc_size());
+  statistics.add_hash_map<MessageId, Message>(manager_name, "loaded_message",
+                                              static_cast<size_t>(loaded_message_count_));
+  statistics.add_hash_map<MessageId, DialogId>(manager_name, "message_id_to_dialog_id",
+                                               message_id_to_dialog_id_.calc_size());
+  statistics.add_hash_map<int64, MessageFullId>(manager_name, "being_sent_message", being_sent_messages_.size());
+}
+
 void MessagesManager::clear_dialog_message_list(Dialog *d, bool remove_from_dialog_list, int32 last_message_date) {
   if (d->server_unread_count + d->local_unread_count > 0) {
     MessageId max_message_id =
@@ -10927,6 +11045,7 @@ void MessagesManager::delete_all_dialog_messages(Dialog *d, bool remove_from_dia
       d->deleted_message_ids.insert(m->message_id);
     }
   });
+  loaded_message_count_ -= static_cast<int64>(d->messages.calc_size());
   Scheduler::instance()->destroy_on_scheduler(G()->get_gc_scheduler_id(), d->messages, d->ordered_messages);
 
   delete_all_dialog_messages_from_database(d, MessageId::max(), "delete_all_dialog_messages 3");
@@ -11606,8 +11725,14 @@ void MessagesManager::repair_server_dialog_total_count(DialogListId dialog_list_
   }
 
   LOG(INFO) << "Repair total chat count in " << dialog_list_id;
-  td_->create_handler<GetDialogListQuery>(Promise<Unit>())
-      ->send(dialog_list_id.get_folder_id(), 2147483647, ServerMessageId(), DialogId(), 1);
+  auto folder_id = dialog_list_id.get_folder_id();
+  auto query_promise = PromiseCreator::lambda(
+      [actor_id = actor_id(this), folder_id](Result<telegram_api::object_ptr<telegram_api::messages_Dialogs>> result) {
+        send_closure(actor_id, &MessagesManager::on_get_dialog_list, folder_id, std::move(result), false,
+                     Promise<Unit>());
+      });
+  td_->create_handler<GetDialogListQuery>(std::move(query_promise))
+      ->send(folder_id, 2147483647, ServerMessageId(), DialogId(), 1);
 }
 
 void MessagesManager::repair_secret_chat_total_count(DialogListId dialog_list_id) {
@@ -12415,6 +12540,7 @@ void MessagesManager::hangup() {
 }
 
 void MessagesManager::start_up() {
+  StartupProfiler::Phase phase(td_->startup_profiler_.get(), "MessagesManager::start_up");
   init();
 }
 
@@ -15311,6 +15437,7 @@ unique_ptr<MessagesManager::Message> MessagesManager::do_delete_message(Dialog *
   auto result = std::move(d->messages[message_id]);
   CHECK(m == result.get());
   d->messages.erase(message_id);
+  loaded_message_count_--;
 
   static_cast<ListNode *>(result.get())->remove();
 
@@ -15758,7 +15885,7 @@ vector<DialogId> MessagesManager::get_dialogs(DialogListId dialog_list_id, Dialo
   update_list_last_pinned_dialog_date(list);
 
   vector<const DialogFolder *> folders;
-  vector<std::set<DialogDate>::const_iterator> folder_iterators;
+  vector<OrderedSet<DialogDate>::const_iterator> folder_iterators;
   for (auto folder_id : get_dialog_list_folder_ids(list)) {
     folders.push_back(get_dialog_folder(folder_id));
     folder_iterators.push_back(folders.back()->ordered_dialogs_.upper_bound(offset));
@@ -15874,10 +16001,7 @@ void MessagesManager::load_folder_dialog_list(FolderId folder_id, int32 limit, b
     auto lock = multipromise.get_promise();
     reload_pinned_dialogs(DialogListId(folder_id), multipromise.get_promise());
     if (folder.folder_last_dialog_date_ == folder.last_server_dialog_date_) {
-      td_->create_handler<GetDialogListQuery>(multipromise.get_promise())
-          ->send(folder_id, folder.last_server_dialog_date_.get_date(),
-                 folder.last_server_dialog_date_.get_message_id().get_next_server_message_id().get_server_message_id(),
-                 folder.last_server_dialog_date_.get_dialog_id(), int32{MAX_GET_DIALOGS});
+      get_dialog_list_from_server(folder_id, folder.last_server_dialog_date_, multipromise.get_promise());
       is_query_sent = true;
     }
     if (folder_id == FolderId::main() && folder.last_server_dialog_date_ == MIN_DIALOG_DATE) {
@@ -15889,6 +16013,213 @@ void MessagesManager::load_folder_dialog_list(FolderId folder_id, int32 limit, b
   CHECK(is_query_sent);
 }
 
+void MessagesManager::send_get_dialog_list_query(
+    FolderId folder_id, DialogDate offset, Promise<telegram_api::object_ptr<telegram_api::messages_Dialogs>> &&promise) {
+  td_->create_handler<GetDialogListQuery>(std::move(promise))
+      ->send(folder_id, offset.get_date(), offset.get_message_id().get_next_server_message_id().get_server_message_id(),
+             offset.get_dialog_id(), int32{MAX_GET_DIALOGS});
+}
+
+void MessagesManager::get_dialog_list_from_server(FolderId folder_id, DialogDate offset, Promise<Unit> &&promise) {
+  auto &prefetch = get_dialog_folder(folder_id)->dialog_list_prefetch_;
+  if (prefetch != nullptr) {
+    switch (prefetch->on_request(offset, Time::now(), promise)) {
+      case DialogListPrefetch::RequestResult::Wait:
+        LOG(INFO) << "Wait for prefetched chats in " << folder_id << " from " << offset;
+        return;
+      case DialogListPrefetch::RequestResult::UsePage: {
+        LOG(INFO) << "Use prefetched chats in " << folder_id << " from " << offset;
+        auto page = prefetch->extract_page();
+        prefetch = nullptr;
+        return on_get_dialog_list(folder_id, std::move(page), true, std::move(promise));
+      }
+      case DialogListPrefetch::RequestResult::Miss: {
+        // the prefetched page is useless for the request, but can still be awaited by other requests
+        auto waiting_promise = prefetch->extract_waiting_promise();
+        auto waiting_offset = prefetch->get_offset();
+        prefetch = nullptr;
+        if (waiting_promise) {
+          get_dialog_list_from_server(folder_id, waiting_offset, std::move(waiting_promise));
+        }
+        break;
+      }
+      default:
+        UNREACHABLE();
+    }
+  }
+
+  send_get_dialog_list_query(
+      folder_id, offset,
+      PromiseCreator::lambda([actor_id = actor_id(this), folder_id, promise = std::move(promise)](
+                                 Result<telegram_api::object_ptr<telegram_api::messages_Dialogs>> result) mutable {
+        send_closure(actor_id, &MessagesManager::on_get_dialog_list, folder_id, std::move(result), true,
+                     std::move(promise));
+      }));
+}
+
+DialogDate MessagesManager::get_dialog_list_page_last_dialog_date(
+    FolderId folder_id, const vector<telegram_api::object_ptr<telegram_api::Dialog>> &dialogs,
+    const vector<telegram_api::object_ptr<telegram_api::Message>> &messages) {
+  // the same dialog date is calculated in on_get_dialogs
+  FlatHashMap<MessageFullId, DialogDate, MessageFullIdHash> message_full_id_to_dialog_date;
+  for (auto &message : messages) {
+    auto message_full_id = MessageFullId::get_message_full_id(message, false);
+    if (!message_full_id.get_message_id().is_valid()) {
+      continue;
+    }
+    int64 order = get_dialog_order(message_full_id.get_message_id(), get_message_date(message));
+    message_full_id_to_dialog_date.emplace(message_full_id, DialogDate(order, message_full_id.get_dialog_id()));
+  }
+
+  DialogDate max_dialog_date = MIN_DIALOG_DATE;
+  for (auto &dialog_folder : dialogs) {
+    if (dialog_folder->get_id() != telegram_api::dialog::ID) {
+      continue;
+    }
+    auto dialog = static_cast<const telegram_api::dialog *>(dialog_folder.get());
+    DialogId dialog_id(dialog->peer_);
+    MessageId last_message_id(ServerMessageId(dialog->top_message_));
+    if (!dialog_id.is_valid() || !last_message_id.is_valid() || FolderId(dialog->folder_id_) != folder_id) {
+      continue;
+    }
+    auto it = message_full_id_to_dialog_date.find({dialog_id, last_message_id});
+    if (it == message_full_id_to_dialog_date.end() && dialog_id.get_type() != DialogType::Channel) {
+      it = message_full_id_to_dialog_date.find({DialogId(), last_message_id});
+    }
+    if (it == message_full_id_to_dialog_date.end()) {
+      continue;
+    }
+    DialogDate dialog_date = it->second;
+    if (dialog_date.get_date() > 0 && dialog_date.get_dialog_id() == dialog_id && max_dialog_date < dialog_date) {
+      max_dialog_date = dialog_date;
+    }
+  }
+  return max_dialog_date;
+}
+
+void MessagesManager::prefetch_dialog_list(FolderId folder_id, DialogDate offset) {
+  auto &prefetch = get_dialog_folder(folder_id)->dialog_list_prefetch_;
+  if (prefetch != nullptr) {
+    return;
+  }
+  LOG(INFO) << "Prefetch chats in " << folder_id << " from " << offset;
+  prefetch = make_unique<DialogListPrefetch>(offset);
+  send_get_dialog_list_query(
+      folder_id, offset,
+      PromiseCreator::lambda([actor_id = actor_id(this), folder_id,
+                              offset](Result<telegram_api::object_ptr<telegram_api::messages_Dialogs>> result) {
+        send_closure(actor_id, &MessagesManager::on_prefetch_dialog_list, folder_id, offset, std::move(result));
+      }));
+}
+
+void MessagesManager::on_prefetch_dialog_list(FolderId folder_id, DialogDate offset,
+                                              Result<telegram_api::object_ptr<telegram_api::messages_Dialogs>> result) {
+  if (G()->close_flag()) {
+    return;
+  }
+  auto &prefetch = get_dialog_folder(folder_id)->dialog_list_prefetch_;
+  if (prefetch == nullptr || prefetch->get_offset() != offset || prefetch->is_received()) {
+    // the prefetched page is no longer needed
+    return;
+  }
+  auto promise = prefetch->extract_waiting_promise();
+  if (result.is_error()) {
+    prefetch = nullptr;
+    if (promise) {
+      // repeat the query without prefetching
+      get_dialog_list_from_server(folder_id, offset, std::move(promise));
+    }
+    return;
+  }
+  if (promise) {
+    prefetch = nullptr;
+    return on_get_dialog_list(folder_id, result.move_as_ok(), true, std::move(promise));
+  }
+  prefetch->set_page(result.move_as_ok(), Time::now());
+}
+
+void MessagesManager::on_get_dialog_list(FolderId folder_id,
+                                         Result<telegram_api::object_ptr<telegram_api::messages_Dialogs>> r_dialogs,
+                                         bool can_prefetch, Promise<Unit> &&promise) {
+  G()->ignore_result_if_closing(r_dialogs);
+  if (r_dialogs.is_error()) {
+    return promise.set_error(r_dialogs.move_as_error());
+  }
+
+  auto page = make_unique<DialogListPage>();
+  page->folder_id_ = folder_id;
+  auto ptr = r_dialogs.move_as_ok();
+  bool is_slice = false;
+  switch (ptr->get_id()) {
+    case telegram_api::messages_dialogs::ID: {
+      auto dialogs = telegram_api::move_object_as<telegram_api::messages_dialogs>(ptr);
+      page->users_ = std::move(dialogs->users_);
+      page->chats_ = std::move(dialogs->chats_);
+      page->total_count_ = narrow_cast<int32>(dialogs->dialogs_.size());
+      page->dialogs_ = std::move(dialogs->dialogs_);
+      page->messages_ = std::move(dialogs->messages_);
+      break;
+    }
+    case telegram_api::messages_dialogsSlice::ID: {
+      auto dialogs = telegram_api::move_object_as<telegram_api::messages_dialogsSlice>(ptr);
+      page->users_ = std::move(dialogs->users_);
+      page->chats_ = std::move(dialogs->chats_);
+      page->total_count_ = max(dialogs->count_, 0);
+      page->dialogs_ = std::move(dialogs->dialogs_);
+      page->messages_ = std::move(dialogs->messages_);
+      is_slice = true;
+      break;
+    }
+    default:
+      UNREACHABLE();
+  }
+  page->promise_ = std::move(promise);
+
+  if (!td_->option_manager_->get_option_boolean("use_pipelined_chat_list_loading")) {
+    td_->user_manager_->on_get_users(std::move(page->users_), "on_get_dialog_list");
+    td_->chat_manager_->on_get_chats(std::move(page->chats_), "on_get_dialog_list");
+    return on_get_dialogs(folder_id, std::move(page->dialogs_), page->total_count_, std::move(page->messages_),
+                          std::move(page->promise_));
+  }
+
+  if (can_prefetch && is_slice && !page->dialogs_.empty()) {
+    // the next page is requested while the current page is being processed
+    auto last_dialog_date = get_dialog_list_page_last_dialog_date(folder_id, page->dialogs_, page->messages_);
+    if (last_dialog_date != MIN_DIALOG_DATE) {
+      prefetch_dialog_list(folder_id, last_dialog_date);
+    }
+  }
+  process_dialog_list_page(std::move(page));
+}
+
+void MessagesManager::process_dialog_list_page(unique_ptr<DialogListPage> page) {
+  if (G()->close_flag()) {
+    return page->promise_.set_error(Global::request_aborted_error());
+  }
+
+  // users and chats are added in small batches to allow processing of other events between them
+  auto extract_batch = [](auto &objects) {
+    auto batch_size = min(objects.size(), DIALOG_LIST_PAGE_ENTITY_BATCH_SIZE);
+    std::decay_t<decltype(objects)> batch;
+    batch.reserve(batch_size);
+    for (size_t i = 0; i < batch_size; i++) {
+      batch.push_back(std::move(objects[i]));
+    }
+    objects.erase(objects.begin(), objects.begin() + batch_size);
+    return batch;
+  };
+  if (!page->users_.empty()) {
+    td_->user_manager_->on_get_users(extract_batch(page->users_), "process_dialog_list_page");
+    return send_closure_later(actor_id(this), &MessagesManager::process_dialog_list_page, std::move(page));
+  }
+  if (!page->chats_.empty()) {
+    td_->chat_manager_->on_get_chats(extract_batch(page->chats_), "process_dialog_list_page");
+    return send_closure_later(actor_id(this), &MessagesManager::process_dialog_list_page, std::move(page));
+  }
+  on_get_dialogs(page->folder_id_, std::move(page->dialogs_), page->total_count_, std::move(page->messages_),
+                 std::move(page->promise_));
+}
+
 void MessagesManager::on_load_folder_dialog_list(FolderId folder_id, Result<Unit> &&result) {
   if (G()->close_flag()) {
     return;
@@ -19314,6 +19645,19 @@ void MessagesManager::close_dialog(Dialog *d) {
   dialog_viewed_messages_.erase(dialog_id);
   update_viewed_messages_timeout_.cancel_timeout(dialog_id.get());
 
+  auto reactions_it = being_reloaded_reactions_.find(dialog_id);
+  if (reactions_it != being_reloaded_reactions_.end()) {
+    // reactions of viewed messages are reloaded only to be shown in the opened chat
+    auto &reactions_to_reload = reactions_it->second;
+    for (auto message_id : reactions_to_reload.viewed_message_ids) {
+      reactions_to_reload.message_ids.erase(message_id);
+    }
+    reactions_to_reload.viewed_message_ids.clear();
+    if (reactions_to_reload.message_ids.empty() && !reactions_to_reload.is_request_sent) {
+      being_reloaded_reactions_.erase(reactions_it);
+    }
+  }
+
   auto live_locations_it = pending_viewed_live_locations_.find(dialog_id);
   if (live_locations_it != pending_viewed_live_locations_.end()) {
     for (auto &it : live_locations_it->second) {
@@ -19747,6 +20091,7 @@ tl_object_ptr<td_api::messages> MessagesManager::get_dialog_history(DialogId dia
     CHECK(offset == 0);
     preload_newer_messages(d, message_ids[0]);
     preload_older_messages(d, message_ids.back());
+    prefetch_message_files(d, message_ids);
   } else if (limit > 0 && left_tries != 0 && !(d->is_empty && d->have_full_history && left_tries < 3)) {
     // there can be more messages in the database or on the server, need to load them
     send_closure_later(actor_id(this), &MessagesManager::load_messages, dialog_id, from_message_id, offset, limit,
@@ -21697,6 +22042,39 @@ void MessagesManager::preload_older_messages(const Dialog *d, MessageId min_mess
   }
 }
 
+void MessagesManager::prefetch_message_files(const Dialog *d, const vector<MessageId> &message_ids) {
+  CHECK(d != nullptr);
+  auto message_count = G()->get_option_integer("prefetch_message_count");
+  if (message_count <= 0) {
+    return;
+  }
+  auto max_file_size = G()->get_option_integer("prefetch_max_file_size", 1 << 20);
+
+  // thumbnails and small files of the returned messages are likely to be needed soon
+  vector<FileId> file_ids;
+  for (auto message_id : message_ids) {
+    if (message_count-- <= 0) {
+      break;
+    }
+    const auto *m = get_message(d, message_id);
+    if (m == nullptr) {
+      continue;
+    }
+    for (auto file_id : get_message_file_ids(m)) {
+      auto file_view = td_->file_manager_->get_file_view(file_id);
+      if (file_view.empty() || file_view.has_local_location() || !file_view.can_download_from_server()) {
+        continue;
+      }
+      auto size = file_view.expected_size();
+      if (size <= 0 || size > max_file_size) {
+        continue;
+      }
+      file_ids.push_back(file_id);
+    }
+  }
+  send_closure(td_->download_manager_actor_, &DownloadManager::prefetch_files, d->dialog_id, std::move(file_ids));
+}
+
 unique_ptr<MessagesManager::Message> MessagesManager::parse_message(Dialog *d, MessageId expected_message_id,
                                                                     const BufferSlice &value, bool is_scheduled) {
   CHECK(d != nullptr);
@@ -21790,7 +22168,8 @@ unique_ptr<MessagesManager::Message> MessagesManager::parse_message(Dialog *d, M
     m->is_pinned = false;
   }
   if (dialog_id == td_->dialog_manager_->get_my_dialog_id() && !m->saved_messages_topic_id.is_valid()) {
-    m->saved_messages_topic_id = SavedMessagesTopicId(dialog_id, m->forward_info.get(), m->real_forward_from_dialog_id);
+    m->saved_messages_topic_id =
+        SavedMessagesTopicId(dialog_id, m->forward_info.get(), m->get_send_info().real_forward_from_dialog_id);
   }
 
   LOG(INFO) << "Loaded " << m->message_id << " in " << dialog_id << " of size " << value.size() << " from database";
@@ -22633,16 +23012,17 @@ tl_object_ptr<td_api::MessageSendingState> MessagesManager::get_message_sending_
   }
   if (m->is_failed_to_send) {
     auto can_retry = can_resend_message(m);
-    auto error_code = m->send_error_code > 0 ? m->send_error_code : 400;
+    const auto &send_info = m->get_send_info();
+    auto error_code = send_info.send_error_code > 0 ? send_info.send_error_code : 400;
     auto need_another_sender =
-        can_retry && error_code == 400 && m->send_error_message == CSlice("SEND_AS_PEER_INVALID");
+        can_retry && error_code == 400 && send_info.send_error_message == CSlice("SEND_AS_PEER_INVALID");
     auto need_another_reply_quote =
-        can_retry && error_code == 400 && m->send_error_message == CSlice("QUOTE_TEXT_INVALID");
+        can_retry && error_code == 400 && send_info.send_error_message == CSlice("QUOTE_TEXT_INVALID");
     auto need_drop_reply =
-        can_retry && error_code == 400 && m->send_error_message == CSlice("REPLY_MESSAGE_ID_INVALID");
+        can_retry && error_code == 400 && send_info.send_error_message == CSlice("REPLY_MESSAGE_ID_INVALID");
     return td_api::make_object<td_api::messageSendingStateFailed>(
-        td_api::make_object<td_api::error>(error_code, m->send_error_message), can_retry, need_another_sender,
-        need_another_reply_quote, need_drop_reply, max(m->try_resend_at - Time::now(), 0.0));
+        td_api::make_object<td_api::error>(error_code, send_info.send_error_message), can_retry, need_another_sender,
+        need_another_reply_quote, need_drop_reply, max(send_info.try_resend_at - Time::now(), 0.0));
   }
   return nullptr;
 }
@@ -23034,10 +23414,11 @@ unique_ptr<MessagesManager::Message> MessagesManager::create_message_to_send(
   m->date = is_scheduled ? options.schedule_date : m->send_date;
   m->replied_message_info = RepliedMessageInfo(td_, input_reply_to);
   m->reply_to_story_full_id = input_reply_to.get_story_full_id();
-  m->input_reply_to = std::move(input_reply_to);
-  m->reply_to_random_id = reply_to_random_id;
+  auto &send_info = m->edit_send_info();
+  send_info.input_reply_to = std::move(input_reply_to);
+  send_info.reply_to_random_id = reply_to_random_id;
   m->top_thread_message_id = top_thread_message_id;
-  m->initial_top_thread_message_id = initial_top_thread_message_id;
+  send_info.initial_top_thread_message_id = initial_top_thread_message_id;
   m->is_topic_message = is_topic_message;
   m->is_channel_post = is_channel_post;
   m->is_outgoing = is_scheduled || dialog_id != DialogId(my_id);
@@ -23062,7 +23443,7 @@ unique_ptr<MessagesManager::Message> MessagesManager::create_message_to_send(
         if (is_channel_post) {
           return td_->chat_manager_->get_channel_has_linked_channel(dialog_id.get_channel_id());
         }
-        return !m->input_reply_to.is_valid();
+        return !m->get_send_info().input_reply_to.is_valid();
       }()) {
     m->reply_info.reply_count_ = 0;
     if (is_channel_post) {
@@ -23081,7 +23462,7 @@ unique_ptr<MessagesManager::Message> MessagesManager::create_message_to_send(
   m->content = std::move(content);
   m->invert_media = invert_media;
   m->forward_info = std::move(forward_info);
-  m->real_forward_from_dialog_id = real_forward_from_dialog_id;
+  m->edit_send_info().real_forward_from_dialog_id = real_forward_from_dialog_id;
   m->is_copy = is_copy || m->forward_info != nullptr;
   m->sending_id = options.sending_id;
 
@@ -23102,7 +23483,8 @@ unique_ptr<MessagesManager::Message> MessagesManager::create_message_to_send(
     m->is_content_secret = m->ttl.is_secret_message_content(m->content->get_type());
   }
   if (dialog_id == DialogId(my_id)) {
-    m->saved_messages_topic_id = SavedMessagesTopicId(dialog_id, m->forward_info.get(), m->real_forward_from_dialog_id);
+    m->saved_messages_topic_id =
+        SavedMessagesTopicId(dialog_id, m->forward_info.get(), m->get_send_info().real_forward_from_dialog_id);
   }
 
   return message;
@@ -23300,7 +23682,7 @@ MessagesManager::ForwardedMessageInfo MessagesManager::get_forwarded_message_inf
 const MessageInputReplyTo *MessagesManager::get_message_input_reply_to(const Message *m) {
   CHECK(m != nullptr);
   CHECK(!m->message_id.is_any_server());
-  return &m->input_reply_to;
+  return &m->get_send_info().input_reply_to;
 }
 
 vector<FileId> MessagesManager::get_message_file_ids(const Message *m) const {
@@ -23448,7 +23830,7 @@ void MessagesManager::add_message_dependencies(Dependencies &dependencies, const
   m->saved_messages_topic_id.add_dependencies(dependencies);
   m->replied_message_info.add_dependencies(dependencies, is_bot);
   dependencies.add_dialog_and_dependencies(m->reply_to_story_full_id.get_dialog_id());
-  dependencies.add_dialog_and_dependencies(m->real_forward_from_dialog_id);
+  dependencies.add_dialog_and_dependencies(m->get_send_info().real_forward_from_dialog_id);
   dependencies.add(m->via_bot_user_id);
   dependencies.add(m->via_business_bot_user_id);
   if (m->forward_info != nullptr) {
@@ -23669,7 +24051,7 @@ Result<td_api::object_ptr<td_api::message>> MessagesManager::send_message(
     m->ttl = message_content.ttl;
     m->is_content_secret = m->ttl.is_secret_message_content(m->content->get_type());
   }
-  m->send_emoji = std::move(message_content.emoji);
+  m->edit_send_info().send_emoji = std::move(message_content.emoji);
 
   if (message_send_options.only_preview) {
     return get_message_object(dialog_id, m, "send_message");
@@ -23734,7 +24116,7 @@ Result<InputMessageContent> MessagesManager::process_input_message_content(
 
     return InputMessageContent(std::move(content), get_message_disable_web_page_preview(copied_message),
                                new_invert_media, false, MessageSelfDestructType(), UserId(),
-                               copied_message->send_emoji);
+                               copied_message->get_send_info().send_emoji);
   }
 
   bool is_premium = td_->option_manager_->get_option_boolean("is_premium");
@@ -23949,8 +24331,13 @@ Result<td_api::object_ptr<td_api::messages>> MessagesManager::send_message_group
   return get_messages_object(-1, std::move(result), false);
 }
 
-void MessagesManager::save_send_message_log_event(DialogId dialog_id, const Message *m) {
-  if (!G()->use_message_database()) {
+bool MessagesManager::need_persist_unsent_messages() const {
+  // bots can opt out of resending of messages after restart to send messages faster
+  return !td_->auth_manager_->is_bot() || !td_->option_manager_->get_option_boolean("use_volatile_message_sending");
+}
+
+void MessagesManager::save_send_message_log_event(DialogId dialog_id, const Message *m) const {
+  if (!G()->use_message_database() || !need_persist_unsent_messages()) {
     return;
   }
 
@@ -24024,7 +24411,7 @@ void MessagesManager::do_send_message(DialogId dialog_id, const Message *m, int3
       CHECK(static_cast<size_t>(media_pos) < file_ids.size());
       CHECK(static_cast<size_t>(media_pos) < thumbnail_file_ids.size());
     }
-    auto input_media = get_message_content_input_media(content, td_, m->ttl, m->send_emoji,
+    auto input_media = get_message_content_input_media(content, td_, m->ttl, m->get_send_info().send_emoji,
                                                        td_->auth_manager_->is_bot() && bad_parts.empty());
     if (input_media == nullptr || media_pos >= 0 || !bad_parts.empty() ||
         content_type == MessageContentType::PaidMedia) {
@@ -24135,8 +24522,8 @@ void MessagesManager::on_message_media_uploaded(DialogId dialog_id, const Messag
           int64 random_id = begin_send_message(dialog_id, m);
           td_->create_handler<SendMediaQuery>()->send(
               std::move(file_ids), std::move(thumbnail_file_ids), get_message_flags(m), dialog_id,
-              get_send_message_as_input_peer(m), *get_message_input_reply_to(m), m->initial_top_thread_message_id,
-              get_message_schedule_date(m), m->effect_id,
+              get_send_message_as_input_peer(m), *get_message_input_reply_to(m),
+              m->get_send_info().initial_top_thread_message_id, get_message_schedule_date(m), m->effect_id,
               get_input_reply_markup(td_->user_manager_.get(), m->reply_markup),
               get_input_message_entities(td_->user_manager_.get(), caption, "on_message_media_uploaded"),
               caption == nullptr ? "" : caption->text, std::move(input_media), m->content->get_type(), m->is_copy,
@@ -24217,7 +24604,7 @@ void MessagesManager::send_secret_message(DialogId dialog_id, const Message *m,
   }
 
   int32 flags = 0;
-  if (m->reply_to_random_id != 0) {
+  if (m->get_send_info().reply_to_random_id != 0) {
     flags |= secret_api::decryptedMessage::REPLY_TO_RANDOM_ID_MASK;
   }
   if (m->via_bot_user_id.is_valid()) {
@@ -24242,8 +24629,8 @@ void MessagesManager::send_secret_message(DialogId dialog_id, const Message *m,
       make_tl_object<secret_api::decryptedMessage>(
           flags, false /*ignored*/, random_id, m->ttl.get_input_ttl(),
           m->content->get_type() == MessageContentType::Text ? text->text : string(), std::move(media.decrypted_media_),
-          std::move(entities), td_->user_manager_->get_user_first_username(m->via_bot_user_id), m->reply_to_random_id,
-          -m->media_album_id),
+          std::move(entities), td_->user_manager_->get_user_first_username(m->via_bot_user_id),
+          m->get_send_info().reply_to_random_id, -m->media_album_id),
       std::move(media.input_file_), Promise<Unit>());
 }
 
@@ -24280,7 +24667,8 @@ void MessagesManager::on_upload_message_media_success(DialogId dialog_id, Messag
     on_message_changed(d, m, need_update, "on_upload_message_media_success");
   }
 
-  auto input_media = get_message_content_input_media(m->content.get(), td_, m->ttl, m->send_emoji, true, media_pos);
+  auto input_media = get_message_content_input_media(m->content.get(), td_, m->ttl,
+                                                     m->get_send_info().send_emoji, true, media_pos);
   Status result;
   if (input_media == nullptr) {
     result = Status::Error(400, "Failed to upload file");
@@ -24475,7 +24863,7 @@ void MessagesManager::do_send_message_group(int64 media_album_id) {
     }
 
     input_reply_to = get_message_input_reply_to(m);
-    top_thread_message_id = m->initial_top_thread_message_id;
+    top_thread_message_id = m->get_send_info().initial_top_thread_message_id;
     flags = get_message_flags(m);
     schedule_date = get_message_schedule_date(m);
     effect_id = m->effect_id;
@@ -24494,7 +24882,8 @@ void MessagesManager::do_send_message_group(int64 media_album_id) {
     }
 
     const FormattedText *caption = get_message_content_caption(m->content.get());
-    auto input_media = get_message_content_input_media(m->content.get(), td_, m->ttl, m->send_emoji, true);
+    auto input_media = get_message_content_input_media(m->content.get(), td_, m->ttl,
+                                                       m->get_send_info().send_emoji, true);
     if (input_media == nullptr) {
       // TODO return CHECK
       auto file_id = get_message_content_any_file_id(m->content.get());
@@ -24592,7 +24981,8 @@ void MessagesManager::do_send_paid_media_group(DialogId dialog_id, MessageId mes
 
   auto file_ids = get_message_content_any_file_ids(m->content.get());
   auto thumbnail_file_ids = get_message_content_thumbnail_file_ids(m->content.get(), td_);
-  auto input_media = get_message_content_input_media(m->content.get(), td_, m->ttl, m->send_emoji, true);
+  auto input_media = get_message_content_input_media(m->content.get(), td_, m->ttl,
+                                                     m->get_send_info().send_emoji, true);
   CHECK(input_media != nullptr);
   pending_paid_media_group_sends_.erase(it);
 
@@ -24601,8 +24991,9 @@ void MessagesManager::do_send_paid_media_group(DialogId dialog_id, MessageId mes
   const FormattedText *caption = get_message_content_caption(m->content.get());
   td_->create_handler<SendMediaQuery>()->send(
       std::move(file_ids), std::move(thumbnail_file_ids), get_message_flags(m), dialog_id,
-      get_send_message_as_input_peer(m), *get_message_input_reply_to(m), m->initial_top_thread_message_id,
-      get_message_schedule_date(m), m->effect_id, get_input_reply_markup(td_->user_manager_.get(), m->reply_markup),
+      get_send_message_as_input_peer(m), *get_message_input_reply_to(m),
+      m->get_send_info().initial_top_thread_message_id, get_message_schedule_date(m), m->effect_id,
+      get_input_reply_markup(td_->user_manager_.get(), m->reply_markup),
       get_input_message_entities(td_->user_manager_.get(), caption, "do_send_paid_media_group"),
       caption == nullptr ? "" : caption->text, std::move(input_media), m->content->get_type(), m->is_copy, random_id,
       &m->send_query_ref);
@@ -24638,14 +25029,14 @@ void MessagesManager::on_text_message_ready_to_send(DialogId dialog_id, MessageI
     if (input_media == nullptr) {
       td_->create_handler<SendMessageQuery>()->send(
           get_message_flags(m), dialog_id, get_send_message_as_input_peer(m), *get_message_input_reply_to(m),
-          m->initial_top_thread_message_id, get_message_schedule_date(m), m->effect_id,
+          m->get_send_info().initial_top_thread_message_id, get_message_schedule_date(m), m->effect_id,
           get_input_reply_markup(td_->user_manager_.get(), m->reply_markup),
           get_input_message_entities(td_->user_manager_.get(), message_text, "on_text_message_ready_to_send"),
           message_text->text, m->is_copy, random_id, &m->send_query_ref);
     } else {
       td_->create_handler<SendMediaQuery>()->send(
           {}, {}, get_message_flags(m), dialog_id, get_send_message_as_input_peer(m), *get_message_input_reply_to(m),
-          m->initial_top_thread_message_id, get_message_schedule_date(m), m->effect_id,
+          m->get_send_info().initial_top_thread_message_id, get_message_schedule_date(m), m->effect_id,
           get_input_reply_markup(td_->user_manager_.get(), m->reply_markup),
           get_input_message_entities(td_->user_manager_.get(), message_text, "on_text_message_ready_to_send"),
           message_text->text, std::move(input_media), MessageContentType::Text, m->is_copy, random_id,
@@ -25044,7 +25435,7 @@ void MessagesManager::do_send_inline_query_result_message(DialogId dialog_id, Me
   }
   m->send_query_ref = td_->create_handler<SendInlineBotResultQuery>()->send(
       flags, dialog_id, get_send_message_as_input_peer(m), *get_message_input_reply_to(m),
-      m->initial_top_thread_message_id, get_message_schedule_date(m), random_id, query_id, result_id);
+      m->get_send_info().initial_top_thread_message_id, get_message_schedule_date(m), random_id, query_id, result_id);
 }
 
 bool MessagesManager::can_edit_message(DialogId dialog_id, const Message *m, bool is_editing,
@@ -25162,15 +25553,17 @@ bool MessagesManager::can_edit_message(DialogId dialog_id, const Message *m, boo
 }
 
 bool MessagesManager::can_resend_message(const Message *m) const {
-  if (m->send_error_code != 429 && m->send_error_message != "Message is too old to be re-sent automatically" &&
-      m->send_error_message != "SCHEDULE_TOO_MUCH" && m->send_error_message != "SEND_AS_PEER_INVALID" &&
-      m->send_error_message != "QUOTE_TEXT_INVALID" && m->send_error_message != "REPLY_MESSAGE_ID_INVALID") {
+  const auto &send_info = m->get_send_info();
+  const auto &error_message = send_info.send_error_message;
+  if (send_info.send_error_code != 429 && error_message != "Message is too old to be re-sent automatically" &&
+      error_message != "SCHEDULE_TOO_MUCH" && error_message != "SEND_AS_PEER_INVALID" &&
+      error_message != "QUOTE_TEXT_INVALID" && error_message != "REPLY_MESSAGE_ID_INVALID") {
     return false;
   }
   if (m->is_bot_start_message) {
     return false;
   }
-  if (m->forward_info != nullptr || m->real_forward_from_dialog_id.is_valid()) {
+  if (m->forward_info != nullptr || send_info.real_forward_from_dialog_id.is_valid()) {
     // TODO implement resending of forwarded messages
     return false;
   }
@@ -26116,7 +26509,7 @@ void MessagesManager::do_forward_messages(DialogId to_dialog_id, DialogId from_d
     return;
   }
 
-  if (log_event_id == 0 && G()->use_message_database()) {
+  if (log_event_id == 0 && G()->use_message_database() && need_persist_unsent_messages()) {
     log_event_id = save_forward_messages_log_event(to_dialog_id, from_dialog_id, messages, message_ids, drop_author,
                                                    drop_media_captions);
   }
@@ -26153,8 +26546,9 @@ void MessagesManager::do_forward_messages(DialogId to_dialog_id, DialogId from_d
   vector<int64> random_ids =
       transform(messages, [this, to_dialog_id](const Message *m) { return begin_send_message(to_dialog_id, m); });
   send_closure_later(actor_id(this), &MessagesManager::send_forward_message_query, flags, to_dialog_id,
-                     messages[0]->initial_top_thread_message_id, from_dialog_id, std::move(as_input_peer), message_ids,
-                     std::move(random_ids), schedule_date, get_erase_log_event_promise(log_event_id));
+                     messages[0]->get_send_info().initial_top_thread_message_id, from_dialog_id,
+                     std::move(as_input_peer), message_ids, std::move(random_ids), schedule_date,
+                     get_erase_log_event_promise(log_event_id));
 }
 
 void MessagesManager::send_forward_message_query(int32 flags, DialogId to_dialog_id,
@@ -26572,7 +26966,7 @@ Result<td_api::object_ptr<td_api::messages>> MessagesManager::forward_messages(
     fix_forwarded_message(m, to_dialog_id, forwarded_message, forwarded_message_contents[j].media_album_id,
                           drop_author);
     m->in_game_share = in_game_share;
-    m->real_forward_from_message_id = message_id;
+    m->edit_send_info().real_forward_from_message_id = message_id;
     forwarded_message_id_to_new_message_id.emplace(message_id, m->message_id);
     if (forwarded_message->replied_message_info.is_external()) {
       if (!message_send_options.only_preview) {
@@ -26834,7 +27228,7 @@ Result<vector<MessageId>> MessagesManager::resend_messages(DialogId dialog_id, v
     if (!can_resend_message(m)) {
       return Status::Error(400, "Message can't be re-sent");
     }
-    if (m->try_resend_at > Time::now()) {
+    if (m->get_send_info().try_resend_at > Time::now()) {
       return Status::Error(400, "Message can't be re-sent yet");
     }
     if (last_message_id != MessageId()) {
@@ -26896,23 +27290,24 @@ Result<vector<MessageId>> MessagesManager::resend_messages(DialogId dialog_id, v
     CHECK(message != nullptr);
     send_update_delete_messages(dialog_id, {message->message_id.get()}, true);
 
+    auto &send_info = message->edit_send_info();
     auto need_another_sender =
-        message->send_error_code == 400 && message->send_error_message == CSlice("SEND_AS_PEER_INVALID");
+        send_info.send_error_code == 400 && send_info.send_error_message == CSlice("SEND_AS_PEER_INVALID");
     auto need_another_reply_quote =
-        message->send_error_code == 400 && message->send_error_message == CSlice("QUOTE_TEXT_INVALID");
+        send_info.send_error_code == 400 && send_info.send_error_message == CSlice("QUOTE_TEXT_INVALID");
     auto need_drop_reply =
-        message->send_error_code == 400 && message->send_error_message == CSlice("REPLY_MESSAGE_ID_INVALID");
+        send_info.send_error_code == 400 && send_info.send_error_message == CSlice("REPLY_MESSAGE_ID_INVALID");
     if (need_another_reply_quote && message_ids.size() == 1 && quote != nullptr) {
-      CHECK(message->input_reply_to.is_valid());
-      CHECK(message->input_reply_to.has_quote());  // checked in on_send_message_fail
-      message->input_reply_to.set_quote(MessageQuote{td_, std::move(quote)});
+      CHECK(send_info.input_reply_to.is_valid());
+      CHECK(send_info.input_reply_to.has_quote());  // checked in on_send_message_fail
+      send_info.input_reply_to.set_quote(MessageQuote{td_, std::move(quote)});
     } else if (need_drop_reply) {
-      message->input_reply_to = {};
+      send_info.input_reply_to = {};
     }
     MessageSendOptions options(message->disable_notification, message->from_background,
                                message->update_stickersets_order, message->noforwards, false,
                                get_message_schedule_date(message.get()), message->sending_id, message->effect_id);
-    Message *m = get_message_to_send(d, message->top_thread_message_id, std::move(message->input_reply_to), options,
+    Message *m = get_message_to_send(d, message->top_thread_message_id, std::move(send_info.input_reply_to), options,
                                      std::move(new_contents[i]), message->invert_media, &need_update_dialog_pos, false,
                                      nullptr, DialogId(), message->is_copy,
                                      need_another_sender ? DialogId() : get_message_sender(message.get()));
@@ -26923,7 +27318,7 @@ Result<vector<MessageId>> MessagesManager::resend_messages(DialogId dialog_id, v
     m->ttl = message->ttl;
     m->is_content_secret = message->is_content_secret;
     m->media_album_id = new_media_album_ids[message->media_album_id].first;
-    m->send_emoji = message->send_emoji;
+    m->edit_send_info().send_emoji = send_info.send_emoji;
     m->has_explicit_sender |= message->has_explicit_sender;
 
     save_send_message_log_event(dialog_id, m);
@@ -27151,7 +27546,7 @@ Result<MessageId> MessagesManager::add_local_message(
     m->ttl = message_content.ttl;
   }
   m->is_content_secret = m->ttl.is_secret_message_content(m->content->get_type());
-  m->send_emoji = std::move(message_content.emoji);
+  m->edit_send_info().send_emoji = std::move(message_content.emoji);
   if (dialog_id == DialogId(my_id)) {
     m->saved_messages_topic_id = SavedMessagesTopicId(dialog_id, m->forward_info.get(), DialogId());
   }
@@ -28693,10 +29088,40 @@ void MessagesManager::send_update_last_message_if_needed(const Dialog *d, const
 }
 
 void MessagesManager::send_update_chat_last_message(Dialog *d, const char *source) {
+  if (updates_batch_depth_ > 0 && d->order != DEFAULT_ORDER && !td_->auth_manager_->is_bot()) {
+    // the chat has already been added to chat lists, so its position can be changed later
+    if (batched_last_message_dialog_id_set_.insert(d->dialog_id).second) {
+      batched_last_message_dialog_ids_.push_back(d->dialog_id);
+    }
+    return;
+  }
   update_dialog_pos(d, source, false);
   send_update_chat_last_message_impl(d, source);
 }
 
+void MessagesManager::begin_updates_batch() {
+  updates_batch_depth_++;
+}
+
+void MessagesManager::end_updates_batch() {
+  CHECK(updates_batch_depth_ > 0);
+  if (--updates_batch_depth_ > 0) {
+    return;
+  }
+
+  auto dialog_ids = std::move(batched_last_message_dialog_ids_);
+  batched_last_message_dialog_ids_.clear();
+  batched_last_message_dialog_id_set_.clear();
+  if (dialog_ids.size() > 1) {
+    LOG(INFO) << "Send batched updateChatLastMessage for " << dialog_ids.size() << " chats";
+  }
+  for (auto dialog_id : dialog_ids) {
+    auto d = get_dialog(dialog_id);
+    CHECK(d != nullptr);
+    send_update_chat_last_message(d, "end_updates_batch");
+  }
+}
+
 void MessagesManager::send_update_chat_last_message_impl(const Dialog *d, const char *source) const {
   if (td_->auth_manager_->is_bot()) {
     return;
@@ -28843,6 +29268,9 @@ void MessagesManager::send_update_chat_read_inbox(const Dialog *d, bool force, c
     }
   } else {
     postponed_chat_read_inbox_updates_.erase(d->dialog_id);
+    if (!td_->is_update_needed(td_api::updateChatReadInbox::ID)) {
+      return;
+    }
     LOG(INFO) << "Send updateChatReadInbox in " << d->dialog_id << "("
               << td_->dialog_manager_->get_dialog_title(d->dialog_id) << ") to " << d->server_unread_count << " + "
               << d->local_unread_count << " from " << source;
@@ -29311,6 +29739,9 @@ MessageFullId MessagesManager::on_send_message_success(int64 random_id, MessageI
 
   send_update_message_send_succeeded(d, old_message_id, sent_message.get(), &need_update_dialog_pos);
 
+  // sending-only data isn't needed anymore
+  sent_message->send_info = nullptr;
+
   bool need_update = true;
   Message *m =
       add_message_to_dialog(d, std::move(sent_message), false, true, &need_update, &need_update_dialog_pos, source);
@@ -29760,13 +30191,17 @@ void MessagesManager::fail_send_message(MessageFullId message_full_id, int32 err
     message->view_count = 0;
   }
   message->is_failed_to_send = true;
-  message->send_error_code = error_code;
-  message->send_error_message = error_message;
-  message->try_resend_at = 0.0;
+  auto &send_info = message->edit_send_info();
+  send_info.send_error_code = error_code;
+  send_info.send_error_message = error_message;
+  send_info.try_resend_at = 0.0;
   auto retry_after = Global::get_retry_after(error_code, error_message);
   if (retry_after > 0) {
-    message->try_resend_at = Time::now() + retry_after;
+    send_info.try_resend_at = Time::now() + retry_after;
   }
+  // the data is used only while the message is being sent; resend_messages creates a new message
+  send_info.reply_to_random_id = 0;
+  send_info.initial_top_thread_message_id = MessageId();
   update_failed_to_send_message_content(td_, message->content);
 
   bool need_update = false;
@@ -29905,8 +30340,9 @@ void MessagesManager::clear_dialog_draft_by_sent_message(Dialog *d, const Messag
   }
   if (!m->clear_draft) {
     const DraftMessage *draft_message = nullptr;
-    if (m->initial_top_thread_message_id.is_valid()) {
-      auto top_m = get_message_force(d, m->initial_top_thread_message_id, "clear_dialog_draft_by_sent_message");
+    auto initial_top_thread_message_id = m->get_send_info().initial_top_thread_message_id;
+    if (initial_top_thread_message_id.is_valid()) {
+      auto top_m = get_message_force(d, initial_top_thread_message_id, "clear_dialog_draft_by_sent_message");
       if (top_m != nullptr) {
         draft_message = top_m->thread_draft_message.get();
       }
@@ -29917,8 +30353,8 @@ void MessagesManager::clear_dialog_draft_by_sent_message(Dialog *d, const Messag
       return;
     }
   }
-  if (m->initial_top_thread_message_id.is_valid()) {
-    set_dialog_draft_message(d->dialog_id, m->initial_top_thread_message_id, nullptr).ignore();
+  if (m->get_send_info().initial_top_thread_message_id.is_valid()) {
+    set_dialog_draft_message(d->dialog_id, m->get_send_info().initial_top_thread_message_id, nullptr).ignore();
   } else {
     update_dialog_draft_message(d, nullptr, false, need_update_dialog_pos);
   }
@@ -31325,7 +31761,7 @@ void MessagesManager::get_dialog_filter_dialog_count(td_api::object_ptr<td_api::
       }
 
       auto dialog_id = dialog_date.get_dialog_id();
-      if (dialog_filter->need_dialog(td_, get_dialog_info_for_dialog_filter(get_dialog(dialog_id)))) {
+      if (dialog_filter->need_dialog(get_dialog_info_for_dialog_filter(get_dialog(dialog_id)))) {
         total_count++;
       }
     }
@@ -31446,7 +31882,7 @@ void MessagesManager::edit_dialog_list_for_dialog_filter(unique_ptr<DialogFilter
       const DialogPositionInList old_position = get_dialog_position_in_list(old_list_ptr, d);
       // can't use get_dialog_position_in_list, because need_dialog_in_list calls get_dialog_filter
       DialogPositionInList new_position;
-      if (new_dialog_filter->need_dialog(td_, get_dialog_info_for_dialog_filter(d))) {
+      if (new_dialog_filter->need_dialog(get_dialog_info_for_dialog_filter(d))) {
         new_position.private_order = get_dialog_private_order(&new_list, d);
         if (new_position.private_order != 0) {
           new_position.public_order =
@@ -32022,6 +32458,7 @@ const MessagesManager::Message *MessagesManager::get_message(const Dialog *d, Me
         auto list_node = const_cast<ListNode *>(static_cast<const ListNode *>(result));
         list_node->remove();
         d->message_lru_list.put_back(list_node);
+        touch_dialog_message_cache_node(d);
       }
     }
   }
@@ -32953,6 +33390,8 @@ MessagesManager::Message *MessagesManager::add_message_to_dialog(Dialog *d, uniq
   d->messages.set(message_id, std::move(message));
 
   d->message_lru_list.put_back(result_message);
+  loaded_message_count_++;
+  on_dialog_message_cache_access(d);
 
   switch (dialog_type) {
     case DialogType::User:
@@ -33237,6 +33676,9 @@ void MessagesManager::add_message_to_database(const Dialog *d, const Message *m,
     return;
   }
   LOG_CHECK(message_id.is_server() || message_id.is_local()) << source;
+  if (message_id.is_yet_unsent() && !need_persist_unsent_messages()) {
+    return;
+  }
 
   LOG(INFO) << "Add " << MessageFullId(d->dialog_id, message_id) << " to database from " << source;
 
@@ -33680,7 +34122,8 @@ bool MessagesManager::update_message(Dialog *d, Message *old_message, unique_ptr
       LOG(ERROR) << message_id << " in " << dialog_id << " sent by " << old_message->sender_user_id << "/"
                  << old_message->sender_dialog_id << " has changed forward info from " << old_message->forward_info
                  << " to " << new_message->forward_info << ", really forwarded from "
-                 << old_message->real_forward_from_message_id << " in " << old_message->real_forward_from_dialog_id
+                 << old_message->get_send_info().real_forward_from_message_id << " in "
+                 << old_message->get_send_info().real_forward_from_dialog_id
                  << ", message content type is " << old_content_type << '/' << new_content_type;
     } else {
       LOG(DEBUG) << "Message forward info has changed from " << old_message->forward_info << " to "
@@ -33820,7 +34263,7 @@ bool MessagesManager::update_message(Dialog *d, Message *old_message, unique_ptr
     old_message->reply_to_story_full_id = new_message->reply_to_story_full_id;
     old_message->top_thread_message_id = new_message->top_thread_message_id;
     old_message->is_topic_message = new_message->is_topic_message;
-    old_message->reply_to_random_id = get_message_reply_to_random_id(d, old_message);
+    old_message->set_reply_to_random_id(get_message_reply_to_random_id(d, old_message));
 
     if (is_message_in_dialog) {
       register_message_reply(d->dialog_id, old_message);
@@ -34076,7 +34519,7 @@ bool MessagesManager::need_message_changed_warning(const Message *old_message) {
   }
   if (old_message->message_id.is_yet_unsent() &&
       (old_message->forward_info != nullptr || old_message->had_forward_info ||
-       old_message->real_forward_from_dialog_id.is_valid())) {
+       old_message->get_send_info().real_forward_from_dialog_id.is_valid())) {
     // original message may be edited
     return false;
   }
@@ -35253,7 +35696,7 @@ bool MessagesManager::set_dialog_order(Dialog *d, int64 new_order, bool need_sen
   if (old_date == new_date) {
     if (new_order == DEFAULT_ORDER) {
       // first addition of a new left dialog
-      if (folder.ordered_dialogs_.insert(new_date).second) {
+      if (folder.ordered_dialogs_.insert(new_date)) {
         for (const auto &dialog_list : dialog_lists_) {
           if (get_dialog_pinned_order(&dialog_list.second, d->dialog_id) != DEFAULT_ORDER) {
             set_dialog_is_pinned(dialog_list.first, d, false);
@@ -35333,12 +35776,26 @@ void MessagesManager::update_dialog_lists(
     }
   }
 
+  // the chat is checked against all chat folders at once, so calculate the chat information needed for them only once
+  DialogFilterDialogInfo dialog_info;
+  bool has_dialog_info = false;
+  if (d->order != DEFAULT_ORDER) {
+    for (auto &dialog_list : dialog_lists_) {
+      if (dialog_list.first.is_filter()) {
+        dialog_info = get_dialog_info_for_dialog_filter(d);
+        has_dialog_info = true;
+        break;
+      }
+    }
+  }
+
   for (auto &dialog_list : dialog_lists_) {
     auto dialog_list_id = dialog_list.first;
     auto &list = dialog_list.second;
 
     const DialogPositionInList &old_position = old_positions[dialog_list_id];
-    const DialogPositionInList new_position = get_dialog_position_in_list(&list, d, true);
+    const DialogPositionInList new_position =
+        get_dialog_position_in_list(&list, d, true, has_dialog_info ? &dialog_info : nullptr);
 
     // sponsored chat is never "in list"
     bool was_in_list = old_position.order != DEFAULT_ORDER && old_position.private_order != 0;
@@ -35790,6 +36247,33 @@ DialogFilterDialogInfo MessagesManager::get_dialog_info_for_dialog_filter(const
   dialog_info.has_unread_mentions_ = d->unread_mention_count != 0 && !is_dialog_mention_notifications_disabled(d);
   dialog_info.is_muted_ = is_dialog_muted(d);
   dialog_info.has_unread_messages_ = d->server_unread_count + d->local_unread_count != 0 || d->is_marked_as_unread;
+  auto dialog_id = d->dialog_id;
+  switch (dialog_id.get_type()) {
+    case DialogType::User: {
+      auto user_id = dialog_id.get_user_id();
+      dialog_info.is_bot_ = td_->user_manager_->is_user_bot(user_id);
+      dialog_info.is_contact_ =
+          user_id == td_->user_manager_->get_my_id() || td_->user_manager_->is_user_contact(user_id);
+      break;
+    }
+    case DialogType::Chat:
+      break;
+    case DialogType::Channel:
+      dialog_info.is_broadcast_ = td_->chat_manager_->is_broadcast_channel(dialog_id.get_channel_id());
+      break;
+    case DialogType::SecretChat: {
+      auto user_id = td_->user_manager_->get_secret_chat_user_id(dialog_id.get_secret_chat_id());
+      if (user_id.is_valid()) {
+        dialog_info.secret_chat_user_dialog_id_ = DialogId(user_id);
+        dialog_info.is_bot_ = td_->user_manager_->is_user_bot(user_id);
+        dialog_info.is_contact_ = td_->user_manager_->is_user_contact(user_id);
+      }
+      break;
+    }
+    case DialogType::None:
+    default:
+      UNREACHABLE();
+  }
   return dialog_info;
 }
 
@@ -35799,7 +36283,8 @@ bool MessagesManager::is_dialog_in_dialog_list(DialogId dialog_id) const {
   return d != nullptr && d->order != DEFAULT_ORDER;
 }
 
-bool MessagesManager::need_dialog_in_list(const Dialog *d, const DialogList &list) const {
+bool MessagesManager::need_dialog_in_list(const Dialog *d, const DialogList &list,
+                                          const DialogFilterDialogInfo *dialog_info) const {
   CHECK(!td_->auth_manager_->is_bot());
   if (d->order == DEFAULT_ORDER) {
     return false;
@@ -35808,8 +36293,11 @@ bool MessagesManager::need_dialog_in_list(const Dialog *d, const DialogList &lis
     return d->folder_id == list.dialog_list_id.get_folder_id();
   }
   if (list.dialog_list_id.is_filter()) {
-    return td_->dialog_filter_manager_->need_dialog_in_filter(list.dialog_list_id.get_filter_id(),
-                                                              get_dialog_info_for_dialog_filter(d));
+    auto dialog_filter_id = list.dialog_list_id.get_filter_id();
+    if (dialog_info != nullptr) {
+      return td_->dialog_filter_manager_->need_dialog_in_filter(dialog_filter_id, *dialog_info);
+    }
+    return td_->dialog_filter_manager_->need_dialog_in_filter(dialog_filter_id, get_dialog_info_for_dialog_filter(d));
   }
   UNREACHABLE();
   return false;
@@ -35826,15 +36314,16 @@ bool MessagesManager::need_send_update_chat_position(const DialogPositionInList
   return old_position.is_pinned != new_position.is_pinned || old_position.is_sponsored != new_position.is_sponsored;
 }
 
-MessagesManager::DialogPositionInList MessagesManager::get_dialog_position_in_list(const DialogList *list,
-                                                                                   const Dialog *d, bool actual) const {
+MessagesManager::DialogPositionInList MessagesManager::get_dialog_position_in_list(
+    const DialogList *list, const Dialog *d, bool actual, const DialogFilterDialogInfo *dialog_info) const {
   CHECK(!td_->auth_manager_->is_bot());
   CHECK(list != nullptr);
   CHECK(d != nullptr);
 
   DialogPositionInList position;
   position.order = d->order;
-  if (is_dialog_sponsored(d) || (actual ? need_dialog_in_list(d, *list) : is_dialog_in_list(d, list->dialog_list_id))) {
+  if (is_dialog_sponsored(d) ||
+      (actual ? need_dialog_in_list(d, *list, dialog_info) : is_dialog_in_list(d, list->dialog_list_id))) {
     position.private_order = get_dialog_private_order(list, d);
   }
   if (position.private_order != 0) {
@@ -36173,29 +36662,74 @@ void MessagesManager::do_get_channel_difference(DialogId dialog_id, int32 pts, b
     limit = MIN_CHANNEL_DIFFERENCE;
   }
 
-  pending_get_channel_differences_.push(
-      td::make_unique<PendingGetChannelDifference>(dialog_id, pts, limit, force, std::move(input_channel), source));
+  auto query =
+      td::make_unique<PendingGetChannelDifference>(dialog_id, pts, limit, force, std::move(input_channel), source);
+  if (need_prioritize_get_channel_difference(d)) {
+    prioritized_pending_get_channel_differences_.push(std::move(query));
+  } else {
+    pending_get_channel_differences_.push(std::move(query));
+  }
+  channel_difference_catch_up_total_count_++;
   process_pending_get_channel_differences();
 }
 
+bool MessagesManager::need_prioritize_get_channel_difference(const Dialog *d) const {
+  if (d == nullptr) {
+    return false;
+  }
+  return d->open_count > 0 || d->unread_mention_count > 0 || d->unread_reaction_count > 0;
+}
+
 void MessagesManager::process_pending_get_channel_differences() {
-  static constexpr int32 MAX_CONCURRENT_GET_CHANNEL_DIFFERENCES = 10;
+  auto max_concurrent_get_channel_differences = narrow_cast<int32>(
+      td_->option_manager_->get_option_integer("channel_difference_concurrent_query_count_max", 10));
 
-  if (pending_get_channel_differences_.empty() ||
-      get_channel_difference_count_ >= MAX_CONCURRENT_GET_CHANNEL_DIFFERENCES) {
+  if ((pending_get_channel_differences_.empty() && prioritized_pending_get_channel_differences_.empty()) ||
+      get_channel_difference_count_ >= max_concurrent_get_channel_differences) {
     return;
   }
 
   get_channel_difference_count_++;
 
-  auto query = std::move(pending_get_channel_differences_.front());
-  pending_get_channel_differences_.pop();
+  auto &queue = prioritized_pending_get_channel_differences_.empty() ? pending_get_channel_differences_
+                                                                     : prioritized_pending_get_channel_differences_;
+  auto query = std::move(queue.front());
+  queue.pop();
 
   LOG(INFO) << "-----BEGIN GET CHANNEL DIFFERENCE----- for " << query->dialog_id_ << " with PTS " << query->pts_
             << " and limit " << query->limit_ << " from " << query->source_;
 
   td_->create_handler<GetChannelDifferenceQuery>()->send(query->dialog_id_, std::move(query->input_channel_),
                                                          query->pts_, query->limit_, query->force_);
+
+  // fill all free slots at once
+  process_pending_get_channel_differences();
+}
+
+void MessagesManager::on_channel_difference_catch_up_progress() {
+  static constexpr int32 MIN_CATCH_UP_CHAT_COUNT = 10;
+
+  channel_difference_catch_up_finished_count_++;
+  auto total_count = channel_difference_catch_up_total_count_;
+  auto pending_count = total_count - channel_difference_catch_up_finished_count_;
+  CHECK(pending_count >= 0);
+  bool need_send_update = false;
+  if (pending_count == 0) {
+    need_send_update = is_channel_difference_catch_up_progress_sent_;
+  } else if (total_count >= MIN_CATCH_UP_CHAT_COUNT) {
+    // send at most 100 updates for a catch-up
+    need_send_update = !is_channel_difference_catch_up_progress_sent_ ||
+                       channel_difference_catch_up_finished_count_ % max(total_count / 100, 1) == 0;
+  }
+  if (need_send_update) {
+    is_channel_difference_catch_up_progress_sent_ = pending_count != 0;
+    send_closure(G()->td(), &Td::send_update,
+                 td_api::make_object<td_api::updateChatCatchUpProgress>(pending_count, total_count));
+  }
+  if (pending_count == 0) {
+    channel_difference_catch_up_total_count_ = 0;
+    channel_difference_catch_up_finished_count_ = 0;
+  }
 }
 
 void MessagesManager::process_get_channel_difference_updates(
@@ -36506,6 +37040,7 @@ void MessagesManager::on_get_channel_difference(DialogId dialog_id, int32 reques
                                                 Status &&status) {
   get_channel_difference_count_--;
   CHECK(get_channel_difference_count_ >= 0);
+  on_channel_difference_catch_up_progress();
   process_pending_get_channel_differences();
   LOG(INFO) << "----- END  GET CHANNEL DIFFERENCE----- for " << dialog_id;
   auto it = active_get_channel_differences_.find(dialog_id);
@@ -37098,9 +37633,9 @@ void MessagesManager::set_message_reply(const Dialog *d, Message *m, MessageInpu
   }
   m->replied_message_info = RepliedMessageInfo(td_, input_reply_to);
   m->reply_to_story_full_id = StoryFullId();
-  m->reply_to_random_id = get_message_reply_to_random_id(d, m);
+  m->set_reply_to_random_id(get_message_reply_to_random_id(d, m));
   if (!m->message_id.is_any_server()) {
-    m->input_reply_to = std::move(input_reply_to);
+    m->edit_send_info().input_reply_to = std::move(input_reply_to);
   }
   if (is_message_in_dialog) {
     register_message_reply(d->dialog_id, m);
@@ -37117,7 +37652,7 @@ void MessagesManager::update_message_reply_to_message_id(const Dialog *d, Messag
   }
   m->replied_message_info.set_message_id(reply_to_message_id);
   if (!m->message_id.is_any_server()) {
-    m->input_reply_to.set_message_id(reply_to_message_id);
+    m->edit_send_info().input_reply_to.set_message_id(reply_to_message_id);
   }
   if (is_message_in_dialog) {
     register_message_reply(d->dialog_id, m);
@@ -37139,7 +37674,8 @@ void MessagesManager::restore_message_reply_to_message_id(Dialog *d, Message *m)
   LOG_CHECK(m->replied_message_info.get_reply_message_full_id(d->dialog_id, true) == replied_message_full_id)
       << replied_message_full_id << ' ' << m->replied_message_info << ' ' << *input_reply_to;
 
-  auto message_id = get_message_id_by_random_id(d, m->reply_to_random_id, "restore_message_reply_to_message_id");
+  auto message_id =
+      get_message_id_by_random_id(d, m->get_send_info().reply_to_random_id, "restore_message_reply_to_message_id");
   if (message_id.is_valid() || message_id.is_valid_scheduled()) {
     update_message_reply_to_message_id(d, m, message_id, false);
   } else {
@@ -37212,6 +37748,7 @@ void MessagesManager::on_binlog_events(vector<BinlogEvent> &&events) {
   if (G()->close_flag()) {
     return;
   }
+  StartupProfiler::Phase phase(td_->startup_profiler_.get(), "MessagesManager::on_binlog_events");
   bool have_old_message_database = G()->use_message_database() && !G()->td_db()->was_dialog_db_created();
   for (auto &event : events) {
     CHECK(event.id_ != 0);
@@ -17,6 +17,7 @@
 #include "td/telegram/DialogFilterId.h"
 #include "td/telegram/DialogId.h"
 #include "td/telegram/DialogListId.h"
+#include "td/telegram/DialogListPrefetch.h"
 #include "td/telegram/DialogNotificationSettings.h"
 #include "td/telegram/DialogParticipant.h"
 #include "td/telegram/DialogSource.h"
@@ -87,6 +88,7 @@
 #include "td/utils/Heap.h"
 #include "td/utils/Hints.h"
 #include "td/utils/List.h"
+#include "td/utils/OrderedSet.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
@@ -114,6 +116,7 @@ class DialogFilter;
 class DraftMessage;
 class FactCheck;
 struct InputMessageContent;
+class MemoryStatistics;
 class MessageContent;
 class MessageForwardInfo;
 struct MessageReactions;
@@ -255,8 +258,17 @@ class MessagesManager final : public Actor {
                       int32 total_count, vector<tl_object_ptr<telegram_api::Message>> &&messages,
                       Promise<Unit> &&promise);
 
+  void on_get_dialog_list(FolderId folder_id,
+                          Result<telegram_api::object_ptr<telegram_api::messages_Dialogs>> r_dialogs,
+                          bool can_prefetch, Promise<Unit> &&promise);
+
   bool on_update_message_id(int64 random_id, MessageId new_message_id, const char *source);
 
+  // updates of chat last message and position are coalesced between the calls
+  void begin_updates_batch();
+
+  void end_updates_batch();
+
   void on_update_dialog_draft_message(DialogId dialog_id, MessageId top_thread_message_id,
                                       tl_object_ptr<telegram_api::DraftMessage> &&draft_message, bool force = false);
 
@@ -376,6 +388,10 @@ class MessagesManager final : public Actor {
 
   void on_failed_scheduled_message_deletion(DialogId dialog_id, const vector<MessageId> &message_ids);
 
+  void on_message_db_messages_pruned(DialogId dialog_id, MessageId first_kept_message_id);
+
+  void memory_stats(MemoryStatistics &statistics) const;
+
   void delete_dialog_history(DialogId dialog_id, bool remove_from_dialog_list, bool revoke, Promise<Unit> &&promise);
 
   void delete_topic_history(DialogId dialog_id, MessageId top_thread_message_id, Promise<Unit> &&promise);
@@ -1024,6 +1040,21 @@ class MessagesManager final : public Actor {
     tl_object_ptr<telegram_api::ReplyMarkup> reply_markup;
   };
 
+  // rarely used fields of messages being sent or failed to be sent, which are stored separately to keep Message small
+  struct MessageSendInfo {
+    MessageId initial_top_thread_message_id;  // for send_message
+    MessageInputReplyTo input_reply_to;       // for send_message
+    int64 reply_to_random_id = 0;             // for send_message and secret chats
+    string send_emoji;                        // for send_message
+
+    DialogId real_forward_from_dialog_id;    // for resend_message
+    MessageId real_forward_from_message_id;  // for resend_message
+
+    int32 send_error_code = 0;
+    string send_error_message;
+    double try_resend_at = 0;
+  };
+
   // Do not forget to update MessagesManager::update_message and all make_unique<Message> when this class is changed
   struct Message final : public ListNode {
     MessageId message_id;
@@ -1047,11 +1078,6 @@ class MessagesManager final : public Actor {
     MessageId linked_top_thread_message_id;
     vector<MessageId> local_thread_message_ids;
 
-    MessageId initial_top_thread_message_id;  // for send_message
-    MessageInputReplyTo input_reply_to;       // for send_message
-    int64 reply_to_random_id = 0;             // for send_message
-    string send_emoji;                        // for send_message
-
     UserId via_bot_user_id;
     UserId via_business_bot_user_id;
 
@@ -1093,9 +1119,6 @@ class MessagesManager final : public Actor {
 
     bool has_get_extended_media_query = false;
 
-    DialogId real_forward_from_dialog_id;    // for resend_message
-    MessageId real_forward_from_message_id;  // for resend_message
-
     NotificationId notification_id;
     NotificationId removed_notification_id;
 
@@ -1114,9 +1137,7 @@ class MessagesManager final : public Actor {
 
     int32 legacy_layer = 0;
 
-    int32 send_error_code = 0;
-    string send_error_message;
-    double try_resend_at = 0;
+    unique_ptr<MessageSendInfo> send_info;
 
     int32 ttl_period = 0;         // counted from message send date
     MessageSelfDestructType ttl;  // counted from message content view date
@@ -1147,6 +1168,24 @@ class MessagesManager final : public Actor {
 
     mutable NetQueryRef send_query_ref;
 
+    const MessageSendInfo &get_send_info() const {
+      static const MessageSendInfo empty_send_info;
+      return send_info == nullptr ? empty_send_info : *send_info;
+    }
+
+    MessageSendInfo &edit_send_info() {
+      if (send_info == nullptr) {
+        send_info = make_unique<MessageSendInfo>();
+      }
+      return *send_info;
+    }
+
+    void set_reply_to_random_id(int64 reply_to_random_id) {
+      if (reply_to_random_id != 0 || send_info != nullptr) {
+        edit_send_info().reply_to_random_id = reply_to_random_id;
+      }
+    }
+
     template <class StorerT>
     void store(StorerT &storer) const;
 
@@ -1184,6 +1223,12 @@ class MessagesManager final : public Actor {
     FlatHashMap<NotificationId, MessageId, NotificationIdHash> notification_id_to_message_id_;
   };
 
+  // node of the list of all dialogs ordered by the last access to their messages
+  struct DialogMessageCacheNode final : public ListNode {
+    DialogId dialog_id_;
+    ListNode *lru_list_ = nullptr;
+  };
+
   struct Dialog {
     DialogId dialog_id;
     MessageId last_new_message_id;  // identifier of the last known server message received from update, there should be
@@ -1335,6 +1380,8 @@ class MessagesManager final : public Actor {
 
     mutable ListNode message_lru_list;
 
+    mutable DialogMessageCacheNode message_cache_node;
+
     OrderedMessages ordered_messages;
 
     unique_ptr<DialogScheduledMessages> scheduled_messages;
@@ -1389,12 +1436,22 @@ class MessagesManager final : public Actor {
     DialogDate list_last_dialog_date_ = MIN_DIALOG_DATE;  // in memory
   };
 
+  struct DialogListPage {
+    FolderId folder_id_;
+    vector<telegram_api::object_ptr<telegram_api::User>> users_;
+    vector<telegram_api::object_ptr<telegram_api::Chat>> chats_;
+    vector<telegram_api::object_ptr<telegram_api::Dialog>> dialogs_;
+    int32 total_count_ = 0;
+    vector<telegram_api::object_ptr<telegram_api::Message>> messages_;
+    Promise<Unit> promise_;
+  };
+
   struct DialogFolder {
     FolderId folder_id;
     // date of the last loaded dialog in the folder
     DialogDate folder_last_dialog_date_{MAX_ORDINARY_DIALOG_ORDER, DialogId()};  // in memory
 
-    std::set<DialogDate> ordered_dialogs_;  // all known dialogs, including with default order
+    OrderedSet<DialogDate> ordered_dialogs_;  // all known dialogs, including with default order
 
     // date of last known user/group/channel dialog in the right order
     DialogDate last_server_dialog_date_{MAX_ORDINARY_DIALOG_ORDER, DialogId()};
@@ -1404,6 +1461,8 @@ class MessagesManager final : public Actor {
     MultiPromiseActor load_folder_dialog_list_multipromise_{
         "LoadDialogListMultiPromiseActor"};  // must be defined before pending_on_get_dialogs_
     int32 load_dialog_list_limit_max_ = 0;
+
+    unique_ptr<DialogListPrefetch> dialog_list_prefetch_;
   };
 
   class DialogListViewIterator {
@@ -1585,6 +1644,7 @@ class MessagesManager final : public Actor {
 
   static constexpr size_t MAX_GROUPED_MESSAGES = 10;               // server side limit
   static constexpr int32 MAX_GET_DIALOGS = 100;                    // server side limit
+  static constexpr size_t DIALOG_LIST_PAGE_ENTITY_BATCH_SIZE = 50;
   static constexpr int32 MAX_GET_HISTORY = 100;                    // server side limit
   static constexpr int32 MAX_SEARCH_MESSAGES = 100;                // server side limit
   static constexpr int32 MIN_SEARCH_PUBLIC_DIALOG_PREFIX_LEN = 4;  // server side limit
@@ -1954,6 +2014,16 @@ class MessagesManager final : public Actor {
 
   void unload_dialog(DialogId dialog_id, int32 delay);
 
+  void unload_dialog_messages(Dialog *d, const vector<MessageId> &message_ids);
+
+  int64 get_message_cache_max_size() const;
+
+  void on_dialog_message_cache_access(Dialog *d);
+
+  static void touch_dialog_message_cache_node(const Dialog *d);
+
+  void reduce_message_cache();
+
   void clear_dialog_message_list(Dialog *d, bool remove_from_dialog_list, int32 last_message_date);
 
   void delete_all_dialog_messages(Dialog *d, bool remove_from_dialog_list, bool is_permanently_deleted);
@@ -2111,6 +2181,8 @@ class MessagesManager final : public Actor {
 
   void preload_older_messages(const Dialog *d, MessageId min_message_id);
 
+  void prefetch_message_files(const Dialog *d, const vector<MessageId> &message_ids);
+
   void load_last_dialog_message_later(DialogId dialog_id);
 
   void load_last_dialog_message(const Dialog *d, const char *source);
@@ -2160,6 +2232,22 @@ class MessagesManager final : public Actor {
 
   void load_folder_dialog_list(FolderId folder_id, int32 limit, bool only_local);
 
+  void send_get_dialog_list_query(FolderId folder_id, DialogDate offset,
+                                  Promise<telegram_api::object_ptr<telegram_api::messages_Dialogs>> &&promise);
+
+  void get_dialog_list_from_server(FolderId folder_id, DialogDate offset, Promise<Unit> &&promise);
+
+  static DialogDate get_dialog_list_page_last_dialog_date(
+      FolderId folder_id, const vector<telegram_api::object_ptr<telegram_api::Dialog>> &dialogs,
+      const vector<telegram_api::object_ptr<telegram_api::Message>> &messages);
+
+  void prefetch_dialog_list(FolderId folder_id, DialogDate offset);
+
+  void on_prefetch_dialog_list(FolderId folder_id, DialogDate offset,
+                               Result<telegram_api::object_ptr<telegram_api::messages_Dialogs>> result);
+
+  void process_dialog_list_page(unique_ptr<DialogListPage> page);
+
   void on_load_folder_dialog_list(FolderId folder_id, Result<Unit> &&result);
 
   void load_folder_dialog_list_from_database(FolderId folder_id, int32 limit, Promise<Unit> &&promise);
@@ -2691,12 +2779,14 @@ class MessagesManager final : public Actor {
 
   DialogFilterDialogInfo get_dialog_info_for_dialog_filter(const Dialog *d) const;
 
-  bool need_dialog_in_list(const Dialog *d, const DialogList &list) const;
+  bool need_dialog_in_list(const Dialog *d, const DialogList &list,
+                           const DialogFilterDialogInfo *dialog_info = nullptr) const;
 
   static bool need_send_update_chat_position(const DialogPositionInList &old_position,
                                              const DialogPositionInList &new_position);
 
-  DialogPositionInList get_dialog_position_in_list(const DialogList *list, const Dialog *d, bool actual = false) const;
+  DialogPositionInList get_dialog_position_in_list(const DialogList *list, const Dialog *d, bool actual = false,
+                                                   const DialogFilterDialogInfo *dialog_info = nullptr) const;
 
   std::unordered_map<DialogListId, DialogPositionInList, DialogListIdHash> get_dialog_positions(const Dialog *d) const;
 
@@ -2987,6 +3077,10 @@ class MessagesManager final : public Actor {
 
   void process_pending_get_channel_differences();
 
+  bool need_prioritize_get_channel_difference(const Dialog *d) const;
+
+  void on_channel_difference_catch_up_progress();
+
   void process_get_channel_difference_updates(DialogId dialog_id, int32 new_pts,
                                               vector<tl_object_ptr<telegram_api::Message>> &&new_messages,
                                               vector<tl_object_ptr<telegram_api::Update>> &&other_updates);
@@ -3081,7 +3175,9 @@ class MessagesManager final : public Actor {
 
   void add_message_dependencies(Dependencies &dependencies, const Message *m);
 
-  static void save_send_message_log_event(DialogId dialog_id, const Message *m);
+  bool need_persist_unsent_messages() const;
+
+  void save_send_message_log_event(DialogId dialog_id, const Message *m) const;
 
   static uint64 save_toggle_dialog_report_spam_state_on_server_log_event(DialogId dialog_id, bool is_spam_dialog);
 
@@ -3330,8 +3426,18 @@ class MessagesManager final : public Actor {
     }
   };
   std::queue<unique_ptr<PendingGetChannelDifference>> pending_get_channel_differences_;
+  // differences in channels with unread mentions or opened by the user are fetched first
+  std::queue<unique_ptr<PendingGetChannelDifference>> prioritized_pending_get_channel_differences_;
   int32 get_channel_difference_count_ = 0;
 
+  int32 channel_difference_catch_up_total_count_ = 0;
+  int32 channel_difference_catch_up_finished_count_ = 0;
+  bool is_channel_difference_catch_up_progress_sent_ = false;
+
+  int32 updates_batch_depth_ = 0;
+  vector<DialogId> batched_last_message_dialog_ids_;
+  FlatHashSet<DialogId, DialogIdHash> batched_last_message_dialog_id_set_;
+
   FlatHashMap<DialogId, string, DialogIdHash> active_get_channel_differences_;
   FlatHashMap<DialogId, uint64, DialogIdHash> get_channel_difference_to_log_event_id_;
   FlatHashMap<DialogId, int32, DialogIdHash> channel_get_difference_retry_timeouts_;
@@ -3348,6 +3454,12 @@ class MessagesManager final : public Actor {
   MultiTimeout pending_read_history_timeout_{"PendingReadHistoryTimeout"};
   MultiTimeout pending_updated_dialog_timeout_{"PendingUpdatedDialogTimeout"};
   MultiTimeout pending_unload_dialog_timeout_{"PendingUnloadDialogTimeout"};
+
+  // the total number of messages in all Dialog::messages and the least recently used dialogs first
+  int64 loaded_message_count_ = 0;
+  ListNode dialog_message_cache_lru_list_;
+  bool is_message_cache_reduce_scheduled_ = false;
+  int64 min_message_count_to_reduce_cache_ = 0;
   MultiTimeout dialog_unmute_timeout_{"DialogUnmuteTimeout"};
   MultiTimeout pending_send_dialog_action_timeout_{"PendingSendDialogActionTimeout"};
   MultiTimeout preload_folder_dialog_list_timeout_{"PreloadFolderDialogListTimeout"};
@@ -3452,6 +3564,7 @@ class MessagesManager final : public Actor {
 
   struct ReactionsToReload {
     FlatHashSet<MessageId, MessageIdHash> message_ids;
+    FlatHashSet<MessageId, MessageIdHash> viewed_message_ids;  // message_ids needed only while the chat is opened
     bool is_request_sent = false;
   };
   FlatHashMap<DialogId, ReactionsToReload, DialogIdHash> being_reloaded_reactions_;
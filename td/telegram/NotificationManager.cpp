@@ -27,6 +27,7 @@
 #include "td/telegram/SecretChatId.h"
 #include "td/telegram/ServerMessageId.h"
 #include "td/telegram/StarManager.h"
+#include "td/telegram/StartupProfiler.h"
 #include "td/telegram/StateManager.h"
 #include "td/telegram/StoryId.h"
 #include "td/telegram/StoryManager.h"
@@ -61,6 +62,7 @@
 #include "td/utils/utf8.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iterator>
 #include <limits>
 
@@ -141,9 +143,13 @@ void NotificationManager::on_flush_pending_notifications_timeout_callback(void *
   auto notification_manager = static_cast<NotificationManager *>(notification_manager_ptr);
   VLOG(notifications) << "Ready to flush pending notifications for notification group " << group_id_int;
   if (group_id_int > 0) {
-    send_closure_later(notification_manager->actor_id(notification_manager),
-                       &NotificationManager::flush_pending_notifications,
-                       NotificationGroupId(narrow_cast<int32>(group_id_int)));
+    // all groups with timeouts expired simultaneously are flushed in one event
+    auto &ready_group_ids = notification_manager->ready_flush_group_ids_;
+    if (ready_group_ids.empty()) {
+      send_closure_later(notification_manager->actor_id(notification_manager),
+                         &NotificationManager::flush_ready_pending_notifications);
+    }
+    ready_group_ids.push_back(NotificationGroupId(narrow_cast<int32>(group_id_int)));
   } else if (group_id_int == 0) {
     send_closure_later(notification_manager->actor_id(notification_manager),
                        &NotificationManager::after_get_difference_impl);
@@ -197,6 +203,7 @@ string NotificationManager::get_is_contact_registered_notifications_synchronized
 }
 
 void NotificationManager::start_up() {
+  StartupProfiler::Phase phase(td_->startup_profiler_.get(), "NotificationManager::start_up");
   init();
 }
 
@@ -936,6 +943,8 @@ void NotificationManager::add_notification(NotificationGroupId group_id, Notific
   auto delay_ms = get_notification_delay_ms(dialog_id, notification, min_delay_ms);
   VLOG(notifications) << "Delay " << notification_id << " for " << delay_ms << " milliseconds";
   auto flush_time = delay_ms * 0.001 + Time::now();
+  // round the flush time up, so notifications from different chats received at once are flushed together
+  flush_time = std::ceil(flush_time * (1000.0 / NOTIFICATION_FLUSH_TICK_MS)) * (NOTIFICATION_FLUSH_TICK_MS * 0.001);
 
   if (group.pending_notifications_flush_time == 0 || flush_time < group.pending_notifications_flush_time) {
     group.pending_notifications_flush_time = flush_time;
@@ -1627,6 +1636,25 @@ void NotificationManager::flush_pending_notifications(NotificationGroupId group_
   }
 }
 
+void NotificationManager::flush_ready_pending_notifications() {
+  auto ready_group_ids = std::move(ready_flush_group_ids_);
+  reset_to_empty(ready_flush_group_ids_);
+
+  std::multimap<int32, NotificationGroupId> group_ids;
+  for (auto group_id : ready_group_ids) {
+    auto group_it = get_group(group_id);
+    if (group_it != groups_.end() && !group_it->second.pending_notifications.empty()) {
+      group_ids.emplace(group_it->second.pending_notifications.back().date, group_id);
+    }
+  }
+
+  // flush groups in order of last notification date
+  VLOG(notifications) << "Flush ready pending notifications in " << group_ids.size() << " notification groups";
+  for (auto &it : group_ids) {
+    flush_pending_notifications(it.second);
+  }
+}
+
 void NotificationManager::flush_all_pending_notifications() {
   std::multimap<int32, NotificationGroupId> group_ids;
   for (auto &group_it : groups_) {
@@ -149,6 +149,8 @@ class NotificationManager final : public Actor {
 
   static constexpr int32 MIN_NOTIFICATION_DELAY_MS = 1;
 
+  static constexpr int32 NOTIFICATION_FLUSH_TICK_MS = 25;  // flush times are rounded up to be flushed together
+
   static constexpr int32 MIN_UPDATE_DELAY_MS = 50;
   static constexpr int32 MAX_UPDATE_DELAY_MS = 60000;
 
@@ -286,6 +288,8 @@ class NotificationManager final : public Actor {
 
   void flush_pending_notifications(NotificationGroupId group_id);
 
+  void flush_ready_pending_notifications();
+
   void flush_all_pending_notifications();
 
   void on_notification_processed(NotificationId notification_id);
@@ -392,6 +396,7 @@ class NotificationManager final : public Actor {
   FlatHashMap<int32, vector<td_api::object_ptr<td_api::Update>>> pending_updates_;
 
   MultiTimeout flush_pending_notifications_timeout_{"FlushPendingNotificationsTimeout"};
+  vector<NotificationGroupId> ready_flush_group_ids_;  // groups with expired flush timeout
   MultiTimeout flush_pending_updates_timeout_{"FlushPendingUpdatesTimeout"};
 
   vector<NotificationGroupId> call_notification_group_ids_;
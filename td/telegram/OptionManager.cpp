@@ -18,8 +18,10 @@
 #include "td/telegram/Global.h"
 #include "td/telegram/JsonValue.h"
 #include "td/telegram/LanguagePackManager.h"
+#include "td/telegram/net/ConnectionCreator.h"
 #include "td/telegram/net/MtprotoHeader.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
+#include "td/telegram/net/NetRequestStats.h"
 #include "td/telegram/NotificationManager.h"
 #include "td/telegram/PeopleNearbyManager.h"
 #include "td/telegram/ReactionType.h"
@@ -52,6 +54,12 @@
 
 namespace td {
 
+static constexpr int64 CACHED_OPTION_EMPTY = std::numeric_limits<int64>::min();
+static constexpr int64 CACHED_OPTION_UNCACHED = CACHED_OPTION_EMPTY + 1;
+static constexpr int64 CACHED_OPTION_FALSE = CACHED_OPTION_EMPTY + 2;
+static constexpr int64 CACHED_OPTION_TRUE = CACHED_OPTION_EMPTY + 3;
+static constexpr int64 CACHED_OPTION_MAX_SPECIAL_VALUE = CACHED_OPTION_TRUE;
+
 OptionManager::OptionManager(Td *td)
     : td_(td)
     , current_scheduler_id_(Scheduler::instance()->sched_id())
@@ -155,6 +163,13 @@ OptionManager::OptionManager(Td *td)
   set_default_integer_option("story_link_area_count_max", 3);
   set_default_integer_option("paid_media_message_star_count_max", 10000);
 
+  for (size_t i = 0; i < CACHED_OPTION_COUNT; i++) {
+    cached_options_[i].store(CACHED_OPTION_EMPTY, std::memory_order_relaxed);
+  }
+  for (auto &name : get_cached_options()) {
+    update_cached_option(name, options.get(name.str()));
+  }
+
   if (options.isset("my_phone_number") || !options.isset("my_id")) {
     update_premium_options();
   }
@@ -256,6 +271,17 @@ bool OptionManager::have_option(Slice name) const {
 }
 
 bool OptionManager::get_option_boolean(Slice name, bool default_value) const {
+  auto cached_option_index = get_cached_option_index(name);
+  if (cached_option_index >= 0) {
+    auto cached_value = cached_options_[cached_option_index].load(std::memory_order_relaxed);
+    if (cached_value == CACHED_OPTION_EMPTY) {
+      return default_value;
+    }
+    if (cached_value == CACHED_OPTION_TRUE || cached_value == CACHED_OPTION_FALSE) {
+      return cached_value == CACHED_OPTION_TRUE;
+    }
+  }
+
   auto value = get_option(name);
   if (value.empty()) {
     return default_value;
@@ -271,6 +297,17 @@ bool OptionManager::get_option_boolean(Slice name, bool default_value) const {
 }
 
 int64 OptionManager::get_option_integer(Slice name, int64 default_value) const {
+  auto cached_option_index = get_cached_option_index(name);
+  if (cached_option_index >= 0) {
+    auto cached_value = cached_options_[cached_option_index].load(std::memory_order_relaxed);
+    if (cached_value == CACHED_OPTION_EMPTY) {
+      return default_value;
+    }
+    if (cached_value > CACHED_OPTION_MAX_SPECIAL_VALUE) {
+      return cached_value;
+    }
+  }
+
   auto value = get_option(name);
   if (value.empty()) {
     return default_value;
@@ -308,6 +345,7 @@ void OptionManager::set_option(Slice name, Slice value) {
     }
     option_pmc_->set(name.str(), value.str());
   }
+  update_cached_option(name, value);
 
   if (!G()->close_flag() && is_td_inited_) {
     on_option_updated(name);
@@ -328,6 +366,58 @@ string OptionManager::get_option(Slice name) const {
   return options_->get(name.str());
 }
 
+const vector<Slice> &OptionManager::get_cached_options() {
+  static const vector<Slice> cached_options{"expect_blocking",
+                                            "is_premium",
+                                            "prefetch_download_share",
+                                            "sequence_max_active_chain_query_count",
+                                            "sequence_max_active_query_count",
+                                            "session_count",
+                                            "session_max_inflight_query_count",
+                                            "test_flood_wait",
+                                            "use_adaptive_download_limit",
+                                            "use_async_file_writes",
+                                            "use_pfs"};
+  CHECK(cached_options.size() == CACHED_OPTION_COUNT);
+  return cached_options;
+}
+
+int32 OptionManager::get_cached_option_index(Slice name) {
+  const auto &cached_options = get_cached_options();
+  for (size_t i = 0; i < cached_options.size(); i++) {
+    if (cached_options[i] == name) {
+      return static_cast<int32>(i);
+    }
+  }
+  return -1;
+}
+
+int64 OptionManager::get_cached_option_value(Slice value) {
+  if (value.empty()) {
+    return CACHED_OPTION_EMPTY;
+  }
+  if (value == "Btrue") {
+    return CACHED_OPTION_TRUE;
+  }
+  if (value == "Bfalse") {
+    return CACHED_OPTION_FALSE;
+  }
+  if (value[0] == 'I') {
+    auto r_integer = to_integer_safe<int64>(value.substr(1));
+    if (r_integer.is_ok() && r_integer.ok() > CACHED_OPTION_MAX_SPECIAL_VALUE) {
+      return r_integer.ok();
+    }
+  }
+  return CACHED_OPTION_UNCACHED;
+}
+
+void OptionManager::update_cached_option(Slice name, Slice value) {
+  auto cached_option_index = get_cached_option_index(name);
+  if (cached_option_index >= 0) {
+    cached_options_[cached_option_index].store(get_cached_option_value(value), std::memory_order_relaxed);
+  }
+}
+
 td_api::object_ptr<td_api::OptionValue> OptionManager::get_unix_time_option_value_object() {
   return td_api::make_object<td_api::optionValueInteger>(G()->unix_time());
 }
@@ -499,6 +589,9 @@ void OptionManager::on_option_updated(Slice name) {
       if (name == "base_language_pack_version") {
         send_closure(td_->language_pack_manager_, &LanguagePackManager::on_language_pack_version_changed, true, -1);
       }
+      if (name == "binlog_sync_delay_ms") {
+        G()->td_db()->update_binlog_sync_options();
+      }
       break;
     case 'c':
       if (name == "connection_parameters") {
@@ -574,6 +667,13 @@ void OptionManager::on_option_updated(Slice name) {
       }
       break;
     case 'm':
+      if (name == "message_database_channel_max_age" || name == "message_database_group_max_age" ||
+          name == "message_database_max_size" || name == "message_database_private_chat_max_age") {
+        G()->td_db()->update_message_retention_policy();
+      }
+      if (name == "message_fts_automerge") {
+        G()->td_db()->update_message_fts_options();
+      }
       if (name == "my_phone_number") {
         send_closure(G()->config_manager(), &ConfigManager::reget_config, Promise<Unit>());
       }
@@ -607,6 +707,11 @@ void OptionManager::on_option_updated(Slice name) {
         send_closure(td_->notification_manager_actor_, &NotificationManager::on_online_cloud_timeout_changed);
       }
       break;
+    case 'p':
+      if (name == "proxy_auto_select") {
+        send_closure(G()->connection_creator(), &ConnectionCreator::on_proxy_auto_select_changed);
+      }
+      break;
     case 'r':
       if (name == "rating_e_decay") {
         send_closure(td_->top_dialog_manager_actor_, &TopDialogManager::update_rating_e_decay);
@@ -622,14 +727,50 @@ void OptionManager::on_option_updated(Slice name) {
       if (name == "session_count") {
         G()->net_query_dispatcher().update_session_count();
       }
+      if (name == "sequence_max_active_chain_query_count" || name == "sequence_max_active_query_count") {
+        G()->net_query_dispatcher().update_sequence_dispatcher_limits();
+      }
+      if (name == "sqlite_pmc_max_pending_writes" || name == "sqlite_pmc_write_delay_ms") {
+        G()->td_db()->update_sqlite_pmc_write_batch_options();
+      }
       break;
     case 'u':
+      if (name == "use_binlog_data_sync") {
+        G()->td_db()->update_binlog_sync_options();
+      }
+      if (name == "use_continuous_file_gc") {
+        send_closure(td_->storage_manager_, &StorageManager::update_use_continuous_file_gc);
+      }
+      if (name == "use_deferred_message_fts_indexing") {
+        G()->td_db()->update_message_fts_options();
+      }
+      if (name == "use_file_stats_index") {
+        send_closure(td_->storage_manager_, &StorageManager::update_use_file_stats_index);
+      }
+      if (name == "use_flood_wait_pacing") {
+        G()->net_query_dispatcher().update_use_flood_wait_pacing();
+      }
+      if (name == "use_message_database_compression") {
+        G()->td_db()->update_message_data_compression_options();
+      }
+      if (name == "use_network_query_deduplication") {
+        G()->net_query_dispatcher().update_use_network_query_deduplication();
+      }
+      if (name == "use_network_request_statistics") {
+        auto request_stats = G()->get_net_request_stats();
+        if (request_stats != nullptr) {
+          request_stats->set_enabled(G()->get_option_boolean(name));
+        }
+      }
       if (name == "use_pfs") {
         G()->net_query_dispatcher().update_use_pfs();
       }
       if (name == "use_storage_optimizer") {
         send_closure(td_->storage_manager_, &StorageManager::update_use_storage_optimizer);
       }
+      if (name == "use_update_coalescing") {
+        td_->update_use_update_coalescing();
+      }
       if (name == "utc_time_offset") {
         if (G()->mtproto_header().set_tz_offset(static_cast<int32>(get_option_integer(name)))) {
           G()->net_query_dispatcher().update_mtproto_header();
@@ -802,7 +943,15 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       }
       */
       break;
+    case 'b':
+      if (set_integer_option("binlog_sync_delay_ms", 0, 1000)) {
+        return;
+      }
+      break;
     case 'c':
+      if (set_integer_option("channel_difference_concurrent_query_count_max", 1, 100)) {
+        return;
+      }
       if (!is_bot && set_string_option("connection_parameters", [](Slice value) {
             string value_copy = value.str();
             auto r_json_value = get_json_value(value_copy);
@@ -815,6 +964,9 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       }
       break;
     case 'd':
+      if (set_integer_option("database_warm_up_chat_count", 0, 100)) {
+        return;
+      }
       if (!is_bot && set_boolean_option("disable_animated_emoji")) {
         return;
       }
@@ -830,6 +982,9 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       if (!is_bot && set_boolean_option("disable_sent_scheduled_message_notifications")) {
         return;
       }
+      if (set_boolean_option("disable_sqlite_secure_delete")) {
+        return;
+      }
       if (set_boolean_option("disable_time_adjustment_protection")) {
         return;
       }
@@ -896,6 +1051,27 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       }
       break;
     case 'm':
+      if (set_integer_option("message_cache_max_size", 0, std::numeric_limits<int64>::max())) {
+        return;
+      }
+      if (set_integer_option("message_database_channel_max_age")) {
+        return;
+      }
+      if (set_integer_option("message_database_group_max_age")) {
+        return;
+      }
+      if (set_integer_option("message_database_max_size", 0, std::numeric_limits<int64>::max())) {
+        return;
+      }
+      if (set_integer_option("message_database_private_chat_max_age")) {
+        return;
+      }
+      if (set_integer_option("message_database_shard_count", 1, 16)) {
+        return;
+      }
+      if (set_integer_option("message_fts_automerge", 0, 16)) {
+        return;
+      }
       if (set_integer_option("message_unload_delay", 60, 86400)) {
         return;
       }
@@ -932,9 +1108,24 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
         send_closure(td_->state_manager_, &StateManager::on_network_updated);
         return;
       }
+      if (set_integer_option("prefetch_download_share", 1, 100)) {
+        return;
+      }
+      if (set_integer_option("prefetch_max_file_size", 0, 1 << 30)) {
+        return;
+      }
+      if (set_integer_option("prefetch_message_count", 0, 100)) {
+        return;
+      }
+      if (set_integer_option("prewarm_connection_count_max", 0, 16)) {
+        return;
+      }
       if (set_boolean_option("process_pinned_messages_as_mentions")) {
         return;
       }
+      if (set_boolean_option("proxy_auto_select")) {
+        return;
+      }
       break;
     case 'r':
       // temporary option
@@ -943,6 +1134,30 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       }
       break;
     case 's':
+      if (set_integer_option("sequence_max_active_chain_query_count", 1, 1000)) {
+        return;
+      }
+      if (set_integer_option("sequence_max_active_query_count", 0, 1000000)) {
+        return;
+      }
+      if (set_integer_option("session_max_inflight_query_count", 1, 16384)) {
+        return;
+      }
+      if (set_string_option("shared_file_cache_directory", [](Slice value) { return true; })) {
+        return;
+      }
+      if (set_integer_option("sqlite_cache_size", 0, 1 << 30)) {
+        return;
+      }
+      if (set_integer_option("sqlite_mmap_size", 0, static_cast<int64>(1) << 40)) {
+        return;
+      }
+      if (set_integer_option("sqlite_pmc_max_pending_writes", 1, 100000)) {
+        return;
+      }
+      if (set_integer_option("sqlite_pmc_write_delay_ms", 0, 1000)) {
+        return;
+      }
       if (set_integer_option("storage_max_files_size")) {
         return;
       }
@@ -965,15 +1180,66 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       }
       break;
     case 'u':
+      if (set_boolean_option("use_adaptive_download_limit")) {
+        return;
+      }
+      if (set_boolean_option("use_async_file_writes")) {
+        return;
+      }
+      if (set_boolean_option("use_binlog_data_sync")) {
+        return;
+      }
+      if (set_boolean_option("use_continuous_file_gc")) {
+        return;
+      }
+      if (set_boolean_option("use_deferred_message_fts_indexing")) {
+        return;
+      }
+      if (set_boolean_option("use_file_stats_index")) {
+        return;
+      }
+      if (set_boolean_option("use_flood_wait_pacing")) {
+        return;
+      }
+      if (set_boolean_option("use_managed_sqlite_checkpoints")) {
+        return;
+      }
+      if (set_boolean_option("use_message_database_compression")) {
+        return;
+      }
+      if (set_boolean_option("use_network_query_deduplication")) {
+        return;
+      }
+      if (set_boolean_option("use_network_request_statistics")) {
+        return;
+      }
       if (set_boolean_option("use_pfs")) {
         return;
       }
+      if (set_boolean_option("use_pipelined_chat_list_loading")) {
+        return;
+      }
       if (set_boolean_option("use_quick_ack")) {
         return;
       }
+      if (set_boolean_option("use_shared_network_config")) {
+        return;
+      }
       if (set_boolean_option("use_storage_optimizer")) {
         return;
       }
+      if (set_boolean_option("use_unencrypted_sqlite_database")) {
+        return;
+      }
+      if (set_boolean_option("use_update_coalescing")) {
+        return;
+      }
+      if (is_bot && set_boolean_option("use_volatile_message_sending")) {
+        return;
+      }
+      if (set_integer_option("user_cache_max_size", 0, 1000000000)) {
+        return;
+      }
       if (set_integer_option("utc_time_offset", -12 * 60 * 60, 14 * 60 * 60)) {
         return;
       }
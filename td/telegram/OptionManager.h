@@ -72,6 +72,14 @@ class OptionManager {
 
   string get_option(Slice name) const;
 
+  static const vector<Slice> &get_cached_options();
+
+  static int32 get_cached_option_index(Slice name);
+
+  static int64 get_cached_option_value(Slice value);
+
+  void update_cached_option(Slice name, Slice value);
+
   static bool is_internal_option(Slice name);
 
   td_api::object_ptr<td_api::Update> get_internal_option_update(Slice name) const;
@@ -93,6 +101,10 @@ class OptionManager {
   std::shared_ptr<KeyValueSyncInterface> option_pmc_;
 
   std::atomic<double> last_sent_server_time_difference_{1e100};
+
+  // values of options which are often read from other threads, kept to avoid locking and parsing on each access
+  static constexpr size_t CACHED_OPTION_COUNT = 11;
+  std::atomic<int64> cached_options_[CACHED_OPTION_COUNT];
 };
 
 }  // namespace td
@@ -62,6 +62,7 @@ class SecretImpl {
 SecretChatActor::SecretChatActor(int32 id, unique_ptr<Context> context, bool can_be_empty)
     : context_(std::move(context)), can_be_empty_(can_be_empty) {
   auth_state_.id = id;
+  crypto_scheduler_id_ = context_->get_crypto_scheduler_id();
 }
 
 template <class T>
@@ -161,7 +162,84 @@ void SecretChatActor::add_inbound_message(unique_ptr<log_event::InboundSecretMes
     LOG(ERROR) << "Ignore unexpected update: " << tag("message", *message);
     return;
   }
-  check_status(do_inbound_message_encrypted(std::move(message)));
+
+  if (crypto_scheduler_id_ < 0) {
+    auto r_decrypted = decrypt(message->encrypted_message);
+    check_status(do_inbound_message_encrypted(std::move(message), std::move(r_decrypted)));
+    loop();
+    return;
+  }
+
+  auto decrypting_id = ++last_decrypting_inbound_message_id_;
+  auto &decrypting_message = decrypting_inbound_messages_[decrypting_id];
+  decrypting_message.message = std::move(message);
+
+  const mtproto::AuthKey *auth_key = nullptr;
+  auto r_auth_key_id = mtproto::Transport::read_auth_key_id(decrypting_message.message->encrypted_message.as_slice());
+  if (r_auth_key_id.is_ok()) {
+    auto auth_key_id = r_auth_key_id.ok();
+    if (auth_key_id == pfs_state_.auth_key.id()) {
+      auth_key = &pfs_state_.auth_key;
+    } else if (auth_key_id == pfs_state_.other_auth_key.id()) {
+      auth_key = &pfs_state_.other_auth_key;
+    }
+  }
+  if (auth_key == nullptr || auth_key->empty()) {
+    // the message will be decrypted synchronously to return the same error or to use new keys
+    decrypting_message.is_ready = true;
+    return process_decrypted_inbound_messages();
+  }
+
+  decrypting_message.auth_key_id = auth_key->id();
+  if (decryptor_.empty()) {
+    decryptor_ = create_actor_on_scheduler<SecretChatDecryptor>("SecretChatDecryptor", crypto_scheduler_id_);
+  }
+  send_closure(decryptor_, &SecretChatDecryptor::decrypt, decrypting_message.message->encrypted_message.copy(),
+               *auth_key, auth_state_.x == 0, config_state_.his_layer >= static_cast<int32>(SecretChatLayer::Mtproto2),
+               PromiseCreator::lambda([actor_id = actor_id(this), decrypting_id](
+                                          Result<std::tuple<uint64, BufferSlice, int32>> r_decrypted) {
+                 send_closure(actor_id, &SecretChatActor::on_inbound_message_decrypted, decrypting_id,
+                              std::move(r_decrypted));
+               }));
+}
+
+void SecretChatActor::on_inbound_message_decrypted(uint64 decrypting_id,
+                                                   Result<std::tuple<uint64, BufferSlice, int32>> r_decrypted) {
+  auto it = decrypting_inbound_messages_.find(decrypting_id);
+  if (it == decrypting_inbound_messages_.end()) {
+    return;
+  }
+  it->second.is_ready = true;
+  it->second.r_decrypted = std::move(r_decrypted);
+  process_decrypted_inbound_messages();
+}
+
+void SecretChatActor::process_decrypted_inbound_messages() {
+  while (!decrypting_inbound_messages_.empty() && decrypting_inbound_messages_.begin()->second.is_ready) {
+    auto decrypting_message = std::move(decrypting_inbound_messages_.begin()->second);
+    decrypting_inbound_messages_.erase(decrypting_inbound_messages_.begin());
+
+    auto message = std::move(decrypting_message.message);
+    SCOPE_EXIT {
+      if (message) {
+        message->promise.set_value(Unit());
+      }
+    };
+    if (close_flag_) {
+      continue;
+    }
+    if (auth_state_.state != State::Ready) {
+      LOG(ERROR) << "Ignore unexpected update: " << tag("message", *message);
+      continue;
+    }
+
+    // previous messages could have changed the keys
+    auto auth_key_id = decrypting_message.auth_key_id;
+    if (auth_key_id == 0 || (auth_key_id != pfs_state_.auth_key.id() && auth_key_id != pfs_state_.other_auth_key.id())) {
+      decrypting_message.r_decrypted = decrypt(message->encrypted_message);
+    }
+    check_status(do_inbound_message_encrypted(std::move(message), std::move(decrypting_message.r_decrypted)));
+  }
   loop();
 }
 
@@ -762,13 +840,20 @@ telegram_api::object_ptr<telegram_api::inputEncryptedChat> SecretChatActor::get_
 }
 void SecretChatActor::tear_down() {
   LOG(INFO) << "SecretChatActor: tear_down";
+  for (auto &it : decrypting_inbound_messages_) {
+    it.second.message->promise.set_value(Unit());
+  }
+  decrypting_inbound_messages_.clear();
   // TODO notify send update that we are dead
 }
 
+void SecretChatDecryptor::decrypt(BufferSlice encrypted_message, mtproto::AuthKey auth_key, bool is_creator,
+                                  bool need_log_errors, Promise<std::tuple<uint64, BufferSlice, int32>> promise) {
+  promise.set_result(SecretChatActor::decrypt_message(encrypted_message, auth_key, is_creator, need_log_errors));
+}
+
 Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt(BufferSlice &encrypted_message) {
-  MutableSlice data = encrypted_message.as_mutable_slice();
-  CHECK(is_aligned_pointer<4>(data.data()));
-  TRY_RESULT(auth_key_id, mtproto::Transport::read_auth_key_id(data));
+  TRY_RESULT(auth_key_id, mtproto::Transport::read_auth_key_id(encrypted_message.as_slice()));
   mtproto::AuthKey *auth_key = nullptr;
   if (auth_key_id == pfs_state_.auth_key.id()) {
     auth_key = &pfs_state_.auth_key;
@@ -779,6 +864,17 @@ Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt(BufferSl
                                      << tag("crc", crc64(encrypted_message.as_slice())));
   }
 
+  return decrypt_message(encrypted_message, *auth_key, auth_state_.x == 0,
+                         config_state_.his_layer >= static_cast<int32>(SecretChatLayer::Mtproto2));
+}
+
+Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt_message(BufferSlice &encrypted_message,
+                                                                                const mtproto::AuthKey &auth_key,
+                                                                                bool is_creator, bool need_log_errors) {
+  MutableSlice data = encrypted_message.as_mutable_slice();
+  CHECK(is_aligned_pointer<4>(data.data()));
+  auto auth_key_id = auth_key.id();
+
   std::array<int, 2> versions{{2, 1}};
   BufferSlice encrypted_message_copy;
   int32 mtproto_version = -1;
@@ -792,10 +888,10 @@ Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt(BufferSl
     packet_info.type = mtproto::PacketInfo::EndToEnd;
     mtproto_version = versions[i];
     packet_info.version = mtproto_version;
-    packet_info.is_creator = auth_state_.x == 0;
-    r_read_result = mtproto::Transport::read(data, *auth_key, &packet_info);
+    packet_info.is_creator = is_creator;
+    r_read_result = mtproto::Transport::read(data, auth_key, &packet_info);
     if (i + 1 != versions.size() && r_read_result.is_error()) {
-      if (config_state_.his_layer >= static_cast<int32>(SecretChatLayer::Mtproto2)) {
+      if (need_log_errors) {
         LOG(WARNING) << tag("mtproto", mtproto_version) << " decryption failed " << r_read_result.error();
       }
       continue;
@@ -826,13 +922,14 @@ Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt(BufferSl
   }
 }
 
-Status SecretChatActor::do_inbound_message_encrypted(unique_ptr<log_event::InboundSecretMessage> message) {
+Status SecretChatActor::do_inbound_message_encrypted(unique_ptr<log_event::InboundSecretMessage> message,
+                                                     Result<std::tuple<uint64, BufferSlice, int32>> r_decrypted) {
   SCOPE_EXIT {
     if (message) {
       message->promise.set_value(Unit());
     }
   };
-  TRY_RESULT(decrypted, decrypt(message->encrypted_message));
+  TRY_RESULT(decrypted, std::move(r_decrypted));
   auto auth_key_id = std::get<0>(decrypted);
   auto data_buffer = std::move(std::get<1>(decrypted));
   auto mtproto_version = std::get<2>(decrypted);
@@ -49,6 +49,13 @@ namespace td {
 class BinlogInterface;
 class NetQueryCreator;
 
+// decrypts inbound secret chat messages outside of SecretChatActor
+class SecretChatDecryptor final : public Actor {
+ public:
+  void decrypt(BufferSlice encrypted_message, mtproto::AuthKey auth_key, bool is_creator, bool need_log_errors,
+               Promise<std::tuple<uint64, BufferSlice, int32>> promise);
+};
+
 class SecretChatActor final : public NetQueryCallback {
  public:
   class Context {
@@ -71,6 +78,11 @@ class SecretChatActor final : public NetQueryCallback {
 
     virtual bool close_flag() = 0;
 
+    // returns scheduler for decryption of inbound messages, or -1 if they must be decrypted synchronously
+    virtual int32 get_crypto_scheduler_id() {
+      return -1;
+    }
+
     // We don't want to expose the whole NetQueryDispatcher, MessagesManager and UserManager.
     // So it is more clear which parts of MessagesManager are really used. And it is much easier to create tests.
     virtual void send_net_query(NetQueryPtr query, ActorShared<NetQueryCallback> callback, bool ordered) = 0;
@@ -566,9 +578,30 @@ class SecretChatActor final : public NetQueryCallback {
 
   std::map<int32, unique_ptr<log_event::InboundSecretMessage>> pending_inbound_messages_;
 
+  // inbound messages are decrypted in parallel, but are processed in the order of receiving
+  struct DecryptingInboundMessage {
+    unique_ptr<log_event::InboundSecretMessage> message;
+    uint64 auth_key_id = 0;  // 0 if the message must be decrypted synchronously
+    bool is_ready = false;
+    Result<std::tuple<uint64, BufferSlice, int32>> r_decrypted;
+  };
+  std::map<uint64, DecryptingInboundMessage> decrypting_inbound_messages_;
+  uint64 last_decrypting_inbound_message_id_ = 0;
+  int32 crypto_scheduler_id_ = -1;
+  ActorOwn<SecretChatDecryptor> decryptor_;
+
+  friend class SecretChatDecryptor;
+  static Result<std::tuple<uint64, BufferSlice, int32>> decrypt_message(BufferSlice &encrypted_message,
+                                                                        const mtproto::AuthKey &auth_key,
+                                                                        bool is_creator, bool need_log_errors);
+
   Result<std::tuple<uint64, BufferSlice, int32>> decrypt(BufferSlice &encrypted_message);
 
-  Status do_inbound_message_encrypted(unique_ptr<log_event::InboundSecretMessage> message);
+  void on_inbound_message_decrypted(uint64 decrypting_id, Result<std::tuple<uint64, BufferSlice, int32>> r_decrypted);
+  void process_decrypted_inbound_messages();
+
+  Status do_inbound_message_encrypted(unique_ptr<log_event::InboundSecretMessage> message,
+                                      Result<std::tuple<uint64, BufferSlice, int32>> r_decrypted);
   Status do_inbound_message_decrypted_unchecked(unique_ptr<log_event::InboundSecretMessage> message,
                                                 int32 mtproto_version);
   Status do_inbound_message_decrypted(unique_ptr<log_event::InboundSecretMessage> message);
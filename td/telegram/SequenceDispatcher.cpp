@@ -8,6 +8,7 @@
 
 #include "td/telegram/Global.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
+#include "td/telegram/net/NetQueryStats.h"
 #include "td/telegram/Td.h"
 
 #include "td/actor/PromiseFuture.h"
@@ -297,12 +298,19 @@ class MultiSequenceDispatcherImpl final : public MultiSequenceDispatcher {
     Node node;
     node.net_query = std::move(query);
     node.net_query->debug("Waiting at SequenceDispatcher");
+    node.net_query->start_stage();
     node.net_query_ref = node.net_query.get_weak();
     node.callback = std::move(callback);
     scheduler_.create_task(chain_ids, std::move(node));
     loop();
   }
 
+  void update_limits(int32 max_active_chain_query_count, int32 max_active_query_count) final {
+    scheduler_.set_max_active_tasks_per_chain(static_cast<uint32>(max(max_active_chain_query_count, 1)));
+    scheduler_.set_max_active_tasks(static_cast<size_t>(max(max_active_query_count, 0)));
+    loop();
+  }
+
  private:
   struct Node {
     NetQueryRef net_query_ref;
@@ -449,6 +457,7 @@ class MultiSequenceDispatcherImpl final : public MultiSequenceDispatcher {
 
       query->set_invoke_after(std::move(parents));
       query->last_timeout_ = 0;
+      query->finish_stage(NetQueryStats::Stage::SequenceWait);
       query->debug("dispatch_with_callback");
       G()->net_query_dispatcher().dispatch_with_callback(std::move(query), actor_shared(this, task.task_id));
     }
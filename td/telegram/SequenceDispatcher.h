@@ -94,6 +94,9 @@ class MultiSequenceDispatcherOld final : public SequenceDispatcher::Parent {
 class MultiSequenceDispatcher : public NetQueryCallback {
  public:
   virtual void send(NetQueryPtr query) = 0;
+
+  // max_active_query_count == 0 means that the total number of simultaneously sent queries isn't limited
+  virtual void update_limits(int32 max_active_chain_query_count, int32 max_active_query_count) = 0;
   static ActorOwn<MultiSequenceDispatcher> create(Slice name);
 };
 
@@ -0,0 +1,34 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/SharedServerDataCache.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/Time.h"
+
+namespace td {
+
+std::shared_ptr<const SharedServerDataCache::Value> SharedServerDataCache::get(const string &key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = values_.find(key);
+  if (it == values_.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void SharedServerDataCache::set(const string &key, int64 hash, string data) {
+  CHECK(!key.empty());
+  auto value = std::make_shared<Value>();
+  value->hash_ = hash;
+  value->data_ = std::move(data);
+  value->receive_time_ = Time::now();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  values_[key] = std::move(value);
+}
+
+}  // namespace td
@@ -0,0 +1,39 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+
+#include <memory>
+#include <mutex>
+
+namespace td {
+
+// cache of immutable server data, which doesn't depend on the current user, so it can be reused by all clients
+// sharing the cache instead of being requested by each of them; owned by the client manager and shared with
+// all Td instances it creates; can be used from any thread
+class SharedServerDataCache {
+ public:
+  struct Value {
+    int64 hash_ = 0;
+    string data_;
+    double receive_time_ = 0.0;
+  };
+
+  // returns the last value saved for the key or nullptr if there is none
+  std::shared_ptr<const Value> get(const string &key) const;
+
+  // must be called whenever the data is received from the server or the server confirmed that it isn't modified
+  void set(const string &key, int64 hash, string data);
+
+ private:
+  mutable std::mutex mutex_;
+  FlatHashMap<string, std::shared_ptr<const Value>> values_;
+};
+
+}  // namespace td
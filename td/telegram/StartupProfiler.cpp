@@ -0,0 +1,118 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/StartupProfiler.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/Clocks.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
+
+#include <algorithm>
+
+namespace td {
+
+StartupProfiler::Phase::Phase(StartupProfiler *profiler, Slice name) : profiler_(profiler), name_(name) {
+  if (profiler_ != nullptr && !profiler_->is_finished()) {
+    start_time_ = Time::now();
+    start_cpu_time_ = Clocks::thread_cpu();
+  }
+}
+
+StartupProfiler::Phase::~Phase() {
+  if (profiler_ != nullptr && !profiler_->is_finished()) {
+    profiler_->add_phase(name_, Time::now() - start_time_, Clocks::thread_cpu() - start_cpu_time_);
+  }
+}
+
+StartupProfiler::StartupProfiler() : start_time_(Time::now()) {
+}
+
+void StartupProfiler::add_phase(Slice name, double wall_time, double cpu_time) {
+  if (is_finished_) {
+    return;
+  }
+  PhaseInfo phase;
+  phase.name = name.str();
+  phase.wall_time = wall_time;
+  phase.cpu_time = cpu_time;
+  phases_.push_back(std::move(phase));
+}
+
+void StartupProfiler::add_binlog_event(int32 type, size_t size) {
+  add_binlog_events(type, 1, size);
+}
+
+void StartupProfiler::add_binlog_events(int32 type, size_t count, size_t size) {
+  if (is_finished_) {
+    return;
+  }
+  for (auto &event : binlog_events_) {
+    if (event.type == type) {
+      event.count += count;
+      event.size += size;
+      return;
+    }
+  }
+  BinlogEventInfo event;
+  event.type = type;
+  event.count = count;
+  event.size = size;
+  binlog_events_.push_back(event);
+}
+
+void StartupProfiler::merge(StartupProfiler &&other) {
+  for (auto &phase : other.phases_) {
+    add_phase(phase.name, phase.wall_time, phase.cpu_time);
+  }
+  for (auto &event : other.binlog_events_) {
+    add_binlog_events(event.type, event.count, event.size);
+  }
+  reset_to_empty(other.phases_);
+  reset_to_empty(other.binlog_events_);
+}
+
+void StartupProfiler::finish(Slice reason) {
+  if (is_finished_) {
+    return;
+  }
+  auto total_time = Time::now() - start_time_;
+  auto summary = get_summary();
+  if (total_time >= 1.0) {
+    LOG(WARNING) << "Finished initialization in " << format::as_time(total_time) << " after " << reason << ":\n"
+                 << summary;
+  } else {
+    LOG(INFO) << "Finished initialization in " << format::as_time(total_time) << " after " << reason << ":\n"
+              << summary;
+  }
+  is_finished_ = true;
+  reset_to_empty(phases_);
+  reset_to_empty(binlog_events_);
+}
+
+string StartupProfiler::get_summary() const {
+  auto sorted_binlog_events = binlog_events_;
+  std::sort(sorted_binlog_events.begin(), sorted_binlog_events.end(),
+            [](const BinlogEventInfo &lhs, const BinlogEventInfo &rhs) { return lhs.size > rhs.size; });
+
+  StringBuilder sb(MutableSlice(), true);
+  for (auto &phase : phases_) {
+    sb << phase.name << ": " << format::as_time(phase.wall_time) << " wall";
+    if (phase.cpu_time >= 0.0) {
+      sb << ", " << format::as_time(phase.cpu_time) << " CPU";
+    }
+    sb << '\n';
+  }
+  for (auto &event : sorted_binlog_events) {
+    sb << "Binlog events of type " << event.type << ": " << event.count << " with total size "
+       << format::as_size(event.size) << '\n';
+  }
+  return sb.as_cslice().str();
+}
+
+}  // namespace td
@@ -0,0 +1,73 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+namespace td {
+
+// collects wall and CPU time of TDLib initialization phases and logs a summary after the initialization is finished
+class StartupProfiler {
+ public:
+  // measures time from its creation till its destruction; does nothing if the profiler is null or finished
+  // the name must be a string literal
+  class Phase {
+   public:
+    Phase(StartupProfiler *profiler, Slice name);
+    Phase(const Phase &) = delete;
+    Phase &operator=(const Phase &) = delete;
+    Phase(Phase &&) = delete;
+    Phase &operator=(Phase &&) = delete;
+    ~Phase();
+
+   private:
+    StartupProfiler *profiler_;
+    Slice name_;
+    double start_time_ = 0.0;
+    double start_cpu_time_ = 0.0;
+  };
+
+  StartupProfiler();
+
+  // negative cpu_time means that CPU time is unknown, because the phase was executed on multiple threads
+  void add_phase(Slice name, double wall_time, double cpu_time = -1.0);
+
+  void add_binlog_event(int32 type, size_t size);
+
+  void merge(StartupProfiler &&other);
+
+  bool is_finished() const {
+    return is_finished_;
+  }
+
+  void finish(Slice reason);
+
+  string get_summary() const;
+
+ private:
+  struct PhaseInfo {
+    string name;
+    double wall_time = 0.0;
+    double cpu_time = 0.0;
+  };
+  vector<PhaseInfo> phases_;
+
+  struct BinlogEventInfo {
+    int32 type = 0;
+    size_t count = 0;
+    size_t size = 0;
+  };
+  vector<BinlogEventInfo> binlog_events_;
+
+  double start_time_ = 0.0;
+  bool is_finished_ = false;
+
+  void add_binlog_events(int32 type, size_t count, size_t size);
+};
+
+}  // namespace td
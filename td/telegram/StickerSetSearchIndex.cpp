@@ -0,0 +1,87 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/StickerSetSearchIndex.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/FlatHashSet.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+
+#include <algorithm>
+
+namespace td {
+
+template <class MapT>
+static void remove_sticker_set_id(MapT &sticker_set_ids, const string &key, StickerSetId sticker_set_id) {
+  auto it = sticker_set_ids.find(key);
+  CHECK(it != sticker_set_ids.end());
+  bool is_removed = td::remove(it->second, sticker_set_id);
+  CHECK(is_removed);
+  if (it->second.empty()) {
+    sticker_set_ids.erase(it);
+  }
+}
+
+void StickerSetSearchIndex::add_sticker_set(StickerSetId sticker_set_id, vector<string> emojis,
+                                            vector<string> keywords) {
+  CHECK(sticker_set_id.is_valid());
+  remove_sticker_set(sticker_set_id);
+
+  td::remove_if(emojis, [](const string &emoji) { return emoji.empty(); });
+  td::remove_if(keywords, [](const string &keyword) { return keyword.empty(); });
+  td::unique(emojis);
+  td::unique(keywords);
+  if (emojis.empty() && keywords.empty()) {
+    return;
+  }
+
+  for (auto &emoji : emojis) {
+    emoji_sticker_set_ids_[emoji].push_back(sticker_set_id);
+  }
+  for (auto &keyword : keywords) {
+    keyword_sticker_set_ids_[keyword].push_back(sticker_set_id);
+  }
+  auto &keys = sticker_set_keys_[sticker_set_id];
+  keys.emojis_ = std::move(emojis);
+  keys.keywords_ = std::move(keywords);
+}
+
+void StickerSetSearchIndex::remove_sticker_set(StickerSetId sticker_set_id) {
+  auto it = sticker_set_keys_.find(sticker_set_id);
+  if (it == sticker_set_keys_.end()) {
+    return;
+  }
+  for (auto &emoji : it->second.emojis_) {
+    remove_sticker_set_id(emoji_sticker_set_ids_, emoji, sticker_set_id);
+  }
+  for (auto &keyword : it->second.keywords_) {
+    remove_sticker_set_id(keyword_sticker_set_ids_, keyword, sticker_set_id);
+  }
+  sticker_set_keys_.erase(it);
+}
+
+vector<StickerSetId> StickerSetSearchIndex::search(const vector<string> &emojis, Slice query) const {
+  FlatHashSet<StickerSetId, StickerSetIdHash> sticker_set_ids;
+  for (auto &emoji : emojis) {
+    if (emoji.empty()) {
+      continue;
+    }
+    auto it = emoji_sticker_set_ids_.find(emoji);
+    if (it != emoji_sticker_set_ids_.end()) {
+      sticker_set_ids.insert(it->second.begin(), it->second.end());
+    }
+  }
+  if (!query.empty()) {
+    for (auto it = keyword_sticker_set_ids_.lower_bound(query.str());
+         it != keyword_sticker_set_ids_.end() && begins_with(it->first, query); ++it) {
+      sticker_set_ids.insert(it->second.begin(), it->second.end());
+    }
+  }
+  return vector<StickerSetId>(sticker_set_ids.begin(), sticker_set_ids.end());
+}
+
+}  // namespace td
@@ -0,0 +1,49 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/StickerSetId.h"
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/Slice.h"
+
+#include <map>
+
+namespace td {
+
+// index from emojis and keywords to sticker sets containing them
+class StickerSetSearchIndex {
+ public:
+  // replaces previously added emojis and keywords of the sticker set
+  void add_sticker_set(StickerSetId sticker_set_id, vector<string> emojis, vector<string> keywords);
+
+  void remove_sticker_set(StickerSetId sticker_set_id);
+
+  // returns sticker sets in an unspecified order, which have one of the emojis or a keyword beginning with the query
+  vector<StickerSetId> search(const vector<string> &emojis, Slice query) const;
+
+  size_t get_emoji_count() const {
+    return emoji_sticker_set_ids_.size();
+  }
+
+  size_t get_keyword_count() const {
+    return keyword_sticker_set_ids_.size();
+  }
+
+ private:
+  struct Keys {
+    vector<string> emojis_;
+    vector<string> keywords_;
+  };
+  FlatHashMap<StickerSetId, Keys, StickerSetIdHash> sticker_set_keys_;
+
+  FlatHashMap<string, vector<StickerSetId>> emoji_sticker_set_ids_;
+  std::map<string, vector<StickerSetId>> keyword_sticker_set_ids_;
+};
+
+}  // namespace td
@@ -23,6 +23,7 @@
 #include "td/telegram/LanguagePackManager.h"
 #include "td/telegram/logevent/LogEvent.h"
 #include "td/telegram/logevent/LogEventHelper.h"
+#include "td/telegram/MemoryStatistics.h"
 #include "td/telegram/MessagesManager.h"
 #include "td/telegram/misc.h"
 #include "td/telegram/net/DcId.h"
@@ -33,6 +34,8 @@
 #include "td/telegram/QuickReplyManager.h"
 #include "td/telegram/secret_api.h"
 #include "td/telegram/SecretChatLayer.h"
+#include "td/telegram/SharedServerDataCache.h"
+#include "td/telegram/StartupProfiler.h"
 #include "td/telegram/StickersManager.hpp"
 #include "td/telegram/Td.h"
 #include "td/telegram/td_api.h"
@@ -1707,6 +1710,7 @@ StickersManager::~StickersManager() {
 }
 
 void StickersManager::start_up() {
+  StartupProfiler::Phase phase(td_->startup_profiler_.get(), "StickersManager::start_up");
   init();
 }
 
@@ -3996,6 +4000,7 @@ StickerSetId StickersManager::on_get_messages_sticker_set(StickerSetId sticker_s
         LOG(ERROR) << "Receive twice document with ID " << document_id << " in " << get_full_source();
       }
     }
+    update_sticker_set_search_index(s);
   }
 
   update_sticker_set(s, "on_get_messages_sticker_set 2");
@@ -4221,6 +4226,21 @@ void StickersManager::find_sticker_set_stickers(const StickerSet *sticker_set, c
   }
 }
 
+void StickersManager::update_sticker_set_search_index(const StickerSet *sticker_set) {
+  CHECK(sticker_set != nullptr);
+  CHECK(sticker_set->was_loaded_);
+  vector<string> emojis;
+  emojis.reserve(sticker_set->emoji_stickers_map_.size());
+  for (auto &it : sticker_set->emoji_stickers_map_) {
+    emojis.push_back(it.first);
+  }
+  vector<string> keywords;
+  for (auto &it : get_sticker_set_keywords(sticker_set)) {
+    keywords.push_back(it.first);
+  }
+  sticker_set_search_index_.add_sticker_set(sticker_set->id_, std::move(emojis), std::move(keywords));
+}
+
 bool StickersManager::can_find_sticker_by_query(FileId sticker_id, const vector<string> &emojis,
                                                 const string &query) const {
   const Sticker *s = get_sticker(sticker_id);
@@ -4362,10 +4382,15 @@ vector<FileId> StickersManager::get_stickers(StickerType sticker_type, string qu
 
   vector<StickerSetId> sets_to_load;
   bool need_load = false;
+  FlatHashMap<StickerSetId, size_t, StickerSetIdHash> examined_sticker_set_positions;
   for (const auto &sticker_set_id : examined_sticker_set_ids) {
     const StickerSet *sticker_set = get_sticker_set(sticker_set_id);
     CHECK(sticker_set != nullptr);
     CHECK(sticker_set->is_inited_);
+    if (!return_all_installed) {
+      auto position = examined_sticker_set_positions.size();
+      examined_sticker_set_positions.emplace(sticker_set_id, position);
+    }
     if (!sticker_set->is_loaded_) {
       sets_to_load.push_back(sticker_set_id);
       if (!sticker_set->was_loaded_) {
@@ -4465,19 +4490,24 @@ vector<FileId> StickersManager::get_stickers(StickerType sticker_type, string qu
   } else {
     auto prepared_query = utf8_prepare_search_string(query);
     LOG(INFO) << "Search stickers by " << emojis << " and keyword " << prepared_query;
-    vector<const StickerSet *> examined_sticker_sets;
-    for (const auto &sticker_set_id : examined_sticker_set_ids) {
+    // only the sticker sets found in the index are scanned, in the order in which they were examined
+    vector<std::pair<size_t, const StickerSet *>> found_sticker_sets;
+    for (auto sticker_set_id : sticker_set_search_index_.search(emojis, prepared_query)) {
+      auto it = examined_sticker_set_positions.find(sticker_set_id);
+      if (it == examined_sticker_set_positions.end()) {
+        continue;
+      }
       const StickerSet *sticker_set = get_sticker_set(sticker_set_id);
       if (sticker_set == nullptr || !sticker_set->was_loaded_) {
         continue;
       }
-
-      if (!td::contains(examined_sticker_sets, sticker_set)) {
-        examined_sticker_sets.push_back(sticker_set);
-      }
+      found_sticker_sets.emplace_back(it->second, sticker_set);
     }
+    std::sort(found_sticker_sets.begin(), found_sticker_sets.end(),
+              [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
     vector<std::pair<bool, FileId>> partial_results[2][2];
-    for (auto sticker_set : examined_sticker_sets) {
+    for (auto &found_sticker_set : found_sticker_sets) {
+      auto sticker_set = found_sticker_set.second;
       find_sticker_set_stickers(sticker_set, emojis, prepared_query,
                                 partial_results[sticker_set->is_installed_][sticker_set->is_archived_]);
     }
@@ -10178,6 +10208,44 @@ string StickersManager::get_emoji_groups_database_key(EmojiGroupType group_type)
   return PSTRING() << "emojigroup" << static_cast<int32>(group_type);
 }
 
+string StickersManager::get_emoji_groups_shared_cache_key(EmojiGroupType group_type,
+                                                          const string &used_language_codes) {
+  return PSTRING() << get_emoji_groups_database_key(group_type) << (G()->is_test_dc() ? "test" : "") << '$'
+                   << used_language_codes;
+}
+
+bool StickersManager::load_emoji_groups_from_shared_cache(EmojiGroupType group_type,
+                                                          const string &used_language_codes) {
+  auto shared_cache = td_->get_shared_server_data_cache();
+  if (used_language_codes.empty() || shared_cache == nullptr) {
+    return false;
+  }
+  auto value = shared_cache->get(get_emoji_groups_shared_cache_key(group_type, used_language_codes));
+  if (value == nullptr) {
+    return false;
+  }
+
+  EmojiGroupList group_list;
+  if (log_event_parse(group_list, value->data_).is_error() ||
+      group_list.get_used_language_codes() != used_language_codes) {
+    return false;
+  }
+  group_list.set_receive_time(value->receive_time_);
+  if (group_list.is_expired()) {
+    return false;
+  }
+
+  LOG(INFO) << "Use emoji groups of type " << group_type << " received by another client";
+  auto custom_emoji_ids = group_list.get_icon_custom_emoji_ids();
+  get_custom_emoji_stickers_unlimited(
+      std::move(custom_emoji_ids),
+      PromiseCreator::lambda([actor_id = actor_id(this), group_type, group_list = std::move(group_list)](
+                                 Result<td_api::object_ptr<td_api::stickers>> &&result) {
+        send_closure(actor_id, &StickersManager::on_load_emoji_group_icons, group_type, std::move(group_list));
+      }));
+  return true;
+}
+
 void StickersManager::get_emoji_groups(EmojiGroupType group_type,
                                        Promise<td_api::object_ptr<td_api::emojiCategories>> &&promise) {
   auto type = static_cast<int32>(group_type);
@@ -10197,6 +10265,10 @@ void StickersManager::get_emoji_groups(EmojiGroupType group_type,
     return;
   }
 
+  if (load_emoji_groups_from_shared_cache(group_type, used_language_codes)) {
+    return;
+  }
+
   if (G()->use_sqlite_pmc()) {
     G()->td_db()->get_sqlite_pmc()->get(
         get_emoji_groups_database_key(group_type),
@@ -10290,20 +10362,32 @@ void StickersManager::on_get_emoji_groups(
     used_language_codes.clear();
   }
 
+  auto shared_cache = td_->get_shared_server_data_cache();
   auto emoji_groups = r_emoji_groups.move_as_ok();
   switch (emoji_groups->get_id()) {
     case telegram_api::messages_emojiGroupsNotModified::ID:
       if (!used_language_codes.empty()) {
         emoji_group_list_[type].update_next_reload_time();
+        if (emoji_group_list_[type].get_used_language_codes() == used_language_codes && shared_cache != nullptr) {
+          shared_cache->set(get_emoji_groups_shared_cache_key(group_type, used_language_codes),
+                            emoji_group_list_[type].get_hash(),
+                            log_event_store(emoji_group_list_[type]).as_slice().str());
+        }
       }
       break;
     case telegram_api::messages_emojiGroups::ID: {
       auto groups = telegram_api::move_object_as<telegram_api::messages_emojiGroups>(emoji_groups);
       EmojiGroupList group_list = EmojiGroupList(used_language_codes, groups->hash_, std::move(groups->groups_));
 
-      if (!used_language_codes.empty() && G()->use_sqlite_pmc()) {
-        G()->td_db()->get_sqlite_pmc()->set(get_emoji_groups_database_key(group_type),
-                                            log_event_store(group_list).as_slice().str(), Auto());
+      if (!used_language_codes.empty()) {
+        auto group_list_data = log_event_store(group_list).as_slice().str();
+        if (G()->use_sqlite_pmc()) {
+          G()->td_db()->get_sqlite_pmc()->set(get_emoji_groups_database_key(group_type), group_list_data, Auto());
+        }
+        if (shared_cache != nullptr) {
+          shared_cache->set(get_emoji_groups_shared_cache_key(group_type, used_language_codes), groups->hash_,
+                            std::move(group_list_data));
+        }
       }
 
       auto custom_emoji_ids = group_list.get_icon_custom_emoji_ids();
@@ -10326,6 +10410,12 @@ void StickersManager::on_get_emoji_groups(
   }
 }
 
+void StickersManager::memory_stats(MemoryStatistics &statistics) const {
+  Slice manager_name = "StickersManager";
+  statistics.add_hash_map<FileId, Sticker>(manager_name, "sticker", stickers_.calc_size());
+  statistics.add_hash_map<StickerSetId, StickerSet>(manager_name, "sticker_set", sticker_sets_.calc_size());
+}
+
 void StickersManager::get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const {
   if (td_->auth_manager_->is_bot()) {
     return;
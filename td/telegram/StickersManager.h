@@ -23,6 +23,7 @@
 #include "td/telegram/StickerListType.h"
 #include "td/telegram/StickerMaskPosition.h"
 #include "td/telegram/StickerSetId.h"
+#include "td/telegram/StickerSetSearchIndex.h"
 #include "td/telegram/StickerType.h"
 #include "td/telegram/td_api.h"
 #include "td/telegram/telegram_api.h"
@@ -52,6 +53,7 @@
 
 namespace td {
 
+class MemoryStatistics;
 class Td;
 
 class StickersManager final : public Actor {
@@ -438,6 +440,8 @@ class StickersManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void memory_stats(MemoryStatistics &statistics) const;
+
   template <class StorerT>
   void store_sticker_set_id(StickerSetId sticker_set_id, StorerT &storer) const;
 
@@ -931,6 +935,8 @@ class StickersManager final : public Actor {
 
   bool can_find_sticker_by_query(FileId sticker_id, const vector<string> &emojis, const string &query) const;
 
+  void update_sticker_set_search_index(const StickerSet *sticker_set);
+
   static string get_emoji_language_code_version_database_key(const string &language_code);
 
   static string get_emoji_language_code_last_difference_time_database_key(const string &language_code);
@@ -941,6 +947,10 @@ class StickersManager final : public Actor {
 
   static string get_emoji_groups_database_key(EmojiGroupType group_type);
 
+  static string get_emoji_groups_shared_cache_key(EmojiGroupType group_type, const string &used_language_codes);
+
+  bool load_emoji_groups_from_shared_cache(EmojiGroupType group_type, const string &used_language_codes);
+
   int32 get_emoji_language_code_version(const string &language_code);
 
   double get_emoji_language_code_last_difference_time(const string &language_code);
@@ -1003,6 +1013,8 @@ class StickersManager final : public Actor {
   WaitFreeHashMap<string, StickerSetId> short_name_to_sticker_set_id_;
 
   vector<StickerSetId> installed_sticker_set_ids_[MAX_STICKER_TYPE];
+
+  StickerSetSearchIndex sticker_set_search_index_;  // contains all loaded sticker sets
   vector<StickerSetId> featured_sticker_set_ids_[MAX_STICKER_TYPE];
   vector<StickerSetId> old_featured_sticker_set_ids_[MAX_STICKER_TYPE];
   vector<FileId> recent_sticker_ids_[2];
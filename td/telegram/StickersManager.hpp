@@ -452,6 +452,9 @@ void StickersManager::parse_sticker_set(StickerSet *sticker_set, ParserT &parser
         }
       }
     }
+    if (sticker_set->was_loaded_) {
+      update_sticker_set_search_index(sticker_set);
+    }
     if (expires_at > sticker_set->expires_at_) {
       sticker_set->expires_at_ = expires_at;
     }
@@ -40,9 +40,14 @@ void StorageManager::start_up() {
   schedule_next_gc();
 
   load_fast_stat();
+
+  file_stats_index_.init(PSTRING() << G()->get_dir() << "file_stats_index");
+  update_use_file_stats_index();
+  update_use_continuous_file_gc();
 }
 
-void StorageManager::on_new_file(int64 size, int64 real_size, int32 cnt) {
+void StorageManager::on_new_file(int64 size, int64 real_size, int32 cnt, FullLocalFileLocation location,
+                                 DialogId owner_dialog_id) {
   LOG(INFO) << "Add " << cnt << " file of size " << size << " with real size " << real_size
             << " to fast storage statistics";
   fast_stat_.cnt += cnt;
@@ -58,6 +63,22 @@ void StorageManager::on_new_file(int64 size, int64 real_size, int32 cnt) {
     fast_stat_ = FileTypeStat();
   }
   save_fast_stat();
+
+  if (use_file_stats_index_) {
+    if (cnt > 0) {
+      auto now = static_cast<uint64>(Clocks::system() * 1e9);
+      FullFileInfo info;
+      info.file_type = location.file_type_;
+      info.path = std::move(location.path_);
+      info.owner_dialog_id = owner_dialog_id;
+      info.size = add_size;
+      info.atime_nsec = now;
+      info.mtime_nsec = location.mtime_nsec_ != 0 ? location.mtime_nsec_ : now;
+      file_stats_index_.add_file(info);
+    } else if (cnt < 0) {
+      file_stats_index_.remove_file(location.path_);
+    }
+  }
 }
 
 void StorageManager::get_storage_stats(bool need_all_files, int32 dialog_limit, Promise<FileStats> promise) {
@@ -79,14 +100,33 @@ void StorageManager::get_storage_stats(bool need_all_files, int32 dialog_limit,
   stats_need_all_files_ = need_all_files;
   pending_storage_stats_.emplace_back(std::move(promise));
 
+  stats_need_index_reset_ = false;
+  if (can_get_file_stats_from_index()) {
+    LOG(INFO) << "Get storage statistics from the file index";
+    return on_file_stats(file_stats_index_.get_file_stats(need_all_files, dialog_limit != 0), stats_generation_);
+  }
+  // the index is rebuilt from the full list of files found by the scan
+  stats_need_index_reset_ = use_file_stats_index_;
+
+  last_scan_time_ = Time::now();
   create_stats_worker();
-  send_closure(stats_worker_, &FileStatsWorker::get_stats, need_all_files, stats_dialog_limit_ != 0,
+  send_closure(stats_worker_, &FileStatsWorker::get_stats, need_all_files || stats_need_index_reset_,
+               stats_dialog_limit_ != 0,
                PromiseCreator::lambda(
                    [actor_id = actor_id(this), stats_generation = stats_generation_](Result<FileStats> file_stats) {
                      send_closure(actor_id, &StorageManager::on_file_stats, std::move(file_stats), stats_generation);
                    }));
 }
 
+bool StorageManager::can_get_file_stats_from_index() const {
+  if (!use_file_stats_index_) {
+    return false;
+  }
+  auto scan_date = file_stats_index_.get_scan_date();
+  auto now = Clocks::system();
+  return scan_date > now - FILE_STATS_INDEX_RESCAN_DELAY && scan_date <= now;
+}
+
 void StorageManager::get_storage_stats_fast(Promise<FileStatsFast> promise) {
   promise.set_value(FileStatsFast(fast_stat_.size, fast_stat_.cnt, get_database_size(),
                                   get_language_pack_database_size(), get_log_size()));
@@ -106,6 +146,33 @@ void StorageManager::update_use_storage_optimizer() {
   schedule_next_gc();
 }
 
+void StorageManager::update_use_file_stats_index() {
+  auto use_file_stats_index = G()->get_option_boolean("use_file_stats_index");
+  if (use_file_stats_index == use_file_stats_index_) {
+    return;
+  }
+  use_file_stats_index_ = use_file_stats_index;
+  if (use_file_stats_index_) {
+    file_stats_index_.load();
+  } else {
+    file_stats_index_.destroy();
+  }
+}
+
+void StorageManager::update_use_continuous_file_gc() {
+  auto use_continuous_gc = G()->get_option_boolean("use_continuous_file_gc");
+  if (use_continuous_gc == use_continuous_gc_) {
+    return;
+  }
+  use_continuous_gc_ = use_continuous_gc;
+  if (use_continuous_gc_) {
+    schedule_continuous_gc(GC_DELAY);
+  } else {
+    next_continuous_gc_at_ = 0;
+    update_timeout();
+  }
+}
+
 void StorageManager::run_gc(FileGcParameters parameters, bool return_deleted_file_statistics,
                             Promise<FileStats> promise) {
   if (is_closed_) {
@@ -137,8 +204,17 @@ void StorageManager::on_file_stats(Result<FileStats> r_file_stats, uint32 genera
     return;
   }
 
-  update_fast_stats(r_file_stats.ok());
-  send_stats(r_file_stats.move_as_ok(), stats_dialog_limit_, std::move(pending_storage_stats_));
+  auto file_stats = r_file_stats.move_as_ok();
+  if (stats_need_index_reset_) {
+    stats_need_index_reset_ = false;
+    if (use_file_stats_index_) {
+      file_stats_index_.reset(file_stats.get_all_files(), Clocks::system());
+      file_stats = file_stats_index_.get_file_stats(stats_need_all_files_, stats_dialog_limit_ != 0);
+    }
+  }
+
+  update_fast_stats(file_stats);
+  send_stats(std::move(file_stats), stats_dialog_limit_, std::move(pending_storage_stats_));
 }
 
 void StorageManager::create_stats_worker() {
@@ -224,6 +300,12 @@ void StorageManager::on_gc_finished(int32 dialog_limit, Result<FileGcResult> r_f
 
   update_fast_stats(r_file_gc_result.ok().kept_file_stats_);
 
+  if (use_file_stats_index_) {
+    for (auto &info : r_file_gc_result.ok_ref().removed_file_stats_.get_all_files()) {
+      file_stats_index_.remove_file(info.path);
+    }
+  }
+
   auto kept_file_promises = std::move(pending_run_gc_[0]);
   auto removed_file_promises = std::move(pending_run_gc_[1]);
   send_stats(std::move(r_file_gc_result.ok_ref().kept_file_stats_), dialog_limit, std::move(kept_file_promises));
@@ -306,6 +388,7 @@ void StorageManager::hangup() {
   is_closed_ = true;
   close_stats_worker();
   close_gc_worker();
+  file_stats_index_.close();
   hangup_shared();
 }
 
@@ -322,7 +405,7 @@ void StorageManager::save_last_gc_timestamp() {
 void StorageManager::schedule_next_gc() {
   if (!G()->get_option_boolean("use_storage_optimizer")) {
     next_gc_at_ = 0;
-    cancel_timeout();
+    update_timeout();
     LOG(INFO) << "No next file clean up is scheduled";
     return;
   }
@@ -341,18 +424,106 @@ void StorageManager::schedule_next_gc() {
 
   LOG(INFO) << "Schedule next file clean up in " << next_gc_in;
   next_gc_at_ = Time::now() + next_gc_in;
-  set_timeout_at(next_gc_at_);
+  update_timeout();
 }
 
-void StorageManager::timeout_expired() {
-  if (next_gc_at_ == 0) {
+void StorageManager::schedule_continuous_gc(double delay) {
+  if (!use_continuous_gc_ || is_closed_) {
     return;
   }
+  next_continuous_gc_at_ = Time::now() + delay;
+  update_timeout();
+}
+
+// removes a bounded number of the least recently used files to keep the cache below a soft limit,
+// so files are removed gradually instead of in a single big batch
+void StorageManager::run_continuous_gc() {
   if (!pending_run_gc_[0].empty() || !pending_run_gc_[1].empty() || !pending_storage_stats_.empty()) {
-    set_timeout_in(60);
-    return;
+    // give way to other requests
+    return schedule_continuous_gc(CONTINUOUS_GC_IDLE_DELAY);
+  }
+
+  FileGcParameters parameters;
+  parameters.max_files_size_ = parameters.max_files_size_ / 100 * CONTINUOUS_GC_SOFT_LIMIT_PERCENT;
+  parameters.max_file_count_ = parameters.max_file_count_ / 100 * CONTINUOUS_GC_SOFT_LIMIT_PERCENT;
+  parameters.max_removed_file_count_ = CONTINUOUS_GC_MAX_REMOVED_FILE_COUNT;
+
+  // fast statistics are updated on every file change and after every scan, so they are enough to check the limits
+  if (fast_stat_.size <= parameters.max_files_size_ &&
+      static_cast<int64>(fast_stat_.cnt) <= static_cast<int64>(parameters.max_file_count_)) {
+    LOG(DEBUG) << "Skip continuous file clean up with " << fast_stat_.cnt << " files of total size "
+               << fast_stat_.size;
+    return schedule_continuous_gc(CONTINUOUS_GC_IDLE_DELAY);
+  }
+  if (!can_get_file_stats_from_index()) {
+    // the file list can be obtained only by a full scan of the file directories
+    auto next_scan_time = last_scan_time_ + CONTINUOUS_GC_MIN_SCAN_INTERVAL;
+    auto now = Time::now();
+    if (last_scan_time_ != 0 && next_scan_time > now) {
+      return schedule_continuous_gc(next_scan_time - now);
+    }
+  }
+  LOG(INFO) << "Run continuous file clean up with " << parameters;
+  run_gc(std::move(parameters), true,
+         PromiseCreator::lambda([actor_id = actor_id(this)](Result<FileStats> r_removed_file_stats) {
+           send_closure(actor_id, &StorageManager::on_continuous_gc_finished, std::move(r_removed_file_stats));
+         }));
+}
+
+void StorageManager::on_continuous_gc_finished(Result<FileStats> r_removed_file_stats) {
+  if (r_removed_file_stats.is_error()) {
+    if (r_removed_file_stats.error().code() != 500) {
+      LOG(ERROR) << "Continuous file clean up failed: " << r_removed_file_stats.error();
+    }
+    return schedule_continuous_gc(CONTINUOUS_GC_IDLE_DELAY);
+  }
+
+  auto removed_stat = r_removed_file_stats.ok().get_total_nontemp_stat();
+  if (removed_stat.cnt > 0) {
+    continuous_gc_removed_file_count_ += removed_stat.cnt;
+    continuous_gc_removed_files_size_ += removed_stat.size;
+    G()->set_option_integer("continuous_file_gc_removed_file_count", continuous_gc_removed_file_count_);
+    G()->set_option_integer("continuous_file_gc_removed_files_size", continuous_gc_removed_files_size_);
+  }
+  LOG(INFO) << "Continuous file clean up removed " << removed_stat.cnt << " files of total size "
+            << removed_stat.size;
+
+  // continue immediately if the limit on the number of removed files was reached
+  schedule_continuous_gc(static_cast<uint32>(removed_stat.cnt) >= CONTINUOUS_GC_MAX_REMOVED_FILE_COUNT
+                             ? CONTINUOUS_GC_BATCH_DELAY
+                             : CONTINUOUS_GC_IDLE_DELAY);
+}
+
+void StorageManager::update_timeout() {
+  double timeout_at = 0;
+  if (next_gc_at_ != 0) {
+    timeout_at = next_gc_at_;
+  }
+  if (next_continuous_gc_at_ != 0 && (timeout_at == 0 || next_continuous_gc_at_ < timeout_at)) {
+    timeout_at = next_continuous_gc_at_;
+  }
+  if (timeout_at == 0) {
+    cancel_timeout();
+  } else {
+    set_timeout_at(timeout_at);
+  }
+}
+
+void StorageManager::timeout_expired() {
+  auto now = Time::now();
+  if (next_continuous_gc_at_ != 0 && next_continuous_gc_at_ <= now) {
+    next_continuous_gc_at_ = 0;
+    run_continuous_gc();
+  }
+  if (next_gc_at_ == 0 || next_gc_at_ > now) {
+    return update_timeout();
+  }
+  if (!pending_run_gc_[0].empty() || !pending_run_gc_[1].empty() || !pending_storage_stats_.empty()) {
+    next_gc_at_ = now + 60;
+    return update_timeout();
   }
   next_gc_at_ = 0;
+  update_timeout();
   run_gc({}, false, PromiseCreator::lambda([actor_id = actor_id(this)](Result<FileStats> r_stats) {
            if (!r_stats.is_error() || r_stats.error().code() != 500) {
              // do not save garbage collection timestamp if request was canceled
@@ -6,8 +6,11 @@
 //
 #pragma once
 
+#include "td/telegram/DialogId.h"
 #include "td/telegram/files/FileGcWorker.h"
+#include "td/telegram/files/FileLocation.h"
 #include "td/telegram/files/FileStats.h"
+#include "td/telegram/files/FileStatsIndex.h"
 #include "td/telegram/files/FileStatsWorker.h"
 #include "td/telegram/td_api.h"
 
@@ -37,13 +40,21 @@ class StorageManager final : public Actor {
   void get_database_stats(Promise<DatabaseStats> promise);
   void run_gc(FileGcParameters parameters, bool return_deleted_file_statistics, Promise<FileStats> promise);
   void update_use_storage_optimizer();
+  void update_use_file_stats_index();
+  void update_use_continuous_file_gc();
 
-  void on_new_file(int64 size, int64 real_size, int32 cnt);
+  void on_new_file(int64 size, int64 real_size, int32 cnt, FullLocalFileLocation location, DialogId owner_dialog_id);
 
  private:
   static constexpr int GC_EACH = 60 * 60 * 24;  // 1 day
   static constexpr int GC_DELAY = 60;
   static constexpr int GC_RAND_DELAY = 60 * 15;
+  static constexpr double FILE_STATS_INDEX_RESCAN_DELAY = 60 * 60 * 24;  // 1 day
+  static constexpr int32 CONTINUOUS_GC_SOFT_LIMIT_PERCENT = 90;
+  static constexpr uint32 CONTINUOUS_GC_MAX_REMOVED_FILE_COUNT = 100;
+  static constexpr double CONTINUOUS_GC_BATCH_DELAY = 1.0;
+  static constexpr double CONTINUOUS_GC_IDLE_DELAY = 60.0;
+  static constexpr double CONTINUOUS_GC_MIN_SCAN_INTERVAL = 60 * 10;  // 10 minutes
 
   ActorShared<> parent_;
 
@@ -55,12 +66,19 @@ class StorageManager final : public Actor {
   uint32 stats_generation_{0};
   int32 stats_dialog_limit_{0};
   bool stats_need_all_files_{false};
+  bool stats_need_index_reset_{false};
 
   FileTypeStat fast_stat_;
 
+  FileStatsIndex file_stats_index_;
+  bool use_file_stats_index_{false};
+
   CancellationTokenSource stats_cancellation_token_source_;
   CancellationTokenSource gc_cancellation_token_source_;
 
+  double last_scan_time_ = 0;
+
+  bool can_get_file_stats_from_index() const;
   void on_file_stats(Result<FileStats> r_file_stats, uint32 generation);
   void create_stats_worker();
   void update_fast_stats(const FileStats &stats);
@@ -99,6 +117,18 @@ class StorageManager final : public Actor {
   void save_last_gc_timestamp();
   void schedule_next_gc();
 
+  // Continuous GC
+  bool use_continuous_gc_ = false;
+  double next_continuous_gc_at_ = 0;
+  int64 continuous_gc_removed_file_count_ = 0;
+  int64 continuous_gc_removed_files_size_ = 0;
+
+  void schedule_continuous_gc(double delay);
+  void run_continuous_gc();
+  void on_continuous_gc_finished(Result<FileStats> r_removed_file_stats);
+
+  void update_timeout();
+
   void timeout_expired() final;
 };
 
@@ -29,6 +29,7 @@
 #include "td/telegram/ReactionManager.h"
 #include "td/telegram/ReactionType.hpp"
 #include "td/telegram/ReportReason.h"
+#include "td/telegram/StartupProfiler.h"
 #include "td/telegram/StoryContent.h"
 #include "td/telegram/StoryContentType.h"
 #include "td/telegram/StoryForwardInfo.h"
@@ -1538,6 +1539,7 @@ StoryManager::~StoryManager() {
 }
 
 void StoryManager::start_up() {
+  StartupProfiler::Phase phase(td_->startup_profiler_.get(), "StoryManager::start_up");
   if (!td_->auth_manager_->is_authorized()) {
     return;
   }
@@ -4391,16 +4393,46 @@ void StoryManager::send_update_chat_active_stories(DialogId owner_dialog_id, con
 }
 
 void StoryManager::save_active_stories(DialogId owner_dialog_id, const ActiveStories *active_stories,
-                                       Promise<Unit> &&promise, const char *source) const {
+                                       Promise<Unit> &&promise, const char *source) {
   if (!G()->use_message_database()) {
     return promise.set_value(Unit());
   }
+  CHECK(active_stories == get_active_stories(owner_dialog_id));
+  LOG(INFO) << "Schedule save of active stories of " << owner_dialog_id << " to database from " << source;
+
+  // all changes of active stories of the dialog done before the flush are saved by a single write
+  pending_active_stories_saves_[owner_dialog_id].push_back(std::move(promise));
+  if (!is_active_stories_save_flush_scheduled_) {
+    is_active_stories_save_flush_scheduled_ = true;
+    send_closure_later(actor_id(this), &StoryManager::flush_pending_active_stories_saves);
+  }
+}
+
+void StoryManager::flush_pending_active_stories_saves() {
+  is_active_stories_save_flush_scheduled_ = false;
+  auto pending_saves = std::move(pending_active_stories_saves_);
+  pending_active_stories_saves_.clear();
+  for (auto &it : pending_saves) {
+    auto owner_dialog_id = it.first;
+    auto promise = PromiseCreator::lambda([promises = std::move(it.second)](Result<Unit> result) mutable {
+      if (result.is_ok()) {
+        set_promises(promises);
+      } else {
+        fail_promises(promises, result.move_as_error());
+      }
+    });
+    do_save_active_stories(owner_dialog_id, get_active_stories(owner_dialog_id), std::move(promise));
+  }
+}
+
+void StoryManager::do_save_active_stories(DialogId owner_dialog_id, const ActiveStories *active_stories,
+                                          Promise<Unit> &&promise) const {
   if (active_stories == nullptr) {
-    LOG(INFO) << "Delete active stories of " << owner_dialog_id << " from database from " << source;
+    LOG(INFO) << "Delete active stories of " << owner_dialog_id << " from database";
     G()->td_db()->get_story_db_async()->delete_active_stories(owner_dialog_id, std::move(promise));
   } else {
     LOG(INFO) << "Add " << active_stories->story_ids_.size() << " active stories of " << owner_dialog_id
-              << " to database from " << source;
+              << " to database";
     auto order = active_stories->story_list_id_.is_valid() ? active_stories->private_order_ : 0;
     SavedActiveStories saved_active_stories;
     saved_active_stories.max_read_story_id_ = active_stories->max_read_story_id_;
@@ -597,7 +597,12 @@ class StoryManager final : public Actor {
                                        const char *source);
 
   void save_active_stories(DialogId owner_dialog_id, const ActiveStories *active_stories, Promise<Unit> &&promise,
-                           const char *source) const;
+                           const char *source);
+
+  void flush_pending_active_stories_saves();
+
+  void do_save_active_stories(DialogId owner_dialog_id, const ActiveStories *active_stories,
+                              Promise<Unit> &&promise) const;
 
   void increment_story_views(DialogId owner_dialog_id, PendingStoryViews &story_views);
 
@@ -677,6 +682,9 @@ class StoryManager final : public Actor {
 
   WaitFreeHashSet<DialogId, DialogIdHash> failed_to_load_active_stories_;
 
+  FlatHashMap<DialogId, vector<Promise<Unit>>, DialogIdHash> pending_active_stories_saves_;
+  bool is_active_stories_save_flush_scheduled_ = false;
+
   FlatHashMap<DialogId, uint64, DialogIdHash> load_expiring_stories_log_event_ids_;
 
   FlatHashMap<StoryFullId, unique_ptr<BeingEditedStory>, StoryFullIdHash> being_edited_stories_;
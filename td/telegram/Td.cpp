@@ -86,6 +86,7 @@
 #include "td/telegram/LinkManager.h"
 #include "td/telegram/Location.h"
 #include "td/telegram/Logging.h"
+#include "td/telegram/MemoryStatistics.h"
 #include "td/telegram/MessageCopyOptions.h"
 #include "td/telegram/MessageEffectId.h"
 #include "td/telegram/MessageEntity.h"
@@ -107,6 +108,8 @@
 #include "td/telegram/net/NetQuery.h"
 #include "td/telegram/net/NetQueryDelayer.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
+#include "td/telegram/net/NetQueryStats.h"
+#include "td/telegram/net/NetRequestStats.h"
 #include "td/telegram/net/NetStatsManager.h"
 #include "td/telegram/net/NetType.h"
 #include "td/telegram/net/Proxy.h"
@@ -144,6 +147,7 @@
 #include "td/telegram/SentEmailCode.h"
 #include "td/telegram/SponsoredMessageManager.h"
 #include "td/telegram/StarManager.h"
+#include "td/telegram/StartupProfiler.h"
 #include "td/telegram/StateManager.h"
 #include "td/telegram/StatisticsManager.h"
 #include "td/telegram/StickerFormat.h"
@@ -186,11 +190,15 @@
 #include "td/mtproto/TransportType.h"
 
 #include "td/actor/actor.h"
+#include "td/actor/ActorStatistics.h"
 
 #include "td/utils/algorithm.h"
 #include "td/utils/buffer.h"
+#include "td/utils/CpuProfiler.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/format.h"
+#include "td/utils/HeapProfiler.h"
+#include "td/utils/LockStatistics.h"
 #include "td/utils/MimeType.h"
 #include "td/utils/misc.h"
 #include "td/utils/PathView.h"
@@ -201,9 +209,11 @@
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
+#include "td/utils/Time.h"
 #include "td/utils/Timer.h"
 #include "td/utils/utf8.h"
 
+#include <atomic>
 #include <limits>
 #include <tuple>
 #include <type_traits>
@@ -213,6 +223,8 @@ namespace td {
 int VERBOSITY_NAME(td_init) = VERBOSITY_NAME(DEBUG) + 3;
 int VERBOSITY_NAME(td_requests) = VERBOSITY_NAME(INFO);
 
+static std::atomic<bool> fast_shutdown_enabled{false};
+
 void Td::ResultHandler::set_td(Td *td) {
   CHECK(td_ == nullptr);
   td_ = td;
@@ -2660,6 +2672,15 @@ bool Td::is_synchronous_request(const td_api::Function *function) {
     case td_api::setLogTagVerbosityLevel::ID:
     case td_api::getLogTagVerbosityLevel::ID:
     case td_api::addLogMessage::ID:
+    case td_api::setLogRecordingVerbosityLevel::ID:
+    case td_api::dumpRecordedLogMessages::ID:
+    case td_api::enableActorStatistics::ID:
+    case td_api::getActorStatistics::ID:
+    case td_api::setHeapProfilerSamplingInterval::ID:
+    case td_api::getHeapProfile::ID:
+    case td_api::getLockStatistics::ID:
+    case td_api::setCpuProfilerFrequency::ID:
+    case td_api::getCpuProfile::ID:
     case td_api::testReturnError::ID:
       return true;
     case td_api::getOption::ID:
@@ -2673,6 +2694,7 @@ bool Td::is_preinitialization_request(int32 id) {
   switch (id) {
     case td_api::getCurrentState::ID:
     case td_api::setAlarm::ID:
+    case td_api::setUpdateFilter::ID:
     case td_api::testUseUpdate::ID:
     case td_api::testCallEmpty::ID:
     case td_api::testSquareInt::ID:
@@ -2712,6 +2734,7 @@ bool Td::is_preauthentication_request(int32 id) {
     case td_api::getNetworkStatistics::ID:
     case td_api::addNetworkStatistics::ID:
     case td_api::resetNetworkStatistics::ID:
+    case td_api::getNetworkRequestLatencyStatistics::ID:
     case td_api::setApplicationVerificationToken::ID:
     case td_api::getCountries::ID:
     case td_api::getCountryCode::ID:
@@ -2828,6 +2851,7 @@ void Td::run_request(uint64 id, tl_object_ptr<td_api::Function> function) {
 
           VLOG(td_init) << "Begin to open database";
           set_parameters_request_id_ = id;
+          startup_profiler_ = make_unique<StartupProfiler>();
           can_ignore_background_updates_ = !parameters.second.use_chat_info_database_ &&
                                            !parameters.second.use_message_database_ &&
                                            !parameters.first.use_secret_chats_;
@@ -2839,6 +2863,7 @@ void Td::run_request(uint64 id, tl_object_ptr<td_api::Function> function) {
               });
           auto use_sqlite_pmc = parameters.second.use_message_database_ || parameters.second.use_chat_info_database_ ||
                                 parameters.second.use_file_database_;
+          parameters.second.database_read_scheduler_id_ = G()->get_database_read_scheduler_id();
           return TdDb::open(use_sqlite_pmc ? G()->get_database_scheduler_id() : G()->get_slow_net_scheduler_id(),
                             std::move(parameters.second), std::move(promise));
         }
@@ -2869,9 +2894,18 @@ void Td::run_request(uint64 id, tl_object_ptr<td_api::Function> function) {
       !is_preinitialization_request(function_id) && !is_authentication_request(function_id)) {
     return send_error_impl(id, make_error(401, "Unauthorized"));
   }
+  CpuProfiler::Label label("td_api request", function_id);
   downcast_call(*function, [this, id](auto &request) { this->on_request(id, request); });
 }
 
+void Td::set_fast_shutdown(bool is_enabled) {
+  fast_shutdown_enabled = is_enabled;
+}
+
+bool Td::is_fast_shutdown_enabled() {
+  return fast_shutdown_enabled.load(std::memory_order_relaxed);
+}
+
 td_api::object_ptr<td_api::Object> Td::static_request(td_api::object_ptr<td_api::Function> function) {
   if (function == nullptr) {
     return td_api::make_object<td_api::error>(400, "Request is empty");
@@ -2959,6 +2993,7 @@ void Td::on_result(NetQueryPtr query) {
   auto handler = extract_handler(query->id());
   if (handler != nullptr) {
     CHECK(query->is_ready());
+    CpuProfiler::Label label("telegram_api query", query->tl_constructor());
     if (query->is_ok()) {
       handler->on_result(query->move_as_ok());
     } else {
@@ -3002,6 +3037,9 @@ void Td::start_up() {
   alarm_timeout_.set_callback(on_alarm_timeout_callback);
   alarm_timeout_.set_callback_data(static_cast<void *>(this));
 
+  // a flood of updates from the server must not grow the mailbox without bound while Td is busy
+  set_mailbox_limit(MAILBOX_CAPACITY, MailboxOverflowPolicy::Block);
+
   CHECK(state_ == State::WaitParameters);
   for (auto &update : get_fake_current_state()) {
     send_update(std::move(update));
@@ -3053,8 +3091,15 @@ void Td::dec_actor_refcnt() {
     } else if (close_flag_ == 3) {
       LOG(INFO) << "All actors were closed";
       Timer timer;
-      auto reset_manager = [&timer](auto &manager, Slice name) {
-        manager.reset();
+      // all persistent data has already been saved, so in fast shutdown mode freeing of the memory, which is
+      // going to be returned to the system on process termination anyway, can be skipped
+      bool skip_memory_cleanup = is_fast_shutdown_enabled();
+      auto reset_manager = [&timer, skip_memory_cleanup](auto &manager, Slice name) {
+        if (skip_memory_cleanup) {
+          static_cast<void>(manager.release());
+        } else {
+          manager.reset();
+        }
         LOG(DEBUG) << name << " was cleared" << timer;
       };
       reset_manager(account_manager_, "AccountManager");
@@ -3117,8 +3162,7 @@ void Td::dec_actor_refcnt() {
       reset_manager(web_pages_manager_, "WebPagesManager");
 
       G()->set_option_manager(nullptr);
-      option_manager_.reset();
-      LOG(DEBUG) << "OptionManager was cleared" << timer;
+      reset_manager(option_manager_, "OptionManager");
 
       G()->close_all(destroy_flag_,
                      PromiseCreator::lambda([actor_id = create_reference()](Unit) mutable { actor_id.reset(); }));
@@ -3396,15 +3440,20 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
   CHECK(set_parameters_request_id_ != 0);
   if (r_opened_database.is_error()) {
     LOG(WARNING) << "Failed to open database: " << r_opened_database.error();
+    startup_profiler_ = nullptr;
     send_closure(actor_id(this), &Td::send_error, set_parameters_request_id_, r_opened_database.move_as_error());
     return finish_set_parameters();
   }
   auto events = r_opened_database.move_as_ok();
 
   VLOG(td_init) << "Successfully inited database";
+  if (startup_profiler_ != nullptr) {
+    startup_profiler_->merge(std::move(events.startup_profiler));
+  }
 
   if (state_ == State::Close) {
     LOG(INFO) << "Close asynchronously opened database";
+    startup_profiler_ = nullptr;
     auto database_ptr = events.database.get();
     auto promise = PromiseCreator::lambda([database = std::move(events.database)](Unit) {
       // destroy the database after closing
@@ -3441,6 +3490,9 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
     G()->connection_creator().get_actor_unsafe()->set_net_stats_callback(
         net_stats_manager_ptr->get_common_stats_callback(), net_stats_manager_ptr->get_media_stats_callback());
     G()->set_net_stats_file_callbacks(net_stats_manager_ptr->get_file_stats_callbacks());
+    G()->set_net_request_stats(net_stats_manager_ptr->get_request_stats());
+    net_stats_manager_ptr->get_request_stats()->set_enabled(
+        option_manager_->get_option_boolean("use_network_request_statistics"));
   }
 
   complete_pending_preauthentication_requests([](int32 id) {
@@ -3526,11 +3578,17 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
 
   state_ = State::Run;
 
+  if (auth_manager_->is_bot() || !auth_manager_->is_authorized()) {
+    // getChats isn't expected to be called soon
+    send_closure_later(actor_id(this), &Td::finish_startup_profiling, Slice("initialization"));
+  }
+
   send_closure(actor_id(this), &Td::send_result, set_parameters_request_id_, td_api::make_object<td_api::ok>());
   return finish_set_parameters();
 }
 
 void Td::process_binlog_events(TdDb::OpenedDatabase &&events) {
+  StartupProfiler::Phase phase(startup_profiler_.get(), "Td::process_binlog_events");
   VLOG(td_init) << "Send binlog events";
   for (auto &event : events.user_events) {
     user_manager_->on_binlog_user_event(std::move(event));
@@ -3596,7 +3654,24 @@ void Td::process_binlog_events(TdDb::OpenedDatabase &&events) {
   send_closure(secret_chats_manager_, &SecretChatsManager::binlog_replay_finish);
 }
 
+void Td::on_first_get_chats(double wall_time) {
+  if (startup_profiler_ == nullptr) {
+    return;
+  }
+  startup_profiler_->add_phase("First getChats", wall_time);
+  finish_startup_profiling("first getChats");
+}
+
+void Td::finish_startup_profiling(Slice reason) {
+  if (startup_profiler_ == nullptr) {
+    return;
+  }
+  startup_profiler_->finish(reason);
+  startup_profiler_ = nullptr;
+}
+
 void Td::init_options_and_network() {
+  StartupProfiler::Phase phase(startup_profiler_.get(), "Td::init_options_and_network");
   VLOG(td_init) << "Create StateManager";
   class StateManagerCallback final : public StateManager::Callback {
    public:
@@ -3617,6 +3692,13 @@ void Td::init_options_and_network() {
   VLOG(td_init) << "Create OptionManager";
   option_manager_ = make_unique<OptionManager>(this);
   G()->set_option_manager(option_manager_.get());
+  G()->td_db()->update_binlog_sync_options();
+  G()->td_db()->update_sqlite_pmc_write_batch_options();
+  G()->td_db()->update_message_fts_options();
+  G()->td_db()->update_message_retention_policy();
+  G()->td_db()->update_message_data_compression_options();
+  G()->td_db()->warm_up_database();
+  update_use_update_coalescing();
 
   VLOG(td_init) << "Create ConnectionCreator";
   G()->set_connection_creator(create_actor<ConnectionCreator>("ConnectionCreator", create_reference()));
@@ -3646,6 +3728,7 @@ void Td::init_options_and_network() {
 }
 
 void Td::init_file_manager() {
+  StartupProfiler::Phase phase(startup_profiler_.get(), "Td::init_file_manager");
   VLOG(td_init) << "Create FileManager";
   download_file_callback_ = std::make_shared<DownloadFileCallback>();
   upload_file_callback_ = std::make_shared<UploadFileCallback>();
@@ -3659,11 +3742,16 @@ void Td::init_file_manager() {
       return !td_->auth_manager_->is_bot();
     }
 
-    void on_new_file(int64 size, int64 real_size, int32 cnt) final {
-      send_closure(G()->storage_manager(), &StorageManager::on_new_file, size, real_size, cnt);
+    void on_new_file(int64 size, int64 real_size, int32 cnt, const FullLocalFileLocation &location,
+                     DialogId owner_dialog_id) final {
+      send_closure(G()->storage_manager(), &StorageManager::on_new_file, size, real_size, cnt, location,
+                   owner_dialog_id);
     }
 
     void on_file_updated(FileId file_id) final {
+      if (!td_->is_update_needed(td_api::updateFile::ID)) {
+        return;
+      }
       send_closure(G()->td(), &Td::send_update,
                    make_tl_object<td_api::updateFile>(td_->file_manager_->get_file_object(file_id)));
     }
@@ -3716,6 +3804,7 @@ void Td::init_file_manager() {
 }
 
 void Td::init_non_actor_managers() {
+  StartupProfiler::Phase phase(startup_profiler_.get(), "Td::init_non_actor_managers");
   VLOG(td_init) << "Create Managers";
   audios_manager_ = make_unique<AudiosManager>(this);
   callback_queries_manager_ = make_unique<CallbackQueriesManager>(this);
@@ -3724,6 +3813,7 @@ void Td::init_non_actor_managers() {
 }
 
 void Td::init_managers() {
+  StartupProfiler::Phase phase(startup_profiler_.get(), "Td::init_managers");
   account_manager_ = make_unique<AccountManager>(this, create_reference());
   account_manager_actor_ = register_actor("AccountManager", account_manager_.get());
   G()->set_account_manager(account_manager_actor_.get());
@@ -3870,6 +3960,7 @@ void Td::init_managers() {
 }
 
 void Td::init_pure_actor_managers() {
+  StartupProfiler::Phase phase(startup_profiler_.get(), "Td::init_pure_actor_managers");
   call_manager_ = create_actor<CallManager>("CallManager", create_reference());
   G()->set_call_manager(call_manager_.get());
   cashtag_search_hints_ = create_actor<HashtagHints>("CashtagSearchHints", "cashtag_search", '$', create_reference());
@@ -3891,6 +3982,92 @@ void Td::send_update(tl_object_ptr<td_api::Update> &&object) {
     return;
   }
 
+  if (!is_update_needed(object_id) && object_id != td_api::updateAuthorizationState::ID) {
+    return;
+  }
+
+  if (use_update_coalescing_ && object_id != td_api::updateAuthorizationState::ID) {
+    auto key = get_update_coalescing_key(object.get());
+    if (key != 0) {
+      auto it = pending_update_positions_.find(key);
+      if (it != pending_update_positions_.end()) {
+        // the previous update hasn't been sent yet and contains an older state of the same object
+        auto &pending_update = pending_updates_[it->second];
+        CHECK(pending_update != nullptr && pending_update->get_id() == object_id);
+        pending_update = std::move(object);
+        coalesced_update_count_++;
+        return;
+      }
+    } else if (object_id == td_api::updateUserStatus::ID) {
+      // a newer updateUser must not be moved before the status change
+      auto user_id = static_cast<const td_api::updateUserStatus *>(object.get())->user_id_;
+      pending_update_positions_.erase(user_id * 8 + 1);
+    }
+    if (pending_updates_.empty()) {
+      send_closure_later(actor_id(this), &Td::flush_pending_updates);
+    }
+    if (key != 0) {
+      pending_update_positions_.emplace(key, pending_updates_.size());
+    }
+    pending_updates_.push_back(std::move(object));
+    return;
+  }
+
+  flush_pending_updates();
+  do_send_update(std::move(object));
+}
+
+int64 Td::get_update_coalescing_key(const td_api::Update *update) {
+  // the updates contain full state of an object, so they can replace previous updates about the same object
+  switch (update->get_id()) {
+    case td_api::updateUser::ID:
+      return static_cast<const td_api::updateUser *>(update)->user_->id_ * 8 + 1;
+    case td_api::updateBasicGroup::ID:
+      return static_cast<const td_api::updateBasicGroup *>(update)->basic_group_->id_ * 8 + 2;
+    case td_api::updateSupergroup::ID:
+      return static_cast<const td_api::updateSupergroup *>(update)->supergroup_->id_ * 8 + 3;
+    case td_api::updateSecretChat::ID:
+      return static_cast<const td_api::updateSecretChat *>(update)->secret_chat_->id_ * 8 + 4;
+    case td_api::updateUserFullInfo::ID:
+      return static_cast<const td_api::updateUserFullInfo *>(update)->user_id_ * 8 + 5;
+    case td_api::updateBasicGroupFullInfo::ID:
+      return static_cast<const td_api::updateBasicGroupFullInfo *>(update)->basic_group_id_ * 8 + 6;
+    case td_api::updateSupergroupFullInfo::ID:
+      return static_cast<const td_api::updateSupergroupFullInfo *>(update)->supergroup_id_ * 8 + 7;
+    default:
+      return 0;
+  }
+}
+
+void Td::flush_pending_updates() {
+  if (pending_updates_.empty()) {
+    return;
+  }
+  if (coalesced_update_count_ > 0) {
+    VLOG(td_requests) << "Coalesced " << coalesced_update_count_ << " updates before sending "
+                      << pending_updates_.size() << " updates";
+    coalesced_update_count_ = 0;
+  }
+  auto updates = std::move(pending_updates_);
+  pending_updates_.clear();
+  pending_update_positions_.clear();
+  for (auto &update : updates) {
+    if (close_flag_ >= 5) {
+      break;
+    }
+    do_send_update(std::move(update));
+  }
+}
+
+void Td::update_use_update_coalescing() {
+  use_update_coalescing_ = option_manager_->get_option_boolean("use_update_coalescing");
+  if (!use_update_coalescing_) {
+    flush_pending_updates();
+  }
+}
+
+void Td::do_send_update(tl_object_ptr<td_api::Update> &&object) {
+  auto object_id = object->get_id();
   switch (object_id) {
     case td_api::updateAccentColors::ID:
     case td_api::updateChatThemes::ID:
@@ -3926,6 +4103,10 @@ void Td::send_update(tl_object_ptr<td_api::Update> &&object) {
   callback_->on_result(0, std::move(object));
 }
 
+bool Td::is_update_needed(int32 update_id) const {
+  return update_filter_.empty() || update_filter_.count(update_id) != 0;
+}
+
 void Td::send_result(uint64 id, tl_object_ptr<td_api::Object> object) {
   if (id == 0) {
     LOG(ERROR) << "Sending " << to_string(object) << " through send_result";
@@ -3939,6 +4120,7 @@ void Td::send_result(uint64 id, tl_object_ptr<td_api::Object> object) {
     }
     VLOG(td_requests) << "Sending result for request " << id << ": " << to_string(object);
     request_set_.erase(it);
+    flush_pending_updates();  // the result can depend on the pending updates
     callback_->on_result(id, std::move(object));
   }
 }
@@ -3953,6 +4135,7 @@ void Td::send_error_impl(uint64 id, tl_object_ptr<td_api::error> error) {
     }
     VLOG(td_requests) << "Sending error for request " << id << ": " << oneline(to_string(error));
     request_set_.erase(it);
+    flush_pending_updates();
     callback_->on_error(id, std::move(error));
   }
 }
@@ -4798,6 +4981,21 @@ void Td::on_request(uint64 id, td_api::getDatabaseStatistics &request) {
   send_closure(storage_manager_, &StorageManager::get_database_stats, std::move(query_promise));
 }
 
+void Td::on_request(uint64 id, const td_api::getMemoryStatistics &request) {
+  MemoryStatistics statistics;
+  messages_manager_->memory_stats(statistics);
+  user_manager_->memory_stats(statistics);
+  chat_manager_->memory_stats(statistics);
+  stickers_manager_->memory_stats(statistics);
+  file_manager_->memory_stats(statistics);
+  if (td_options_.net_query_stats != nullptr) {
+    auto query_count = static_cast<size_t>(td_options_.net_query_stats->get_count());
+    statistics.add("NetQueryCreator", "net_query", query_count, query_count * sizeof(NetQuery));
+  }
+  statistics.add("BufferAllocator", "buffer", 0, BufferAllocator::get_buffer_mem());
+  send_closure(actor_id(this), &Td::send_result, id, statistics.get_memory_statistics_object());
+}
+
 void Td::on_request(uint64 id, td_api::optimizeStorage &request) {
   std::vector<FileType> file_types;
   for (auto &file_type : request.file_types_) {
@@ -4833,15 +5031,43 @@ void Td::on_request(uint64 id, td_api::getNetworkStatistics &request) {
   CREATE_REQUEST_PROMISE();
   auto query_promise = PromiseCreator::lambda([promise = std::move(promise)](Result<NetworkStats> result) mutable {
     if (result.is_error()) {
-      promise.set_error(result.move_as_error());
-    } else {
-      promise.set_value(result.ok().get_network_statistics_object());
+      return promise.set_error(result.move_as_error());
     }
+    send_closure(
+        G()->connection_creator(), &ConnectionCreator::get_proxy_statistics,
+        PromiseCreator::lambda(
+            [promise = std::move(promise), network_statistics = result.ok().get_network_statistics_object()](
+                Result<vector<td_api::object_ptr<td_api::networkProxyStatistics>>> r_proxy_entries) mutable {
+              if (r_proxy_entries.is_ok()) {
+                network_statistics->proxy_entries_ = r_proxy_entries.move_as_ok();
+              }
+              promise.set_value(std::move(network_statistics));
+            }));
   });
   send_closure(net_stats_manager_, &NetStatsManager::get_network_stats, request.only_current_,
                std::move(query_promise));
 }
 
+void Td::on_request(uint64 id, const td_api::getNetworkRequestLatencyStatistics &request) {
+  if (td_options_.net_query_stats == nullptr) {
+    return send_error_raw(id, 400, "Network statistics are disabled");
+  }
+  auto latencies = td_options_.net_query_stats->get_latency_statistics();
+  string prometheus_text;
+  if (request.return_prometheus_text_) {
+    prometheus_text = NetQueryStats::get_prometheus_latency_statistics(latencies);
+  }
+  auto entries = transform(latencies, [](const NetQueryStats::LatencyInfo &info) {
+    const auto &histogram = info.histogram;
+    return td_api::make_object<td_api::networkRequestLatencyStatisticsEntry>(
+        NetQueryStats::get_stage_name(info.stage).str(), info.tl_constructor, info.dc_id,
+        static_cast<int64>(histogram.get_count()), histogram.get_total(), histogram.get_quantile(0.5),
+        histogram.get_quantile(0.9), histogram.get_quantile(0.99), histogram.get_max());
+  });
+  send_result(id, td_api::make_object<td_api::networkRequestLatencyStatistics>(std::move(entries),
+                                                                                std::move(prometheus_text)));
+}
+
 void Td::on_request(uint64 id, td_api::resetNetworkStatistics &request) {
   if (net_stats_manager_.empty()) {
     return send_error_raw(id, 400, "Network statistics are disabled");
@@ -5005,6 +5231,13 @@ void Td::on_request(uint64 id, const td_api::loadChats &request) {
 void Td::on_request(uint64 id, const td_api::getChats &request) {
   CHECK_IS_USER();
   CREATE_REQUEST_PROMISE();
+  if (startup_profiler_ != nullptr) {
+    promise = PromiseCreator::lambda([actor_id = actor_id(this), start_time = Time::now(), promise = std::move(promise)](
+                                         Result<td_api::object_ptr<td_api::chats>> result) mutable {
+      send_closure(actor_id, &Td::on_first_get_chats, Time::now() - start_time);
+      promise.set_result(std::move(result));
+    });
+  }
   messages_manager_->get_dialogs_from_list(DialogListId(request.chat_list_), request.limit_, std::move(promise));
 }
 
@@ -7548,6 +7781,12 @@ void Td::on_request(uint64 id, const td_api::readFilePart &request) {
                request.count_, 2, std::move(promise));
 }
 
+void Td::on_request(uint64 id, const td_api::getFilePartLocation &request) {
+  CREATE_REQUEST_PROMISE();
+  send_closure(file_manager_actor_, &FileManager::get_file_part_location, FileId(request.file_id_, 0),
+               request.offset_, request.count_, std::move(promise));
+}
+
 void Td::on_request(uint64 id, const td_api::deleteFile &request) {
   CREATE_OK_REQUEST_PROMISE();
   send_closure(file_manager_actor_, &FileManager::delete_file, FileId(request.file_id_, 0), std::move(promise),
@@ -9420,6 +9659,19 @@ void Td::on_request(uint64 id, const td_api::setAlarm &request) {
   alarm_timeout_.set_timeout_in(alarm_id, request.seconds_);
 }
 
+void Td::on_request(uint64 id, td_api::setUpdateFilter &request) {
+  FlatHashSet<int32> update_filter;
+  for (auto &update_type : request.update_types_) {
+    auto update_id = td_api::get_constructor_id(static_cast<const td_api::Update *>(nullptr), update_type);
+    if (update_id == 0) {
+      return send_error_raw(id, 400, PSLICE() << "Unknown update type \"" << update_type << '"');
+    }
+    update_filter.insert(update_id);
+  }
+  update_filter_ = std::move(update_filter);
+  send_closure(actor_id(this), &Td::send_result, id, td_api::make_object<td_api::ok>());
+}
+
 void Td::on_request(uint64 id, td_api::searchHashtags &request) {
   CHECK_IS_USER();
   CLEAN_INPUT_STRING(request.prefix_);
@@ -9801,6 +10053,42 @@ void Td::on_request(uint64 id, const td_api::getLogVerbosityLevel &request) {
   UNREACHABLE();
 }
 
+void Td::on_request(uint64 id, const td_api::setLogRecordingVerbosityLevel &request) {
+  UNREACHABLE();
+}
+
+void Td::on_request(uint64 id, const td_api::dumpRecordedLogMessages &request) {
+  UNREACHABLE();
+}
+
+void Td::on_request(uint64 id, const td_api::enableActorStatistics &request) {
+  UNREACHABLE();
+}
+
+void Td::on_request(uint64 id, const td_api::getActorStatistics &request) {
+  UNREACHABLE();
+}
+
+void Td::on_request(uint64 id, const td_api::setHeapProfilerSamplingInterval &request) {
+  UNREACHABLE();
+}
+
+void Td::on_request(uint64 id, const td_api::getHeapProfile &request) {
+  UNREACHABLE();
+}
+
+void Td::on_request(uint64 id, const td_api::getLockStatistics &request) {
+  UNREACHABLE();
+}
+
+void Td::on_request(uint64 id, const td_api::setCpuProfilerFrequency &request) {
+  UNREACHABLE();
+}
+
+void Td::on_request(uint64 id, const td_api::getCpuProfile &request) {
+  UNREACHABLE();
+}
+
 void Td::on_request(uint64 id, const td_api::getLogTags &request) {
   UNREACHABLE();
 }
@@ -10064,6 +10352,96 @@ td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getLogVer
   return td_api::make_object<td_api::logVerbosityLevel>(Logging::get_verbosity_level());
 }
 
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::setLogRecordingVerbosityLevel &request) {
+  auto result = Logging::set_recording_verbosity_level(static_cast<int>(request.new_verbosity_level_));
+  if (result.is_ok()) {
+    return td_api::make_object<td_api::ok>();
+  } else {
+    return make_error(400, result.message());
+  }
+}
+
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::dumpRecordedLogMessages &request) {
+  Logging::dump_recorded_messages();
+  return td_api::make_object<td_api::ok>();
+}
+
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::enableActorStatistics &request) {
+  if (!(request.slow_event_threshold_ >= 0.0)) {
+    return make_error(400, "Invalid slow event threshold specified");
+  }
+  ActorStatistics::enable(request.slow_event_threshold_);
+  return td_api::make_object<td_api::ok>();
+}
+
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getActorStatistics &request) {
+  auto entries = transform(ActorStatistics::get_statistics(), [](const ActorStatistics::Info &info) {
+    return td_api::make_object<td_api::actorStatisticsEntry>(
+        info.name, static_cast<int64>(info.event_count), info.total_time, info.max_time,
+        narrow_cast<int32>(min(info.max_mailbox_size, static_cast<size_t>(std::numeric_limits<int32>::max()))),
+        static_cast<int64>(info.dropped_event_count), static_cast<int64>(info.coalesced_event_count));
+  });
+  return td_api::make_object<td_api::actorStatistics>(std::move(entries));
+}
+
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::setHeapProfilerSamplingInterval &request) {
+  if (request.sampling_interval_ < 0) {
+    return make_error(400, "Invalid sampling interval specified");
+  }
+  auto status = HeapProfiler::set_sampling_interval(static_cast<size_t>(request.sampling_interval_));
+  if (status.is_error()) {
+    return make_error(400, status.message());
+  }
+  return td_api::make_object<td_api::ok>();
+}
+
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getHeapProfile &request) {
+  if (!HeapProfiler::is_supported()) {
+    return make_error(400, "Heap profiler is unsupported");
+  }
+  auto entries = transform(HeapProfiler::get_statistics(), [](const HeapProfiler::Entry &entry) {
+    return td_api::make_object<td_api::heapProfileEntry>(entry.name, static_cast<int64>(entry.size),
+                                                         static_cast<int64>(entry.allocation_count));
+  });
+  return td_api::make_object<td_api::heapProfile>(std::move(entries), HeapProfiler::get_pprof_profile());
+}
+
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getLockStatistics &request) {
+  if (!LockStatistics::is_enabled()) {
+    return make_error(400, "Lock statistics are unsupported; TDLib must be built with TD_ENABLE_LOCK_STATISTICS");
+  }
+  auto entries = transform(LockStatistics::get_statistics(), [](const LockStatistics::Entry &entry) {
+    return td_api::make_object<td_api::lockStatisticsEntry>(entry.name, static_cast<int64>(entry.lock_count),
+                                                            static_cast<int64>(entry.contention_count),
+                                                            static_cast<int64>(entry.spin_count), entry.wait_time);
+  });
+  return td_api::make_object<td_api::lockStatistics>(std::move(entries));
+}
+
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::setCpuProfilerFrequency &request) {
+  auto status = CpuProfiler::set_frequency(request.frequency_);
+  if (status.is_error()) {
+    return make_error(400, status.message());
+  }
+  return td_api::make_object<td_api::ok>();
+}
+
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getCpuProfile &request) {
+  if (!CpuProfiler::is_supported()) {
+    return make_error(400, "CPU profiler is unsupported on the platform");
+  }
+  auto entries = transform(CpuProfiler::get_statistics(), [](const CpuProfiler::Entry &entry) {
+    string label;
+    if (!entry.label_kind.empty()) {
+      label = PSTRING() << entry.label_kind << " 0x" << format::as_hex(entry.label_id);
+    }
+    return td_api::make_object<td_api::cpuProfileEntry>(entry.actor_name, std::move(label),
+                                                        static_cast<int64>(entry.sample_count));
+  });
+  return td_api::make_object<td_api::cpuProfile>(std::move(entries),
+                                                 static_cast<int64>(CpuProfiler::get_dropped_sample_count()));
+}
+
 td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getLogTags &request) {
   return td_api::make_object<td_api::logTags>(Logging::get_tags());
 }
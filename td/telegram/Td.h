@@ -11,6 +11,7 @@
 #include "td/telegram/net/MtprotoHeader.h"
 #include "td/telegram/net/NetQuery.h"
 #include "td/telegram/net/NetQueryStats.h"
+#include "td/telegram/SharedServerDataCache.h"
 #include "td/telegram/td_api.h"
 #include "td/telegram/TdCallback.h"
 #include "td/telegram/TdDb.h"
@@ -26,6 +27,7 @@
 #include "td/utils/common.h"
 #include "td/utils/Container.h"
 #include "td/utils/FlatHashMap.h"
+#include "td/utils/FlatHashSet.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
@@ -91,6 +93,7 @@ class SecureManager;
 class SecretChatsManager;
 class SponsoredMessageManager;
 class StarManager;
+class StartupProfiler;
 class StateManager;
 class StatisticsManager;
 class StickersManager;
@@ -130,12 +133,18 @@ class Td final : public Actor {
 
   struct Options {
     std::shared_ptr<NetQueryStats> net_query_stats;
+    std::shared_ptr<SharedServerDataCache> shared_server_data_cache;
   };
 
   Td(unique_ptr<TdCallback> callback, Options options);
 
   void request(uint64 id, tl_object_ptr<td_api::Function> function);
 
+  // returns nullptr if server data isn't shared with other clients
+  SharedServerDataCache *get_shared_server_data_cache() const {
+    return td_options_.shared_server_data_cache.get();
+  }
+
   void destroy();
 
   void schedule_get_terms_of_service(int32 expires_in);
@@ -291,6 +300,8 @@ class Td final : public Actor {
   ActorOwn<StateManager> state_manager_;
   ActorOwn<StorageManager> storage_manager_;
 
+  unique_ptr<StartupProfiler> startup_profiler_;  // non-null only during initialization
+
   class ResultHandler : public std::enable_shared_from_this<ResultHandler> {
    public:
     ResultHandler() = default;
@@ -332,8 +343,19 @@ class Td final : public Actor {
 
   void send_update(tl_object_ptr<td_api::Update> &&object);
 
+  // returns false if updates with the given constructor identifier are known to be dropped by the update filter
+  bool is_update_needed(int32 update_id) const;
+
+  void update_use_update_coalescing();
+
   static td_api::object_ptr<td_api::Object> static_request(td_api::object_ptr<td_api::Function> function);
 
+  // if enabled, instances closed after the call save all persistent data, but leave in-memory objects of managers
+  // unfreed; must be enabled only before process termination
+  static void set_fast_shutdown(bool is_enabled);
+
+  static bool is_fast_shutdown_enabled();
+
  private:
   static constexpr int64 ONLINE_ALARM_ID = 0;
   static constexpr int64 PING_SERVER_ALARM_ID = -1;
@@ -341,10 +363,19 @@ class Td final : public Actor {
   static constexpr int64 TERMS_OF_SERVICE_ALARM_ID = -2;
   static constexpr int64 PROMO_DATA_ALARM_ID = -3;
 
+  // network threads, which send received updates and query results to Td, wait while so many events are queued
+  static constexpr size_t MAILBOX_CAPACITY = 10000;
+
   void on_connection_state_changed(ConnectionState new_state);
 
   void run_request(uint64 id, tl_object_ptr<td_api::Function> function);
 
+  static int64 get_update_coalescing_key(const td_api::Update *update);
+
+  void flush_pending_updates();
+
+  void do_send_update(tl_object_ptr<td_api::Update> &&object);
+
   void send_result(uint64 id, tl_object_ptr<td_api::Object> object);
   void send_error(uint64 id, Status error);
   void send_error_impl(uint64 id, tl_object_ptr<td_api::error> error);
@@ -398,6 +429,14 @@ class Td final : public Actor {
   FlatHashMap<int64, uint64> pending_alarms_;
   MultiTimeout alarm_timeout_{"AlarmTimeout"};
 
+  FlatHashSet<int32> update_filter_;  // constructor identifiers of the updates to send; all updates are sent if empty
+
+  // updates sent during the current event; an update can be replaced with a newer update with the full object state
+  bool use_update_coalescing_ = false;
+  vector<tl_object_ptr<td_api::Update>> pending_updates_;
+  FlatHashMap<int64, size_t> pending_update_positions_;  // coalescing key -> position in pending_updates_
+  int32 coalesced_update_count_ = 0;
+
   TermsOfService pending_terms_of_service_;
 
   struct DownloadInfo {
@@ -677,10 +716,14 @@ class Td final : public Actor {
 
   void on_request(uint64 id, td_api::getDatabaseStatistics &request);
 
+  void on_request(uint64 id, const td_api::getMemoryStatistics &request);
+
   void on_request(uint64 id, td_api::optimizeStorage &request);
 
   void on_request(uint64 id, td_api::getNetworkStatistics &request);
 
+  void on_request(uint64 id, const td_api::getNetworkRequestLatencyStatistics &request);
+
   void on_request(uint64 id, td_api::resetNetworkStatistics &request);
 
   void on_request(uint64 id, td_api::addNetworkStatistics &request);
@@ -1347,6 +1390,8 @@ class Td final : public Actor {
 
   void on_request(uint64 id, const td_api::readFilePart &request);
 
+  void on_request(uint64 id, const td_api::getFilePartLocation &request);
+
   void on_request(uint64 id, const td_api::deleteFile &request);
 
   void on_request(uint64 id, const td_api::addFileToDownloads &request);
@@ -1849,6 +1894,8 @@ class Td final : public Actor {
 
   void on_request(uint64 id, const td_api::setAlarm &request);
 
+  void on_request(uint64 id, td_api::setUpdateFilter &request);
+
   void on_request(uint64 id, td_api::searchHashtags &request);
 
   void on_request(uint64 id, td_api::removeRecentHashtag &request);
@@ -1971,6 +2018,24 @@ class Td final : public Actor {
 
   void on_request(uint64 id, const td_api::getLogVerbosityLevel &request);
 
+  void on_request(uint64 id, const td_api::setLogRecordingVerbosityLevel &request);
+
+  void on_request(uint64 id, const td_api::dumpRecordedLogMessages &request);
+
+  void on_request(uint64 id, const td_api::enableActorStatistics &request);
+
+  void on_request(uint64 id, const td_api::getActorStatistics &request);
+
+  void on_request(uint64 id, const td_api::setHeapProfilerSamplingInterval &request);
+
+  void on_request(uint64 id, const td_api::getHeapProfile &request);
+
+  void on_request(uint64 id, const td_api::getLockStatistics &request);
+
+  void on_request(uint64 id, const td_api::setCpuProfilerFrequency &request);
+
+  void on_request(uint64 id, const td_api::getCpuProfile &request);
+
   void on_request(uint64 id, const td_api::getLogTags &request);
 
   void on_request(uint64 id, const td_api::setLogTagVerbosityLevel &request);
@@ -2021,6 +2086,15 @@ class Td final : public Actor {
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getLogStream &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::setLogVerbosityLevel &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getLogVerbosityLevel &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::setLogRecordingVerbosityLevel &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::dumpRecordedLogMessages &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::enableActorStatistics &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getActorStatistics &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::setHeapProfilerSamplingInterval &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getHeapProfile &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getLockStatistics &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::setCpuProfilerFrequency &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getCpuProfile &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getLogTags &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::setLogTagVerbosityLevel &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getLogTagVerbosityLevel &request);
@@ -2051,6 +2125,10 @@ class Td final : public Actor {
 
   void process_binlog_events(TdDb::OpenedDatabase &&events);
 
+  void on_first_get_chats(double wall_time);
+
+  void finish_startup_profiling(Slice reason);
+
   void clear();
 
   void close_impl(bool destroy_flag);
@@ -12,6 +12,7 @@
 #include "td/telegram/Global.h"
 #include "td/telegram/logevent/LogEvent.h"
 #include "td/telegram/MessageDb.h"
+#include "td/telegram/MessagesManager.h"
 #include "td/telegram/MessageThreadDb.h"
 #include "td/telegram/StoryDb.h"
 #include "td/telegram/Td.h"
@@ -25,6 +26,7 @@
 #include "td/db/SqliteKeyValue.h"
 #include "td/db/SqliteKeyValueAsync.h"
 #include "td/db/SqliteKeyValueSafe.h"
+#include "td/db/SqliteWalCheckpointer.h"
 
 #include "td/actor/actor.h"
 #include "td/actor/MultiPromise.h"
@@ -39,8 +41,10 @@
 #include "td/utils/Random.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
 
 #include <algorithm>
+#include <limits>
 
 namespace td {
 
@@ -55,6 +59,26 @@ std::string get_sqlite_path(const TdDb::Parameters &parameters) {
   return parameters.database_directory_ + db_name + ".sqlite";
 }
 
+constexpr int32 MAX_MESSAGE_DB_SHARD_COUNT = 16;
+
+std::string get_message_db_shard_path(const TdDb::Parameters &parameters, int32 shard) {
+  CHECK(shard > 0);
+  const string db_name = "db" + (parameters.is_test_dc_ ? string("_test") : string());
+  return PSTRING() << parameters.database_directory_ << db_name << "_messages_" << shard << ".sqlite";
+}
+
+// the mode is applied immediately only to a new database; existing databases are converted by MessageDb in background,
+// because the conversion requires VACUUM of the whole database
+Status enable_incremental_vacuum(SqliteDb &db) {
+  return db.exec("PRAGMA auto_vacuum=INCREMENTAL");
+}
+
+void destroy_message_db_shards(const TdDb::Parameters &parameters) {
+  for (int32 shard = 1; shard < MAX_MESSAGE_DB_SHARD_COUNT; shard++) {
+    SqliteDb::destroy(get_message_db_shard_path(parameters, shard)).ignore();
+  }
+}
+
 Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_pmc, BinlogKeyValue<Binlog> &config_pmc,
                    TdDb::OpenedDatabase &events, DbKey key) {
   auto r_binlog_stat = stat(path);
@@ -69,6 +93,7 @@ Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_p
   }
 
   auto callback = [&](const BinlogEvent &event) {
+    events.startup_profiler.add_binlog_event(event.type_, event.size_);
     switch (event.type_) {
       case LogEvent::HandlerType::SecretChats:
         events.to_secret_chats_manager.push_back(event.clone());
@@ -289,7 +314,17 @@ void TdDb::do_close(bool destroy_flag, Promise<Unit> on_finished) {
   }
   MultiPromiseActorSafe mpas{"TdDbCloseMultiPromiseActor"};
   mpas.add_promise(PromiseCreator::lambda(
-      [promise = std::move(on_finished), sql_connection = std::move(sql_connection_), destroy_flag](Unit) mutable {
+      [promise = std::move(on_finished), sql_connection = std::move(sql_connection_),
+       shard_connections = std::move(message_db_shard_connections_), destroy_flag](Unit) mutable {
+        for (auto &shard_connection : shard_connections) {
+          LOG_CHECK(shard_connection.unique()) << shard_connection.use_count();
+          if (destroy_flag) {
+            shard_connection->close_and_destroy();
+          } else {
+            shard_connection->close();
+          }
+          shard_connection.reset();
+        }
         if (sql_connection) {
           LOG_CHECK(sql_connection.unique()) << sql_connection.use_count();
           if (destroy_flag) {
@@ -303,6 +338,11 @@ void TdDb::do_close(bool destroy_flag, Promise<Unit> on_finished) {
       }));
   auto lock = mpas.get_promise();
 
+  for (auto &wal_checkpointer : wal_checkpointers_) {
+    wal_checkpointer->close(mpas.get_promise());
+  }
+  wal_checkpointers_.clear();
+
   if (file_db_) {
     file_db_->close(mpas.get_promise());
     file_db_.reset();
@@ -367,17 +407,35 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
 
   was_dialog_db_created_ = false;
 
+  // messages are stored in the previous shards until the database is recreated with the new shard count
+  int32 message_db_shard_count = use_message_database ? message_db_shard_count_ : 1;
+  int32 old_message_db_shard_count = 1;
+  auto old_message_db_shard_count_str = binlog_pmc.get("message_db_shard_count");
+  if (!old_message_db_shard_count_str.empty()) {
+    old_message_db_shard_count = to_integer<int32>(old_message_db_shard_count_str);
+  }
+  bool need_reshard_message_db = use_message_database && old_message_db_shard_count != message_db_shard_count;
+  if (need_reshard_message_db || !use_message_database) {
+    destroy_message_db_shards(parameters);
+  }
+
   if (!use_sqlite) {
     SqliteDb::destroy(sql_database_path).ignore();
     return Status::OK();
   }
 
   TRY_RESULT(db_instance, SqliteDb::change_key(sql_database_path, true, key, old_key));
-  sql_connection_ = std::make_shared<SqliteConnectionSafe>(sql_database_path, key, db_instance.get_cipher_version());
+  sql_connection_ = std::make_shared<SqliteConnectionSafe>(sql_database_path, key, db_instance.get_cipher_version(),
+                                                           use_sqlite_secure_delete_, !use_managed_sqlite_checkpoints_,
+                                                           sqlite_mmap_size_, sqlite_cache_size_,
+                                                           use_sqlite_cell_size_check_);
   sql_connection_->set(std::move(db_instance));
   auto &db = sql_connection_->get();
-  TRY_STATUS(db.exec("PRAGMA journal_mode=WAL"));
-  TRY_STATUS(db.exec("PRAGMA secure_delete=1"));
+  TRY_STATUS(SqliteConnectionSafe::init_connection(db, use_sqlite_secure_delete_, !use_managed_sqlite_checkpoints_,
+                                                   sqlite_mmap_size_, sqlite_cache_size_, use_sqlite_cell_size_check_));
+  if (use_incremental_vacuum_ && use_message_database) {
+    TRY_STATUS(enable_incremental_vacuum(db));
+  }
 
   // Init databases
   // Do initialization once and before everything else to avoid "database is locked" error.
@@ -390,6 +448,14 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
   TRY_RESULT(user_version, db.user_version());
   LOG(INFO) << "Have PRAGMA user_version = " << user_version;
 
+  if (need_reshard_message_db) {
+    // chats contain references to stored messages, so they must be reloaded from the server too
+    LOG(WARNING) << "Change number of message database shards from " << old_message_db_shard_count << " to "
+                 << message_db_shard_count;
+    TRY_STATUS(drop_dialog_db(db, user_version));
+    TRY_STATUS(drop_message_db(db, user_version));
+  }
+
   // init DialogDb
   if (use_dialog_db) {
     TRY_STATUS(init_dialog_db(db, user_version, binlog_pmc, was_dialog_db_created_));
@@ -453,12 +519,40 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
     binlog_pmc.erase("invalidate_old_featured_sticker_sets");
     binlog_pmc.erase(AttachMenuManager::get_attach_menu_bots_database_key());
   }
+  if (message_db_shard_count == 1) {
+    binlog_pmc.erase("message_db_shard_count");
+  } else {
+    binlog_pmc.set("message_db_shard_count", to_string(message_db_shard_count));
+  }
   binlog_pmc.force_sync(Auto(), "init_sqlite");
 
   TRY_STATUS(db.exec("COMMIT TRANSACTION"));
 
+  for (int32 shard = 1; shard < message_db_shard_count; shard++) {
+    TRY_RESULT(shard_connection, init_message_db_shard(get_message_db_shard_path(parameters, shard), key, old_key));
+    message_db_shard_connections_.push_back(std::move(shard_connection));
+  }
+
   file_db_ = create_file_db(sql_connection_);
 
+#if !TD_THREAD_UNSUPPORTED
+  if (use_managed_sqlite_checkpoints_) {
+    // checkpoints are run by dedicated threads using their own connections
+    auto add_wal_checkpointer = [&](const std::shared_ptr<SqliteConnectionSafe> &connection,
+                                    const string &path) -> Status {
+      TRY_RESULT(checkpoint_db, SqliteDb::open_with_key(path, false, key, connection->get().get_cipher_version()));
+      wal_checkpointers_.push_back(
+          create_sqlite_wal_checkpointer(std::move(checkpoint_db), path, 5.0, static_cast<int64>(4) << 20));
+      return Status::OK();
+    };
+    TRY_STATUS(add_wal_checkpointer(sql_connection_, sql_database_path));
+    for (size_t i = 0; i < message_db_shard_connections_.size(); i++) {
+      TRY_STATUS(add_wal_checkpointer(message_db_shard_connections_[i],
+                                      get_message_db_shard_path(parameters, static_cast<int32>(i + 1))));
+    }
+  }
+#endif
+
   common_kv_safe_ = std::make_shared<SqliteKeyValueSafe>("common", sql_connection_);
   common_kv_async_ = create_sqlite_key_value_async(common_kv_safe_);
 
@@ -471,7 +565,7 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
 
   if (use_dialog_db) {
     dialog_db_sync_safe_ = create_dialog_db_sync(sql_connection_);
-    dialog_db_async_ = create_dialog_db_async(dialog_db_sync_safe_);
+    dialog_db_async_ = create_dialog_db_async(dialog_db_sync_safe_, -1, parameters.database_read_scheduler_id_);
   }
 
   if (use_message_thread_db) {
@@ -480,8 +574,11 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
   }
 
   if (use_message_database) {
-    message_db_sync_safe_ = create_message_db_sync(sql_connection_);
-    message_db_async_ = create_message_db_async(message_db_sync_safe_);
+    vector<std::shared_ptr<SqliteConnectionSafe>> message_db_connections{sql_connection_};
+    append(message_db_connections, message_db_shard_connections_);
+    message_db_sync_safe_ = create_message_db_sync(std::move(message_db_connections));
+    message_db_async_ =
+        create_message_db_async(message_db_sync_safe_, -1, parameters.database_read_scheduler_id_);
   }
 
   if (use_story_database) {
@@ -492,6 +589,32 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
   return Status::OK();
 }
 
+Result<std::shared_ptr<SqliteConnectionSafe>> TdDb::init_message_db_shard(const string &path, const DbKey &key,
+                                                                          const DbKey &old_key) {
+  TRY_RESULT(db_instance, SqliteDb::change_key(path, true, key, old_key));
+  auto connection = std::make_shared<SqliteConnectionSafe>(path, key, db_instance.get_cipher_version(),
+                                                           use_sqlite_secure_delete_, !use_managed_sqlite_checkpoints_,
+                                                           sqlite_mmap_size_, sqlite_cache_size_,
+                                                           use_sqlite_cell_size_check_);
+  connection->set(std::move(db_instance));
+  auto &db = connection->get();
+  TRY_STATUS(SqliteConnectionSafe::init_connection(db, use_sqlite_secure_delete_, !use_managed_sqlite_checkpoints_,
+                                                   sqlite_mmap_size_, sqlite_cache_size_, use_sqlite_cell_size_check_));
+  if (use_incremental_vacuum_) {
+    TRY_STATUS(enable_incremental_vacuum(db));
+  }
+
+  TRY_STATUS(db.exec("BEGIN TRANSACTION"));
+  TRY_RESULT(user_version, db.user_version());
+  TRY_STATUS(init_message_db(db, user_version));
+  auto db_version = current_db_version();
+  if (db_version != user_version) {
+    TRY_STATUS(db.set_user_version(db_version));
+  }
+  TRY_STATUS(db.exec("COMMIT TRANSACTION"));
+  return std::move(connection);
+}
+
 void TdDb::open(int32 scheduler_id, Parameters parameters, Promise<OpenedDatabase> &&promise) {
   Scheduler::instance()->run_on_scheduler(
       scheduler_id, [parameters = std::move(parameters), promise = std::move(promise)](Unit) mutable {
@@ -503,6 +626,8 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
   TRY_STATUS_PROMISE(promise, check_parameters(parameters));
 
   OpenedDatabase result;
+  auto start_time = Time::now();
+  auto start_cpu_time = Clocks::thread_cpu();
 
   // Init pmc
   Binlog *binlog_ptr = nullptr;
@@ -515,8 +640,11 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
 
   bool encrypt_binlog = !parameters.encryption_key_.is_empty();
   VLOG(td_init) << "Start binlog loading";
-  TRY_STATUS_PROMISE(promise, init_binlog(*binlog, get_binlog_path(parameters), *binlog_pmc, *config_pmc, result,
-                                          std::move(parameters.encryption_key_)));
+  {
+    StartupProfiler::Phase phase(&result.startup_profiler, "Binlog loading");
+    TRY_STATUS_PROMISE(promise, init_binlog(*binlog, get_binlog_path(parameters), *binlog_pmc, *config_pmc, result,
+                                            std::move(parameters.encryption_key_)));
+  }
   VLOG(td_init) << "Finish binlog loading";
 
   binlog_pmc->external_init_finish(binlog);
@@ -531,7 +659,8 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
 
   DbKey new_sqlite_key;
   DbKey old_sqlite_key;
-  bool encrypt_sqlite = encrypt_binlog;
+  // the option is applied only on database opening, so it takes effect after restart
+  bool encrypt_sqlite = encrypt_binlog && config_pmc->get("use_unencrypted_sqlite_database") != "Btrue";
   bool drop_sqlite_key = false;
   auto sqlite_key = binlog_pmc->get("sqlite_key");
   if (encrypt_sqlite) {
@@ -552,15 +681,55 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
   }
   VLOG(td_init) << "Start to init database";
   auto db = make_unique<TdDb>();
-  auto init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc);
+  // the options are applied only on database opening, so they take effect after restart
+  db->use_sqlite_secure_delete_ = config_pmc->get("disable_sqlite_secure_delete") != "Btrue";
+  // the database was left unencrypted on request, so there are no SQLCipher page checksums
+  db->use_sqlite_cell_size_check_ = encrypt_binlog && !encrypt_sqlite;
+#if !TD_THREAD_UNSUPPORTED
+  db->use_managed_sqlite_checkpoints_ = config_pmc->get("use_managed_sqlite_checkpoints") == "Btrue";
+#endif
+  auto get_integer_option = [&](Slice name) -> int64 {
+    auto value = config_pmc->get(name.str());
+    if (value.size() > 1 && value[0] == 'I') {
+      return to_integer<int64>(Slice(value).substr(1));
+    }
+    return 0;
+  };
+  db->sqlite_mmap_size_ = get_integer_option("sqlite_mmap_size");
+  db->sqlite_cache_size_ = get_integer_option("sqlite_cache_size");
+  auto message_db_shard_count = config_pmc->get("message_database_shard_count");
+  if (message_db_shard_count.size() > 1 && message_db_shard_count[0] == 'I') {
+    db->message_db_shard_count_ =
+        clamp(to_integer<int32>(Slice(message_db_shard_count).substr(1)), 1, MAX_MESSAGE_DB_SHARD_COUNT);
+  }
+  for (auto option_name : {"message_database_max_size", "message_database_private_chat_max_age",
+                           "message_database_group_max_age", "message_database_channel_max_age"}) {
+    auto value = config_pmc->get(option_name);
+    if (value.size() > 1 && value[0] == 'I' && value != "I0") {
+      db->use_incremental_vacuum_ = true;
+    }
+  }
+  Status init_sqlite_status;
+  {
+    StartupProfiler::Phase phase(&result.startup_profiler, "TdDb::init_sqlite");
+    init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc);
+  }
   VLOG(td_init) << "Finish to init database";
   if (init_sqlite_status.is_error()) {
     LOG(ERROR) << "Destroy bad SQLite database because of " << init_sqlite_status;
     if (db->sql_connection_ != nullptr) {
       db->sql_connection_->get().close();
     }
+    for (auto &shard_connection : db->message_db_shard_connections_) {
+      shard_connection->get().close();
+    }
+    db->message_db_shard_connections_.clear();
     SqliteDb::destroy(get_sqlite_path(parameters)).ignore();
-    init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc);
+    destroy_message_db_shards(parameters);
+    {
+      StartupProfiler::Phase phase(&result.startup_profiler, "TdDb::init_sqlite after database destruction");
+      init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc);
+    }
     if (init_sqlite_status.is_error()) {
       return promise.set_error(Status::Error(400, init_sqlite_status.message()));
     }
@@ -602,6 +771,7 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
   db->binlog_ = std::move(concurrent_binlog);
 
   result.database = std::move(db);
+  result.startup_profiler.add_phase("TdDb::open", Time::now() - start_time, Clocks::thread_cpu() - start_cpu_time);
 
   promise.set_value(std::move(result));
 }
@@ -666,14 +836,120 @@ void TdDb::change_key(DbKey key, Promise<> promise) {
   get_binlog()->change_key(std::move(key), std::move(promise));
 }
 
+void TdDb::update_binlog_sync_options() {
+  CHECK(binlog_ != nullptr);
+  auto force_sync_delay = static_cast<double>(G()->get_option_integer("binlog_sync_delay_ms", 3)) * 1e-3;
+  auto sync_mode = G()->get_option_boolean("use_binlog_data_sync") ? Binlog::SyncMode::Data : Binlog::SyncMode::Full;
+  binlog_->set_sync_options(force_sync_delay, sync_mode);
+}
+
+void TdDb::update_sqlite_pmc_write_batch_options() {
+  if (common_kv_async_ == nullptr) {
+    return;
+  }
+  auto max_delay = static_cast<double>(G()->get_option_integer("sqlite_pmc_write_delay_ms", 10)) * 1e-3;
+  auto max_count = static_cast<size_t>(G()->get_option_integer("sqlite_pmc_max_pending_writes", 100));
+  common_kv_async_->set_write_batch_options(max_delay, max_count);
+}
+
+// the dialog list and last messages of the first chats are loaded in the order in which they are loaded by the client,
+// so the pages are cached by the database connection, which will be used for the following queries
+static void warm_up_chat(std::shared_ptr<DialogDbAsyncInterface> dialog_db_async,
+                         std::shared_ptr<MessageDbAsyncInterface> message_db_async, int64 order, DialogId dialog_id,
+                         int32 left_chat_count) {
+  if (left_chat_count <= 0 || G()->close_flag()) {
+    LOG(INFO) << "Finish database warm up";
+    return;
+  }
+  auto *dialog_db = dialog_db_async.get();
+  dialog_db->get_dialogs(
+      FolderId::main(), order, dialog_id, 1,
+      PromiseCreator::lambda([dialog_db_async = std::move(dialog_db_async),
+                              message_db_async = std::move(message_db_async),
+                              left_chat_count](Result<DialogDbGetDialogsResult> r_dialogs) mutable {
+        if (r_dialogs.is_error() || r_dialogs.ok().dialogs.empty() || G()->close_flag()) {
+          LOG(INFO) << "Finish database warm up";
+          return;
+        }
+        auto next_order = r_dialogs.ok().next_order;
+        auto next_dialog_id = r_dialogs.ok().next_dialog_id;
+
+        MessageDbMessagesQuery query;
+        query.dialog_id = next_dialog_id;
+        query.from_message_id = MessageId::max();
+        query.limit = 50;
+        auto *message_db = message_db_async.get();
+        message_db->get_messages(
+            std::move(query),
+            PromiseCreator::lambda([dialog_db_async = std::move(dialog_db_async),
+                                    message_db_async = std::move(message_db_async), next_order, next_dialog_id,
+                                    left_chat_count](Result<vector<MessageDbDialogMessage>> r_messages) mutable {
+              if (r_messages.is_error()) {
+                return;
+              }
+              warm_up_chat(std::move(dialog_db_async), std::move(message_db_async), next_order, next_dialog_id,
+                           left_chat_count - 1);
+            }));
+      }));
+}
+
+void TdDb::warm_up_database() {
+  auto chat_count = narrow_cast<int32>(G()->get_option_integer("database_warm_up_chat_count"));
+  if (chat_count <= 0 || dialog_db_async_ == nullptr || message_db_async_ == nullptr) {
+    return;
+  }
+  LOG(INFO) << "Start database warm up for " << chat_count << " chats";
+  warm_up_chat(dialog_db_async_, message_db_async_, std::numeric_limits<int64>::max(), DialogId(), chat_count);
+}
+
+void TdDb::update_message_fts_options() {
+  if (message_db_async_ == nullptr) {
+    return;
+  }
+  auto use_deferred_indexing = G()->get_option_boolean("use_deferred_message_fts_indexing");
+  auto automerge = narrow_cast<int32>(G()->get_option_integer("message_fts_automerge", 4));
+  message_db_async_->set_fts_options(use_deferred_indexing, automerge);
+}
+
+void TdDb::update_message_retention_policy() {
+  if (message_db_async_ == nullptr) {
+    return;
+  }
+  class RetentionCallback final : public MessageDbRetentionCallback {
+   public:
+    void on_messages_pruned(DialogId dialog_id, MessageId first_kept_message_id) final {
+      send_closure(G()->messages_manager(), &MessagesManager::on_message_db_messages_pruned, dialog_id,
+                   first_kept_message_id);
+    }
+  };
+
+  MessageDbRetentionPolicy policy;
+  policy.max_database_size = G()->get_option_integer("message_database_max_size");
+  policy.private_chat_max_age = narrow_cast<int32>(G()->get_option_integer("message_database_private_chat_max_age"));
+  policy.group_max_age = narrow_cast<int32>(G()->get_option_integer("message_database_group_max_age"));
+  policy.channel_max_age = narrow_cast<int32>(G()->get_option_integer("message_database_channel_max_age"));
+  message_db_async_->set_retention_policy(policy, std::make_shared<RetentionCallback>());
+}
+
+void TdDb::update_message_data_compression_options() {
+  if (message_db_async_ == nullptr) {
+    return;
+  }
+  message_db_async_->set_data_compression(G()->get_option_boolean("use_message_database_compression"));
+}
+
 Status TdDb::destroy(const Parameters &parameters) {
   SqliteDb::destroy(get_sqlite_path(parameters)).ignore();
+  destroy_message_db_shards(parameters);
   Binlog::destroy(get_binlog_path(parameters)).ignore();
   return Status::OK();
 }
 
 void TdDb::with_db_path(const std::function<void(CSlice)> &callback) {
   SqliteDb::with_db_path(get_sqlite_path(parameters_), callback);
+  for (size_t i = 0; i < message_db_shard_connections_.size(); i++) {
+    SqliteDb::with_db_path(get_message_db_shard_path(parameters_, static_cast<int32>(i + 1)), callback);
+  }
   CHECK(binlog_ != nullptr);
   callback(binlog_->get_path());
 }
@@ -702,8 +978,20 @@ Result<string> TdDb::get_stats() {
                               << mask << "'",
                      PSLICE() << table << ":" << mask);
   };
+  auto r_wal_stat = stat(get_sqlite_path(parameters_) + "-wal");
+  if (r_wal_stat.is_ok()) {
+    sb << "WAL size: " << format::as_size(r_wal_stat.ok().size_) << "\n";
+  }
   TRY_STATUS(run_query("SELECT 0, SUM(length(data)), COUNT(*) FROM stories WHERE 1", "stories"));
   TRY_STATUS(run_query("SELECT 0, SUM(length(data)), COUNT(*) FROM messages WHERE 1", "messages"));
+  for (size_t i = 0; i < message_db_shard_connections_.size(); i++) {
+    TRY_RESULT(stmt, message_db_shard_connections_[i]->get().get_statement(
+                         "SELECT SUM(length(data)), COUNT(*) FROM messages WHERE 1"));
+    TRY_STATUS(stmt.step());
+    CHECK(stmt.has_row());
+    sb << "messages shard " << i + 1 << ":\n";
+    sb << format::as_size(stmt.view_int64(0)) << "\t" << stmt.view_int64(1) << "\n";
+  }
   TRY_STATUS(run_query("SELECT 0, SUM(length(data)), COUNT(*) FROM dialogs WHERE 1", "dialogs"));
   TRY_STATUS(run_kv_query("%", "common"));
   TRY_STATUS(run_kv_query("%", "files"));
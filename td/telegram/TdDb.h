@@ -6,6 +6,8 @@
 //
 #pragma once
 
+#include "td/telegram/StartupProfiler.h"
+
 #include "td/db/binlog/BinlogEvent.h"
 #include "td/db/binlog/BinlogInterface.h"
 #include "td/db/DbKey.h"
@@ -39,6 +41,7 @@ class SqliteConnectionSafe;
 class SqliteKeyValueSafe;
 class SqliteKeyValueAsyncInterface;
 class SqliteKeyValue;
+class SqliteWalCheckpointerInterface;
 class StoryDbSyncInterface;
 class StoryDbSyncSafeInterface;
 class StoryDbAsyncInterface;
@@ -60,6 +63,7 @@ class TdDb {
     bool use_file_database_ = false;
     bool use_chat_info_database_ = false;
     bool use_message_database_ = false;
+    int32 database_read_scheduler_id_ = -1;
   };
 
   struct OpenedDatabase {
@@ -80,6 +84,8 @@ class TdDb {
     vector<BinlogEvent> to_story_manager;
 
     int64 since_last_open = 0;
+
+    StartupProfiler startup_profiler;
   };
   static void open(int32 scheduler_id, Parameters parameters, Promise<OpenedDatabase> &&promise);
 
@@ -150,6 +156,19 @@ class TdDb {
 
   void change_key(DbKey key, Promise<> promise);
 
+  void update_binlog_sync_options();
+
+  void update_sqlite_pmc_write_batch_options();
+
+  void update_message_fts_options();
+
+  void update_message_retention_policy();
+
+  void update_message_data_compression_options();
+
+  // asynchronously preloads the first chats from the chat list to the database cache
+  void warm_up_database();
+
   void with_db_path(const std::function<void(CSlice)> &callback);
 
   Result<string> get_stats();
@@ -159,7 +178,18 @@ class TdDb {
 
   bool was_dialog_db_created_ = false;
 
+  bool use_sqlite_secure_delete_ = true;
+  bool use_sqlite_cell_size_check_ = false;
+  bool use_managed_sqlite_checkpoints_ = false;
+  int64 sqlite_mmap_size_ = 0;
+  int64 sqlite_cache_size_ = 0;
+  int32 message_db_shard_count_ = 1;
+  bool use_incremental_vacuum_ = false;
+
   std::shared_ptr<SqliteConnectionSafe> sql_connection_;
+  // connections to additional message database shards; the first shard is stored in the main database
+  vector<std::shared_ptr<SqliteConnectionSafe>> message_db_shard_connections_;
+  vector<unique_ptr<SqliteWalCheckpointerInterface>> wal_checkpointers_;
 
   std::shared_ptr<FileDbInterface> file_db_;
 
@@ -189,6 +219,9 @@ class TdDb {
   Status init_sqlite(const Parameters &parameters, const DbKey &key, const DbKey &old_key,
                      BinlogKeyValue<Binlog> &binlog_pmc);
 
+  Result<std::shared_ptr<SqliteConnectionSafe>> init_message_db_shard(const string &path, const DbKey &key,
+                                                                      const DbKey &old_key);
+
   void do_close(bool destroy_flag, Promise<Unit> on_finished);
 };
 
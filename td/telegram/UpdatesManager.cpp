@@ -67,6 +67,7 @@
 #include "td/telegram/ServerMessageId.h"
 #include "td/telegram/SpecialStickerSetType.h"
 #include "td/telegram/StarManager.h"
+#include "td/telegram/StartupProfiler.h"
 #include "td/telegram/StateManager.h"
 #include "td/telegram/StatisticsManager.h"
 #include "td/telegram/StickerListType.h"
@@ -92,6 +93,7 @@
 
 #include "td/utils/algorithm.h"
 #include "td/utils/buffer.h"
+#include "td/utils/CpuProfiler.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/Random.h"
@@ -121,6 +123,7 @@ class OnUpdate {
   template <class T>
   void operator()(T &obj) const {
     CHECK(&*update_ == &obj);
+    CpuProfiler::Label label("telegram_api update", T::ID);
     updates_manager_->on_update(move_tl_object_as<T>(update_), std::move(promise_));
   }
 };
@@ -284,6 +287,7 @@ void UpdatesManager::tear_down() {
 }
 
 void UpdatesManager::start_up() {
+  StartupProfiler::Phase phase(td_->startup_profiler_.get(), "UpdatesManager::start_up");
   if (td_->auth_manager_->is_bot()) {
     return;
   }
@@ -388,13 +392,13 @@ void UpdatesManager::fill_pts_gap(void *td) {
     max_pts = max(max_pts, updates_manager->pending_pts_updates_.rbegin()->pts);
   }
   if (!updates_manager->postponed_pts_updates_.empty()) {
-    auto &min_update = *updates_manager->postponed_pts_updates_.begin();
+    auto &min_update = updates_manager->postponed_pts_updates_.front();
     if (min_update.pts < min_pts) {
       min_pts = min_update.pts;
       min_pts_count = min_update.pts_count;
       first_update = min_update.update.get();
     }
-    max_pts = max(max_pts, updates_manager->postponed_pts_updates_.rbegin()->pts);
+    max_pts = max(max_pts, updates_manager->postponed_pts_updates_.back().pts);
   }
   updates_manager->pts_gap_++;
   fill_gap(td, PSTRING() << "PTS from " << updates_manager->get_pts() << " to " << min_pts << "(-" << min_pts_count
@@ -519,11 +523,82 @@ void UpdatesManager::run_get_difference(bool is_recursive, const char *source) {
       send_closure(G()->updates_manager(), &UpdatesManager::on_failed_get_difference, result.move_as_error());
     }
   });
-  td_->create_handler<GetDifferenceQuery>(std::move(promise))->send(pts, date, qts);
+  if (is_recursive && prefetched_difference_.generation_ != 0 && prefetched_difference_.pts_ == pts &&
+      prefetched_difference_.date_ == date && prefetched_difference_.qts_ == qts) {
+    VLOG(get_difference) << "Use prefetched difference";
+    get_difference_prefetched_slice_count_++;
+    prefetched_difference_.promise_ = std::move(promise);
+    if (prefetched_difference_.is_received_) {
+      prefetched_difference_.is_received_ = false;
+      send_closure_later(actor_id(this), &UpdatesManager::on_get_prefetched_difference,
+                         prefetched_difference_.generation_, std::move(prefetched_difference_.result_));
+    }
+  } else {
+    drop_prefetched_difference();
+    td_->create_handler<GetDifferenceQuery>(std::move(promise))->send(pts, date, qts);
+  }
   last_confirmed_pts_ = pts;
   last_confirmed_qts_ = qts;
 }
 
+void UpdatesManager::prefetch_difference(int32 pts, int32 date, int32 qts) {
+  drop_prefetched_difference();
+  if (pts < 0) {
+    pts = 0;
+  }
+
+  VLOG(get_difference) << "Prefetch difference with PTS = " << pts << ", QTS = " << qts << ", date = " << date;
+  auto generation = ++last_prefetched_difference_generation_;
+  prefetched_difference_.generation_ = generation;
+  prefetched_difference_.pts_ = pts;
+  prefetched_difference_.date_ = date;
+  prefetched_difference_.qts_ = qts;
+  auto promise =
+      PromiseCreator::lambda([generation](Result<tl_object_ptr<telegram_api::updates_Difference>> result) {
+        send_closure(G()->updates_manager(), &UpdatesManager::on_get_prefetched_difference, generation,
+                     std::move(result));
+      });
+  td_->create_handler<GetDifferenceQuery>(std::move(promise))->send(pts, date, qts);
+}
+
+void UpdatesManager::on_get_prefetched_difference(uint64 generation,
+                                                  Result<tl_object_ptr<telegram_api::updates_Difference>> result) {
+  if (generation != prefetched_difference_.generation_) {
+    VLOG(get_difference) << "Ignore dropped prefetched difference";
+    return;
+  }
+  if (G()->close_flag() || !td_->auth_manager_->is_authorized()) {
+    // the waiting getDifference must be finished, so that the prefetched difference can be dropped later
+    auto promise = std::move(prefetched_difference_.promise_);
+    prefetched_difference_ = PrefetchedDifference();
+    if (promise) {
+      promise.set_error(Status::Error(500, "Request aborted"));
+    }
+    return;
+  }
+
+  if (prefetched_difference_.promise_) {
+    auto promise = std::move(prefetched_difference_.promise_);
+    prefetched_difference_ = PrefetchedDifference();
+    promise.set_result(std::move(result));
+  } else if (result.is_error()) {
+    VLOG(get_difference) << "Failed to prefetch difference: " << result.error();
+    prefetched_difference_ = PrefetchedDifference();
+  } else {
+    VLOG(get_difference) << "Receive prefetched difference";
+    prefetched_difference_.is_received_ = true;
+    prefetched_difference_.result_ = std::move(result);
+  }
+}
+
+void UpdatesManager::drop_prefetched_difference() {
+  CHECK(!prefetched_difference_.promise_);
+  if (prefetched_difference_.generation_ != 0) {
+    VLOG(get_difference) << "Drop prefetched difference with PTS = " << prefetched_difference_.pts_;
+    prefetched_difference_ = PrefetchedDifference();
+  }
+}
+
 void UpdatesManager::before_get_difference(bool is_initial) {
   // may be called many times before after_get_difference is called
   send_closure(G()->state_manager(), &StateManager::on_synchronized, false);
@@ -1935,6 +2010,9 @@ void UpdatesManager::on_get_difference(tl_object_ptr<telegram_api::updates_Diffe
         }
       }
 
+      get_difference_slice_count_++;
+      get_difference_message_count_ += difference->new_messages_.size();
+      get_difference_update_count_ += difference->other_updates_.size();
       process_get_difference_updates(std::move(difference->new_messages_),
                                      std::move(difference->new_encrypted_messages_),
                                      std::move(difference->other_updates_));
@@ -1949,11 +2027,10 @@ void UpdatesManager::on_get_difference(tl_object_ptr<telegram_api::updates_Diffe
     case telegram_api::updates_differenceSlice::ID: {
       auto difference = move_tl_object_as<telegram_api::updates_differenceSlice>(difference_ptr);
       bool is_pts_changed = have_update_pts_changed(difference->other_updates_);
-      if (difference->intermediate_state_->pts_ >= get_pts() && get_pts() != std::numeric_limits<int32>::max() &&
-          difference->intermediate_state_->date_ >= date_ && difference->intermediate_state_->qts_ == get_qts() &&
-          !is_pts_changed) {
-        // TODO send new getDifference request and apply difference slice only after that
-      }
+      bool can_prefetch_difference = difference->intermediate_state_->pts_ >= get_pts() &&
+                                     get_pts() != std::numeric_limits<int32>::max() &&
+                                     difference->intermediate_state_->date_ >= date_ &&
+                                     difference->intermediate_state_->qts_ == get_qts() && !is_pts_changed;
 
       VLOG(get_difference) << "In get difference receive " << difference->users_.size() << " users and "
                            << difference->chats_.size() << " chats";
@@ -1971,6 +2048,18 @@ void UpdatesManager::on_get_difference(tl_object_ptr<telegram_api::updates_Diffe
         }
       }
 
+      if (can_prefetch_difference) {
+        // the state after the slice is already known, so request the next slice while the current one is applied;
+        // the next slice will be used only if the state doesn't change in other ways
+        const auto &state = difference->intermediate_state_;
+        prefetch_difference(state->pts_, state->date_, state->qts_);
+      }
+
+      get_difference_slice_count_++;
+      get_difference_message_count_ += difference->new_messages_.size();
+      get_difference_update_count_ += difference->other_updates_.size();
+      VLOG(get_difference) << "Apply difference slice " << get_difference_slice_count_ << " up to PTS "
+                           << difference->intermediate_state_->pts_;
       process_get_difference_updates(std::move(difference->new_messages_),
                                      std::move(difference->new_encrypted_messages_),
                                      std::move(difference->other_updates_));
@@ -2122,6 +2211,18 @@ void UpdatesManager::confirm_pts_qts(int32 qts) {
 void UpdatesManager::after_get_difference() {
   CHECK(!running_get_difference_);
 
+  drop_prefetched_difference();
+  if (get_difference_slice_count_ > 0) {
+    LOG(INFO) << "Received " << get_difference_message_count_ << " messages and " << get_difference_update_count_
+              << " other updates in " << get_difference_slice_count_ << " differences, "
+              << get_difference_prefetched_slice_count_ << " of which were prefetched, in "
+              << (Time::now() - get_difference_start_time_) << " seconds";
+    get_difference_slice_count_ = 0;
+    get_difference_prefetched_slice_count_ = 0;
+    get_difference_message_count_ = 0;
+    get_difference_update_count_ = 0;
+  }
+
   retry_timeout_.cancel_timeout();
   retry_time_ = 1;
 
@@ -2517,6 +2618,8 @@ void UpdatesManager::on_pending_updates(vector<tl_object_ptr<telegram_api::Updat
     }
   }
 
+  // consecutive new messages in the same chat change its last message and position only once
+  td_->messages_manager_->begin_updates_batch();
   for (auto &update : updates) {
     if (update != nullptr) {
       if (is_pts_update(update.get())) {
@@ -2543,6 +2646,7 @@ void UpdatesManager::on_pending_updates(vector<tl_object_ptr<telegram_api::Updat
       }
     }
   }
+  td_->messages_manager_->end_updates_batch();
 
   if (seq_begin == 0 && seq_end == 0) {
     bool have_updates = false;
@@ -3159,16 +3263,16 @@ void UpdatesManager::process_postponed_pts_updates() {
   auto old_pts = initial_pts;
   int32 skipped_update_count = 0;
   int32 applied_update_count = 0;
-  auto update_it = postponed_pts_updates_.begin();
-  while (update_it != postponed_pts_updates_.end()) {
-    auto new_pts = update_it->pts;
-    auto pts_count = update_it->pts_count;
+  while (!postponed_pts_updates_.empty()) {
+    const auto &first_update = postponed_pts_updates_.front();
+    auto new_pts = first_update.pts;
+    auto pts_count = first_update.pts_count;
     if (new_pts <= old_pts || (old_pts >= 1 && new_pts - (1 << 30) > old_pts)) {
       skipped_update_count++;
-      td_->messages_manager_->skip_old_pending_pts_update(std::move(update_it->update), new_pts, old_pts, pts_count,
+      auto updates = postponed_pts_updates_.extract_front(1);
+      td_->messages_manager_->skip_old_pending_pts_update(std::move(updates[0].update), new_pts, old_pts, pts_count,
                                                           "process_postponed_pts_updates");
-      update_it->promise.set_value(Unit());
-      update_it = postponed_pts_updates_.erase(update_it);
+      updates[0].promise.set_value(Unit());
       continue;
     }
 
@@ -3177,40 +3281,40 @@ void UpdatesManager::process_postponed_pts_updates() {
       break;
     }
 
-    auto last_update_it = update_it;
-    for (int32 i = 1; true; i++) {
-      ++last_update_it;
+    size_t update_count = 0;
+    for (size_t i = 1; true; i++) {
       if (old_pts == new_pts - pts_count) {
         // the updates can be applied
+        update_count = i;
         break;
       }
-      if (old_pts > new_pts - pts_count || last_update_it == postponed_pts_updates_.end() ||
-          i == GAP_TIMEOUT_UPDATE_COUNT) {
+      if (old_pts > new_pts - pts_count || i == postponed_pts_updates_.size() ||
+          i == static_cast<size_t>(GAP_TIMEOUT_UPDATE_COUNT)) {
         // the updates can't be applied
-        VLOG(get_difference) << "Can't apply " << i << " next postponed updates with PTS " << update_it->pts << '-'
+        VLOG(get_difference) << "Can't apply " << i << " next postponed updates with PTS " << first_update.pts << '-'
                              << new_pts << ", because their pts_count is " << pts_count << " instead of expected "
                              << new_pts - old_pts;
-        last_update_it = update_it;
         break;
       }
 
-      new_pts = last_update_it->pts;
-      pts_count += last_update_it->pts_count;
+      new_pts = postponed_pts_updates_[i].pts;
+      pts_count += postponed_pts_updates_[i].pts_count;
     }
 
-    if (last_update_it == update_it) {
+    if (update_count == 0) {
       // the updates will be applied or skipped later
       break;
     }
     CHECK(old_pts == new_pts - pts_count);
 
-    while (update_it != last_update_it) {
-      if (update_it->pts_count > 0) {
+    // the applied updates are removed in one batch before processing
+    auto updates = postponed_pts_updates_.extract_front(update_count);
+    for (auto &update : updates) {
+      if (update.pts_count > 0) {
         applied_update_count++;
-        td_->messages_manager_->process_pts_update(std::move(update_it->update));
+        td_->messages_manager_->process_pts_update(std::move(update.update));
       }
-      update_it->promise.set_value(Unit());
-      update_it = postponed_pts_updates_.erase(update_it);
+      update.promise.set_value(Unit());
     }
     old_pts = new_pts;
   }
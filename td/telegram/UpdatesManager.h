@@ -28,6 +28,8 @@
 #include "td/utils/tl_storers.h"
 #include "td/utils/TlStorerToString.h"
 
+#include <algorithm>
+#include <iterator>
 #include <map>
 #include <set>
 #include <utility>
@@ -176,6 +178,73 @@ class UpdatesManager final : public Actor {
     }
   };
 
+  // PTS updates sorted by PTS in a contiguous buffer, which are removed from the beginning in batches
+  class PendingPtsUpdateQueue {
+    vector<PendingPtsUpdate> updates_;
+    size_t begin_pos_ = 0;
+
+   public:
+    template <class... ArgsT>
+    void emplace(ArgsT &&...args) {
+      PendingPtsUpdate update(std::forward<ArgsT>(args)...);
+      if (empty() || !(update < updates_.back())) {
+        // the most common case is addition of an update with the biggest PTS
+        updates_.push_back(std::move(update));
+      } else {
+        auto it = std::upper_bound(updates_.begin() + begin_pos_, updates_.end(), update);
+        updates_.insert(it, std::move(update));
+      }
+    }
+
+    bool empty() const {
+      return begin_pos_ == updates_.size();
+    }
+
+    size_t size() const {
+      return updates_.size() - begin_pos_;
+    }
+
+    const PendingPtsUpdate &operator[](size_t pos) const {
+      CHECK(pos < size());
+      return updates_[begin_pos_ + pos];
+    }
+
+    const PendingPtsUpdate &front() const {
+      return (*this)[0];
+    }
+
+    const PendingPtsUpdate &back() const {
+      CHECK(!empty());
+      return updates_.back();
+    }
+
+    vector<PendingPtsUpdate>::iterator begin() {
+      return updates_.begin() + begin_pos_;
+    }
+
+    vector<PendingPtsUpdate>::iterator end() {
+      return updates_.end();
+    }
+
+    vector<PendingPtsUpdate> extract_front(size_t count) {
+      CHECK(count <= size());
+      vector<PendingPtsUpdate> result(std::make_move_iterator(begin()), std::make_move_iterator(begin() + count));
+      begin_pos_ += count;
+      if (empty()) {
+        clear();
+      } else if (begin_pos_ >= 16 && begin_pos_ * 2 >= updates_.size()) {
+        updates_.erase(updates_.begin(), updates_.begin() + begin_pos_);
+        begin_pos_ = 0;
+      }
+      return result;
+    }
+
+    void clear() {
+      updates_.clear();
+      begin_pos_ = 0;
+    }
+  };
+
   class PendingSeqUpdates {
    public:
     int32 seq_begin;
@@ -244,7 +313,7 @@ class UpdatesManager final : public Actor {
   double last_pts_gap_time_ = 0;
 
   std::multiset<PendingPtsUpdate> pending_pts_updates_;
-  std::multiset<PendingPtsUpdate> postponed_pts_updates_;
+  PendingPtsUpdateQueue postponed_pts_updates_;
 
   std::multiset<PendingSeqUpdates> postponed_updates_;    // updates received during getDifference
   std::multiset<PendingSeqUpdates> pending_seq_updates_;  // updates with too big seq
@@ -275,6 +344,25 @@ class UpdatesManager final : public Actor {
   double get_difference_start_time_ = 0;  // time from which we started to get difference without success
   int32 get_difference_retry_count_ = 0;
 
+  // statistics of the current getDifference run
+  int32 get_difference_slice_count_ = 0;
+  int32 get_difference_prefetched_slice_count_ = 0;
+  size_t get_difference_message_count_ = 0;
+  size_t get_difference_update_count_ = 0;
+
+  // the next difference slice, which is requested before the previous slice is applied
+  struct PrefetchedDifference {
+    uint64 generation_ = 0;
+    int32 pts_ = 0;
+    int32 date_ = 0;
+    int32 qts_ = 0;
+    bool is_received_ = false;
+    Result<tl_object_ptr<telegram_api::updates_Difference>> result_;
+    Promise<tl_object_ptr<telegram_api::updates_Difference>> promise_;  // promise of the waiting getDifference
+  };
+  PrefetchedDifference prefetched_difference_;
+  uint64 last_prefetched_difference_generation_ = 0;
+
   struct SessionInfo {
     uint64 update_count = 0;
     double first_update_time = 0.0;
@@ -398,6 +486,12 @@ class UpdatesManager final : public Actor {
 
   void run_get_difference(bool is_recursive, const char *source);
 
+  void prefetch_difference(int32 pts, int32 date, int32 qts);
+
+  void on_get_prefetched_difference(uint64 generation, Result<tl_object_ptr<telegram_api::updates_Difference>> result);
+
+  void drop_prefetched_difference();
+
   void confirm_pts_qts(int32 qts);
 
   void on_failed_get_updates_state(Status &&error);
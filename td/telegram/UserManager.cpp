@@ -37,6 +37,7 @@
 #include "td/telegram/LinkManager.h"
 #include "td/telegram/logevent/LogEvent.h"
 #include "td/telegram/logevent/LogEventHelper.h"
+#include "td/telegram/MemoryStatistics.h"
 #include "td/telegram/MessageId.h"
 #include "td/telegram/MessagesManager.h"
 #include "td/telegram/MessageTtl.h"
@@ -3577,11 +3578,22 @@ bool UserManager::have_min_user(UserId user_id) const {
 }
 
 const UserManager::User *UserManager::get_user(UserId user_id) const {
-  return users_.get_pointer(user_id);
+  const User *u = users_.get_pointer(user_id);
+  if (u != nullptr) {
+    u->is_recently_used = true;
+  }
+  return u;
 }
 
 UserManager::User *UserManager::get_user(UserId user_id) {
-  return users_.get_pointer(user_id);
+  User *u = users_.get_pointer(user_id);
+  if (u == nullptr && evicted_users_.is_evicted(user_id)) {
+    u = reload_evicted_user(user_id);
+  }
+  if (u != nullptr) {
+    u->is_recently_used = true;
+  }
+  return u;
 }
 
 UserManager::User *UserManager::add_user(UserId user_id) {
@@ -3589,10 +3601,58 @@ UserManager::User *UserManager::add_user(UserId user_id) {
   auto &user_ptr = users_[user_id];
   if (user_ptr == nullptr) {
     user_ptr = make_unique<User>();
+    evicted_users_.on_load(user_id);
+
+    auto max_user_count = td_->option_manager_->get_option_integer("user_cache_max_size");
+    if (max_user_count > 0 && !is_user_cache_reduce_scheduled_ && G()->use_chat_info_database() &&
+        static_cast<int64>(users_.calc_size()) > max_user_count + max_user_count / 10) {
+      is_user_cache_reduce_scheduled_ = true;
+      send_closure_later(actor_id(this), &UserManager::reduce_user_cache);
+    }
   }
   return user_ptr.get();
 }
 
+UserManager::User *UserManager::reload_evicted_user(UserId user_id) {
+  CHECK(G()->use_chat_info_database());
+  evicted_users_.on_load(user_id);
+  LOG(INFO) << "Reload evicted " << user_id << " from database";
+  on_load_user_from_database(user_id, G()->td_db()->get_sqlite_sync_pmc()->get(get_user_database_key(user_id)), true);
+  return users_.get_pointer(user_id);
+}
+
+bool UserManager::can_evict_user(UserId user_id, const User *u) const {
+  if (!u->is_saved || !u->is_status_saved || u->is_being_saved || u->log_event_id != 0 ||
+      u->is_changed || u->need_save_to_database || u->is_status_changed || u->is_being_updated) {
+    return false;
+  }
+  if (user_id == get_my_id() || u->is_contact) {
+    return false;
+  }
+  return users_full_.count(user_id) == 0 && pending_user_photos_.count(user_id) == 0 &&
+         secret_chats_with_user_.count(user_id) == 0 && load_user_from_database_queries_.count(user_id) == 0 &&
+         !user_online_timeout_.has_timeout(user_id.get()) && !user_emoji_status_timeout_.has_timeout(user_id.get()) &&
+         !td_->messages_manager_->have_dialog(DialogId(user_id));
+}
+
+void UserManager::reduce_user_cache() {
+  is_user_cache_reduce_scheduled_ = false;
+  auto max_user_count = td_->option_manager_->get_option_integer("user_cache_max_size");
+  if (G()->close_flag() || max_user_count <= 0 || !G()->use_chat_info_database()) {
+    return;
+  }
+
+  auto evicted_user_ids =
+      evicted_users_.evict(users_, static_cast<size_t>(max_user_count),
+                           [this](const UserId &user_id, const User *u) { return can_evict_user(user_id, u); });
+  for (auto user_id : evicted_user_ids) {
+    users_.erase(user_id);
+    user_photos_.erase(user_id);
+    loaded_from_database_users_.erase(user_id);
+  }
+  LOG(INFO) << "Evict " << evicted_user_ids.size() << " users; " << evicted_users_.size() << " users are evicted";
+}
+
 void UserManager::save_user(User *u, UserId user_id, bool from_binlog) {
   if (!G()->use_chat_info_database()) {
     return;
@@ -7628,9 +7688,11 @@ void UserManager::update_user(User *u, UserId user_id, bool from_binlog, bool fr
       u->is_status_saved = false;
     }
     CHECK(u->is_update_user_sent);
-    send_closure(
-        G()->td(), &Td::send_update,
-        td_api::make_object<td_api::updateUserStatus>(user_id.get(), get_user_status_object(user_id, u, unix_time)));
+    if (td_->is_update_needed(td_api::updateUserStatus::ID)) {
+      send_closure(
+          G()->td(), &Td::send_update,
+          td_api::make_object<td_api::updateUserStatus>(user_id.get(), get_user_status_object(user_id, u, unix_time)));
+    }
     u->is_status_changed = false;
   }
   if (u->is_online_status_changed) {
@@ -8048,6 +8110,15 @@ td_api::object_ptr<td_api::secretChat> UserManager::get_secret_chat_object_const
                                                  secret_chat->is_outbound, secret_chat->key_hash, secret_chat->layer);
 }
 
+void UserManager::memory_stats(MemoryStatistics &statistics) const {
+  Slice manager_name = "UserManager";
+  statistics.add_hash_map<UserId, User>(manager_name, "user", users_.calc_size());
+  statistics.add(manager_name, "evicted_user", evicted_users_.size(), evicted_users_.size() * 2 * sizeof(UserId));
+  statistics.add_hash_map<UserId, UserFull>(manager_name, "user_full", users_full_.calc_size());
+  statistics.add_hash_map<UserId, UserPhotos>(manager_name, "user_photos", user_photos_.calc_size());
+  statistics.add_hash_map<SecretChatId, SecretChat>(manager_name, "secret_chat", secret_chats_.calc_size());
+}
+
 void UserManager::get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const {
   for (auto user_id : unknown_users_) {
     if (!have_min_user(user_id)) {
@@ -8063,6 +8134,13 @@ void UserManager::get_current_state(vector<td_api::object_ptr<td_api::Update>> &
   users_.foreach([&](const UserId &user_id, const unique_ptr<User> &user) {
     updates.push_back(get_update_user_object(user_id, user.get()));
   });
+  // evicted users are known to the client, so they are sent as stored in the database without loading them to memory
+  evicted_users_.foreach([&](const UserId &user_id) {
+    User user;
+    if (log_event_parse(user, G()->td_db()->get_sqlite_sync_pmc()->get(get_user_database_key(user_id))).is_ok()) {
+      updates.push_back(get_update_user_object(user_id, &user));
+    }
+  });
   // secret chat objects contain user_id, so they must be sent after users
   secret_chats_.foreach([&](const SecretChatId &secret_chat_id, const unique_ptr<SecretChat> &secret_chat) {
     updates.push_back(
@@ -12,6 +12,7 @@
 #include "td/telegram/BotCommand.h"
 #include "td/telegram/BotMenuButton.h"
 #include "td/telegram/ChannelId.h"
+#include "td/telegram/ColdObjectEvictor.h"
 #include "td/telegram/Contact.h"
 #include "td/telegram/CustomEmojiId.h"
 #include "td/telegram/DialogId.h"
@@ -62,6 +63,7 @@ class BusinessGreetingMessage;
 class BusinessInfo;
 class BusinessIntro;
 class BusinessWorkHours;
+class MemoryStatistics;
 class Td;
 
 class UserManager final : public Actor {
@@ -467,6 +469,8 @@ class UserManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void memory_stats(MemoryStatistics &statistics) const;
+
  private:
   struct User {
     string first_name;
@@ -555,6 +559,8 @@ class UserManager final : public Actor {
 
     bool is_received_from_server = false;  // true, if the user was received from the server and not the database
 
+    mutable bool is_recently_used = true;  // whether the user was accessed since the last user cache reduction
+
     uint64 log_event_id = 0;
 
     template <class StorerT>
@@ -737,6 +743,12 @@ class UserManager final : public Actor {
 
   User *add_user(UserId user_id);
 
+  User *reload_evicted_user(UserId user_id);
+
+  bool can_evict_user(UserId user_id, const User *u) const;
+
+  void reduce_user_cache();
+
   void save_user(User *u, UserId user_id, bool from_binlog);
 
   static string get_user_database_key(UserId user_id);
@@ -1029,6 +1041,10 @@ class UserManager final : public Actor {
 
   FlatHashMap<UserId, vector<Promise<Unit>>, UserIdHash> load_user_from_database_queries_;
   FlatHashSet<UserId, UserIdHash> loaded_from_database_users_;
+
+  // users, which were removed from memory and are reloaded from the database on access from non-const methods
+  ColdObjectEvictor<UserId, UserIdHash> evicted_users_;
+  bool is_user_cache_reduce_scheduled_ = false;
   FlatHashSet<UserId, UserIdHash> unavailable_user_fulls_;
 
   FlatHashMap<SecretChatId, vector<Promise<Unit>>, SecretChatIdHash> load_secret_chat_from_database_queries_;
@@ -1082,7 +1098,7 @@ class UserManager final : public Actor {
   int32 next_contacts_sync_date_ = 0;
   Hints contacts_hints_;  // search contacts by first name, last name and usernames
   vector<Promise<Unit>> load_contacts_queries_;
-  MultiPromiseActor load_contact_users_multipromise_{"LoadContactUsersMultiPromiseActor"};
+  MultiPromiseCounter load_contact_users_multipromise_{"LoadContactUsersMultiPromiseCounter", this};
   int32 saved_contact_count_ = -1;
 
   int32 was_online_local_ = 0;
@@ -1090,7 +1106,7 @@ class UserManager final : public Actor {
 
   bool are_imported_contacts_loaded_ = false;
   vector<Promise<Unit>> load_imported_contacts_queries_;
-  MultiPromiseActor load_imported_contact_users_multipromise_{"LoadImportedContactUsersMultiPromiseActor"};
+  MultiPromiseCounter load_imported_contact_users_multipromise_{"LoadImportedContactUsersMultiPromiseCounter", this};
   vector<Contact> all_imported_contacts_;
   bool are_imported_contacts_changing_ = false;
   bool need_clear_imported_contacts_ = false;
@@ -0,0 +1,109 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/WebPageBlock.h"
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/StringBuilder.h"
+#include "td/utils/tl_helpers.h"
+
+namespace td {
+
+// instant view of a web page; page blocks are stored after all other fields,
+// so the header can be parsed without decoding of the page blocks
+class WebPageInstantView {
+ public:
+  vector<unique_ptr<WebPageBlock>> page_blocks_;
+  string url_;
+  int32 view_count_ = 0;
+  int32 hash_ = 0;
+  bool is_v2_ = false;
+  bool is_rtl_ = false;
+  bool is_empty_ = true;
+  bool is_full_ = false;
+  bool is_loaded_ = false;
+  bool was_loaded_from_database_ = false;
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    using ::td::store;
+    bool has_url = !url_.empty();
+    bool has_view_count = view_count_ > 0;
+    BEGIN_STORE_FLAGS();
+    STORE_FLAG(is_full_);
+    STORE_FLAG(is_loaded_);
+    STORE_FLAG(is_rtl_);
+    STORE_FLAG(is_v2_);
+    STORE_FLAG(has_url);
+    STORE_FLAG(has_view_count);
+    STORE_FLAG(true);  // is_header_first
+    END_STORE_FLAGS();
+
+    store(hash_, storer);
+    if (has_url) {
+      store(url_, storer);
+    }
+    if (has_view_count) {
+      store(view_count_, storer);
+    }
+    store(page_blocks_, storer);
+    CHECK(!is_empty_);
+  }
+
+  // parses everything except page blocks; returns false if page blocks must be parsed first
+  template <class ParserT>
+  bool parse_header(ParserT &parser) {
+    using ::td::parse;
+    bool has_url;
+    bool has_view_count;
+    bool is_header_first;
+    BEGIN_PARSE_FLAGS();
+    PARSE_FLAG(is_full_);
+    PARSE_FLAG(is_loaded_);
+    PARSE_FLAG(is_rtl_);
+    PARSE_FLAG(is_v2_);
+    PARSE_FLAG(has_url);
+    PARSE_FLAG(has_view_count);
+    PARSE_FLAG(is_header_first);
+    END_PARSE_FLAGS();
+
+    if (!is_header_first) {
+      parse(page_blocks_, parser);
+    }
+    parse(hash_, parser);
+    if (has_url) {
+      parse(url_, parser);
+    }
+    if (has_view_count) {
+      parse(view_count_, parser);
+    }
+    is_empty_ = false;
+    return is_header_first;
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    if (parse_header(parser)) {
+      ::td::parse(page_blocks_, parser);
+    }
+  }
+
+  friend StringBuilder &operator<<(StringBuilder &string_builder,
+                                   const WebPageInstantView &instant_view) {
+    return string_builder << "InstantView(URL = " << instant_view.url_
+                          << ", size = " << instant_view.page_blocks_.size()
+                          << ", view_count = " << instant_view.view_count_ << ", hash = " << instant_view.hash_
+                          << ", is_empty = " << instant_view.is_empty_ << ", is_v2 = " << instant_view.is_v2_
+                          << ", is_rtl = " << instant_view.is_rtl_ << ", is_full = " << instant_view.is_full_
+                          << ", is_loaded = " << instant_view.is_loaded_
+                          << ", was_loaded_from_database = " << instant_view.was_loaded_from_database_ << ")";
+  }
+};
+
+}  // namespace td
@@ -41,6 +41,7 @@
 #include "td/telegram/VideosManager.h"
 #include "td/telegram/VoiceNotesManager.h"
 #include "td/telegram/WebPageBlock.h"
+#include "td/telegram/WebPageInstantView.h"
 
 #include "td/db/binlog/BinlogEvent.h"
 #include "td/db/binlog/BinlogHelper.h"
@@ -153,81 +154,6 @@ class GetWebPageQuery final : public Td::ResultHandler {
   }
 };
 
-class WebPagesManager::WebPageInstantView {
- public:
-  vector<unique_ptr<WebPageBlock>> page_blocks_;
-  string url_;
-  int32 view_count_ = 0;
-  int32 hash_ = 0;
-  bool is_v2_ = false;
-  bool is_rtl_ = false;
-  bool is_empty_ = true;
-  bool is_full_ = false;
-  bool is_loaded_ = false;
-  bool was_loaded_from_database_ = false;
-
-  template <class StorerT>
-  void store(StorerT &storer) const {
-    using ::td::store;
-    bool has_url = !url_.empty();
-    bool has_view_count = view_count_ > 0;
-    BEGIN_STORE_FLAGS();
-    STORE_FLAG(is_full_);
-    STORE_FLAG(is_loaded_);
-    STORE_FLAG(is_rtl_);
-    STORE_FLAG(is_v2_);
-    STORE_FLAG(has_url);
-    STORE_FLAG(has_view_count);
-    END_STORE_FLAGS();
-
-    store(page_blocks_, storer);
-    store(hash_, storer);
-    if (has_url) {
-      store(url_, storer);
-    }
-    if (has_view_count) {
-      store(view_count_, storer);
-    }
-    CHECK(!is_empty_);
-  }
-
-  template <class ParserT>
-  void parse(ParserT &parser) {
-    using ::td::parse;
-    bool has_url;
-    bool has_view_count;
-    BEGIN_PARSE_FLAGS();
-    PARSE_FLAG(is_full_);
-    PARSE_FLAG(is_loaded_);
-    PARSE_FLAG(is_rtl_);
-    PARSE_FLAG(is_v2_);
-    PARSE_FLAG(has_url);
-    PARSE_FLAG(has_view_count);
-    END_PARSE_FLAGS();
-
-    parse(page_blocks_, parser);
-    parse(hash_, parser);
-    if (has_url) {
-      parse(url_, parser);
-    }
-    if (has_view_count) {
-      parse(view_count_, parser);
-    }
-    is_empty_ = false;
-  }
-
-  friend StringBuilder &operator<<(StringBuilder &string_builder,
-                                   const WebPagesManager::WebPageInstantView &instant_view) {
-    return string_builder << "InstantView(URL = " << instant_view.url_
-                          << ", size = " << instant_view.page_blocks_.size()
-                          << ", view_count = " << instant_view.view_count_ << ", hash = " << instant_view.hash_
-                          << ", is_empty = " << instant_view.is_empty_ << ", is_v2 = " << instant_view.is_v2_
-                          << ", is_rtl = " << instant_view.is_rtl_ << ", is_full = " << instant_view.is_full_
-                          << ", is_loaded = " << instant_view.is_loaded_
-                          << ", was_loaded_from_database = " << instant_view.was_loaded_from_database_ << ")";
-  }
-};
-
 class WebPagesManager::WebPage {
  public:
   string url_;
@@ -1121,6 +1047,28 @@ void WebPagesManager::on_load_web_page_instant_view_from_database(WebPageId web_
     return;
   }
 
+  if (!value.empty() && web_page_instant_view.is_loaded_ && !web_page_instant_view.is_empty_) {
+    // the page blocks are needed only if the instant view from the database will be used
+    WebPageInstantView header;
+    LogEventParser parser(value);
+    if (header.parse_header(parser) && parser.get_error() == nullptr) {
+      header.was_loaded_from_database_ = true;
+      bool use_old = need_use_old_instant_view(web_page_instant_view, header);
+      bool is_same = header.hash_ == web_page_instant_view.hash_ && header.is_full_ == web_page_instant_view.is_full_;
+      if (!use_old || is_same) {
+        LOG(INFO) << "Skip parsing of page blocks of " << web_page_id << " instant view from database";
+        if (use_old) {
+          // the database contains the same instant view
+          web_page_instant_view.was_loaded_from_database_ = true;
+        } else {
+          update_web_page_instant_view(web_page_id, web_page_instant_view, std::move(header));
+        }
+        update_web_page_instant_view_load_requests(web_page_id, false, web_page_id);
+        return;
+      }
+    }
+  }
+
   WebPageInstantView instant_view;
   if (!value.empty()) {
     auto status = log_event_parse(instant_view, value);
@@ -1612,7 +1560,7 @@ const WebPagesManager::WebPage *WebPagesManager::get_web_page(WebPageId web_page
   return web_pages_.get_pointer(web_page_id);
 }
 
-const WebPagesManager::WebPageInstantView *WebPagesManager::get_web_page_instant_view(WebPageId web_page_id) const {
+const WebPageInstantView *WebPagesManager::get_web_page_instant_view(WebPageId web_page_id) const {
   const WebPage *web_page = get_web_page(web_page_id);
   if (web_page == nullptr || web_page->instant_view_.is_empty_) {
     return nullptr;
@@ -37,6 +37,8 @@ struct BinlogEvent;
 
 class Td;
 
+class WebPageInstantView;
+
 class WebPagesManager final : public Actor {
  public:
   WebPagesManager(Td *td, ActorShared<> parent);
@@ -118,8 +120,6 @@ class WebPagesManager final : public Actor {
  private:
   class WebPage;
 
-  class WebPageInstantView;
-
   class WebPageLogEvent;
 
   void update_web_page(unique_ptr<WebPage> web_page, WebPageId web_page_id, bool from_binlog, bool from_database);
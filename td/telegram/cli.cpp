@@ -3555,6 +3555,8 @@ class CliClient final : public Actor {
       send_request(td_api::make_object<td_api::getStorageStatisticsFast>());
     } else if (op == "database") {
       send_request(td_api::make_object<td_api::getDatabaseStatistics>());
+    } else if (op == "memory") {
+      send_request(td_api::make_object<td_api::getMemoryStatistics>());
     } else if (op == "optimize_storage" || op == "optimize_storage_all") {
       string chat_ids;
       string exclude_chat_ids;
@@ -3591,6 +3593,10 @@ class CliClient final : public Actor {
       send_request(td_api::make_object<td_api::getNetworkStatistics>());
     } else if (op == "current_network") {
       send_request(td_api::make_object<td_api::getNetworkStatistics>(true));
+    } else if (op == "network_latency") {
+      send_request(td_api::make_object<td_api::getNetworkRequestLatencyStatistics>(false));
+    } else if (op == "network_latency_prometheus") {
+      send_request(td_api::make_object<td_api::getNetworkRequestLatencyStatistics>(true));
     } else if (op == "reset_network") {
       send_request(td_api::make_object<td_api::resetNetworkStatistics>());
     } else if (op == "snt") {
@@ -3937,6 +3943,12 @@ class CliClient final : public Actor {
       int64 count;
       get_args(args, file_id, offset, count);
       send_request(td_api::make_object<td_api::readFilePart>(file_id, offset, count));
+    } else if (op == "gfpl") {
+      FileId file_id;
+      int64 offset;
+      int64 count;
+      get_args(args, file_id, offset, count);
+      send_request(td_api::make_object<td_api::getFilePartLocation>(file_id, offset, count));
     } else if (op == "grf") {
       send_request(td_api::make_object<td_api::getRemoteFile>(args, nullptr));
     } else if (op == "gmtf") {
@@ -6999,6 +7011,12 @@ class CliClient final : public Actor {
       execute(td_api::make_object<td_api::setLogVerbosityLevel>(new_verbosity_level));
     } else if (op == "glvl") {
       execute(td_api::make_object<td_api::getLogVerbosityLevel>());
+    } else if (op == "slrvl") {
+      int32 new_verbosity_level;
+      get_args(args, new_verbosity_level);
+      execute(td_api::make_object<td_api::setLogRecordingVerbosityLevel>(new_verbosity_level));
+    } else if (op == "drlm") {
+      execute(td_api::make_object<td_api::dumpRecordedLogMessages>());
     } else if (op == "gtags" || op == "glt") {
       execute(td_api::make_object<td_api::getLogTags>());
     } else if (op == "sltvl" || op == "sltvle" || op == "tag") {
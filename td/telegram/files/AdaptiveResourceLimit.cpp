@@ -0,0 +1,86 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/AdaptiveResourceLimit.h"
+
+#include "td/utils/misc.h"
+
+namespace td {
+
+constexpr double AdaptiveResourceLimit::SAMPLE_PERIOD;
+constexpr size_t AdaptiveResourceLimit::SAMPLE_COUNT;
+constexpr int64 AdaptiveResourceLimit::MIN_LIMIT;
+constexpr int64 AdaptiveResourceLimit::MAX_LIMIT;
+constexpr size_t AdaptiveResourceLimit::PROBE_PERIOD;
+
+void AdaptiveResourceLimit::on_transferred(int64 size) {
+  if (size > 0) {
+    sample_transferred_ += size;
+  }
+}
+
+void AdaptiveResourceLimit::on_delay(double delay) {
+  if (delay <= 0.0) {
+    return;
+  }
+  if (sample_min_delay_ == 0.0 || delay < sample_min_delay_) {
+    sample_min_delay_ = delay;
+  }
+}
+
+bool AdaptiveResourceLimit::update(double now) {
+  if (sample_start_time_ == 0.0) {
+    sample_start_time_ = now;
+    return false;
+  }
+  auto passed_time = now - sample_start_time_;
+  if (passed_time < SAMPLE_PERIOD) {
+    return false;
+  }
+
+  bool has_sample = sample_transferred_ > 0 && sample_min_delay_ > 0.0;
+  if (has_sample) {
+    Sample sample;
+    sample.bandwidth_ = static_cast<double>(sample_transferred_) / passed_time;
+    sample.delay_ = sample_min_delay_;
+    if (samples_.size() < SAMPLE_COUNT) {
+      samples_.push_back(sample);
+    } else {
+      samples_[next_sample_pos_] = sample;
+      next_sample_pos_ = (next_sample_pos_ + 1) % SAMPLE_COUNT;
+    }
+  }
+
+  sample_start_time_ = now;
+  sample_transferred_ = 0;
+  sample_min_delay_ = 0.0;
+  if (!has_sample) {
+    return false;
+  }
+
+  auto old_limit = get_limit();
+
+  // the maximum bandwidth and the minimum delay are the least affected by queueing
+  // while the link isn't saturated, the bandwidth is limit / delay and the limit doubles;
+  // after the link is saturated, the bandwidth stops growing and probes keep the minimum delay close to the real one
+  double max_bandwidth = 0.0;
+  double min_delay = samples_[0].delay_;
+  for (auto &it : samples_) {
+    max_bandwidth = max(max_bandwidth, it.bandwidth_);
+    min_delay = min(min_delay, it.delay_);
+  }
+  limit_ = clamp(static_cast<int64>(2 * max_bandwidth * min_delay), MIN_LIMIT, MAX_LIMIT);
+
+  sample_count_++;
+  is_probing_ = sample_count_ % PROBE_PERIOD == 0;
+  return get_limit() != old_limit;
+}
+
+int64 AdaptiveResourceLimit::get_probe_limit() const {
+  return max(limit_ / 4, MIN_LIMIT);
+}
+
+}  // namespace td
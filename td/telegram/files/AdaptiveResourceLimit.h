@@ -0,0 +1,57 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// chooses a limit on bytes in flight equal to twice the estimated bandwidth-delay product
+// bandwidth is measured as the number of transferred bytes per sample period, and delay is measured per part;
+// once in PROBE_PERIOD samples the limit is lowered for one sample to measure the delay without queueing
+class AdaptiveResourceLimit {
+ public:
+  static constexpr double SAMPLE_PERIOD = 1.0;
+  static constexpr size_t SAMPLE_COUNT = 10;
+  static constexpr int64 MIN_LIMIT = 1 << 19;
+  static constexpr int64 MAX_LIMIT = 1 << 27;
+  static constexpr size_t PROBE_PERIOD = 10;
+
+  explicit AdaptiveResourceLimit(int64 limit) : limit_(limit) {
+  }
+
+  void on_transferred(int64 size);
+
+  void on_delay(double delay);
+
+  // returns true, if the limit has changed
+  bool update(double now);
+
+  int64 get_limit() const {
+    return is_probing_ ? get_probe_limit() : limit_;
+  }
+
+ private:
+  struct Sample {
+    double bandwidth_ = 0.0;  // bytes per second
+    double delay_ = 0.0;      // seconds
+  };
+  vector<Sample> samples_;
+  size_t next_sample_pos_ = 0;
+
+  int64 limit_ = 0;
+  size_t sample_count_ = 0;
+  bool is_probing_ = false;
+
+  double sample_start_time_ = 0.0;
+  int64 sample_transferred_ = 0;
+  double sample_min_delay_ = 0.0;
+
+  int64 get_probe_limit() const;
+};
+
+}  // namespace td
@@ -20,9 +20,13 @@
 
 #include "td/actor/actor.h"
 
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/format.h"
+#include "td/utils/List.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/optional.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
@@ -65,6 +69,7 @@ class FileDb final : public FileDbInterface {
     }
 
     void close(Promise<> promise) {
+      do_flush();
       file_kv_safe_.reset();
       LOG(INFO) << "FileDb is closed";
       promise.set_value(Unit());
@@ -72,96 +77,181 @@ class FileDb final : public FileDbInterface {
     }
 
     void load_file_data(const string &key, Promise<FileData> promise) {
-      promise.set_result(load_file_data_impl(actor_id(this), file_pmc(), key, max_file_db_id_));
+      promise.set_result(load_file_data_impl(
+          actor_id(this), [this](const string &value_key) { return get_value(value_key); }, key, max_file_db_id_));
     }
 
     void clear_file_data(FileDbId file_db_id, const string &remote_key, const string &local_key,
                          const string &generate_key) {
-      auto &pmc = file_pmc();
-      pmc.begin_write_transaction().ensure();
-
       if (file_db_id > max_file_db_id_) {
-        pmc.set("file_id", to_string(file_db_id.get()));
+        set_value("file_id", to_string(file_db_id.get()));
         max_file_db_id_ = file_db_id;
       }
 
-      pmc.erase(PSTRING() << "file" << file_db_id.get());
+      erase_value(PSTRING() << "file" << file_db_id.get());
       // LOG(DEBUG) << "ERASE " << format::as_hex_dump<4>(Slice(PSLICE() << "file" << file_db_id.get()));
 
       if (!remote_key.empty()) {
-        pmc.erase(remote_key);
+        erase_value(remote_key);
         // LOG(DEBUG) << "ERASE remote " << format::as_hex_dump<4>(Slice(remote_key));
       }
       if (!local_key.empty()) {
-        pmc.erase(local_key);
+        erase_value(local_key);
         // LOG(DEBUG) << "ERASE local " << format::as_hex_dump<4>(Slice(local_key));
       }
       if (!generate_key.empty()) {
-        pmc.erase(generate_key);
+        erase_value(generate_key);
       }
 
-      pmc.commit_transaction().ensure();
+      on_write();
     }
 
-    void store_file_data(FileDbId file_db_id, const string &file_data, const string &remote_key,
-                         const string &local_key, const string &generate_key) {
-      auto &pmc = file_pmc();
-      pmc.begin_write_transaction().ensure();
-
+    void store_file_data(FileDbId file_db_id, string file_data, const string &remote_key, const string &local_key,
+                         const string &generate_key) {
       if (file_db_id > max_file_db_id_) {
-        pmc.set("file_id", to_string(file_db_id.get()));
+        set_value("file_id", to_string(file_db_id.get()));
         max_file_db_id_ = file_db_id;
       }
 
-      pmc.set(PSTRING() << "file" << file_db_id.get(), file_data);
+      set_value(PSTRING() << "file" << file_db_id.get(), std::move(file_data));
 
       if (!remote_key.empty()) {
-        pmc.set(remote_key, to_string(file_db_id.get()));
+        set_value(remote_key, to_string(file_db_id.get()));
       }
       if (!local_key.empty()) {
-        pmc.set(local_key, to_string(file_db_id.get()));
+        set_value(local_key, to_string(file_db_id.get()));
       }
       if (!generate_key.empty()) {
-        pmc.set(generate_key, to_string(file_db_id.get()));
+        set_value(generate_key, to_string(file_db_id.get()));
       }
 
-      pmc.commit_transaction().ensure();
+      on_write();
     }
 
     void store_file_data_ref(FileDbId file_db_id, FileDbId new_file_db_id) {
-      auto &pmc = file_pmc();
-      pmc.begin_write_transaction().ensure();
-
       if (file_db_id > max_file_db_id_) {
-        pmc.set("file_id", to_string(file_db_id.get()));
+        set_value("file_id", to_string(file_db_id.get()));
         max_file_db_id_ = file_db_id;
       }
 
       do_store_file_data_ref(file_db_id, new_file_db_id);
 
-      pmc.commit_transaction().ensure();
+      on_write();
     }
 
     void optimize_refs(std::vector<FileDbId> file_db_ids, FileDbId main_file_db_id) {
       LOG(INFO) << "Optimize " << file_db_ids.size() << " file_db_ids in file database to " << main_file_db_id.get();
-      auto &pmc = file_pmc();
-      pmc.begin_write_transaction().ensure();
       for (size_t i = 0; i + 1 < file_db_ids.size(); i++) {
         do_store_file_data_ref(file_db_ids[i], main_file_db_id);
       }
-      pmc.commit_transaction().ensure();
+      on_write();
     }
 
    private:
+    static constexpr size_t MAX_PENDING_WRITE_COUNT = 300;
+    static constexpr double MAX_PENDING_WRITE_DELAY = 0.01;
+    static constexpr size_t MAX_CACHED_VALUE_COUNT = 10000;
+
     FileDbId max_file_db_id_;
     std::shared_ptr<SqliteKeyValueSafe> file_kv_safe_;
 
+    // changed values, which will be written to the database in one transaction; empty optional means erased value
+    FlatHashMap<string, optional<string>> pending_writes_;
+    bool has_flush_timeout_ = false;
+
+    // all changes are made by the actor, so the cached values are always up to date
+    struct CachedValue final : public ListNode {
+      string key_;
+      string value_;
+    };
+    FlatHashMap<string, unique_ptr<CachedValue>> cached_values_;
+    ListNode cached_value_lru_;  // the most recently used values are in the beginning
+
     SqliteKeyValue &file_pmc() {
       return file_kv_safe_->get();
     }
 
+    string get_value(const string &key) {
+      auto it = cached_values_.find(key);
+      if (it != cached_values_.end()) {
+        auto *cached_value = it->second.get();
+        cached_value->remove();
+        cached_value_lru_.put(cached_value);
+        return cached_value->value_;
+      }
+      auto value = file_pmc().get(key);
+      cache_value(key, value);
+      return value;
+    }
+
+    void cache_value(const string &key, string value) {
+      auto it = cached_values_.find(key);
+      CachedValue *cached_value;
+      if (it == cached_values_.end()) {
+        if (cached_values_.size() >= MAX_CACHED_VALUE_COUNT) {
+          auto *oldest_value = static_cast<CachedValue *>(cached_value_lru_.get());
+          CHECK(oldest_value != nullptr);
+          cached_values_.erase(oldest_value->key_);
+        }
+        auto new_value = make_unique<CachedValue>();
+        new_value->key_ = key;
+        cached_value = new_value.get();
+        cached_values_.emplace(key, std::move(new_value));
+      } else {
+        cached_value = it->second.get();
+        cached_value->remove();
+      }
+      cached_value->value_ = std::move(value);
+      cached_value_lru_.put(cached_value);
+    }
+
+    void set_value(const string &key, string value) {
+      cache_value(key, value);
+      pending_writes_[key] = std::move(value);
+    }
+
+    void erase_value(const string &key) {
+      cache_value(key, string());
+      pending_writes_[key] = optional<string>();
+    }
+
+    void on_write() {
+      if (pending_writes_.size() >= MAX_PENDING_WRITE_COUNT) {
+        do_flush();
+      } else if (!has_flush_timeout_) {
+        has_flush_timeout_ = true;
+        set_timeout_in(MAX_PENDING_WRITE_DELAY);
+      }
+    }
+
+    void do_flush() {
+      if (has_flush_timeout_) {
+        has_flush_timeout_ = false;
+        cancel_timeout();
+      }
+      if (pending_writes_.empty()) {
+        return;
+      }
+      auto &pmc = file_pmc();
+      pmc.begin_write_transaction().ensure();
+      for (auto &it : pending_writes_) {
+        if (it.second) {
+          pmc.set(it.first, it.second.value());
+        } else {
+          pmc.erase(it.first);
+        }
+      }
+      pmc.commit_transaction().ensure();
+      pending_writes_.clear();
+    }
+
+    void timeout_expired() final {
+      has_flush_timeout_ = false;
+      do_flush();
+    }
+
     void do_store_file_data_ref(FileDbId file_db_id, FileDbId new_file_db_id) {
-      file_pmc().set(PSTRING() << "file" << file_db_id.get(), PSTRING() << "@@" << new_file_db_id.get());
+      set_value(PSTRING() << "file" << file_db_id.get(), PSTRING() << "@@" << new_file_db_id.get());
     }
   };
 
@@ -187,7 +277,9 @@ class FileDb final : public FileDbInterface {
   }
 
   Result<FileData> get_file_data_sync_impl(string key) final {
-    return load_file_data_impl(file_db_actor_.get(), file_kv_safe_->get(), key, max_file_db_id_);
+    auto &pmc = file_kv_safe_->get();
+    return load_file_data_impl(
+        file_db_actor_.get(), [&pmc](const string &value_key) { return pmc.get(value_key); }, key, max_file_db_id_);
   }
 
   void clear_file_data(FileDbId file_db_id, const FileData &file_data) final {
@@ -240,10 +332,16 @@ class FileDb final : public FileDbInterface {
   FileDbId max_file_db_id_;
   std::shared_ptr<SqliteKeyValueSafe> file_kv_safe_;
 
-  static Result<FileData> load_file_data_impl(ActorId<FileDbActor> file_db_actor_id, SqliteKeyValue &pmc,
+  template <class GetValueT>
+  static Result<FileData> load_file_data_impl(ActorId<FileDbActor> file_db_actor_id, GetValueT &&get_value,
                                               const string &key, FileDbId max_file_db_id) {
     // LOG(DEBUG) << "Load by key " << format::as_hex_dump<4>(Slice(key));
-    TRY_RESULT(file_db_id, get_file_db_id(pmc, key));
+    auto file_db_id_str = get_value(key);
+    // LOG(DEBUG) << "Found ID " << file_db_id_str << " by key " << format::as_hex_dump<4>(Slice(key));
+    if (file_db_id_str.empty()) {
+      return Status::Error("There is no such key in the database");
+    }
+    auto file_db_id = FileDbId(to_integer<uint64>(file_db_id_str));
 
     vector<FileDbId> file_db_ids;
     string data_str;
@@ -255,7 +353,7 @@ class FileDb final : public FileDbInterface {
       }
       attempt_count++;
 
-      data_str = pmc.get(PSTRING() << "file" << file_db_id.get());
+      data_str = get_value(PSTRING() << "file" << file_db_id.get());
       auto data_slice = Slice(data_str);
 
       if (data_slice.substr(0, 2) == "@@") {
@@ -283,15 +381,6 @@ class FileDb final : public FileDbInterface {
     }
     return std::move(data);
   }
-
-  static Result<FileDbId> get_file_db_id(SqliteKeyValue &pmc, const string &key) TD_WARN_UNUSED_RESULT {
-    auto file_db_id_str = pmc.get(key);
-    // LOG(DEBUG) << "Found ID " << file_db_id_str << " by key " << format::as_hex_dump<4>(Slice(key));
-    if (file_db_id_str.empty()) {
-      return Status::Error("There is no such key in the database");
-    }
-    return FileDbId(to_integer<uint64>(file_db_id_str));
-  }
 };
 
 std::shared_ptr<FileDbInterface> create_file_db(std::shared_ptr<SqliteConnectionSafe> connection, int scheduler_id) {
@@ -25,6 +25,7 @@
 #include "td/utils/misc.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/Stat.h"
+#include "td/utils/Promise.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/UInt.h"
@@ -120,6 +121,13 @@ Result<FileLoader::FileInfo> FileDownloader::init() {
        file_type == FileType::VideoStory || (file_type == FileType::Encrypted && size_ > (1 << 20)));
   res.offset = offset_;
   res.limit = limit_;
+  // parts of secret files must be reported as ready in the order of their decryption
+  use_async_part_writes_ =
+      !only_check_ && !encryption_key_.is_secret() && G()->get_option_boolean("use_async_file_writes");
+  if (!is_small_ && !encryption_key_.is_secret() && !remote_.is_web() && !only_check_) {
+    // the server allows to request up to 1 MB at once, if the requested range doesn't cross 1 MB boundary
+    res.max_merged_part_size = 1 << 20;
+  }
   return res;
 }
 
@@ -233,7 +241,8 @@ Result<std::pair<NetQueryPtr, bool>> FileDownloader::start_part(Part part, int32
   // size = min(size + 16, get_part_size());
   // LOG(INFO) << "Ask " << size << " instead of " << part.size;
   //}
-  auto size = get_part_size();
+  // merged parts are always aligned and have a size, which is a power of two multiple of the part size
+  auto size = max(get_part_size(), part.size);
   CHECK(part.size <= size);
 
   callback_->on_start_download();
@@ -285,6 +294,46 @@ Result<std::pair<NetQueryPtr, bool>> FileDownloader::start_part(Part part, int32
   return std::make_pair(std::move(net_query), false);
 }
 
+Status FileDownloader::decrypt_cdn_part(int64 offset, AesCtrState &ctr_state, MutableSlice data) {
+  // the data is decrypted in place, and hashes of the fully received ranges are checked in the same pass,
+  // while the decrypted data is still in the CPU cache
+  static constexpr size_t CHUNK_SIZE = 16 << 10;
+  auto end_offset = offset + static_cast<int64>(data.size());
+  int64 decrypted_offset = offset;
+  auto decrypt_until = [&](int64 until_offset, Sha256State *sha256_state) {
+    while (decrypted_offset < until_offset) {
+      auto size = static_cast<size_t>(min(until_offset - decrypted_offset, static_cast<int64>(CHUNK_SIZE)));
+      auto chunk = data.substr(static_cast<size_t>(decrypted_offset - offset), size);
+      ctr_state.decrypt(chunk, chunk);
+      if (sha256_state != nullptr) {
+        sha256_state->feed(chunk);
+      }
+      decrypted_offset += static_cast<int64>(size);
+    }
+  };
+
+  HashInfo search_info;
+  search_info.offset = offset;
+  for (auto it = hash_info_.lower_bound(search_info);
+       it != hash_info_.end() && it->offset + narrow_cast<int64>(it->size) <= end_offset; ++it) {
+    if (it->size == 0) {
+      continue;
+    }
+    decrypt_until(it->offset, nullptr);
+    Sha256State sha256_state;
+    sha256_state.init();
+    decrypt_until(it->offset + narrow_cast<int64>(it->size), &sha256_state);
+    string hash(32, ' ');
+    sha256_state.extract(hash, true);
+    if (hash != it->hash) {
+      return Status::Error("Hash mismatch");
+    }
+    checked_hash_offsets_.insert(it->offset);
+  }
+  decrypt_until(end_offset, nullptr);
+  return Status::OK();
+}
+
 Status FileDownloader::check_net_query(NetQueryPtr &net_query) {
   if (net_query->is_error()) {
     auto error = net_query->move_as_error();
@@ -299,6 +348,53 @@ Status FileDownloader::check_net_query(NetQueryPtr &net_query) {
 }
 
 Result<size_t> FileDownloader::process_part(Part part, NetQueryPtr net_query) {
+  TRY_RESULT(bytes, get_part_bytes(part, std::move(net_query)));
+  if (bytes.empty()) {
+    return 0;
+  }
+
+  auto slice = bytes.as_slice();
+  TRY_STATUS(acquire_fd());
+  LOG(INFO) << "Receive " << slice.size() << " bytes at offset " << part.offset << " for \"" << path_ << '"';
+  TRY_RESULT(written, fd_.pwrite(slice, part.offset));
+  LOG(INFO) << "Written " << written << " bytes";
+  // may write less than part.size, when size of downloadable file is unknown
+  if (written != slice.size()) {
+    return Status::Error("Failed to save file part to the file");
+  }
+  return written;
+}
+
+Result<bool> FileDownloader::process_part_async(Part part, NetQueryPtr &net_query) {
+  if (!use_async_part_writes_) {
+    return false;
+  }
+  TRY_RESULT(bytes, get_part_bytes(part, std::move(net_query)));
+  if (path_.empty()) {
+    // create the temporary file
+    TRY_STATUS(acquire_fd());
+    try_release_fd();
+  }
+  if (part_writer_.empty()) {
+    part_writer_ = create_actor_on_scheduler<FilePartWriter>("FilePartWriter", G()->get_file_io_scheduler_id(), path_);
+  }
+  auto size = bytes.size();
+  LOG(INFO) << "Receive " << size << " bytes at offset " << part.offset << " for \"" << path_ << '"';
+  send_closure(part_writer_, &FilePartWriter::write_part, part.offset, std::move(bytes),
+               PromiseCreator::lambda([actor_id = actor_id(this), part, size](Result<Unit> result) {
+                 send_closure(actor_id, &FileDownloader::on_part_written, part, size, std::move(result));
+               }));
+  return true;
+}
+
+void FileDownloader::on_part_written(Part part, size_t size, Result<Unit> result) {
+  if (result.is_error()) {
+    return on_part_processed(part, result.move_as_error());
+  }
+  on_part_processed(part, size);
+}
+
+Result<BufferSlice> FileDownloader::get_part_bytes(Part part, NetQueryPtr net_query) {
   TRY_STATUS(check_net_query(net_query));
 
   BufferSlice bytes;
@@ -339,7 +435,7 @@ Result<size_t> FileDownloader::process_part(Part part, NetQueryPtr net_query) {
     return Status::Error("Part size is more than requested");
   }
   if (bytes.empty()) {
-    return 0;
+    return std::move(bytes);
   }
 
   // Encryption
@@ -353,7 +449,7 @@ Result<size_t> FileDownloader::process_part(Part part, NetQueryPtr net_query) {
     string iv = cdn_encryption_iv_;
     as<uint32>(&iv[12]) = offset;
     ctr_state.init(cdn_encryption_key_, iv);
-    ctr_state.decrypt(bytes.as_slice(), bytes.as_mutable_slice());
+    TRY_STATUS(decrypt_cdn_part(part.offset, ctr_state, bytes.as_mutable_slice()));
   }
   if (encryption_key_.is_secret()) {
     LOG_CHECK(next_part_ == part.id) << tag("expected part.id", next_part_) << "!=" << tag("part.id", part.id);
@@ -366,16 +462,10 @@ Result<size_t> FileDownloader::process_part(Part part, NetQueryPtr net_query) {
                     bytes.as_mutable_slice());
   }
 
-  auto slice = bytes.as_slice().substr(0, part.size);
-  TRY_STATUS(acquire_fd());
-  LOG(INFO) << "Receive " << slice.size() << " bytes at offset " << part.offset << " for \"" << path_ << '"';
-  TRY_RESULT(written, fd_.pwrite(slice, part.offset));
-  LOG(INFO) << "Written " << written << " bytes";
-  // may write less than part.size, when size of downloadable file is unknown
-  if (written != slice.size()) {
-    return Status::Error("Failed to save file part to the file");
+  if (bytes.size() > part.size) {
+    bytes.truncate(part.size);
   }
-  return written;
+  return std::move(bytes);
 }
 
 void FileDownloader::on_progress(Progress progress) {
@@ -444,6 +534,12 @@ Result<FileLoader::CheckInfo> FileDownloader::check_loop(int64 checked_prefix_si
         }
         end_offset = ready_prefix_size;
       }
+      if (checked_hash_offsets_.erase(begin_offset) != 0 && end_offset == it->offset + narrow_cast<int64>(it->size)) {
+        // the hash has already been checked after the part was received
+        checked_prefix_size = end_offset;
+        info.changed = true;
+        continue;
+      }
       auto size = narrow_cast<size_t>(end_offset - begin_offset);
       auto slice = BufferSlice(size);
       TRY_STATUS(acquire_fd());
@@ -9,12 +9,18 @@
 #include "td/telegram/files/FileEncryptionKey.h"
 #include "td/telegram/files/FileLoader.h"
 #include "td/telegram/files/FileLocation.h"
+#include "td/telegram/files/FilePartWriter.h"
 #include "td/telegram/net/DcId.h"
 #include "td/telegram/net/NetQuery.h"
 #include "td/telegram/telegram_api.h"
 
+#include "td/actor/actor.h"
+
+#include "td/utils/buffer.h"
 #include "td/utils/common.h"
+#include "td/utils/crypto.h"
 #include "td/utils/port/FileFd.h"
+#include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
 #include <map>
@@ -78,6 +84,7 @@ class FileDownloader final : public FileLoader {
     }
   };
   std::set<HashInfo> hash_info_;
+  std::set<int64> checked_hash_offsets_;
   bool has_hash_query_ = false;
 
   Result<FileInfo> init() final TD_WARN_UNUSED_RESULT;
@@ -87,17 +94,25 @@ class FileDownloader final : public FileLoader {
   Result<std::pair<NetQueryPtr, bool>> start_part(Part part, int32 part_count,
                                                   int64 streaming_offset) final TD_WARN_UNUSED_RESULT;
   Result<size_t> process_part(Part part, NetQueryPtr net_query) final TD_WARN_UNUSED_RESULT;
+  Result<bool> process_part_async(Part part, NetQueryPtr &net_query) final TD_WARN_UNUSED_RESULT;
+  Result<BufferSlice> get_part_bytes(Part part, NetQueryPtr net_query) TD_WARN_UNUSED_RESULT;
+  void on_part_written(Part part, size_t size, Result<Unit> result);
   void on_progress(Progress progress) final;
   FileLoader::Callback *get_callback() final;
   Status process_check_query(NetQueryPtr net_query) final;
   Result<CheckInfo> check_loop(int64 checked_prefix_size, int64 ready_prefix_size, bool is_ready) final;
   void add_hash_info(const std::vector<telegram_api::object_ptr<telegram_api::fileHash>> &hashes);
 
+  bool use_async_part_writes_ = false;
+  ActorOwn<FilePartWriter> part_writer_;
+
   bool keep_fd_ = false;
   void keep_fd_flag(bool keep_fd) final;
   void try_release_fd();
   Status acquire_fd() TD_WARN_UNUSED_RESULT;
 
   Status check_net_query(NetQueryPtr &net_query);
+
+  Status decrypt_cdn_part(int64 offset, AesCtrState &ctr_state, MutableSlice data) TD_WARN_UNUSED_RESULT;
 };
 }  // namespace td
@@ -37,6 +37,7 @@ StringBuilder &operator<<(StringBuilder &string_builder, const FileGcParameters
                         << tag("max_time_from_last_access", parameters.max_time_from_last_access_)
                         << tag("max_file_count", parameters.max_file_count_)
                         << tag("immunity_delay", parameters.immunity_delay_)
+                        << tag("max_removed_file_count", parameters.max_removed_file_count_)
                         << tag("file_types", parameters.file_types_)
                         << tag("owner_dialog_ids", parameters.owner_dialog_ids_)
                         << tag("exclude_owner_dialog_ids", parameters.exclude_owner_dialog_ids_)
@@ -8,6 +8,7 @@
 
 #include "td/telegram/files/FileLocation.h"
 #include "td/telegram/files/FileManager.h"
+#include "td/telegram/files/FileSharedCache.h"
 #include "td/telegram/files/FileType.h"
 #include "td/telegram/Global.h"
 
@@ -17,6 +18,7 @@
 #include "td/utils/misc.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
 #include "td/utils/Time.h"
 
 #include <algorithm>
@@ -82,9 +84,28 @@ void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFi
   }
 
   FileStats new_stats(false, parameters.dialog_limit_ != 0);
-  FileStats removed_stats(false, parameters.dialog_limit_ != 0);
+  FileStats removed_stats(true, parameters.dialog_limit_ != 0);
 
-  auto do_remove_file = [&removed_stats](const FullFileInfo &info) {
+  // the list of files may come from the file index with outdated access time, so it is rechecked before removal
+  auto is_recently_accessed = [](FullFileInfo &info) {
+    auto r_stat = stat(info.path);
+    if (r_stat.is_error()) {
+      return false;
+    }
+    auto access_time = max(r_stat.ok().atime_nsec_, r_stat.ok().mtime_nsec_);
+    if (access_time <= info.atime_nsec + 1000000000) {
+      return false;
+    }
+    info.atime_nsec = access_time;
+    return true;
+  };
+
+  uint32 removed_file_count = 0;
+  auto can_remove_file = [&] {
+    return parameters.max_removed_file_count_ == 0 || removed_file_count < parameters.max_removed_file_count_;
+  };
+  auto do_remove_file = [&removed_stats, &removed_file_count](const FullFileInfo &info) {
+    removed_file_count++;
     removed_stats.add_copy(info);
     auto status = unlink(info.path);
     LOG_IF(WARNING, status.is_error()) << "Failed to unlink file \"" << info.path << "\" during files GC: " << status;
@@ -94,8 +115,13 @@ void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFi
 
   double now = Clocks::system();
 
+  if (parameters.max_removed_file_count_ != 0) {
+    // the least recently used files must be removed first
+    std::sort(files.begin(), files.end(), [](const auto &a, const auto &b) { return a.atime_nsec < b.atime_nsec; });
+  }
+
   // Remove all suitable files with (atime > now - max_time_from_last_access)
-  td::remove_if(files, [&](const FullFileInfo &info) {
+  td::remove_if(files, [&](FullFileInfo &info) {
     if (token_) {
       return false;
     }
@@ -121,7 +147,11 @@ void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFi
       return true;
     }
 
-    if (static_cast<double>(info.atime_nsec) * 1e-9 < now - parameters.max_time_from_last_access_) {
+    if (static_cast<double>(info.atime_nsec) * 1e-9 < now - parameters.max_time_from_last_access_ &&
+        can_remove_file()) {
+      if (is_recently_accessed(info)) {
+        return false;
+      }
       do_remove_file(info);
       total_removed_size += info.size;
       remove_by_atime_cnt++;
@@ -148,10 +178,15 @@ void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFi
   }
 
   size_t pos = 0;
-  while (pos < files.size() && (remove_count > 0 || remove_size > 0)) {
+  while (pos < files.size() && (remove_count > 0 || remove_size > 0) && can_remove_file()) {
     if (token_) {
       return promise.set_error(Global::request_aborted_error());
     }
+    if (is_recently_accessed(files[pos])) {
+      new_stats.add_copy(files[pos]);
+      pos++;
+      continue;
+    }
     if (remove_count > 0) {
       remove_by_count_cnt++;
     } else {
@@ -191,6 +226,10 @@ void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFi
                  << tag("total_removed_size", format::as_size(total_removed_size));
   }
 
+  if (removed_file_count > 0) {
+    remove_unused_shared_cache_files();
+  }
+
   promise.set_value({std::move(new_stats), std::move(removed_stats)});
 }
 
@@ -20,11 +20,96 @@
 #include "td/utils/misc.h"
 #include "td/utils/PathView.h"
 #include "td/utils/port/FileFd.h"
-#include "td/utils/port/PollFlags.h"
+#include "td/utils/port/MemoryMapping.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
 namespace td {
 
+namespace {
+
+// calculates SHA-256 of a local file outside of the file loader scheduler
+class FileSha256Calculator final : public Actor {
+ public:
+  FileSha256Calculator(string path, int64 size, Promise<string> promise)
+      : path_(std::move(path)), size_(size), promise_(std::move(promise)) {
+  }
+
+ private:
+  static constexpr int64 CHUNK_SIZE = 8 << 20;
+
+  string path_;
+  int64 size_;
+  int64 offset_ = 0;
+  FileFd fd_;
+  Sha256State sha256_state_;
+  BufferSlice buffer_;
+  Promise<string> promise_;
+
+  void start_up() final {
+    auto r_fd = FileFd::open(path_, FileFd::Read);
+    if (r_fd.is_error()) {
+      promise_.set_error(r_fd.move_as_error());
+      return stop();
+    }
+    fd_ = r_fd.move_as_ok();
+    sha256_state_.init();
+    loop();
+  }
+
+  void loop() final {
+    // hash the file by chunks to allow the actor to be stopped in the middle
+    auto status = hash_chunk();
+    if (status.is_error()) {
+      promise_.set_error(std::move(status));
+      return stop();
+    }
+    if (offset_ == size_) {
+      string hash(32, ' ');
+      sha256_state_.extract(hash, true);
+      promise_.set_value(std::move(hash));
+      return stop();
+    }
+    yield();
+  }
+
+  Status hash_chunk() {
+    auto size = min(size_ - offset_, CHUNK_SIZE);
+    if (size == 0) {
+      return Status::OK();
+    }
+    // the mapped file data is hashed without copying it to a buffer
+    auto r_mapping =
+        MemoryMapping::create_from_file(fd_, MemoryMapping::Options().with_offset(offset_).with_size(size));
+    if (r_mapping.is_ok()) {
+      auto data = r_mapping.ok().as_slice();
+      if (data.size() != static_cast<size_t>(size)) {
+        return Status::Error("Unexpected end of file");
+      }
+      sha256_state_.feed(data);
+    } else {
+      if (buffer_.empty()) {
+        buffer_ = BufferSlice(static_cast<size_t>(CHUNK_SIZE));
+      }
+      auto data = buffer_.as_mutable_slice().substr(0, static_cast<size_t>(size));
+      TRY_RESULT(read_size, fd_.pread(data, offset_));
+      if (read_size != data.size()) {
+        return Status::Error("Unexpected end of file");
+      }
+      sha256_state_.feed(data);
+    }
+    offset_ += size;
+    return Status::OK();
+  }
+
+  void tear_down() final {
+    fd_.close();
+  }
+};
+
+}  // namespace
+
 void FileHashUploader::start_up() {
   auto status = init();
   if (status.is_error()) {
@@ -32,19 +117,20 @@ void FileHashUploader::start_up() {
     stop_flag_ = true;
     return;
   }
+  loop();
 }
 
 Status FileHashUploader::init() {
   TRY_RESULT(fd, FileFd::open(local_.path_, FileFd::Read));
   TRY_RESULT(file_size, fd.get_size());
+  fd.close();
   if (file_size != size_) {
     return Status::Error("Size mismatch");
   }
-  fd_ = BufferedFd<FileFd>(std::move(fd));
-  sha256_state_.init();
 
+  // the file is hashed by a separate actor, so download and upload resources aren't needed
   resource_state_.set_unit_size(1024);
-  resource_state_.update_estimated_limit(size_);
+  resource_state_.update_estimated_limit(0);
   return Status::OK();
 }
 
@@ -63,14 +149,17 @@ void FileHashUploader::loop() {
 
 Status FileHashUploader::loop_impl() {
   if (state_ == State::CalcSha) {
-    TRY_STATUS(loop_sha());
+    state_ = State::WaitSha;
+    sha256_calculator_ = create_actor_on_scheduler<FileSha256Calculator>(
+        "FileSha256Calculator", G()->get_gc_scheduler_id(), local_.path_, size_,
+        PromiseCreator::lambda([actor_id = actor_id(this)](Result<string> r_sha256) {
+          send_closure(actor_id, &FileHashUploader::on_sha256_calculated, std::move(r_sha256));
+        }));
   }
   if (state_ == State::NetRequest) {
     // messages.getDocumentByHash#338e2464 sha256:bytes size:long mime_type:string = Document;
-    auto hash = BufferSlice(32);
-    sha256_state_.extract(hash.as_mutable_slice(), true);
     auto mime_type = MimeType::from_extension(PathView(local_.path_).extension(), "image/gif");
-    auto query = telegram_api::messages_getDocumentByHash(std::move(hash), size_, std::move(mime_type));
+    auto query = telegram_api::messages_getDocumentByHash(BufferSlice(sha256_), size_, std::move(mime_type));
     LOG(INFO) << "Send getDocumentByHash request: " << to_string(query);
     auto ptr = G()->net_query_creator().create(query);
     G()->net_query_dispatcher().dispatch_with_callback(std::move(ptr), actor_shared(this));
@@ -79,38 +168,20 @@ Status FileHashUploader::loop_impl() {
   return Status::OK();
 }
 
-Status FileHashUploader::loop_sha() {
-  auto limit = resource_state_.unused();
-  if (limit == 0) {
-    return Status::OK();
-  }
-  if (limit > size_left_) {
-    limit = size_left_;
-  }
-  resource_state_.start_use(limit);
-
-  fd_.get_poll_info().add_flags(PollFlags::Read());
-  TRY_RESULT(read_size, fd_.flush_read(static_cast<size_t>(limit)));
-  if (read_size != static_cast<size_t>(limit)) {
-    return Status::Error("Unexpected end of file");
-  }
-  while (true) {
-    auto ready = fd_.input_buffer().prepare_read();
-    if (ready.empty()) {
-      break;
-    }
-    sha256_state_.feed(ready);
-    fd_.input_buffer().confirm_read(ready.size());
+void FileHashUploader::on_sha256_calculated(Result<string> r_sha256) {
+  sha256_calculator_.release();
+  if (stop_flag_) {
+    return;
   }
-  resource_state_.stop_use(limit);
-
-  size_left_ -= narrow_cast<int64>(read_size);
-  CHECK(size_left_ >= 0);
-  if (size_left_ == 0) {
-    state_ = State::NetRequest;
-    return Status::OK();
+  if (r_sha256.is_error()) {
+    callback_->on_error(r_sha256.move_as_error());
+    stop_flag_ = true;
+    return;
   }
-  return Status::OK();
+  CHECK(state_ == State::WaitSha);
+  sha256_ = r_sha256.move_as_ok();
+  state_ = State::NetRequest;
+  loop();
 }
 
 void FileHashUploader::on_result(NetQueryPtr net_query) {
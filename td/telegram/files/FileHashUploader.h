@@ -12,9 +12,7 @@
 
 #include "td/actor/actor.h"
 
-#include "td/utils/BufferedFd.h"
-#include "td/utils/crypto.h"
-#include "td/utils/port/FileFd.h"
+#include "td/utils/common.h"
 #include "td/utils/Status.h"
 
 namespace td {
@@ -33,7 +31,7 @@ class FileHashUploader final : public FileLoaderActor {
   };
 
   FileHashUploader(const FullLocalFileLocation &local, int64 size, unique_ptr<Callback> callback)
-      : local_(local), size_(size), size_left_(size), callback_(std::move(callback)) {
+      : local_(local), size_(size), callback_(std::move(callback)) {
   }
 
   void set_resource_manager(ActorShared<ResourceManager> resource_manager) final {
@@ -54,18 +52,17 @@ class FileHashUploader final : public FileLoaderActor {
 
  private:
   ResourceState resource_state_;
-  BufferedFd<FileFd> fd_;
 
   FullLocalFileLocation local_;
   int64 size_;
-  int64 size_left_;
   unique_ptr<Callback> callback_;
 
   ActorShared<ResourceManager> resource_manager_;
 
-  enum class State : int32 { CalcSha, NetRequest, WaitNetResult } state_ = State::CalcSha;
+  enum class State : int32 { CalcSha, WaitSha, NetRequest, WaitNetResult } state_ = State::CalcSha;
   bool stop_flag_ = false;
-  Sha256State sha256_state_;
+  ActorOwn<> sha256_calculator_;
+  string sha256_;
 
   void start_up() final;
   Status init();
@@ -74,7 +71,7 @@ class FileHashUploader final : public FileLoaderActor {
 
   Status loop_impl();
 
-  Status loop_sha();
+  void on_sha256_calculated(Result<string> r_sha256);
 
   void on_result(NetQueryPtr net_query) final;
 
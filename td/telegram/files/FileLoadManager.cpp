@@ -6,12 +6,14 @@
 //
 #include "td/telegram/files/FileLoadManager.h"
 
+#include "td/telegram/files/FileSharedCache.h"
 #include "td/telegram/Global.h"
 #include "td/telegram/net/DcId.h"
 
 #include "td/utils/common.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/format.h"
+#include "td/utils/misc.h"
 #include "td/utils/port/path.h"
 #include "td/utils/SliceBuilder.h"
 
@@ -36,7 +38,10 @@ ActorOwn<ResourceManager> &FileLoadManager::get_download_resource_manager(bool i
   if (actor.empty()) {
     actor = create_actor<ResourceManager>(
         PSLICE() << "DownloadResourceManager " << tag("is_small", is_small) << tag("dc_id", dc_id),
-        max_download_resource_limit_, ResourceManager::Mode::Baseline);
+        max_download_resource_limit_, ResourceManager::Mode::Baseline,
+        !is_small && G()->get_option_boolean("use_adaptive_download_limit"),
+        narrow_cast<int32>(clamp(G()->get_option_integer("prefetch_download_share", 100), static_cast<int64>(1),
+                                 static_cast<int64>(100))));
   }
   return actor;
 }
@@ -48,10 +53,19 @@ void FileLoadManager::download(QueryId query_id, const FullRemoteFileLocation &r
   if (stop_flag_) {
     return;
   }
+  auto shared_cache_key = get_shared_file_cache_key(remote_location, size);
+  if (!shared_cache_key.empty() && local.type() == LocalFileLocation::Type::Empty) {
+    auto r_local_location = load_file_from_shared_cache(shared_cache_key, remote_location.file_type_, name);
+    if (r_local_location.is_ok()) {
+      send_closure(callback_, &Callback::on_download_ok, query_id, r_local_location.move_as_ok(), size, true);
+      return;
+    }
+  }
   NodeId node_id = nodes_container_.create(Node());
   Node *node = nodes_container_.get(node_id);
   CHECK(node);
   node->query_id_ = query_id;
+  node->shared_cache_key_ = std::move(shared_cache_key);
   auto callback = make_unique<FileDownloaderCallback>(actor_shared(this, node_id));
   bool is_small = size < 20 * 1024;
   node->loader_ =
@@ -257,6 +271,9 @@ void FileLoadManager::on_ok_download(FullLocalFileLocation local, int64 size, bo
     return;
   }
   if (!stop_flag_) {
+    if (!node->shared_cache_key_.empty()) {
+      save_file_to_shared_cache(node->shared_cache_key_, local);
+    }
     send_closure(callback_, &Callback::on_download_ok, node->query_id_, std::move(local), size, is_new);
   }
   close_node(node_id);
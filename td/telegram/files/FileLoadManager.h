@@ -75,6 +75,7 @@ class FileLoadManager final : public Actor {
     QueryId query_id_;
     ActorOwn<FileLoaderActor> loader_;
     ResourceState resource_state_;
+    string shared_cache_key_;
   };
   using NodeId = uint64;
 
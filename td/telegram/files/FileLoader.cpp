@@ -17,6 +17,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/ScopeGuard.h"
+#include "td/utils/Time.h"
 
 #include <tuple>
 
@@ -81,9 +82,11 @@ void FileLoader::update_downloaded_part(int64 offset, int64 limit, int64 max_res
     auto end_part_id = begin_part_id + td::min(max_parts, new_end_part_id - begin_part_id);
     VLOG(file_loader) << "Protect parts " << begin_part_id << " ... " << end_part_id - 1;
     for (auto &it : part_map_) {
-      if (!it.second.second.empty() && !(begin_part_id <= it.second.first.id && it.second.first.id < end_part_id)) {
-        VLOG(file_loader) << "Cancel part " << it.second.first.id;
-        it.second.second.reset();  // cancel_query(it.second.second);
+      auto &part_query = it.second;
+      if (!part_query.cancel_slot_.empty() &&
+          !(begin_part_id <= part_query.part_.id && part_query.part_.id < end_part_id)) {
+        VLOG(file_loader) << "Cancel part " << part_query.part_.id;
+        part_query.cancel_slot_.reset();  // cancel_query(part_query.cancel_slot_);
       }
     }
   } else {
@@ -132,6 +135,9 @@ void FileLoader::start_up() {
   if (file_info.only_check) {
     parts_manager_.set_checked_prefix_size(0);
   }
+  if (file_info.max_merged_part_size != 0) {
+    parts_manager_.set_max_merged_part_size(file_info.max_merged_part_size);
+  }
   parts_manager_.set_streaming_offset(file_info.offset, file_info.limit);
   if (ordered_flag_) {
     ordered_parts_ = OrderedEventsProcessor<std::pair<Part, NetQueryPtr>>(parts_manager_.get_ready_prefix_count());
@@ -199,7 +205,7 @@ Status FileLoader::do_loop() {
       VLOG(file_loader) << "Receive only " << resource_state_.unused() << " resource";
       break;
     }
-    TRY_RESULT(part, parts_manager_.start_part());
+    TRY_RESULT(part, parts_manager_.start_part(resource_state_.unused()));
     if (part.size == 0) {
       break;
     }
@@ -215,8 +221,10 @@ Status FileLoader::do_loop() {
       CHECK(blocking_id_ == 0);
       blocking_id_ = unique_id;
     }
-    part_map_[unique_id] = std::make_pair(part, query->cancel_slot_.get_signal_new());
-    // part_map_[unique_id] = std::make_pair(part, query.get_weak());
+    auto &part_query = part_map_[unique_id];
+    part_query.part_ = part;
+    part_query.cancel_slot_ = query->cancel_slot_.get_signal_new();
+    part_query.send_time_ = Time::now();
 
     auto callback = actor_shared(this, unique_id);
     if (delay_dispatcher_.empty()) {
@@ -233,7 +241,7 @@ Status FileLoader::do_loop() {
 
 void FileLoader::tear_down() {
   for (auto &it : part_map_) {
-    it.second.second.reset();  // cancel_query(it.second.second);
+    it.second.cancel_slot_.reset();  // cancel_query(it.second.cancel_slot_);
   }
   ordered_parts_.clear([](auto &&part) { part.second->clear(); });
   if (!delay_dispatcher_.empty()) {
@@ -272,9 +280,12 @@ void FileLoader::on_result(NetQueryPtr query) {
     return;
   }
 
-  Part part = it->second.first;
-  it->second.second.release();
+  Part part = it->second.part_;
+  it->second.cancel_slot_.release();
   CHECK(query->is_ready());
+  if (query->is_ok()) {
+    resource_state_.on_delay(Time::now() - it->second.send_time_);
+  }
   part_map_.erase(it);
 
   bool next = false;
@@ -317,11 +328,29 @@ void FileLoader::on_part_query(Part part, NetQueryPtr query) {
     // important for secret files
     return;
   }
-  auto status = try_on_part_query(part, std::move(query));
+  auto r_is_async = process_part_async(part, query);
+  if (r_is_async.is_ok() && r_is_async.ok()) {
+    return;
+  }
+  auto status = r_is_async.is_error() ? r_is_async.move_as_error() : try_on_part_query(part, std::move(query));
+  if (status.is_error()) {
+    on_error(std::move(status));
+    stop_flag_ = true;
+  }
+}
+
+void FileLoader::on_part_processed(Part part, Result<size_t> r_size) {
+  if (stop_flag_) {
+    return;
+  }
+  auto status = r_size.is_error() ? r_size.move_as_error() : on_part_ok(part, r_size.ok());
   if (status.is_error()) {
     on_error(std::move(status));
     stop_flag_ = true;
+    return;
   }
+  update_estimated_limit();
+  loop();
 }
 
 void FileLoader::on_common_query(NetQueryPtr query) {
@@ -334,8 +363,13 @@ void FileLoader::on_common_query(NetQueryPtr query) {
 
 Status FileLoader::try_on_part_query(Part part, NetQueryPtr query) {
   TRY_RESULT(size, process_part(part, std::move(query)));
+  return on_part_ok(part, size);
+}
+
+Status FileLoader::on_part_ok(Part part, size_t size) {
   VLOG(file_loader) << "Ok part " << tag("id", part.id) << tag("size", part.size);
   resource_state_.stop_use(static_cast<int64>(part.size));
+  resource_state_.on_transferred(static_cast<int64>(part.size));
   auto old_ready_prefix_count = parts_manager_.get_unchecked_ready_prefix_count();
   TRY_STATUS(parts_manager_.on_part_ok(part.id, part.size, size));
   auto new_ready_prefix_count = parts_manager_.get_unchecked_ready_prefix_count();
@@ -61,6 +61,7 @@ class FileLoader : public FileLoaderActor {
     int64 offset{0};
     int64 limit{0};
     bool is_upload{false};
+    size_t max_merged_part_size{0};
   };
   virtual Result<FileInfo> init() TD_WARN_UNUSED_RESULT = 0;
   virtual Status on_ok(int64 size) TD_WARN_UNUSED_RESULT = 0;
@@ -73,6 +74,12 @@ class FileLoader : public FileLoaderActor {
   virtual void after_start_parts() {
   }
   virtual Result<size_t> process_part(Part part, NetQueryPtr net_query) TD_WARN_UNUSED_RESULT = 0;
+  // returns true if the part is processed asynchronously instead of process_part;
+  // on_part_processed must be called after the processing is finished in that case
+  virtual Result<bool> process_part_async(Part part, NetQueryPtr &net_query) TD_WARN_UNUSED_RESULT {
+    return false;
+  }
+  void on_part_processed(Part part, Result<size_t> r_size);
   struct Progress {
     int32 part_count{0};
     int32 part_size{0};
@@ -115,7 +122,12 @@ class FileLoader : public FileLoaderActor {
   ResourceState resource_state_;
   PartsManager parts_manager_;
   uint64 blocking_id_{0};
-  std::map<uint64, std::pair<Part, ActorShared<>>> part_map_;
+  struct PartQuery {
+    Part part_;
+    ActorShared<> cancel_slot_;
+    double send_time_ = 0.0;
+  };
+  std::map<uint64, PartQuery> part_map_;
   bool ordered_flag_ = false;
   OrderedEventsProcessor<std::pair<Part, NetQueryPtr>> ordered_parts_;
   ActorOwn<DelayDispatcher> delay_dispatcher_;
@@ -139,6 +151,7 @@ class FileLoader : public FileLoaderActor {
   void on_part_query(Part part, NetQueryPtr query);
   void on_common_query(NetQueryPtr query);
   Status try_on_part_query(Part part, NetQueryPtr query);
+  Status on_part_ok(Part part, size_t size);
 };
 
 }  // namespace td
@@ -14,8 +14,10 @@
 #include "td/telegram/files/FileLoaderUtils.h"
 #include "td/telegram/files/FileLocation.h"
 #include "td/telegram/files/FileLocation.hpp"
+#include "td/telegram/files/ResourceManager.h"
 #include "td/telegram/Global.h"
 #include "td/telegram/logevent/LogEvent.h"
+#include "td/telegram/MemoryStatistics.h"
 #include "td/telegram/misc.h"
 #include "td/telegram/SecureStorage.h"
 #include "td/telegram/TdDb.h"
@@ -898,6 +900,32 @@ FileManager::~FileManager() {
       local_location_to_file_id_, generate_location_to_file_id_, file_id_info_, empty_file_ids_, file_nodes_);
 }
 
+void FileManager::memory_stats(MemoryStatistics &statistics) const {
+  Slice manager_name = "FileManager";
+  size_t file_node_count = 0;
+  for (size_t i = 0; i < file_nodes_.size(); i++) {
+    if (file_nodes_[i] != nullptr) {
+      file_node_count++;
+    }
+  }
+  statistics.add(manager_name, "file_node", file_node_count,
+                 file_nodes_.size() * sizeof(unique_ptr<FileNode>) + file_node_count * sizeof(FileNode));
+  statistics.add(manager_name, "file_id", file_id_info_.size(), file_id_info_.size() * sizeof(FileIdInfo));
+
+  // a std::map node contains 3 pointers and a color in addition to the value
+  auto get_map_size = [](const auto &map) {
+    return map.size() * (sizeof(typename std::decay_t<decltype(map)>::value_type) + 4 * sizeof(void *));
+  };
+  statistics.add(manager_name, "remote_location", remote_location_info_.size(),
+                 remote_location_info_.size() * (sizeof(RemoteInfo) + 2 * sizeof(void *)) +
+                     get_map_size(remote_location_to_file_id_));
+  statistics.add(manager_name, "local_location", local_location_to_file_id_.size(),
+                 get_map_size(local_location_to_file_id_));
+  statistics.add(manager_name, "generate_location", generate_location_to_file_id_.size(),
+                 get_map_size(generate_location_to_file_id_));
+  statistics.add_hash_map<string, FileId>(manager_name, "file_hash", file_hash_to_file_id_.calc_size());
+}
+
 string FileManager::fix_file_extension(Slice file_name, Slice file_type, Slice file_extension) {
   return PSTRING() << (file_name.empty() ? file_type : file_name) << '.' << file_extension;
 }
@@ -1183,6 +1211,21 @@ FileId FileManager::dup_file_id(FileId file_id, const char *source) {
   return result_file_id;
 }
 
+void FileManager::forget_dup_file_id(FileId file_id, const char *source) {
+  auto node = get_file_node(file_id);
+  if (!node) {
+    return;
+  }
+  LOG(INFO) << "Forget duplicated file " << file_id << " from " << source;
+  auto *file_info = get_file_id_info(file_id);
+  if (file_info->download_priority_ != 0) {
+    file_info->download_priority_ = 0;
+    file_info->download_callback_ = nullptr;
+    run_download(node, false);
+  }
+  try_forget_file_id(file_id);
+}
+
 FileId FileManager::copy_file_id(FileId file_id, FileType file_type, DialogId owner_dialog_id, const char *source) {
   auto file_view = get_file_view(file_id);
   auto download_file_id = dup_file_id(file_id, source);
@@ -1755,6 +1798,7 @@ Status FileManager::merge(FileId x_file_id, FileId y_file_id, bool no_sync) {
     node->download_was_update_file_reference_ = other_node->download_was_update_file_reference_;
     node->is_download_started_ |= other_node->is_download_started_;
     node->set_download_priority(other_node->download_priority_);
+    node->is_background_download_ = other_node->is_background_download_;
     other_node->download_id_ = 0;
     other_node->download_was_update_file_reference_ = false;
     other_node->is_download_started_ = false;
@@ -2265,54 +2309,64 @@ void FileManager::get_content(FileId file_id, Promise<BufferSlice> promise) {
   send_closure(file_load_manager_, &FileLoadManager::get_content, node->local_.full().path_, std::move(promise));
 }
 
-void FileManager::read_file_part(FileId file_id, int64 offset, int64 count, int left_tries,
-                                 Promise<td_api::object_ptr<td_api::filePart>> promise) {
-  TRY_STATUS_PROMISE(promise, G()->close_status());
+Result<FileManager::FilePartInfo> FileManager::get_file_part_info(FileId file_id, int64 offset, int64 count) {
+  TRY_STATUS(G()->close_status());
 
   if (!file_id.is_valid()) {
-    return promise.set_error(Status::Error(400, "File identifier is invalid"));
+    return Status::Error(400, "File identifier is invalid");
   }
   auto node = get_sync_file_node(file_id);
   if (!node) {
-    return promise.set_error(Status::Error(400, "File not found"));
+    return Status::Error(400, "File not found");
   }
   if (offset < 0) {
-    return promise.set_error(Status::Error(400, "Parameter offset must be non-negative"));
+    return Status::Error(400, "Parameter offset must be non-negative");
   }
   if (count < 0) {
-    return promise.set_error(Status::Error(400, "Parameter count must be non-negative"));
+    return Status::Error(400, "Parameter count must be non-negative");
   }
 
   auto file_view = FileView(node);
 
+  FilePartInfo result;
   if (count == 0) {
     count = file_view.downloaded_prefix(offset);
     if (count == 0) {
-      return promise.set_value(td_api::make_object<td_api::filePart>());
+      return std::move(result);
     }
   } else if (file_view.downloaded_prefix(offset) < count) {
     // TODO this check is safer to do in another thread
-    return promise.set_error(Status::Error(400, "There is not enough downloaded bytes in the file to read"));
+    return Status::Error(400, "There is not enough downloaded bytes in the file to read");
   }
   if (count >= static_cast<int64>(std::numeric_limits<size_t>::max() / 2 - 1)) {
-    return promise.set_error(Status::Error(400, "Part length is too big"));
+    return Status::Error(400, "Part length is too big");
   }
 
-  const string *path = nullptr;
-  bool is_partial = false;
   if (file_view.has_local_location()) {
-    path = &file_view.local_location().path_;
-    if (!begins_with(*path, get_files_dir(file_view.get_type()))) {
-      return promise.set_error(Status::Error(400, "File is not inside the cache"));
+    result.path_ = file_view.local_location().path_;
+    if (!begins_with(result.path_, get_files_dir(file_view.get_type()))) {
+      return Status::Error(400, "File is not inside the cache");
     }
   } else {
     CHECK(node->local_.type() == LocalFileLocation::Type::Partial);
-    path = &node->local_.partial().path_;
-    is_partial = true;
+    result.path_ = node->local_.partial().path_;
+    result.is_partial_ = true;
+  }
+  result.count_ = count;
+  return std::move(result);
+}
+
+void FileManager::read_file_part(FileId file_id, int64 offset, int64 count, int left_tries,
+                                 Promise<td_api::object_ptr<td_api::filePart>> promise) {
+  TRY_RESULT_PROMISE(promise, file_part_info, get_file_part_info(file_id, offset, count));
+  if (file_part_info.count_ == 0) {
+    return promise.set_value(td_api::make_object<td_api::filePart>());
   }
+  count = file_part_info.count_;
 
   auto read_file_part_promise =
-      PromiseCreator::lambda([actor_id = actor_id(this), file_id, offset, count, left_tries, is_partial,
+      PromiseCreator::lambda([actor_id = actor_id(this), file_id, offset, count, left_tries,
+                              is_partial = file_part_info.is_partial_,
                               promise = std::move(promise)](Result<string> r_bytes) mutable {
         if (r_bytes.is_error()) {
           LOG(INFO) << "Failed to read file bytes: " << r_bytes.error();
@@ -2335,10 +2389,17 @@ void FileManager::read_file_part(FileId file_id, int64 offset, int64 count, int
           promise.set_value(std::move(result));
         }
       });
-  send_closure(file_load_manager_, &FileLoadManager::read_file_part, *path, offset, count,
+  send_closure(file_load_manager_, &FileLoadManager::read_file_part, std::move(file_part_info.path_), offset, count,
                std::move(read_file_part_promise));
 }
 
+void FileManager::get_file_part_location(FileId file_id, int64 offset, int64 count,
+                                         Promise<td_api::object_ptr<td_api::filePartLocation>> promise) {
+  TRY_RESULT_PROMISE(promise, file_part_info, get_file_part_info(file_id, offset, count));
+  promise.set_value(td_api::make_object<td_api::filePartLocation>(std::move(file_part_info.path_), offset,
+                                                                  file_part_info.count_));
+}
+
 void FileManager::delete_file(FileId file_id, Promise<Unit> promise, const char *source) {
   LOG(INFO) << "Trying to delete file " << file_id << " from " << source;
   auto node = get_sync_file_node(file_id);
@@ -2354,7 +2415,8 @@ void FileManager::delete_file(FileId file_id, Promise<Unit> promise, const char
     if (begins_with(file_view.local_location().path_, get_files_dir(file_view.get_type()))) {
       clear_from_pmc(node);
       if (context_->need_notify_on_new_files()) {
-        context_->on_new_file(-file_view.size(), -file_view.get_allocated_local_size(), -1);
+        context_->on_new_file(-file_view.size(), -file_view.get_allocated_local_size(), -1,
+                              file_view.local_location(), file_view.owner_dialog_id());
       }
       path = std::move(node->local_.full().path_);
     }
@@ -2447,6 +2509,10 @@ void FileManager::download_impl(FileId file_id, std::shared_ptr<DownloadCallback
     }
     new_priority = 0;
   }
+  bool is_background_download = new_priority == BACKGROUND_DOWNLOAD_PRIORITY;
+  if (is_background_download) {
+    new_priority = 1;
+  }
 
   LOG(INFO) << "Change download priority of file " << file_id << " to " << new_priority << " with callback "
             << callback.get();
@@ -2467,6 +2533,7 @@ void FileManager::download_impl(FileId file_id, std::shared_ptr<DownloadCallback
   }
   file_info->ignore_download_limit = limit == IGNORE_DOWNLOAD_LIMIT;
   file_info->download_priority_ = narrow_cast<int8>(new_priority);
+  file_info->is_background_download_ = is_background_download;
   file_info->download_callback_ = std::move(callback);
 
   if (file_info->download_callback_) {
@@ -2484,15 +2551,20 @@ void FileManager::download_impl(FileId file_id, std::shared_ptr<DownloadCallback
 void FileManager::run_download(FileNodePtr node, bool force_update_priority) {
   int8 priority = 0;
   bool ignore_download_limit = false;
+  bool is_background_download = true;
   for (auto id : node->file_ids_) {
     auto *info = get_file_id_info(id);
     if (info->download_priority_ > priority) {
       priority = info->download_priority_;
     }
+    if (info->download_priority_ != 0 && !info->is_background_download_) {
+      is_background_download = false;
+    }
     ignore_download_limit |= info->ignore_download_limit;
   }
 
   auto old_priority = node->download_priority_;
+  auto old_is_background_download = node->is_background_download_;
 
   if (priority == 0) {
     node->set_download_priority(priority);
@@ -2518,6 +2590,8 @@ void FileManager::run_download(FileNodePtr node, bool force_update_priority) {
   }
   node->set_download_priority(priority);
   node->set_ignore_download_limit(ignore_download_limit);
+  node->is_background_download_ = is_background_download;
+  auto load_priority = is_background_download ? ResourceManager::BACKGROUND_PRIORITY : priority;
   bool need_update_offset = node->is_download_offset_dirty_;
   node->is_download_offset_dirty_ = false;
 
@@ -2527,8 +2601,8 @@ void FileManager::run_download(FileNodePtr node, bool force_update_priority) {
   if (old_priority != 0) {
     LOG(INFO) << "Update download offset and limits of file " << node->main_file_id_;
     CHECK(node->download_id_ != 0);
-    if (force_update_priority || priority != old_priority) {
-      send_closure(file_load_manager_, &FileLoadManager::update_priority, node->download_id_, priority);
+    if (force_update_priority || priority != old_priority || is_background_download != old_is_background_download) {
+      send_closure(file_load_manager_, &FileLoadManager::update_priority, node->download_id_, load_priority);
     }
     if (need_update_limit || need_update_offset) {
       auto download_offset = node->download_offset_;
@@ -2609,7 +2683,7 @@ void FileManager::run_download(FileNodePtr node, bool force_update_priority) {
   }
   send_closure(file_load_manager_, &FileLoadManager::download, query_id, node->remote_.full.value(), node->local_,
                node->size_, node->suggested_path(), node->encryption_key_, node->can_search_locally_, download_offset,
-               download_limit, priority);
+               download_limit, load_priority);
 }
 
 class FileManager::ForceUploadActor final : public Actor {
@@ -3851,7 +3925,11 @@ void FileManager::on_download_ok(QueryId query_id, FullLocalFileLocation local,
     status = Status::Error(PSLICE() << "Can't register local file after download: " << r_new_file_id.error().message());
   } else {
     if (is_new && context_->need_notify_on_new_files()) {
-      context_->on_new_file(size, get_file_view(r_new_file_id.ok()).get_allocated_local_size(), 1);
+      auto new_file_view = get_file_view(r_new_file_id.ok());
+      if (new_file_view.has_local_location()) {
+        context_->on_new_file(size, new_file_view.get_allocated_local_size(), 1, new_file_view.local_location(),
+                              new_file_view.owner_dialog_id());
+      }
     }
   }
   if (status.is_error()) {
@@ -4016,7 +4094,8 @@ void FileManager::on_generate_ok(QueryId query_id, FullLocalFileLocation local)
   FileView file_view(file_node);
   if (context_->need_notify_on_new_files()) {
     if (!file_view.has_generate_location() || !begins_with(file_view.generate_location().conversion_, "#file_id#")) {
-      context_->on_new_file(file_view.size(), file_view.get_allocated_local_size(), 1);
+      context_->on_new_file(file_view.size(), file_view.get_allocated_local_size(), 1, file_view.local_location(),
+                            file_view.owner_dialog_id());
     }
   }
 
@@ -48,6 +48,7 @@ extern int VERBOSITY_NAME(update_file);
 
 class FileData;
 class FileDbInterface;
+class MemoryStatistics;
 
 enum class FileLocationSource : int8 { None, FromUser, FromBinlog, FromDatabase, FromServer };
 
@@ -193,6 +194,8 @@ class FileNode {
 
   bool ignore_download_limit_{false};
 
+  bool is_background_download_{false};
+
   void init_ready_size();
 
   void recalc_ready_prefix_size(int64 prefix_offset, int64 ready_prefix_size);
@@ -381,6 +384,8 @@ class FileManager final : public FileLoadManager::Callback {
   static constexpr int64 KEEP_DOWNLOAD_LIMIT = -1;
   static constexpr int64 KEEP_DOWNLOAD_OFFSET = -1;
   static constexpr int64 IGNORE_DOWNLOAD_LIMIT = -2;
+  // download priority below all priorities, which can be specified by the user
+  static constexpr int8 BACKGROUND_DOWNLOAD_PRIORITY = -2;
   class DownloadCallback {
    public:
     DownloadCallback() = default;
@@ -414,7 +419,8 @@ class FileManager final : public FileLoadManager::Callback {
    public:
     virtual bool need_notify_on_new_files() = 0;
 
-    virtual void on_new_file(int64 size, int64 real_size, int32 cnt) = 0;
+    virtual void on_new_file(int64 size, int64 real_size, int32 cnt, const FullLocalFileLocation &location,
+                             DialogId owner_dialog_id) = 0;
 
     virtual void on_file_updated(FileId size) = 0;
 
@@ -453,8 +459,13 @@ class FileManager final : public FileLoadManager::Callback {
 
   void init_actor();
 
+  void memory_stats(MemoryStatistics &statistics) const;
+
   FileId dup_file_id(FileId file_id, const char *source);
 
+  // frees file identifier returned by dup_file_id, if it isn't used anymore
+  void forget_dup_file_id(FileId file_id, const char *source);
+
   FileId copy_file_id(FileId file_id, FileType file_type, DialogId owner_dialog_id, const char *source);
 
   void on_file_unlink(const FullLocalFileLocation &location);
@@ -506,6 +517,9 @@ class FileManager final : public FileLoadManager::Callback {
   void read_file_part(FileId file_id, int64 offset, int64 count, int left_tries,
                       Promise<td_api::object_ptr<td_api::filePart>> promise);
 
+  void get_file_part_location(FileId file_id, int64 offset, int64 count,
+                              Promise<td_api::object_ptr<td_api::filePartLocation>> promise);
+
   void delete_file(FileId file_id, Promise<Unit> promise, const char *source);
 
   void external_file_generate_write_part(int64 generation_id, int64 offset, string data, Promise<> promise);
@@ -569,6 +583,13 @@ class FileManager final : public FileLoadManager::Callback {
 
   static constexpr int8 FROM_BYTES_PRIORITY = 10;
 
+  struct FilePartInfo {
+    string path_;
+    int64 count_ = 0;
+    bool is_partial_ = false;
+  };
+  Result<FilePartInfo> get_file_part_info(FileId file_id, int64 offset, int64 count);
+
   using FileNodeId = int32;
 
   using QueryId = FileLoadManager::QueryId;
@@ -595,6 +616,7 @@ class FileManager final : public FileLoadManager::Callback {
     bool pin_flag_{false};
     bool sent_file_id_flag_{false};
     bool ignore_download_limit{false};
+    bool is_background_download_{false};
 
     int8 download_priority_{0};
     int8 upload_priority_{0};
@@ -0,0 +1,114 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FilePartWriter.h"
+
+#include "td/telegram/files/FileLoaderUtils.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace td {
+
+void FilePartWriter::write_part(int64 offset, BufferSlice bytes, Promise<Unit> promise) {
+  if (pending_parts_.empty()) {
+    // write all parts, which will be received before the wakeup, at once
+    yield();
+  }
+  PendingPart part;
+  part.offset_ = offset;
+  part.bytes_ = std::move(bytes);
+  part.promise_ = std::move(promise);
+  pending_parts_.push_back(std::move(part));
+}
+
+void FilePartWriter::loop() {
+  if (pending_parts_.empty()) {
+    return;
+  }
+  auto parts = std::move(pending_parts_);
+  pending_parts_.clear();
+  std::stable_sort(parts.begin(), parts.end(),
+                   [](const PendingPart &lhs, const PendingPart &rhs) { return lhs.offset_ < rhs.offset_; });
+
+  vector<Status> results(parts.size());
+  auto r_fd = FileFd::open(path_, FileFd::Write);
+  if (r_fd.is_error()) {
+    for (auto &result : results) {
+      result = r_fd.error().clone();
+    }
+  } else {
+    auto fd = r_fd.move_as_ok();
+    size_t write_count = 0;
+    for (size_t begin = 0; begin < parts.size();) {
+      auto end = begin + 1;
+      auto total_size = parts[begin].bytes_.size();
+      while (end < parts.size() &&
+             parts[end].offset_ == parts[end - 1].offset_ + static_cast<int64>(parts[end - 1].bytes_.size()) &&
+             total_size + parts[end].bytes_.size() <= MAX_WRITE_SIZE) {
+        total_size += parts[end].bytes_.size();
+        end++;
+      }
+
+      Slice data = parts[begin].bytes_.as_slice();
+      BufferSlice buffer;
+      if (end != begin + 1) {
+        buffer = BufferSlice(total_size);
+        auto ptr = buffer.as_mutable_slice().begin();
+        for (auto i = begin; i < end; i++) {
+          std::memcpy(ptr, parts[i].bytes_.data(), parts[i].bytes_.size());
+          ptr += parts[i].bytes_.size();
+        }
+        data = buffer.as_slice();
+      }
+
+      Status status;
+      auto offset = parts[begin].offset_;
+      while (!data.empty()) {
+        auto r_written = fd.pwrite(data, offset);
+        if (r_written.is_error()) {
+          status = r_written.move_as_error();
+          break;
+        }
+        auto written = r_written.ok();
+        if (written == 0) {
+          status = Status::Error("Failed to save file part to the file");
+          break;
+        }
+        data.remove_prefix(written);
+        offset += static_cast<int64>(written);
+      }
+      for (auto i = begin; i < end; i++) {
+        results[i] = status.clone();
+      }
+      write_count++;
+      begin = end;
+    }
+    fd.close();
+    VLOG(file_loader) << "Written " << parts.size() << " parts to \"" << path_ << "\" using " << write_count
+                      << " writes";
+  }
+
+  for (size_t i = 0; i < parts.size(); i++) {
+    if (results[i].is_error()) {
+      parts[i].promise_.set_error(std::move(results[i]));
+    } else {
+      parts[i].promise_.set_value(Unit());
+    }
+  }
+}
+
+void FilePartWriter::hangup() {
+  loop();
+  stop();
+}
+
+}  // namespace td
@@ -0,0 +1,43 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/actor/actor.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/Promise.h"
+
+namespace td {
+
+// Writes downloaded file parts outside of the file loader scheduler.
+// Parts received while the previous writes are in progress are sorted and adjacent parts are written at once.
+class FilePartWriter final : public Actor {
+ public:
+  explicit FilePartWriter(string path) : path_(std::move(path)) {
+  }
+
+  void write_part(int64 offset, BufferSlice bytes, Promise<Unit> promise);
+
+ private:
+  static constexpr size_t MAX_WRITE_SIZE = 4 << 20;
+
+  struct PendingPart {
+    int64 offset_ = 0;
+    BufferSlice bytes_;
+    Promise<Unit> promise_;
+  };
+
+  string path_;
+  vector<PendingPart> pending_parts_;
+
+  void loop() final;
+
+  void hangup() final;
+};
+
+}  // namespace td
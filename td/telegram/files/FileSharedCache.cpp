@@ -0,0 +1,86 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FileSharedCache.h"
+
+#include "td/telegram/files/FileLoaderUtils.h"
+#include "td/telegram/Global.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/Random.h"
+#include "td/utils/SliceBuilder.h"
+
+namespace td {
+
+static string get_shared_file_cache_dir() {
+  auto dir = G()->get_option_string("shared_file_cache_directory");
+  if (!dir.empty() && dir.back() != TD_DIR_SLASH) {
+    dir += TD_DIR_SLASH;
+  }
+  return dir;
+}
+
+string get_shared_file_cache_key(const FullRemoteFileLocation &remote_location, int64 size) {
+  // only documents have identifiers, which don't depend on the current user and persistently identify the content
+  if (size <= 0 || remote_location.is_web() || !remote_location.is_document() ||
+      get_shared_file_cache_dir().empty()) {
+    return string();
+  }
+  return PSTRING() << remote_location.get_dc_id().get_raw_id() << '_' << remote_location.get_id() << '_' << size;
+}
+
+Result<FullLocalFileLocation> load_file_from_shared_cache(const string &key, FileType file_type, CSlice name) {
+  CHECK(!key.empty());
+  auto shared_path = get_shared_file_cache_dir() + key;
+  TRY_RESULT(stat, stat(shared_path));
+  if (!stat.is_reg_) {
+    return Status::Error("Not a regular file");
+  }
+
+  auto temp_path = PSTRING() << get_files_temp_dir(file_type) << "shared_" << key << '_' << Random::secure_uint32();
+  TRY_STATUS(link(shared_path, temp_path));
+  auto r_path = create_from_temp(file_type, temp_path, name);
+  if (r_path.is_error()) {
+    unlink(temp_path).ignore();
+    return r_path.move_as_error();
+  }
+  LOG(INFO) << "Load file " << key << " from the shared cache to " << r_path.ok();
+  return FullLocalFileLocation(file_type, r_path.move_as_ok(), 0);
+}
+
+void save_file_to_shared_cache(const string &key, const FullLocalFileLocation &local_location) {
+  CHECK(!key.empty());
+  auto dir = get_shared_file_cache_dir();
+  auto status = mkpath(dir, 0750);
+  if (status.is_ok()) {
+    // creation of the link may fail if the file has already been saved by another client
+    status = link(local_location.path_, dir + key);
+  }
+  LOG(INFO) << "Save file " << local_location.path_ << " to the shared cache as " << key << ": " << status;
+}
+
+void remove_unused_shared_cache_files() {
+  auto dir = get_shared_file_cache_dir();
+  if (dir.empty()) {
+    return;
+  }
+  int32 removed_file_count = 0;
+  walk_path(dir, [&](CSlice path, WalkPath::Type type) {
+    if (type != WalkPath::Type::RegularFile) {
+      return WalkPath::Action::Continue;
+    }
+    auto r_stat = stat(path);
+    if (r_stat.is_ok() && r_stat.ok().link_count_ == 1 && unlink(path).is_ok()) {
+      removed_file_count++;
+    }
+    return WalkPath::Action::Continue;
+  }).ignore();
+  LOG(INFO) << "Removed " << removed_file_count << " unused files from the shared cache";
+}
+
+}  // namespace td
@@ -0,0 +1,31 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/files/FileLocation.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+// Shared file cache is a directory with downloaded files, which is shared between all clients using it.
+// Files are keyed by their remote identifier and are stored as hard links to files of the clients,
+// so the file system counts references to each stored file.
+
+// returns an empty string if the file can't be stored in the shared cache
+string get_shared_file_cache_key(const FullRemoteFileLocation &remote_location, int64 size);
+
+Result<FullLocalFileLocation> load_file_from_shared_cache(const string &key, FileType file_type, CSlice name);
+
+void save_file_to_shared_cache(const string &key, const FullLocalFileLocation &local_location);
+
+// removes files, which aren't used by any client
+void remove_unused_shared_cache_files();
+
+}  // namespace td
@@ -0,0 +1,261 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FileStatsIndex.h"
+
+#include "td/telegram/DialogId.h"
+#include "td/telegram/files/FileType.h"
+
+#include "td/utils/as.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/path.h"
+#include "td/utils/tl_helpers.h"
+
+#include <cstring>
+
+namespace td {
+
+namespace {
+
+struct FileStatsIndexRecord {
+  bool is_deleted = false;
+  FullFileInfo info;
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    td::store(is_deleted, storer);
+    td::store(static_cast<int32>(info.file_type), storer);
+    td::store(info.path, storer);
+    if (!is_deleted) {
+      td::store(info.owner_dialog_id.get(), storer);
+      td::store(info.size, storer);
+      td::store(info.atime_nsec, storer);
+      td::store(info.mtime_nsec, storer);
+    }
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    td::parse(is_deleted, parser);
+    int32 file_type;
+    td::parse(file_type, parser);
+    if (file_type < 0 || file_type >= MAX_FILE_TYPE) {
+      return parser.set_error("Invalid file type");
+    }
+    info.file_type = static_cast<FileType>(file_type);
+    td::parse(info.path, parser);
+    info.owner_dialog_id = DialogId();
+    info.size = 0;
+    info.atime_nsec = 0;
+    info.mtime_nsec = 0;
+    if (!is_deleted) {
+      int64 owner_dialog_id;
+      td::parse(owner_dialog_id, parser);
+      info.owner_dialog_id = DialogId(owner_dialog_id);
+      td::parse(info.size, parser);
+      td::parse(info.atime_nsec, parser);
+      td::parse(info.mtime_nsec, parser);
+    }
+  }
+};
+
+struct FileStatsIndexSnapshot {
+  int32 version = 0;
+  double scan_date = 0.0;
+  vector<FileStatsIndexRecord> records;
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    td::store(version, storer);
+    td::store(scan_date, storer);
+    td::store(records, storer);
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    td::parse(version, parser);
+    td::parse(scan_date, parser);
+    td::parse(records, parser);
+  }
+};
+
+}  // namespace
+
+void FileStatsIndex::init(string path) {
+  snapshot_path_ = path + ".bin";
+  journal_path_ = path + ".log";
+}
+
+void FileStatsIndex::load() {
+  clear();
+  auto r_snapshot = read_file_str(snapshot_path_);
+  if (r_snapshot.is_error()) {
+    return;
+  }
+  FileStatsIndexSnapshot snapshot;
+  auto status = unserialize(snapshot, r_snapshot.ok());
+  if (status.is_ok() && snapshot.version != VERSION) {
+    status = Status::Error("Unsupported version");
+  }
+  if (status.is_error()) {
+    LOG(ERROR) << "Failed to load file index: " << status;
+    return;
+  }
+  for (auto &record : snapshot.records) {
+    apply_record(false, std::move(record.info));
+  }
+
+  auto r_journal = read_file_str(journal_path_);
+  if (r_journal.is_ok()) {
+    Slice data = r_journal.ok();
+    while (data.size() >= sizeof(uint32)) {
+      auto size = static_cast<size_t>(as<uint32>(data.data()));
+      if (data.size() - sizeof(uint32) < size) {
+        LOG(WARNING) << "Ignore incomplete file index journal record";
+        break;
+      }
+      FileStatsIndexRecord record;
+      if (unserialize(record, data.substr(sizeof(uint32), size)).is_error()) {
+        LOG(ERROR) << "Ignore invalid file index journal record";
+        break;
+      }
+      apply_record(record.is_deleted, std::move(record.info));
+      journal_record_count_++;
+      data.remove_prefix(sizeof(uint32) + size);
+    }
+  }
+  scan_date_ = snapshot.scan_date;
+  LOG(INFO) << "Loaded file index with " << files_.size() << " files and " << journal_record_count_
+            << " journal records";
+
+  if (journal_record_count_ > 0) {
+    // compact the journal; this also drops its possibly incomplete last record
+    save_snapshot();
+  }
+}
+
+void FileStatsIndex::reset(const vector<FullFileInfo> &files, double scan_date) {
+  clear();
+  for (auto &info : files) {
+    auto info_copy = info;
+    apply_record(false, std::move(info_copy));
+  }
+  scan_date_ = scan_date;
+  save_snapshot();
+}
+
+void FileStatsIndex::add_file(const FullFileInfo &info) {
+  if (scan_date_ == 0.0 || info.path.empty()) {
+    return;
+  }
+  auto info_copy = info;
+  apply_record(false, std::move(info_copy));
+  append_journal_record(false, info);
+}
+
+void FileStatsIndex::remove_file(const string &path) {
+  if (scan_date_ == 0.0) {
+    return;
+  }
+  auto it = files_.find(path);
+  if (it == files_.end()) {
+    return;
+  }
+  auto info = std::move(it->second);
+  files_.erase(it);
+  append_journal_record(true, info);
+}
+
+FileStats FileStatsIndex::get_file_stats(bool need_all_files, bool split_by_owner_dialog_id) const {
+  FileStats file_stats(need_all_files, split_by_owner_dialog_id);
+  for (auto &it : files_) {
+    file_stats.add_copy(it.second);
+  }
+  return file_stats;
+}
+
+void FileStatsIndex::close() {
+  journal_fd_.close();
+}
+
+void FileStatsIndex::destroy() {
+  clear();
+  unlink(snapshot_path_).ignore();
+  unlink(journal_path_).ignore();
+}
+
+void FileStatsIndex::apply_record(bool is_deleted, FullFileInfo &&info) {
+  if (info.path.empty()) {
+    return;
+  }
+  if (is_deleted) {
+    files_.erase(info.path);
+  } else {
+    auto path = info.path;
+    files_[std::move(path)] = std::move(info);
+  }
+}
+
+void FileStatsIndex::append_journal_record(bool is_deleted, const FullFileInfo &info) {
+  if (journal_record_count_ >= max(files_.size(), static_cast<size_t>(MIN_COMPACTED_JOURNAL_SIZE))) {
+    return save_snapshot();
+  }
+
+  FileStatsIndexRecord record;
+  record.is_deleted = is_deleted;
+  record.info = info;
+  auto data = serialize(record);
+  string buffer(sizeof(uint32) + data.size(), '\0');
+  as<uint32>(&buffer[0]) = narrow_cast<uint32>(data.size());
+  std::memcpy(&buffer[sizeof(uint32)], data.data(), data.size());
+
+  if (journal_fd_.empty()) {
+    auto r_fd = FileFd::open(journal_path_, FileFd::Write | FileFd::Create | FileFd::Append);
+    if (r_fd.is_error()) {
+      LOG(ERROR) << "Failed to open file index journal: " << r_fd.error();
+      // the index can't be kept up to date, so it must be rebuilt
+      return destroy();
+    }
+    journal_fd_ = r_fd.move_as_ok();
+  }
+  auto r_written = journal_fd_.write(buffer);
+  if (r_written.is_error() || r_written.ok() != buffer.size()) {
+    LOG(ERROR) << "Failed to write file index journal";
+    return destroy();
+  }
+  journal_record_count_++;
+}
+
+void FileStatsIndex::save_snapshot() {
+  journal_fd_.close();
+
+  FileStatsIndexSnapshot snapshot;
+  snapshot.version = VERSION;
+  snapshot.scan_date = scan_date_;
+  snapshot.records.reserve(files_.size());
+  for (auto &it : files_) {
+    FileStatsIndexRecord record;
+    record.info = it.second;
+    snapshot.records.push_back(std::move(record));
+  }
+  auto status = atomic_write_file(snapshot_path_, serialize(snapshot));
+  if (status.is_error()) {
+    LOG(ERROR) << "Failed to save file index: " << status;
+    return destroy();
+  }
+  unlink(journal_path_).ignore();
+  journal_record_count_ = 0;
+}
+
+void FileStatsIndex::clear() {
+  journal_fd_.close();
+  files_.clear();
+  scan_date_ = 0.0;
+  journal_record_count_ = 0;
+}
+
+}  // namespace td
@@ -0,0 +1,65 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/files/FileStats.h"
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+// Persistent index of local files, which allows to get storage statistics without scanning the file system.
+// It is stored as a snapshot with the results of the last full scan and a journal of subsequent changes.
+class FileStatsIndex {
+ public:
+  void init(string path);
+
+  void load();
+
+  // returns time of the last full scan of the file system or 0 if there is no valid index
+  double get_scan_date() const {
+    return scan_date_;
+  }
+
+  void reset(const vector<FullFileInfo> &files, double scan_date);
+
+  void add_file(const FullFileInfo &info);
+
+  void remove_file(const string &path);
+
+  FileStats get_file_stats(bool need_all_files, bool split_by_owner_dialog_id) const;
+
+  void close();
+
+  // removes the index from the disk
+  void destroy();
+
+ private:
+  static constexpr int32 VERSION = 1;
+  static constexpr size_t MIN_COMPACTED_JOURNAL_SIZE = 1000;
+
+  string snapshot_path_;
+  string journal_path_;
+  double scan_date_ = 0.0;
+  FlatHashMap<string, FullFileInfo> files_;
+  FileFd journal_fd_;
+  size_t journal_record_count_ = 0;
+
+  void apply_record(bool is_deleted, FullFileInfo &&info);
+
+  void append_journal_record(bool is_deleted, const FullFileInfo &info);
+
+  void save_snapshot();
+
+  void clear();
+};
+
+}  // namespace td
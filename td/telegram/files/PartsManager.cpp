@@ -38,6 +38,10 @@ int32 PartsManager::set_streaming_offset(int64 offset, int64 limit) {
     return first_streaming_not_ready_part_;
   };
 
+  if (offset != streaming_offset_) {
+    // start from small parts after seek to return the requested data as soon as possible
+    transferred_part_count_ = 0;
+  }
   if (offset < 0 || need_check_ || (!unknown_size_flag_ && get_size() < offset)) {
     streaming_offset_ = 0;
     LOG_IF(ERROR, offset != 0) << "Ignore streaming_offset " << offset << ", need_check_ = " << need_check_
@@ -276,7 +280,52 @@ bool PartsManager::is_streaming_limit_reached() {
   return !is_part_in_streaming_limit(part_id);
 }
 
-Result<Part> PartsManager::start_part() {
+void PartsManager::set_max_merged_part_size(size_t max_merged_part_size) {
+  CHECK(!is_upload_);
+  max_merged_part_size_ = max_merged_part_size;
+}
+
+int32 PartsManager::get_merged_part_count(int part_id, int64 max_size) const {
+  if (unknown_size_flag_ || known_prefix_flag_ || need_check_ || transferred_part_count_ < MERGED_PART_DELAY) {
+    return 1;
+  }
+
+  // the merged part must have size, which is a power of two multiple of part_size_, and be aligned to its size
+  int32 part_count = 1;
+  while (static_cast<size_t>(part_count) * 2 * part_size_ <= max_merged_part_size_ &&
+         static_cast<int64>(part_count) * 2 * static_cast<int64>(part_size_) <= max_size) {
+    part_count *= 2;
+  }
+  for (; part_count > 1; part_count /= 2) {
+    if (part_id % part_count != 0 || part_id + part_count > part_count_ ||
+        static_cast<int64>(part_id + part_count) * static_cast<int64>(part_size_) > size_) {
+      continue;
+    }
+    bool is_ok = true;
+    for (int i = part_id; i < part_id + part_count; i++) {
+      if (part_status_[i] != PartStatus::Empty || !is_part_in_streaming_limit(i)) {
+        is_ok = false;
+        break;
+      }
+    }
+    if (is_ok) {
+      return part_count;
+    }
+  }
+  return 1;
+}
+
+int32 PartsManager::extract_merged_part_count(int part_id) {
+  auto it = merged_part_count_.find(part_id);
+  if (it == merged_part_count_.end()) {
+    return 1;
+  }
+  auto result = it->second;
+  merged_part_count_.erase(it);
+  return result;
+}
+
+Result<Part> PartsManager::start_part(int64 max_size) {
   update_first_empty_part();
   auto part_id = first_streaming_empty_part_;
   if (known_prefix_flag_ && part_id >= static_cast<int>(known_prefix_size_ / part_size_)) {
@@ -306,8 +355,16 @@ Result<Part> PartsManager::start_part() {
     return get_empty_part();
   }
   CHECK(part_status_[part_id] == PartStatus::Empty);
-  on_part_start(part_id);
-  return get_part(part_id);
+  auto part_count = get_merged_part_count(part_id, max_size);
+  for (int i = 0; i < part_count; i++) {
+    on_part_start(part_id + i);
+  }
+  auto part = get_part(part_id);
+  if (part_count > 1) {
+    merged_part_count_[part_id] = part_count;
+    part.size = part_size_ * static_cast<size_t>(part_count);
+  }
+  return part;
 }
 
 Status PartsManager::set_known_prefix(int64 size, bool is_ready) {
@@ -345,7 +402,17 @@ Status PartsManager::on_part_ok(int part_id, size_t part_size, size_t actual_siz
       << part_id << ' ' << part_size << ' ' << actual_size << ' ' << *this;
   LOG_CHECK(part_status_[part_id] == PartStatus::Pending) << part_id << ' ' << static_cast<int32>(part_status_[part_id])
                                                           << ' ' << part_size << ' ' << actual_size << ' ' << *this;
+  auto part_count = extract_merged_part_count(part_id);
+  if (part_count > 1) {
+    CHECK(part_size == part_size_ * static_cast<size_t>(part_count));
+    for (int i = 0; i < part_count; i++) {
+      auto offset = part_size_ * static_cast<size_t>(i);
+      TRY_STATUS(on_part_ok(part_id + i, part_size_, actual_size > offset ? min(actual_size - offset, part_size_) : 0));
+    }
+    return Status::OK();
+  }
   pending_count_--;
+  transferred_part_count_++;
 
   part_status_[part_id] = PartStatus::Ready;
   if (actual_size != 0) {
@@ -390,6 +457,10 @@ Status PartsManager::on_part_ok(int part_id, size_t part_size, size_t actual_siz
 }
 
 void PartsManager::on_part_failed(int32 part_id) {
+  auto part_count = extract_merged_part_count(part_id);
+  for (int i = part_count - 1; i > 0; i--) {
+    on_part_failed(part_id + i);
+  }
   CHECK(part_status_[part_id] == PartStatus::Pending);
   pending_count_--;
   part_status_[part_id] = PartStatus::Empty;
@@ -482,6 +553,8 @@ Status PartsManager::init_common(const std::vector<int> &ready_parts) {
   ready_size_ = 0;
   streaming_ready_size_ = 0;
   pending_count_ = 0;
+  transferred_part_count_ = 0;
+  merged_part_count_.clear();
   first_empty_part_ = 0;
   first_not_ready_part_ = 0;
   part_status_ = vector<PartStatus>(part_count_);
@@ -581,6 +654,7 @@ StringBuilder &operator<<(StringBuilder &string_builder, const PartsManager &par
                         << ", first_streaming_empty_part = " << parts_manager.first_streaming_empty_part_
                         << ", first_streaming_not_ready_part = " << parts_manager.first_streaming_not_ready_part_
                         << ", use_part_count_limit = " << parts_manager.use_part_count_limit_
+                        << ", max_merged_part_size = " << parts_manager.max_merged_part_size_
                         << ", part_status_count = " << parts_manager.part_status_.size() << ": "
                         << parts_manager.bitmask_ << ']';
 }
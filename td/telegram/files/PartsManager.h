@@ -12,6 +12,8 @@
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 
+#include <map>
+
 namespace td {
 
 struct Part {
@@ -29,8 +31,11 @@ class PartsManager {
   bool unchecked_ready();
   Status finish() TD_WARN_UNUSED_RESULT;
 
-  // returns empty part if nothing to return
-  Result<Part> start_part() TD_WARN_UNUSED_RESULT;
+  // allows to request up to max_merged_part_size bytes of consecutive aligned parts at once
+  void set_max_merged_part_size(size_t max_merged_part_size);
+
+  // returns empty part if nothing to return; returned part is never bigger than max(max_size, get_part_size())
+  Result<Part> start_part(int64 max_size) TD_WARN_UNUSED_RESULT;
   Status on_part_ok(int part_id, size_t part_size, size_t actual_size) TD_WARN_UNUSED_RESULT;
   void on_part_failed(int part_id);
   Status set_known_prefix(int64 size, bool is_ready);
@@ -59,6 +64,7 @@ class PartsManager {
   static constexpr int MAX_PART_COUNT_PREMIUM = 8000;
   static constexpr size_t MAX_PART_SIZE = 512 << 10;
   static constexpr int64 MAX_FILE_SIZE = static_cast<int64>(MAX_PART_SIZE) * MAX_PART_COUNT_PREMIUM;
+  static constexpr int MERGED_PART_DELAY = 4;  // number of parts to be transferred before parts are merged
 
   enum class PartStatus : int32 { Empty, Pending, Ready };
 
@@ -90,6 +96,10 @@ class PartsManager {
   Bitmask bitmask_;
   bool use_part_count_limit_{false};
 
+  size_t max_merged_part_size_{0};
+  int transferred_part_count_{0};
+  std::map<int32, int32> merged_part_count_;  // first part_id -> number of parts in a pending merged part
+
   Status init_common(const vector<int> &ready_parts);
   Status init_known_prefix(int64 known_prefix, size_t part_size,
                            const std::vector<int> &ready_parts) TD_WARN_UNUSED_RESULT;
@@ -99,6 +109,8 @@ class PartsManager {
 
   Part get_part(int part_id) const;
   void on_part_start(int part_id);
+  int32 get_merged_part_count(int part_id, int64 max_size) const;
+  int32 extract_merged_part_count(int part_id);
   void update_first_empty_part();
   void update_first_not_ready_part();
 
@@ -13,6 +13,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/ScopeGuard.h"
+#include "td/utils/Time.h"
 
 #include <algorithm>
 
@@ -54,6 +55,7 @@ void ResourceManager::update_resources(const ResourceState &resource_state) {
   auto node = (*node_ptr).get();
   CHECK(node);
   VLOG(file_loader) << "Before total: " << resource_state_ << "; node " << node_id << ": " << node->resource_state_;
+  update_adaptive_limit(node->resource_state_, resource_state);
   resource_state_ -= node->resource_state_;
   node->resource_state_.update_master(resource_state);
   resource_state_ += node->resource_state_;
@@ -82,6 +84,28 @@ void ResourceManager::hangup_shared() {
   loop();
 }
 
+void ResourceManager::update_adaptive_limit(const ResourceState &old_state, const ResourceState &new_state) {
+  if (!is_adaptive_) {
+    return;
+  }
+
+  auto transferred = new_state.get_transferred() - old_state.get_transferred();
+  if (transferred > 0) {
+    adaptive_limit_.on_transferred(transferred);
+    total_transferred_ += transferred;
+  }
+  auto delay_count = new_state.get_delay_count() - old_state.get_delay_count();
+  if (delay_count > 0) {
+    adaptive_limit_.on_delay((new_state.get_delay_sum() - old_state.get_delay_sum()) /
+                             static_cast<double>(delay_count));
+  }
+  if (adaptive_limit_.update(Time::now())) {
+    LOG(INFO) << get_name() << " changes limit from " << max_resource_limit_ << " to "
+              << adaptive_limit_.get_limit() << tag("total_transferred", total_transferred_);
+    max_resource_limit_ = adaptive_limit_.get_limit();
+  }
+}
+
 void ResourceManager::add_to_heap(Node *node) {
   auto *heap_node = node->as_heap_node();
   auto key = node->resource_state_.estimated_extra();
@@ -98,7 +122,7 @@ void ResourceManager::add_to_heap(Node *node) {
   }
 }
 
-bool ResourceManager::satisfy_node(NodeId file_node_id) {
+bool ResourceManager::satisfy_node(NodeId file_node_id, int64 max_give) {
   auto file_node_ptr = nodes_container_.get(file_node_id);
   CHECK(file_node_ptr);
   auto file_node = (*file_node_ptr).get();
@@ -111,11 +135,11 @@ bool ResourceManager::satisfy_node(NodeId file_node_id) {
   if (need == 0) {
     return true;
   }
-  auto give = resource_state_.unused();
+  auto give = min(resource_state_.unused(), max_give);
   give = min(need, give);
   give -= give % part_size;
   VLOG(file_loader) << tag("give", give);
-  if (give == 0) {
+  if (give <= 0) {  // can be negative if the adaptive limit has decreased
     return false;
   }
   resource_state_.start_use(give);
@@ -142,7 +166,7 @@ void ResourceManager::loop() {
       SCOPE_EXIT {
         to_add.push_back(node);
       };
-      if (!satisfy_node(node->node_id)) {
+      if (!satisfy_node(node->node_id, resource_state_.unused())) {
         break;
       }
     }
@@ -151,15 +175,40 @@ void ResourceManager::loop() {
     }
   } else if (mode_ == Mode::Baseline) {
     // plain
+    auto background_unused = max_resource_limit_;
+    if (background_share_percent_ < 100) {
+      background_unused = max_resource_limit_ / 100 * background_share_percent_;
+      for (auto &it : to_xload_) {
+        if (it.first <= BACKGROUND_PRIORITY) {
+          background_unused -= get_node_resource_state(it.second).active_limit();
+        }
+      }
+    }
     for (auto &it : to_xload_) {
       auto file_node_id = it.second;
-      if (!satisfy_node(file_node_id)) {
+      if (it.first > BACKGROUND_PRIORITY) {
+        if (!satisfy_node(file_node_id, resource_state_.unused())) {
+          break;
+        }
+        continue;
+      }
+
+      // background downloads are the last in the list
+      auto old_active_limit = get_node_resource_state(file_node_id).active_limit();
+      if (!satisfy_node(file_node_id, background_unused)) {
         break;
       }
+      background_unused -= get_node_resource_state(file_node_id).active_limit() - old_active_limit;
     }
   }
 }
 
+const ResourceState &ResourceManager::get_node_resource_state(NodeId node_id) {
+  auto node_ptr = nodes_container_.get(node_id);
+  CHECK(node_ptr);
+  return (*node_ptr)->resource_state_;
+}
+
 void ResourceManager::add_node(NodeId node_id, int8 priority) {
   if (priority >= 0) {
     auto it = std::find_if(to_xload_.begin(), to_xload_.end(), [&](auto &x) { return x.first <= priority; });
@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/telegram/files/AdaptiveResourceLimit.h"
 #include "td/telegram/files/FileLoaderActor.h"
 #include "td/telegram/files/ResourceState.h"
 
@@ -22,7 +23,16 @@ namespace td {
 class ResourceManager final : public Actor {
  public:
   enum class Mode : int32 { Baseline, Greedy };
-  ResourceManager(int64 max_resource_limit, Mode mode) : max_resource_limit_(max_resource_limit), mode_(mode) {
+  // downloads with priority BACKGROUND_PRIORITY can use at most background_share_percent of the resource limit;
+  // the priority is below all priorities of user downloads, which are positive
+  static constexpr int8 BACKGROUND_PRIORITY = 0;
+
+  ResourceManager(int64 max_resource_limit, Mode mode, bool is_adaptive = false, int32 background_share_percent = 100)
+      : max_resource_limit_(max_resource_limit)
+      , mode_(mode)
+      , is_adaptive_(is_adaptive)
+      , adaptive_limit_(max_resource_limit)
+      , background_share_percent_(background_share_percent) {
   }
   // use through ActorShared
   void update_priority(int8 priority);
@@ -34,6 +44,13 @@ class ResourceManager final : public Actor {
   int64 max_resource_limit_ = 0;
   Mode mode_;
 
+  // if adaptive, then the limit is chosen based on the estimated bandwidth-delay product
+  bool is_adaptive_ = false;
+  AdaptiveResourceLimit adaptive_limit_;
+  int64 total_transferred_ = 0;
+
+  int32 background_share_percent_ = 100;
+
   using NodeId = uint64;
   struct Node final : public HeapNode {
     NodeId node_id = 0;
@@ -61,8 +78,11 @@ class ResourceManager final : public Actor {
 
   void loop() final;
 
+  void update_adaptive_limit(const ResourceState &old_state, const ResourceState &new_state);
+
   void add_to_heap(Node *node);
-  bool satisfy_node(NodeId file_node_id);
+  bool satisfy_node(NodeId file_node_id, int64 max_give);
+  const ResourceState &get_node_resource_state(NodeId node_id);
   void add_node(NodeId node_id, int8 priority);
   bool remove_node(NodeId node_id);
 };
@@ -25,6 +25,15 @@ class ResourceState {
     used_ += x;
   }
 
+  void on_transferred(int64 x) {
+    transferred_ += x;
+  }
+
+  void on_delay(double delay) {
+    delay_sum_ += delay;
+    delay_count_++;
+  }
+
   void update_limit(int64 extra) {
     limit_ += extra;
   }
@@ -61,6 +70,18 @@ class ResourceState {
     return using_;
   }
 
+  int64 get_transferred() const {
+    return transferred_;
+  }
+
+  double get_delay_sum() const {
+    return delay_sum_;
+  }
+
+  int64 get_delay_count() const {
+    return delay_count_;
+  }
+
   int64 unused() const {
     return limit_ - using_ - used_;
   }
@@ -92,6 +113,9 @@ class ResourceState {
     used_ = other.used_;
     using_ = other.using_;
     unit_size_ = other.unit_size_;
+    transferred_ = other.transferred_;
+    delay_sum_ = other.delay_sum_;
+    delay_count_ = other.delay_count_;
   }
 
   void update_slave(const ResourceState &other) {
@@ -109,6 +133,9 @@ class ResourceState {
   int64 used_ = 0;             // me
   int64 using_ = 0;            // me
   size_t unit_size_ = 1;       // me
+  int64 transferred_ = 0;      // me; total size of successfully transferred parts
+  double delay_sum_ = 0.0;     // me; total time between sending of a part query and receiving its result
+  int64 delay_count_ = 0;      // me; number of measured part queries
 };
 
 }  // namespace td
@@ -40,6 +40,8 @@
 #include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
 
+#include <algorithm>
+#include <cmath>
 #include <utility>
 
 namespace td {
@@ -129,6 +131,36 @@ void ConnectionCreator::ClientInfo::add_session_id(uint64 session_id) {
   }
 }
 
+void ConnectionCreator::ClientInfo::on_connection_requested(double now, bool is_hit) {
+  auto half_life = is_media ? MEDIA_DEMAND_HALF_LIFE : DEMAND_HALF_LIFE;
+  demand = demand * std::exp2((demand_updated_at - now) / half_life) + 1.0;
+  demand_updated_at = now;
+  if (is_hit) {
+    ready_hit_count++;
+  } else {
+    ready_miss_count++;
+  }
+}
+
+size_t ConnectionCreator::ClientInfo::get_prewarm_connection_count(double now, size_t max_count) const {
+  if (max_count == 0 || demand == 0) {
+    return 0;
+  }
+  // expected number of requests during READY_CONNECTIONS_TIMEOUT, estimated from the decaying demand;
+  // media connections are requested in bursts after long idle periods, so their demand is remembered longer
+  // and at least one connection is kept ready while the demand is high enough
+  auto half_life = is_media ? MEDIA_DEMAND_HALF_LIFE : DEMAND_HALF_LIFE;
+  auto current_demand = demand * std::exp2((demand_updated_at - now) / half_life);
+  auto expected_count = current_demand * std::log(2.0) / half_life * READY_CONNECTIONS_TIMEOUT;
+  if (is_media) {
+    expected_count = max(expected_count, current_demand * MIN_PREWARM_DEMAND);
+  }
+  if (expected_count < MIN_PREWARM_DEMAND) {
+    return 0;
+  }
+  return min(max_count, static_cast<size_t>(std::ceil(expected_count)));
+}
+
 ConnectionCreator::ConnectionCreator(ActorShared<> parent) : parent_(std::move(parent)) {
 }
 
@@ -168,6 +200,7 @@ void ConnectionCreator::add_proxy(int32 old_proxy_id, string server, int32 port,
     G()->td_db()->get_binlog_pmc()->erase(get_proxy_used_database_key(old_proxy_id));
     proxy_last_used_date_.erase(old_proxy_id);
     proxy_last_used_saved_date_.erase(old_proxy_id);
+    proxy_selector_.remove_proxy(old_proxy_id);
   } else {
 #if TD_EMSCRIPTEN || TD_DARWIN_WATCH_OS
     return promise.set_error(Status::Error(400, "The method is unsupported for the platform"));
@@ -204,6 +237,8 @@ void ConnectionCreator::enable_proxy(int32 proxy_id, Promise<Unit> promise) {
     return promise.set_error(Status::Error(400, "Unknown proxy identifier"));
   }
 
+  // don't switch from the proxy chosen by the user automatically unless it stops working
+  proxy_selector_.on_proxy_switched(Time::now());
   enable_proxy_impl(proxy_id);
   promise.set_value(Unit());
 }
@@ -224,6 +259,7 @@ void ConnectionCreator::remove_proxy(int32 proxy_id, Promise<Unit> promise) {
   }
 
   proxies_.erase(proxy_id);
+  proxy_selector_.remove_proxy(proxy_id);
 
   G()->td_db()->get_binlog_pmc()->erase(get_proxy_database_key(proxy_id));
   G()->td_db()->get_binlog_pmc()->erase(get_proxy_used_database_key(proxy_id));
@@ -386,6 +422,77 @@ void ConnectionCreator::ping_proxy_buffered_socket_fd(IPAddress ip_address, Buff
                                create_reference(token))};
 }
 
+void ConnectionCreator::on_proxy_auto_select_changed() {
+  next_proxy_probe_timestamp_ = Timestamp();
+  loop();
+}
+
+void ConnectionCreator::get_proxy_statistics(
+    Promise<vector<td_api::object_ptr<td_api::networkProxyStatistics>>> promise) {
+  auto ranked_proxy_ids = proxy_selector_.get_ranked_proxy_ids();
+  vector<td_api::object_ptr<td_api::networkProxyStatistics>> result;
+  for (auto &proxy : proxies_) {
+    auto proxy_id = proxy.first;
+    auto info = proxy_selector_.get_probe_info(proxy_id);
+    auto rank_it = std::find(ranked_proxy_ids.begin(), ranked_proxy_ids.end(), proxy_id);
+    auto rank = rank_it == ranked_proxy_ids.end() ? 0 : static_cast<int32>(rank_it - ranked_proxy_ids.begin()) + 1;
+    result.push_back(td_api::make_object<td_api::networkProxyStatistics>(
+        proxy_id, info.probe_count, info.success_count, info.last_probe_date, info.last_rtt, info.average_rtt,
+        ProxySelector::is_proxy_available(info), rank));
+  }
+  promise.set_value(std::move(result));
+}
+
+bool ConnectionCreator::need_probe_proxies() const {
+  // probes are needed only to choose between proxies, so they are sent only while a proxy is used
+  return !close_flag_ && active_proxy_id_ != 0 && proxies_.size() >= 2 &&
+         G()->get_option_boolean("proxy_auto_select");
+}
+
+void ConnectionCreator::probe_proxies() {
+  next_proxy_probe_timestamp_ = Timestamp::in(PROXY_PROBE_PERIOD * Random::fast(90, 110) * 0.01);
+  auto proxy_ids = transform(proxies_, [](const auto &proxy) { return proxy.first; });
+  auto round = proxy_selector_.start_probe_round(proxy_ids, G()->unix_time());
+  VLOG(connections) << "Start proxy probe round " << round << " for " << proxy_ids.size() << " proxies";
+  for (auto proxy_id : proxy_ids) {
+    ping_proxy(proxy_id,
+               PromiseCreator::lambda([actor_id = actor_id(this), proxy_id, round](Result<double> result) {
+                 send_closure(actor_id, &ConnectionCreator::on_proxy_probe_result, proxy_id, round,
+                              std::move(result));
+               }));
+  }
+  auto_select_proxy();
+}
+
+void ConnectionCreator::on_proxy_probe_result(int32 proxy_id, uint32 round, Result<double> r_rtt) {
+  bool is_failed = r_rtt.is_error();
+  if (!proxy_selector_.on_probe_result(proxy_id, round, std::move(r_rtt), G()->unix_time())) {
+    return;
+  }
+
+  if (is_failed && proxy_id == active_proxy_id_) {
+    // recheck the active proxy sooner to notice quickly that it stopped working
+    next_proxy_probe_timestamp_.relax(Timestamp::in(PROXY_FAILED_PROBE_PERIOD));
+  }
+  auto_select_proxy();
+  loop();
+}
+
+void ConnectionCreator::auto_select_proxy() {
+  if (!need_probe_proxies()) {
+    return;
+  }
+
+  auto best_proxy_id = proxy_selector_.choose_proxy(active_proxy_id_, Time::now());
+  if (best_proxy_id == 0) {
+    return;
+  }
+
+  LOG(WARNING) << "Automatically switch from proxy " << active_proxy_id_ << " to proxy " << best_proxy_id;
+  proxy_selector_.on_proxy_switched(Time::now());
+  enable_proxy_impl(best_proxy_id);
+}
+
 void ConnectionCreator::set_active_proxy_id(int32 proxy_id, bool from_binlog) {
   active_proxy_id_ = proxy_id;
   if (proxy_id == 0) {
@@ -539,6 +646,9 @@ void ConnectionCreator::on_network(bool network_flag, uint32 network_generation)
     }
 
     if (old_generation != network_generation_) {
+      // probes through the previous network say nothing about the new one
+      proxy_selector_.on_network_changed();
+      next_proxy_probe_timestamp_ = Timestamp();
       loop();
     }
   }
@@ -608,8 +718,15 @@ void ConnectionCreator::request_raw_connection(DcId dc_id, bool allow_media_only
   }
   client.auth_data = std::move(auth_data);
   client.auth_data_generation++;
+
+  auto expires_at = Time::now() - ClientInfo::READY_CONNECTIONS_TIMEOUT;
+  auto ready_connection_count = static_cast<size_t>(
+      std::count_if(client.ready_connections.begin(), client.ready_connections.end(),
+                    [expires_at](const auto &ready_connection) { return ready_connection.second >= expires_at; }));
+  bool is_hit = ready_connection_count > client.queries.size();
+  client.on_connection_requested(Time::now_cached(), is_hit);
   VLOG(connections) << "Request connection for " << tag("client", format::as_hex(client.hash)) << " to " << dc_id << " "
-                    << tag("allow_media_only", allow_media_only);
+                    << tag("allow_media_only", allow_media_only) << tag("hit", is_hit);
   client.queries.push_back(std::move(promise));
 
   client_loop(client);
@@ -824,6 +941,9 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
                 [&, expires_at = Time::now_cached() - ClientInfo::READY_CONNECTIONS_TIMEOUT](auto &v) {
                   bool drop = v.second < expires_at;
                   VLOG_IF(connections, drop) << "Drop expired " << tag("connection", v.first.get());
+                  if (drop) {
+                    client.expired_connection_count++;
+                  }
                   return drop;
                 });
 
@@ -844,25 +964,36 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
 
   // Main loop. Create new connections till needed
   bool check_mode = client.checking_connections != 0 && !proxy.use_proxy();
+  bool act_as_if_online = online_flag_ || is_logging_out_;
+  // keep some connections ready in advance, but only while online to not waste traffic and battery
+  size_t prewarm_count = 0;
+  if (act_as_if_online && client.demand_updated_at > client.last_prewarm_at) {
+    prewarm_count = client.get_prewarm_connection_count(Time::now_cached(), get_max_prewarm_connection_count());
+  }
   while (true) {
     // Check if we need new connections
     if (client.queries.empty()) {
       if (!client.ready_connections.empty()) {
-        client_set_timeout_at(client, Time::now() + ClientInfo::READY_CONNECTIONS_TIMEOUT);
+        auto first_ready_at = client.ready_connections[0].second;
+        for (auto &ready_connection : client.ready_connections) {
+          first_ready_at = min(first_ready_at, ready_connection.second);
+        }
+        client_set_timeout_at(client, first_ready_at + ClientInfo::READY_CONNECTIONS_TIMEOUT);
       }
-      return;
-    }
-    if (check_mode) {
+      if (check_mode || client.pending_connections + client.ready_connections.size() >= prewarm_count) {
+        return;
+      }
+    } else if (check_mode) {
       if (client.checking_connections >= 3) {
         return;
       }
     } else {
-      if (client.pending_connections >= client.queries.size()) {
+      if (client.pending_connections >= client.queries.size() + prewarm_count) {
         return;
       }
     }
+    bool is_prewarm = client.pending_connections >= client.queries.size();
 
-    bool act_as_if_online = online_flag_ || is_logging_out_;
     // Check flood
     auto &flood_control = act_as_if_online ? client.flood_control_online : client.flood_control;
     auto wakeup_at = max(flood_control.get_wakeup_at(), client.mtproto_error_flood_control.get_wakeup_at());
@@ -907,6 +1038,11 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
 #endif
 
     client.pending_connections++;
+    if (is_prewarm) {
+      VLOG(connections) << "Prewarm connection for " << tag("client", format::as_hex(client.hash));
+      client.prewarmed_connection_count++;
+      client.last_prewarm_at = Time::now_cached();
+    }
     if (check_mode) {
       if (extra.stat) {
         extra.stat->on_check();
@@ -997,6 +1133,21 @@ void ConnectionCreator::client_set_timeout_at(ClientInfo &client, double wakeup_
                     << wakeup_at - Time::now_cached();
 }
 
+size_t ConnectionCreator::get_max_prewarm_connection_count() {
+  return static_cast<size_t>(G()->get_option_integer("prewarm_connection_count_max", DEFAULT_PREWARM_CONNECTION_COUNT));
+}
+
+void ConnectionCreator::dump_client_statistics(const ClientInfo &client) {
+  auto request_count = client.ready_hit_count + client.ready_miss_count;
+  if (request_count == 0) {
+    return;
+  }
+  LOG(INFO) << "Ready connections for " << client.dc_id << tag("is_media", client.is_media)
+            << tag("hit", client.ready_hit_count) << tag("miss", client.ready_miss_count)
+            << tag("hit_rate", static_cast<double>(client.ready_hit_count) / static_cast<double>(request_count))
+            << tag("prewarmed", client.prewarmed_connection_count) << tag("expired", client.expired_connection_count);
+}
+
 void ConnectionCreator::client_add_connection(uint32 hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection,
                                               bool check_flag, uint64 auth_data_generation, uint64 session_id) {
   auto &client = clients_[hash];
@@ -1188,6 +1339,9 @@ ActorShared<ConnectionCreator> ConnectionCreator::create_reference(int64 token)
 
 void ConnectionCreator::hangup() {
   close_flag_ = true;
+  for (auto &client : clients_) {
+    dump_client_statistics(client.second);
+  }
   save_proxy_last_used_date(0);
   ref_cnt_guard_.reset();
   for (auto &child : children_) {
@@ -1289,6 +1443,13 @@ void ConnectionCreator::loop() {
     }
   }
 
+  if (need_probe_proxies()) {
+    if (next_proxy_probe_timestamp_.is_in_past()) {
+      probe_proxies();
+    }
+    timeout.relax(next_proxy_probe_timestamp_);
+  }
+
   if (timeout) {
     set_timeout_at(timeout.at());
   }
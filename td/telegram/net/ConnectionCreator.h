@@ -11,6 +11,7 @@
 #include "td/telegram/net/DcOptionsSet.h"
 #include "td/telegram/net/NetQuery.h"
 #include "td/telegram/net/Proxy.h"
+#include "td/telegram/net/ProxySelector.h"
 #include "td/telegram/td_api.h"
 
 #include "td/mtproto/AuthData.h"
@@ -79,6 +80,9 @@ class ConnectionCreator final : public NetQueryCallback {
   void get_proxy_link(int32 proxy_id, Promise<string> promise);
   void ping_proxy(int32 proxy_id, Promise<double> promise);
 
+  void on_proxy_auto_select_changed();
+  void get_proxy_statistics(Promise<vector<td_api::object_ptr<td_api::networkProxyStatistics>>> promise);
+
   struct ConnectionData {
     IPAddress ip_address;
     BufferedFd<SocketFd> buffered_socket_fd;
@@ -106,6 +110,8 @@ class ConnectionCreator final : public NetQueryCallback {
   bool is_inited_ = false;
 
   static constexpr int32 MAX_PROXY_LAST_USED_SAVE_DELAY = 60;
+  // pre-warming of connections is disabled by default, because it increases traffic and battery usage
+  static constexpr int64 DEFAULT_PREWARM_CONNECTION_COUNT = 0;
   std::map<int32, Proxy> proxies_;
   FlatHashMap<int32, int32> proxy_last_used_date_;
   FlatHashMap<int32, int32> proxy_last_used_saved_date_;
@@ -117,6 +123,11 @@ class ConnectionCreator final : public NetQueryCallback {
   Timestamp resolve_proxy_timestamp_;
   uint64 resolve_proxy_query_token_{0};
 
+  static constexpr double PROXY_PROBE_PERIOD = 60;
+  static constexpr double PROXY_FAILED_PROBE_PERIOD = 10;
+  ProxySelector proxy_selector_;
+  Timestamp next_proxy_probe_timestamp_;
+
   struct ClientInfo {
     class Backoff {
 #if TD_ANDROID || TD_DARWIN_IOS || TD_DARWIN_VISION_OS || TD_DARWIN_WATCH_OS || TD_TIZEN
@@ -145,6 +156,9 @@ class ConnectionCreator final : public NetQueryCallback {
     uint64 extract_session_id();
     void add_session_id(uint64 session_id);
 
+    void on_connection_requested(double now, bool is_hit);
+    size_t get_prewarm_connection_count(double now, size_t max_count) const;
+
     Backoff backoff;
     FloodControlStrict sanity_flood_control;
     FloodControlStrict flood_control;
@@ -158,6 +172,23 @@ class ConnectionCreator final : public NetQueryCallback {
 
     static constexpr double READY_CONNECTIONS_TIMEOUT = 10;
 
+    // exponentially decaying number of recently requested connections
+    double demand{0};
+    double demand_updated_at{0};
+    static constexpr double DEMAND_HALF_LIFE = 60;
+    static constexpr double MEDIA_DEMAND_HALF_LIFE = 300;
+    static constexpr double MIN_PREWARM_DEMAND = 0.1;
+
+    // connections are pre-warmed only if there were requests after the last pre-warming, so expired pre-warmed
+    // connections aren't re-created while there are no new requests
+    double last_prewarm_at{-1};
+
+    // statistics of requests served from ready connections
+    size_t ready_hit_count{0};
+    size_t ready_miss_count{0};
+    size_t prewarmed_connection_count{0};
+    size_t expired_connection_count{0};
+
     bool inited{false};
     uint32 hash{0};
     DcId dc_id;
@@ -226,6 +257,8 @@ class ConnectionCreator final : public NetQueryCallback {
   void client_add_connection(uint32 hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection, bool check_flag,
                              uint64 auth_data_generation, uint64 session_id);
   void client_set_timeout_at(ClientInfo &client, double wakeup_at);
+  static size_t get_max_prewarm_connection_count();
+  static void dump_client_statistics(const ClientInfo &client);
 
   void on_proxy_resolved(Result<IPAddress> ip_address, bool dummy);
 
@@ -252,6 +285,11 @@ class ConnectionCreator final : public NetQueryCallback {
                                      mtproto::TransportType transport_type, string debug_str, Promise<double> promise);
 
   void on_ping_main_dc_result(uint64 token, Result<double> result);
+
+  bool need_probe_proxies() const;
+  void probe_proxies();
+  void on_proxy_probe_result(int32 proxy_id, uint32 round, Result<double> r_rtt);
+  void auto_select_proxy();
 };
 
 }  // namespace td
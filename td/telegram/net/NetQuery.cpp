@@ -8,6 +8,7 @@
 
 #include "td/telegram/ChainId.h"
 #include "td/telegram/Global.h"
+#include "td/telegram/net/NetRequestStats.h"
 #include "td/telegram/telegram_api.h"
 
 #include "td/utils/algorithm.h"
@@ -56,6 +57,42 @@ NetQuery::NetQuery(uint64 id, BufferSlice &&query, DcId dc_id, Type type, AuthFl
   LOG(INFO) << *this;
   if (stats) {
     nq_counter_ = stats->register_query(this);
+    stats_ = stats;
+  }
+}
+
+void NetQuery::on_queued() {
+  queued_at_ = Time::now();
+}
+
+void NetQuery::on_dequeued() {
+  if (queued_at_ == 0.0) {
+    return;
+  }
+  auto wait_time = Time::now() - queued_at_;
+  queued_at_ = 0.0;
+  {
+    auto guard = lock();
+    get_data_unsafe().queue_wait_time_ += wait_time;
+  }
+  if (stats_ != nullptr) {
+    stats_->on_queue_wait(wait_time);
+    stats_->on_stage_finished(NetQueryStats::Stage::SessionQueue, tl_constructor_, stats_dc_id_, wait_time);
+  }
+}
+
+void NetQuery::start_stage() {
+  stage_started_at_ = Time::now();
+}
+
+void NetQuery::finish_stage(NetQueryStats::Stage stage) {
+  if (stage_started_at_ == 0.0) {
+    return;
+  }
+  auto duration = Time::now() - stage_started_at_;
+  stage_started_at_ = 0.0;
+  if (stats_ != nullptr) {
+    stats_->on_stage_finished(stage, tl_constructor_, stats_dc_id_, duration);
   }
 }
 
@@ -64,6 +101,7 @@ void NetQuery::clear() {
     auto guard = lock();
     LOG(ERROR) << "Destroy not ready query " << *this << " " << tag("state", get_data_unsafe().state_);
   }
+  finish_stage(NetQueryStats::Stage::ResponseProcessing);
   // TODO: CHECK if net_query is lost here
   cancel_slot_.close();
   *this = NetQuery();
@@ -103,13 +141,22 @@ void NetQuery::on_net_write(size_t size) {
   if (static_cast<size_t>(file_type_) < callbacks.size()) {
     callbacks[file_type_]->on_write(size);
   }
+  auto request_stats = G()->get_net_request_stats();
+  if (request_stats != nullptr && request_stats->is_enabled()) {
+    auto uncompressed_size = gzip_flag_ == GzipFlag::On ? uncompressed_query_size_ : query_.size();
+    request_stats->on_request_sent(tl_constructor_, size, uncompressed_size);
+  }
 }
 
-void NetQuery::on_net_read(size_t size) {
+void NetQuery::on_net_read(size_t size, size_t uncompressed_size) {
   const auto &callbacks = G()->get_net_stats_file_callbacks();
   if (static_cast<size_t>(file_type_) < callbacks.size()) {
     callbacks[file_type_]->on_read(size);
   }
+  auto request_stats = G()->get_net_request_stats();
+  if (request_stats != nullptr && request_stats->is_enabled()) {
+    request_stats->on_response_received(tl_constructor_, size, uncompressed_size);
+  }
 }
 
 int32 NetQuery::tl_magic(const BufferSlice &buffer_slice) {
@@ -115,7 +115,11 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   void set_ok(BufferSlice slice);
 
   void on_net_write(size_t size);
-  void on_net_read(size_t size);
+  void on_net_read(size_t size, size_t uncompressed_size);
+
+  void set_uncompressed_query_size(size_t size) {
+    uncompressed_query_size_ = size;
+  }
 
   void set_error(Status status, string source = string());
 
@@ -193,9 +197,22 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
 
   void stop_track() {
     nq_counter_ = NetQueryCounter();
+    stats_ = nullptr;
     remove();
   }
 
+  // must be called when the query is added to and removed from a queue of queries waiting to be sent
+  void on_queued();
+  void on_dequeued();
+
+  // must be called when the query starts and finishes a stage of its processing to collect latency statistics
+  void start_stage();
+  void finish_stage(NetQueryStats::Stage stage);
+
+  void set_stats_dc_id(int32 dc_id) {
+    stats_dc_id_ = dc_id;
+  }
+
   void debug_send_failed() {
     auto guard = lock();
     get_data_unsafe().send_failed_count_++;
@@ -252,9 +269,14 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   DcId dc_id_;
 
   NetQueryCounter nq_counter_;
+  NetQueryStats *stats_ = nullptr;
+  double queued_at_ = 0.0;
+  double stage_started_at_ = 0.0;
+  int32 stats_dc_id_ = 0;
   Status status_;
   uint64 id_ = 0;
   BufferSlice query_;
+  size_t uncompressed_query_size_ = 0;
   BufferSlice answer_;
   int32 tl_constructor_ = 0;
   int32 verification_prefix_length_ = 0;
@@ -304,6 +326,8 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   Slot cancel_slot_;                // for Session and to be set by caller
   Promise<> quick_ack_promise_;     // for Session and to be set by caller
   bool need_resend_on_503_ = true;  // for NetQueryDispatcher and to be set by caller
+  uint64 deduplication_id_ = 0;     // for NetQueryDeduplicator
+  bool is_paced_ = false;           // for NetQueryDispatcher
 
   NetQuery(uint64 id, BufferSlice &&query, DcId dc_id, Type type, AuthFlag auth_flag, GzipFlag gzip_flag,
            int32 tl_constructor, int32 total_timeout_limit, NetQueryStats *stats, vector<ChainId> chain_ids);
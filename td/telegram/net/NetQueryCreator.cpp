@@ -51,16 +51,6 @@ NetQueryPtr NetQueryCreator::create(uint64 id, const telegram_api::object_ptr<te
     CHECK(real_size == prefix_str.size());
   }
 
-  auto storer = DefaultStorer<telegram_api::Function>(function);
-  BufferSlice slice(prefix_str.size() + storer.size());
-  auto real_size = storer.store(slice.as_mutable_slice().ubegin() + prefix_str.size());
-  LOG_CHECK(prefix_str.size() + real_size == slice.size())
-      << prefix_str.size() << ' ' << real_size << ' ' << slice.size() << ' '
-      << format::as_hex_dump<4>(slice.as_slice());
-  if (prefix != nullptr) {
-    slice.as_mutable_slice().copy_from(prefix_str);
-  }
-
   size_t min_gzipped_size = 128;
   int32 tl_constructor = function.get_id();
   int32 total_timeout_limit = 60;
@@ -82,6 +72,20 @@ NetQueryPtr NetQueryCreator::create(uint64 id, const telegram_api::object_ptr<te
     }
   }
 
+  auto storer = DefaultStorer<telegram_api::Function>(function);
+  auto size = prefix_str.size() + storer.size();
+  // the uncompressed query is destroyed right after compression, so it can be allocated from the arena;
+  // otherwise, it is kept until the query is answered and must not pin an arena chunk
+  bool is_short_living = size >= min_gzipped_size;
+  auto slice = is_short_living ? BufferSlice::create_short_living(size) : BufferSlice(size);
+  auto real_size = storer.store(slice.as_mutable_slice().ubegin() + prefix_str.size());
+  LOG_CHECK(prefix_str.size() + real_size == slice.size())
+      << prefix_str.size() << ' ' << real_size << ' ' << slice.size() << ' '
+      << format::as_hex_dump<4>(slice.as_slice());
+  if (prefix != nullptr) {
+    slice.as_mutable_slice().copy_from(prefix_str);
+  }
+
   auto gzip_flag = slice.size() < min_gzipped_size ? NetQuery::GzipFlag::Off : NetQuery::GzipFlag::On;
   if (slice.size() >= 16384) {
     // test compression ratio for the middle part
@@ -92,6 +96,7 @@ NetQueryPtr NetQueryCreator::create(uint64 id, const telegram_api::object_ptr<te
       gzip_flag = NetQuery::GzipFlag::Off;
     }
   }
+  auto uncompressed_size = slice.size();
   if (gzip_flag == NetQuery::GzipFlag::On) {
     BufferSlice compressed = gzencode(slice.as_slice(), 0.9);
     if (compressed.empty()) {
@@ -100,10 +105,14 @@ NetQueryPtr NetQueryCreator::create(uint64 id, const telegram_api::object_ptr<te
       slice = std::move(compressed);
     }
   }
+  if (is_short_living && gzip_flag == NetQuery::GzipFlag::Off) {
+    slice = BufferSlice(slice.as_slice());
+  }
 
   auto query = object_pool_.create(id, std::move(slice), dc_id, type, auth_flag, gzip_flag, tl_constructor,
                                    total_timeout_limit, net_query_stats_.get(), std::move(chain_ids));
   query->set_cancellation_token(query.generation());
+  query->set_uncompressed_query_size(uncompressed_size);
   return query;
 }
 
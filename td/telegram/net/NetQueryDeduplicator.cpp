@@ -0,0 +1,85 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/NetQueryDeduplicator.h"
+
+#include "td/telegram/Global.h"
+#include "td/telegram/net/NetQueryDispatcher.h"
+#include "td/telegram/telegram_api.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/SliceBuilder.h"
+
+namespace td {
+
+bool NetQueryDeduplicator::need_deduplication(const NetQuery &query) {
+  if (query.deduplication_id_ != 0 || query.is_ready() || !query.get_chain_ids().empty() ||
+      !query.invoke_after().empty() || query.has_verification_prefix()) {
+    return false;
+  }
+  switch (query.tl_constructor()) {
+    case telegram_api::users_getUsers::ID:
+    case telegram_api::users_getFullUser::ID:
+    case telegram_api::messages_getChats::ID:
+    case telegram_api::messages_getFullChat::ID:
+    case telegram_api::channels_getChannels::ID:
+    case telegram_api::channels_getFullChannel::ID:
+    case telegram_api::messages_getStickerSet::ID:
+    case telegram_api::messages_getCustomEmojiDocuments::ID:
+      return true;
+    default:
+      return false;
+  }
+}
+
+string NetQueryDeduplicator::get_query_key(const NetQuery &query) {
+  auto dc_id = query.dc_id();
+  string key = PSTRING() << (dc_id.is_main() ? 0 : dc_id.get_raw_id()) << ' ' << static_cast<int32>(query.type()) << ' '
+                         << static_cast<int32>(query.auth_flag()) << ' ';
+  key += query.query().as_slice().str();
+  return key;
+}
+
+void NetQueryDeduplicator::add_query(NetQueryPtr query) {
+  CHECK(!query.empty());
+  auto deduplication_id = queries_.add_query(get_query_key(*query), query);
+  if (deduplication_id == 0) {
+    return;
+  }
+  query->deduplication_id_ = deduplication_id;
+  G()->net_query_dispatcher().dispatch(std::move(query));
+}
+
+void NetQueryDeduplicator::on_query_result(uint64 deduplication_id, Result<BufferSlice> r_answer) {
+  auto waiting_queries = queries_.on_query_result(deduplication_id);
+  if (r_answer.is_error() && r_answer.error().code() == NetQuery::Canceled) {
+    // the query was canceled by its owner; the waiting queries must be sent anew
+    for (auto &query : waiting_queries) {
+      add_query(std::move(query));
+    }
+    return;
+  }
+
+  for (auto &query : waiting_queries) {
+    if (r_answer.is_ok()) {
+      query->set_ok(r_answer.ok().clone());
+    } else {
+      query->set_error(r_answer.error().clone());
+    }
+    query->debug("receive the result of an identical query");
+    G()->net_query_dispatcher().dispatch(std::move(query));
+  }
+}
+
+void NetQueryDeduplicator::tear_down() {
+  for (auto &query : queries_.clear()) {
+    query->set_error(Global::request_aborted_error());
+    G()->net_query_dispatcher().dispatch(std::move(query));
+  }
+  parent_.reset();
+}
+
+}  // namespace td
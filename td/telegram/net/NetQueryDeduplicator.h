@@ -0,0 +1,94 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/net/NetQuery.h"
+
+#include "td/actor/actor.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+// Keeps queries, which wait for the result of an identical query sent before them
+template <class QueryT>
+class DeduplicatedQueries {
+ public:
+  // returns a new deduplication identifier for the query, which must be sent,
+  // or 0 if the query was moved to the queries waiting for the result of an identical query
+  uint64 add_query(string key, QueryT &query) {
+    auto it = key_to_deduplication_id_.find(key);
+    if (it != key_to_deduplication_id_.end()) {
+      pending_queries_[it->second].waiting_queries_.push_back(std::move(query));
+      return 0;
+    }
+
+    auto deduplication_id = next_deduplication_id_++;
+    key_to_deduplication_id_.emplace(key, deduplication_id);
+    pending_queries_[deduplication_id].key_ = std::move(key);
+    return deduplication_id;
+  }
+
+  // returns the queries, which were waiting for the result of the query with the given deduplication identifier
+  vector<QueryT> on_query_result(uint64 deduplication_id) {
+    auto it = pending_queries_.find(deduplication_id);
+    if (it == pending_queries_.end()) {
+      return {};
+    }
+    auto pending_query = std::move(it->second);
+    pending_queries_.erase(it);
+    key_to_deduplication_id_.erase(pending_query.key_);
+    return std::move(pending_query.waiting_queries_);
+  }
+
+  vector<QueryT> clear() {
+    vector<QueryT> result;
+    for (auto &it : pending_queries_) {
+      append(result, std::move(it.second.waiting_queries_));
+    }
+    pending_queries_.clear();
+    key_to_deduplication_id_.clear();
+    return result;
+  }
+
+ private:
+  struct PendingQuery {
+    string key_;
+    vector<QueryT> waiting_queries_;
+  };
+  FlatHashMap<uint64, PendingQuery> pending_queries_;
+  FlatHashMap<string, uint64> key_to_deduplication_id_;
+  uint64 next_deduplication_id_ = 1;
+};
+
+// Merges concurrent identical read-only queries: only the first of them is sent, and its result is copied to the others
+class NetQueryDeduplicator final : public Actor {
+ public:
+  explicit NetQueryDeduplicator(ActorShared<> parent) : parent_(std::move(parent)) {
+  }
+
+  static bool need_deduplication(const NetQuery &query);
+
+  void add_query(NetQueryPtr query);
+
+  void on_query_result(uint64 deduplication_id, Result<BufferSlice> r_answer);
+
+ private:
+  DeduplicatedQueries<NetQueryPtr> queries_;
+
+  ActorShared<> parent_;
+
+  static string get_query_key(const NetQuery &query);
+
+  void tear_down() final;
+};
+
+}  // namespace td
@@ -38,6 +38,9 @@ void NetQueryDelayer::delay(NetQueryPtr query) {
                         Slice("TAKEOUT_INIT_DELAY_"), Slice("FLOOD_PREMIUM_WAIT_")}) {
       if (begins_with(error_message, prefix)) {
         timeout = clamp(to_integer<int>(error_message.substr(prefix.size())), 1, 14 * 24 * 60 * 60);
+        if (prefix == "FLOOD_WAIT_") {
+          G()->net_query_dispatcher().on_flood_wait(query, timeout);
+        }
         if (prefix == "FLOOD_PREMIUM_WAIT_") {
           switch (query->type()) {
             case NetQuery::Type::Common:
@@ -99,6 +102,17 @@ void NetQueryDelayer::delay(NetQueryPtr query) {
   LOG(WARNING) << "Delay: " << query << " " << tag("timeout", timeout) << tag("total_timeout", query->total_timeout_)
                << " because of " << error << " from " << query->source_;
   query->debug(PSTRING() << "delay for " << format::as_time(timeout));
+  add_query(std::move(query), timeout);
+}
+
+void NetQueryDelayer::delay_send(NetQueryPtr query, double timeout) {
+  CHECK(!query->is_ready());
+  query->debug(PSTRING() << "pace for " << format::as_time(timeout));
+  add_query(std::move(query), timeout);
+}
+
+void NetQueryDelayer::add_query(NetQueryPtr query, double timeout) {
+  query->start_stage();
   auto id = container_.create(QuerySlot());
   auto *query_slot = container_.get(id);
   query_slot->query_ = std::move(query);
@@ -120,6 +134,7 @@ void NetQueryDelayer::on_slot_event(uint64 id) {
     return;
   }
   auto query = std::move(slot->query_);
+  query->finish_stage(NetQueryStats::Stage::Delay);
   if (!query->invoke_after().empty()) {
     // Fail query after timeout expired if it is a part of an invokeAfter chain.
     // It is not necessary but helps to avoid server problems, when previous query was lost.
@@ -21,6 +21,9 @@ class NetQueryDelayer final : public Actor {
   }
   void delay(NetQueryPtr query);
 
+  // delays sending of a new query to keep the pace of queries of the same method after a flood wait
+  void delay_send(NetQueryPtr query, double timeout);
+
  private:
   struct QuerySlot {
     NetQueryPtr query_;
@@ -30,6 +33,8 @@ class NetQueryDelayer final : public Actor {
   ActorShared<> parent_;
   void wakeup() final;
 
+  void add_query(NetQueryPtr query, double timeout);
+
   void on_slot_event(uint64 id);
 
   void tear_down() final;
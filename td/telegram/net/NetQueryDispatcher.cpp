@@ -10,6 +10,7 @@
 #include "td/telegram/net/AuthDataShared.h"
 #include "td/telegram/net/DcAuthManager.h"
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryDeduplicator.h"
 #include "td/telegram/net/NetQueryDelayer.h"
 #include "td/telegram/net/NetQueryVerifier.h"
 #include "td/telegram/net/PublicRsaKeySharedCdn.h"
@@ -29,12 +30,31 @@
 #include "td/utils/port/sleep.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
 
 namespace td {
 
 #define TD_TEST_VERIFICATION 0
 
 void NetQueryDispatcher::complete_net_query(NetQueryPtr net_query) {
+  if (net_query->deduplication_id_ != 0 && !stop_flag_.load(std::memory_order_relaxed)) {
+    // copy the result to identical queries, which are waiting for it
+    auto deduplication_id = net_query->deduplication_id_;
+    net_query->deduplication_id_ = 0;
+    Result<BufferSlice> r_answer;
+    if (net_query->is_ok()) {
+      r_answer = net_query->ok().clone();
+    } else {
+      r_answer = net_query->error().clone();
+    }
+    std::lock_guard<std::mutex> guard(mutex_);
+    send_closure_later(deduplicator_, &NetQueryDeduplicator::on_query_result, deduplication_id, std::move(r_answer));
+  }
+
+  if (net_query->is_ok()) {
+    rate_model_.on_query_ok(net_query->tl_constructor(), Time::now());
+  }
+
   auto callback = net_query->move_callback();
   if (callback.empty()) {
     net_query->debug("sent to td (no callback)");
@@ -45,7 +65,7 @@ void NetQueryDispatcher::complete_net_query(NetQueryPtr net_query) {
   }
 }
 
-bool NetQueryDispatcher::check_stop_flag(NetQueryPtr &net_query) const {
+bool NetQueryDispatcher::check_stop_flag(NetQueryPtr &net_query) {
   if (stop_flag_.load(std::memory_order_relaxed)) {
     net_query->set_error(Global::request_aborted_error());
     complete_net_query(std::move(net_query));
@@ -121,7 +141,18 @@ void NetQueryDispatcher::dispatch(NetQueryPtr net_query) {
     }
   }
 
+  if (use_network_query_deduplication_.load(std::memory_order_relaxed) &&
+      NetQueryDeduplicator::need_deduplication(*net_query)) {
+    net_query->debug("sent to NetQueryDeduplicator");
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (check_stop_flag(net_query)) {
+      return;
+    }
+    return send_closure_later(deduplicator_, &NetQueryDeduplicator::add_query, std::move(net_query));
+  }
+
   if (!net_query->is_ready()) {
+    net_query->start_stage();
     if (net_query->dispatch_ttl_ == 0) {
       net_query->set_error(Status::Error("DispatchTtlError"));
     }
@@ -139,10 +170,33 @@ void NetQueryDispatcher::dispatch(NetQueryPtr net_query) {
     return complete_net_query(std::move(net_query));
   }
 
+  if (net_query->is_paced_) {
+    net_query->is_paced_ = false;
+  } else if (net_query->invoke_after().empty() && use_flood_wait_pacing_.load(std::memory_order_relaxed)) {
+    auto delay = rate_model_.get_send_delay(net_query->tl_constructor(), Time::now());
+    if (delay > 0) {
+      auto timeout = static_cast<int32>(delay) + 1;
+      if (net_query->total_timeout_ + timeout > net_query->total_timeout_limit_) {
+        // the query would receive a flood wait error anyway
+        net_query->set_error(Status::Error(429, PSLICE() << "Too Many Requests: retry after " << timeout));
+        return complete_net_query(std::move(net_query));
+      }
+      net_query->total_timeout_ += timeout;
+      net_query->is_paced_ = true;
+      net_query->debug("sent to NetQueryDelayer for pacing");
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (check_stop_flag(net_query)) {
+        return;
+      }
+      return send_closure_later(delayer_, &NetQueryDelayer::delay_send, std::move(net_query), delay);
+    }
+  }
+
   if (net_query->dispatch_ttl_ > 0) {
     net_query->dispatch_ttl_--;
   }
 
+  net_query->set_stats_dc_id(dest_dc_id.get_raw_id());
   auto dc_pos = static_cast<size_t>(dest_dc_id.get_raw_id() - 1);
   CHECK(dc_pos < dcs_.size());
   std::lock_guard<std::mutex> guard(mutex_);
@@ -171,6 +225,13 @@ void NetQueryDispatcher::dispatch(NetQueryPtr net_query) {
   }
 }
 
+void NetQueryDispatcher::on_flood_wait(const NetQueryPtr &net_query, int32 wait_time) {
+  if (!use_flood_wait_pacing_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  rate_model_.on_flood_wait(net_query->tl_constructor(), wait_time, Time::now());
+}
+
 Status NetQueryDispatcher::wait_dc_init(DcId dc_id, bool force) {
   // TODO: optimize
   if (!dc_id.is_exact()) {
@@ -258,6 +319,7 @@ void NetQueryDispatcher::stop() {
   std::lock_guard<std::mutex> guard(mutex_);
   stop_flag_ = true;
   delayer_.reset();
+  deduplicator_.reset();
   verifier_.reset();
   for (auto &dc : dcs_) {
     dc.main_session_.reset();
@@ -304,6 +366,23 @@ void NetQueryDispatcher::destroy_auth_keys(Promise<> promise) {
   send_closure_later(dc_auth_manager_, &DcAuthManager::destroy, std::move(promise));
 }
 
+void NetQueryDispatcher::update_sequence_dispatcher_limits() {
+  auto max_active_chain_query_count =
+      narrow_cast<int32>(G()->get_option_integer("sequence_max_active_chain_query_count", 10));
+  auto max_active_query_count = narrow_cast<int32>(G()->get_option_integer("sequence_max_active_query_count", 0));
+  std::lock_guard<std::mutex> guard(mutex_);
+  send_closure_later(sequence_dispatcher_, &MultiSequenceDispatcher::update_limits, max_active_chain_query_count,
+                     max_active_query_count);
+}
+
+void NetQueryDispatcher::update_use_network_query_deduplication() {
+  use_network_query_deduplication_ = G()->get_option_boolean("use_network_query_deduplication");
+}
+
+void NetQueryDispatcher::update_use_flood_wait_pacing() {
+  use_flood_wait_pacing_ = G()->get_option_boolean("use_flood_wait_pacing");
+}
+
 void NetQueryDispatcher::update_use_pfs() {
   std::lock_guard<std::mutex> guard(mutex_);
   bool use_pfs = get_use_pfs();
@@ -351,6 +430,7 @@ NetQueryDispatcher::NetQueryDispatcher(const std::function<ActorShared<>()> &cre
     main_dc_id_ = to_integer<int32>(s_main_dc_id);
   }
   delayer_ = create_actor<NetQueryDelayer>("NetQueryDelayer", create_reference());
+  deduplicator_ = create_actor<NetQueryDeduplicator>("NetQueryDeduplicator", create_reference());
 #if TD_ANDROID || TD_DARWIN_IOS || TD_DARWIN_VISION_OS || TD_DARWIN_WATCH_OS || TD_TEST_VERIFICATION
   verifier_ = create_actor<NetQueryVerifier>("NetQueryVerifier", create_reference());
 #endif
@@ -358,6 +438,9 @@ NetQueryDispatcher::NetQueryDispatcher(const std::function<ActorShared<>()> &cre
       create_actor_on_scheduler<DcAuthManager>("DcAuthManager", get_main_session_scheduler_id(), create_reference());
   public_rsa_key_watchdog_ = create_actor<PublicRsaKeyWatchdog>("PublicRsaKeyWatchdog", create_reference());
   sequence_dispatcher_ = MultiSequenceDispatcher::create("MultiSequenceDispatcher");
+  update_sequence_dispatcher_limits();
+  update_use_flood_wait_pacing();
+  update_use_network_query_deduplication();
 
   td_guard_ = create_shared_lambda_guard([actor = create_reference()] {});
 }
@@ -8,6 +8,7 @@
 
 #include "td/telegram/net/DcId.h"
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryRateModel.h"
 
 #include "td/actor/actor.h"
 
@@ -26,6 +27,7 @@ namespace td {
 
 class DcAuthManager;
 class MultiSequenceDispatcher;
+class NetQueryDeduplicator;
 class NetQueryDelayer;
 class NetQueryVerifier;
 class PublicRsaKeyWatchdog;
@@ -49,6 +51,9 @@ class NetQueryDispatcher {
   void destroy_auth_keys(Promise<> promise);
   void update_use_pfs();
   void update_mtproto_header();
+  void update_sequence_dispatcher_limits();
+  void update_use_flood_wait_pacing();
+  void update_use_network_query_deduplication();
 
   DcId get_main_dc_id() const {
     return DcId::internal(main_dc_id_.load(std::memory_order_relaxed));
@@ -59,10 +64,16 @@ class NetQueryDispatcher {
 
   void set_verification_token(int64 verification_id, string &&token, Promise<Unit> &&promise);
 
+  // must be called when a FLOOD_WAIT error is received for the query
+  void on_flood_wait(const NetQueryPtr &net_query, int32 wait_time);
+
  private:
   std::atomic<bool> stop_flag_{false};
+  std::atomic<bool> use_flood_wait_pacing_{false};
+  std::atomic<bool> use_network_query_deduplication_{false};
   bool need_destroy_auth_key_{false};
   ActorOwn<NetQueryDelayer> delayer_;
+  ActorOwn<NetQueryDeduplicator> deduplicator_;
   ActorOwn<NetQueryVerifier> verifier_;
   ActorOwn<DcAuthManager> dc_auth_manager_;
   ActorOwn<MultiSequenceDispatcher> sequence_dispatcher_;
@@ -85,6 +96,7 @@ class NetQueryDispatcher {
   ActorOwn<PublicRsaKeyWatchdog> public_rsa_key_watchdog_;
   std::mutex mutex_;
   std::shared_ptr<Guard> td_guard_;
+  NetQueryRateModel rate_model_;
 
   Status wait_dc_init(DcId dc_id, bool force);
   bool is_dc_inited(int32 raw_dc_id);
@@ -93,8 +105,8 @@ class NetQueryDispatcher {
   static int32 get_session_count();
   static bool get_use_pfs();
 
-  static void complete_net_query(NetQueryPtr net_query);
-  bool check_stop_flag(NetQueryPtr &net_query) const;
+  void complete_net_query(NetQueryPtr net_query);
+  bool check_stop_flag(NetQueryPtr &net_query);
 
   void try_fix_migrate(NetQueryPtr &net_query);
 };
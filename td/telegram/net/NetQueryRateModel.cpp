@@ -0,0 +1,63 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/NetQueryRateModel.h"
+
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+
+namespace td {
+
+constexpr double NetQueryRateModel::MIN_INTERVAL;
+constexpr double NetQueryRateModel::INITIAL_INTERVAL;
+constexpr double NetQueryRateModel::MAX_INTERVAL;
+constexpr double NetQueryRateModel::INTERVAL_DECREASE_FACTOR;
+
+void NetQueryRateModel::on_flood_wait(int32 tl_constructor, int32 wait_time, double now) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto &info = rates_[tl_constructor];
+  info.blocked_until_ = max(info.blocked_until_, now + wait_time);
+  info.next_send_time_ = max(info.next_send_time_, info.blocked_until_);
+  info.interval_ = info.interval_ == 0.0 ? INITIAL_INTERVAL : min(info.interval_ * 2, MAX_INTERVAL);
+  size_.store(rates_.size(), std::memory_order_relaxed);
+  LOG(INFO) << "Pace queries " << format::as_hex(tl_constructor) << " with interval " << info.interval_
+            << " after flood wait for " << wait_time << " seconds";
+}
+
+void NetQueryRateModel::on_query_ok(int32 tl_constructor, double now) {
+  if (size_.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = rates_.find(tl_constructor);
+  if (it == rates_.end()) {
+    return;
+  }
+  auto &info = it->second;
+  info.interval_ *= INTERVAL_DECREASE_FACTOR;
+  if (info.interval_ < MIN_INTERVAL && info.next_send_time_ <= now) {
+    LOG(INFO) << "Stop to pace queries " << format::as_hex(tl_constructor);
+    rates_.erase(it);
+    size_.store(rates_.size(), std::memory_order_relaxed);
+  }
+}
+
+double NetQueryRateModel::get_send_delay(int32 tl_constructor, double now) {
+  if (size_.load(std::memory_order_relaxed) == 0) {
+    return 0.0;
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = rates_.find(tl_constructor);
+  if (it == rates_.end()) {
+    return 0.0;
+  }
+  auto &info = it->second;
+  auto send_time = max(info.next_send_time_, now);
+  info.next_send_time_ = send_time + info.interval_;
+  return send_time - now;
+}
+
+}  // namespace td
@@ -0,0 +1,47 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace td {
+
+// Paces queries of a method after a FLOOD_WAIT error was received for one of them. The server reports FLOOD_WAIT_X
+// for the method and the whole account, so queries are paced regardless of the DC they are sent to.
+// The minimum interval between queries is doubled after each flood wait and slowly decreased after each successful
+// query, until the pacing isn't needed anymore. All methods can be called from any thread.
+class NetQueryRateModel {
+ public:
+  void on_flood_wait(int32 tl_constructor, int32 wait_time, double now);
+
+  void on_query_ok(int32 tl_constructor, double now);
+
+  // reserves a send slot for a new query and returns the time to wait before sending it
+  double get_send_delay(int32 tl_constructor, double now);
+
+  static constexpr double MIN_INTERVAL = 0.05;
+  static constexpr double INITIAL_INTERVAL = 0.5;
+  static constexpr double MAX_INTERVAL = 30.0;
+  static constexpr double INTERVAL_DECREASE_FACTOR = 0.95;
+
+ private:
+  struct RateInfo {
+    double blocked_until_ = 0.0;
+    double next_send_time_ = 0.0;
+    double interval_ = 0.0;
+  };
+
+  std::atomic<size_t> size_{0};
+  std::mutex mutex_;
+  FlatHashMap<int32, RateInfo> rates_;
+};
+
+}  // namespace td
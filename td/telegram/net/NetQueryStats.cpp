@@ -8,21 +8,127 @@
 
 #include "td/telegram/net/NetQuery.h"
 
+#include "td/utils/algorithm.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
 
+#include <algorithm>
+#include <tuple>
+
 namespace td {
 
 uint64 NetQueryStats::get_count() const {
   return count_.load(std::memory_order_relaxed);
 }
 
+double NetQueryStats::get_average_queue_wait_time() const {
+  auto count = queue_wait_count_.load(std::memory_order_relaxed);
+  if (count == 0) {
+    return 0.0;
+  }
+  return static_cast<double>(queue_wait_time_us_.load(std::memory_order_relaxed)) * 1e-6 / static_cast<double>(count);
+}
+
+uint64 NetQueryStats::get_latency_key(Stage stage, int32 tl_constructor, int32 dc_id) {
+  auto key = (static_cast<uint64>(static_cast<uint32>(tl_constructor)) << 32) |
+             (static_cast<uint64>(static_cast<uint32>(dc_id) & 0xFFFF) << 8) |
+             (static_cast<uint64>(stage) + 1);
+
+  // ConcurrentHashMap needs random keys, so mix the bits with a bijective function, which keeps the key non-zero
+  key ^= key >> 33;
+  key *= static_cast<uint64>(0xFF51AFD7ED558CCD);
+  key ^= key >> 33;
+  key *= static_cast<uint64>(0xC4CEB9FE1A85EC53);
+  key ^= key >> 33;
+  return key;
+}
+
+NetQueryStats::LatencyNode *NetQueryStats::add_latency_node(uint64 key, Stage stage, int32 tl_constructor,
+                                                            int32 dc_id) {
+  std::lock_guard<std::mutex> guard(latency_mutex_);
+  auto node = latencies_.find(key, nullptr);
+  if (node == nullptr) {
+    auto new_node = make_unique<LatencyNode>();
+    new_node->info_.stage = stage;
+    new_node->info_.tl_constructor = tl_constructor;
+    new_node->info_.dc_id = dc_id;
+    node = new_node.get();
+    latency_nodes_.push_back(std::move(new_node));
+    latencies_.insert(key, node);
+  }
+  return node;
+}
+
+void NetQueryStats::on_stage_finished(Stage stage, int32 tl_constructor, int32 dc_id, double duration) {
+  auto key = get_latency_key(stage, tl_constructor, dc_id);
+  auto node = latencies_.find(key, nullptr);
+  if (node == nullptr) {
+    node = add_latency_node(key, stage, tl_constructor, dc_id);
+  }
+  std::lock_guard<std::mutex> guard(node->mutex_);
+  node->info_.histogram.add(duration);
+}
+
+vector<NetQueryStats::LatencyInfo> NetQueryStats::get_latency_statistics() const {
+  vector<LatencyInfo> result;
+  {
+    std::lock_guard<std::mutex> guard(latency_mutex_);
+    result.reserve(latency_nodes_.size());
+    for (auto &node : latency_nodes_) {
+      std::lock_guard<std::mutex> node_guard(node->mutex_);
+      result.push_back(node->info_);
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const LatencyInfo &lhs, const LatencyInfo &rhs) {
+    return std::tie(lhs.stage, lhs.tl_constructor, lhs.dc_id) < std::tie(rhs.stage, rhs.tl_constructor, rhs.dc_id);
+  });
+  return result;
+}
+
+Slice NetQueryStats::get_stage_name(Stage stage) {
+  switch (stage) {
+    case Stage::Dispatch:
+      return Slice("dispatch");
+    case Stage::Delay:
+      return Slice("delay");
+    case Stage::SessionQueue:
+      return Slice("session_queue");
+    case Stage::InFlight:
+      return Slice("in_flight");
+    case Stage::ResponseProcessing:
+      return Slice("response_processing");
+    case Stage::SequenceWait:
+      return Slice("sequence_wait");
+    default:
+      UNREACHABLE();
+      return Slice();
+  }
+}
+
+string NetQueryStats::get_prometheus_latency_statistics(const vector<LatencyInfo> &latencies) {
+  static const string metric_name = "tdlib_network_query_latency_seconds";
+  string result = PSTRING() << "# HELP " << metric_name << " Duration of stages of network query processing\n"
+                            << "# TYPE " << metric_name << " summary\n";
+  for (auto &info : latencies) {
+    string labels = PSTRING() << "stage=\"" << get_stage_name(info.stage) << "\",constructor=\""
+                              << format::as_hex(info.tl_constructor) << "\",dc=\"" << info.dc_id << '"';
+    for (auto quantile : {Slice("0.5"), Slice("0.9"), Slice("0.99")}) {
+      result += PSTRING() << metric_name << '{' << labels << ",quantile=\"" << quantile << "\"} "
+                          << info.histogram.get_quantile(to_double(quantile)) << '\n';
+    }
+    result += PSTRING() << metric_name << "_sum{" << labels << "} " << info.histogram.get_total() << '\n';
+    result += PSTRING() << metric_name << "_count{" << labels << "} " << info.histogram.get_count() << '\n';
+  }
+  return result;
+}
+
 void NetQueryStats::dump_pending_network_queries() {
   auto n = get_count();
-  LOG(WARNING) << tag("pending net queries", n);
+  LOG(WARNING) << tag("pending net queries", n)
+               << tag("average queue wait", format::as_time(get_average_queue_wait_time()));
 
   if (!use_list_) {
     return;
@@ -47,7 +153,8 @@ void NetQueryStats::dump_pending_network_queries() {
                    << tag("in this state", format::as_time(Time::now_cached() - debug.state_timestamp_))
                    << tag("state changed", debug.state_change_count_) << tag("resend count", debug.resend_count_)
                    << tag("fail count", debug.send_failed_count_) << tag("ack state", debug.ack_state_)
-                   << tag("unknown", debug.unknown_state_);
+                   << tag("unknown", debug.unknown_state_)
+                   << tag("queue wait", format::as_time(debug.queue_wait_time_));
     } else {
       was_gap = true;
     }
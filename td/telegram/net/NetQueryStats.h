@@ -9,9 +9,13 @@
 #include "td/telegram/net/NetQueryCounter.h"
 
 #include "td/utils/common.h"
+#include "td/utils/ConcurrentHashTable.h"
+#include "td/utils/LatencyHistogram.h"
+#include "td/utils/Slice.h"
 #include "td/utils/TsList.h"
 
 #include <atomic>
+#include <mutex>
 
 namespace td {
 
@@ -25,10 +29,21 @@ struct NetQueryDebug {
   int32 send_failed_count_ = 0;
   int32 ack_state_ = 0;
   bool unknown_state_ = false;
+  double queue_wait_time_ = 0;  // total time spent in Session queues before sending
 };
 
 class NetQueryStats {
  public:
+  // stages of a query processing, for which latency statistics are collected
+  enum class Stage : int32 { Dispatch, Delay, SessionQueue, InFlight, ResponseProcessing, SequenceWait, Size };
+
+  struct LatencyInfo {
+    Stage stage;
+    int32 tl_constructor;
+    int32 dc_id;
+    LatencyHistogram histogram;
+  };
+
   NetQueryCounter register_query(TsListNode<NetQueryDebug> *query) {
     if (use_list_.load(std::memory_order_relaxed)) {
       list_.put(query);
@@ -38,12 +53,49 @@ class NetQueryStats {
 
   uint64 get_count() const;
 
+  // can be called from any thread
+  void on_queue_wait(double wait_time) {
+    queue_wait_count_.store(queue_wait_count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    auto wait_time_us = static_cast<uint64>(max(wait_time, 0.0) * 1e6);
+    queue_wait_time_us_.store(queue_wait_time_us_.load(std::memory_order_relaxed) + wait_time_us,
+                              std::memory_order_relaxed);
+  }
+
+  double get_average_queue_wait_time() const;
+
+  // can be called from any thread
+  void on_stage_finished(Stage stage, int32 tl_constructor, int32 dc_id, double duration);
+
+  vector<LatencyInfo> get_latency_statistics() const;
+
+  static Slice get_stage_name(Stage stage);
+
+  // returns latency statistics in Prometheus text exposition format
+  static string get_prometheus_latency_statistics(const vector<LatencyInfo> &latencies);
+
   void dump_pending_network_queries();
 
  private:
   NetQueryCounter::Counter count_{0};
+  std::atomic<uint64> queue_wait_count_{0};
+  std::atomic<uint64> queue_wait_time_us_{0};
   std::atomic<bool> use_list_{true};
   TsList<NetQueryDebug> list_;
+
+  struct LatencyNode {
+    mutable std::mutex mutex_;
+    LatencyInfo info_;
+  };
+
+  // on_stage_finished is called from any thread, so the nodes are looked up without locking
+  // and are only added under latency_mutex_
+  mutable std::mutex latency_mutex_;
+  vector<unique_ptr<LatencyNode>> latency_nodes_;
+  ConcurrentHashMap<uint64, LatencyNode *> latencies_;
+
+  static uint64 get_latency_key(Stage stage, int32 tl_constructor, int32 dc_id);
+
+  LatencyNode *add_latency_node(uint64 key, Stage stage, int32 tl_constructor, int32 dc_id);
 };
 
 }  // namespace td
@@ -0,0 +1,63 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/NetRequestStats.h"
+
+#include <algorithm>
+
+namespace td {
+
+td_api::object_ptr<td_api::networkRequestStatistics> NetRequestStats::Entry::get_network_request_statistics_object()
+    const {
+  return td_api::make_object<td_api::networkRequestStatistics>(tl_constructor, request_count, sent_bytes,
+                                                               uncompressed_sent_bytes, response_count, received_bytes,
+                                                               uncompressed_received_bytes);
+}
+
+void NetRequestStats::on_request_sent(int32 tl_constructor, size_t size, size_t uncompressed_size) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto &entry = entries_[tl_constructor];
+  entry.tl_constructor = tl_constructor;
+  entry.request_count++;
+  entry.sent_bytes += static_cast<int64>(size);
+  entry.uncompressed_sent_bytes += static_cast<int64>(uncompressed_size);
+}
+
+void NetRequestStats::on_response_received(int32 tl_constructor, size_t size, size_t uncompressed_size) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto &entry = entries_[tl_constructor];
+  entry.tl_constructor = tl_constructor;
+  entry.response_count++;
+  entry.received_bytes += static_cast<int64>(size);
+  entry.uncompressed_received_bytes += static_cast<int64>(uncompressed_size);
+}
+
+vector<NetRequestStats::Entry> NetRequestStats::get_entries() const {
+  vector<Entry> result;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    result.reserve(entries_.size());
+    for (auto &it : entries_) {
+      result.push_back(it.second);
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const Entry &lhs, const Entry &rhs) {
+    auto lhs_size = lhs.sent_bytes + lhs.received_bytes;
+    auto rhs_size = rhs.sent_bytes + rhs.received_bytes;
+    if (lhs_size != rhs_size) {
+      return lhs_size > rhs_size;
+    }
+    return lhs.tl_constructor < rhs.tl_constructor;
+  });
+  return result;
+}
+
+void NetRequestStats::clear() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  entries_.clear();
+}
+
+}  // namespace td
@@ -0,0 +1,57 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/td_api.h"
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace td {
+
+// In-memory traffic statistics of network requests by TL constructor; all methods can be called from any thread.
+// The statistics are collected only if enabled, because they are updated under a global lock for every packet
+class NetRequestStats {
+ public:
+  struct Entry {
+    int32 tl_constructor = 0;
+    int64 request_count = 0;
+    int64 sent_bytes = 0;
+    int64 uncompressed_sent_bytes = 0;
+    int64 response_count = 0;
+    int64 received_bytes = 0;
+    int64 uncompressed_received_bytes = 0;
+
+    td_api::object_ptr<td_api::networkRequestStatistics> get_network_request_statistics_object() const;
+  };
+
+  void set_enabled(bool is_enabled) {
+    is_enabled_.store(is_enabled, std::memory_order_relaxed);
+  }
+
+  bool is_enabled() const {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  void on_request_sent(int32 tl_constructor, size_t size, size_t uncompressed_size);
+
+  void on_response_received(int32 tl_constructor, size_t size, size_t uncompressed_size);
+
+  vector<Entry> get_entries() const;
+
+  void clear();
+
+ private:
+  std::atomic<bool> is_enabled_{false};
+  mutable std::mutex mutex_;
+  FlatHashMap<int32, Entry> entries_;
+};
+
+}  // namespace td
@@ -136,6 +136,7 @@ void NetStatsManager::get_network_stats(bool current, Promise<NetworkStats> prom
     // LOG(ERROR) << total.read_size << " " << check.read_size;
     // LOG(ERROR) << total.write_size << " " << check.write_size;
   }
+  result.request_entries = request_stats_->get_entries();
 
   promise.set_value(std::move(result));
 }
@@ -152,6 +153,7 @@ void NetStatsManager::reset_network_stats() {
   };
 
   for_each_stat([&](NetStatsInfo &info, size_t id, CSlice name, FileType) { do_reset_network_stats(info); });
+  request_stats_->clear();
 
   auto unix_time = G()->unix_time();
   since_total_ = unix_time;
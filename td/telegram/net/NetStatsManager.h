@@ -7,6 +7,7 @@
 #pragma once
 
 #include "td/telegram/files/FileType.h"
+#include "td/telegram/net/NetRequestStats.h"
 #include "td/telegram/net/NetType.h"
 #include "td/telegram/td_api.h"
 
@@ -47,6 +48,7 @@ struct NetworkStatsEntry {
 struct NetworkStats {
   int32 since = 0;
   std::vector<NetworkStatsEntry> entries;
+  std::vector<NetRequestStats::Entry> request_entries;
 
   auto get_network_statistics_object() const {
     auto result = make_tl_object<td_api::networkStatistics>();
@@ -57,6 +59,10 @@ struct NetworkStats {
         result->entries_.push_back(entry.get_network_statistics_entry_object());
       }
     }
+    result->request_entries_.reserve(request_entries.size());
+    for (const auto &entry : request_entries) {
+      result->request_entries_.push_back(entry.get_network_request_statistics_object());
+    }
     return result;
   }
 };
@@ -70,6 +76,9 @@ class NetStatsManager final : public Actor {
   std::shared_ptr<NetStatsCallback> get_common_stats_callback() const;
   std::shared_ptr<NetStatsCallback> get_media_stats_callback() const;
   std::vector<std::shared_ptr<NetStatsCallback>> get_file_stats_callbacks() const;
+  std::shared_ptr<NetRequestStats> get_request_stats() const {
+    return request_stats_;
+  }
 
   void get_network_stats(bool current, Promise<NetworkStats> promise);
 
@@ -119,6 +128,7 @@ class NetStatsManager final : public Actor {
   NetStatsInfo media_net_stats_;
   std::array<NetStatsInfo, MAX_FILE_TYPE> files_stats_;
   NetStatsInfo call_net_stats_;
+  std::shared_ptr<NetRequestStats> request_stats_ = std::make_shared<NetRequestStats>();
   static constexpr int32 CALL_NET_STATS_ID{MAX_FILE_TYPE + 2};
 
   template <class F>
@@ -0,0 +1,142 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/ProxySelector.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/logging.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace td {
+
+uint32 ProxySelector::start_probe_round(const vector<int32> &proxy_ids, int32 date) {
+  round_++;
+  for (auto proxy_id : proxy_ids) {
+    auto &info = probe_infos_[proxy_id];
+    if (info.pending_round != 0) {
+      // the previous probe hasn't finished in time
+      add_probe_result(info, Status::Error("Probe timed out"), date);
+    }
+    info.pending_round = round_;
+  }
+  return round_;
+}
+
+bool ProxySelector::on_probe_result(int32 proxy_id, uint32 round, Result<double> r_rtt, int32 date) {
+  auto it = probe_infos_.find(proxy_id);
+  if (it == probe_infos_.end() || it->second.pending_round != round) {
+    // the proxy was removed or the probe has already been counted as failed
+    return false;
+  }
+  auto &info = it->second;
+  info.pending_round = 0;
+  add_probe_result(info, std::move(r_rtt), date);
+  return true;
+}
+
+void ProxySelector::on_network_changed() {
+  for (auto &it : probe_infos_) {
+    it.second.consecutive_failure_count = 0;
+    it.second.pending_round = 0;
+  }
+}
+
+void ProxySelector::remove_proxy(int32 proxy_id) {
+  probe_infos_.erase(proxy_id);
+}
+
+ProxySelector::ProbeInfo ProxySelector::get_probe_info(int32 proxy_id) const {
+  auto it = probe_infos_.find(proxy_id);
+  if (it == probe_infos_.end()) {
+    return ProbeInfo();
+  }
+  return it->second;
+}
+
+void ProxySelector::add_probe_result(ProbeInfo &info, Result<double> r_rtt, int32 date) {
+  info.probe_count++;
+  info.last_probe_date = date;
+  if (r_rtt.is_error()) {
+    LOG(INFO) << "Proxy probe failed: " << r_rtt.error();
+    info.consecutive_failure_count++;
+    return;
+  }
+
+  auto rtt = r_rtt.ok();
+  info.success_count++;
+  info.consecutive_failure_count = 0;
+  info.last_rtt = rtt;
+  if (info.average_rtt == 0) {
+    info.average_rtt = rtt;
+  } else {
+    info.average_rtt += (rtt - info.average_rtt) * RTT_SMOOTHING_FACTOR;
+  }
+}
+
+bool ProxySelector::is_proxy_available(const ProbeInfo &info) {
+  return info.success_count > 0 && info.consecutive_failure_count < MAX_PROBE_FAILURES;
+}
+
+vector<int32> ProxySelector::rank_proxies(const std::map<int32, ProbeInfo> &probe_infos) {
+  vector<std::pair<double, int32>> proxies;
+  for (auto &it : probe_infos) {
+    if (is_proxy_available(it.second)) {
+      proxies.emplace_back(it.second.average_rtt, it.first);
+    }
+  }
+  std::sort(proxies.begin(), proxies.end());
+  return transform(proxies, [](const std::pair<double, int32> &proxy) { return proxy.second; });
+}
+
+int32 ProxySelector::choose_proxy(const std::map<int32, ProbeInfo> &probe_infos, int32 active_proxy_id,
+                                  double time_since_last_switch) {
+  if (active_proxy_id == 0) {
+    // the user has chosen to connect directly
+    return 0;
+  }
+
+  const ProbeInfo *active_info = nullptr;
+  auto active_it = probe_infos.find(active_proxy_id);
+  if (active_it != probe_infos.end()) {
+    active_info = &active_it->second;
+  }
+  bool is_active_dead = active_info != nullptr && active_info->consecutive_failure_count >= MAX_PROBE_FAILURES;
+  if (!is_active_dead) {
+    if (active_info == nullptr || !is_proxy_available(*active_info) ||
+        time_since_last_switch < MIN_SWITCH_INTERVAL) {
+      return 0;
+    }
+  }
+
+  const ProbeInfo *best_info = nullptr;
+  int32 best_proxy_id = 0;
+  for (auto proxy_id : rank_proxies(probe_infos)) {
+    if (proxy_id == active_proxy_id) {
+      // the active proxy is the best of the proxies having enough measurements
+      return 0;
+    }
+    const auto &info = probe_infos.find(proxy_id)->second;
+    if (is_active_dead || info.success_count >= MIN_SWITCH_SUCCESS_COUNT) {
+      best_info = &info;
+      best_proxy_id = proxy_id;
+      break;
+    }
+  }
+  if (best_info == nullptr) {
+    return 0;
+  }
+  if (!is_active_dead) {
+    if (best_info->average_rtt * MIN_SWITCH_RTT_RATIO > active_info->average_rtt ||
+        best_info->average_rtt + MIN_SWITCH_RTT_GAIN > active_info->average_rtt) {
+      return 0;
+    }
+  }
+  return best_proxy_id;
+}
+
+}  // namespace td
@@ -0,0 +1,79 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Status.h"
+
+#include <map>
+
+namespace td {
+
+// results of background probing of added proxies, used for automatic proxy selection
+class ProxySelector {
+ public:
+  struct ProbeInfo {
+    int32 probe_count{0};
+    int32 success_count{0};
+    int32 consecutive_failure_count{0};
+    int32 last_probe_date{0};
+    double last_rtt{0};
+    double average_rtt{0};
+    uint32 pending_round{0};
+  };
+
+  static constexpr double RTT_SMOOTHING_FACTOR = 0.3;
+  static constexpr int32 MAX_PROBE_FAILURES = 2;
+  // hysteresis of automatic switching from a working proxy
+  static constexpr int32 MIN_SWITCH_SUCCESS_COUNT = 3;
+  static constexpr double MIN_SWITCH_INTERVAL = 600;
+  static constexpr double MIN_SWITCH_RTT_RATIO = 1.5;
+  static constexpr double MIN_SWITCH_RTT_GAIN = 0.05;
+
+  // starts a new probe round and returns its identifier; unfinished probes of the previous round are counted as failed
+  uint32 start_probe_round(const vector<int32> &proxy_ids, int32 date);
+
+  // returns false if the result is stale, because the probe has already been counted as failed
+  bool on_probe_result(int32 proxy_id, uint32 round, Result<double> r_rtt, int32 date);
+
+  // probes through the previous network say nothing about the new one
+  void on_network_changed();
+
+  void on_proxy_switched(double now) {
+    last_switch_time_ = now;
+  }
+
+  void remove_proxy(int32 proxy_id);
+
+  ProbeInfo get_probe_info(int32 proxy_id) const;
+
+  vector<int32> get_ranked_proxy_ids() const {
+    return rank_proxies(probe_infos_);
+  }
+
+  // returns the proxy, which must be enabled instead of the active proxy, or 0 if the active proxy must be kept
+  int32 choose_proxy(int32 active_proxy_id, double now) const {
+    return choose_proxy(probe_infos_, active_proxy_id, now - last_switch_time_);
+  }
+
+  static bool is_proxy_available(const ProbeInfo &info);
+
+  // returns identifiers of available proxies ordered by average RTT
+  static vector<int32> rank_proxies(const std::map<int32, ProbeInfo> &probe_infos);
+
+  static int32 choose_proxy(const std::map<int32, ProbeInfo> &probe_infos, int32 active_proxy_id,
+                            double time_since_last_switch);
+
+ private:
+  std::map<int32, ProbeInfo> probe_infos_;
+  uint32 round_{0};
+  double last_switch_time_{0};
+
+  static void add_probe_result(ProbeInfo &info, Result<double> r_rtt, int32 date);
+};
+
+}  // namespace td
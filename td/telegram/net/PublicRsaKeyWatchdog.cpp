@@ -8,6 +8,7 @@
 
 #include "td/telegram/Global.h"
 #include "td/telegram/net/NetQueryCreator.h"
+#include "td/telegram/net/SharedNetConfig.h"
 #include "td/telegram/TdDb.h"
 #include "td/telegram/telegram_api.h"
 #include "td/telegram/Version.h"
@@ -15,6 +16,7 @@
 #include "td/mtproto/RSA.h"
 
 #include "td/utils/logging.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
 
 namespace td {
@@ -75,6 +77,25 @@ void PublicRsaKeyWatchdog::loop() {
   if (ok) {
     return;
   }
+  if (use_shared_cdn_config()) {
+    auto value = SharedNetConfig::get_value(get_shared_cdn_config_key(), shared_cdn_config_version_);
+    switch (value.state) {
+      case SharedNetConfig::State::Ready:
+        LOG(INFO) << "Use shared CDN config of version " << value.version;
+        shared_cdn_config_version_ = value.version;
+        sync(std::move(value.data));
+        return;
+      case SharedNetConfig::State::Pending:
+        // another client is requesting the CDN config; wait for its result
+        set_timeout_in(1.0);
+        return;
+      case SharedNetConfig::State::Absent:
+        is_shared_cdn_config_requested_ = true;
+        break;
+      default:
+        UNREACHABLE();
+    }
+  }
   flood_control_.add_event(now);
   has_query_ = true;
   auto query = G()->net_query_creator().create(telegram_api::help_getCdnConfig());
@@ -85,13 +106,22 @@ void PublicRsaKeyWatchdog::loop() {
 void PublicRsaKeyWatchdog::on_result(NetQueryPtr net_query) {
   has_query_ = false;
   yield();
+  bool is_shared_cdn_config_requested = is_shared_cdn_config_requested_;
+  is_shared_cdn_config_requested_ = false;
   if (net_query->is_error()) {
     LOG(ERROR) << "Receive error for GetCdnConfig: " << net_query->move_as_error();
+    if (is_shared_cdn_config_requested) {
+      SharedNetConfig::on_request_failed(get_shared_cdn_config_key());
+    }
     loop();
     return;
   }
 
   auto buf = net_query->move_as_ok();
+  if (use_shared_cdn_config()) {
+    shared_cdn_config_version_ =
+        SharedNetConfig::set_value(get_shared_cdn_config_key(), buf.clone(), Time::now() + SHARED_CDN_CONFIG_TTL);
+  }
   G()->td_db()->get_binlog_pmc()->set("cdn_config_version", current_version_);
   G()->td_db()->get_binlog_pmc()->set("cdn_config" + current_version_, buf.as_slice().str());
   sync(std::move(buf));
@@ -119,6 +149,14 @@ void PublicRsaKeyWatchdog::sync(BufferSlice cdn_config_serialized) {
   }
 }
 
+bool PublicRsaKeyWatchdog::use_shared_cdn_config() {
+  return G()->get_option_boolean("use_shared_network_config");
+}
+
+string PublicRsaKeyWatchdog::get_shared_cdn_config_key() {
+  return PSTRING() << "cdn_config:" << G()->is_test_dc();
+}
+
 void PublicRsaKeyWatchdog::sync_key(std::shared_ptr<PublicRsaKeySharedCdn> &key) {
   if (!cdn_config_) {
     return;
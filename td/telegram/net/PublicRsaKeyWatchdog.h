@@ -29,12 +29,16 @@ class PublicRsaKeyWatchdog final : public NetActor {
   void add_public_rsa_key(std::shared_ptr<PublicRsaKeySharedCdn> key);
 
  private:
+  static constexpr double SHARED_CDN_CONFIG_TTL = 3600.0;
+
   ActorShared<> parent_;
   vector<std::shared_ptr<PublicRsaKeySharedCdn>> keys_;
   tl_object_ptr<telegram_api::cdnConfig> cdn_config_;
   FloodControlStrict flood_control_;
   bool has_query_{false};
   string current_version_;
+  int64 shared_cdn_config_version_ = 0;
+  bool is_shared_cdn_config_requested_ = false;
 
   void start_up() final;
   void loop() final;
@@ -42,6 +46,9 @@ class PublicRsaKeyWatchdog final : public NetActor {
   void on_result(NetQueryPtr net_query) final;
   void sync(BufferSlice cdn_config_serialized);
   void sync_key(std::shared_ptr<PublicRsaKeySharedCdn> &key);
+
+  static bool use_shared_cdn_config();
+  static string get_shared_cdn_config_key();
 };
 
 }  // namespace td
@@ -201,7 +201,7 @@ class GenAuthKeyActor final : public Actor {
     VLOG(dc) << "Receive raw connection " << raw_connection.get();
     network_generation_ = raw_connection->extra().extra;
     child_ = create_actor_on_scheduler<mtproto::HandshakeActor>(
-        PSLICE() << name_ + "::HandshakeActor", G()->get_slow_net_scheduler_id(), std::move(handshake_),
+        PSLICE() << name_ + "::HandshakeActor", G()->get_crypto_scheduler_id(), std::move(handshake_),
         std::move(raw_connection), std::move(context_), 10, std::move(connection_promise_),
         std::move(handshake_promise_));
   }
@@ -213,6 +213,7 @@ TD_THREAD_LOCAL Semaphore *GenAuthKeyActor::semaphore_{};
 }  // namespace detail
 
 void Session::PriorityQueue::push(NetQueryPtr query) {
+  query->on_queued();
   auto priority = query->priority();
   queries_[priority].push(std::move(query));
 }
@@ -224,6 +225,7 @@ NetQueryPtr Session::PriorityQueue::pop() {
   if (it->second.empty()) {
     queries_.erase(it);
   }
+  res->on_dequeued();
   return res;
 }
 
@@ -231,6 +233,35 @@ bool Session::PriorityQueue::empty() const {
   return queries_.empty();
 }
 
+size_t Session::InflightQueryLimit::get_limit(size_t max_limit) const {
+  return min(static_cast<size_t>(limit_), max_limit);
+}
+
+void Session::InflightQueryLimit::on_query_answered(double latency) {
+  if (min_latency_ == 0.0 || latency < min_latency_) {
+    min_latency_ = latency;
+  } else {
+    // slowly forget old measurements
+    min_latency_ += (latency - min_latency_) * 0.01;
+  }
+  if (latency > max(min_latency_ * LATENCY_FACTOR, MIN_CONGESTION_LATENCY)) {
+    on_congestion(Time::now());
+    return;
+  }
+  // increase the limit by one after each window of answered queries
+  limit_ = min(limit_ + 1.0 / limit_, static_cast<double>(MAX_INFLIGHT_QUERIES_LIMIT));
+}
+
+void Session::InflightQueryLimit::on_congestion(double now) {
+  // decrease the limit at most once per minimum latency
+  if (now < decreased_at_ + max(min_latency_, 0.1)) {
+    return;
+  }
+  decreased_at_ = now;
+  limit_ = max(limit_ * 0.5, MIN_LIMIT);
+  LOG(INFO) << "Decrease maximum number of sent queries to " << limit_;
+}
+
 Session::Session(unique_ptr<Callback> callback, std::shared_ptr<AuthDataShared> shared_auth_data, int32 raw_dc_id,
                  int32 dc_id, bool is_primary, bool is_main, bool use_pfs, bool persist_tmp_auth_key, bool is_cdn,
                  bool need_destroy_auth_key, const mtproto::AuthKey &tmp_auth_key,
@@ -326,7 +357,13 @@ void Session::on_network(bool network_flag, uint32 network_generation) {
   network_flag_ = network_flag;
   if (network_generation_ != network_generation) {
     network_generation_ = network_generation;
-    connection_close(&main_connection_);
+    if (network_flag && !close_flag_ && mode_ == Mode::Tcp && main_connection_.state_ == ConnectionInfo::State::Ready) {
+      // keep using the old connection, until a connection over the new network is ready
+      migrate_main_connection();
+    } else {
+      cancel_main_connection_migration();
+      connection_close(&main_connection_);
+    }
     connection_close(&long_poll_connection_);
   }
 
@@ -374,6 +411,7 @@ void Session::send(NetQueryPtr &&query) {
   last_activity_timestamp_ = Time::now();
 
   // query->debug(PSTRING() << get_name() << ": received from SessionProxy");
+  query->finish_stage(NetQueryStats::Stage::Dispatch);
   query->set_session_id(auth_data_.get_session_id());
   VLOG(net_query) << "Receive query " << query;
   if (query->update_is_ready()) {
@@ -491,6 +529,8 @@ void Session::return_query(NetQueryPtr &&query) {
   last_activity_timestamp_ = Time::now();
 
   query->set_session_id(0);
+  query->finish_stage(NetQueryStats::Stage::InFlight);
+  query->start_stage();
   callback_->on_result(std::move(query));
 }
 
@@ -505,6 +545,7 @@ void Session::flush_pending_invoke_after_queries() {
 void Session::close() {
   LOG(INFO) << "Close session (external)";
   close_flag_ = true;
+  cancel_main_connection_migration();
   connection_close(&main_connection_);
   connection_close(&long_poll_connection_);
 
@@ -624,6 +665,13 @@ void Session::on_closed(Status status) {
   if (!close_flag_ && is_main_) {
     connection_token_.reset();
   }
+  const auto &container_statistics = current_info_->connection_->get_container_statistics();
+  if (container_statistics.packet_count != 0) {
+    container_statistics_.add(container_statistics);
+    LOG(INFO) << "Sent " << container_statistics_.query_count << " queries in " << container_statistics_.packet_count
+              << " packets to DC " << dc_id_ << " with average container fill ratio "
+              << container_statistics_.get_fill_ratio();
+  }
   auto raw_connection = current_info_->connection_->move_as_raw_connection();
   Scheduler::unsubscribe_before_close(raw_connection->get_poll_info().get_pollable_fd_ref());
   raw_connection->close();
@@ -668,6 +716,9 @@ void Session::on_closed(Status status) {
     if (status.is_error()) {
       LOG(WARNING) << "Session connection with " << sent_queries_.size() << " pending requests was closed: " << status
                    << ' ' << current_info_->connection_->get_name();
+      if (!sent_queries_.empty()) {
+        inflight_query_limit_.on_congestion(Time::now());
+      }
     } else {
       LOG(INFO) << "Session connection with " << sent_queries_.size() << " pending requests was closed: " << status
                 << ' ' << current_info_->connection_->get_name();
@@ -874,6 +925,13 @@ Status Session::on_update(BufferSlice packet) {
   return Status::OK();
 }
 
+size_t Session::get_max_inflight_query_count() const {
+  auto max_limit = clamp(G()->get_option_integer("session_max_inflight_query_count",
+                                                 static_cast<int64>(MAX_INFLIGHT_QUERIES)),
+                         static_cast<int64>(1), static_cast<int64>(MAX_INFLIGHT_QUERIES_LIMIT));
+  return inflight_query_limit_.get_limit(static_cast<size_t>(max_limit));
+}
+
 Status Session::on_message_result_ok(mtproto::MessageId message_id, BufferSlice packet, size_t original_size) {
   last_success_timestamp_ = Time::now();
 
@@ -900,6 +958,7 @@ Status Session::on_message_result_ok(mtproto::MessageId message_id, BufferSlice
   auth_data_.on_api_response();
   Query *query_ptr = &it->second;
   VLOG(net_query) << "Return query result " << query_ptr->net_query_;
+  inflight_query_limit_.on_query_answered(last_success_timestamp_ - query_ptr->sent_at_);
 
   if (!parser.get_error()) {
     // Steal authorization information.
@@ -917,7 +976,7 @@ Status Session::on_message_result_ok(mtproto::MessageId message_id, BufferSlice
 
   cleanup_container(message_id, query_ptr);
   mark_as_known(message_id, query_ptr);
-  query_ptr->net_query_->on_net_read(original_size);
+  query_ptr->net_query_->on_net_read(original_size, packet.size());
   query_ptr->net_query_->set_ok(std::move(packet));
   query_ptr->net_query_->set_message_id(0);
   return_query(std::move(query_ptr->net_query_));
@@ -996,6 +1055,11 @@ void Session::on_message_result_error(mtproto::MessageId message_id, int error_c
 
   Query *query_ptr = &it->second;
   VLOG(net_query) << "Return query error " << query_ptr->net_query_;
+  if (error_code == 420 || error_code >= 500) {
+    inflight_query_limit_.on_congestion(Time::now());
+  } else {
+    inflight_query_limit_.on_query_answered(Time::now() - query_ptr->sent_at_);
+  }
 
   cleanup_container(message_id, query_ptr);
   mark_as_known(message_id, query_ptr);
@@ -1181,6 +1245,7 @@ void Session::connection_send_query(ConnectionInfo *info, NetQueryPtr &&net_quer
     LOG(DEBUG) << "Set event for net_query cancellation for " << message_id;
     net_query->cancel_slot_.set_event(EventCreator::raw(actor_id(), message_id.get()));
   }
+  net_query->start_stage();
   auto status =
       sent_queries_.emplace(message_id, Query{message_id, std::move(net_query), main_connection_.connection_id_, now});
   LOG_CHECK(status.second) << message_id;
@@ -1227,6 +1292,52 @@ void Session::connection_open(ConnectionInfo *info, double now, bool ask_info) {
   info->wakeup_at_ = now + 1000;
 }
 
+void Session::migrate_main_connection() {
+  LOG(INFO) << "Request new main connection after network change";
+  cached_connection_.reset();
+  is_main_connection_migrating_ = true;
+  migration_cancellation_token_source_ = CancellationTokenSource{};
+  auto promise = PromiseCreator::cancellable_lambda(
+      migration_cancellation_token_source_.get_cancellation_token(),
+      [actor_id = actor_id(this)](Result<unique_ptr<mtproto::RawConnection>> res) {
+        send_closure(actor_id, &Session::on_main_connection_migrated, std::move(res));
+      });
+  callback_->request_raw_connection(nullptr, std::move(promise));
+}
+
+void Session::cancel_main_connection_migration() {
+  if (!is_main_connection_migrating_) {
+    return;
+  }
+  is_main_connection_migrating_ = false;
+  migration_cancellation_token_source_.cancel();
+}
+
+void Session::on_main_connection_migrated(Result<unique_ptr<mtproto::RawConnection>> r_raw_connection) {
+  if (!is_main_connection_migrating_) {
+    return;
+  }
+  is_main_connection_migrating_ = false;
+  if (close_flag_) {
+    return;
+  }
+
+  if (r_raw_connection.is_ok() && r_raw_connection.ok()->extra().extra != network_generation_) {
+    r_raw_connection = Status::Error("Receive connection over an old network");
+  }
+  if (r_raw_connection.is_error()) {
+    // the old connection is likely to be broken too, so reconnect as usual
+    LOG(WARNING) << "Failed to open new main connection: " << r_raw_connection.error();
+    connection_close(&main_connection_);
+  } else {
+    // the new connection will be used instead of the closed one immediately
+    LOG(INFO) << "Switch main connection to the new network";
+    connection_add(r_raw_connection.move_as_ok());
+    connection_close(&main_connection_);
+  }
+  loop();
+}
+
 void Session::connection_add(unique_ptr<mtproto::RawConnection> raw_connection) {
   VLOG(dc) << "Cache connection " << raw_connection.get();
   cached_connection_ = std::move(raw_connection);
@@ -1307,7 +1418,7 @@ void Session::connection_open_finish(ConnectionInfo *info,
   info->state_ = ConnectionInfo::State::Ready;
   info->created_at_ = Time::now();
   info->wakeup_at_ = info->created_at_ + 10;
-  if (unknown_queries_.size() > MAX_INFLIGHT_QUERIES) {
+  if (unknown_queries_.size() > MAX_INFLIGHT_QUERIES_LIMIT) {
     LOG(ERROR) << "With current limits `Too many queries with unknown state` error must be impossible";
     on_session_failed(Status::Error("Too many queries with unknown state"));
     return;
@@ -1556,7 +1667,8 @@ void Session::loop() {
     while (main_connection_.state_ == ConnectionInfo::State::Ready) {
       if (auth_data_.is_ready(now)) {
         if (need_send_query()) {
-          while (!pending_queries_.empty() && sent_queries_.size() < MAX_INFLIGHT_QUERIES) {
+          auto max_inflight_query_count = get_max_inflight_query_count();
+          while (!pending_queries_.empty() && sent_queries_.size() < max_inflight_query_count) {
             auto query = pending_queries_.pop();
             connection_send_query(&main_connection_, std::move(query));
             need_flush = true;
@@ -1581,6 +1693,8 @@ void Session::loop() {
     }
   }
   if (!close_flag_ && main_connection_.state_ == ConnectionInfo::State::Empty) {
+    // if the old connection was closed before the new one is ready, then request a connection as usual
+    cancel_main_connection_migration();
     connection_open(&main_connection_, now, true /*send ask_info*/);
   }
 
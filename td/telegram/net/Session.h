@@ -147,6 +147,25 @@ class Session final
     std::map<int8, VectorQueue<NetQueryPtr>, std::greater<>> queries_;
   };
   PriorityQueue pending_queries_;
+
+  // AIMD controller of the number of sent, but not answered yet queries
+  class InflightQueryLimit {
+   public:
+    size_t get_limit(size_t max_limit) const;
+
+    void on_query_answered(double latency);
+    void on_congestion(double now);
+
+   private:
+    static constexpr double MIN_LIMIT = 16.0;
+    static constexpr double LATENCY_FACTOR = 8.0;   // latency increase, treated as congestion
+    static constexpr double MIN_CONGESTION_LATENCY = 1.0;
+
+    double limit_ = static_cast<double>(MAX_INFLIGHT_QUERIES_LIMIT);
+    double min_latency_ = 0.0;
+    double decreased_at_ = 0.0;
+  };
+  InflightQueryLimit inflight_query_limit_;
   std::map<mtproto::MessageId, Query> sent_queries_;
   std::deque<NetQueryPtr> pending_invoke_after_queries_;
   ListNode sent_queries_list_;
@@ -167,9 +186,15 @@ class Session final
   ConnectionInfo long_poll_connection_;
   mtproto::ConnectionManager::ConnectionToken connection_token_;
 
+  mtproto::SessionConnection::ContainerStatistics container_statistics_;
+
   double cached_connection_timestamp_ = 0;
   unique_ptr<mtproto::RawConnection> cached_connection_;
 
+  // a connection over the new network, which is requested after network change, while the old main connection is used
+  bool is_main_connection_migrating_ = false;
+  CancellationTokenSource migration_cancellation_token_source_;
+
   std::shared_ptr<Callback> callback_;
   bool use_pfs_{false};
   bool need_check_main_key_{false};
@@ -178,7 +203,10 @@ class Session final
   bool close_flag_ = false;
 
   static constexpr double ACTIVITY_TIMEOUT = 60 * 5;
-  static constexpr size_t MAX_INFLIGHT_QUERIES = 1024;
+  static constexpr size_t MAX_INFLIGHT_QUERIES = 1024;         // default value of the option
+  static constexpr size_t MAX_INFLIGHT_QUERIES_LIMIT = 16384;  // maximum value of the option
+
+  size_t get_max_inflight_query_count() const;
 
   struct ContainerInfo {
     size_t ref_cnt;
@@ -259,6 +287,10 @@ class Session final
   void connection_check_mode(ConnectionInfo *info);
   void connection_open_finish(ConnectionInfo *info, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection);
 
+  void migrate_main_connection();
+  void cancel_main_connection_migration();
+  void on_main_connection_migrated(Result<unique_ptr<mtproto::RawConnection>> r_raw_connection);
+
   void connection_online_update(double now, bool force);
   void connection_close(ConnectionInfo *info);
   void connection_flush(ConnectionInfo *info);
@@ -7,6 +7,7 @@
 #include "td/telegram/net/SessionMultiProxy.h"
 
 #include "td/telegram/net/SessionProxy.h"
+#include "td/telegram/telegram_api.h"
 
 #include "td/utils/common.h"
 #include "td/utils/format.h"
@@ -36,32 +37,81 @@ SessionMultiProxy::SessionMultiProxy(int32 session_count, std::shared_ptr<AuthDa
   }
 }
 
+SessionMultiProxy::QueryClass SessionMultiProxy::get_query_class(const NetQueryPtr &query) {
+  switch (query->tl_constructor()) {
+    case telegram_api::upload_getFile::ID:
+    case telegram_api::upload_getCdnFile::ID:
+    case telegram_api::upload_getWebFile::ID:
+    case telegram_api::messages_getHistory::ID:
+    case telegram_api::messages_getReplies::ID:
+    case telegram_api::messages_search::ID:
+    case telegram_api::messages_searchGlobal::ID:
+    case telegram_api::messages_getDialogs::ID:
+    case telegram_api::messages_getAllStickers::ID:
+    case telegram_api::channels_getParticipants::ID:
+    case telegram_api::contacts_getContacts::ID:
+      return QueryClass::Bulk;
+    default:
+      return QueryClass::LatencySensitive;
+  }
+}
+
+size_t SessionMultiProxy::get_latency_sensitive_session_count() const {
+  if (!is_primary_ || sessions_.size() < 2) {
+    // media sessions receive only bulk queries
+    return sessions_.size();
+  }
+  // a quarter of sessions, but at least one, are reserved for bulk queries
+  return sessions_.size() - max(sessions_.size() / 4, static_cast<size_t>(1));
+}
+
+size_t SessionMultiProxy::choose_session(size_t begin, size_t end) const {
+  CHECK(begin < end);
+  size_t pos = begin;
+  size_t equal_count = 1;
+  int min_query_count = sessions_[pos].query_count;
+  for (size_t i = begin + 1; i < end; i++) {
+    if (sessions_[i].query_count < min_query_count) {
+      pos = i;
+      min_query_count = sessions_[pos].query_count;
+      equal_count = 1;
+    } else if (sessions_[i].query_count == min_query_count) {
+      equal_count++;
+      if (Random::fast_uint32() % equal_count == 0) {
+        pos = i;
+      }
+    }
+  }
+  return pos;
+}
+
 void SessionMultiProxy::send(NetQueryPtr query) {
   size_t pos = 0;
+  bool is_bulk = false;
   if (query->auth_flag() == NetQuery::AuthFlag::On) {
+    auto latency_sensitive_session_count = get_latency_sensitive_session_count();
     size_t session_rand = query->session_rand();
     if (session_rand) {
-      pos = session_rand % sessions_.size();
+      // queries from the same chain must be sent through the same session regardless of their class
+      pos = session_rand % latency_sensitive_session_count;
+    } else if (get_query_class(query) == QueryClass::Bulk) {
+      is_bulk = true;
+      pos = latency_sensitive_session_count == sessions_.size()
+                ? choose_session(0, sessions_.size())
+                : choose_session(latency_sensitive_session_count, sessions_.size());
     } else {
-      size_t equal_count = 1;
-      int min_query_count = sessions_[pos].query_count;
-      for (size_t i = 1; i < sessions_.size(); i++) {
-        if (sessions_[i].query_count < min_query_count) {
-          pos = i;
-          min_query_count = sessions_[pos].query_count;
-          equal_count = 1;
-        } else if (sessions_[i].query_count == min_query_count) {
-          equal_count++;
-          if (Random::fast_uint32() % equal_count == 0) {
-            pos = i;
-          }
-        }
-      }
+      pos = choose_session(0, latency_sensitive_session_count);
     }
   }
   // query->debug(PSTRING() << get_name() << ": send to proxy #" << pos);
-  sessions_[pos].query_count++;
-  send_closure(sessions_[pos].proxy, &SessionProxy::send, std::move(query));
+  auto &session = sessions_[pos];
+  session.query_count++;
+  session.max_query_count = max(session.max_query_count, session.query_count);
+  session.sent_query_count++;
+  if (is_bulk) {
+    session.sent_bulk_query_count++;
+  }
+  send_closure(session.proxy, &SessionProxy::send, std::move(query));
 }
 
 void SessionMultiProxy::update_main_flag(bool is_main) {
@@ -129,11 +179,28 @@ void SessionMultiProxy::start_up() {
   init();
 }
 
+void SessionMultiProxy::tear_down() {
+  dump_statistics();
+}
+
+void SessionMultiProxy::dump_statistics() const {
+  for (size_t i = 0; i < sessions_.size(); i++) {
+    auto &session = sessions_[i];
+    if (session.sent_query_count == 0) {
+      continue;
+    }
+    LOG(INFO) << get_name() << " session #" << i << ": " << tag("sent", session.sent_query_count)
+              << tag("bulk", session.sent_bulk_query_count) << tag("pending", session.query_count)
+              << tag("max pending", session.max_query_count);
+  }
+}
+
 bool SessionMultiProxy::get_pfs_flag() const {
   return use_pfs_ && !is_cdn_;
 }
 
 void SessionMultiProxy::init() {
+  dump_statistics();
   sessions_generation_++;
   sessions_.clear();
   if (is_main_ && session_count_ > 1) {
@@ -48,15 +48,33 @@ class SessionMultiProxy final : public Actor {
   struct SessionInfo {
     ActorOwn<SessionProxy> proxy;
     int query_count{0};
+
+    // telemetry
+    int max_query_count{0};
+    uint64 sent_query_count{0};
+    uint64 sent_bulk_query_count{0};
   };
   uint32 sessions_generation_{0};
   std::vector<SessionInfo> sessions_;
 
+  // queries with big answers are sent through separate sessions to avoid head-of-line blocking of other queries
+  enum class QueryClass : int32 { LatencySensitive, Bulk };
+
+  static QueryClass get_query_class(const NetQueryPtr &query);
+
+  // returns number of the first sessions, which are used for latency-sensitive queries
+  size_t get_latency_sensitive_session_count() const;
+
+  size_t choose_session(size_t begin, size_t end) const;
+
   void start_up() final;
+  void tear_down() final;
   void init();
 
   bool get_pfs_flag() const;
 
+  void dump_statistics() const;
+
   void on_query_finished(uint32 generation, int session_id);
 };
 
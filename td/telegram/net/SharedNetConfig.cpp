@@ -0,0 +1,70 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/SharedNetConfig.h"
+
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/Time.h"
+
+#include <mutex>
+
+namespace td {
+
+namespace {
+
+struct StoredValue {
+  int64 version = 0;
+  BufferSlice data;
+  double expires_at = 0.0;
+  double request_started_at = 0.0;
+};
+
+std::mutex shared_net_config_mutex;
+FlatHashMap<string, StoredValue> shared_net_config_values;
+int64 last_shared_net_config_version = 0;
+
+}  // namespace
+
+SharedNetConfig::Value SharedNetConfig::get_value(Slice key, int64 known_version) {
+  auto now = Time::now();
+  Value result;
+  std::lock_guard<std::mutex> guard(shared_net_config_mutex);
+  auto &value = shared_net_config_values[key.str()];
+  if (value.version != 0 && value.version != known_version && value.expires_at > now) {
+    result.state = State::Ready;
+    result.version = value.version;
+    result.data = value.data.clone();
+    result.expires_at = value.expires_at;
+    return result;
+  }
+  if (value.request_started_at != 0.0 && value.request_started_at > now - MAX_REQUEST_TIME) {
+    result.state = State::Pending;
+    return result;
+  }
+  value.request_started_at = now;
+  result.state = State::Absent;
+  return result;
+}
+
+int64 SharedNetConfig::set_value(Slice key, BufferSlice data, double expires_at) {
+  std::lock_guard<std::mutex> guard(shared_net_config_mutex);
+  auto &value = shared_net_config_values[key.str()];
+  value.version = ++last_shared_net_config_version;
+  value.data = std::move(data);
+  value.expires_at = expires_at;
+  value.request_started_at = 0.0;
+  return value.version;
+}
+
+void SharedNetConfig::on_request_failed(Slice key) {
+  std::lock_guard<std::mutex> guard(shared_net_config_mutex);
+  auto it = shared_net_config_values.find(key.str());
+  if (it != shared_net_config_values.end()) {
+    it->second.request_started_at = 0.0;
+  }
+}
+
+}  // namespace td
@@ -0,0 +1,43 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+namespace td {
+
+// Process-wide storage of serialized network configuration received by clients,
+// which have enabled the option "use_shared_network_config". Every stored value has a version,
+// which is unique across all clients of the process, so a client can find out whether it has already applied it.
+class SharedNetConfig {
+ public:
+  enum class State : int32 { Ready, Pending, Absent };
+
+  struct Value {
+    State state = State::Absent;
+    int64 version = 0;
+    BufferSlice data;
+    double expires_at = 0.0;
+  };
+
+  // returns a non-expired value, which differs from the known version, if any;
+  // otherwise, returns Pending if another client is already requesting the value, or Absent if the caller
+  // must request it and then call set_value or on_request_failed
+  static Value get_value(Slice key, int64 known_version);
+
+  // stores a new value and returns its version
+  static int64 set_value(Slice key, BufferSlice data, double expires_at);
+
+  static void on_request_failed(Slice key);
+
+ private:
+  static constexpr double MAX_REQUEST_TIME = 60.0;
+};
+
+}  // namespace td
@@ -10,6 +10,7 @@
 #include "td/telegram/Log.h"
 #include "td/telegram/td_tdc_api_inner.h"
 
+#include <cstddef>
 #include <cstring>
 
 static td::ClientManager *GetClientManager() {
@@ -34,6 +35,21 @@ TdResponse TdCClientReceive(double timeout) {
   return c_response;
 }
 
+int TdCClientReceiveBatch(double timeout, int max_count, TdResponse *responses) {
+  if (max_count <= 0) {
+    return 0;
+  }
+  auto received_responses = GetClientManager()->receive_batch(timeout, static_cast<std::size_t>(max_count));
+  int count = 0;
+  for (auto &response : received_responses) {
+    auto &c_response = responses[count++];
+    c_response.client_id = response.client_id;
+    c_response.request_id = response.request_id;
+    c_response.object = TdConvertFromInternal(*response.object);
+  }
+  return count;
+}
+
 TdObject *TdCClientExecute(TdFunction *function) {
   auto result = td::ClientManager::execute(TdConvertToInternal(function));
   TdDestroyObjectFunction(function);
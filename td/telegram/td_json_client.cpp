@@ -9,6 +9,7 @@
 #include "td/telegram/Client.h"
 #include "td/telegram/ClientJson.h"
 
+#include "td/utils/SharedMemoryQueue.h"
 #include "td/utils/Slice.h"
 
 void *td_json_client_create() {
@@ -43,10 +44,75 @@ const char *td_receive(double timeout) {
   return td::json_receive(timeout);
 }
 
+const char *td_receive_batch(double timeout, int max_count) {
+  return td::json_receive_batch(timeout, max_count);
+}
+
 const char *td_execute(const char *request) {
   return td::json_execute(td::Slice(request == nullptr ? "" : request));
 }
 
+static td::Slice get_binary_request(const void *request, int request_size) {
+  if (request == nullptr || request_size <= 0) {
+    return td::Slice();
+  }
+  return td::Slice(static_cast<const char *>(request), static_cast<size_t>(request_size));
+}
+
+static const void *get_binary_response(td::Slice response, int *response_size) {
+  if (response_size != nullptr) {
+    *response_size = static_cast<int>(response.size());
+  }
+  return response.empty() ? nullptr : response.data();
+}
+
+void td_binary_send(int client_id, const void *request, int request_size) {
+  td::binary_send(client_id, get_binary_request(request, request_size));
+}
+
+const void *td_binary_receive(double timeout, int *response_size) {
+  return get_binary_response(td::binary_receive(timeout), response_size);
+}
+
+const void *td_binary_execute(const void *request, int request_size, int *response_size) {
+  return get_binary_response(td::binary_execute(get_binary_request(request, request_size)), response_size);
+}
+
+void *td_shared_queue_create(const char *file_path, int capacity) {
+  if (capacity <= 0) {
+    return nullptr;
+  }
+  auto r_queue =
+      td::SharedMemoryQueue::create(td::CSlice(file_path == nullptr ? "" : file_path), static_cast<size_t>(capacity));
+  if (r_queue.is_error()) {
+    return nullptr;
+  }
+  return new td::ClientJsonSharedQueue(r_queue.move_as_ok());
+}
+
+void *td_shared_queue_open(const char *file_path) {
+  auto r_queue = td::SharedMemoryQueue::open(td::CSlice(file_path == nullptr ? "" : file_path));
+  if (r_queue.is_error()) {
+    return nullptr;
+  }
+  return new td::ClientJsonSharedQueue(r_queue.move_as_ok());
+}
+
+int td_shared_queue_receive(void *queue, double timeout, int max_count) {
+  if (max_count <= 0) {
+    return 0;
+  }
+  return static_cast<td::ClientJsonSharedQueue *>(queue)->receive(timeout, max_count);
+}
+
+const char *td_shared_queue_pop(void *queue) {
+  return static_cast<td::ClientJsonSharedQueue *>(queue)->pop();
+}
+
+void td_shared_queue_destroy(void *queue) {
+  delete static_cast<td::ClientJsonSharedQueue *>(queue);
+}
+
 void td_set_log_message_callback(int max_verbosity_level, td_log_message_callback_ptr callback) {
   td::ClientManager::set_log_message_callback(max_verbosity_level, callback);
 }
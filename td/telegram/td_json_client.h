@@ -76,6 +76,19 @@ TDJSON_EXPORT void td_send(int client_id, const char *request);
  */
 TDJSON_EXPORT const char *td_receive(double timeout);
 
+/**
+ * Receives up to max_count incoming updates and request responses at once. Must not be called simultaneously from two
+ * different threads or simultaneously with td_receive.
+ * Waits for new data only if there are no already received updates and responses.
+ * The returned pointer can be used until the next call to td_receive, td_receive_batch or td_execute, after which it
+ * will be deallocated by TDLib.
+ * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+ * \param[in] max_count The maximum number of returned objects. Must be positive.
+ * \return JSON-serialized null-terminated array of incoming updates and request responses in the order they were
+ *         received. May be NULL if the timeout expires.
+ */
+TDJSON_EXPORT const char *td_receive_batch(double timeout, int max_count);
+
 /**
  * Synchronously executes a TDLib request.
  * A request can be executed synchronously, only if it is documented with "Can be called synchronously".
@@ -85,6 +98,89 @@ TDJSON_EXPORT const char *td_receive(double timeout);
  */
 TDJSON_EXPORT const char *td_execute(const char *request);
 
+/**
+ * Sends a TL-serialized request to the TDLib client. May be called from any thread.
+ * This is a binary alternative to td_send, which avoids JSON serialization. The request must consist of
+ * a 64-bit little-endian request identifier followed by a boxed td_api::Function serialized in the TL binary format,
+ * described by the td_api.tlo scheme. Each object field is preceded by a 32-bit presence flag, which is 0 for
+ * absent objects and 1 otherwise. Request identifiers are returned unchanged in the corresponding responses,
+ * so the same client must not be used simultaneously through td_send. Requests shorter than 8 bytes are ignored.
+ * \param[in] client_id TDLib client identifier.
+ * \param[in] request TL-serialized request to TDLib.
+ * \param[in] request_size Size of the request in bytes.
+ */
+TDJSON_EXPORT void td_binary_send(int client_id, const void *request, int request_size);
+
+/**
+ * Receives incoming update or request response in the TL binary format. Must not be called simultaneously from two
+ * different threads or simultaneously with td_receive. The response consists of a 32-bit TDLib client identifier,
+ * which is 0 for responses to td_binary_execute, a 64-bit request identifier, which is 0 for incoming updates,
+ * and a boxed td_api::Object serialized in the TL binary format.
+ * The returned pointer can be used until the next call to td_binary_receive, td_binary_execute, td_receive or
+ * td_execute, after which it will be deallocated by TDLib.
+ * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+ * \param[out] response_size Size of the returned response in bytes.
+ * \return TL-serialized incoming update or request response. May be NULL if the timeout expires.
+ */
+TDJSON_EXPORT const void *td_binary_receive(double timeout, int *response_size);
+
+/**
+ * Synchronously executes a TL-serialized TDLib request. The request and the response have the same format as in
+ * td_binary_send and td_binary_receive. The returned pointer can be used until the next call to td_binary_receive,
+ * td_binary_execute, td_receive or td_execute, after which it will be deallocated by TDLib.
+ * \param[in] request TL-serialized request to TDLib.
+ * \param[in] request_size Size of the request in bytes.
+ * \param[out] response_size Size of the returned response in bytes.
+ * \return TL-serialized request response, or NULL if the request is shorter than 8 bytes.
+ */
+TDJSON_EXPORT const void *td_binary_execute(const void *request, int request_size, int *response_size);
+
+/**
+ * Creates a single-producer single-consumer queue in a memory-mapped file, which can be used to pass
+ * incoming updates and request responses to another process without copying them through a socket.
+ * Responses are received by td_shared_queue_receive in this process and can be read by td_shared_queue_pop
+ * in another process, which has opened the queue with td_shared_queue_open.
+ * \param[in] file_path Path to the file for the queue. The file will be overwritten if it already exists.
+ * \param[in] capacity Size of the queue in bytes; must be a power of 2 between 4096 and 2^30.
+ * \return An opaque pointer to the queue, or NULL if the queue can't be created.
+ */
+TDJSON_EXPORT void *td_shared_queue_create(const char *file_path, int capacity);
+
+/**
+ * Opens a queue created by td_shared_queue_create, possibly in another process.
+ * \param[in] file_path Path to the file of the queue.
+ * \return An opaque pointer to the queue, or NULL if the queue can't be opened.
+ */
+TDJSON_EXPORT void *td_shared_queue_open(const char *file_path);
+
+/**
+ * Receives up to max_count incoming updates and request responses as td_receive_batch does and pushes them
+ * to the queue. Must not be called simultaneously with td_receive or td_receive_batch.
+ * Responses, which don't fit in the queue, are kept and pushed during the next call. Objects of any size are
+ * passed; objects bigger than a half of the queue capacity are pushed in several parts.
+ * \param[in] queue The queue created by td_shared_queue_create.
+ * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+ * \param[in] max_count The maximum number of objects to push.
+ * \return The number of objects pushed to the queue.
+ */
+TDJSON_EXPORT int td_shared_queue_receive(void *queue, double timeout, int max_count);
+
+/**
+ * Returns the next JSON-serialized object from the queue without waiting. Must be called only by one thread.
+ * The returned pointer can be used until the next call to td_shared_queue_pop, td_receive or td_execute in the same
+ * thread, after which it will be deallocated by TDLib. There are no notifications about new objects, so the queue
+ * needs to be polled.
+ * \param[in] queue The queue opened by td_shared_queue_open.
+ * \return JSON-serialized null-terminated incoming update or request response. May be NULL if the queue is empty.
+ */
+TDJSON_EXPORT const char *td_shared_queue_pop(void *queue);
+
+/**
+ * Unmaps the queue. The queue file isn't deleted.
+ * \param[in] queue The queue.
+ */
+TDJSON_EXPORT void td_shared_queue_destroy(void *queue);
+
 /**
  * A type of callback function that will be called when a message is added to the internal TDLib log.
  *
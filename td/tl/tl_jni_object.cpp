@@ -216,7 +216,11 @@ std::string from_jstring(JNIEnv *env, jstring s) {
     return std::string();
   }
   jsize s_len = env->GetStringLength(s);
-  const jchar *p = env->GetStringChars(s, nullptr);
+  if (s_len == 0) {
+    return std::string();
+  }
+  // no JNI calls are made until the string is released, so the string data can be accessed without copying
+  auto p = static_cast<const jchar *>(env->GetStringCritical(s, nullptr));
   if (p == nullptr) {
     parse_error = true;
     return std::string();
@@ -226,7 +230,7 @@ std::string from_jstring(JNIEnv *env, jstring s) {
   if (len) {
     utf16_to_utf8(p, s_len, &res[0]);
   }
-  env->ReleaseStringChars(s, p);
+  env->ReleaseStringCritical(s, p);
   return res;
 }
 
@@ -56,6 +56,12 @@ class TlFetchInt {
   static std::int32_t parse(ParserT &parser) {
     return parser.fetch_int();
   }
+
+  // the length must be checked by the caller
+  template <class ParserT>
+  static std::int32_t parse_unsafe(ParserT &parser) {
+    return parser.fetch_int_unsafe();
+  }
 };
 
 class TlFetchLong {
@@ -64,6 +70,11 @@ class TlFetchLong {
   static std::int64_t parse(ParserT &parser) {
     return parser.fetch_long();
   }
+
+  template <class ParserT>
+  static std::int64_t parse_unsafe(ParserT &parser) {
+    return parser.fetch_long_unsafe();
+  }
 };
 
 class TlFetchDouble {
@@ -72,6 +83,11 @@ class TlFetchDouble {
   static double parse(ParserT &parser) {
     return parser.fetch_double();
   }
+
+  template <class ParserT>
+  static double parse_unsafe(ParserT &parser) {
+    return parser.fetch_double_unsafe();
+  }
 };
 
 class TlFetchInt128 {
@@ -80,6 +96,11 @@ class TlFetchInt128 {
   static UInt128 parse(ParserT &parser) {
     return parser.template fetch_binary<UInt128>();
   }
+
+  template <class ParserT>
+  static UInt128 parse_unsafe(ParserT &parser) {
+    return parser.template fetch_binary_unsafe<UInt128>();
+  }
 };
 
 class TlFetchInt256 {
@@ -88,6 +109,11 @@ class TlFetchInt256 {
   static UInt256 parse(ParserT &parser) {
     return parser.template fetch_binary<UInt256>();
   }
+
+  template <class ParserT>
+  static UInt256 parse_unsafe(ParserT &parser) {
+    return parser.template fetch_binary_unsafe<UInt256>();
+  }
 };
 
 template <class T>
@@ -127,6 +153,23 @@ class TlFetchVector {
   }
 };
 
+template <class Func>
+class TlFetchOptional {
+ public:
+  template <class ParserT>
+  static auto parse(ParserT &parser) -> decltype(Func::parse(parser)) {
+    auto is_present = parser.fetch_int();
+    if (is_present == 0) {
+      return decltype(Func::parse(parser))();
+    }
+    if (is_present != 1) {
+      parser.set_error(PSTRING() << "Wrong object presence flag " << is_present);
+      return decltype(Func::parse(parser))();
+    }
+    return Func::parse(parser);
+  }
+};
+
 template <class T>
 class TlFetchObject {
  public:
@@ -75,6 +75,18 @@ class TlStoreVector {
   }
 };
 
+template <class Func>
+class TlStoreOptional {
+ public:
+  template <class T, class StorerT>
+  static void store(const T &x, StorerT &storer) {
+    storer.store_binary(static_cast<std::int32_t>(x != nullptr));
+    if (x != nullptr) {
+      Func::store(x, storer);
+    }
+  }
+};
+
 class TlStoreObject {
  public:
   template <class T, class StorerT>
@@ -0,0 +1,117 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/actor/ActorStatistics.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+
+#include <map>
+#include <mutex>
+
+namespace td {
+
+struct ActorStatistics::Entry {
+  string name;
+  std::atomic<uint64> event_count{0};
+  std::atomic<double> total_time{0.0};
+  std::atomic<double> max_time{0.0};
+  std::atomic<size_t> max_mailbox_size{0};
+  std::atomic<uint64> dropped_event_count{0};
+  std::atomic<uint64> coalesced_event_count{0};
+};
+
+std::atomic<bool> ActorStatistics::is_enabled_{false};
+
+static std::atomic<double> slow_event_threshold{0.0};
+
+static std::mutex entries_mutex;
+
+static std::map<string, unique_ptr<ActorStatistics::Entry>> &get_entries() {
+  // entries are never destroyed, because they can be used by actors until the very end of the process
+  static auto *entries = new std::map<string, unique_ptr<ActorStatistics::Entry>>();
+  return *entries;
+}
+
+template <class T>
+static void update_max(std::atomic<T> &value, T new_value) {
+  auto old_value = value.load(std::memory_order_relaxed);
+  while (old_value < new_value && !value.compare_exchange_weak(old_value, new_value, std::memory_order_relaxed)) {
+  }
+}
+
+static void add(std::atomic<double> &value, double addition) {
+  auto old_value = value.load(std::memory_order_relaxed);
+  while (!value.compare_exchange_weak(old_value, old_value + addition, std::memory_order_relaxed)) {
+  }
+}
+
+void ActorStatistics::enable(double slow_event_threshold_seconds) {
+  slow_event_threshold.store(slow_event_threshold_seconds, std::memory_order_relaxed);
+  is_enabled_.store(true, std::memory_order_relaxed);
+}
+
+ActorStatistics::Entry *ActorStatistics::get_entry(Slice name) {
+  // actors of the same kind often have names like "SecretChat 12" or "ServiceActor3"
+  auto space_pos = name.find(' ');
+  if (space_pos != Slice::npos) {
+    name.truncate(space_pos);
+  }
+  while (!name.empty() && is_digit(name.back())) {
+    name.remove_suffix(1);
+  }
+
+  std::lock_guard<std::mutex> guard(entries_mutex);
+  auto &entry = get_entries()[name.str()];
+  if (entry == nullptr) {
+    entry = make_unique<Entry>();
+    entry->name = name.str();
+  }
+  return entry.get();
+}
+
+void ActorStatistics::on_mailbox_size(Entry *entry, size_t mailbox_size) {
+  update_max(entry->max_mailbox_size, mailbox_size);
+}
+
+void ActorStatistics::on_dropped_event(Entry *entry) {
+  entry->dropped_event_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ActorStatistics::on_coalesced_event(Entry *entry) {
+  entry->coalesced_event_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ActorStatistics::on_event(Entry *entry, double event_time) {
+  entry->event_count.fetch_add(1, std::memory_order_relaxed);
+  add(entry->total_time, event_time);
+  update_max(entry->max_time, event_time);
+
+  auto threshold = slow_event_threshold.load(std::memory_order_relaxed);
+  if (threshold > 0 && event_time >= threshold) {
+    LOG(WARNING) << "Slow event in actor " << entry->name << " was processed in " << event_time << " seconds";
+  }
+}
+
+vector<ActorStatistics::Info> ActorStatistics::get_statistics() {
+  vector<Info> result;
+  std::lock_guard<std::mutex> guard(entries_mutex);
+  for (auto &it : get_entries()) {
+    auto &entry = *it.second;
+    Info info;
+    info.name = entry.name;
+    info.event_count = entry.event_count.load(std::memory_order_relaxed);
+    info.total_time = entry.total_time.load(std::memory_order_relaxed);
+    info.max_time = entry.max_time.load(std::memory_order_relaxed);
+    info.max_mailbox_size = entry.max_mailbox_size.load(std::memory_order_relaxed);
+    info.dropped_event_count = entry.dropped_event_count.load(std::memory_order_relaxed);
+    info.coalesced_event_count = entry.coalesced_event_count.load(std::memory_order_relaxed);
+    result.push_back(std::move(info));
+  }
+  return result;
+}
+
+}  // namespace td
@@ -0,0 +1,57 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+#include <atomic>
+
+namespace td {
+
+// process-wide statistics about events processed by actors, grouped by actor name
+class ActorStatistics {
+ public:
+  struct Entry;
+
+  struct Info {
+    string name;
+    uint64 event_count = 0;
+    double total_time = 0.0;
+    double max_time = 0.0;
+    size_t max_mailbox_size = 0;
+    uint64 dropped_event_count = 0;
+    uint64 coalesced_event_count = 0;
+  };
+
+  // enables collection of statistics for actors created after the call
+  // events processed longer than slow_event_threshold seconds are logged; pass 0 to disable logging
+  static void enable(double slow_event_threshold);
+
+  static bool is_enabled() {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  // returns a persistent entry for the actor name; actor sequence numbers in the name are ignored
+  static Entry *get_entry(Slice name);
+
+  static void on_mailbox_size(Entry *entry, size_t mailbox_size);
+
+  static void on_dropped_event(Entry *entry);
+
+  static void on_coalesced_event(Entry *entry);
+
+  static void on_event(Entry *entry, double event_time);
+
+  // can be called from any thread
+  static vector<Info> get_statistics();
+
+ private:
+  static std::atomic<bool> is_enabled_;
+};
+
+}  // namespace td
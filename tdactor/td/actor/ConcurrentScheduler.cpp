@@ -7,7 +7,9 @@
 #include "td/actor/ConcurrentScheduler.h"
 
 #include "td/utils/ExitGuard.h"
+#include "td/utils/logging.h"
 #include "td/utils/MpscPollableQueue.h"
+#include "td/utils/port/numa.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/ScopeGuard.h"
 
@@ -70,6 +72,135 @@ void ConcurrentScheduler::test_one_thread_run() {
   } while (!is_finished_.load(std::memory_order_relaxed));
 }
 
+double ConcurrentScheduler::get_busy_time() const {
+  double result = 0.0;
+  for (auto &sched : schedulers_) {
+    result += sched->get_busy_time();
+  }
+  return result;
+}
+
+void ConcurrentScheduler::enable_busy_polling(double max_busy_poll_time) {
+  CHECK(state_ == State::Start);
+  CHECK(max_busy_poll_time >= 0);
+  for (auto &sched : schedulers_) {
+    sched->enable_busy_polling(max_busy_poll_time);
+  }
+}
+
+uint64 ConcurrentScheduler::get_avoided_wakeup_count() const {
+  uint64 result = 0;
+  for (auto &sched : schedulers_) {
+    result += sched->get_avoided_wakeup_count();
+  }
+  return result;
+}
+
+uint64 ConcurrentScheduler::get_busy_poll_count() const {
+  uint64 result = 0;
+  for (auto &sched : schedulers_) {
+    result += sched->get_busy_poll_count();
+  }
+  return result;
+}
+
+uint64 ConcurrentScheduler::get_dropped_event_count() const {
+  uint64 result = 0;
+  for (auto &sched : schedulers_) {
+    result += sched->get_dropped_event_count();
+  }
+  return result;
+}
+
+uint64 ConcurrentScheduler::get_coalesced_event_count() const {
+  uint64 result = 0;
+  for (auto &sched : schedulers_) {
+    result += sched->get_coalesced_event_count();
+  }
+  return result;
+}
+
+uint64 ConcurrentScheduler::get_blocked_send_count() const {
+  uint64 result = 0;
+  for (auto &sched : schedulers_) {
+    result += sched->get_blocked_send_count();
+  }
+  return result;
+}
+
+void ConcurrentScheduler::enable_work_stealing() {
+  CHECK(state_ == State::Start);
+  is_work_stealing_enabled_ = true;
+}
+
+void ConcurrentScheduler::enable_numa_binding(int32 numa_node) {
+  CHECK(state_ == State::Start);
+  CHECK(numa_node >= -1);
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  auto numa_node_cpu_masks = get_numa_node_cpu_masks();
+  if (numa_node_cpu_masks.size() <= 1) {
+    LOG(INFO) << "Skip binding to NUMA nodes, because there are " << numa_node_cpu_masks.size() << " nodes";
+    return;
+  }
+  numa_node_cpu_masks_ = std::move(numa_node_cpu_masks);
+  numa_node_ = numa_node;
+#endif
+}
+
+uint64 ConcurrentScheduler::get_scheduler_affinity_mask(int32 sched_id) const {
+#if TD_THREAD_UNSUPPORTED || TD_EVENTFD_UNSUPPORTED
+  return 0;
+#else
+  auto mask = thread_affinity_mask_;
+  if (!numa_node_cpu_masks_.empty()) {
+    auto numa_node = static_cast<size_t>(numa_node_ >= 0 ? numa_node_ : sched_id);
+    auto node_mask = numa_node_cpu_masks_[numa_node % numa_node_cpu_masks_.size()];
+    if (mask == 0) {
+      mask = node_mask;
+    } else if ((mask & node_mask) != 0) {
+      mask &= node_mask;
+    }
+  }
+  return mask;
+#endif
+}
+
+void ConcurrentScheduler::steal_work(int32 sched_id, WorkStealingState &state) {
+  constexpr double WORK_STEALING_CHECK_PERIOD = 0.1;
+  constexpr double MAX_IDLE_LOAD = 0.2;
+  constexpr double MIN_BUSY_LOAD = 0.8;
+
+  auto now = Time::now();
+  auto period = now - state.last_check_time;
+  if (period < WORK_STEALING_CHECK_PERIOD) {
+    return;
+  }
+  state.last_check_time = now;
+
+  // the extra scheduler can't accept migrated actors
+  auto sched_count = schedulers_.size() - extra_scheduler_;
+  bool is_first_check = state.busy_times.empty();
+  state.busy_times.resize(sched_count);
+  int32 busiest_sched_id = -1;
+  double max_load = 0.0;
+  double own_load = 0.0;
+  for (size_t i = 0; i < sched_count; i++) {
+    auto busy_time = schedulers_[i]->get_busy_time();
+    auto load = (busy_time - state.busy_times[i]) / period;
+    state.busy_times[i] = busy_time;
+    if (static_cast<int32>(i) == sched_id) {
+      own_load = load;
+    } else if (load > max_load) {
+      max_load = load;
+      busiest_sched_id = static_cast<int32>(i);
+    }
+  }
+  if (is_first_check || own_load > MAX_IDLE_LOAD || max_load < MIN_BUSY_LOAD) {
+    return;
+  }
+  schedulers_[busiest_sched_id]->request_actor_migration(sched_id);
+}
+
 #if !TD_THREAD_UNSUPPORTED
 thread::id ConcurrentScheduler::get_scheduler_thread_id(int32 sched_id) {
   auto thread_pos = static_cast<size_t>(sched_id - 1);
@@ -84,7 +215,8 @@ void ConcurrentScheduler::start() {
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
   for (size_t i = 1; i + extra_scheduler_ < schedulers_.size(); i++) {
     auto &sched = schedulers_[i];
-    threads_.push_back(td::thread([&, thread_affinity_mask = thread_affinity_mask_] {
+    auto sched_id = static_cast<int32>(i);
+    threads_.push_back(td::thread([&, sched_id, thread_affinity_mask = get_scheduler_affinity_mask(sched_id)] {
 #if TD_PORT_WINDOWS
       detail::Iocp::Guard iocp_guard(iocp_.get());
 #endif
@@ -95,8 +227,15 @@ void ConcurrentScheduler::start() {
 #else
       (void)thread_affinity_mask;
 #endif
+      WorkStealingState work_stealing_state;
       while (!is_finished()) {
-        sched->run(Timestamp::in(10));
+        if (is_work_stealing_enabled_) {
+          // wake up periodically to find busy schedulers
+          sched->run(Timestamp::in(0.1));
+          steal_work(sched_id, work_stealing_state);
+        } else {
+          sched->run(Timestamp::in(10));
+        }
       }
     }));
   }
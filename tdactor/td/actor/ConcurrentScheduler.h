@@ -46,6 +46,38 @@ class ConcurrentScheduler final : private Scheduler::Callback {
 
   void test_one_thread_run();
 
+  // returns total time in seconds spent by all schedulers in processing of events; can be called from any thread
+  double get_busy_time() const;
+
+  // idle scheduler threads will take ready migratable actors from busy schedulers; must be called before start
+  void enable_work_stealing();
+
+  // schedulers will check events from other threads for at most max_busy_poll_time seconds before sleeping;
+  // trades CPU time for lower latency of cross-thread events; must be called before start
+  void enable_busy_polling(double max_busy_poll_time);
+
+  // returns the number of wakeups avoided by busy polling in all schedulers; can be called from any thread
+  uint64 get_avoided_wakeup_count() const;
+
+  // returns the number of busy polling attempts in all schedulers; can be called from any thread
+  uint64 get_busy_poll_count() const;
+
+  // returns the number of events dropped because of full mailboxes in all schedulers; can be called from any thread
+  uint64 get_dropped_event_count() const;
+
+  // returns the number of events coalesced because of full mailboxes in all schedulers; can be called from any thread
+  uint64 get_coalesced_event_count() const;
+
+  // returns the number of times senders waited for full mailboxes in all schedulers; can be called from any thread
+  uint64 get_blocked_send_count() const;
+
+  // scheduler threads will be bound to CPUs of the NUMA node numa_node, or will be spread between NUMA nodes
+  // if numa_node == -1; does nothing if there is only one NUMA node; must be called before start
+  void enable_numa_binding(int32 numa_node = -1);
+
+  // returns CPU affinity mask for the thread running the scheduler, or 0 if the mask must be left unchanged
+  uint64 get_scheduler_affinity_mask(int32 sched_id) const;
+
   bool is_finished() const {
     return is_finished_.load(std::memory_order_relaxed);
   }
@@ -101,12 +133,22 @@ class ConcurrentScheduler final : private Scheduler::Callback {
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
   vector<td::thread> threads_;
   uint64 thread_affinity_mask_ = 0;
+  vector<uint64> numa_node_cpu_masks_;
+  int32 numa_node_ = -1;
 #endif
 #if TD_PORT_WINDOWS
   unique_ptr<detail::Iocp> iocp_;
   td::thread iocp_thread_;
 #endif
   int32 extra_scheduler_ = 0;
+  bool is_work_stealing_enabled_ = false;
+
+  struct WorkStealingState {
+    double last_check_time = 0.0;
+    vector<double> busy_times;
+  };
+
+  void steal_work(int32 sched_id, WorkStealingState &state);
 
   void on_finish() final;
 
@@ -0,0 +1,243 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/config.h"
+
+#if TD_HAVE_COROUTINES
+
+#include "td/actor/actor.h"
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Status.h"
+
+#include <coroutine>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace td {
+
+// Coroutines are started by Task<T>::start in an actor and are always resumed in the same actor.
+// Awaiting returns Result<T>, coroutine returns a value or an error using co_return.
+// If the actor is destroyed while a coroutine is suspended, the coroutine is destroyed and its promise fails.
+template <class T = Unit>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+  std::coroutine_handle<> continuation_;
+
+  // the started coroutine, which owns all coroutines awaited by it
+  std::coroutine_handle<> root_;
+
+  std::suspend_always initial_suspend() noexcept {
+    return {};
+  }
+
+  void unhandled_exception() noexcept {
+    UNREACHABLE();
+  }
+};
+
+template <class T>
+struct TaskPromise final : public TaskPromiseBase {
+  Result<T> result_;
+  Promise<T> promise_;
+
+  Task<T> get_return_object() noexcept;
+
+  void return_value(Result<T> &&result) {
+    result_ = std::move(result);
+  }
+
+  struct FinalAwaiter {
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<TaskPromise> handle) noexcept {
+      auto &task_promise = handle.promise();
+      if (task_promise.continuation_) {
+        return task_promise.continuation_;
+      }
+      auto promise = std::move(task_promise.promise_);
+      auto result = std::move(task_promise.result_);
+      handle.destroy();
+      promise.set_result(std::move(result));
+      return std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {
+    }
+  };
+
+  FinalAwaiter final_suspend() noexcept {
+    return {};
+  }
+};
+
+class CoroutineResumer {
+ public:
+  CoroutineResumer(std::coroutine_handle<> handle, std::coroutine_handle<> root) : handle_(handle), root_(root) {
+  }
+  CoroutineResumer(const CoroutineResumer &) = delete;
+  CoroutineResumer &operator=(const CoroutineResumer &) = delete;
+  CoroutineResumer(CoroutineResumer &&other) noexcept
+      : handle_(std::exchange(other.handle_, {})), root_(std::exchange(other.root_, {})) {
+  }
+  CoroutineResumer &operator=(CoroutineResumer &&) = delete;
+  ~CoroutineResumer() {
+    if (handle_) {
+      // the owner actor was destroyed
+      root_.destroy();
+    }
+  }
+
+  void resume() {
+    CHECK(handle_);
+    root_ = {};
+    std::exchange(handle_, {}).resume();
+  }
+
+ private:
+  std::coroutine_handle<> handle_;
+  std::coroutine_handle<> root_;
+};
+
+template <class T, class F>
+class PromiseAwaiter {
+ public:
+  explicit PromiseAwaiter(F &&f) : f_(std::move(f)) {
+  }
+
+  bool await_ready() const noexcept {
+    return false;
+  }
+
+  template <class P>
+  void await_suspend(std::coroutine_handle<P> handle) {
+    auto owner = Scheduler::instance()->get_current_actor_id();
+    LOG_CHECK(!owner.empty()) << "Coroutine must be awaited in an actor";
+    f_(PromiseCreator::lambda([owner = std::move(owner), result_ptr = &result_,
+                               resumer = CoroutineResumer(handle, handle.promise().root_)](Result<T> result) mutable {
+      *result_ptr = std::move(result);
+      send_lambda(owner, [resumer = std::move(resumer)]() mutable { resumer.resume(); });
+    }));
+  }
+
+  Result<T> await_resume() {
+    return std::move(result_);
+  }
+
+ private:
+  F f_;
+  Result<T> result_;
+};
+
+template <class T>
+struct PromiseValue;
+
+template <class T>
+struct PromiseValue<Promise<T>> {
+  using type = T;
+};
+
+}  // namespace detail
+
+template <class T>
+class Task {
+ public:
+  using promise_type = detail::TaskPromise<T>;
+
+  Task() = default;
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+  Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, {})) {
+  }
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      reset();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+  ~Task() {
+    reset();
+  }
+
+  // runs the coroutine in the current actor until the first suspension; the result is passed to the promise
+  void start(Promise<T> &&promise) && {
+    CHECK(handle_);
+    auto handle = std::exchange(handle_, {});
+    handle.promise().promise_ = std::move(promise);
+    handle.promise().root_ = handle;
+    handle.resume();
+  }
+
+  bool await_ready() const noexcept {
+    return false;
+  }
+
+  template <class P>
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<P> continuation) noexcept {
+    auto &task_promise = handle_.promise();
+    task_promise.continuation_ = continuation;
+    task_promise.root_ = continuation.promise().root_;
+    return handle_;
+  }
+
+  Result<T> await_resume() noexcept {
+    return std::move(handle_.promise().result_);
+  }
+
+ private:
+  friend promise_type;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {
+  }
+
+  void reset() {
+    if (handle_) {
+      handle_.destroy();
+      handle_ = {};
+    }
+  }
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+template <class T>
+Task<T> detail::TaskPromise<T>::get_return_object() noexcept {
+  return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+// co_await await_promise<T>(f) calls f(Promise<T>) and returns the Result<T> passed to the promise
+template <class T, class F>
+auto await_promise(F &&f) {
+  return detail::PromiseAwaiter<T, std::decay_t<F>>(std::forward<F>(f));
+}
+
+// co_await ask(actor_id, &ActorT::func, args...) sends closure with an additional Promise<T> as the last argument
+// and returns the Result<T> passed to the promise
+template <class ActorIdT, class FunctionClassT, class... FunctionArgsT, class... ArgsT>
+auto ask(ActorIdT &&actor_id, void (FunctionClassT::*function)(FunctionArgsT...), ArgsT &&...args) {
+  static_assert(sizeof...(FunctionArgsT) == sizeof...(ArgsT) + 1, "Wrong number of arguments");
+  using PromiseT = std::decay_t<std::tuple_element_t<sizeof...(ArgsT), std::tuple<FunctionArgsT...>>>;
+  using T = typename detail::PromiseValue<PromiseT>::type;
+  return await_promise<T>([actor_id = std::forward<ActorIdT>(actor_id), function,
+                           ... args = std::forward<ArgsT>(args)](Promise<T> &&promise) mutable {
+    send_closure(std::move(actor_id), function, std::move(args)..., std::move(promise));
+  });
+}
+
+}  // namespace td
+
+#endif
@@ -102,4 +102,65 @@ MultiPromiseActorSafe::~MultiPromiseActorSafe() {
   }
 }
 
+void MultiPromiseCounter::add_promise(Promise<Unit> &&promise) {
+  promises_.emplace_back(std::move(promise));
+  LOG(DEBUG) << "Add promise #" << promises_.size() << " to " << name_;
+}
+
+Promise<Unit> MultiPromiseCounter::get_promise() {
+  CHECK(!promises_.empty());
+  auto owner = owner_->actor_id();
+  LOG_CHECK(!owner.empty()) << "Promise for " << name_ << " must be created after the owner actor is registered";
+
+  pending_count_++;
+  LOG(DEBUG) << "Get promise #" << received_results_ + pending_count_ << " for " << name_;
+  return PromiseCreator::lambda([counter = this, owner = std::move(owner)](Result<Unit> result) mutable {
+    if (Scheduler::instance()->is_actor_running(owner)) {
+      return counter->on_result(std::move(result));
+    }
+    send_lambda(owner, [counter, result = std::move(result)]() mutable { counter->on_result(std::move(result)); });
+  });
+}
+
+void MultiPromiseCounter::on_result(Result<Unit> &&result) {
+  CHECK(pending_count_ > 0);
+  pending_count_--;
+  received_results_++;
+  LOG(DEBUG) << "Receive result #" << received_results_ << " out of " << received_results_ + pending_count_ << " for "
+             << name_;
+  if (result.is_error() && error_.is_ok()) {
+    error_ = result.move_as_error();
+  }
+  if (pending_count_ != 0) {
+    return;
+  }
+
+  LOG(DEBUG) << "Set result for " << promises_.size() << " promises in " << name_;
+
+  // MultiPromiseCounter should be cleared before it begins to send out result
+  auto promises_copy = std::move(promises_);
+  promises_.clear();
+  received_results_ = 0;
+  Result<Unit> final_result = Unit();
+  if (!ignore_errors_ && error_.is_error()) {
+    final_result = std::move(error_);
+  }
+  error_ = Status::OK();
+
+  if (!promises_copy.empty()) {
+    for (size_t i = 0; i + 1 < promises_copy.size(); i++) {
+      promises_copy[i].set_result(final_result.clone());
+    }
+    promises_copy.back().set_result(std::move(final_result));
+  }
+}
+
+void MultiPromiseCounter::set_ignore_errors(bool ignore_errors) {
+  ignore_errors_ = ignore_errors;
+}
+
+size_t MultiPromiseCounter::promise_count() const {
+  return promises_.size();
+}
+
 }  // namespace td
@@ -117,4 +117,34 @@ class MultiPromiseActorSafe final : public MultiPromiseInterface {
   unique_ptr<MultiPromiseActor> multi_promise_;
 };
 
+// Lightweight alternative to MultiPromiseActor, which doesn't need a separate actor.
+// Must be stored inside the actor, which uses it, and must not be destroyed before the actor.
+// Promises must be created inside the actor. If they are set in the actor, results are counted without
+// additional events, otherwise results are sent to the actor via send_lambda and are ignored after its destruction.
+class MultiPromiseCounter final : public MultiPromiseInterface {
+ public:
+  // all promises are bound to the owner actor, whose identifier is unknown until the actor is registered
+  MultiPromiseCounter(const char *name, Actor *owner) : name_(name), owner_(owner) {
+  }
+
+  void add_promise(Promise<Unit> &&promise) final;
+
+  Promise<Unit> get_promise() final;
+
+  void set_ignore_errors(bool ignore_errors) final;
+
+  size_t promise_count() const final;
+
+ private:
+  const char *name_;
+  Actor *owner_;
+  vector<Promise<Unit>> promises_;  // promises waiting for result
+  size_t pending_count_ = 0;        // number of returned promises without result
+  size_t received_results_ = 0;
+  bool ignore_errors_ = false;
+  Status error_;
+
+  void on_result(Result<Unit> &&result);
+};
+
 }  // namespace td
@@ -20,15 +20,15 @@ void MultiTimeout::set_timeout_at(int64 key, double timeout) {
   auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item.first));
   if (heap_node->in_heap()) {
     CHECK(!item.second);
-    bool need_update_timeout = heap_node->is_top();
+    bool need_update_timeout = timeout_queue_.is_top(heap_node);
     timeout_queue_.fix(timeout, heap_node);
-    if (need_update_timeout || heap_node->is_top()) {
+    if (need_update_timeout || timeout_queue_.is_top(heap_node)) {
       update_timeout("set_timeout");
     }
   } else {
     CHECK(item.second);
     timeout_queue_.insert(timeout, heap_node);
-    if (heap_node->is_top()) {
+    if (timeout_queue_.is_top(heap_node)) {
       update_timeout("set_timeout 2");
     }
   }
@@ -43,7 +43,7 @@ void MultiTimeout::add_timeout_at(int64 key, double timeout) {
   } else {
     CHECK(item.second);
     timeout_queue_.insert(timeout, heap_node);
-    if (heap_node->is_top()) {
+    if (timeout_queue_.is_top(heap_node)) {
       update_timeout("add_timeout");
     }
   }
@@ -55,7 +55,7 @@ void MultiTimeout::cancel_timeout(int64 key, const char *source) {
   if (item != items_.end()) {
     auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item));
     CHECK(heap_node->in_heap());
-    bool need_update_timeout = heap_node->is_top();
+    bool need_update_timeout = timeout_queue_.is_top(heap_node);
     timeout_queue_.erase(heap_node);
     items_.erase(item);
 
@@ -68,7 +68,7 @@ class MultiTimeout final : public Actor {
   Callback callback_;
   Data data_;
 
-  KHeap<double> timeout_queue_;
+  TimeoutQueue timeout_queue_;
   std::set<Item> items_;
 
   void update_timeout(const char *source);
@@ -75,6 +75,14 @@ class Actor : public ObserverBase {
   void migrate(int32 sched_id);
   void do_migrate(int32 sched_id);
 
+  // allows the scheduler to migrate the actor to an idle scheduler if work stealing is enabled
+  // must not be set for actors, which are subscribed to file descriptors or rely on the scheduler they are run on
+  void set_migratable(bool is_migratable);
+
+  // limits the number of events waiting in the mailbox of the actor; capacity 0 means no limit
+  // the limit isn't applied to system and high-priority events, and to events sent while the actor is running
+  void set_mailbox_limit(size_t capacity, MailboxOverflowPolicy overflow_policy);
+
   uint64 get_link_token();
   std::weak_ptr<ActorContext> get_context_weak_ptr() const;
   std::shared_ptr<ActorContext> set_context(std::shared_ptr<ActorContext> context);
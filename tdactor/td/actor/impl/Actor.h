@@ -72,6 +72,12 @@ inline void Actor::migrate(int32 sched_id) {
 inline void Actor::do_migrate(int32 sched_id) {
   Scheduler::instance()->do_migrate_actor(this, sched_id);
 }
+inline void Actor::set_migratable(bool is_migratable) {
+  info_->set_migratable(is_migratable);
+}
+inline void Actor::set_mailbox_limit(size_t capacity, MailboxOverflowPolicy overflow_policy) {
+  info_->set_mailbox_limit(capacity, overflow_policy);
+}
 
 template <class ActorType>
 std::enable_if_t<std::is_base_of<Actor, ActorType>::value> start_migrate(ActorType &obj, int32 sched_id) {
@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/actor/ActorStatistics.h"
 #include "td/actor/impl/ActorId-decl.h"
 #include "td/actor/impl/Event.h"
 
@@ -24,6 +25,13 @@ namespace td {
 
 class Actor;
 
+// what to do with an ordinary event sent to an actor, which mailbox is full
+enum class MailboxOverflowPolicy : int32 {
+  Block,    // a sender from another thread waits until the mailbox is drained, but at most for 10 milliseconds
+  Drop,     // the event is dropped
+  Coalesce  // the event replaces the last queued call of the same method with the same link token
+};
+
 class ActorContext {
  public:
   ActorContext() = default;
@@ -108,14 +116,38 @@ class ActorInfo final
   bool need_context() const;
   bool need_start_up() const;
 
+  void set_migratable(bool is_migratable);
+  bool is_migratable() const;
+
+  // returns nullptr if actor statistics weren't enabled when the actor was created
+  ActorStatistics::Entry *get_statistics() const;
+
+  void set_mailbox_limit(size_t capacity, MailboxOverflowPolicy overflow_policy);
+  // the following methods can be called from any thread
+  size_t get_mailbox_capacity() const;
+  MailboxOverflowPolicy get_mailbox_overflow_policy() const;
+  // returns the number of events in the mailbox and sent from other threads, which weren't received yet;
+  // the values are updated only for actors with a mailbox limit
+  size_t get_published_mailbox_size() const;
+  void publish_mailbox_size();
+  void on_send_from_other_thread();
+  void on_receive_from_other_thread();
+
  private:
   Deleter deleter_ = Deleter::None;
   bool need_context_ = true;
   bool need_start_up_ = true;
   bool is_running_ = false;
+  bool is_migratable_ = false;
 
   std::atomic<int32> sched_id_{0};
   Actor *actor_ = nullptr;
+  ActorStatistics::Entry *statistics_ = nullptr;
+
+  std::atomic<size_t> mailbox_capacity_{0};
+  std::atomic<MailboxOverflowPolicy> mailbox_overflow_policy_{MailboxOverflowPolicy::Drop};
+  std::atomic<size_t> published_mailbox_size_{0};
+  std::atomic<int64> in_flight_event_count_{0};
 
 #ifdef TD_DEBUG
   string name_;
@@ -50,6 +50,11 @@ inline void ActorInfo::init(int32 sched_id, Slice name, ObjectPool<ActorInfo>::O
   need_context_ = need_context;
   need_start_up_ = need_start_up;
   is_running_ = false;
+  is_migratable_ = false;
+  statistics_ = ActorStatistics::is_enabled() ? ActorStatistics::get_entry(name) : nullptr;
+  mailbox_capacity_.store(0, std::memory_order_relaxed);
+  published_mailbox_size_.store(0, std::memory_order_relaxed);
+  in_flight_event_count_.store(0, std::memory_order_relaxed);
 }
 
 inline bool ActorInfo::need_context() const {
@@ -60,6 +65,51 @@ inline bool ActorInfo::need_start_up() const {
   return need_start_up_;
 }
 
+inline void ActorInfo::set_migratable(bool is_migratable) {
+  is_migratable_ = is_migratable;
+}
+
+inline bool ActorInfo::is_migratable() const {
+  return is_migratable_;
+}
+
+inline ActorStatistics::Entry *ActorInfo::get_statistics() const {
+  return statistics_;
+}
+
+inline void ActorInfo::set_mailbox_limit(size_t capacity, MailboxOverflowPolicy overflow_policy) {
+  mailbox_overflow_policy_.store(overflow_policy, std::memory_order_relaxed);
+  mailbox_capacity_.store(capacity, std::memory_order_relaxed);
+  publish_mailbox_size();
+}
+
+inline size_t ActorInfo::get_mailbox_capacity() const {
+  return mailbox_capacity_.load(std::memory_order_relaxed);
+}
+
+inline MailboxOverflowPolicy ActorInfo::get_mailbox_overflow_policy() const {
+  return mailbox_overflow_policy_.load(std::memory_order_relaxed);
+}
+
+inline size_t ActorInfo::get_published_mailbox_size() const {
+  // the counter can be negative if events were sent before the mailbox limit was set
+  auto in_flight_event_count = in_flight_event_count_.load(std::memory_order_relaxed);
+  return published_mailbox_size_.load(std::memory_order_relaxed) +
+         static_cast<size_t>(in_flight_event_count > 0 ? in_flight_event_count : 0);
+}
+
+inline void ActorInfo::publish_mailbox_size() {
+  published_mailbox_size_.store(mailbox_.size(), std::memory_order_relaxed);
+}
+
+inline void ActorInfo::on_send_from_other_thread() {
+  in_flight_event_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void ActorInfo::on_receive_from_other_thread() {
+  in_flight_event_count_.fetch_sub(1, std::memory_order_relaxed);
+}
+
 inline void ActorInfo::on_actor_moved(Actor *actor_new_ptr) {
   actor_ = actor_new_ptr;
 }
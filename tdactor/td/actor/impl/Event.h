@@ -8,6 +8,7 @@
 
 #include "td/utils/Closure.h"
 #include "td/utils/common.h"
+#include "td/utils/SmallObjectAllocator.h"
 #include "td/utils/StringBuilder.h"
 
 #include <type_traits>
@@ -47,11 +48,29 @@ class CustomEvent {
   CustomEvent &operator=(CustomEvent &&) = delete;
   virtual ~CustomEvent() = default;
 
+  // an event is allocated for almost every message, so the memory is reused through per-thread free lists
+  static void *operator new(size_t size) {
+    return SmallObjectAllocator::allocate(size);
+  }
+  static void operator delete(void *ptr, size_t size) noexcept {
+    SmallObjectAllocator::deallocate(ptr, size);
+  }
+
   virtual void run(Actor *actor) = 0;
   virtual void start_migrate(int32 sched_id) {
   }
   virtual void finish_migrate() {
   }
+
+  // events with the same non-null type identifier are created from the same closure type
+  virtual const void *get_type_id() const {
+    return nullptr;
+  }
+
+  // returns true, if the event can replace the other event with the same type identifier in a full mailbox
+  virtual bool can_replace(const CustomEvent &other) const {
+    return false;
+  }
 };
 
 template <class ClosureT>
@@ -78,10 +97,24 @@ class ClosureEvent final : public CustomEvent {
     });
   }
 
+  const void *get_type_id() const final {
+    return &type_id_;
+  }
+
+  // different methods with the same signature have the same closure type
+  bool can_replace(const CustomEvent &other) const final {
+    return other.get_type_id() == &type_id_ &&
+           static_cast<const ClosureEvent &>(other).closure_.get_function() == closure_.get_function();
+  }
+
  private:
   ClosureT closure_;
+  static const char type_id_;
 };
 
+template <class ClosureT>
+const char ClosureEvent<ClosureT>::type_id_ = 0;
+
 template <class LambdaT>
 class LambdaEvent final : public CustomEvent {
  public:
@@ -92,6 +125,8 @@ class LambdaEvent final : public CustomEvent {
   explicit LambdaEvent(FromLambdaT &&func) : f_(std::forward<FromLambdaT>(func)) {
   }
 
+  // lambdas of the same type can have different captures, including promises, so they are never coalesced
+
  private:
   LambdaT f_;
 };
@@ -100,6 +135,7 @@ class Event {
  public:
   enum class Type { NoType, Start, Stop, Yield, Timeout, Hangup, Raw, Custom };
   Type type;
+  bool is_high_priority = false;  // high-priority events are delivered before ordinary events waiting in the mailbox
   uint64 link_token = 0;
   union Raw {
     void *ptr;
@@ -157,12 +193,14 @@ class Event {
   }
   Event(const Event &) = delete;
   Event &operator=(const Event &) = delete;
-  Event(Event &&other) noexcept : type(other.type), link_token(other.link_token), data(other.data) {
+  Event(Event &&other) noexcept
+      : type(other.type), is_high_priority(other.is_high_priority), link_token(other.link_token), data(other.data) {
     other.type = Type::NoType;
   }
   Event &operator=(Event &&other) noexcept {
     destroy();
     type = other.type;
+    is_high_priority = other.is_high_priority;
     link_token = other.link_token;
     data = other.data;
     other.type = Type::NoType;
@@ -186,6 +224,11 @@ class Event {
     return *this;
   }
 
+  Event &set_high_priority() {
+    is_high_priority = true;
+    return *this;
+  }
+
   friend void start_migrate(Event &obj, int32 sched_id) {
     if (obj.type == Type::Custom) {
       obj.data.custom_event->start_migrate(sched_id);
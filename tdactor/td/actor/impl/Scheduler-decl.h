@@ -26,8 +26,10 @@
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Time.h"
+#include "td/utils/TimerWheel.h"
 #include "td/utils/type_traits.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <type_traits>
@@ -37,6 +39,12 @@ namespace td {
 
 extern int VERBOSITY_NAME(actor);
 
+#if TD_ACTOR_TIMER_WHEEL
+using TimeoutQueue = TimerWheel;
+#else
+using TimeoutQueue = KHeap<double>;
+#endif
+
 class ActorInfo;
 
 class Scheduler;
@@ -133,6 +141,9 @@ class Scheduler {
   void stop_actor(Actor *actor);
   void do_stop_actor(Actor *actor);
   uint64 get_link_token(Actor *actor);
+  ActorId<> get_current_actor_id() const;
+  // returns true if the actor is being run by the scheduler now and isn't being destroyed
+  bool is_actor_running(const ActorId<> &actor_id) const;
   void migrate_actor(Actor *actor, int32 dest_sched_id);
   void do_migrate_actor(Actor *actor, int32 dest_sched_id);
   void start_migrate_actor(Actor *actor, int32 dest_sched_id);
@@ -159,11 +170,75 @@ class Scheduler {
 
   Timestamp get_timeout();
 
+  // returns total time in seconds spent by the scheduler in processing of events; can be called from any thread
+  double get_busy_time() const {
+    return busy_time_.load(std::memory_order_relaxed);
+  }
+
+  // returns the number of batches of events sent to other schedulers; can be called from any thread
+  uint64 get_outbound_batch_count() const {
+    return outbound_batch_count_.load(std::memory_order_relaxed);
+  }
+
+  // returns the total number of events in batches sent to other schedulers; can be called from any thread
+  uint64 get_outbound_batched_event_count() const {
+    return outbound_batched_event_count_.load(std::memory_order_relaxed);
+  }
+
+  // before sleeping in poll the scheduler will check events from other threads for at most max_busy_poll_time
+  // seconds; the time is adapted to the frequency of the events
+  void enable_busy_polling(double max_busy_poll_time) {
+    max_busy_poll_time_ = max_busy_poll_time;
+    busy_poll_time_ = max_busy_poll_time;
+  }
+
+  // returns the number of times the scheduler checked events before sleeping; can be called from any thread
+  uint64 get_busy_poll_count() const {
+    return busy_poll_count_.load(std::memory_order_relaxed);
+  }
+
+  // returns the number of times the scheduler received an event while busy polling instead of being woken up;
+  // can be called from any thread
+  uint64 get_avoided_wakeup_count() const {
+    return avoided_wakeup_count_.load(std::memory_order_relaxed);
+  }
+
+  // returns the number of events dropped because of full mailboxes; can be called from any thread
+  uint64 get_dropped_event_count() const {
+    return dropped_event_count_.load(std::memory_order_relaxed);
+  }
+
+  // returns the number of events coalesced with queued events because of full mailboxes;
+  // can be called from any thread
+  uint64 get_coalesced_event_count() const {
+    return coalesced_event_count_.load(std::memory_order_relaxed);
+  }
+
+  // returns the number of times the scheduler waited for a full mailbox of an actor on another scheduler;
+  // can be called from any thread
+  uint64 get_blocked_send_count() const {
+    return blocked_send_count_.load(std::memory_order_relaxed);
+  }
+
+  // asks the scheduler to migrate one of its ready migratable actors to the scheduler dest_sched_id
+  // can be called from any thread
+  void request_actor_migration(int32 dest_sched_id) {
+    actor_migration_request_.store(dest_sched_id, std::memory_order_relaxed);
+  }
+
  private:
+  // the sender's scheduler doesn't process its own events while waiting, so the wait must be short
+  static constexpr double MAX_MAILBOX_WAIT_TIME = 0.01;
+
   static void set_scheduler(Scheduler *scheduler);
 
   void destroy_on_scheduler_impl(int32 sched_id, Promise<Unit> action);
 
+  void add_busy_time(double busy_time) {
+    // the value is changed only by the scheduler thread
+    busy_time_.store(busy_time_.load(std::memory_order_relaxed) + busy_time, std::memory_order_relaxed);
+  }
+
   class ServiceActor final : public Actor {
    public:
     void set_queue(std::shared_ptr<MpscPollableQueue<EventFull>> queues);
@@ -200,6 +275,8 @@ class Scheduler {
 
   void register_migrated_actor(ActorInfo *actor_info);
   void add_to_mailbox(ActorInfo *actor_info, Event &&event);
+  bool on_mailbox_overflow(ActorInfo *actor_info, Event &event);
+  void wait_for_mailbox(const ActorInfo *actor_info);
   void clear_mailbox(ActorInfo *actor_info);
 
   void flush_mailbox(ActorInfo *actor_info);
@@ -213,6 +290,10 @@ class Scheduler {
   void send_later_impl(const ActorId<> &actor_id, Event &&event);
 
   Timestamp run_timeout();
+  void migrate_ready_actor(int32 dest_sched_id);
+  void flush_outbound_batches();
+
+  bool busy_poll(Timestamp timeout);
   void run_mailbox();
   Timestamp run_events(Timestamp timeout);
   void run_poll(Timestamp timeout);
@@ -230,13 +311,32 @@ class Scheduler {
   int32 actor_count_ = 0;
   ListNode pending_actors_list_;
   ListNode ready_actors_list_;
-  KHeap<double> timeout_queue_;
+  TimeoutQueue timeout_queue_;
 
   FlatHashMap<ActorInfo *, std::vector<Event>> pending_events_;
 
   ServiceActor service_actor_;
   Poll poll_;
 
+  std::atomic<double> busy_time_{0.0};
+  std::atomic<int32> actor_migration_request_{-1};
+
+  // events sent to other schedulers during a run_mailbox pass are delivered at its end
+  bool is_outbound_batching_ = false;
+  bool has_outbound_batches_ = false;
+  std::vector<std::vector<EventFull>> outbound_batches_;
+  std::atomic<uint64> outbound_batch_count_{0};
+  std::atomic<uint64> outbound_batched_event_count_{0};
+
+  double max_busy_poll_time_ = 0.0;
+  double busy_poll_time_ = 0.0;
+  std::atomic<uint64> busy_poll_count_{0};
+  std::atomic<uint64> avoided_wakeup_count_{0};
+
+  std::atomic<uint64> dropped_event_count_{0};
+  std::atomic<uint64> coalesced_event_count_{0};
+  std::atomic<uint64> blocked_send_count_{0};
+
   bool yield_flag_ = false;
   bool has_guard_ = false;
   bool close_flag_ = false;
@@ -21,6 +21,7 @@
 #include "td/utils/misc.h"
 #include "td/utils/MpscPollableQueue.h"
 #include "td/utils/ObjectPool.h"
+#include "td/utils/port/sleep.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/Promise.h"
 #include "td/utils/ScopeGuard.h"
@@ -96,6 +97,11 @@ void Scheduler::ServiceActor::loop() {
     } else {
       VLOG(actor) << "Receive " << event.data();
       finish_migrate(event.data());
+      // the event can stop the actor and its ActorInfo can be reused, so the counter must be updated before emit
+      auto actor_info = event.actor_id().get_actor_info();
+      if (actor_info != nullptr && unlikely(actor_info->get_mailbox_capacity() != 0)) {
+        actor_info->on_receive_from_other_thread();
+      }
       event.try_emit();
     }
   }
@@ -229,6 +235,7 @@ void Scheduler::init(int32 id, std::vector<std::shared_ptr<MpscPollableQueue<Eve
   outbound_queues_ = std::move(outbound);
   sched_id_ = id;
   sched_n_ = static_cast<int32>(outbound_queues_.size());
+  outbound_batches_.resize(outbound_queues_.size());
   service_actor_.set_queue(inbound_queue_);
   register_actor(PSLICE() << "ServiceActor" << id, &service_actor_).release();
 }
@@ -359,10 +366,19 @@ void Scheduler::send_to_other_scheduler(int32 sched_id, const ActorId<> &actor_i
     auto actor_info = actor_id.get_actor_info();
     if (actor_info) {
       VLOG(actor) << "Send to " << *actor_info << " on scheduler " << sched_id << ": " << event;
+      if (unlikely(actor_info->get_mailbox_capacity() != 0)) {
+        wait_for_mailbox(actor_info);
+        actor_info->on_send_from_other_thread();
+      }
     } else {
       VLOG(actor) << "Send to scheduler " << sched_id << ": " << event;
     }
     start_migrate(event, sched_id);
+    if (is_outbound_batching_) {
+      outbound_batches_[sched_id].push_back(EventCreator::event_unsafe(actor_id, std::move(event)));
+      has_outbound_batches_ = true;
+      return;
+    }
     outbound_queues_[sched_id]->writer_put(EventCreator::event_unsafe(actor_id, std::move(event)));
     outbound_queues_[sched_id]->writer_flush();
   }
@@ -405,14 +421,91 @@ void Scheduler::destroy_on_scheduler_impl(int32 sched_id, Promise<Unit> action)
   LOG_TAG = current_tag;
 }
 
+bool Scheduler::on_mailbox_overflow(ActorInfo *actor_info, Event &event) {
+  auto &mailbox = actor_info->mailbox_;
+  if (mailbox.size() < actor_info->get_mailbox_capacity() || actor_info->is_running() ||
+      event.type != Event::Type::Custom || event.is_high_priority) {
+    return false;
+  }
+
+  auto statistics = actor_info->get_statistics();
+  switch (actor_info->get_mailbox_overflow_policy()) {
+    case MailboxOverflowPolicy::Block:
+      // senders from other threads have already waited, so the event is queued
+      return false;
+    case MailboxOverflowPolicy::Drop:
+      VLOG(actor) << "Drop " << event << " sent to " << *actor_info << " with full mailbox";
+      dropped_event_count_.store(dropped_event_count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      if (unlikely(statistics != nullptr)) {
+        ActorStatistics::on_dropped_event(statistics);
+      }
+      return true;
+    case MailboxOverflowPolicy::Coalesce: {
+      if (event.data.custom_event->get_type_id() == nullptr) {
+        return false;
+      }
+      for (auto it = mailbox.rbegin(); it != mailbox.rend(); ++it) {
+        if (it->type == Event::Type::Custom && !it->is_high_priority && it->link_token == event.link_token &&
+            event.data.custom_event->can_replace(*it->data.custom_event)) {
+          VLOG(actor) << "Coalesce " << event << " sent to " << *actor_info << " with full mailbox";
+          *it = std::move(event);
+          coalesced_event_count_.store(coalesced_event_count_.load(std::memory_order_relaxed) + 1,
+                                       std::memory_order_relaxed);
+          if (unlikely(statistics != nullptr)) {
+            ActorStatistics::on_coalesced_event(statistics);
+          }
+          return true;
+        }
+      }
+      return false;
+    }
+    default:
+      UNREACHABLE();
+      return false;
+  }
+}
+
+void Scheduler::wait_for_mailbox(const ActorInfo *actor_info) {
+  auto capacity = actor_info->get_mailbox_capacity();
+  if (actor_info->get_mailbox_overflow_policy() != MailboxOverflowPolicy::Block ||
+      actor_info->get_published_mailbox_size() < capacity) {
+    return;
+  }
+
+  // the wait is limited, because the actor can wait for the current scheduler itself
+  blocked_send_count_.store(blocked_send_count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  flush_outbound_batches();
+  auto deadline = Timestamp::in(MAX_MAILBOX_WAIT_TIME);
+  while (actor_info->get_published_mailbox_size() >= capacity && !close_flag_ && !deadline.is_in_past()) {
+    usleep_for(100);
+  }
+}
+
 void Scheduler::add_to_mailbox(ActorInfo *actor_info, Event &&event) {
+  bool has_mailbox_limit = actor_info->get_mailbox_capacity() != 0;
+  if (unlikely(has_mailbox_limit) && on_mailbox_overflow(actor_info, event)) {
+    return;
+  }
   if (!actor_info->is_running()) {
     auto node = actor_info->get_list_node();
     node->remove();
     ready_actors_list_.put(node);
   }
   VLOG(actor) << "Add to mailbox: " << *actor_info << " " << event;
-  actor_info->mailbox_.push_back(std::move(event));
+  auto &mailbox = actor_info->mailbox_;
+  if (event.is_high_priority && !actor_info->is_running()) {
+    // put the event before ordinary closures, but after other high-priority and all system events
+    auto it = mailbox.end();
+    while (it != mailbox.begin() && !(it - 1)->is_high_priority && (it - 1)->type == Event::Type::Custom) {
+      --it;
+    }
+    mailbox.insert(it, std::move(event));
+  } else {
+    mailbox.push_back(std::move(event));
+  }
+  if (unlikely(has_mailbox_limit)) {
+    actor_info->publish_mailbox_size();
+  }
 }
 
 void Scheduler::do_stop_actor(Actor *actor) {
@@ -509,7 +602,42 @@ void Scheduler::set_actor_timeout_at(ActorInfo *actor_info, double timeout_at) {
   }
 }
 
+bool Scheduler::busy_poll(Timestamp timeout) {
+  if (!inbound_queue_ || timeout.is_in_past() || !inbound_queue_->reader_disable_wakeup()) {
+    return false;
+  }
+  busy_poll_count_.store(busy_poll_count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+  auto deadline = min(Time::now() + busy_poll_time_, timeout.at());
+  bool has_events = false;
+  do {
+    has_events = inbound_queue_->reader_has_values();
+  } while (!has_events && Time::now() < deadline);
+  if (!has_events) {
+    has_events = inbound_queue_->reader_enable_wakeup();
+  }
+
+  // spin longer while events arrive during busy polling, and shorter if they don't
+  if (has_events) {
+    avoided_wakeup_count_.store(avoided_wakeup_count_.load(std::memory_order_relaxed) + 1,
+                                std::memory_order_relaxed);
+    busy_poll_time_ = min(busy_poll_time_ * 2, max_busy_poll_time_);
+    service_actor_.notify();
+  } else {
+    busy_poll_time_ = max(busy_poll_time_ * 0.5, max_busy_poll_time_ / 64);
+  }
+  return has_events;
+}
+
 void Scheduler::run_poll(Timestamp timeout) {
+  if (max_busy_poll_time_ > 0 && busy_poll(timeout)) {
+    // the events will be processed by the service actor; handle only already ready file descriptors
+#if TD_PORT_POSIX
+    poll_.run(0);
+#endif
+    return;
+  }
+
   // we can't wait for less than 1ms
   auto timeout_ms = static_cast<int>(clamp(timeout.in(), 0.0, 1000000.0) * 1000 + 1);
 #if TD_PORT_WINDOWS
@@ -527,14 +655,81 @@ void Scheduler::flush_mailbox(ActorInfo *actor_info) {
   CHECK(mailbox_size != 0);
   EventGuard guard(this, actor_info);
   size_t i = 0;
-  for (; i < mailbox_size && guard.can_run(); i++) {
-    do_event(actor_info, std::move(mailbox[i]));
+  auto statistics = actor_info->get_statistics();
+  if (unlikely(statistics != nullptr)) {
+    ActorStatistics::on_mailbox_size(statistics, mailbox_size);
+    for (; i < mailbox_size && guard.can_run(); i++) {
+      auto start_time = Time::now();
+      do_event(actor_info, std::move(mailbox[i]));
+      ActorStatistics::on_event(statistics, Time::now() - start_time);
+    }
+  } else {
+    for (; i < mailbox_size && guard.can_run(); i++) {
+      do_event(actor_info, std::move(mailbox[i]));
+    }
   }
   mailbox.erase(mailbox.begin(), mailbox.begin() + i);
+  if (unlikely(actor_info->get_mailbox_capacity() != 0)) {
+    actor_info->publish_mailbox_size();
+  }
+}
+
+void Scheduler::migrate_ready_actor(int32 dest_sched_id) {
+  if (dest_sched_id == sched_id_ || dest_sched_id >= sched_count()) {
+    return;
+  }
+
+  // leave at least one ready actor to the scheduler, so it doesn't become idle itself
+  ActorInfo *migrated_actor_info = nullptr;
+  bool has_other_ready_actors = false;
+  for (ListNode *end = &ready_actors_list_, *it = ready_actors_list_.get_next(); it != end; it = it->get_next()) {
+    auto actor_info = ActorInfo::from_list_node(it);
+    if (migrated_actor_info == nullptr && actor_info->is_migratable() && !actor_info->is_running()) {
+      migrated_actor_info = actor_info;
+    } else {
+      has_other_ready_actors = true;
+    }
+  }
+  if (migrated_actor_info == nullptr || !has_other_ready_actors) {
+    return;
+  }
+
+  VLOG(actor) << "Migrate ready actor " << *migrated_actor_info << " to idle scheduler " << dest_sched_id;
+  do_migrate_actor(migrated_actor_info, dest_sched_id);
+}
+
+void Scheduler::flush_outbound_batches() {
+  if (!has_outbound_batches_) {
+    return;
+  }
+  has_outbound_batches_ = false;
+
+  uint64 batch_count = 0;
+  uint64 event_count = 0;
+  for (size_t sched_id = 0; sched_id < outbound_batches_.size(); sched_id++) {
+    auto &batch = outbound_batches_[sched_id];
+    if (batch.empty()) {
+      continue;
+    }
+    batch_count++;
+    event_count += batch.size();
+    outbound_queues_[sched_id]->writer_put_batch(batch);
+    outbound_queues_[sched_id]->writer_flush();
+  }
+  // the values are changed only by the scheduler thread
+  outbound_batch_count_.store(outbound_batch_count_.load(std::memory_order_relaxed) + batch_count,
+                              std::memory_order_relaxed);
+  outbound_batched_event_count_.store(outbound_batched_event_count_.load(std::memory_order_relaxed) + event_count,
+                                      std::memory_order_relaxed);
 }
 
 void Scheduler::run_mailbox() {
   VLOG(actor) << "Run mailbox : begin";
+  if (actor_migration_request_.load(std::memory_order_relaxed) >= 0) {
+    migrate_ready_actor(actor_migration_request_.exchange(-1, std::memory_order_relaxed));
+  }
+  CHECK(!is_outbound_batching_);
+  is_outbound_batching_ = true;
   ListNode actors_list = std::move(ready_actors_list_);
   while (!actors_list.empty()) {
     ListNode *node = actors_list.get();
@@ -542,6 +737,8 @@ void Scheduler::run_mailbox() {
     auto actor_info = ActorInfo::from_list_node(node);
     flush_mailbox(actor_info);
   }
+  is_outbound_batching_ = false;
+  flush_outbound_batches();
   VLOG(actor) << "Run mailbox : finish " << actor_count_;
 
   //Useful for debug, but O(ActorsCount) check
@@ -590,12 +787,17 @@ void Scheduler::run_no_guard(Timestamp timeout) {
     yield_flag_ = false;
   };
 
+  auto start_time = Time::now();
   timeout.relax(run_events(timeout));
+  auto busy_time = Time::now() - start_time;
   if (yield_flag_) {
+    add_busy_time(busy_time);
     return;
   }
   run_poll(timeout);
+  start_time = Time::now();
   run_events(timeout);
+  add_busy_time(busy_time + (Time::now() - start_time));
 }
 
 Timestamp Scheduler::get_timeout() {
@@ -193,7 +193,14 @@ void Scheduler::send_immediately_impl(const ActorId<> &actor_id, const RunFuncT
 
   if (likely(can_send_immediately)) {  // run immediately
     EventGuard guard(this, actor_info);
-    run_func(actor_info);
+    auto statistics = actor_info->get_statistics();
+    if (unlikely(statistics != nullptr)) {
+      auto start_time = Time::now();
+      run_func(actor_info);
+      ActorStatistics::on_event(statistics, Time::now() - start_time);
+    } else {
+      run_func(actor_info);
+    }
   } else {
     if (on_current_sched) {
       add_to_mailbox(actor_info, event_func());
@@ -294,6 +301,17 @@ inline uint64 Scheduler::get_link_token(ActorInfo *actor_info) {
   return event_context_ptr_->link_token;
 }
 
+inline ActorId<> Scheduler::get_current_actor_id() const {
+  auto actor_info = event_context_ptr_ == nullptr ? nullptr : event_context_ptr_->actor_info;
+  return actor_info == nullptr ? ActorId<>() : actor_info->actor_id();
+}
+
+inline bool Scheduler::is_actor_running(const ActorId<> &actor_id) const {
+  auto actor_info = event_context_ptr_ == nullptr ? nullptr : event_context_ptr_->actor_info;
+  // the actor is cleared before destruction
+  return actor_info != nullptr && actor_info == actor_id.get_actor_info() && !actor_info->get_actor_unsafe()->empty();
+}
+
 inline void Scheduler::finish_migrate_actor(Actor *actor) {
   register_migrated_actor(actor->get_info());
 }
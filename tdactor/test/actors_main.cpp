@@ -10,10 +10,12 @@
 
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/sleep.h"
 #include "td/utils/Random.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/tests.h"
 
+#include <atomic>
 #include <limits>
 #include <map>
 #include <memory>
@@ -504,3 +506,225 @@ TEST(Actors, context_during_destruction) {
   }
   sched.finish();
 }
+
+static std::atomic<bool> is_stolen_actor_migrated{false};
+
+class SpinningActor final : public td::Actor {
+ public:
+  explicit SpinningActor(bool is_migratable) : is_migratable_(is_migratable) {
+  }
+
+ private:
+  bool is_migratable_;
+
+  void start_up() final {
+    set_migratable(is_migratable_);
+    yield();
+  }
+
+  void loop() final {
+    if (is_stolen_actor_migrated) {
+      return stop();
+    }
+    if (is_migratable_ && td::Scheduler::instance()->sched_id() != 1) {
+      is_stolen_actor_migrated = true;
+      td::Scheduler::instance()->finish();
+      return stop();
+    }
+    yield();
+  }
+};
+
+TEST(Actors, work_stealing) {
+  int threads_n = 2;
+  td::ConcurrentScheduler sched(threads_n, 0);
+  sched.enable_work_stealing();
+
+  sched.create_actor_unsafe<SpinningActor>(1, "Pinned", false).release();
+  sched.create_actor_unsafe<SpinningActor>(1, "Migratable", true).release();
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+  ASSERT_TRUE(is_stolen_actor_migrated);
+}
+
+class FanOutSender;
+
+class FanOutReceiver final : public td::Actor {
+ public:
+  explicit FanOutReceiver(td::ActorId<FanOutSender> sender) : sender_(sender) {
+  }
+
+  void receive(int value);
+
+ private:
+  td::ActorId<FanOutSender> sender_;
+  int received_count_ = 0;
+};
+
+class FanOutSender final : public td::Actor {
+ public:
+  static constexpr int EVENT_COUNT = 1000;
+
+  void on_received() {
+    auto scheduler = td::Scheduler::instance();
+    auto batch_count = scheduler->get_outbound_batch_count();
+    auto event_count = scheduler->get_outbound_batched_event_count();
+    ASSERT_TRUE(event_count >= static_cast<td::uint64>(EVENT_COUNT));
+    ASSERT_TRUE(batch_count * 100 < event_count);
+    receiver_.reset();
+    td::Scheduler::instance()->finish();
+    stop();
+  }
+
+ private:
+  td::ActorOwn<FanOutReceiver> receiver_;
+
+  void start_up() final {
+    receiver_ = td::create_actor_on_scheduler<FanOutReceiver>("FanOutReceiver", 2, actor_id(this));
+    for (int i = 0; i < EVENT_COUNT; i++) {
+      send_closure(receiver_, &FanOutReceiver::receive, i);
+    }
+  }
+};
+
+void FanOutReceiver::receive(int value) {
+  CHECK(value == received_count_);
+  if (++received_count_ == FanOutSender::EVENT_COUNT) {
+    send_closure(sender_, &FanOutSender::on_received);
+  }
+}
+
+TEST(Actors, batched_cross_scheduler_events) {
+  int threads_n = 2;
+  td::ConcurrentScheduler sched(threads_n, 0);
+
+  sched.create_actor_unsafe<FanOutSender>(1, "FanOutSender").release();
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+}
+
+class BusyPollPong final : public td::Actor {
+ public:
+  void ping(td::Promise<int> promise, int value) {
+    promise.set_value(value + 1);
+  }
+};
+
+class BusyPollPing final : public td::Actor {
+  static constexpr int ROUND_TRIP_COUNT = 200;
+
+  td::ActorOwn<BusyPollPong> pong_;
+  int value_ = 0;
+
+  void start_up() final {
+    pong_ = td::create_actor_on_scheduler<BusyPollPong>("BusyPollPong", 2);
+    loop();
+  }
+
+  void loop() final {
+    if (value_ == ROUND_TRIP_COUNT) {
+      pong_.reset();
+      td::Scheduler::instance()->finish();
+      stop();
+      return;
+    }
+    send_closure(pong_, &BusyPollPong::ping, td::PromiseCreator::lambda([actor_id = actor_id(this)](int value) {
+                   send_closure(actor_id, &BusyPollPing::on_pong, value);
+                 }),
+                 value_);
+  }
+
+ public:
+  void on_pong(int value) {
+    CHECK(value == value_ + 1);
+    value_ = value;
+    loop();
+  }
+};
+
+TEST(Actors, busy_polling) {
+  td::ConcurrentScheduler sched(2, 0);
+  sched.enable_busy_polling(1e-4);
+
+  sched.create_actor_unsafe<BusyPollPing>(1, "BusyPollPing").release();
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  auto busy_poll_count = sched.get_busy_poll_count();
+  auto avoided_wakeup_count = sched.get_avoided_wakeup_count();
+  sched.finish();
+  LOG(INFO) << "Avoided " << avoided_wakeup_count << " wakeups out of " << busy_poll_count;
+  ASSERT_TRUE(busy_poll_count > 0);
+  ASSERT_TRUE(avoided_wakeup_count <= busy_poll_count);
+}
+
+class BlockingReceiver final : public td::Actor {
+ public:
+  explicit BlockingReceiver(td::ActorShared<> parent) : parent_(std::move(parent)) {
+  }
+
+  void start_up() final {
+    set_mailbox_limit(4, td::MailboxOverflowPolicy::Block);
+    send_event(parent_, td::Event::yield());
+  }
+
+  void f(int value) {
+    CHECK(value == next_value_);
+    next_value_++;
+    td::usleep_for(100);
+  }
+
+  int next_value_ = 0;
+
+ private:
+  td::ActorShared<> parent_;
+};
+
+class BlockingSender final : public td::Actor {
+  static constexpr int EVENT_COUNT = 100;
+
+  td::ActorOwn<BlockingReceiver> receiver_;
+  bool is_sent_ = false;
+
+  void start_up() final {
+    receiver_ = td::create_actor_on_scheduler<BlockingReceiver>("BlockingReceiver", 1, actor_shared(this));
+  }
+
+  void wakeup() final {
+    if (is_sent_) {
+      return;
+    }
+    is_sent_ = true;
+    for (int i = 0; i < EVENT_COUNT; i++) {
+      send_closure(receiver_, &BlockingReceiver::f, i);
+    }
+    receiver_.reset();
+  }
+
+  void hangup_shared() final {
+    td::Scheduler::instance()->finish();
+    stop();
+  }
+};
+
+TEST(Actors, blocking_mailbox) {
+  td::ConcurrentScheduler sched(2, 0);
+
+  sched.create_actor_unsafe<BlockingSender>(2, "BlockingSender").release();
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  auto blocked_send_count = sched.get_blocked_send_count();
+  auto dropped_event_count = sched.get_dropped_event_count();
+  sched.finish();
+  ASSERT_TRUE(blocked_send_count > 0);
+  ASSERT_EQ(0u, dropped_event_count);
+}
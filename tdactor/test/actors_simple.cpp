@@ -5,12 +5,15 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 #include "td/actor/actor.h"
+#include "td/actor/ActorStatistics.h"
 #include "td/actor/ConcurrentScheduler.h"
+#include "td/actor/Coroutine.h"
 #include "td/actor/MultiPromise.h"
 #include "td/actor/PromiseFuture.h"
 #include "td/actor/SleepActor.h"
 
 #include "td/utils/common.h"
+#include "td/utils/config.h"
 #include "td/utils/logging.h"
 #include "td/utils/MpscPollableQueue.h"
 #include "td/utils/Observer.h"
@@ -18,6 +21,7 @@
 #include "td/utils/port/path.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/Promise.h"
+#include "td/utils/SmallObjectAllocator.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
@@ -445,6 +449,49 @@ TEST(Actors, promise) {
   ASSERT_EQ(1, value);
 }
 
+TEST(Actors, promise_small_object_allocator) {
+  static_assert(sizeof(td::Promise<int>) == sizeof(void *), "Promise must stay a single pointer");
+
+  int value = 0;
+  int lost_count = 0;
+  td::string big_capture(td::SmallObjectAllocator::MAX_SIZE, 'a');
+  for (int i = 0; i < 1000; i++) {
+    td::vector<td::Promise<int>> promises;
+    promises.push_back(td::PromiseCreator::lambda([&value](int x) { value += x; }));
+    promises.push_back(td::PromiseCreator::lambda([&value, big_capture](int x) {
+      value += x * static_cast<int>(big_capture.size());
+    }));
+    promises.push_back(td::PromiseCreator::lambda([&lost_count](td::Result<int> result) {
+      ASSERT_TRUE(result.is_error());
+      lost_count++;
+    }));
+    promises[0].set_value(1);
+    promises[1].set_value(1);
+
+    // implementations released from a promise are deleted by their own type
+    auto released = promises[2].release();
+    ASSERT_TRUE(!promises[2]);
+    promises[2] = td::Promise<int>(std::move(released));
+  }
+  ASSERT_EQ(1000 * (1 + static_cast<int>(td::SmallObjectAllocator::MAX_SIZE)), value);
+  ASSERT_EQ(1000, lost_count);
+
+#if !TD_THREAD_UNSUPPORTED
+  // promises are often created and destroyed by different threads
+  td::vector<td::Promise<int>> promises;
+  for (int i = 0; i < 1000; i++) {
+    promises.push_back(td::PromiseCreator::lambda([&value, i](int x) { value += x + i; }));
+  }
+  td::thread thread([&promises] {
+    for (auto &promise : promises) {
+      promise.set_value(1);
+    }
+    promises.clear();
+  });
+  thread.join();
+#endif
+}
+
 class LaterSlave final : public td::Actor {
  public:
   explicit LaterSlave(td::ActorShared<> parent) : parent_(std::move(parent)) {
@@ -680,3 +727,376 @@ TEST(Actors, MultiPromiseSendClosureLater) {
   }
   scheduler.finish();
 }
+
+class MultiPromiseCounterClient final : public td::Actor {
+ public:
+  explicit MultiPromiseCounterClient(td::MultiPromiseCounter *counter) : counter_(counter) {
+  }
+
+  void start_up() final {
+    // the promise is created outside of the owner actor, but its result must be still handled by the owner
+    promise_ = counter_->get_promise();
+    set_timeout_in(0.05);
+  }
+
+  void timeout_expired() final {
+    promise_.set_value(td::Unit());
+    stop();
+  }
+
+ private:
+  td::MultiPromiseCounter *counter_;
+  td::Promise<td::Unit> promise_;
+};
+
+class MultiPromiseCounterTest final : public td::Actor {
+ public:
+  void start_up() final {
+    counter_.add_promise(td::PromiseCreator::lambda([this](td::Result<td::Unit> result) {
+      CHECK(td::Scheduler::instance()->is_actor_running(actor_id()));
+      CHECK(step_ == 0);
+      CHECK(result.is_error());
+      step_++;
+      run_second_round();
+    }));
+    auto lock = counter_.get_promise();
+    for (int i = 0; i < 3; i++) {
+      counter_.get_promise().set_value(td::Unit());
+    }
+    td::create_actor<MultiPromiseCounterClient>("MultiPromiseCounterClient", &counter_).release();
+    td::create_actor<td::SleepActor>(
+        "Sleep", 0.01,
+        td::PromiseCreator::lambda([promise = counter_.get_promise()](td::Unit) mutable {
+          promise.set_error(td::Status::Error("Error"));
+        }))
+        .release();
+    lock.set_value(td::Unit());
+    CHECK(step_ == 0);
+    CHECK(counter_.promise_count() == 1);
+  }
+
+  void run_second_round() {
+    counter_.set_ignore_errors(true);
+    counter_.add_promise(td::PromiseCreator::lambda([this](td::Result<td::Unit> result) {
+      CHECK(step_ == 1);
+      CHECK(result.is_ok());
+      step_++;
+
+      // the result of pending_promise_ must be ignored, because it is destroyed with the actor,
+      // so the promise will fail only because it is destroyed too
+      counter_.add_promise(td::PromiseCreator::lambda([](td::Result<td::Unit> result) { CHECK(result.is_error()); }));
+      pending_promise_ = counter_.get_promise();
+      stop();
+    }));
+    for (int i = 0; i < 10; i++) {
+      td::create_actor<td::SleepActor>("Sleep", 0.01 * i, counter_.get_promise()).release();
+    }
+    counter_.get_promise().set_error(td::Status::Error("Ignored error"));
+  }
+
+  void tear_down() final {
+    CHECK(step_ == 2);
+    td::Scheduler::instance()->finish();
+  }
+
+ private:
+  int step_ = 0;
+  td::MultiPromiseCounter counter_{"MultiPromiseCounter", this};
+  td::Promise<td::Unit> pending_promise_;
+};
+
+TEST(Actors, MultiPromiseCounter) {
+  td::ConcurrentScheduler scheduler(0, 0);
+  scheduler.create_actor_unsafe<MultiPromiseCounterTest>(0, "MultiPromiseCounterTest").release();
+  scheduler.start();
+  while (scheduler.run_main(1)) {
+  }
+  scheduler.finish();
+}
+
+class HighPriorityReceiver final : public td::Actor {
+ public:
+  void f(int x) {
+    values_.push_back(x);
+    if (values_.size() == 4) {
+      ASSERT_EQ(2, values_[0]);
+      ASSERT_EQ(4, values_[1]);
+      ASSERT_EQ(1, values_[2]);
+      ASSERT_EQ(3, values_[3]);
+      td::Scheduler::instance()->finish();
+    }
+  }
+
+ private:
+  td::vector<int> values_;
+};
+
+class HighPrioritySender final : public td::Actor {
+  void start_up() final {
+    receiver_ = td::create_actor<HighPriorityReceiver>("HighPriorityReceiver");
+    for (int i = 1; i <= 4; i++) {
+      auto event = td::Event::delayed_closure(&HighPriorityReceiver::f, i);
+      if (i % 2 == 0) {
+        event.set_high_priority();
+      }
+      td::send_event_later(receiver_, std::move(event));
+    }
+  }
+
+  td::ActorOwn<HighPriorityReceiver> receiver_;
+};
+
+TEST(Actors, high_priority_events) {
+  td::ConcurrentScheduler scheduler(0, 0);
+  scheduler.create_actor_unsafe<HighPrioritySender>(0, "HighPrioritySender").release();
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+}
+
+TEST(Actors, actor_statistics) {
+  td::ActorStatistics::enable(0.0);
+
+  class CountedWorker final : public td::Actor {
+   public:
+    void f() {
+    }
+    void close() {
+      td::Scheduler::instance()->finish();
+      stop();
+    }
+  };
+
+  td::ConcurrentScheduler scheduler(0, 0);
+  {
+    auto guard = scheduler.get_main_guard();
+    auto worker = td::create_actor<CountedWorker>("CountedWorker 7").release();
+    for (int i = 0; i < 10; i++) {
+      td::send_closure_later(worker, &CountedWorker::f);
+    }
+    td::send_closure_later(worker, &CountedWorker::close);
+  }
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+
+  bool is_found = false;
+  for (auto &info : td::ActorStatistics::get_statistics()) {
+    if (info.name == "CountedWorker") {
+      is_found = true;
+      ASSERT_TRUE(info.event_count >= 11u);
+      ASSERT_TRUE(info.max_mailbox_size >= 11u);
+      ASSERT_TRUE(info.max_time <= info.total_time);
+    }
+  }
+  ASSERT_TRUE(is_found);
+}
+
+TEST(Actors, bounded_mailbox) {
+  class LimitedWorker final : public td::Actor {
+   public:
+    LimitedWorker(td::MailboxOverflowPolicy overflow_policy, td::vector<int> *values)
+        : overflow_policy_(overflow_policy), values_(values) {
+    }
+
+    void start_up() final {
+      set_mailbox_limit(3, overflow_policy_);
+    }
+
+    void f(int value) {
+      values_->push_back(value);
+    }
+
+    void g(int value) {
+      values_->push_back(-value);
+    }
+
+    void close() {
+      stop();
+    }
+
+   private:
+    td::MailboxOverflowPolicy overflow_policy_;
+    td::vector<int> *values_;
+  };
+
+  td::vector<int> dropped_values;
+  td::vector<int> coalesced_values;
+  td::vector<int> method_coalesced_values;
+  td::ConcurrentScheduler scheduler(0, 0);
+  td::ActorId<LimitedWorker> dropping_worker;
+  td::ActorId<LimitedWorker> coalescing_worker;
+  td::ActorId<LimitedWorker> method_coalescing_worker;
+  {
+    auto guard = scheduler.get_main_guard();
+    dropping_worker =
+        td::create_actor<LimitedWorker>("DroppingWorker", td::MailboxOverflowPolicy::Drop, &dropped_values).release();
+    coalescing_worker =
+        td::create_actor<LimitedWorker>("CoalescingWorker", td::MailboxOverflowPolicy::Coalesce, &coalesced_values)
+            .release();
+    method_coalescing_worker = td::create_actor<LimitedWorker>("MethodCoalescingWorker",
+                                                               td::MailboxOverflowPolicy::Coalesce,
+                                                               &method_coalesced_values)
+                                   .release();
+  }
+  scheduler.start();
+  scheduler.run_main(0);  // the limits are set in start_up
+
+  {
+    auto guard = scheduler.get_main_guard();
+    for (int i = 1; i <= 10; i++) {
+      td::send_closure_later(dropping_worker, &LimitedWorker::f, i);
+      td::send_closure_later(coalescing_worker, &LimitedWorker::f, i);
+      if (i == 1) {
+        td::send_closure_later(coalescing_worker, &LimitedWorker::g, i);
+      }
+    }
+    // system events are never dropped
+    td::send_event_later(dropping_worker, td::Event::yield());
+    td::send_closure_later(dropping_worker, &LimitedWorker::close);
+    td::send_closure_later(coalescing_worker, &LimitedWorker::close);
+    td::send_event_later(dropping_worker, td::Event::hangup());
+
+    // f and g have the same signature, but calls of different methods must not be coalesced
+    td::send_closure_later(method_coalescing_worker, &LimitedWorker::f, 1);
+    td::send_closure_later(method_coalescing_worker, &LimitedWorker::f, 2);
+    td::send_closure_later(method_coalescing_worker, &LimitedWorker::g, 3);
+    td::send_closure_later(method_coalescing_worker, &LimitedWorker::f, 4);
+    td::send_closure_later(method_coalescing_worker, &LimitedWorker::g, 5);
+    // lambdas are never coalesced, because they can have different captures
+    for (int value = 6; value <= 7; value++) {
+      td::Scheduler::instance()->send_lambda_later(
+          method_coalescing_worker, [values = &method_coalesced_values, value] { values->push_back(value); });
+    }
+    td::send_closure_later(method_coalescing_worker, &LimitedWorker::close);
+  }
+  while (dropping_worker.is_alive() || coalescing_worker.is_alive() || method_coalescing_worker.is_alive()) {
+    scheduler.run_main(0.01);
+  }
+  auto dropped_event_count = scheduler.get_dropped_event_count();
+  auto coalesced_event_count = scheduler.get_coalesced_event_count();
+  scheduler.finish();
+
+  ASSERT_EQ(dropped_values, td::vector<int>({1, 2, 3}));
+  ASSERT_EQ(coalesced_values, td::vector<int>({1, -1, 10}));
+  ASSERT_EQ(method_coalesced_values, td::vector<int>({1, 4, -5, 6, 7}));
+  ASSERT_EQ(8u, dropped_event_count);
+  ASSERT_EQ(10u, coalesced_event_count);
+}
+
+#if !TD_THREAD_UNSUPPORTED
+TEST(Actors, small_object_allocator_cross_thread) {
+  td::vector<td::Event> events;
+  for (int round = 0; round < 10; round++) {
+    for (int i = 0; i < 1000; i++) {
+      td::string payload(static_cast<size_t>(i % 100), 'a');
+      events.push_back(td::Event::from_lambda([payload] { CHECK(payload.size() < 100); }));
+    }
+    td::thread other_thread([&events] {
+      // events allocated by another thread are freed to the local free lists and returned to the shared pool
+      events.clear();
+    });
+    other_thread.join();
+    ASSERT_TRUE(events.empty());
+  }
+}
+#endif
+
+#if TD_HAVE_COROUTINES
+class SquareActor final : public td::Actor {
+ public:
+  void square(int x, td::Promise<int> promise) {
+    CHECK(td::Scheduler::instance()->sched_id() == 1);
+    if (x < 0) {
+      return;  // the promise is lost
+    }
+    promise.set_value(x * x);
+  }
+};
+
+class CoroutineActor final : public td::Actor {
+  td::ActorOwn<SquareActor> square_actor_;
+
+  td::Task<int> get_square(int x) {
+    auto result = co_await td::ask(square_actor_.get(), &SquareActor::square, x);
+    CHECK(td::Scheduler::instance()->sched_id() == 0);
+    co_return std::move(result);
+  }
+
+  td::Task<int> sum_squares(int n) {
+    int sum = 0;
+    for (int i = 1; i <= n; i++) {
+      auto r_square = co_await get_square(i);
+      if (r_square.is_error()) {
+        co_return r_square.move_as_error();
+      }
+      sum += r_square.ok();
+    }
+    auto r_error = co_await get_square(-1);
+    CHECK(r_error.is_error());
+    co_return sum;
+  }
+
+  void start_up() final {
+    square_actor_ = td::create_actor_on_scheduler<SquareActor>("SquareActor", 1);
+    sum_squares(10).start(td::PromiseCreator::lambda([actor_id = actor_id(this)](td::Result<int> result) {
+      ASSERT_EQ(385, result.ok());
+      td::send_closure(actor_id, &CoroutineActor::close);
+    }));
+  }
+
+  void close() {
+    td::Scheduler::instance()->finish();
+    stop();
+  }
+};
+
+static td::Promise<int> saved_promise;
+static bool is_coroutine_destroyed = false;
+
+class AbandonedCoroutineActor final : public td::Actor {
+  td::Task<int> wait() {
+    auto result = co_await td::await_promise<int>([](td::Promise<int> &&promise) { saved_promise = std::move(promise); });
+    UNREACHABLE();
+    co_return std::move(result);
+  }
+
+  void start_up() final {
+    wait().start(td::PromiseCreator::lambda([](td::Result<int> result) {
+      CHECK(result.is_error());
+      is_coroutine_destroyed = true;
+    }));
+    stop();
+  }
+
+  void tear_down() final {
+    td::create_actor<td::SleepActor>("SleepActor", 0.01, td::PromiseCreator::lambda([](td::Unit) {
+      // the owner actor is already destroyed, so the coroutine can't be resumed
+      saved_promise.set_value(1);
+      CHECK(is_coroutine_destroyed);
+      td::Scheduler::instance()->finish();
+    })).release();
+  }
+};
+
+TEST(Actors, coroutines) {
+  td::ConcurrentScheduler scheduler(1, 0);
+  scheduler.create_actor_unsafe<CoroutineActor>(0, "CoroutineActor").release();
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+}
+
+TEST(Actors, abandoned_coroutine) {
+  td::ConcurrentScheduler scheduler(0, 0);
+  scheduler.create_actor_unsafe<AbandonedCoroutineActor>(0, "AbandonedCoroutineActor").release();
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+  ASSERT_TRUE(is_coroutine_destroyed);
+}
+#endif
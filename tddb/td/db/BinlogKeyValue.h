@@ -26,6 +26,7 @@
 #include "td/utils/tl_parsers.h"
 #include "td/utils/tl_storers.h"
 
+#include <array>
 #include <functional>
 #include <memory>
 #include <unordered_map>
@@ -89,7 +90,7 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
             LOG(ERROR) << "Have event with empty key";
             return;
           }
-          map_.emplace(event.key.str(), std::make_pair(event.value.str(), binlog_event.id_));
+          get_shard(event.key).map_.emplace(event.key.str(), std::make_pair(event.value.str(), binlog_event.id_));
         },
         std::move(db_key), DbKey::empty(), scheduler_id));
     return Status::OK();
@@ -104,7 +105,9 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
 
   template <class OtherBinlogT>
   void external_init_handle(BinlogKeyValue<OtherBinlogT> &&other) {
-    map_ = std::move(other.map_);
+    for (size_t i = 0; i < SHARD_COUNT; i++) {
+      shards_[i].map_ = std::move(other.shards_[i].map_);
+    }
   }
 
   void external_init_handle(const BinlogEvent &binlog_event) {
@@ -114,7 +117,7 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
       LOG(ERROR) << "Have external event with empty key";
       return;
     }
-    map_.emplace(event.key.str(), std::make_pair(event.value.str(), binlog_event.id_));
+    get_shard(event.key).map_.emplace(event.key.str(), std::make_pair(event.value.str(), binlog_event.id_));
   }
 
   void external_init_finish(std::shared_ptr<BinlogT> binlog) {
@@ -129,10 +132,11 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
   }
 
   SeqNo set(string key, string value) final {
-    auto lock = rw_mutex_.lock_write().move_as_ok();
-    uint64 old_event_id = 0;
     CHECK(!key.empty());
-    auto it_ok = map_.emplace(key, std::make_pair(value, 0));
+    auto &shard = get_shard(key);
+    auto lock = shard.rw_mutex_.lock_write().move_as_ok();
+    uint64 old_event_id = 0;
+    auto it_ok = shard.map_.emplace(key, std::make_pair(value, 0));
     if (!it_ok.second) {
       if (it_ok.first->second.first == value) {
         return 0;
@@ -162,14 +166,15 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
   }
 
   SeqNo erase(const string &key) final {
-    auto lock = rw_mutex_.lock_write().move_as_ok();
-    auto it = map_.find(key);
-    if (it == map_.end()) {
+    auto &shard = get_shard(key);
+    auto lock = shard.rw_mutex_.lock_write().move_as_ok();
+    auto it = shard.map_.find(key);
+    if (it == shard.map_.end()) {
       return 0;
     }
     VLOG(binlog) << "Remove value of key " << key << ", which is " << hex_encode(it->second.first);
     uint64 event_id = it->second.second;
-    map_.erase(it);
+    shard.map_.erase(it);
     auto seq_no = binlog_->next_event_id();
     lock.reset();
     add_event(seq_no, BinlogEvent::create_raw(event_id, BinlogEvent::ServiceTypes::Empty, BinlogEvent::Flags::Rewrite,
@@ -178,13 +183,16 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
   }
 
   SeqNo erase_batch(vector<string> keys) final {
-    auto lock = rw_mutex_.lock_write().move_as_ok();
+    // the locks must be held until the event identifier is assigned, so that the erasure can't be reordered
+    // with changes of the same keys from other threads
+    auto locks = lock_shards(keys);
     vector<uint64> log_event_ids;
     for (auto &key : keys) {
-      auto it = map_.find(key);
-      if (it != map_.end()) {
+      auto &shard = get_shard(key);
+      auto it = shard.map_.find(key);
+      if (it != shard.map_.end()) {
         log_event_ids.push_back(it->second.second);
-        map_.erase(it);
+        shard.map_.erase(it);
       }
     }
     if (log_event_ids.empty()) {
@@ -199,14 +207,16 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
   }
 
   bool isset(const string &key) final {
-    auto lock = rw_mutex_.lock_read().move_as_ok();
-    return map_.count(key) > 0;
+    const auto &shard = get_shard(key);
+    auto lock = shard.rw_mutex_.lock_read().move_as_ok();
+    return shard.map_.count(key) > 0;
   }
 
   string get(const string &key) final {
-    auto lock = rw_mutex_.lock_read().move_as_ok();
-    auto it = map_.find(key);
-    if (it == map_.end()) {
+    const auto &shard = get_shard(key);
+    auto lock = shard.rw_mutex_.lock_read().move_as_ok();
+    auto it = shard.map_.find(key);
+    if (it == shard.map_.end()) {
       return string();
     }
     VLOG(binlog) << "Get value of key " << key << ", which is " << hex_encode(it->second.first);
@@ -222,45 +232,57 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
   }
 
   void for_each(std::function<void(Slice, Slice)> func) final {
-    auto lock = rw_mutex_.lock_write().move_as_ok();
-    for (const auto &kv : map_) {
-      func(kv.first, kv.second.first);
+    auto locks = lock_all_shards();
+    for (auto &shard : shards_) {
+      for (const auto &kv : shard.map_) {
+        func(kv.first, kv.second.first);
+      }
     }
   }
 
   std::unordered_map<string, string, Hash<string>> prefix_get(Slice prefix) final {
-    auto lock = rw_mutex_.lock_write().move_as_ok();
     std::unordered_map<string, string, Hash<string>> res;
-    for (const auto &kv : map_) {
-      if (begins_with(kv.first, prefix)) {
-        res.emplace(kv.first.substr(prefix.size()), kv.second.first);
+    auto locks = lock_all_shards();
+    for (auto &shard : shards_) {
+      for (const auto &kv : shard.map_) {
+        if (begins_with(kv.first, prefix)) {
+          res.emplace(kv.first.substr(prefix.size()), kv.second.first);
+        }
       }
     }
     return res;
   }
 
   FlatHashMap<string, string> get_all() final {
-    auto lock = rw_mutex_.lock_write().move_as_ok();
     FlatHashMap<string, string> res;
-    res.reserve(map_.size());
-    for (const auto &kv : map_) {
-      res.emplace(kv.first, kv.second.first);
+    auto locks = lock_all_shards();
+    for (auto &shard : shards_) {
+      for (const auto &kv : shard.map_) {
+        res.emplace(kv.first, kv.second.first);
+      }
     }
     return res;
   }
 
   void erase_by_prefix(Slice prefix) final {
-    auto lock = rw_mutex_.lock_write().move_as_ok();
     vector<uint64> event_ids;
-    table_remove_if(map_, [&](const auto &it) {
-      if (begins_with(it.first, prefix)) {
-        event_ids.push_back(it.second.second);
-        return true;
-      }
-      return false;
-    });
+    auto locks = lock_all_shards();
+    for (auto &shard : shards_) {
+      table_remove_if(shard.map_, [&](const auto &it) {
+        if (begins_with(it.first, prefix)) {
+          event_ids.push_back(it.second.second);
+          return true;
+        }
+        return false;
+      });
+    }
+    if (event_ids.empty()) {
+      return;
+    }
     auto seq_no = binlog_->next_event_id(narrow_cast<int32>(event_ids.size()));
-    lock.reset();
+    for (auto &lock : locks) {
+      lock.reset();
+    }
     for (auto event_id : event_ids) {
       add_event(seq_no, BinlogEvent::create_raw(event_id, BinlogEvent::ServiceTypes::Empty, BinlogEvent::Flags::Rewrite,
                                                 EmptyStorer()));
@@ -276,9 +298,56 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
   }
 
  private:
-  FlatHashMap<string, std::pair<string, uint64>> map_;
+  // keys are split between shards with independent locks, so reads of different keys from different threads
+  // don't contend for the same lock
+  static constexpr size_t SHARD_COUNT = 16;
+
+  using ShardLocks = std::array<RwMutex::WriteLock, SHARD_COUNT>;
+
+  struct Shard {
+    FlatHashMap<string, std::pair<string, uint64>> map_;
+    mutable RwMutex rw_mutex_;
+  };
+
+  Shard &get_shard(Slice key) {
+    return shards_[get_shard_index(key)];
+  }
+
+  const Shard &get_shard(Slice key) const {
+    return shards_[get_shard_index(key)];
+  }
+
+  // whole-map operations must see a consistent snapshot, so all shards are locked at once;
+  // operations locking more than one shard lock them in order of their indices, so they can't deadlock
+  ShardLocks lock_all_shards() {
+    ShardLocks locks;
+    for (size_t i = 0; i < SHARD_COUNT; i++) {
+      locks[i] = shards_[i].rw_mutex_.lock_write().move_as_ok();
+    }
+    return locks;
+  }
+
+  // locks only shards of the specified keys
+  ShardLocks lock_shards(const vector<string> &keys) {
+    std::array<bool, SHARD_COUNT> is_used{};
+    for (auto &key : keys) {
+      is_used[get_shard_index(key)] = true;
+    }
+    ShardLocks locks;
+    for (size_t i = 0; i < SHARD_COUNT; i++) {
+      if (is_used[i]) {
+        locks[i] = shards_[i].rw_mutex_.lock_write().move_as_ok();
+      }
+    }
+    return locks;
+  }
+
+  static size_t get_shard_index(Slice key) {
+    return randomize_hash(SliceHash()(key)) % SHARD_COUNT;
+  }
+
+  std::array<Shard, SHARD_COUNT> shards_;
   std::shared_ptr<BinlogT> binlog_;
-  RwMutex rw_mutex_;
   int32 magic_ = MAGIC;
 };
 
@@ -9,24 +9,48 @@
 #include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
 
 namespace td {
 
-SqliteConnectionSafe::SqliteConnectionSafe(string path, DbKey key, optional<int32> cipher_version)
+SqliteConnectionSafe::SqliteConnectionSafe(string path, DbKey key, optional<int32> cipher_version,
+                                           bool use_secure_delete, bool use_auto_checkpoint, int64 mmap_size,
+                                           int64 cache_size, bool use_cell_size_check)
     : path_(std::move(path))
     , lsls_connection_([path = path_, close_state_ptr = &close_state_, key = std::move(key),
-                        cipher_version = std::move(cipher_version)] {
+                        cipher_version = std::move(cipher_version), use_secure_delete, use_auto_checkpoint, mmap_size,
+                        cache_size, use_cell_size_check] {
       auto r_db = SqliteDb::open_with_key(path, false, key, cipher_version.copy());
       if (r_db.is_error()) {
         LOG(FATAL) << "Can't open database in state " << close_state_ptr->load() << ": " << r_db.error().message();
       }
       auto db = r_db.move_as_ok();
-      db.exec("PRAGMA journal_mode=WAL").ensure();
-      db.exec("PRAGMA secure_delete=1").ensure();
+      init_connection(db, use_secure_delete, use_auto_checkpoint, mmap_size, cache_size, use_cell_size_check).ensure();
       return db;
     }) {
 }
 
+Status SqliteConnectionSafe::init_connection(SqliteDb &db, bool use_secure_delete, bool use_auto_checkpoint,
+                                             int64 mmap_size, int64 cache_size, bool use_cell_size_check) {
+  TRY_STATUS(db.exec("PRAGMA journal_mode=WAL"));
+  TRY_STATUS(db.exec(use_secure_delete ? CSlice("PRAGMA secure_delete=1") : CSlice("PRAGMA secure_delete=0")));
+  if (!use_auto_checkpoint) {
+    TRY_STATUS(db.exec("PRAGMA wal_autocheckpoint=0"));
+  }
+  if (mmap_size > 0) {
+    // pages of unencrypted databases are read directly from the mapping instead of being copied to the page cache
+    TRY_STATUS(db.exec(PSLICE() << "PRAGMA mmap_size=" << mmap_size));
+  }
+  if (cache_size > 0) {
+    TRY_STATUS(db.exec(PSLICE() << "PRAGMA cache_size=-" << cache_size));
+  }
+  if (use_cell_size_check) {
+    TRY_STATUS(db.exec("PRAGMA cell_size_check=ON"));
+  }
+  return Status::OK();
+}
+
 void SqliteConnectionSafe::set(SqliteDb &&db) {
   lsls_connection_.set(std::move(db));
 }
@@ -13,6 +13,7 @@
 
 #include "td/utils/common.h"
 #include "td/utils/optional.h"
+#include "td/utils/Status.h"
 
 #include <atomic>
 
@@ -21,7 +22,15 @@ namespace td {
 class SqliteConnectionSafe {
  public:
   SqliteConnectionSafe() = default;
-  SqliteConnectionSafe(string path, DbKey key, optional<int32> cipher_version = {});
+  // mmap_size is in bytes and cache_size is in KiB; zero values keep SQLite defaults
+  // use_cell_size_check enables b-tree page structure checks, which are useful for databases without SQLCipher HMACs
+  SqliteConnectionSafe(string path, DbKey key, optional<int32> cipher_version = {}, bool use_secure_delete = true,
+                       bool use_auto_checkpoint = true, int64 mmap_size = 0, int64 cache_size = 0,
+                       bool use_cell_size_check = false);
+
+  // applies the connection settings, which are passed to the constructor, to the database
+  static Status init_connection(SqliteDb &db, bool use_secure_delete, bool use_auto_checkpoint, int64 mmap_size = 0,
+                                int64 cache_size = 0, bool use_cell_size_check = false) TD_WARN_UNUSED_RESULT;
 
   SqliteDb &get();
   void set(SqliteDb &&db);
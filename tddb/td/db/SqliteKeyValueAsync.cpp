@@ -39,6 +39,9 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
   void close(Promise<Unit> promise) final {
     send_closure_later(impl_, &Impl::close, std::move(promise));
   }
+  void set_write_batch_options(double max_delay, size_t max_count) final {
+    send_closure_later(impl_, &Impl::set_write_batch_options, max_delay, max_count);
+  }
 
  private:
   class Impl final : public Actor {
@@ -57,7 +60,6 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
       if (promise) {
         buffer_promises_.push_back(std::move(promise));
       }
-      cnt_++;
       do_flush(false /*force*/);
     }
 
@@ -78,7 +80,6 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
       if (promise) {
         buffer_promises_.push_back(std::move(promise));
       }
-      cnt_++;
       do_flush(false /*force*/);
     }
 
@@ -104,15 +105,27 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
       promise.set_value(Unit());
     }
 
+    void set_write_batch_options(double max_delay, size_t max_count) {
+      CHECK(max_delay >= 0.0);
+      CHECK(max_count > 0);
+      max_pending_queries_delay_ = max_delay;
+      max_pending_queries_count_ = max_count;
+      if (wakeup_at_ != 0) {
+        wakeup_at_ = min(wakeup_at_, Time::now() + max_delay);
+      }
+      do_flush(false /*force*/);
+    }
+
    private:
     std::shared_ptr<SqliteKeyValueSafe> kv_safe_;
     SqliteKeyValue *kv_ = nullptr;
 
-    static constexpr double MAX_PENDING_QUERIES_DELAY = 0.01;
-    static constexpr size_t MAX_PENDING_QUERIES_COUNT = 100;
+    double max_pending_queries_delay_ = 0.01;
+    size_t max_pending_queries_count_ = 100;
+
+    // repeated changes of the same key are merged and written once
     FlatHashMap<string, optional<string>> buffer_;
     vector<Promise<Unit>> buffer_promises_;
-    size_t cnt_ = 0;
 
     double wakeup_at_ = 0;
     void do_flush(bool force) {
@@ -123,16 +136,15 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
       if (!force) {
         auto now = Time::now_cached();
         if (wakeup_at_ == 0) {
-          wakeup_at_ = now + MAX_PENDING_QUERIES_DELAY;
+          wakeup_at_ = now + max_pending_queries_delay_;
         }
-        if (now < wakeup_at_ && cnt_ < MAX_PENDING_QUERIES_COUNT) {
+        if (now < wakeup_at_ && buffer_.size() < max_pending_queries_count_) {
           set_timeout_at(wakeup_at_);
           return;
         }
       }
 
       wakeup_at_ = 0;
-      cnt_ = 0;
 
       kv_->begin_write_transaction().ensure();
       for (auto &it : buffer_) {
@@ -31,6 +31,9 @@ class SqliteKeyValueAsyncInterface {
   virtual void get(string key, Promise<string> promise) = 0;
 
   virtual void close(Promise<Unit> promise) = 0;
+
+  // changed keys are written in one transaction after max_delay seconds or after max_count keys were changed
+  virtual void set_write_batch_options(double max_delay, size_t max_count) = 0;
 };
 
 unique_ptr<SqliteKeyValueAsyncInterface> create_sqlite_key_value_async(std::shared_ptr<SqliteKeyValueSafe> kv,
@@ -0,0 +1,177 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/db/SqliteWalCheckpointer.h"
+
+#if !TD_THREAD_UNSUPPORTED
+
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+#include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+namespace td {
+
+struct SqliteWalStatistics {
+  int64 checkpoint_count = 0;
+  int64 busy_checkpoint_count = 0;
+  int32 last_log_frame_count = 0;
+  int32 last_checkpointed_frame_count = 0;
+  int64 wal_size = 0;
+};
+
+static StringBuilder &operator<<(StringBuilder &string_builder, const SqliteWalStatistics &statistics) {
+  return string_builder << "not checkpointed WAL size = " << format::as_size(statistics.wal_size)
+                        << ", checkpoints = " << statistics.checkpoint_count
+                        << ", busy checkpoints = " << statistics.busy_checkpoint_count
+                        << ", last checkpoint = " << statistics.last_checkpointed_frame_count << '/'
+                        << statistics.last_log_frame_count << " frames";
+}
+
+class SqliteWalCheckpointer final : public SqliteWalCheckpointerInterface {
+ public:
+  SqliteWalCheckpointer(SqliteDb db, string database_path, double period, int64 max_wal_size)
+      : db_(std::move(db))
+      , shm_path_(database_path + "-shm")
+      , period_(period)
+      , max_wal_size_(max_wal_size)
+      , thread_([this] { run(); }) {
+  }
+  SqliteWalCheckpointer(const SqliteWalCheckpointer &) = delete;
+  SqliteWalCheckpointer &operator=(const SqliteWalCheckpointer &) = delete;
+  SqliteWalCheckpointer(SqliteWalCheckpointer &&) = delete;
+  SqliteWalCheckpointer &operator=(SqliteWalCheckpointer &&) = delete;
+  ~SqliteWalCheckpointer() final {
+    stop();
+  }
+
+  int64 get_checkpoint_count() const final {
+    return checkpoint_count_.load(std::memory_order_relaxed);
+  }
+
+  void close(Promise<Unit> promise) final {
+    stop();
+    promise.set_value(Unit());
+  }
+
+ private:
+  static constexpr double CHECK_PERIOD = 1.0;
+
+  SqliteDb db_;
+  string shm_path_;
+  double period_;
+  int64 max_wal_size_;
+
+  SqliteWalStatistics statistics_;
+  std::atomic<int64> checkpoint_count_{0};
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool is_stopped_ = false;
+
+  thread thread_;
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (is_stopped_) {
+        return;
+      }
+      is_stopped_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+    db_.close();
+  }
+
+  void run() {
+    auto next_checkpoint_at = Time::now() + period_;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      condition_.wait_for(lock, std::chrono::milliseconds(static_cast<int64>(CHECK_PERIOD * 1000)));
+      if (is_stopped_) {
+        break;
+      }
+      lock.unlock();
+      statistics_.wal_size = get_not_checkpointed_wal_size();
+      if (Time::now() >= next_checkpoint_at || statistics_.wal_size >= max_wal_size_) {
+        checkpoint();
+        next_checkpoint_at = Time::now() + period_;
+      }
+      lock.lock();
+    }
+  }
+
+  // the WAL file isn't truncated after checkpoints and is overwritten from the beginning instead, so its size can't be
+  // used; the number of frames is taken from the wal-index header instead, see https://www.sqlite.org/walformat.html
+  int64 get_not_checkpointed_wal_size() const {
+    auto r_fd = FileFd::open(shm_path_, FileFd::Read);
+    if (r_fd.is_error()) {
+      return 0;
+    }
+    auto fd = r_fd.move_as_ok();
+    char header[100];
+    auto r_size = fd.pread(MutableSlice(header, sizeof(header)), 0);
+    fd.close();
+    if (r_size.is_error() || r_size.ok() != sizeof(header)) {
+      return 0;
+    }
+
+    // the header is stored in the native byte order
+    uint16 page_size;
+    uint32 max_frame;
+    uint32 backfilled_frame_count;
+    std::memcpy(&page_size, header + 14, sizeof(page_size));
+    std::memcpy(&max_frame, header + 16, sizeof(max_frame));
+    std::memcpy(&backfilled_frame_count, header + 96, sizeof(backfilled_frame_count));
+    if (max_frame <= backfilled_frame_count) {
+      return 0;
+    }
+    int64 frame_size = (page_size == 1 ? 65536 : static_cast<int64>(page_size)) + 24;
+    return static_cast<int64>(max_frame - backfilled_frame_count) * frame_size;
+  }
+
+  void checkpoint() {
+    auto r_stmt = db_.get_statement("PRAGMA wal_checkpoint(PASSIVE)");
+    if (r_stmt.is_error()) {
+      LOG(ERROR) << "Failed to prepare WAL checkpoint: " << r_stmt.error();
+      return;
+    }
+    auto stmt = r_stmt.move_as_ok();
+    auto status = stmt.step();
+    if (status.is_error() || !stmt.has_row()) {
+      LOG(ERROR) << "Failed to run WAL checkpoint: " << status;
+      return;
+    }
+    statistics_.checkpoint_count++;
+    checkpoint_count_.store(statistics_.checkpoint_count, std::memory_order_relaxed);
+    if (stmt.view_int32(0) != 0) {
+      statistics_.busy_checkpoint_count++;
+    }
+    statistics_.last_log_frame_count = stmt.view_int32(1);
+    statistics_.last_checkpointed_frame_count = stmt.view_int32(2);
+    LOG(INFO) << "Finish WAL checkpoint: " << statistics_;
+  }
+};
+
+unique_ptr<SqliteWalCheckpointerInterface> create_sqlite_wal_checkpointer(SqliteDb db, string database_path,
+                                                                          double period, int64 max_wal_size) {
+  return td::make_unique<SqliteWalCheckpointer>(std::move(db), std::move(database_path), period, max_wal_size);
+}
+
+}  // namespace td
+
+#endif
@@ -0,0 +1,37 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/db/SqliteDb.h"
+
+#include "td/utils/common.h"
+#include "td/utils/port/config.h"
+#include "td/utils/Promise.h"
+
+namespace td {
+
+// Runs passive WAL checkpoints in a dedicated thread instead of automatic checkpoints in committing connections.
+// A checkpoint is run each period seconds and as soon as the WAL contains max_wal_size bytes of frames, which aren't
+// checkpointed yet. Automatic checkpoints must be disabled in all connections to the database.
+class SqliteWalCheckpointerInterface {
+ public:
+  virtual ~SqliteWalCheckpointerInterface() = default;
+
+  // can be called from any thread
+  virtual int64 get_checkpoint_count() const = 0;
+
+  // waits for the running checkpoint to finish
+  virtual void close(Promise<Unit> promise) = 0;
+};
+
+#if !TD_THREAD_UNSUPPORTED
+// db must be a connection to the database at database_path, which isn't used by anyone else
+unique_ptr<SqliteWalCheckpointerInterface> create_sqlite_wal_checkpointer(SqliteDb db, string database_path,
+                                                                          double period, int64 max_wal_size);
+#endif
+
+}  // namespace td
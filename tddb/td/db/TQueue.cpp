@@ -12,15 +12,19 @@
 #include "td/db/binlog/BinlogInterface.h"
 
 #include "td/utils/FlatHashMap.h"
+#include "td/utils/FlatHashSet.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/Random.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/StorerBase.h"
 #include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
 #include "td/utils/tl_parsers.h"
 #include "td/utils/tl_storers.h"
 
+#include <algorithm>
+#include <deque>
 #include <set>
 
 namespace td {
@@ -102,7 +106,7 @@ class TQueueImpl final : public TQueue {
       return false;
     }
     auto &q = queues_[queue_id];
-    if (q.events.size() >= MAX_QUEUE_EVENTS || q.total_event_length > MAX_TOTAL_EVENT_LENGTH - raw_event.data.size() ||
+    if (q.event_count >= MAX_QUEUE_EVENTS || q.total_event_length > MAX_TOTAL_EVENT_LENGTH - raw_event.data.size() ||
         raw_event.expires_at <= 0) {
       return false;
     }
@@ -112,16 +116,16 @@ class TQueueImpl final : public TQueue {
     }
 
     if (!q.events.empty()) {
-      auto it = q.events.end();
-      --it;
-      if (it->second.data.empty()) {
-        if (callback_ != nullptr && it->second.log_event_id != 0) {
-          callback_->pop(it->second.log_event_id);
+      auto &last_event = q.events.back();
+      if (last_event.data.empty()) {
+        if (callback_ != nullptr && last_event.log_event_id != 0) {
+          callback_->pop(last_event.log_event_id);
         }
-        q.events.erase(it);
+        remove_event(q, last_event);
+        shrink(q);
       }
     }
-    if (q.events.empty() && !raw_event.data.empty()) {
+    if (q.event_count == 0 && !raw_event.data.empty()) {
       schedule_queue_gc(queue_id, q, raw_event.expires_at);
     }
 
@@ -130,53 +134,26 @@ class TQueueImpl final : public TQueue {
     }
     q.tail_id = event_id.next().move_as_ok();
     q.total_event_length += raw_event.data.size();
-    q.events.emplace(event_id, std::move(raw_event));
+    if (q.events.size() >= 2 * q.event_count + MIN_COMPACTED_HOLE_COUNT) {
+      compact(q);
+    }
+    q.event_count++;
+    q.events.push_back(std::move(raw_event));
     return true;
   }
 
   Result<EventId> push(QueueId queue_id, string data, int32 expires_at, int64 extra, EventId hint_new_id) final {
-    if (data.empty()) {
-      return Status::Error("Data is empty");
-    }
-    if (data.size() > MAX_EVENT_LENGTH) {
-      return Status::Error("Data is too big");
-    }
+    TRY_STATUS(check_event_data(data));
     if (queue_id == 0) {
       return Status::Error("Queue identifier is invalid");
     }
 
     auto &q = queues_[queue_id];
-    if (q.events.size() >= MAX_QUEUE_EVENTS) {
-      return Status::Error("Queue is full");
-    }
-    if (q.total_event_length > MAX_TOTAL_EVENT_LENGTH - data.size()) {
-      return Status::Error("Queue size is too big");
-    }
+    TRY_STATUS(check_queue_capacity(q, 1, data.size()));
     if (expires_at <= 0) {
       return Status::Error("Failed to add already expired event");
     }
-    EventId event_id;
-    while (true) {
-      if (q.tail_id.empty()) {
-        if (hint_new_id.empty()) {
-          q.tail_id = EventId::from_int32(
-                          Random::fast(2 * max(static_cast<int>(MAX_QUEUE_EVENTS), 1000000) + 1, EventId::MAX_ID / 2))
-                          .move_as_ok();
-        } else {
-          q.tail_id = hint_new_id;
-        }
-      }
-      event_id = q.tail_id;
-      CHECK(event_id.is_valid());
-      if (event_id.next().is_ok()) {
-        break;
-      }
-      for (auto it = q.events.begin(); it != q.events.end();) {
-        pop(q, queue_id, it, {});
-      }
-      q.tail_id = EventId();
-      CHECK(hint_new_id.next().is_ok());
-    }
+    auto event_id = allocate_event_ids(queue_id, q, 1, hint_new_id);
 
     RawEvent raw_event;
     raw_event.event_id = event_id;
@@ -188,6 +165,86 @@ class TQueueImpl final : public TQueue {
     return event_id;
   }
 
+  Result<EventId> push_batch(QueueId queue_id, vector<RawEvent> events, EventId hint_new_id) final {
+    if (events.empty()) {
+      return Status::Error("Events are empty");
+    }
+    size_t total_event_length = 0;
+    for (auto &event : events) {
+      TRY_STATUS(check_event_data(event.data));
+      if (event.expires_at <= 0) {
+        return Status::Error("Failed to add already expired event");
+      }
+      total_event_length += event.data.size();
+    }
+    if (queue_id == 0) {
+      return Status::Error("Queue identifier is invalid");
+    }
+
+    auto &q = queues_[queue_id];
+    TRY_STATUS(check_queue_capacity(q, events.size(), total_event_length));
+    auto first_event_id = allocate_event_ids(queue_id, q, events.size(), hint_new_id);
+
+    vector<std::pair<QueueId, RawEvent>> new_events;
+    new_events.reserve(events.size());
+    for (size_t i = 0; i < events.size(); i++) {
+      auto &event = events[i];
+      event.log_event_id = 0;
+      event.event_id = first_event_id.advance(i).move_as_ok();
+      new_events.emplace_back(queue_id, std::move(event));
+    }
+    add_new_events(std::move(new_events));
+    return first_event_id;
+  }
+
+  vector<Result<EventId>> push_many(const vector<QueueId> &queue_ids, const string &data, int32 expires_at,
+                                    int64 extra, EventId hint_new_id) final {
+    vector<Result<EventId>> results;
+    results.reserve(queue_ids.size());
+    auto status = check_event_data(data);
+    if (status.is_ok() && expires_at <= 0) {
+      status = Status::Error("Failed to add already expired event");
+    }
+    if (status.is_error()) {
+      for (size_t i = 0; i < queue_ids.size(); i++) {
+        results.emplace_back(status.clone());
+      }
+      return results;
+    }
+
+    vector<std::pair<QueueId, RawEvent>> new_events;
+    new_events.reserve(queue_ids.size());
+    FlatHashSet<QueueId> added_queue_ids;
+    for (auto queue_id : queue_ids) {
+      if (queue_id == 0) {
+        results.emplace_back(Status::Error("Queue identifier is invalid"));
+        continue;
+      }
+      if (!added_queue_ids.insert(queue_id).second) {
+        results.emplace_back(Status::Error("Queue identifier is duplicated"));
+        continue;
+      }
+
+      auto &q = queues_[queue_id];
+      auto capacity_status = check_queue_capacity(q, 1, data.size());
+      if (capacity_status.is_error()) {
+        results.emplace_back(std::move(capacity_status));
+        continue;
+      }
+      auto event_id = allocate_event_ids(queue_id, q, 1, hint_new_id);
+
+      RawEvent raw_event;
+      raw_event.event_id = event_id;
+      raw_event.data = data;
+      raw_event.expires_at = expires_at;
+      raw_event.extra = extra;
+      new_events.emplace_back(queue_id, std::move(raw_event));
+      results.emplace_back(event_id);
+    }
+    add_new_events(std::move(new_events));
+    return results;
+  }
+
   EventId get_head(QueueId queue_id) const final {
     auto it = queues_.find(queue_id);
     if (it == queues_.end()) {
@@ -211,14 +268,15 @@ class TQueueImpl final : public TQueue {
       return;
     }
     auto &q = q_it->second;
-    auto it = q.events.find(event_id);
-    if (it == q.events.end()) {
+    auto pos = lower_bound(q, event_id);
+    if (pos == q.events.size() || q.events[pos].event_id != event_id || is_removed(q.events[pos])) {
       return;
     }
-    pop(q, queue_id, it, q.tail_id);
+    pop(q, queue_id, q.events[pos], q.tail_id);
+    shrink(q);
   }
 
-  std::map<EventId, RawEvent> clear(QueueId queue_id, size_t keep_count) final {
+  vector<RawEvent> clear(QueueId queue_id, size_t keep_count) final {
     auto queue_it = queues_.find(queue_id);
     if (queue_it == queues_.end()) {
       return {};
@@ -232,15 +290,17 @@ class TQueueImpl final : public TQueue {
     auto start_time = Time::now();
     auto total_event_length = q.total_event_length;
 
-    auto end_it = q.events.end();
+    auto end_pos = q.events.size();
     for (size_t i = 0; i < keep_count; i++) {
-      --end_it;
+      do {
+        --end_pos;
+      } while (is_removed(q.events[end_pos]));
     }
     if (keep_count == 0) {
-      --end_it;
-      auto &event = end_it->second;
+      --end_pos;
+      auto &event = q.events[end_pos];
       if (callback_ == nullptr || event.log_event_id == 0) {
-        ++end_it;
+        ++end_pos;
       } else if (!event.data.empty()) {
         clear_event_data(q, event);
         callback_->push(queue_id, event);
@@ -251,9 +311,9 @@ class TQueueImpl final : public TQueue {
     if (callback_ != nullptr) {
       vector<uint64> deleted_log_event_ids;
       deleted_log_event_ids.reserve(size - keep_count);
-      for (auto it = q.events.begin(); it != end_it; ++it) {
-        auto &event = it->second;
-        if (event.log_event_id != 0) {
+      for (size_t pos = 0; pos < end_pos; pos++) {
+        auto &event = q.events[pos];
+        if (!is_removed(event) && event.log_event_id != 0) {
           deleted_log_event_ids.push_back(event.log_event_id);
         }
       }
@@ -262,24 +322,17 @@ class TQueueImpl final : public TQueue {
     }
     auto callback_clear_time = Time::now() - start_time;
 
-    std::map<EventId, RawEvent> deleted_events;
-    if (keep_count > size / 2) {
-      for (auto it = q.events.begin(); it != end_it;) {
-        q.total_event_length -= it->second.data.size();
-        bool is_inserted = deleted_events.emplace(it->first, std::move(it->second)).second;
-        CHECK(is_inserted);
-        it = q.events.erase(it);
+    vector<RawEvent> deleted_events;
+    deleted_events.reserve(size - keep_count);
+    for (size_t pos = 0; pos < end_pos; pos++) {
+      auto &event = q.events[pos];
+      if (!is_removed(event)) {
+        q.total_event_length -= event.data.size();
+        deleted_events.push_back(std::move(event));
       }
-    } else {
-      q.total_event_length = 0;
-      for (auto it = end_it; it != q.events.end();) {
-        q.total_event_length += it->second.data.size();
-        bool is_inserted = deleted_events.emplace(it->first, std::move(it->second)).second;
-        CHECK(is_inserted);
-        it = q.events.erase(it);
-      }
-      std::swap(deleted_events, q.events);
     }
+    q.event_count -= deleted_events.size();
+    q.events.erase(q.events.begin(), q.events.begin() + end_pos);
 
     auto clear_time = Time::now() - start_time;
     if (clear_time > 0.02) {
@@ -312,9 +365,9 @@ class TQueueImpl final : public TQueue {
     return get_size(q);
   }
 
-  std::pair<int64, bool> run_gc(int32 unix_time_now) final {
+  std::pair<int64, bool> run_gc(int32 unix_time_now, double max_duration) final {
     int64 deleted_events = 0;
-    auto max_finish_time = Time::now() + 0.05;
+    auto max_finish_time = Time::now() + max_duration;
     int64 counter = 0;
     while (!queue_gc_at_.empty()) {
       auto it = queue_gc_at_.begin();
@@ -328,34 +381,43 @@ class TQueueImpl final : public TQueue {
 
       if (!q.events.empty()) {
         size_t size_before = get_size(q);
-        for (auto event_it = q.events.begin(); event_it != q.events.end();) {
-          auto &event = event_it->second;
-          if ((++counter & 128) == 0 && Time::now() >= max_finish_time) {
+        for (auto &event : q.events) {
+          if (is_removed(event)) {
+            continue;
+          }
+          if ((++counter & 127) == 0 && Time::now() >= max_finish_time) {
             if (new_gc_at == 0) {
               new_gc_at = event.expires_at;
             }
             break;
           }
           if (event.expires_at < unix_time_now || event.data.empty()) {
-            pop(q, queue_id, event_it, q.tail_id);
+            pop(q, queue_id, event, q.tail_id);
           } else {
             if (new_gc_at != 0) {
               break;
             }
             new_gc_at = event.expires_at;
-            ++event_it;
           }
         }
+        shrink(q);
         size_t size_after = get_size(q);
         CHECK(size_after <= size_before);
         deleted_events += size_before - size_after;
       }
       schedule_queue_gc(queue_id, q, new_gc_at);
       if (Time::now() >= max_finish_time) {
-        return {deleted_events, false};
+        break;
       }
     }
-    return {deleted_events, true};
+    return {deleted_events, queue_gc_at_.empty() || queue_gc_at_.begin()->first >= unix_time_now};
+  }
+
+  int32 get_next_gc_time() const final {
+    if (queue_gc_at_.empty()) {
+      return 0;
+    }
+    return queue_gc_at_.begin()->first;
   }
 
   size_t get_size(QueueId queue_id) const final {
@@ -374,9 +436,15 @@ class TQueueImpl final : public TQueue {
   }
 
  private:
+  static constexpr size_t MIN_COMPACTED_HOLE_COUNT = 1000;
+
+  // events are stored in the order of their identifiers; deleted events are left as holes and are removed
+  // from the ends of the queue immediately, or from the middle of the queue during the next push,
+  // so event data returned by get remains valid until the next push or the deletion of the event
   struct Queue {
     EventId tail_id;
-    std::map<EventId, RawEvent> events;
+    std::deque<RawEvent> events;
+    size_t event_count = 0;
     size_t total_event_length = 0;
     int32 gc_at = 0;
   };
@@ -385,11 +453,69 @@ class TQueueImpl final : public TQueue {
   std::set<std::pair<int32, QueueId>> queue_gc_at_;
   unique_ptr<StorageCallback> callback_;
 
+  static Status check_event_data(const string &data) {
+    if (data.empty()) {
+      return Status::Error("Data is empty");
+    }
+    if (data.size() > MAX_EVENT_LENGTH) {
+      return Status::Error("Data is too big");
+    }
+    return Status::OK();
+  }
+
+  static Status check_queue_capacity(const Queue &q, size_t event_count, size_t total_event_length) {
+    if (event_count > MAX_QUEUE_EVENTS - q.event_count) {
+      return Status::Error("Queue is full");
+    }
+    if (total_event_length > MAX_TOTAL_EVENT_LENGTH || q.total_event_length > MAX_TOTAL_EVENT_LENGTH - total_event_length) {
+      return Status::Error("Queue size is too big");
+    }
+    return Status::OK();
+  }
+
+  // returns the first of event_count consecutive identifiers, which can be used for new events in the queue
+  EventId allocate_event_ids(QueueId queue_id, Queue &q, size_t event_count, EventId hint_new_id) {
+    while (true) {
+      if (q.tail_id.empty()) {
+        if (hint_new_id.empty()) {
+          q.tail_id = EventId::from_int32(
+                          Random::fast(2 * max(static_cast<int>(MAX_QUEUE_EVENTS), 1000000) + 1, EventId::MAX_ID / 2))
+                          .move_as_ok();
+        } else {
+          q.tail_id = hint_new_id;
+        }
+      }
+      auto event_id = q.tail_id;
+      CHECK(event_id.is_valid());
+      if (event_id.advance(event_count).is_ok()) {
+        return event_id;
+      }
+      for (auto &event : q.events) {
+        if (!is_removed(event)) {
+          pop(q, queue_id, event, {});
+        }
+      }
+      shrink(q);
+      q.tail_id = EventId();
+      CHECK(hint_new_id.advance(event_count).is_ok());
+    }
+  }
+
+  void add_new_events(vector<std::pair<QueueId, RawEvent>> &&new_events) {
+    if (callback_ != nullptr) {
+      callback_->push_batch(as_mutable_span(new_events));
+    }
+    for (auto &new_event : new_events) {
+      bool is_added = do_push(new_event.first, std::move(new_event.second));
+      CHECK(is_added);
+    }
+  }
+
   static EventId get_queue_head(const Queue &q) {
     if (q.events.empty()) {
       return q.tail_id;
     }
-    return q.events.begin()->first;
+    return q.events.front().event_id;
   }
 
   static size_t get_size(const Queue &q) {
@@ -397,13 +523,25 @@ class TQueueImpl final : public TQueue {
       return 0;
     }
 
-    return q.events.size() - (q.events.rbegin()->second.data.empty() ? 1 : 0);
+    return q.event_count - (q.events.back().data.empty() ? 1 : 0);
+  }
+
+  static bool is_removed(const RawEvent &event) {
+    // expiration date of stored events is always positive
+    return event.expires_at == 0;
   }
 
-  void pop(Queue &q, QueueId queue_id, std::map<EventId, RawEvent>::iterator &it, EventId tail_id) {
-    auto &event = it->second;
+  // returns position of the first event or hole with identifier not less than event_id
+  static size_t lower_bound(const Queue &q, EventId event_id) {
+    return static_cast<size_t>(
+        std::lower_bound(q.events.begin(), q.events.end(), event_id,
+                         [](const RawEvent &event, EventId event_id) { return event.event_id < event_id; }) -
+        q.events.begin());
+  }
+
+  void pop(Queue &q, QueueId queue_id, RawEvent &event, EventId tail_id) {
     if (callback_ == nullptr || event.log_event_id == 0) {
-      remove_event(q, it);
+      remove_event(q, event);
       return;
     }
 
@@ -412,16 +550,34 @@ class TQueueImpl final : public TQueue {
         clear_event_data(q, event);
         callback_->push(queue_id, event);
       }
-      ++it;
     } else {
       callback_->pop(event.log_event_id);
-      remove_event(q, it);
+      remove_event(q, event);
+    }
+  }
+
+  static void remove_event(Queue &q, RawEvent &event) {
+    CHECK(!is_removed(event));
+    q.total_event_length -= event.data.size();
+    q.event_count--;
+    event.log_event_id = 0;
+    event.expires_at = 0;
+    event.data = string();
+  }
+
+  // removes holes from the ends of the queue
+  static void shrink(Queue &q) {
+    while (!q.events.empty() && is_removed(q.events.back())) {
+      q.events.pop_back();
+    }
+    while (!q.events.empty() && is_removed(q.events.front())) {
+      q.events.pop_front();
     }
   }
 
-  static void remove_event(Queue &q, std::map<EventId, RawEvent>::iterator &it) {
-    q.total_event_length -= it->second.data.size();
-    it = q.events.erase(it);
+  static void compact(Queue &q) {
+    q.events.erase(std::remove_if(q.events.begin(), q.events.end(), is_removed), q.events.end());
+    CHECK(q.events.size() == q.event_count);
   }
 
   static void clear_event_data(Queue &q, RawEvent &event) {
@@ -432,16 +588,21 @@ class TQueueImpl final : public TQueue {
   void do_get(QueueId queue_id, Queue &q, EventId from_id, bool forget_previous, int32 unix_time_now,
               MutableSpan<Event> &result_events) {
     if (forget_previous) {
-      for (auto it = q.events.begin(); it != q.events.end() && it->first < from_id;) {
-        pop(q, queue_id, it, q.tail_id);
+      for (size_t pos = 0; pos < q.events.size() && q.events[pos].event_id < from_id; pos++) {
+        if (!is_removed(q.events[pos])) {
+          pop(q, queue_id, q.events[pos], q.tail_id);
+        }
       }
     }
 
     size_t ready_n = 0;
-    for (auto it = q.events.lower_bound(from_id); it != q.events.end();) {
-      auto &event = it->second;
+    for (auto pos = lower_bound(q, from_id); pos < q.events.size(); pos++) {
+      auto &event = q.events[pos];
+      if (is_removed(event)) {
+        continue;
+      }
       if (event.expires_at < unix_time_now || event.data.empty()) {
-        pop(q, queue_id, it, q.tail_id);
+        pop(q, queue_id, event, q.tail_id);
       } else {
         CHECK(!(event.event_id < from_id));
         if (ready_n == result_events.size()) {
@@ -454,9 +615,9 @@ class TQueueImpl final : public TQueue {
         to.expires_at = event.expires_at;
         to.extra = event.extra;
         ready_n++;
-        ++it;
       }
     }
+    shrink(q);
 
     result_events.truncate(ready_n);
   }
@@ -478,6 +639,40 @@ unique_ptr<TQueue> TQueue::create() {
   return make_unique<TQueueImpl>();
 }
 
+vector<IoSlice> TQueue::get_io_slices(Span<Event> events, Slice separator) {
+  vector<IoSlice> result;
+  if (events.empty()) {
+    return result;
+  }
+  result.reserve(separator.empty() ? events.size() : 2 * events.size() - 1);
+  for (size_t i = 0; i < events.size(); i++) {
+    if (i > 0 && !separator.empty()) {
+      result.push_back(as_io_slice(separator));
+    }
+    result.push_back(as_io_slice(events[i].data));
+  }
+  return result;
+}
+
+Result<size_t> TQueue::copy_data(Span<Event> events, MutableSlice buffer, MutableSpan<size_t> offsets) {
+  CHECK(offsets.size() >= events.size());
+  size_t total_size = 0;
+  for (auto &event : events) {
+    total_size += event.data.size();
+  }
+  if (total_size > buffer.size()) {
+    return Status::Error(PSLICE() << "Buffer of size " << buffer.size() << " is too small to hold " << total_size
+                                  << " bytes");
+  }
+  size_t offset = 0;
+  for (size_t i = 0; i < events.size(); i++) {
+    offsets[i] = offset;
+    buffer.substr(offset).copy_from(events[i].data);
+    offset += events[i].data.size();
+  }
+  return total_size;
+}
+
 struct TQueueLogEvent final : public Storer {
   int64 queue_id;
   int32 event_id;
@@ -485,6 +680,16 @@ struct TQueueLogEvent final : public Storer {
   Slice data;
   int64 extra;
 
+  TQueueLogEvent() = default;
+
+  TQueueLogEvent(int64 queue_id, const TQueue::RawEvent &event)
+      : queue_id(queue_id)
+      , event_id(event.event_id.value())
+      , expires_at(event.expires_at)
+      , data(event.data)
+      , extra(event.extra) {
+  }
+
   template <class StorerT>
   void store(StorerT &&storer) const {
     using td::store;
@@ -526,12 +731,7 @@ struct TQueueLogEvent final : public Storer {
 
 template <class BinlogT>
 uint64 TQueueBinlog<BinlogT>::push(QueueId queue_id, const RawEvent &event) {
-  TQueueLogEvent log_event;
-  log_event.queue_id = queue_id;
-  log_event.event_id = event.event_id.value();
-  log_event.expires_at = event.expires_at;
-  log_event.data = event.data;
-  log_event.extra = event.extra;
+  TQueueLogEvent log_event(queue_id, event);
   auto magic = BINLOG_EVENT_TYPE + (log_event.extra != 0);
   if (event.log_event_id == 0) {
     return binlog_->add(magic, log_event);
@@ -550,6 +750,25 @@ void TQueueBinlog<BinlogT>::pop_batch(std::vector<uint64> log_event_ids) {
   binlog_->erase_batch(std::move(log_event_ids));
 }
 
+template <class BinlogT>
+void TQueueBinlog<BinlogT>::push_batch(MutableSpan<std::pair<QueueId, RawEvent>> events) {
+  if (events.empty()) {
+    return;
+  }
+  auto seq_no = binlog_->next_event_id(narrow_cast<int32>(events.size()));
+  vector<BufferSlice> raw_events;
+  raw_events.reserve(events.size());
+  for (auto &it : events) {
+    auto &event = it.second;
+    CHECK(event.log_event_id == 0);
+    event.log_event_id = seq_no + raw_events.size();
+    TQueueLogEvent log_event(it.first, event);
+    auto magic = BINLOG_EVENT_TYPE + (log_event.extra != 0);
+    raw_events.push_back(BinlogEvent::create_raw(event.log_event_id, magic, 0, log_event));
+  }
+  binlog_->add_raw_event_batch(seq_no, std::move(raw_events));
+}
+
 template <class BinlogT>
 Status TQueueBinlog<BinlogT>::replay(const BinlogEvent &binlog_event, TQueue &q) const {
   TQueueLogEvent event;
@@ -610,4 +829,11 @@ void TQueue::StorageCallback::pop_batch(std::vector<uint64> log_event_ids) {
     pop(id);
   }
 }
+
+void TQueue::StorageCallback::push_batch(MutableSpan<std::pair<QueueId, RawEvent>> events) {
+  for (auto &event : events) {
+    CHECK(event.second.log_event_id == 0);
+    event.second.log_event_id = push(event.first, event.second);
+  }
+}
 }  // namespace td
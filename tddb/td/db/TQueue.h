@@ -7,6 +7,7 @@
 #pragma once
 
 #include "td/utils/common.h"
+#include "td/utils/port/IoSlice.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Span.h"
@@ -84,6 +85,9 @@ class TQueue {
     virtual void pop(uint64 log_event_id) = 0;
     virtual void close(Promise<> promise) = 0;
     virtual void pop_batch(std::vector<uint64> log_event_ids);
+
+    // sets log_event_id of the new events
+    virtual void push_batch(MutableSpan<std::pair<QueueId, RawEvent>> events);
   };
 
   static unique_ptr<TQueue> create();
@@ -103,9 +107,16 @@ class TQueue {
 
   virtual Result<EventId> push(QueueId queue_id, string data, int32 expires_at, int64 extra, EventId hint_new_id) = 0;
 
+  // adds all events with consecutive identifiers or none of them; event_id and log_event_id of the events are ignored
+  virtual Result<EventId> push_batch(QueueId queue_id, vector<RawEvent> events, EventId hint_new_id) = 0;
+
+  // adds the same event to each of the queues; returns identifier of the event or an error for each queue
+  virtual vector<Result<EventId>> push_many(const vector<QueueId> &queue_ids, const string &data, int32 expires_at,
+                                            int64 extra, EventId hint_new_id) = 0;
+
   virtual void forget(QueueId queue_id, EventId event_id) = 0;
 
-  virtual std::map<EventId, RawEvent> clear(QueueId queue_id, size_t keep_count) = 0;
+  virtual vector<RawEvent> clear(QueueId queue_id, size_t keep_count) = 0;
 
   virtual EventId get_head(QueueId queue_id) const = 0;
   virtual EventId get_tail(QueueId queue_id) const = 0;
@@ -115,8 +126,25 @@ class TQueue {
 
   virtual size_t get_size(QueueId queue_id) const = 0;
 
+  // returns data of the events, interleaved with the separator if it isn't empty, as slices, which can be written
+  // by a single writev call without copying; the slices are valid only until the next change of the queue
+  static vector<IoSlice> get_io_slices(Span<Event> events, Slice separator = Slice());
+
+  // contiguously copies data of the events to the buffer and stores starting offset of data of each event;
+  // returns total size of the data or an error if the buffer is too small
+  static Result<size_t> copy_data(Span<Event> events, MutableSlice buffer, MutableSpan<size_t> offsets);
+
   // returns number of deleted events and whether garbage collection was completed
-  virtual std::pair<int64, bool> run_gc(int32 unix_time_now) = 0;
+  std::pair<int64, bool> run_gc(int32 unix_time_now) {
+    return run_gc(unix_time_now, 0.05);
+  }
+
+  // deletes expired events in about max_duration seconds; at least some events are deleted even if max_duration is 0
+  // returns number of deleted events and whether garbage collection was completed
+  virtual std::pair<int64, bool> run_gc(int32 unix_time_now, double max_duration) = 0;
+
+  // returns the time after which run_gc needs to be called, or 0 if there are no events to delete
+  virtual int32 get_next_gc_time() const = 0;
   virtual void close(Promise<> promise) = 0;
 };
 
@@ -130,6 +158,7 @@ class TQueueBinlog final : public TQueue::StorageCallback {
   uint64 push(QueueId queue_id, const RawEvent &event) final;
   void pop(uint64 log_event_id) final;
   void pop_batch(std::vector<uint64> log_event_ids) final;
+  void push_batch(MutableSpan<std::pair<QueueId, RawEvent>> events) final;
   Status replay(const BinlogEvent &binlog_event, TQueue &q) const TD_WARN_UNUSED_RESULT;
 
   void set_binlog(std::shared_ptr<BinlogT> binlog) {
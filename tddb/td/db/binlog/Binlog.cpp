@@ -14,6 +14,7 @@
 #include "td/utils/misc.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/FileFd.h"
+#include "td/utils/port/MemoryMapping.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/PollFlags.h"
 #include "td/utils/port/sleep.h"
@@ -98,10 +99,22 @@ class BinlogReader {
   }
   void set_input(ChainBufferReader *input, bool is_encrypted, int64 expected_size) {
     input_ = input;
+    is_mapped_ = false;
     is_encrypted_ = is_encrypted;
     expected_size_ = expected_size;
   }
 
+  // events are read directly from the memory-mapped file until set_input is called
+  void set_mapped_input(Slice mapped_input) {
+    CHECK(!is_encrypted_);
+    is_mapped_ = true;
+    mapped_input_ = mapped_input;
+  }
+
+  bool is_mapped() const {
+    return is_mapped_;
+  }
+
   ChainBufferReader *input() {
     return input_;
   }
@@ -111,13 +124,16 @@ class BinlogReader {
   }
   Result<size_t> read_next(BinlogEvent *event) {
     if (state_ == State::ReadLength) {
-      if (input_->size() < 4) {
+      if (get_input_size() < 4) {
         return 4;
       }
-      auto it = input_->clone();
-
       char buf[4];
-      it.advance(4, MutableSlice(buf, 4));
+      if (is_mapped()) {
+        MutableSlice(buf, 4).copy_from(mapped_input_.substr(0, 4));
+      } else {
+        auto it = input_->clone();
+        it.advance(4, MutableSlice(buf, 4));
+      }
       size_ = static_cast<size_t>(TlParser(Slice(buf, 4)).fetch_int());
 
       if (size_ > BinlogEvent::MAX_SIZE) {
@@ -129,18 +145,24 @@ class BinlogReader {
       if (size_ % 4 != 0) {
         return Status::Error(-2, PSLICE() << "Event of size " << size_ << " at offset " << offset() << " out of "
                                           << expected_size_ << ' ' << tag("is_encrypted", is_encrypted_)
-                                          << format::as_hex_dump<4>(Slice(input_->prepare_read().truncate(28))));
+                                          << format::as_hex_dump<4>(get_input_prefix().truncate(28)));
       }
       state_ = State::ReadEvent;
     }
 
-    if (input_->size() < size_) {
+    if (get_input_size() < size_) {
       return size_;
     }
 
     event->debug_info_ = BinlogDebugInfo{__FILE__, __LINE__};
-    auto buffer_slice = input_->cut_head(size_).move_as_buffer_slice();
-    event->init(buffer_slice.as_slice().str());
+    string raw_event(size_, '\0');
+    if (is_mapped()) {
+      MutableSlice(raw_event).copy_from(mapped_input_.substr(0, size_));
+      mapped_input_.remove_prefix(size_);
+    } else {
+      input_->advance(size_, raw_event);
+    }
+    event->init(std::move(raw_event));
     TRY_STATUS(event->validate());
     offset_ += size_;
     event->offset_ = offset_;
@@ -150,12 +172,22 @@ class BinlogReader {
 
  private:
   ChainBufferReader *input_;
+  bool is_mapped_{false};
+  Slice mapped_input_;
   enum class State { ReadLength, ReadEvent };
   State state_ = State::ReadLength;
   size_t size_{0};
   int64 offset_{0};
   int64 expected_size_{0};
   bool is_encrypted_{false};
+
+  size_t get_input_size() const {
+    return is_mapped() ? mapped_input_.size() : input_->size();
+  }
+
+  Slice get_input_prefix() {
+    return is_mapped() ? mapped_input_ : Slice(input_->prepare_read());
+  }
 };
 
 static int64 file_size(CSlice path) {
@@ -246,10 +278,13 @@ void Binlog::add_event(BinlogEvent &&event) {
     auto need_reindex = [&](int64 min_size, int rate) {
       return fd_size > min_size && fd_size / rate > processor_->total_raw_events_size();
     };
-    if (need_reindex(50000, 5) || need_reindex(100000, 4) || need_reindex(300000, 3) || need_reindex(500000, 2)) {
+    if (incremental_reindex_ == nullptr && (need_reindex(50000, 5) || need_reindex(100000, 4) || need_reindex(300000, 3) || need_reindex(500000, 2))) {
       LOG(INFO) << tag("fd_size", format::as_size(fd_size))
                 << tag("total events size", format::as_size(processor_->total_raw_events_size()));
-      do_reindex();
+      start_incremental_reindex();
+    }
+    if (incremental_reindex_ != nullptr) {
+      continue_incremental_reindex();
     }
   }
 }
@@ -285,6 +320,7 @@ Status Binlog::close(bool need_sync) {
   if (fd_.empty()) {
     return Status::OK();
   }
+  cancel_incremental_reindex();
   if (need_sync) {
     sync("close");
   } else {
@@ -335,6 +371,12 @@ void Binlog::do_event(BinlogEvent &&event) {
     VLOG(binlog) << "Write binlog event: " << format::cond(state_ == State::Reindex, "[reindex] ")
                  << event.public_to_string();
     buffer_writer_.append(as_slice(event.raw_event_));
+
+    if (incremental_reindex_ != nullptr && (event.flags_ & BinlogEvent::Flags::Rewrite) != 0 &&
+        event.id_ < incremental_reindex_->next_event_id_) {
+      // the rewritten event has already been copied to the regenerated binlog
+      write_incremental_reindex_event(as_slice(event.raw_event_));
+    }
   }
 
   if (event.type_ < 0) {
@@ -408,7 +450,7 @@ void Binlog::sync(const char *source) {
   flush(source);
   if (need_sync_) {
     LOG(INFO) << "Sync binlog from " << source;
-    auto status = fd_.sync();
+    auto status = sync_mode_ == SyncMode::Data ? fd_.sync_data() : fd_.sync();
     LOG_IF(FATAL, status.is_error()) << "Failed to sync binlog: " << status;
     need_sync_ = false;
   }
@@ -467,6 +509,10 @@ void Binlog::update_read_encryption() {
       break;
     }
     case EncryptionType::AesCtr: {
+      if (binlog_reader_ptr_->is_mapped()) {
+        // continue to read the encrypted part of the file through fd_
+        fd_.seek(binlog_reader_ptr_->offset()).ensure();
+      }
       byte_flow_source_ = ByteFlowSource(&buffer_reader_);
       aes_xcode_byte_flow_ = AesCtrByteFlow();
       aes_xcode_byte_flow_.init(std::move(aes_ctr_state_));
@@ -512,6 +558,12 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
 
   update_read_encryption();
 
+  // unencrypted part of the binlog is read directly from the memory-mapped file to avoid reading syscalls and copying
+  auto r_mapping = MemoryMapping::create_from_file(fd_);
+  if (r_mapping.is_ok()) {
+    reader.set_mapped_input(r_mapping.ok().as_slice());
+  }
+
   fd_.get_poll_info().add_flags(PollFlags::Read());
   info_.wrong_password = false;
   while (true) {
@@ -543,8 +595,10 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
       if (info_.wrong_password) {
         return Status::OK();
       }
+    } else if (reader.is_mapped()) {
+      break;  // the whole file has been read
     } else {
-      TRY_STATUS(fd_.flush_read(max(need_size, static_cast<size_t>(4096))));
+      TRY_STATUS(fd_.flush_read(max(need_size, static_cast<size_t>(1 << 20))));
       buffer_reader_.sync_with_writer();
       if (byte_flow_flag_) {
         byte_flow_source_.wakeup();
@@ -570,6 +624,8 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
     fd_.seek(offset).ensure();
     fd_.truncate_to_current_position(offset).ensure();
     db_key_used_ = false;  // force reindex
+  } else if (reader.is_mapped()) {
+    fd_.seek(offset).ensure();  // the file wasn't read through fd_
   }
   LOG_CHECK(fd_size_ == offset) << fd_size << " " << fd_size_ << " " << offset;
   binlog_reader_ptr_ = nullptr;
@@ -627,6 +683,7 @@ void Binlog::reset_encryption() {
 }
 
 void Binlog::do_reindex() {
+  cancel_incremental_reindex();
   flush_events_buffer(true);
   // start reindex
   CHECK(state_ == State::Run);
@@ -670,7 +727,20 @@ void Binlog::do_reindex() {
     need_sync_ = false;
   }
 
-  // finish_reindex
+  finish_reindex(std::move(old_fd), new_path, start_time, start_size, start_events);
+
+  buffer_writer_ = ChainBufferWriter();
+  buffer_reader_ = buffer_writer_.extract_reader();
+
+  // reuse aes_ctr_state_
+  if (encryption_type_ == EncryptionType::AesCtr) {
+    aes_ctr_state_ = aes_xcode_byte_flow_.move_aes_ctr_state();
+  }
+  update_write_encryption();
+}
+
+void Binlog::finish_reindex(BufferedFdBase<FileFd> old_fd, const string &new_path, double start_time,
+                            int64 start_size, uint64 start_events) {
   auto status = unlink(path_);
   LOG_IF(FATAL, status.is_error()) << "Failed to unlink old binlog: " << status;
   old_fd.close();  // now we can close old file and release the system lock
@@ -707,17 +777,118 @@ void Binlog::do_reindex() {
   }(PSLICE() << "Regenerate index " << tag("name", path_) << tag("time", format::as_time(finish_time - start_time))
              << tag("before_size", format::as_size(start_size)) << tag("after_size", format::as_size(finish_size))
              << tag("ratio", ratio) << tag("before_events", start_events) << tag("after_events", finish_events));
+}
+
+void Binlog::start_incremental_reindex() {
+  CHECK(state_ == State::Run);
+  CHECK(incremental_reindex_ == nullptr);
+  flush_events_buffer(true);
+
+  string new_path = path_ + ".new";
+  auto r_opened_file = open_binlog(new_path, FileFd::Flags::Write | FileFd::Flags::Create | FileFd::Truncate);
+  if (r_opened_file.is_error()) {
+    LOG(ERROR) << "Can't open new binlog for regenerate: " << r_opened_file.error();
+    return;
+  }
+
+  incremental_reindex_ = make_unique<IncrementalReindex>();
+  auto &reindex = *incremental_reindex_;
+  reindex.fd_ = BufferedFdBase<FileFd>(r_opened_file.move_as_ok());
+  reindex.buffer_reader_ = reindex.buffer_writer_.extract_reader();
+  reindex.fd_.set_output_reader(&reindex.buffer_reader_);
+  reindex.start_size_ = detail::file_size(path_);
+  reindex.start_events_ = fd_events_;
+
+  if (encryption_type_ == EncryptionType::AesCtr) {
+    // the current key is reused with a new IV
+    using EncryptionEvent = detail::AesCtrEncryptionEvent;
+    EncryptionEvent event;
+    event.key_salt_ = aes_ctr_key_salt_;
+    event.iv_.resize(EncryptionEvent::iv_size());
+    Random::secure_bytes(event.iv_);
+    event.key_hash_ = EncryptionEvent::generate_hash(as_slice(aes_ctr_key_));
+
+    // the encryption event itself isn't encrypted
+    write_incremental_reindex_event(as_slice(
+        BinlogEvent::create_raw(0, BinlogEvent::ServiceTypes::AesCtrEncryption, 0, create_default_storer(event))));
+    flush_incremental_reindex();
+
+    AesCtrState aes_ctr_state;
+    aes_ctr_state.init(as_slice(aes_ctr_key_), event.iv_);
+    reindex.byte_flow_source_ = ByteFlowSource(&reindex.buffer_reader_);
+    reindex.aes_xcode_byte_flow_.init(std::move(aes_ctr_state));
+    reindex.byte_flow_source_ >> reindex.aes_xcode_byte_flow_ >> reindex.byte_flow_sink_;
+    reindex.byte_flow_flag_ = true;
+    reindex.fd_.set_output_reader(reindex.byte_flow_sink_.get_output());
+  }
+  LOG(INFO) << "Start incremental regeneration of " << path_;
+}
+
+void Binlog::continue_incremental_reindex() {
+  CHECK(incremental_reindex_ != nullptr);
+  bool is_finished =
+      processor_->for_each_from(&incremental_reindex_->next_event_id_, INCREMENTAL_REINDEX_SLICE_SIZE,
+                                [&](const BinlogEvent &event) { write_incremental_reindex_event(event.raw_event_); });
+  flush_incremental_reindex();
+  if (is_finished) {
+    finish_incremental_reindex();
+  }
+}
+
+void Binlog::write_incremental_reindex_event(Slice raw_event) {
+  auto &reindex = *incremental_reindex_;
+  reindex.buffer_writer_.append(raw_event);
+  reindex.fd_size_ += static_cast<int64>(raw_event.size());
+  reindex.fd_events_++;
+}
+
+void Binlog::flush_incremental_reindex() {
+  auto &reindex = *incremental_reindex_;
+  if (reindex.byte_flow_flag_) {
+    reindex.byte_flow_source_.wakeup();
+  }
+  reindex.fd_.flush_write().ensure();
+  LOG_IF(FATAL, reindex.fd_.need_flush_write()) << "Failed to flush regenerated binlog";
+}
+
+void Binlog::finish_incremental_reindex() {
+  auto start_time = Clocks::monotonic();  // only the final switch blocks the binlog
+  auto reindex = std::move(incremental_reindex_);
+  if (reindex->start_size_ != 0) {  // must sync creation of the file if it is non-empty
+    auto status = reindex->fd_.sync_barrier();
+    LOG_IF(FATAL, status.is_error()) << "Failed to sync binlog: " << status;
+  }
+  need_sync_ = false;
+
+  // all events from the old binlog, including not flushed ones, are already written to the new binlog
+  auto old_fd = std::move(fd_);
+  fd_ = std::move(reindex->fd_);
+  fd_size_ = reindex->fd_size_;
+  fd_events_ = reindex->fd_events_;
+  finish_reindex(std::move(old_fd), path_ + ".new", start_time, reindex->start_size_, reindex->start_events_);
 
   buffer_writer_ = ChainBufferWriter();
   buffer_reader_ = buffer_writer_.extract_reader();
+  need_flush_since_ = 0;
 
-  // reuse aes_ctr_state_
+  encryption_type_ = reindex->byte_flow_flag_ ? EncryptionType::AesCtr : EncryptionType::None;
   if (encryption_type_ == EncryptionType::AesCtr) {
-    aes_ctr_state_ = aes_xcode_byte_flow_.move_aes_ctr_state();
+    aes_ctr_state_ = reindex->aes_xcode_byte_flow_.move_aes_ctr_state();
   }
   update_write_encryption();
 }
 
+void Binlog::cancel_incremental_reindex() {
+  if (incremental_reindex_ == nullptr) {
+    return;
+  }
+  string new_path = path_ + ".new";
+  incremental_reindex_->fd_.lock(FileFd::LockFlags::Unlock, new_path, 1).ignore();
+  incremental_reindex_->fd_.close();
+  incremental_reindex_ = nullptr;
+  unlink(new_path).ignore();
+}
+
 string Binlog::debug_get_binlog_data(int64 begin_offset, int64 end_offset) {
   if (begin_offset > end_offset) {
     return "Begin offset is bigger than end_offset";
@@ -46,6 +46,7 @@ class BinlogEventsBuffer;
 class Binlog {
  public:
   enum class Error : int { WrongPassword = -1037284 };
+  enum class SyncMode : int32 { Full, Data };
   Binlog();
   Binlog(const Binlog &) = delete;
   Binlog &operator=(const Binlog &) = delete;
@@ -104,6 +105,14 @@ class Binlog {
     return seq_no;
   }
 
+  // raw_events must be created with consecutive identifiers starting from seq_no returned by next_event_id(shift)
+  void add_raw_event_batch(uint64 seq_no, vector<BufferSlice> raw_events) {
+    CHECK(seq_no + raw_events.size() == last_event_id_ + 1);
+    for (auto &raw_event : raw_events) {
+      add_raw_event(std::move(raw_event), {});
+    }
+  }
+
   void add_raw_event(BufferSlice &&raw_event, BinlogDebugInfo info) {
     add_event(BinlogEvent(std::move(raw_event), info));
   }
@@ -116,6 +125,9 @@ class Binlog {
     return need_flush_since_;
   }
   void change_key(DbKey new_db_key);
+  void set_sync_mode(SyncMode sync_mode) {
+    sync_mode_ = sync_mode;
+  }
 
   Status close(bool need_sync = true) TD_WARN_UNUSED_RESULT;
   void close(Promise<> promise);
@@ -163,14 +175,45 @@ class Binlog {
   double need_flush_since_ = 0;
   double next_buffer_flush_time_ = 0;
   bool need_sync_{false};
+  SyncMode sync_mode_{SyncMode::Full};
   enum class State { Empty, Load, Reindex, Run } state_{State::Empty};
 
+  // background regeneration of the binlog, which is done in small slices while new events are added
+  struct IncrementalReindex {
+    BufferedFdBase<FileFd> fd_;
+    ChainBufferWriter buffer_writer_;
+    ChainBufferReader buffer_reader_;
+
+    bool byte_flow_flag_ = false;
+    ByteFlowSource byte_flow_source_;
+    ByteFlowSink byte_flow_sink_;
+    AesCtrByteFlow aes_xcode_byte_flow_;
+
+    uint64 next_event_id_{0};  // all live events with smaller identifiers are already written
+    int64 fd_size_{0};
+    uint64 fd_events_{0};
+
+    int64 start_size_{0};
+    uint64 start_events_{0};
+  };
+  unique_ptr<IncrementalReindex> incremental_reindex_;
+  static constexpr int64 INCREMENTAL_REINDEX_SLICE_SIZE = 1 << 17;
+
   static Result<FileFd> open_binlog(const string &path, int32 flags);
   size_t flush_events_buffer(bool force);
   void do_add_event(BinlogEvent &&event);
   void do_event(BinlogEvent &&event);
   Status load_binlog(const Callback &callback, const Callback &debug_callback = Callback()) TD_WARN_UNUSED_RESULT;
   void do_reindex();
+  void finish_reindex(BufferedFdBase<FileFd> old_fd, const string &new_path, double start_time, int64 start_size,
+                      uint64 start_events);
+
+  void start_incremental_reindex();
+  void continue_incremental_reindex();
+  void write_incremental_reindex_event(Slice raw_event);
+  void flush_incremental_reindex();
+  void finish_incremental_reindex();
+  void cancel_incremental_reindex();
 
   void update_encryption(Slice key, Slice iv);
   void reset_encryption();
@@ -9,6 +9,7 @@
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/format.h"
+#include "td/utils/logging.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
@@ -79,7 +80,8 @@ struct BinlogEvent {
     BinlogEvent result;
     result.debug_info_ = BinlogDebugInfo{__FILE__, __LINE__};
     result.init(raw_event_);
-    result.validate().ensure();
+    // the event was validated when it was read or created, so there is no need to recalculate CRC32 of the copy
+    CHECK(result.crc32_ == crc32_);
     return result;
   }
 
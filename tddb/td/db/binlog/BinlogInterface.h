@@ -74,6 +74,13 @@ class BinlogInterface {
     return seq_no;
   }
 
+  // raw_events must be created with consecutive identifiers starting from seq_no returned by next_event_id(shift)
+  virtual void add_raw_event_batch(uint64 seq_no, vector<BufferSlice> raw_events) {
+    for (auto &raw_event : raw_events) {
+      add_raw_event_impl(seq_no++, std::move(raw_event), Promise<>(), {});
+    }
+  }
+
   virtual void force_sync(Promise<> promise, const char *source) = 0;
   virtual void force_flush() = 0;
   virtual void change_key(DbKey db_key, Promise<> promise) = 0;
@@ -50,6 +50,13 @@ class BinlogActor final : public Actor {
     }
   }
 
+  void add_raw_event_batch(uint64 seq_no, vector<BufferSlice> raw_events) {
+    for (auto &raw_event : raw_events) {
+      add_raw_event(seq_no, std::move(raw_event), Promise<Unit>(), BinlogDebugInfo{__FILE__, __LINE__});
+      seq_no++;
+    }
+  }
+
   void add_raw_event(uint64 seq_no, BufferSlice &&raw_event, Promise<> &&promise, BinlogDebugInfo info) {
     processor_.add(seq_no, Event{std::move(raw_event), std::move(promise), info}, [&](uint64 event_id, Event &&event) {
       if (!event.raw_event.empty()) {
@@ -82,6 +89,11 @@ class BinlogActor final : public Actor {
     promise.set_value(Unit());
   }
 
+  void set_sync_options(double force_sync_delay, Binlog::SyncMode sync_mode) {
+    force_sync_delay_ = force_sync_delay;
+    binlog_->set_sync_mode(sync_mode);
+  }
+
  private:
   unique_ptr<Binlog> binlog_;
 
@@ -94,6 +106,9 @@ class BinlogActor final : public Actor {
   bool flush_flag_ = false;
   double wakeup_at_ = 0;
 
+  // all force_sync requests received during the delay are completed by a single sync
+  double force_sync_delay_ = 0.003;
+
   static constexpr double FLUSH_TIMEOUT = 0.001;  // 1ms
 
   void wakeup_after(double after) {
@@ -139,7 +154,7 @@ class BinlogActor final : public Actor {
     }
     if (!force_sync_flag_) {
       force_sync_flag_ = true;
-      wakeup_after(0.003);
+      wakeup_after(force_sync_delay_);
     }
   }
 
@@ -218,6 +233,10 @@ void ConcurrentBinlog::change_key(DbKey db_key, Promise<> promise) {
   send_closure(binlog_actor_, &detail::BinlogActor::change_key, std::move(db_key), std::move(promise));
 }
 
+void ConcurrentBinlog::set_sync_options(double force_sync_delay, Binlog::SyncMode sync_mode) {
+  send_closure(binlog_actor_, &detail::BinlogActor::set_sync_options, force_sync_delay, sync_mode);
+}
+
 uint64 ConcurrentBinlog::erase_batch(vector<uint64> event_ids) {
   auto shift = narrow_cast<int32>(event_ids.size());
   if (shift == 0) {
@@ -228,4 +247,11 @@ uint64 ConcurrentBinlog::erase_batch(vector<uint64> event_ids) {
   return seq_no;
 }
 
+void ConcurrentBinlog::add_raw_event_batch(uint64 seq_no, vector<BufferSlice> raw_events) {
+  if (raw_events.empty()) {
+    return;
+  }
+  send_closure(binlog_actor_, &detail::BinlogActor::add_raw_event_batch, seq_no, std::move(raw_events));
+}
+
 }  // namespace td
@@ -45,6 +45,9 @@ class ConcurrentBinlog final : public BinlogInterface {
   void force_flush() final;
   void change_key(DbKey db_key, Promise<> promise) final;
 
+  // force_sync requests are grouped during force_sync_delay seconds and completed by a single sync
+  void set_sync_options(double force_sync_delay, Binlog::SyncMode sync_mode);
+
   uint64 next_event_id() final {
     return last_event_id_.fetch_add(1, std::memory_order_relaxed);
   }
@@ -57,6 +60,7 @@ class ConcurrentBinlog final : public BinlogInterface {
   }
 
   uint64 erase_batch(vector<uint64> event_ids) final;
+  void add_raw_event_batch(uint64 seq_no, vector<BufferSlice> raw_events) final;
 
  private:
   void init_impl(unique_ptr<Binlog> binlog, int scheduler_id);
@@ -95,16 +95,95 @@ struct Trie {
 
 enum Magic { ConfigPmcMagic = 0x1f18, BinlogPmcMagic = 0x4327 };
 
+// handler types are defined in td/telegram/logevent/LogEvent.h and TQueue; only groups of them are distinguished
+static td::Slice get_event_type_group(td::int32 type) {
+  if (type == ConfigPmcMagic) {
+    return td::Slice("ConfigPmc");
+  }
+  if (type == BinlogPmcMagic) {
+    return td::Slice("BinlogPmc");
+  }
+  if (type == 2314 || type == 2315) {
+    return td::Slice("TQueue");
+  }
+  if (type == 1 || type == 5) {
+    return td::Slice("SecretChats");
+  }
+  if (type >= 2 && type < 0x10) {
+    return td::Slice("Users&Chats");
+  }
+  if (type >= 0x10 && type < 0x100) {
+    return td::Slice("WebPages&Polls");
+  }
+  if (type >= 0x100 && type < 0x200) {
+    return td::Slice("Messages");
+  }
+  if (type >= 0x200 && type < 0x300) {
+    return td::Slice("Notifications");
+  }
+  if (type >= 0x400 && type < 0x500) {
+    return td::Slice("Stories");
+  }
+  if (type >= 0x500 && type < 0x600) {
+    return td::Slice("Account");
+  }
+  if (type < 0) {
+    return td::Slice("Service");
+  }
+  return td::Slice("Other");
+}
+
+struct EventStats {
+  td::uint64 count = 0;
+  td::uint64 size = 0;
+
+  void add(td::uint64 event_size) {
+    count++;
+    size += event_size;
+  }
+};
+
+static td::string format_stats(const EventStats &all, const EventStats &live) {
+  return PSTRING() << td::tag("count", all.count) << td::tag("size", td::format::as_size(all.size))
+                   << td::tag("live_count", live.count) << td::tag("live_size", td::format::as_size(live.size))
+                   << td::tag("dead_size", td::format::as_size(all.size - live.size));
+}
+
+static void print_usage() {
+  LOG(PLAIN) << "Usage: binlog_dump [--stats] [--compact <output_binlog_file_name>] <binlog_file_name>";
+  LOG(PLAIN) << "  --stats    print only statistics without events";
+  LOG(PLAIN) << "  --compact  write only live events to a new binlog; the source binlog must not be in use";
+}
+
 int main(int argc, char *argv[]) {
-  if (argc < 2) {
-    LOG(PLAIN) << "Usage: binlog_dump <binlog_file_name>";
+  bool need_print_events = true;
+  td::string compacted_binlog_file_name;
+  td::string binlog_file_name;
+  for (int i = 1; i < argc; i++) {
+    td::Slice arg(argv[i]);
+    if (arg == "--stats") {
+      need_print_events = false;
+    } else if (arg == "--compact" && i + 1 < argc) {
+      compacted_binlog_file_name = argv[++i];
+    } else if (binlog_file_name.empty() && !td::begins_with(arg, "--")) {
+      binlog_file_name = arg.str();
+    } else {
+      print_usage();
+      return 1;
+    }
+  }
+  if (binlog_file_name.empty()) {
+    print_usage();
     return 1;
   }
-  td::string binlog_file_name = argv[1];
   auto r_stat = td::stat(binlog_file_name);
   if (r_stat.is_error() || r_stat.ok().size_ == 0 || !r_stat.ok().is_reg_) {
     LOG(PLAIN) << "Wrong binlog file name specified";
-    LOG(PLAIN) << "Usage: binlog_dump <binlog_file_name>";
+    print_usage();
+    return 1;
+  }
+  if (!compacted_binlog_file_name.empty() && td::stat(compacted_binlog_file_name).is_ok()) {
+    LOG(PLAIN) << "Output binlog file already exists";
     return 1;
   }
 
@@ -116,6 +195,13 @@ int main(int argc, char *argv[]) {
   };
   std::map<td::uint64, Info> info;
 
+  // all events are read from the file, live events are the ones, which remain after all rewrites and erasures
+  std::map<td::Slice, EventStats> all_group_stats;
+  std::map<td::Slice, EventStats> live_group_stats;
+  std::map<td::int32, EventStats> all_type_stats;
+  std::map<td::int32, EventStats> live_type_stats;
+  td::vector<td::BufferSlice> live_events;
+
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
   td::Binlog binlog;
   binlog
@@ -124,23 +210,32 @@ int main(int argc, char *argv[]) {
           [&](auto &event) {
             info[0].compressed_size += event.raw_event_.size();
             info[event.type_].compressed_size += event.raw_event_.size();
+            live_group_stats[get_event_type_group(event.type_)].add(event.raw_event_.size());
+            live_type_stats[event.type_].add(event.raw_event_.size());
             if (event.type_ == ConfigPmcMagic || event.type_ == BinlogPmcMagic) {
               auto key = td::TlParser(event.get_data()).template fetch_string<td::Slice>();
               info[event.type_].compressed_trie.add(key);
             }
+            if (!compacted_binlog_file_name.empty()) {
+              live_events.push_back(td::BufferSlice(event.raw_event_));
+            }
           },
           td::DbKey::raw_key("cucumber"), td::DbKey::empty(), -1,
           [&](auto &event) mutable {
             info[0].full_size += event.raw_event_.size();
             info[event.type_].full_size += event.raw_event_.size();
+            all_group_stats[get_event_type_group(event.type_)].add(event.raw_event_.size());
+            all_type_stats[event.type_].add(event.raw_event_.size());
             if (event.type_ == ConfigPmcMagic || event.type_ == BinlogPmcMagic) {
               auto key = td::TlParser(event.get_data()).template fetch_string<td::Slice>();
               info[event.type_].trie.add(key);
             }
-            LOG(PLAIN) << "LogEvent[" << td::tag("event_id", td::format::as_hex(event.id_))
-                       << td::tag("type", event.type_) << td::tag("flags", event.flags_)
-                       << td::tag("size", event.get_data().size())
-                       << td::tag("data", td::format::escaped(event.get_data())) << "]\n";
+            if (need_print_events) {
+              LOG(PLAIN) << "LogEvent[" << td::tag("event_id", td::format::as_hex(event.id_))
+                         << td::tag("type", event.type_) << td::tag("flags", event.flags_)
+                         << td::tag("size", event.get_data().size())
+                         << td::tag("data", td::format::escaped(event.get_data())) << "]\n";
+            }
           })
       .ensure();
 
@@ -154,5 +249,37 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  EventStats all_total;
+  EventStats live_total;
+  for (auto &it : all_group_stats) {
+    auto &live = live_group_stats[it.first];
+    all_total.count += it.second.count;
+    all_total.size += it.second.size;
+    live_total.count += live.count;
+    live_total.size += live.size;
+    LOG(PLAIN) << td::tag("group", it.first) << format_stats(it.second, live);
+  }
+  for (auto &it : all_type_stats) {
+    LOG(PLAIN) << td::tag("type", td::format::as_hex(it.first)) << td::tag("group", get_event_type_group(it.first))
+               << format_stats(it.second, live_type_stats[it.first]);
+  }
+  LOG(PLAIN) << "TOTAL" << format_stats(all_total, live_total)
+             << td::tag("file_size", td::format::as_size(r_stat.ok().size_));
+
+  binlog.close(false).ensure();
+
+  if (!compacted_binlog_file_name.empty()) {
+    // live events are written at once in their order, which is much faster than a reindex inside a running client
+    td::Binlog compacted_binlog;
+    compacted_binlog.init(compacted_binlog_file_name, [](auto &) { UNREACHABLE(); }, td::DbKey::raw_key("cucumber"))
+        .ensure();
+    for (auto &raw_event : live_events) {
+      compacted_binlog.add_raw_event(std::move(raw_event), {});
+    }
+    compacted_binlog.close().ensure();
+    LOG(PLAIN) << "Compacted binlog " << td::tag("events", live_events.size())
+               << td::tag("file_size", td::format::as_size(td::stat(compacted_binlog_file_name).ok().size_));
+  }
+
   return 0;
 }
@@ -12,6 +12,8 @@
 #include "td/utils/logging.h"
 #include "td/utils/Status.h"
 
+#include <algorithm>
+
 namespace td {
 namespace detail {
 
@@ -33,6 +35,29 @@ class BinlogEventsProcessor {
     }
   }
 
+  // calls callback for not deleted events with identifier not less than *from_event_id until their total size
+  // reaches max_size, updates *from_event_id to the identifier of the next event to process
+  // returns true if there are no more events to process
+  template <class CallbackT>
+  bool for_each_from(uint64 *from_event_id, int64 max_size, CallbackT &&callback) {
+    auto it = std::lower_bound(event_ids_.begin(), event_ids_.end(), *from_event_id * 2);
+    int64 size = 0;
+    for (; it != event_ids_.end(); ++it) {
+      if ((*it & 1) != 0) {
+        continue;
+      }
+      if (size >= max_size) {
+        *from_event_id = *it / 2;
+        return false;
+      }
+      auto &event = events_[it - event_ids_.begin()];
+      size += static_cast<int64>(event.raw_event_.size());
+      callback(event);
+    }
+    *from_event_id = last_event_id_ + 1;
+    return true;
+  }
+
   uint64 last_event_id() const {
     return last_event_id_;
   }
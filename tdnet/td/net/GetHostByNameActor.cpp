@@ -28,10 +28,15 @@ class GoogleDnsResolver final : public Actor {
   }
 
  private:
+  // time to wait for an address of the preferred family after an address of the other family is received, RFC 8305
+  static constexpr double RESOLUTION_DELAY = 0.05;
+
   std::string host_;
   bool prefer_ipv6_;
   Promise<IPAddress> promise_;
-  ActorOwn<Wget> wget_;
+  ActorOwn<Wget> wget_[2];
+  bool has_result_[2] = {false, false};
+  Result<IPAddress> results_[2];
   double begin_time_ = 0;
 
   void start_up() final {
@@ -41,35 +46,52 @@ class GoogleDnsResolver final : public Actor {
       return stop();
     }
 
+    // A and AAAA records are requested simultaneously
+    begin_time_ = Time::now();
+    send_query(prefer_ipv6_);
+    send_query(!prefer_ipv6_);
+  }
+
+  void send_query(bool is_ipv6) {
     const int timeout = 10;
     const int ttl = 3;
-    begin_time_ = Time::now();
-    auto wget_promise = PromiseCreator::lambda([actor_id = actor_id(this)](Result<unique_ptr<HttpQuery>> r_http_query) {
-      send_closure(actor_id, &GoogleDnsResolver::on_result, std::move(r_http_query));
-    });
-    wget_ = create_actor<Wget>(
+    auto wget_promise =
+        PromiseCreator::lambda([actor_id = actor_id(this), is_ipv6](Result<unique_ptr<HttpQuery>> r_http_query) {
+          send_closure(actor_id, &GoogleDnsResolver::on_result, is_ipv6, std::move(r_http_query));
+        });
+    wget_[is_ipv6] = create_actor<Wget>(
         "GoogleDnsResolver", std::move(wget_promise),
-        PSTRING() << "https://dns.google/resolve?name=" << url_encode(host_) << "&type=" << (prefer_ipv6_ ? 28 : 1),
+        PSTRING() << "https://dns.google/resolve?name=" << url_encode(host_) << "&type=" << get_record_type(is_ipv6),
         std::vector<std::pair<string, string>>({{"Host", "dns.google"}}), timeout, ttl, prefer_ipv6_,
         SslCtx::VerifyPeer::Off);
   }
 
-  static Result<IPAddress> get_ip_address(Result<unique_ptr<HttpQuery>> r_http_query) {
+  static int32 get_record_type(bool is_ipv6) {
+    return is_ipv6 ? 28 : 1;
+  }
+
+  static Result<IPAddress> get_ip_address(Result<unique_ptr<HttpQuery>> r_http_query, bool is_ipv6) {
     TRY_RESULT(http_query, std::move(r_http_query));
 
-    auto get_ip_address = [](JsonValue &answer) -> Result<IPAddress> {
+    auto get_ip_address = [is_ipv6](JsonValue &answer) -> Result<IPAddress> {
       auto &array = answer.get_array();
       if (array.empty()) {
         return Status::Error("Failed to parse DNS result: Answer is an empty array");
       }
-      if (array[0].type() != JsonValue::Type::Object) {
-        return Status::Error("Failed to parse DNS result: Answer[0] is not an object");
+      // the answer can also contain CNAME records, which must be skipped
+      for (auto &record : array) {
+        if (record.type() != JsonValue::Type::Object) {
+          return Status::Error("Failed to parse DNS result: Answer record is not an object");
+        }
+        auto &object = record.get_object();
+        TRY_RESULT(type, object.get_optional_int_field("type", get_record_type(is_ipv6)));
+        if (type != get_record_type(is_ipv6)) {
+          continue;
+        }
+        TRY_RESULT(ip_str, object.get_required_string_field("data"));
+        return is_ipv6 ? IPAddress::get_ipv6_address(ip_str) : IPAddress::get_ipv4_address(ip_str);
       }
-      auto &answer_0 = array[0].get_object();
-      TRY_RESULT(ip_str, answer_0.get_required_string_field("data"));
-      IPAddress ip;
-      TRY_STATUS(ip.init_host_port(ip_str, 0));
-      return ip;
+      return Status::Error("Failed to parse DNS result: Answer has no addresses");
     };
     if (!http_query->get_arg("Answer").empty()) {
       TRY_RESULT(answer, json_decode(http_query->get_arg("Answer")));
@@ -88,13 +110,38 @@ class GoogleDnsResolver final : public Actor {
     }
   }
 
-  void on_result(Result<unique_ptr<HttpQuery>> r_http_query) {
+  void on_result(bool is_ipv6, Result<unique_ptr<HttpQuery>> r_http_query) {
     auto end_time = Time::now();
-    auto result = get_ip_address(std::move(r_http_query));
-    VLOG(dns_resolver) << "Init IPv" << (prefer_ipv6_ ? "6" : "4") << " host = " << host_ << " in "
+    auto result = get_ip_address(std::move(r_http_query), is_ipv6);
+    VLOG(dns_resolver) << "Init IPv" << (is_ipv6 ? "6" : "4") << " host = " << host_ << " in "
                        << end_time - begin_time_ << " seconds to "
                        << (result.is_ok() ? (PSLICE() << result.ok()) : CSlice("[invalid]"));
-    promise_.set_result(std::move(result));
+    wget_[is_ipv6].reset();
+    has_result_[is_ipv6] = true;
+    results_[is_ipv6] = std::move(result);
+
+    if (has_result_[prefer_ipv6_]) {
+      if (results_[prefer_ipv6_].is_ok() || has_result_[!prefer_ipv6_]) {
+        return finish();
+      }
+    } else if (results_[!prefer_ipv6_].is_ok()) {
+      set_timeout_in(RESOLUTION_DELAY);
+    }
+  }
+
+  void timeout_expired() final {
+    finish();
+  }
+
+  void finish() {
+    if (has_result_[prefer_ipv6_] && results_[prefer_ipv6_].is_ok()) {
+      promise_.set_result(std::move(results_[prefer_ipv6_]));
+    } else if (has_result_[!prefer_ipv6_] && results_[!prefer_ipv6_].is_ok()) {
+      promise_.set_result(std::move(results_[!prefer_ipv6_]));
+    } else {
+      CHECK(has_result_[prefer_ipv6_]);
+      promise_.set_result(std::move(results_[prefer_ipv6_]));
+    }
     stop();
   }
 };
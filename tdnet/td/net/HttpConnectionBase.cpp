@@ -24,7 +24,8 @@ HttpConnectionBase::HttpConnectionBase(State state, BufferedFd<SocketFd> fd, Ssl
     , max_post_size_(max_post_size)
     , max_files_(max_files)
     , idle_timeout_(idle_timeout)
-    , slow_scheduler_id_(slow_scheduler_id) {
+    , slow_scheduler_id_(slow_scheduler_id)
+    , allow_pipelining_(state == State::Write) {
   CHECK(state_ != State::Close);
 
   if (ssl_stream_) {
@@ -58,7 +59,7 @@ void HttpConnectionBase::tear_down() {
 }
 
 void HttpConnectionBase::write_next_noflush(BufferSlice buffer) {
-  CHECK(state_ == State::Write);
+  CHECK(state_ == State::Write || (state_ == State::Read && allow_pipelining_));
   write_buffer_.append(std::move(buffer));
 }
 void HttpConnectionBase::write_next(BufferSlice buffer) {
@@ -67,6 +68,11 @@ void HttpConnectionBase::write_next(BufferSlice buffer) {
 }
 
 void HttpConnectionBase::write_ok() {
+  if (state_ == State::Read && allow_pipelining_) {
+    // the query is sent before responses to the previous queries are received
+    pipelined_query_count_++;
+    return loop();
+  }
   CHECK(state_ == State::Write);
   current_query_ = make_unique<HttpQuery>();
   state_ = State::Read;
@@ -115,7 +121,7 @@ void HttpConnectionBase::loop() {
 
   bool want_read = false;
   bool can_be_slow = slow_scheduler_id_ == -1;
-  if (state_ == State::Read) {
+  while (state_ == State::Read) {
     auto res = reader_.read_next(current_query_.get(), can_be_slow);
     if (res.is_error()) {
       if (res.error().message() == "SLOW") {
@@ -140,14 +146,21 @@ void HttpConnectionBase::loop() {
       close_after_write_ = true;
       on_error(Status::Error(res.error().public_message()));
     } else if (res.ok() == 0) {
-      state_ = State::Write;
       LOG(DEBUG) << "Send query to handler";
       live_event();
       current_query_->peer_address_ = peer_address_;
       on_query(std::move(current_query_));
+      if (pipelined_query_count_ > 0) {
+        // wait for the response to the next pipelined query
+        pipelined_query_count_--;
+        current_query_ = make_unique<HttpQuery>();
+        continue;
+      }
+      state_ = State::Write;
     } else {
       want_read = true;
     }
+    break;
   }
 
   write_source_.wakeup();
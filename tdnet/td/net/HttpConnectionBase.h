@@ -59,6 +59,10 @@ class HttpConnectionBase : public Actor {
 
   int32 slow_scheduler_id_{-1};
 
+  // outbound connections can send next queries before the response to the previous query is received
+  bool allow_pipelining_ = false;
+  size_t pipelined_query_count_ = 0;
+
   void live_event();
 
   void start_up() final;
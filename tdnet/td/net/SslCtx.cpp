@@ -151,6 +151,91 @@ X509_STORE *load_system_certificate_store() {
   return store;
 }
 
+// TLS sessions, which can be resumed by subsequent connections to the same host
+class SslSessionCache {
+ public:
+  SslSessionCache() = default;
+  SslSessionCache(const SslSessionCache &) = delete;
+  SslSessionCache &operator=(const SslSessionCache &) = delete;
+  SslSessionCache(SslSessionCache &&) = delete;
+  SslSessionCache &operator=(SslSessionCache &&) = delete;
+  ~SslSessionCache() {
+    clear();
+  }
+
+  // takes ownership of the session
+  void add_session(const string &host, SSL_SESSION *session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(host);
+    if (it != sessions_.end()) {
+      SSL_SESSION_free(it->second);
+      it->second = session;
+      return;
+    }
+    if (sessions_.size() >= MAX_SESSION_COUNT) {
+      clear();
+    }
+    sessions_.emplace(host, session);
+  }
+
+  void restore_session(SSL *ssl_handle, const string &host) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(host);
+    if (it == sessions_.end()) {
+      return;
+    }
+    SSL_set_session(ssl_handle, it->second);
+#ifdef TLS1_3_VERSION
+    if (SSL_SESSION_get_protocol_version(it->second) >= TLS1_3_VERSION) {
+      // TLS 1.3 tickets must not be reused; the resumed connection will receive a new ticket
+      SSL_SESSION_free(it->second);
+      sessions_.erase(it);
+    }
+#endif
+  }
+
+ private:
+  static constexpr size_t MAX_SESSION_COUNT = 1000;
+
+  std::mutex mutex_;
+  FlatHashMap<string, SSL_SESSION *> sessions_;
+
+  void clear() {
+    for (auto &it : sessions_) {
+      SSL_SESSION_free(it.second);
+    }
+    sessions_.clear();
+  }
+};
+
+void free_ssl_session_cache(void *parent, void *ptr, CRYPTO_EX_DATA *ad, int idx, long argl, void *argp) {
+  delete static_cast<SslSessionCache *>(ptr);
+}
+
+int get_ssl_session_cache_index() {
+  static int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, free_ssl_session_cache);
+  return index;
+}
+
+int get_ssl_host_index() {
+  static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  return index;
+}
+
+SslSessionCache *get_ssl_session_cache(SSL *ssl_handle) {
+  return static_cast<SslSessionCache *>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl_handle), get_ssl_session_cache_index()));
+}
+
+int new_session_callback(SSL *ssl_handle, SSL_SESSION *session) {
+  auto *host = static_cast<const string *>(SSL_get_ex_data(ssl_handle, get_ssl_host_index()));
+  auto *cache = get_ssl_session_cache(ssl_handle);
+  if (host == nullptr || cache == nullptr) {
+    return 0;
+  }
+  cache->add_session(*host, session);
+  return 1;
+}
+
 using SslCtxPtr = std::shared_ptr<SSL_CTX>;
 
 Result<SslCtxPtr> do_create_ssl_ctx(CSlice cert_file, SslCtx::VerifyPeer verify_peer) {
@@ -181,6 +266,10 @@ Result<SslCtxPtr> do_create_ssl_ctx(CSlice cert_file, SslCtx::VerifyPeer verify_
 #endif
   SSL_CTX_set_mode(ssl_ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER | SSL_MODE_ENABLE_PARTIAL_WRITE);
 
+  SSL_CTX_set_ex_data(ssl_ctx, get_ssl_session_cache_index(), new SslSessionCache());
+  SSL_CTX_set_session_cache_mode(ssl_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(ssl_ctx, new_session_callback);
+
   if (cert_file.empty()) {
     auto *store = load_system_certificate_store();
     if (store == nullptr) {
@@ -321,6 +410,16 @@ void *SslCtx::get_openssl_ctx() const {
   return impl_ == nullptr ? nullptr : impl_->get_openssl_ctx();
 }
 
+void SslCtx::init_session_resumption(void *ssl_handle, const string &host) {
+  auto *ssl = static_cast<SSL *>(ssl_handle);
+  auto *cache = detail::get_ssl_session_cache(ssl);
+  if (cache == nullptr) {
+    return;
+  }
+  SSL_set_ex_data(ssl, detail::get_ssl_host_index(), const_cast<string *>(&host));
+  cache->restore_session(ssl, host);
+}
+
 SslCtx::SslCtx(unique_ptr<detail::SslCtxImpl> impl) : impl_(std::move(impl)) {
 }
 
@@ -362,6 +461,9 @@ void *SslCtx::get_openssl_ctx() const {
   return nullptr;
 }
 
+void SslCtx::init_session_resumption(void *ssl_handle, const string &host) {
+}
+
 SslCtx::SslCtx(unique_ptr<detail::SslCtxImpl> impl) : impl_(std::move(impl)) {
 }
 
@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/utils/common.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
@@ -32,6 +33,10 @@ class SslCtx {
 
   void *get_openssl_ctx() const;
 
+  // resumes a saved TLS session with the host if possible and saves new sessions for the host;
+  // the host must be alive while the SSL handle exists
+  static void init_session_resumption(void *ssl_handle, const string &host);
+
   explicit operator bool() const noexcept {
     return static_cast<bool>(impl_);
   }
@@ -12,6 +12,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/IPAddress.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 #include "td/utils/Time.h"
 
@@ -20,6 +21,7 @@
 #include <openssl/ssl.h>
 #include <openssl/x509.h>
 
+#include <atomic>
 #include <cstring>
 #include <memory>
 
@@ -27,6 +29,9 @@ namespace td {
 
 namespace detail {
 namespace {
+std::atomic<uint64> full_handshake_count;
+std::atomic<uint64> resumed_handshake_count;
+
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
 void *BIO_get_data(BIO *b) {
   return b->ptr;
@@ -177,6 +182,10 @@ class SslStreamImpl {
 #endif
     SSL_set_connect_state(ssl_handle.get());
 
+    // sessions must not be shared between connections with different host verification parameters
+    host_ = check_ip_address_as_host ? PSTRING() << "host:" << host : host.str();
+    SslCtx::init_session_resumption(ssl_handle.get(), host_);
+
     ssl_handle_ = std::move(ssl_handle);
 
     return Status::OK();
@@ -196,7 +205,21 @@ class SslStreamImpl {
   }
 
  private:
+  string host_;
   SslHandle ssl_handle_;
+  bool is_handshake_finished_ = false;
+
+  void check_handshake_finished() {
+    if (!is_handshake_finished_ && SSL_is_init_finished(ssl_handle_.get())) {
+      is_handshake_finished_ = true;
+      if (SSL_session_reused(ssl_handle_.get())) {
+        LOG(DEBUG) << "Resumed TLS session with " << host_;
+        resumed_handshake_count.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        full_handshake_count.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
 
   friend class SslReadByteFlow;
   friend class SslWriteByteFlow;
@@ -205,6 +228,7 @@ class SslStreamImpl {
     clear_openssl_errors("Before SslFd::write");
     auto start_time = Time::now();
     auto size = SSL_write(ssl_handle_.get(), slice.data(), static_cast<int>(slice.size()));
+    check_handshake_finished();
     auto elapsed_time = Time::now() - start_time;
     if (elapsed_time >= 0.1) {
       LOG(WARNING) << "SSL_write of size " << slice.size() << " took " << elapsed_time << " seconds and returned "
@@ -220,6 +244,7 @@ class SslStreamImpl {
     clear_openssl_errors("Before SslFd::read");
     auto start_time = Time::now();
     auto size = SSL_read(ssl_handle_.get(), slice.data(), static_cast<int>(slice.size()));
+    check_handshake_finished();
     auto elapsed_time = Time::now() - start_time;
     if (elapsed_time >= 0.1) {
       LOG(WARNING) << "SSL_read took " << elapsed_time << " seconds and returned " << size << ' '
@@ -364,6 +389,12 @@ Result<SslStream> SslStream::create(CSlice host, SslCtx ssl_ctx, bool use_ip_add
 }
 SslStream::SslStream(unique_ptr<detail::SslStreamImpl> impl) : impl_(std::move(impl)) {
 }
+SslStream::HandshakeStatistics SslStream::get_handshake_statistics() {
+  HandshakeStatistics result;
+  result.full_handshake_count = detail::full_handshake_count.load(std::memory_order_relaxed);
+  result.resumed_handshake_count = detail::resumed_handshake_count.load(std::memory_order_relaxed);
+  return result;
+}
 ByteFlowInterface &SslStream::read_byte_flow() {
   return impl_->read_byte_flow();
 }
@@ -399,6 +430,10 @@ Result<SslStream> SslStream::create(CSlice host, SslCtx ssl_ctx, bool check_ip_a
 SslStream::SslStream(unique_ptr<detail::SslStreamImpl> impl) : impl_(std::move(impl)) {
 }
 
+SslStream::HandshakeStatistics SslStream::get_handshake_statistics() {
+  return HandshakeStatistics();
+}
+
 ByteFlowInterface &SslStream::read_byte_flow() {
   UNREACHABLE();
 }
@@ -9,6 +9,7 @@
 #include "td/net/SslCtx.h"
 
 #include "td/utils/ByteFlow.h"
+#include "td/utils/common.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
@@ -27,6 +28,14 @@ class SslStream {
 
   static Result<SslStream> create(CSlice host, SslCtx ssl_ctx, bool use_ip_address_as_host = false);
 
+  struct HandshakeStatistics {
+    uint64 full_handshake_count = 0;
+    uint64 resumed_handshake_count = 0;
+  };
+
+  // returns numbers of finished handshakes of all SslStreams
+  static HandshakeStatistics get_handshake_statistics();
+
   ByteFlowInterface &read_byte_flow();
   ByteFlowInterface &write_byte_flow();
 
@@ -15,6 +15,8 @@
 
 namespace td {
 
+// server sockets are opened with SO_REUSEPORT, so listeners on the same port can be created on several schedulers
+// to accept connections in parallel; the kernel balances connections between them
 class TcpListener final : public Actor {
  public:
   class Callback : public Actor {
@@ -238,13 +238,7 @@ static void write_constructor_fetch(tl_outputer &out, const std::string &parser_
   out.append(w.gen_vars(t, result_type, vars));
   out.append(w.gen_uni(result_type, vars, true));
   int field_num = 0;
-  for (std::size_t i = 0; i < t->args.size(); i++) {
-    std::string field_fetch = w.gen_field_fetch(field_num, t->args[i], vars, is_flat, parser_type);
-    if (!field_fetch.empty()) {
-      out.append(field_fetch);
-      field_num++;
-    }
-  }
+  out.append(w.gen_fields_fetch(t, vars, is_flat, parser_type, field_num));
 
   out.append(w.gen_fetch_function_end(class_name != parent_class_name, field_num, vars, parser_type));
 }
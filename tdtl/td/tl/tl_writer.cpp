@@ -155,6 +155,19 @@ std::string TL_writer::gen_main_class_name(const tl_type *t) const {
   return gen_class_name(t->name);
 }
 
+std::string TL_writer::gen_fields_fetch(const tl_combinator *t, std::vector<var_description> &vars, bool flat,
+                                        int parser_type, int &field_num) const {
+  std::string result;
+  for (std::size_t i = 0; i < t->args.size(); i++) {
+    std::string field_fetch = gen_field_fetch(field_num, t->args[i], vars, flat, parser_type);
+    if (!field_fetch.empty()) {
+      result += field_fetch;
+      field_num++;
+    }
+  }
+  return result;
+}
+
 int TL_writer::get_parser_type(const tl_combinator *t, const std::string &parser_name) const {
   return t->var_count > 0;
 }
@@ -112,6 +112,8 @@ class TL_writer {
   virtual std::string gen_constructor_id_store(std::int32_t id, int storer_type) const = 0;
   virtual std::string gen_field_fetch(int field_num, const arg &a, std::vector<var_description> &vars, bool flat,
                                       int parser_type) const = 0;
+  virtual std::string gen_fields_fetch(const tl_combinator *t, std::vector<var_description> &vars, bool flat,
+                                       int parser_type, int &field_num) const;
   virtual std::string gen_field_store(const arg &a, std::vector<var_description> &vars, bool flat,
                                       int storer_type) const = 0;
   virtual std::string gen_type_fetch(const std::string &field_name, const tl_tree_type *tree_type,
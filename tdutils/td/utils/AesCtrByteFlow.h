@@ -29,8 +29,12 @@ class AesCtrByteFlow final : public ByteFlowInplaceBase {
   }
   bool loop() final {
     bool result = false;
-    auto ready = input_->prepare_read();
-    if (!ready.empty()) {
+    // process all available chunks at once instead of one chunk per wakeup
+    while (true) {
+      auto ready = input_->prepare_read();
+      if (ready.empty()) {
+        break;
+      }
       state_.encrypt(ready, MutableSlice(const_cast<char *>(ready.data()), ready.size()));
       input_->confirm_read(ready.size());
       output_.advance_end(ready.size());
@@ -80,6 +80,15 @@ Status AsyncFileLog::init(string path, int64 rotate_threshold, bool redirect_std
           }
         };
 
+        // consecutive log lines are written to the file at once
+        string buffer;
+        auto flush_buffer = [&] {
+          if (!buffer.empty()) {
+            append(buffer);
+            buffer.clear();
+          }
+        };
+
         while (true) {
           int ready_count = queue->reader_wait_nonblock();
           if (ready_count == 0) {
@@ -89,9 +98,19 @@ Status AsyncFileLog::init(string path, int64 rotate_threshold, bool redirect_std
           bool need_close = false;
           while (ready_count-- > 0) {
             Query query = queue->reader_get_unsafe();
+            if (query.type_ != Query::Type::Log) {
+              flush_buffer();
+            }
             switch (query.type_) {
               case Query::Type::Log:
-                append(query.data_);
+                if (buffer.empty() && query.data_.size() >= MAX_BUFFER_SIZE) {
+                  append(query.data_);
+                } else {
+                  buffer += query.data_;
+                  if (buffer.size() >= MAX_BUFFER_SIZE) {
+                    flush_buffer();
+                  }
+                }
                 break;
               case Query::Type::AfterRotation:
                 after_rotation();
@@ -103,6 +122,7 @@ Status AsyncFileLog::init(string path, int64 rotate_threshold, bool redirect_std
                 process_fatal_error("Invalid query type in AsyncFileLog");
             }
           }
+          flush_buffer();
           queue->reader_flush();
 
           if (need_close) {
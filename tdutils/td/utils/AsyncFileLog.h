@@ -29,6 +29,8 @@ class AsyncFileLog final : public LogInterface {
   Status init(string path, int64 rotate_threshold, bool redirect_stderr = true);
 
  private:
+  static constexpr size_t MAX_BUFFER_SIZE = 1 << 16;
+
   struct Query {
     enum class Type : int32 { Log, AfterRotation, Close };
     Type type_ = Type::Log;
@@ -38,6 +38,10 @@ class BufferedFdBase : public FdT {
     write_->sync_with_writer();
     return write_->size();
   }
+  // returns the number of writev calls made by flush_write
+  uint64 get_write_syscall_count() const {
+    return write_syscall_count_;
+  }
   void sync_with_poll() {
     ::td::sync_with_poll(*this);
   }
@@ -51,6 +55,7 @@ class BufferedFdBase : public FdT {
  private:
   ChainBufferWriter *read_ = nullptr;
   ChainBufferReader *write_ = nullptr;
+  uint64 write_syscall_count_ = 0;
 };
 
 template <class FdT>
@@ -118,12 +123,12 @@ Result<size_t> BufferedFdBase<FdT>::flush_write() {
   write_->sync_with_writer();
   size_t result = 0;
   while (!write_->empty() && ::td::can_write_local(*this)) {
-    constexpr size_t BUF_SIZE = 20;
-    IoSlice buf[BUF_SIZE];
+    // all pending chunks are written by a single call, unless there are too many of them
+    IoSlice buf[MAX_IO_SLICE_COUNT];
 
     auto it = write_->clone();
     size_t buf_i;
-    for (buf_i = 0; buf_i < BUF_SIZE; buf_i++) {
+    for (buf_i = 0; buf_i < MAX_IO_SLICE_COUNT; buf_i++) {
       Slice slice = it.prepare_read();
       if (slice.empty()) {
         break;
@@ -131,6 +136,7 @@ Result<size_t> BufferedFdBase<FdT>::flush_write() {
       buf[buf_i] = as_io_slice(slice);
       it.confirm_read(slice.size());
     }
+    write_syscall_count_++;
     TRY_RESULT(x, FdT::writev(Span<IoSlice>(buf, buf_i)));
     write_->advance(x);
     result += x;
@@ -11,6 +11,8 @@ char disable_linker_warning_about_empty_file_buffered_udp_cpp TD_UNUSED;
 namespace td {
 
 #if TD_PORT_POSIX
+constexpr size_t BufferedUdp::DEFAULT_BATCH_SIZE;
+
 TD_THREAD_LOCAL detail::UdpReader *BufferedUdp::udp_reader_;
 #endif
 
@@ -25,21 +25,82 @@ namespace td {
 namespace detail {
 class UdpWriter {
  public:
-  static Status write_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue) TD_WARN_UNUSED_RESULT {
-    std::array<UdpSocketFd::OutboundMessage, 16> messages;
+  static Status write_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue, size_t batch_size,
+                           string &buffer) TD_WARN_UNUSED_RESULT {
+    std::array<UdpSocketFd::OutboundMessage, UdpSocketFd::MAX_BATCH_SIZE> messages;
+    // number of queued messages sent as each of the messages
+    std::array<size_t, UdpSocketFd::MAX_BATCH_SIZE> message_counts;
     auto to_send = queue.as_span();
-    size_t to_send_n = td::min(messages.size(), to_send.size());
-    to_send.truncate(to_send_n);
-    for (size_t i = 0; i < to_send_n; i++) {
-      messages[i].to = &to_send[i].address;
-      messages[i].data = to_send[i].data.as_slice();
+    size_t to_send_n = 0;
+    size_t pos = 0;
+    size_t buffer_size = 0;
+    bool use_offload = fd.is_send_offload_enabled();
+    while (to_send_n < batch_size && pos < to_send.size()) {
+      auto segment_count = use_offload ? get_segment_count(to_send.substr(pos)) : 1;
+      messages[to_send_n].to = &to_send[pos].address;
+      if (segment_count > 1) {
+        messages[to_send_n].segment_size = to_send[pos].data.size();
+        for (size_t i = 0; i < segment_count; i++) {
+          buffer_size += to_send[pos + i].data.size();
+        }
+      } else {
+        messages[to_send_n].data = to_send[pos].data.as_slice();
+      }
+      message_counts[to_send_n] = segment_count;
+      pos += segment_count;
+      to_send_n++;
+    }
+
+    if (buffer_size != 0) {
+      // the buffer must not be reallocated after data of the messages is set
+      buffer.resize(buffer_size);
+      MutableSlice buffer_slice(buffer);
+      pos = 0;
+      for (size_t i = 0; i < to_send_n; i++) {
+        if (messages[i].segment_size != 0) {
+          auto *begin = buffer_slice.begin();
+          for (size_t j = 0; j < message_counts[i]; j++) {
+            auto data = to_send[pos + j].data.as_slice();
+            buffer_slice.copy_from(data);
+            buffer_slice.remove_prefix(data.size());
+          }
+          messages[i].data = Slice(begin, buffer_slice.begin());
+        }
+        pos += message_counts[i];
+      }
     }
 
     size_t cnt;
     auto status = fd.send_messages(Span<UdpSocketFd::OutboundMessage>(messages).truncate(to_send_n), cnt);
-    queue.pop_n(cnt);
+    size_t sent_n = 0;
+    for (size_t i = 0; i < cnt; i++) {
+      sent_n += message_counts[i];
+    }
+    queue.pop_n(sent_n);
     return status;
   }
+
+ private:
+  // returns number of the first messages, which can be sent as one message with segmentation offload
+  static size_t get_segment_count(Span<UdpMessage> messages) {
+    auto segment_size = messages[0].data.size();
+    size_t total_size = segment_size;
+    size_t count = 1;
+    while (count < messages.size() && count < UdpSocketFd::MAX_SEGMENT_COUNT) {
+      auto &message = messages[count];
+      if (message.data.size() > segment_size || message.data.empty() || !(message.address == messages[0].address) ||
+          total_size + message.data.size() > UdpSocketFd::MAX_SEGMENTED_MESSAGE_SIZE) {
+        break;
+      }
+      total_size += message.data.size();
+      count++;
+      if (message.data.size() < segment_size) {
+        // only the last segment can be shorter
+        break;
+      }
+    }
+    return count;
+  }
 };
 
 class UdpReaderHelper {
@@ -73,22 +134,22 @@ class UdpReaderHelper {
 // One for thread is enough
 class UdpReader {
  public:
-  UdpReader() {
-    for (size_t i = 0; i < messages_.size(); i++) {
-      helpers_[i].init_inbound_message(messages_[i]);
+  Status read_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue, size_t batch_size) TD_WARN_UNUSED_RESULT {
+    CHECK(batch_size <= messages_.size());
+    // buffers are allocated only for the used messages
+    for (; initialized_count_ < batch_size; initialized_count_++) {
+      helpers_[initialized_count_].init_inbound_message(messages_[initialized_count_]);
     }
-  }
-  Status read_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue) TD_WARN_UNUSED_RESULT {
-    for (auto &message : messages_) {
-      CHECK(message.data.size() == 2048);
+    for (size_t i = 0; i < batch_size; i++) {
+      CHECK(messages_[i].data.size() == 2048);
     }
     size_t cnt = 0;
-    auto status = fd.receive_messages(messages_, cnt);
+    auto status = fd.receive_messages(MutableSpan<UdpSocketFd::InboundMessage>(messages_).truncate(batch_size), cnt);
     for (size_t i = 0; i < cnt; i++) {
       queue.push(helpers_[i].extract_udp_message(messages_[i]));
       helpers_[i].init_inbound_message(messages_[i]);
     }
-    for (size_t i = cnt; i < messages_.size(); i++) {
+    for (size_t i = cnt; i < batch_size; i++) {
       LOG_CHECK(messages_[i].data.size() == 2048)
           << " cnt = " << cnt << " i = " << i << " size = " << messages_[i].data.size() << " status = " << status;
     }
@@ -100,9 +161,9 @@ class UdpReader {
   }
 
  private:
-  static constexpr size_t BUFFER_SIZE = 16;
-  std::array<UdpSocketFd::InboundMessage, BUFFER_SIZE> messages_;
-  std::array<UdpReaderHelper, BUFFER_SIZE> helpers_;
+  std::array<UdpSocketFd::InboundMessage, UdpSocketFd::MAX_BATCH_SIZE> messages_;
+  std::array<UdpReaderHelper, UdpSocketFd::MAX_BATCH_SIZE> helpers_;
+  size_t initialized_count_ = 0;
 };
 
 }  // namespace detail
@@ -115,6 +176,15 @@ class BufferedUdp final : public UdpSocketFd {
   }
 
 #if TD_PORT_POSIX
+  static constexpr size_t DEFAULT_BATCH_SIZE = 16;
+
+  // sets maximum number of datagrams received or sent by one system call;
+  // with enabled send offload, several datagrams to the same address are sent as one message
+  void set_batch_size(size_t batch_size) {
+    CHECK(1 <= batch_size && batch_size <= MAX_BATCH_SIZE);
+    batch_size_ = batch_size;
+  }
+
   void sync_with_poll() {
     ::td::sync_with_poll(*this);
   }
@@ -153,6 +223,8 @@ class BufferedUdp final : public UdpSocketFd {
 #if TD_PORT_POSIX
   VectorQueue<UdpMessage> input_;
   VectorQueue<UdpMessage> output_;
+  size_t batch_size_ = DEFAULT_BATCH_SIZE;
+  string send_buffer_;
 
   VectorQueue<UdpMessage> &input() {
     return input_;
@@ -162,12 +234,12 @@ class BufferedUdp final : public UdpSocketFd {
   }
 
   Status flush_send_once() TD_WARN_UNUSED_RESULT {
-    return detail::UdpWriter::write_once(as_fd(), output_);
+    return detail::UdpWriter::write_once(as_fd(), output_, batch_size_, send_buffer_);
   }
 
   Status flush_read_once() TD_WARN_UNUSED_RESULT {
     init_thread_local<detail::UdpReader>(udp_reader_);
-    return udp_reader_->read_once(as_fd(), input_);
+    return udp_reader_->read_once(as_fd(), input_, batch_size_);
   }
 
   static TD_THREAD_LOCAL detail::UdpReader *udp_reader_;
@@ -18,8 +18,6 @@
 #include "td/utils/StringBuilder.h"
 #include "td/utils/VectorQueue.h"
 
-#include <functional>
-
 namespace td {
 
 struct ChainSchedulerBase {
@@ -47,6 +45,26 @@ class ChainScheduler final : public ChainSchedulerBase {
 
   void reset_task(TaskId task_id);
 
+  // limits the number of simultaneously active tasks in a chain; 10 by default
+  void set_max_active_tasks_per_chain(uint32 max_active_tasks_per_chain) {
+    max_active_tasks_per_chain_ = td::max(max_active_tasks_per_chain, static_cast<uint32>(1));
+  }
+
+  // limits the total number of simultaneously active tasks; 0 if unlimited, which is the default
+  void set_max_active_tasks(size_t max_active_tasks);
+
+  size_t get_task_count() const {
+    return tasks_.size();
+  }
+
+  size_t get_active_task_count() const {
+    return active_task_count_;
+  }
+
+  size_t get_chain_count() const {
+    return chains_.size();
+  }
+
   template <class F>
   void for_each(F &&f) {
     tasks_.for_each([&f](uint64, Task &task) { f(task.extra); });
@@ -109,13 +127,15 @@ class ChainScheduler final : public ChainSchedulerBase {
       return head_.empty();
     }
 
-    void foreach(std::function<void(TaskId, uint64)> f) const {
+    template <class F>
+    void foreach(F &&f) const {
       for (auto it = head_.begin(); it != head_.end(); it = it->get_next()) {
         auto &node = static_cast<const ChainNode &>(*it);
         f(node.task_id, node.generation);
       }
     }
-    void foreach_child(ListNode *start_node, std::function<void(TaskId, uint64)> f) const {
+    template <class F>
+    void foreach_child(ListNode *start_node, F &&f) const {
       for (auto it = start_node; it != head_.end(); it = it->get_next()) {
         auto &node = static_cast<const ChainNode &>(*it);
         f(node.task_id, node.generation);
@@ -140,15 +160,27 @@ class ChainScheduler final : public ChainSchedulerBase {
     vector<TaskChainInfo> chains;
     ExtraT extra;
   };
+  static constexpr size_t MAX_FREE_CHAIN_INFOS = 256;
+
   FlatHashMap<ChainId, unique_ptr<ChainInfo>> chains_;
+  vector<unique_ptr<ChainInfo>> free_chain_infos_;  // to avoid reallocation of short-living chains
   FlatHashMap<ChainId, TaskId> limited_tasks_;
   Container<Task> tasks_;
   VectorQueue<TaskId> pending_tasks_;
+  VectorQueue<TaskId> globally_limited_tasks_;  // may contain already started or finished tasks
+  uint32 max_active_tasks_per_chain_ = 10;
+  size_t max_active_tasks_ = 0;
+  size_t active_task_count_ = 0;
 
   ChainInfo &get_chain_info(ChainId chain_id) {
     auto &chain = chains_[chain_id];
     if (chain == nullptr) {
-      chain = make_unique<ChainInfo>();
+      if (free_chain_infos_.empty()) {
+        chain = make_unique<ChainInfo>();
+      } else {
+        chain = std::move(free_chain_infos_.back());
+        free_chain_infos_.pop_back();
+      }
     }
     return *chain;
   }
@@ -168,12 +200,17 @@ class ChainScheduler final : public ChainSchedulerBase {
         }
       }
 
-      if (task_chain_info.chain_info->active_tasks >= 10) {
+      if (task_chain_info.chain_info->active_tasks >= max_active_tasks_per_chain_) {
         limited_tasks_[task_chain_info.chain_id] = task_id;
         return;
       }
     }
 
+    if (max_active_tasks_ != 0 && active_task_count_ >= max_active_tasks_) {
+      globally_limited_tasks_.push(task_id);
+      return;
+    }
+
     do_start_task(task_id, task);
   }
 
@@ -184,6 +221,7 @@ class ChainScheduler final : public ChainSchedulerBase {
       task_chain_info.chain_node.generation = chain_info.generation;
     }
     task->state = Task::State::Active;
+    active_task_count_++;
 
     pending_tasks_.push(task_id);
     for_each_child(task, [&](TaskId task_id) { try_start_task(task_id); });
@@ -206,6 +244,10 @@ class ChainScheduler final : public ChainSchedulerBase {
     CHECK(task != nullptr);
     bool was_active = task->state == Task::State::Active;
     task->state = Task::State::Pending;
+    if (was_active) {
+      CHECK(active_task_count_ > 0);
+      active_task_count_--;
+    }
     for (TaskChainInfo &task_chain_info : task->chains) {
       ChainInfo &chain_info = *task_chain_info.chain_info;
       if (was_active) {
@@ -238,7 +280,14 @@ class ChainScheduler final : public ChainSchedulerBase {
     auto &chain = task_chain_info.chain_info->chain;
     chain.finish_task(&task_chain_info.chain_node);
     if (chain.empty()) {
-      chains_.erase(task_chain_info.chain_id);
+      auto it = chains_.find(task_chain_info.chain_id);
+      CHECK(it != chains_.end());
+      if (free_chain_infos_.size() < MAX_FREE_CHAIN_INFOS) {
+        it->second->active_tasks = 0;
+        it->second->generation = 1;
+        free_chain_infos_.push_back(std::move(it->second));
+      }
+      chains_.erase(it);
     }
   }
 
@@ -255,6 +304,16 @@ class ChainScheduler final : public ChainSchedulerBase {
       try_start_task(task_id);
     }
     CHECK(to_start_.empty());
+    start_globally_limited_tasks();
+  }
+
+  void start_globally_limited_tasks() {
+    while (!globally_limited_tasks_.empty() && (max_active_tasks_ == 0 || active_task_count_ < max_active_tasks_)) {
+      auto task_id = globally_limited_tasks_.pop();
+      if (tasks_.get(task_id) != nullptr) {
+        try_start_task(task_id);
+      }
+    }
   }
 
   template <class ExtraTT>
@@ -344,6 +403,13 @@ void ChainScheduler<ExtraT>::reset_task(TaskId task_id) {
   flush_try_start_task();
 }
 
+template <class ExtraT>
+void ChainScheduler<ExtraT>::set_max_active_tasks(size_t max_active_tasks) {
+  CHECK(to_start_.empty());
+  max_active_tasks_ = max_active_tasks;
+  start_globally_limited_tasks();
+}
+
 template <class ExtraT>
 void ChainScheduler<ExtraT>::pause_task(TaskId task_id) {
   auto *task = tasks_.get(task_id);
@@ -101,6 +101,10 @@ class DelayedClosure {
     tuple_for_each(args, f);
   }
 
+  const FunctionT &get_function() const {
+    return std::get<0>(args);
+  }
+
  private:
   std::tuple<FunctionT, typename std::decay<ArgsT>::type...> args;
 
@@ -7,13 +7,14 @@
 #pragma once
 
 #include "td/utils/common.h"
-#include "td/utils/HazardPointers.h"
+#include "td/utils/EpochBasedMemoryReclamation.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/thread_local.h"
 
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <utility>
 
 namespace td {
 
@@ -93,16 +94,24 @@ class AtomicHashArray {
   std::vector<Node> nodes_;
 };
 
-// Simple concurrent hash map with multiple limitations
+// Resizable lock-free concurrent hash map, optimized for lookups
+//
+// Limitations:
+//  Keys must be random and distinct from KeyT{}, as for AtomicHashArray.
+//  Values can't be changed or erased after insertion and must be distinct from ValueT{} and ValueT(1).
+//  Insertions may wait for a concurrent resize of the table.
+//
+// Tables replaced during resize are reclaimed using EpochBasedMemoryReclamation, so the methods can be called from any
+// thread.
 template <class KeyT, class ValueT>
 class ConcurrentHashMap {
   using HashMap = AtomicHashArray<KeyT, std::atomic<ValueT>>;
-  static HazardPointers<HashMap> hp_;
+  using Reclamation = EpochBasedMemoryReclamation<HashMap>;
+  static Reclamation ebmr_;
 
  public:
   explicit ConcurrentHashMap(size_t n = 32) {
-    n = 1;
-    hash_map_.store(make_unique<HashMap>(n).release());
+    hash_map_.store(make_unique<HashMap>(td::max(n, static_cast<size_t>(1))).release());
   }
   ConcurrentHashMap(const ConcurrentHashMap &) = delete;
   ConcurrentHashMap &operator=(const ConcurrentHashMap &) = delete;
@@ -126,14 +135,16 @@ class ConcurrentHashMap {
     return (ValueT)(1);  // c-style conversion because reinterpret_cast<int>(1) is CE in MSVC
   }
 
+  // returns the inserted value or the value, which was inserted before
   ValueT insert(KeyT key, ValueT value) {
     CHECK(key != empty_key());
+    CHECK(value != empty_value());
     CHECK(value != migrate_value());
-    typename HazardPointers<HashMap>::Holder holder(hp_, get_thread_id(), 0);
+    typename Reclamation::Guard guard(ebmr_, detail::get_reclamation_thread_slot());
     while (true) {
-      auto hash_map = holder.protect(hash_map_);
+      auto hash_map = hash_map_.load();
       if (!hash_map) {
-        do_migrate(nullptr);
+        do_migrate(nullptr, guard);
         continue;
       }
 
@@ -157,16 +168,17 @@ class ConcurrentHashMap {
       if (ok) {
         return inserted_value;
       }
-      do_migrate(hash_map);
+      do_migrate(hash_map, guard);
     }
   }
 
+  // returns the value for the key or the specified default value if the key isn't found
   ValueT find(KeyT key, ValueT value) {
-    typename HazardPointers<HashMap>::Holder holder(hp_, get_thread_id(), 0);
+    typename Reclamation::Guard guard(ebmr_, detail::get_reclamation_thread_slot());
     while (true) {
-      auto hash_map = holder.protect(hash_map_);
+      auto hash_map = hash_map_.load();
       if (!hash_map) {
-        do_migrate(nullptr);
+        do_migrate(nullptr, guard);
         continue;
       }
 
@@ -175,27 +187,50 @@ class ConcurrentHashMap {
       if (!has_value || value != migrate_value()) {
         return value;
       }
-      do_migrate(hash_map);
+      do_migrate(hash_map, guard);
     }
   }
 
+  // calls f(key, value) for a snapshot of the map; values inserted concurrently may be skipped
   template <class F>
   void for_each(F &&f) {
-    auto hash_map = hash_map_.load();
-    CHECK(hash_map);
-    auto size = hash_map->size();
-    for (size_t i = 0; i < size; i++) {
-      auto &node = hash_map->node_at(i);
-      auto key = node.key.load(std::memory_order_relaxed);
-      auto value = node.value.load(std::memory_order_relaxed);
+    vector<std::pair<KeyT, ValueT>> values;
+    {
+      typename Reclamation::Guard guard(ebmr_, detail::get_reclamation_thread_slot());
+      while (true) {
+        auto hash_map = hash_map_.load();
+        if (!hash_map) {
+          do_migrate(nullptr, guard);
+          continue;
+        }
 
-      if (key != empty_key()) {
-        CHECK(value != migrate_value());
-        if (value != empty_value()) {
-          f(key, value);
+        values.clear();
+        bool is_migrating = false;
+        auto size = hash_map->size();
+        for (size_t i = 0; i < size; i++) {
+          auto &node = hash_map->node_at(i);
+          auto key = node.key.load(std::memory_order_relaxed);
+          if (key == empty_key()) {
+            continue;
+          }
+          auto value = node.value.load(std::memory_order_acquire);
+          if (value == migrate_value()) {
+            is_migrating = true;
+            break;
+          }
+          if (value != empty_value()) {
+            values.emplace_back(key, value);
+          }
         }
+        if (!is_migrating) {
+          break;
+        }
+        do_migrate(hash_map, guard);
       }
     }
+    for (auto &it : values) {
+      f(it.first, it.second);
+    }
   }
 
  private:
@@ -239,7 +274,7 @@ class ConcurrentHashMap {
   };
   TaskCreator task_creator;
 
-  void do_migrate(HashMap *ptr) {
+  void do_migrate(HashMap *ptr, typename Reclamation::Guard &guard) {
     //LOG(ERROR) << "In do_migrate: " << ptr;
     std::unique_lock<std::mutex> lock(migrate_mutex_);
     if (hash_map_.load() != ptr) {
@@ -256,15 +291,15 @@ class ConcurrentHashMap {
     lock.lock();
     migrate_cnt_--;
     if (migrate_cnt_ == 0) {
-      finish_migrate();
+      finish_migrate(guard);
     }
     migrate_cv_.wait(lock, [&] { return migrate_generation_ != migrate_generation; });
   }
 
-  void finish_migrate() {
+  void finish_migrate(typename Reclamation::Guard &guard) {
     //LOG(ERROR) << "In finish_migrate";
     hash_map_.store(migrate_to_hash_map_);
-    hp_.retire(get_thread_id(), migrate_from_hash_map_);
+    guard.retire(migrate_from_hash_map_);
     migrate_from_hash_map_ = nullptr;
     migrate_to_hash_map_ = nullptr;
     migrate_generation_++;
@@ -304,7 +339,7 @@ class ConcurrentHashMap {
     for (auto i = task.begin; i < task.end; i++) {
       auto &node = migrate_from_hash_map_->node_at(i);
       auto old_value = node.value.exchange(migrate_value(), std::memory_order_acq_rel);
-      if (old_value == 0) {
+      if (old_value == empty_value()) {
         continue;
       }
       auto node_key = node.key.load(std::memory_order_relaxed);
@@ -316,6 +351,6 @@ class ConcurrentHashMap {
 };
 
 template <class KeyT, class ValueT>
-HazardPointers<typename ConcurrentHashMap<KeyT, ValueT>::HashMap> ConcurrentHashMap<KeyT, ValueT>::hp_(64);
+typename ConcurrentHashMap<KeyT, ValueT>::Reclamation ConcurrentHashMap<KeyT, ValueT>::ebmr_(TD_MAX_THREAD_COUNT);
 
 }  // namespace td
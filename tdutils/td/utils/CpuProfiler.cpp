@@ -0,0 +1,224 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/CpuProfiler.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/port/config.h"
+#include "td/utils/port/platform.h"
+
+#define TD_HAVE_CPU_PROFILER (TD_PORT_POSIX && !TD_EMSCRIPTEN)
+
+#if TD_HAVE_CPU_PROFILER
+#include <cerrno>
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+namespace td {
+
+TD_THREAD_LOCAL const char *CpuProfiler::label_kind_ = nullptr;
+TD_THREAD_LOCAL int32 CpuProfiler::label_id_ = 0;
+
+#if TD_HAVE_CPU_PROFILER
+namespace {
+
+constexpr size_t MAX_ACTOR_NAME_SIZE = 48;
+constexpr size_t SAMPLE_TABLE_SIZE = 1 << 12;
+constexpr size_t MAX_PROBE_COUNT = 32;
+
+// samples are stored from the signal handler, so the table is a fixed-size lock-free open addressing hash table
+struct CpuSampleSlot {
+  std::atomic<uint64> hash{0};
+  std::atomic<bool> is_ready{false};
+  std::atomic<uint64> sample_count{0};
+  char actor_name[MAX_ACTOR_NAME_SIZE];
+  const char *label_kind = nullptr;
+  int32 label_id = 0;
+};
+
+std::mutex cpu_profiler_mutex;
+std::atomic<int32> cpu_profiler_frequency{0};
+std::atomic<uint64> cpu_profiler_dropped_sample_count{0};
+std::atomic<CpuSampleSlot *> cpu_sample_table{nullptr};  // allocated once and never freed
+
+uint64 get_cpu_sample_hash(const char *actor_name, const char *label_kind, int32 label_id) {
+  uint64 hash = 14695981039346656037ull;
+  auto add = [&hash](uint64 value) {
+    hash ^= value;
+    hash *= 1099511628211ull;
+  };
+  if (actor_name != nullptr) {
+    for (size_t i = 0; i + 1 < MAX_ACTOR_NAME_SIZE && actor_name[i] != '\0'; i++) {
+      add(static_cast<unsigned char>(actor_name[i]));
+    }
+  }
+  add(static_cast<uint64>(reinterpret_cast<std::uintptr_t>(label_kind)));
+  add(static_cast<uint32>(label_id));
+  return hash == 0 ? 1 : hash;
+}
+
+void on_cpu_profiler_signal(int signal) {
+  auto saved_errno = errno;
+  auto *table = cpu_sample_table.load(std::memory_order_acquire);
+  if (table != nullptr && cpu_profiler_frequency.load(std::memory_order_relaxed) != 0) {
+    const char *actor_name = Logger::tag2_;
+    const char *label_kind = CpuProfiler::label_kind_;
+    int32 label_id = label_kind == nullptr ? 0 : CpuProfiler::label_id_;
+    auto hash = get_cpu_sample_hash(actor_name, label_kind, label_id);
+    bool is_stored = false;
+    for (size_t i = 0; i < MAX_PROBE_COUNT && !is_stored; i++) {
+      auto &slot = table[(hash + i) % SAMPLE_TABLE_SIZE];
+      auto slot_hash = slot.hash.load(std::memory_order_acquire);
+      if (slot_hash == 0) {
+        if (!slot.hash.compare_exchange_strong(slot_hash, hash, std::memory_order_acq_rel)) {
+          if (slot_hash != hash) {
+            continue;
+          }
+        } else {
+          std::memset(slot.actor_name, 0, sizeof(slot.actor_name));
+          if (actor_name != nullptr) {
+            std::strncpy(slot.actor_name, actor_name, MAX_ACTOR_NAME_SIZE - 1);
+          }
+          slot.label_kind = label_kind;
+          slot.label_id = label_id;
+          slot.is_ready.store(true, std::memory_order_release);
+        }
+      } else if (slot_hash != hash) {
+        continue;
+      }
+      slot.sample_count.fetch_add(1, std::memory_order_relaxed);
+      is_stored = true;
+    }
+    if (!is_stored) {
+      cpu_profiler_dropped_sample_count.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  errno = saved_errno;
+}
+
+}  // namespace
+#endif
+
+bool CpuProfiler::is_supported() {
+#if TD_HAVE_CPU_PROFILER
+  return true;
+#else
+  return false;
+#endif
+}
+
+Status CpuProfiler::set_frequency(int32 frequency) {
+#if TD_HAVE_CPU_PROFILER
+  if (frequency < 0 || frequency > 10000) {
+    return Status::Error("Invalid sampling frequency specified");
+  }
+  std::lock_guard<std::mutex> lock(cpu_profiler_mutex);
+  if (frequency == 0) {
+    if (cpu_profiler_frequency.load(std::memory_order_relaxed) != 0) {
+      struct itimerval timer;
+      std::memset(&timer, 0, sizeof(timer));
+      setitimer(ITIMER_PROF, &timer, nullptr);
+      cpu_profiler_frequency = 0;
+    }
+    return Status::OK();
+  }
+
+  auto *table = cpu_sample_table.load(std::memory_order_relaxed);
+  if (table == nullptr) {
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = on_cpu_profiler_signal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) {
+      return OS_ERROR("Failed to set SIGPROF handler");
+    }
+    cpu_sample_table = new CpuSampleSlot[SAMPLE_TABLE_SIZE];
+  } else if (cpu_profiler_frequency.load(std::memory_order_relaxed) == 0) {
+    // the timer is stopped, so the table can be cleared
+    for (size_t i = 0; i < SAMPLE_TABLE_SIZE; i++) {
+      table[i].is_ready = false;
+      table[i].sample_count = 0;
+      table[i].hash = 0;
+    }
+    cpu_profiler_dropped_sample_count = 0;
+  }
+
+  cpu_profiler_frequency = frequency;
+  struct itimerval timer;
+  timer.it_interval.tv_sec = 0;
+  timer.it_interval.tv_usec = static_cast<decltype(timer.it_interval.tv_usec)>(std::max(1000000 / frequency, 100));
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+    cpu_profiler_frequency = 0;
+    return OS_ERROR("Failed to start profiling timer");
+  }
+  return Status::OK();
+#else
+  return Status::Error("CPU profiler is unsupported on the platform");
+#endif
+}
+
+int32 CpuProfiler::get_frequency() {
+#if TD_HAVE_CPU_PROFILER
+  return cpu_profiler_frequency.load(std::memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
+
+vector<CpuProfiler::Entry> CpuProfiler::get_statistics() {
+  vector<Entry> result;
+#if TD_HAVE_CPU_PROFILER
+  std::lock_guard<std::mutex> lock(cpu_profiler_mutex);
+  auto *table = cpu_sample_table.load(std::memory_order_acquire);
+  if (table == nullptr) {
+    return result;
+  }
+  for (size_t i = 0; i < SAMPLE_TABLE_SIZE; i++) {
+    auto &slot = table[i];
+    if (!slot.is_ready.load(std::memory_order_acquire)) {
+      continue;
+    }
+    auto sample_count = slot.sample_count.load(std::memory_order_relaxed);
+    if (sample_count == 0) {
+      continue;
+    }
+    Entry entry;
+    entry.actor_name = slot.actor_name;
+    if (slot.label_kind != nullptr) {
+      entry.label_kind = slot.label_kind;
+      entry.label_id = slot.label_id;
+    }
+    entry.sample_count = sample_count;
+    result.push_back(std::move(entry));
+  }
+  std::sort(result.begin(), result.end(), [](const Entry &lhs, const Entry &rhs) {
+    if (lhs.sample_count != rhs.sample_count) {
+      return lhs.sample_count > rhs.sample_count;
+    }
+    return lhs.actor_name < rhs.actor_name;
+  });
+#endif
+  return result;
+}
+
+uint64 CpuProfiler::get_dropped_sample_count() {
+#if TD_HAVE_CPU_PROFILER
+  return cpu_profiler_dropped_sample_count.load(std::memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
+
+}  // namespace td
@@ -0,0 +1,67 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+// sampling CPU profiler, which groups samples by the name of the current actor and the current label
+// the actor name is taken from LOG_TAG2, which is set by the scheduler
+class CpuProfiler {
+ public:
+  struct Entry {
+    string actor_name;
+    string label_kind;
+    int32 label_id = 0;
+    uint64 sample_count = 0;
+  };
+
+  // marks the operation, which is executed by the current thread till the label is destroyed, for example,
+  // processing of a request with the specified TL constructor identifier; the kind must be a string literal
+  class Label {
+   public:
+    Label(const char *kind, int32 id) : saved_kind_(label_kind_), saved_id_(label_id_) {
+      label_id_ = id;
+      label_kind_ = kind;
+    }
+    Label(const Label &) = delete;
+    Label &operator=(const Label &) = delete;
+    Label(Label &&) = delete;
+    Label &operator=(Label &&) = delete;
+    ~Label() {
+      label_kind_ = saved_kind_;
+      label_id_ = saved_id_;
+    }
+
+   private:
+    const char *saved_kind_;
+    int32 saved_id_;
+  };
+
+  static bool is_supported();
+
+  // takes approximately frequency samples per second of consumed CPU time; 0 disables the profiler
+  // previously collected samples are dropped when the profiler is enabled
+  static Status set_frequency(int32 frequency) TD_WARN_UNUSED_RESULT;
+
+  static int32 get_frequency();
+
+  // returns collected samples sorted by decreasing sample count
+  static vector<Entry> get_statistics();
+
+  // returns number of samples, which were dropped because there were too many different labels
+  static uint64 get_dropped_sample_count();
+
+  // the current label of the thread; can be read by external samplers
+  static TD_THREAD_LOCAL const char *label_kind_;
+  static TD_THREAD_LOCAL int32 label_id_;
+};
+
+}  // namespace td
@@ -0,0 +1,79 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/EpochBasedMemoryReclamation.h"
+
+#include "td/utils/ExitGuard.h"
+#include "td/utils/port/thread_local.h"
+
+#include <mutex>
+#include <set>
+
+namespace td {
+namespace detail {
+
+class ReclamationThreadSlotManager {
+ public:
+  size_t register_thread() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (unused_slots_.empty()) {
+      LOG_CHECK(next_slot_ < static_cast<size_t>(TD_MAX_THREAD_COUNT)) << "Too many threads use memory reclamation";
+      return next_slot_++;
+    }
+    auto it = unused_slots_.begin();
+    auto result = *it;
+    unused_slots_.erase(it);
+    return result;
+  }
+
+  void unregister_thread(size_t slot) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    CHECK(slot < next_slot_);
+    bool is_inserted = unused_slots_.insert(slot).second;
+    CHECK(is_inserted);
+  }
+
+ private:
+  std::mutex mutex_;
+  std::set<size_t> unused_slots_;
+  size_t next_slot_ = 0;
+};
+static ReclamationThreadSlotManager reclamation_thread_slot_manager;
+static ExitGuard exit_guard;
+
+// slot + 1 of the current thread or 0 if the thread has no slot
+static TD_THREAD_LOCAL size_t reclamation_thread_slot;
+
+class ReclamationThreadSlotGuard {
+ public:
+  ReclamationThreadSlotGuard() : slot_(reclamation_thread_slot_manager.register_thread()) {
+    reclamation_thread_slot = slot_ + 1;
+  }
+  ReclamationThreadSlotGuard(const ReclamationThreadSlotGuard &) = delete;
+  ReclamationThreadSlotGuard &operator=(const ReclamationThreadSlotGuard &) = delete;
+  ReclamationThreadSlotGuard(ReclamationThreadSlotGuard &&) = delete;
+  ReclamationThreadSlotGuard &operator=(ReclamationThreadSlotGuard &&) = delete;
+  ~ReclamationThreadSlotGuard() {
+    reclamation_thread_slot = 0;
+    if (!ExitGuard::is_exited()) {
+      reclamation_thread_slot_manager.unregister_thread(slot_);
+    }
+  }
+
+ private:
+  size_t slot_;
+};
+
+size_t get_reclamation_thread_slot() {
+  if (unlikely(reclamation_thread_slot == 0)) {
+    // a C++11 thread_local is used, because its destructor is called on exit of any thread, not only of td::thread
+    static thread_local ReclamationThreadSlotGuard guard;
+  }
+  return reclamation_thread_slot - 1;
+}
+
+}  // namespace detail
+}  // namespace td
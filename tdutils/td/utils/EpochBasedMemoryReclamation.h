@@ -15,6 +15,13 @@
 
 namespace td {
 
+namespace detail {
+// returns an index of the current thread, which is less than TD_MAX_THREAD_COUNT and isn't used by other running
+// threads; unlike get_thread_id(), it is registered on first use, so it is distinct also for threads, which weren't
+// created by td::thread, for example for threads of inline clients
+size_t get_reclamation_thread_slot();
+}  // namespace detail
+
 template <class T>
 class EpochBasedMemoryReclamation {
  public:
@@ -72,6 +79,30 @@ class EpochBasedMemoryReclamation {
     std::unique_ptr<EpochBasedMemoryReclamation, Never> ebmr_;
   };
 
+  // protects pointers during one short operation; unlike Locker, doesn't wait for retired pointers on destruction,
+  // so the pointers retired through it are deleted during subsequent operations of the same thread
+  class Guard {
+   public:
+    Guard(EpochBasedMemoryReclamation &ebmr, size_t thread_id) : thread_id_(thread_id), ebmr_(ebmr) {
+      ebmr_.lock(thread_id_);
+    }
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+    Guard(Guard &&) = delete;
+    Guard &operator=(Guard &&) = delete;
+    ~Guard() {
+      ebmr_.unlock(thread_id_);
+    }
+
+    void retire(T *ptr) {
+      ebmr_.retire(thread_id_, ptr);
+    }
+
+   private:
+    size_t thread_id_;
+    EpochBasedMemoryReclamation &ebmr_;
+  };
+
   explicit EpochBasedMemoryReclamation(size_t threads_n) : threads_(threads_n) {
   }
 
@@ -542,7 +542,7 @@ class FlatHashTableChunks {
   void erase_node(NodeIterator it) {
     DCHECK(!it->empty());
     size_t empty_i = it - nodes_.begin();
-    DCHECK(0 <= empty_i && empty_i < nodes_.size());
+    DCHECK(empty_i < nodes_.size());
     auto empty_chunk_i = empty_i / Chunk::CHUNK_SIZE;
     auto hash = calc_hash(it->key());
     auto chunk_it = get_chunk_it(hash.chunk_i);
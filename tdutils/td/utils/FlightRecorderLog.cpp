@@ -0,0 +1,117 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/FlightRecorderLog.h"
+
+#include "td/utils/SliceBuilder.h"
+
+#include <cstring>
+
+namespace td {
+
+FlightRecorderLog::FlightRecorderLog(size_t thread_buffer_size) : thread_buffer_size_(thread_buffer_size) {
+  CHECK(thread_buffer_size_ > 0);
+}
+
+void FlightRecorderLog::dump() {
+  auto *log = get_log();
+  if (log == nullptr) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> dump_guard(dump_mutex_);
+  string data;
+  for (size_t thread_id = 0; thread_id < buffers_.size(); thread_id++) {
+    auto &buffer = buffers_[thread_id];
+    data.clear();
+    {
+      std::lock_guard<std::mutex> guard(buffer.mutex);
+      if (buffer.write_pos == buffer.dump_pos) {
+        continue;
+      }
+      auto begin_pos = buffer.dump_pos;
+      bool is_truncated = false;
+      if (buffer.write_pos - begin_pos > thread_buffer_size_) {
+        begin_pos = buffer.write_pos - thread_buffer_size_;
+        is_truncated = true;
+      }
+      auto size = static_cast<size_t>(buffer.write_pos - begin_pos);
+      auto offset = static_cast<size_t>(begin_pos % thread_buffer_size_);
+      auto first_size = td::min(size, thread_buffer_size_ - offset);
+      data.append(&buffer.data[offset], first_size);
+      data.append(&buffer.data[0], size - first_size);
+      buffer.dump_pos = buffer.write_pos;
+
+      if (is_truncated) {
+        // skip the partially overwritten message
+        auto line_end = data.find('\n');
+        data.erase(0, line_end == string::npos ? data.size() : line_end + 1);
+      }
+    }
+    if (!data.empty()) {
+      log->do_append(VERBOSITY_NAME(INFO), PSLICE() << "!!! Recorded log of thread " << thread_id << " !!!\n");
+      log->do_append(VERBOSITY_NAME(INFO), data);
+      log->do_append(VERBOSITY_NAME(INFO), PSLICE() << "!!! End of recorded log of thread " << thread_id << " !!!\n");
+    }
+  }
+}
+
+void FlightRecorderLog::clear() {
+  for (auto &buffer : buffers_) {
+    std::lock_guard<std::mutex> guard(buffer.mutex);
+    buffer.dump_pos = buffer.write_pos;
+  }
+}
+
+void FlightRecorderLog::after_rotation() {
+  auto *log = get_log();
+  if (log != nullptr) {
+    log->after_rotation();
+  }
+}
+
+vector<string> FlightRecorderLog::get_file_paths() {
+  auto *log = get_log();
+  if (log == nullptr) {
+    return {};
+  }
+  return log->get_file_paths();
+}
+
+void FlightRecorderLog::do_append(int log_level, CSlice slice) {
+  if (log_level <= VERBOSITY_NAME(ERROR)) {
+    dump();
+  }
+  if (log_level <= get_log_verbosity_level()) {
+    auto *log = get_log();
+    if (log != nullptr) {
+      log->do_append(log_level, slice);
+    }
+    return;
+  }
+
+  auto thread_id = get_thread_id();
+  CHECK(0 <= thread_id && static_cast<size_t>(thread_id) < buffers_.size());
+  record(buffers_[thread_id], slice);
+}
+
+void FlightRecorderLog::record(ThreadBuffer &buffer, Slice slice) {
+  if (slice.size() > thread_buffer_size_) {
+    slice.remove_prefix(slice.size() - thread_buffer_size_);
+  }
+
+  std::lock_guard<std::mutex> guard(buffer.mutex);
+  if (buffer.data.empty()) {
+    buffer.data.resize(thread_buffer_size_);
+  }
+  auto offset = static_cast<size_t>(buffer.write_pos % thread_buffer_size_);
+  auto first_size = td::min(slice.size(), thread_buffer_size_ - offset);
+  std::memcpy(&buffer.data[offset], slice.data(), first_size);
+  std::memcpy(&buffer.data[0], slice.data() + first_size, slice.size() - first_size);
+  buffer.write_pos += slice.size();
+}
+
+}  // namespace td
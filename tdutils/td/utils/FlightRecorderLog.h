@@ -0,0 +1,74 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Slice.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+namespace td {
+
+// Writes messages with verbosity level up to the log verbosity level to the underlying log and keeps more verbose
+// messages in per-thread in-memory ring buffers. The kept messages are written to the underlying log by dump() and
+// automatically before any message with verbosity level up to VERBOSITY_NAME(ERROR).
+class FlightRecorderLog final : public LogInterface {
+ public:
+  static constexpr size_t DEFAULT_THREAD_BUFFER_SIZE = 1 << 16;
+
+  explicit FlightRecorderLog(size_t thread_buffer_size = DEFAULT_THREAD_BUFFER_SIZE);
+
+  void set_log(LogInterface *log) {
+    log_.store(log, std::memory_order_release);
+  }
+
+  LogInterface *get_log() const {
+    return log_.load(std::memory_order_acquire);
+  }
+
+  void set_log_verbosity_level(int new_verbosity_level) {
+    log_verbosity_level_.store(new_verbosity_level, std::memory_order_relaxed);
+  }
+
+  int get_log_verbosity_level() const {
+    return log_verbosity_level_.load(std::memory_order_relaxed);
+  }
+
+  // writes all messages recorded since the previous dump to the underlying log
+  void dump();
+
+  // forgets all recorded messages
+  void clear();
+
+  void after_rotation() final;
+
+  vector<string> get_file_paths() final;
+
+  void do_append(int log_level, CSlice slice) final;
+
+ private:
+  struct ThreadBuffer {
+    std::mutex mutex;
+    string data;
+    uint64 write_pos = 0;
+    uint64 dump_pos = 0;
+  };
+
+  size_t thread_buffer_size_;
+  std::atomic<LogInterface *> log_{nullptr};
+  std::atomic<int> log_verbosity_level_{VERBOSITY_NAME(ERROR)};
+  std::array<ThreadBuffer, TD_MAX_THREAD_COUNT> buffers_;
+  std::mutex dump_mutex_;
+
+  void record(ThreadBuffer &buffer, Slice slice);
+};
+
+}  // namespace td
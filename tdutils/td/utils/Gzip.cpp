@@ -9,6 +9,7 @@
 char disable_linker_warning_about_empty_file_gzip_cpp TD_UNUSED;
 
 #if TD_HAVE_ZLIB
+#include "td/utils/port/thread_local.h"
 #include "td/utils/SliceBuilder.h"
 
 #include <cstring>
@@ -22,24 +23,82 @@ namespace td {
 class Gzip::Impl {
  public:
   z_stream stream_;
+  Mode mode_ = Mode::Empty;  // the mode for which the stream is initialized
 
   // z_stream is not copyable nor movable
-  Impl() = default;
+  Impl() {
+    std::memset(&stream_, 0, sizeof(stream_));
+  }
   Impl(const Impl &) = delete;
   Impl &operator=(const Impl &) = delete;
   Impl(Impl &&) = delete;
   Impl &operator=(Impl &&) = delete;
-  ~Impl() = default;
+  ~Impl() {
+    if (mode_ == Mode::Decode) {
+      inflateEnd(&stream_);
+    } else if (mode_ == Mode::Encode) {
+      deflateEnd(&stream_);
+    }
+  }
 };
 
+class Gzip::ImplPool {
+ public:
+  static constexpr size_t MAX_SIZE = 2;
+
+  static ImplPool &get() {
+    static TD_THREAD_LOCAL ImplPool *pool;
+    init_thread_local<ImplPool>(pool);
+    return *pool;
+  }
+
+  vector<unique_ptr<Impl>> &get_impls(Mode mode) {
+    return mode == Mode::Encode ? encoders_ : decoders_;
+  }
+
+ private:
+  vector<unique_ptr<Impl>> encoders_;
+  vector<unique_ptr<Impl>> decoders_;
+};
+
+unique_ptr<Gzip::Impl> Gzip::acquire_impl(Mode mode) {
+  auto &impls = ImplPool::get().get_impls(mode);
+  if (impls.empty()) {
+    return nullptr;
+  }
+  auto impl = std::move(impls.back());
+  impls.pop_back();
+  auto ret = mode == Mode::Encode ? deflateReset(&impl->stream_) : inflateReset(&impl->stream_);
+  if (ret != Z_OK) {
+    return nullptr;
+  }
+  return impl;
+}
+
+void Gzip::release_impl(unique_ptr<Impl> impl) {
+  CHECK(impl != nullptr);
+  CHECK(impl->mode_ != Mode::Empty);
+  auto &impls = ImplPool::get().get_impls(impl->mode_);
+  if (impls.size() < ImplPool::MAX_SIZE) {
+    impls.push_back(std::move(impl));
+  }
+}
+
 Status Gzip::init_encode() {
   CHECK(mode_ == Mode::Empty);
   init_common();
   mode_ = Mode::Encode;
+  auto impl = acquire_impl(mode_);
+  if (impl != nullptr) {
+    impl_ = std::move(impl);
+    return Status::OK();
+  }
   int ret = deflateInit2(&impl_->stream_, 6, Z_DEFLATED, 15, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY);
   if (ret != Z_OK) {
+    mode_ = Mode::Empty;
     return Status::Error(PSLICE() << "zlib deflate init failed: " << ret);
   }
+  impl_->mode_ = mode_;
   return Status::OK();
 }
 
@@ -47,10 +106,17 @@ Status Gzip::init_decode() {
   CHECK(mode_ == Mode::Empty);
   init_common();
   mode_ = Mode::Decode;
+  auto impl = acquire_impl(mode_);
+  if (impl != nullptr) {
+    impl_ = std::move(impl);
+    return Status::OK();
+  }
   int ret = inflateInit2(&impl_->stream_, MAX_WBITS + 32);
   if (ret != Z_OK) {
+    mode_ = Mode::Empty;
     return Status::Error(PSLICE() << "zlib inflate init failed: " << ret);
   }
+  impl_->mode_ = mode_;
   return Status::OK();
 }
 
@@ -103,6 +169,7 @@ size_t Gzip::left_output() const {
 }
 
 void Gzip::init_common() {
+  CHECK(impl_->mode_ == Mode::Empty);
   std::memset(&impl_->stream_, 0, sizeof(impl_->stream_));
   impl_->stream_.zalloc = Z_NULL;
   impl_->stream_.zfree = Z_NULL;
@@ -119,10 +186,18 @@ void Gzip::init_common() {
 }
 
 void Gzip::clear() {
-  if (mode_ == Mode::Decode) {
-    inflateEnd(&impl_->stream_);
-  } else if (mode_ == Mode::Encode) {
-    deflateEnd(&impl_->stream_);
+  if (mode_ != Mode::Empty) {
+    CHECK(impl_->mode_ == mode_);
+    // keep left_input() and left_output() for the caller, but release the stream itself
+    auto impl = make_unique<Impl>();
+    impl->stream_.avail_in = impl_->stream_.avail_in;
+    impl->stream_.avail_out = impl_->stream_.avail_out;
+    impl_->stream_.avail_in = 0;
+    impl_->stream_.next_in = nullptr;
+    impl_->stream_.avail_out = 0;
+    impl_->stream_.next_out = nullptr;
+    release_impl(std::move(impl_));
+    impl_ = std::move(impl);
   }
   mode_ = Mode::Empty;
 }
@@ -184,25 +259,172 @@ BufferSlice gzdecode(Slice s) {
   return message.extract_reader().move_as_buffer_slice();
 }
 
+namespace {
+
+// deflate stream, which is reset instead of being recreated for each message to avoid expensive reallocation
+// and initialization of its internal buffers
+class ReusableGzipEncoder {
+ public:
+  ReusableGzipEncoder(int window_bits, int mem_level) {
+    std::memset(&stream_, 0, sizeof(stream_));
+    stream_.zalloc = Z_NULL;
+    stream_.zfree = Z_NULL;
+    stream_.opaque = Z_NULL;
+    is_inited_ = deflateInit2(&stream_, 6, Z_DEFLATED, window_bits, mem_level, Z_DEFAULT_STRATEGY) == Z_OK;
+    CHECK(is_inited_);
+  }
+  ReusableGzipEncoder(const ReusableGzipEncoder &) = delete;
+  ReusableGzipEncoder &operator=(const ReusableGzipEncoder &) = delete;
+  ReusableGzipEncoder(ReusableGzipEncoder &&) = delete;
+  ReusableGzipEncoder &operator=(ReusableGzipEncoder &&) = delete;
+  ~ReusableGzipEncoder() {
+    if (is_inited_) {
+      deflateEnd(&stream_);
+    }
+  }
+
+  BufferSlice encode(Slice s, double max_compression_ratio) {
+    CHECK(s.size() <= std::numeric_limits<uInt>::max());
+    auto max_size = static_cast<size_t>(static_cast<double>(s.size()) * max_compression_ratio);
+    BufferWriter message{max_size};
+    auto output = message.prepare_append();
+
+    if (deflateReset(&stream_) != Z_OK) {
+      return BufferSlice();
+    }
+    stream_.avail_in = static_cast<uInt>(s.size());
+    stream_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(s.data()));
+    stream_.avail_out = static_cast<uInt>(output.size());
+    stream_.next_out = reinterpret_cast<Bytef *>(output.data());
+    auto ret = deflate(&stream_, Z_FINISH);
+    auto used_output = output.size() - stream_.avail_out;
+    stream_.avail_in = 0;
+    stream_.next_in = nullptr;
+    stream_.avail_out = 0;
+    stream_.next_out = nullptr;
+    if (ret != Z_STREAM_END) {
+      // the output buffer is too small or an error occurred
+      return BufferSlice();
+    }
+    message.confirm_append(used_output);
+    return message.as_buffer_slice();
+  }
+
+ private:
+  z_stream stream_;
+  bool is_inited_ = false;
+};
+
+}  // namespace
+
 BufferSlice gzencode(Slice s, double max_compression_ratio) {
-  Gzip gzip;
-  gzip.init_encode().ensure();
-  gzip.set_input(s);
-  gzip.close_input();
-  auto max_size = static_cast<size_t>(static_cast<double>(s.size()) * max_compression_ratio);
-  BufferWriter message{max_size};
-  gzip.set_output(message.prepare_append());
-  auto r_state = gzip.run();
-  if (r_state.is_error()) {
-    return BufferSlice();
+  // the window covering the whole input gives the same compression, but smaller state is faster to reset
+  constexpr size_t SMALL_INPUT_SIZE = 1 << 12;
+  if (s.size() <= SMALL_INPUT_SIZE) {
+    static TD_THREAD_LOCAL ReusableGzipEncoder *small_encoder;
+    init_thread_local<ReusableGzipEncoder>(small_encoder, 12, 7);
+    return small_encoder->encode(s, max_compression_ratio);
+  }
+  static TD_THREAD_LOCAL ReusableGzipEncoder *encoder;
+  init_thread_local<ReusableGzipEncoder>(encoder, 15, MAX_MEM_LEVEL);
+  return encoder->encode(s, max_compression_ratio);
+}
+
+namespace {
+
+class RawDeflateStream {
+ public:
+  explicit RawDeflateStream(bool is_encoder) : is_encoder_(is_encoder) {
+    std::memset(&stream_, 0, sizeof(stream_));
+    stream_.zalloc = Z_NULL;
+    stream_.zfree = Z_NULL;
+    stream_.opaque = Z_NULL;
+    if (is_encoder_) {
+      is_inited_ = deflateInit2(&stream_, 6, Z_DEFLATED, -15, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) == Z_OK;
+    } else {
+      is_inited_ = inflateInit2(&stream_, -15) == Z_OK;
+    }
+    CHECK(is_inited_);
   }
-  auto state = r_state.ok();
-  if (state != Gzip::State::Done) {
+  RawDeflateStream(const RawDeflateStream &) = delete;
+  RawDeflateStream &operator=(const RawDeflateStream &) = delete;
+  RawDeflateStream(RawDeflateStream &&) = delete;
+  RawDeflateStream &operator=(RawDeflateStream &&) = delete;
+  ~RawDeflateStream() {
+    if (is_inited_) {
+      if (is_encoder_) {
+        deflateEnd(&stream_);
+      } else {
+        inflateEnd(&stream_);
+      }
+    }
+  }
+
+  // returns number of written bytes or -1 if the output buffer is too small or the input is invalid
+  int64 run(Slice input, Slice dictionary, MutableSlice output) {
+    CHECK(input.size() <= std::numeric_limits<uInt>::max());
+    CHECK(dictionary.size() <= std::numeric_limits<uInt>::max());
+    CHECK(output.size() <= std::numeric_limits<uInt>::max());
+    auto dictionary_data = reinterpret_cast<const Bytef *>(dictionary.data());
+    auto dictionary_size = static_cast<uInt>(dictionary.size());
+    if (is_encoder_) {
+      if (deflateReset(&stream_) != Z_OK ||
+          (!dictionary.empty() && deflateSetDictionary(&stream_, dictionary_data, dictionary_size) != Z_OK)) {
+        return -1;
+      }
+    } else {
+      // a raw inflate stream accepts the dictionary before any input
+      if (inflateReset(&stream_) != Z_OK ||
+          (!dictionary.empty() && inflateSetDictionary(&stream_, dictionary_data, dictionary_size) != Z_OK)) {
+        return -1;
+      }
+    }
+    stream_.avail_in = static_cast<uInt>(input.size());
+    stream_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+    stream_.avail_out = static_cast<uInt>(output.size());
+    stream_.next_out = reinterpret_cast<Bytef *>(output.data());
+    auto ret = is_encoder_ ? deflate(&stream_, Z_FINISH) : inflate(&stream_, Z_FINISH);
+    auto used_output = output.size() - stream_.avail_out;
+    stream_.avail_in = 0;
+    stream_.next_in = nullptr;
+    stream_.avail_out = 0;
+    stream_.next_out = nullptr;
+    if (ret != Z_STREAM_END) {
+      return -1;
+    }
+    return static_cast<int64>(used_output);
+  }
+
+ private:
+  z_stream stream_;
+  bool is_encoder_ = false;
+  bool is_inited_ = false;
+};
+
+}  // namespace
+
+BufferSlice deflate_with_dictionary(Slice s, Slice dictionary, size_t max_size) {
+  static TD_THREAD_LOCAL RawDeflateStream *encoder;
+  init_thread_local<RawDeflateStream>(encoder, true);
+  BufferWriter message{max_size};
+  auto size = encoder->run(s, dictionary, message.prepare_append());
+  if (size < 0) {
     return BufferSlice();
   }
-  message.confirm_append(gzip.flush_output());
+  message.confirm_append(static_cast<size_t>(size));
   return message.as_buffer_slice();
 }
 
+Result<BufferSlice> inflate_with_dictionary(Slice s, Slice dictionary, size_t decoded_size) {
+  static TD_THREAD_LOCAL RawDeflateStream *decoder;
+  init_thread_local<RawDeflateStream>(decoder, false);
+  BufferSlice result(decoded_size);
+  auto size = decoder->run(s, dictionary, result.as_mutable_slice());
+  if (size != static_cast<int64>(decoded_size)) {
+    return Status::Error("Failed to decompress data");
+  }
+  return std::move(result);
+}
+
 }  // namespace td
 #endif
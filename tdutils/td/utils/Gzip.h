@@ -15,6 +15,8 @@
 
 namespace td {
 
+// zlib stream wrapper; streams of finished or destroyed objects are kept in a small per-thread pool
+// and are reset instead of being recreated by subsequent init_encode/init_decode calls
 class Gzip {
  public:
   Gzip();
@@ -84,6 +86,7 @@ class Gzip {
 
  private:
   class Impl;
+  class ImplPool;
   unique_ptr<Impl> impl_;
 
   size_t input_size_ = 0;
@@ -94,6 +97,9 @@ class Gzip {
   void init_common();
   void clear();
 
+  static unique_ptr<Impl> acquire_impl(Mode mode);
+  static void release_impl(unique_ptr<Impl> impl);
+
   void swap(Gzip &other);
 };
 
@@ -101,6 +107,13 @@ BufferSlice gzdecode(Slice s);
 
 BufferSlice gzencode(Slice s, double max_compression_ratio);
 
+// raw deflate with a preset dictionary, which is useful for independent compression of many small similar strings;
+// returns an empty slice if the compressed data doesn't fit in max_size bytes
+BufferSlice deflate_with_dictionary(Slice s, Slice dictionary, size_t max_size);
+
+// decoded_size must be equal to the size of the original string
+Result<BufferSlice> inflate_with_dictionary(Slice s, Slice dictionary, size_t decoded_size);
+
 }  // namespace td
 
 #endif
@@ -47,6 +47,10 @@ class KHeap {
     return array_[0].node_;
   }
 
+  bool is_top(const HeapNode *node) const {
+    return node->is_top();
+  }
+
   HeapNode *pop() {
     CHECK(!empty());
     HeapNode *result = array_[0].node_;
@@ -0,0 +1,282 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/HeapProfiler.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Slice.h"
+#include "td/utils/StringBuilder.h"
+
+#if __GLIBC__ || TD_DARWIN
+#include <execinfo.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+namespace td {
+
+namespace {
+
+constexpr size_t MAX_BACKTRACE_SIZE = 32;
+constexpr size_t MAX_NAME_SIZE = 48;
+
+struct HeapSample {
+  size_t size = 0;
+  size_t sampling_interval = 0;
+  int backtrace_size = 0;
+  void *backtrace[MAX_BACKTRACE_SIZE];
+  char name[MAX_NAME_SIZE];
+};
+
+std::atomic<bool> is_heap_profiler_supported{false};
+std::atomic<size_t> heap_sampling_interval{0};
+std::atomic<size_t> heap_sample_count{0};
+// incremented whenever the sampling interval is changed to restart countdowns of all threads
+std::atomic<uint32> heap_sampling_generation{0};
+
+// must be locked only with in_heap_profiler set, so that allocations made under the lock aren't sampled
+std::mutex heap_samples_mutex;
+std::unordered_map<void *, HeapSample> *heap_samples = nullptr;
+
+TD_THREAD_LOCAL bool in_heap_profiler;
+TD_THREAD_LOCAL int64 bytes_until_heap_sample;
+TD_THREAD_LOCAL uint32 thread_heap_sampling_generation;
+TD_THREAD_LOCAL uint64 heap_sample_random_state;
+
+class HeapProfilerGuard {
+ public:
+  HeapProfilerGuard() {
+    in_heap_profiler = true;
+  }
+  HeapProfilerGuard(const HeapProfilerGuard &) = delete;
+  HeapProfilerGuard &operator=(const HeapProfilerGuard &) = delete;
+  HeapProfilerGuard(HeapProfilerGuard &&) = delete;
+  HeapProfilerGuard &operator=(HeapProfilerGuard &&) = delete;
+  ~HeapProfilerGuard() {
+    in_heap_profiler = false;
+  }
+};
+
+// distances between samples are exponentially distributed, so each allocated byte is sampled with equal probability
+int64 get_next_heap_sample_distance(size_t sampling_interval) {
+  auto &state = heap_sample_random_state;
+  if (state == 0) {
+    state = static_cast<uint64>(reinterpret_cast<std::uintptr_t>(&state)) * 0x9E3779B97F4A7C15ull + 1;
+  }
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  double u = static_cast<double>((state >> 11) + 1) / static_cast<double>(static_cast<uint64>(1) << 53);
+  return static_cast<int64>(-std::log(u) * static_cast<double>(sampling_interval)) + 1;
+}
+
+// returns the inverse probability of an allocation of the specified size to be sampled
+double get_heap_sample_scale(const HeapSample &sample) {
+  if (sample.size == 0) {
+    return 1.0;
+  }
+  auto probability =
+      1.0 - std::exp(-static_cast<double>(sample.size) / static_cast<double>(sample.sampling_interval));
+  return 1.0 / probability;
+}
+
+void append_proc_maps(StringBuilder &sb) {
+  auto r_fd = FileFd::open("/proc/self/maps", FileFd::Read);
+  if (r_fd.is_error()) {
+    return;
+  }
+  auto fd = r_fd.move_as_ok();
+  char buf[4096];
+  while (true) {
+    auto r_size = fd.read(MutableSlice(buf, sizeof(buf)));
+    if (r_size.is_error() || r_size.ok() == 0) {
+      break;
+    }
+    sb << Slice(buf, r_size.ok());
+  }
+  fd.close();
+}
+
+}  // namespace
+
+bool HeapProfiler::is_supported() {
+  return is_heap_profiler_supported.load(std::memory_order_relaxed);
+}
+
+Status HeapProfiler::set_sampling_interval(size_t sampling_interval) {
+  if (!is_supported()) {
+    return Status::Error("Heap profiler is unsupported without a malloc replacement");
+  }
+  HeapProfilerGuard guard;
+  std::lock_guard<std::mutex> lock(heap_samples_mutex);
+  heap_sampling_generation++;
+  if (sampling_interval == 0) {
+    heap_sampling_interval = 0;
+    delete heap_samples;
+    heap_samples = nullptr;
+    heap_sample_count = 0;
+    return Status::OK();
+  }
+  if (heap_samples == nullptr) {
+    heap_samples = new std::unordered_map<void *, HeapSample>();
+  }
+  heap_sampling_interval = sampling_interval;
+  return Status::OK();
+}
+
+size_t HeapProfiler::get_sampling_interval() {
+  return heap_sampling_interval.load(std::memory_order_relaxed);
+}
+
+void HeapProfiler::on_allocation(void *ptr, size_t size) {
+  auto sampling_interval = heap_sampling_interval.load(std::memory_order_relaxed);
+  if (sampling_interval == 0) {
+    if (!is_heap_profiler_supported.load(std::memory_order_relaxed)) {
+      is_heap_profiler_supported = true;
+    }
+    return;
+  }
+  if (ptr == nullptr || in_heap_profiler) {
+    return;
+  }
+  auto generation = heap_sampling_generation.load(std::memory_order_relaxed);
+  if (thread_heap_sampling_generation != generation) {
+    // a fresh countdown must be random too; otherwise, the first allocation of every thread would be sampled
+    thread_heap_sampling_generation = generation;
+    bytes_until_heap_sample = get_next_heap_sample_distance(sampling_interval);
+  }
+  bytes_until_heap_sample -= static_cast<int64>(size);
+  if (bytes_until_heap_sample > 0) {
+    return;
+  }
+
+  HeapProfilerGuard guard;
+  bytes_until_heap_sample = get_next_heap_sample_distance(sampling_interval);
+
+  HeapSample sample;
+  sample.size = size;
+  sample.sampling_interval = sampling_interval;
+#if __GLIBC__ || TD_DARWIN
+  sample.backtrace_size = ::backtrace(sample.backtrace, static_cast<int>(MAX_BACKTRACE_SIZE));
+#endif
+  std::memset(sample.name, 0, sizeof(sample.name));
+  auto *name = Logger::tag2_;
+  if (name != nullptr) {
+    std::strncpy(sample.name, name, MAX_NAME_SIZE - 1);
+  }
+
+  std::lock_guard<std::mutex> lock(heap_samples_mutex);
+  if (heap_samples == nullptr) {
+    return;
+  }
+  if (heap_samples->emplace(ptr, sample).second) {
+    heap_sample_count++;
+  }
+}
+
+void HeapProfiler::on_deallocation(void *ptr) {
+  if (heap_sample_count.load(std::memory_order_relaxed) == 0 || ptr == nullptr || in_heap_profiler) {
+    return;
+  }
+
+  HeapProfilerGuard guard;
+  std::lock_guard<std::mutex> lock(heap_samples_mutex);
+  if (heap_samples != nullptr && heap_samples->erase(ptr) != 0) {
+    heap_sample_count--;
+  }
+}
+
+vector<HeapProfiler::Entry> HeapProfiler::get_statistics() {
+  std::unordered_map<string, std::pair<double, double>> sizes;
+  {
+    HeapProfilerGuard guard;
+    std::lock_guard<std::mutex> lock(heap_samples_mutex);
+    if (heap_samples != nullptr) {
+      for (auto &it : *heap_samples) {
+        auto &sample = it.second;
+        auto scale = get_heap_sample_scale(sample);
+        auto &size = sizes[string(sample.name)];
+        size.first += static_cast<double>(sample.size) * scale;
+        size.second += scale;
+      }
+    }
+  }
+
+  auto result = transform(sizes, [](const auto &it) {
+    Entry entry;
+    entry.name = it.first;
+    entry.size = static_cast<uint64>(it.second.first + 0.5);
+    entry.allocation_count = static_cast<uint64>(it.second.second + 0.5);
+    return entry;
+  });
+  std::sort(result.begin(), result.end(), [](const Entry &lhs, const Entry &rhs) {
+    if (lhs.size != rhs.size) {
+      return lhs.size > rhs.size;
+    }
+    return lhs.name < rhs.name;
+  });
+  return result;
+}
+
+string HeapProfiler::get_pprof_profile() {
+  struct Record {
+    size_t count = 0;
+    size_t size = 0;
+    vector<void *> backtrace;
+  };
+  vector<Record> records;
+  size_t total_count = 0;
+  size_t total_size = 0;
+  auto sampling_interval = get_sampling_interval();
+  {
+    HeapProfilerGuard guard;
+    std::lock_guard<std::mutex> lock(heap_samples_mutex);
+    if (heap_samples != nullptr) {
+      std::unordered_map<string, size_t> record_ids;
+      for (auto &it : *heap_samples) {
+        auto &sample = it.second;
+        string key(reinterpret_cast<const char *>(sample.backtrace), sample.backtrace_size * sizeof(void *));
+        auto record_it = record_ids.emplace(std::move(key), records.size()).first;
+        if (record_it->second == records.size()) {
+          records.emplace_back();
+          records.back().backtrace.assign(sample.backtrace, sample.backtrace + sample.backtrace_size);
+        }
+        auto &record = records[record_it->second];
+        record.count++;
+        record.size += sample.size;
+        total_count++;
+        total_size += sample.size;
+      }
+    }
+  }
+  std::sort(records.begin(), records.end(), [](const Record &lhs, const Record &rhs) { return lhs.size > rhs.size; });
+
+  // the first frame is always the profiler itself
+  StringBuilder sb;
+  sb << "heap profile: " << total_count << ": " << total_size << " [" << total_count << ": " << total_size
+     << "] @ heap_v2/" << sampling_interval << '\n';
+  for (auto &record : records) {
+    sb << record.count << ": " << record.size << " [" << record.count << ": " << record.size << "] @";
+    for (size_t i = 1; i < record.backtrace.size(); i++) {
+      sb << ' ' << static_cast<const void *>(record.backtrace[i]);
+    }
+    sb << '\n';
+  }
+  sb << "\nMAPPED_LIBRARIES:\n";
+  append_proc_maps(sb);
+  return sb.as_cslice().str();
+}
+
+}  // namespace td
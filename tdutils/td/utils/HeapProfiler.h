@@ -0,0 +1,46 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+// sampling profiler of live heap memory, which can be enabled at runtime
+// allocations must be reported by a malloc replacement, for example, by memprof built with MEMPROF=SAMPLED
+class HeapProfiler {
+ public:
+  struct Entry {
+    string name;
+    uint64 size = 0;
+    uint64 allocation_count = 0;
+  };
+
+  // returns true if allocations are reported to the profiler
+  static bool is_supported();
+
+  // samples on average one allocation per sampling_interval allocated bytes; 0 disables sampling and drops all samples
+  static Status set_sampling_interval(size_t sampling_interval) TD_WARN_UNUSED_RESULT;
+
+  static size_t get_sampling_interval();
+
+  // must be called after each successful allocation; must not allocate memory itself
+  static void on_allocation(void *ptr, size_t size);
+
+  // must be called before each deallocation
+  static void on_deallocation(void *ptr);
+
+  // returns estimated live heap memory usage grouped by names of the actors, which allocated it,
+  // sorted by decreasing size; memory allocated outside of actors is returned with an empty name
+  static vector<Entry> get_statistics();
+
+  // returns sampled live heap memory in the legacy text heap profile format, which is supported by pprof
+  static string get_pprof_profile();
+};
+
+}  // namespace td
@@ -14,6 +14,7 @@
 #include "td/utils/utf8.h"
 
 #include <algorithm>
+#include <limits>
 
 namespace td {
 
@@ -40,23 +41,21 @@ vector<string> Hints::get_words(Slice name) {
   return fix_words(utf8_get_search_words(name));
 }
 
-void Hints::add_word(const string &word, KeyT key, std::map<string, vector<KeyT>> &word_to_keys) {
-  vector<KeyT> &keys = word_to_keys[word];
-  CHECK(!td::contains(keys, key));
-  keys.push_back(key);
+void Hints::add_word_transliterations(vector<string> &transliterations, const string &word) {
+  auto old_size = transliterations.size();
+  append_word_transliterations(transliterations, word, false);
+  transliterations.erase(std::remove(transliterations.begin() + old_size, transliterations.end(), word),
+                         transliterations.end());
 }
 
-void Hints::delete_word(const string &word, KeyT key, std::map<string, vector<KeyT>> &word_to_keys) {
-  vector<KeyT> &keys = word_to_keys[word];
-  auto key_it = std::find(keys.begin(), keys.end(), key);
-  CHECK(key_it != keys.end());
-  if (keys.size() == 1) {
-    word_to_keys.erase(word);
-  } else {
-    CHECK(keys.size() > 1);
-    *key_it = keys.back();
-    keys.pop_back();
-  }
+void Hints::add_word(const string &word, KeyT key, WordTable &word_to_keys) {
+  auto is_inserted = word_to_keys.insert(std::make_pair(word, key));
+  CHECK(is_inserted);
+}
+
+void Hints::delete_word(const string &word, KeyT key, WordTable &word_to_keys) {
+  auto erased_count = word_to_keys.erase(std::make_pair(word, key));
+  CHECK(erased_count == 1);
 }
 
 void Hints::add(KeyT key, Slice name) {
@@ -69,12 +68,7 @@ void Hints::add(KeyT key, Slice name) {
     vector<string> old_transliterations;
     for (auto &old_word : get_words(it->second)) {
       delete_word(old_word, key, word_to_keys_);
-
-      for (auto &w : get_word_transliterations(old_word, false)) {
-        if (w != old_word) {
-          old_transliterations.push_back(std::move(w));
-        }
-      }
+      add_word_transliterations(old_transliterations, old_word);
     }
     for (auto &word : fix_words(old_transliterations)) {
       delete_word(word, key, translit_word_to_keys_);
@@ -91,12 +85,7 @@ void Hints::add(KeyT key, Slice name) {
   vector<string> transliterations;
   for (auto &word : get_words(name)) {
     add_word(word, key, word_to_keys_);
-
-    for (auto &w : get_word_transliterations(word, false)) {
-      if (w != word) {
-        transliterations.push_back(std::move(w));
-      }
-    }
+    add_word_transliterations(transliterations, word);
   }
   for (auto &word : fix_words(transliterations)) {
     add_word(word, key, translit_word_to_keys_);
@@ -110,12 +99,11 @@ void Hints::set_rating(KeyT key, RatingT rating) {
   key_to_rating_[key] = rating;
 }
 
-void Hints::add_search_results(vector<KeyT> &results, const string &word,
-                               const std::map<string, vector<KeyT>> &word_to_keys) {
+void Hints::add_search_results(vector<KeyT> &results, const string &word, const WordTable &word_to_keys) {
   LOG(DEBUG) << "Search for word " << word;
-  auto it = word_to_keys.lower_bound(word);
+  auto it = word_to_keys.lower_bound(std::make_pair(word, std::numeric_limits<KeyT>::min()));
   while (it != word_to_keys.end() && begins_with(it->first, word)) {
-    append(results, it->second);
+    results.push_back(it->second);
     ++it;
   }
 }
@@ -8,9 +8,9 @@
 
 #include "td/utils/common.h"
 #include "td/utils/HashTableUtils.h"
+#include "td/utils/OrderedSet.h"
 #include "td/utils/Slice.h"
 
-#include <map>
 #include <unordered_map>
 #include <utility>
 
@@ -45,18 +45,22 @@ class Hints {
   static vector<string> fix_words(vector<string> words);
 
  private:
-  std::map<string, vector<KeyT>> word_to_keys_;
-  std::map<string, vector<KeyT>> translit_word_to_keys_;
+  // pairs (word, key) are stored in contiguous sorted chunks, so all words with the same prefix are adjacent
+  using WordTable = OrderedSet<std::pair<string, KeyT>>;
+
+  WordTable word_to_keys_;
+  WordTable translit_word_to_keys_;
   std::unordered_map<KeyT, string, Hash<KeyT>> key_to_name_;
   std::unordered_map<KeyT, RatingT, Hash<KeyT>> key_to_rating_;
 
-  static void add_word(const string &word, KeyT key, std::map<string, vector<KeyT>> &word_to_keys);
-  static void delete_word(const string &word, KeyT key, std::map<string, vector<KeyT>> &word_to_keys);
+  static void add_word(const string &word, KeyT key, WordTable &word_to_keys);
+  static void delete_word(const string &word, KeyT key, WordTable &word_to_keys);
 
   static vector<string> get_words(Slice name);
 
-  static void add_search_results(vector<KeyT> &results, const string &word,
-                                 const std::map<string, vector<KeyT>> &word_to_keys);
+  static void add_word_transliterations(vector<string> &transliterations, const string &word);
+
+  static void add_search_results(vector<KeyT> &results, const string &word, const WordTable &word_to_keys);
 
   vector<KeyT> search_word(const string &word) const;
 
@@ -6,13 +6,80 @@
 //
 #include "td/utils/JsonBuilder.h"
 
+#include "td/utils/bits.h"
 #include "td/utils/misc.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/utf8.h"
 
+#include <cstring>
+
+#if defined(__SSE2__) || (TD_MSVC && (defined(_M_X64) || (defined(_M_IX86) && _M_IX86_FP >= 2)))
+#define TD_SSE2 1
+#endif
+
+#ifdef __aarch64__
+#include <arm_neon.h>
+#endif
+
+#if TD_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace td {
 
+// returns length of the longest prefix without characters, which must be escaped in a JSON string
+template <bool escape_non_ascii>
+static size_t get_json_clean_prefix_length(const char *s, size_t len) {
+  auto is_special = [](unsigned char ch) {
+    return ch < 0x20 || ch == '"' || ch == '\\' || (escape_non_ascii && ch >= 0x80);
+  };
+
+  // short runs are common, so the first bytes are checked one by one
+  size_t pos = 0;
+  for (; pos < len && pos < 8; pos++) {
+    if (is_special(static_cast<unsigned char>(s[pos]))) {
+      return pos;
+    }
+  }
+#ifdef __aarch64__
+  for (; pos + 16 <= len; pos += 16) {
+    auto bytes = vld1q_u8(reinterpret_cast<const uint8 *>(s + pos));
+    auto special_mask = vorrq_u8(vorrq_u8(vcltq_u8(bytes, vdupq_n_u8(0x20)), vceqq_u8(bytes, vdupq_n_u8('"'))),
+                                 vceqq_u8(bytes, vdupq_n_u8('\\')));
+    if (escape_non_ascii) {
+      special_mask = vorrq_u8(special_mask, vcgeq_u8(bytes, vdupq_n_u8(0x80)));
+    }
+    auto mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(special_mask), 4)), 0);
+    if (mask != 0) {
+      return pos + count_trailing_zeroes64(mask) / 4;
+    }
+  }
+#elif TD_SSE2
+  for (; pos + 16 <= len; pos += 16) {
+    auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + pos));
+    auto special_mask =
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\')));
+    if (escape_non_ascii) {
+      // signed comparison also matches all bytes greater than 0x7F
+      special_mask = _mm_or_si128(special_mask, _mm_cmplt_epi8(bytes, _mm_set1_epi8(0x20)));
+    } else {
+      special_mask = _mm_or_si128(special_mask, _mm_cmpeq_epi8(_mm_min_epu8(bytes, _mm_set1_epi8(0x1F)), bytes));
+    }
+    auto mask = static_cast<uint32>(_mm_movemask_epi8(special_mask));
+    if (mask != 0) {
+      return pos + count_trailing_zeroes32(mask);
+    }
+  }
+#endif
+  for (; pos < len; pos++) {
+    if (is_special(static_cast<unsigned char>(s[pos]))) {
+      break;
+    }
+  }
+  return pos;
+}
+
 StringBuilder &operator<<(StringBuilder &sb, const JsonRawString &val) {
   sb << '"';
   SCOPE_EXIT {
@@ -22,6 +89,14 @@ StringBuilder &operator<<(StringBuilder &sb, const JsonRawString &val) {
   auto len = val.value_.size();
 
   for (size_t pos = 0; pos < len; pos++) {
+    auto clean_length = get_json_clean_prefix_length<false>(s + pos, len - pos);
+    if (clean_length > 0) {
+      sb << Slice(s + pos, clean_length);
+      pos += clean_length;
+      if (pos == len) {
+        break;
+      }
+    }
     auto ch = static_cast<unsigned char>(s[pos]);
     switch (ch) {
       case '"':
@@ -66,6 +141,14 @@ StringBuilder &operator<<(StringBuilder &sb, const JsonString &val) {
   auto len = val.str_.size();
 
   for (size_t pos = 0; pos < len; pos++) {
+    auto clean_length = get_json_clean_prefix_length<true>(s + pos, len - pos);
+    if (clean_length > 0) {
+      sb << Slice(s + pos, clean_length);
+      pos += clean_length;
+      if (pos == len) {
+        break;
+      }
+    }
     auto ch = static_cast<unsigned char>(s[pos]);
     switch (ch) {
       case '"':
@@ -220,6 +303,16 @@ Result<MutableSlice> json_string_decode(Parser &parser) {
       }
     } else {
       *cur_dest++ = *cur_src++;
+      if (cur_src != end && *cur_src != '"' && *cur_src != '\\') {
+        // copy all characters up to the next special character at once
+        auto run_length = get_json_clean_prefix_length<false>(reinterpret_cast<const char *>(cur_src),
+                                                              static_cast<size_t>(end - cur_src));
+        if (cur_dest != cur_src) {
+          std::memmove(cur_dest, cur_src, run_length);
+        }
+        cur_src += run_length;
+        cur_dest += run_length;
+      }
     }
   }
   UNREACHABLE();
@@ -287,6 +380,10 @@ Status json_string_skip(Parser &parser) {
       }
     } else {
       cur_src++;
+      if (cur_src != end && *cur_src != '"' && *cur_src != '\\') {
+        cur_src += get_json_clean_prefix_length<false>(reinterpret_cast<const char *>(cur_src),
+                                                       static_cast<size_t>(end - cur_src));
+      }
     }
   }
   UNREACHABLE();
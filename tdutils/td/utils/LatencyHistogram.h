@@ -0,0 +1,88 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <cmath>
+
+namespace td {
+
+// Histogram of durations in seconds with logarithmic buckets, each of which is 2^(1/4) times wider than the previous,
+// so quantiles are estimated with relative error below 19%. Durations above 1000 seconds are stored in one bucket.
+class LatencyHistogram {
+ public:
+  void add(double duration) {
+    if (!(duration > 0.0)) {
+      duration = 0.0;
+    }
+    buckets_[get_bucket_id(duration)]++;
+    count_++;
+    total_ += duration;
+    if (duration > max_) {
+      max_ = duration;
+    }
+  }
+
+  uint64 get_count() const {
+    return count_;
+  }
+
+  double get_total() const {
+    return total_;
+  }
+
+  double get_max() const {
+    return max_;
+  }
+
+  // returns an upper estimate of the q-quantile, 0 <= q <= 1
+  double get_quantile(double q) const {
+    if (count_ == 0) {
+      return 0.0;
+    }
+    auto rank = static_cast<uint64>(std::ceil(q * static_cast<double>(count_)));
+    if (rank == 0) {
+      rank = 1;
+    }
+    uint64 sum = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+      sum += buckets_[i];
+      if (sum >= rank) {
+        return i + 1 == BUCKET_COUNT ? max_ : min(get_bucket_upper_bound(i), max_);
+      }
+    }
+    return max_;
+  }
+
+ private:
+  static constexpr int32 BUCKETS_PER_POWER_OF_TWO = 4;
+  static constexpr double MIN_DURATION = 1e-6;
+  static constexpr size_t BUCKET_COUNT = 30 * BUCKETS_PER_POWER_OF_TWO + 1;
+
+  uint32 buckets_[BUCKET_COUNT] = {};
+  uint64 count_ = 0;
+  double total_ = 0.0;
+  double max_ = 0.0;
+
+  static size_t get_bucket_id(double duration) {
+    if (duration <= MIN_DURATION) {
+      return 0;
+    }
+    auto bucket_id = std::ceil(std::log2(duration / MIN_DURATION) * BUCKETS_PER_POWER_OF_TWO);
+    if (bucket_id >= static_cast<double>(BUCKET_COUNT - 1)) {
+      return BUCKET_COUNT - 1;
+    }
+    return static_cast<size_t>(bucket_id);
+  }
+
+  static double get_bucket_upper_bound(size_t bucket_id) {
+    return MIN_DURATION * std::exp2(static_cast<double>(bucket_id) / BUCKETS_PER_POWER_OF_TWO);
+  }
+};
+
+}  // namespace td
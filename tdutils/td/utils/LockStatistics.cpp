@@ -0,0 +1,51 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/LockStatistics.h"
+
+#include "td/utils/Slice.h"
+
+#include <algorithm>
+
+namespace td {
+
+// statistics objects are never destroyed, so they can be stored in a lock-free singly linked list
+static std::atomic<LockStatistics *> lock_statistics_head{nullptr};
+
+LockStatistics::LockStatistics(const char *name) : name_(name) {
+  auto head = lock_statistics_head.load(std::memory_order_relaxed);
+  do {
+    next_ = head;
+  } while (!lock_statistics_head.compare_exchange_weak(head, this, std::memory_order_release,
+                                                       std::memory_order_relaxed));
+}
+
+vector<LockStatistics::Entry> LockStatistics::get_statistics() {
+  vector<Entry> result;
+  for (auto statistics = lock_statistics_head.load(std::memory_order_acquire); statistics != nullptr;
+       statistics = statistics->next_) {
+    auto it = std::find_if(result.begin(), result.end(),
+                           [name = Slice(statistics->name_)](const Entry &entry) { return entry.name == name; });
+    if (it == result.end()) {
+      result.emplace_back();
+      result.back().name = statistics->name_;
+      it = result.end() - 1;
+    }
+    it->lock_count += statistics->lock_count_.load(std::memory_order_relaxed);
+    it->contention_count += statistics->contention_count_.load(std::memory_order_relaxed);
+    it->spin_count += statistics->spin_count_.load(std::memory_order_relaxed);
+    it->wait_time += static_cast<double>(statistics->wait_time_ns_.load(std::memory_order_relaxed)) * 1e-9;
+  }
+  std::sort(result.begin(), result.end(), [](const Entry &lhs, const Entry &rhs) {
+    if (lhs.wait_time != rhs.wait_time) {
+      return lhs.wait_time > rhs.wait_time;
+    }
+    return lhs.name < rhs.name;
+  });
+  return result;
+}
+
+}  // namespace td
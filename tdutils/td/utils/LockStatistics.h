@@ -0,0 +1,58 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/config.h"
+
+#include <atomic>
+
+namespace td {
+
+// contention statistics of all locks or queues with the same name
+// the statistics are collected only if TDLib is built with TD_ENABLE_LOCK_STATISTICS
+class LockStatistics {
+ public:
+  struct Entry {
+    string name;
+    uint64 lock_count = 0;
+    uint64 contention_count = 0;
+    uint64 spin_count = 0;
+    double wait_time = 0.0;
+  };
+
+  // the name must be a string literal; the object must have static storage duration
+  explicit LockStatistics(const char *name);
+
+  void on_lock() {
+    lock_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // must be called after on_lock if the lock wasn't acquired immediately or the queue had to be waited for
+  void on_contention(uint64 spin_count, double wait_time) {
+    contention_count_.fetch_add(1, std::memory_order_relaxed);
+    spin_count_.fetch_add(spin_count, std::memory_order_relaxed);
+    wait_time_ns_.fetch_add(static_cast<uint64>(wait_time * 1e9), std::memory_order_relaxed);
+  }
+
+  static constexpr bool is_enabled() {
+    return TD_HAVE_LOCK_STATISTICS != 0;
+  }
+
+  // returns statistics summed up by name and sorted by decreasing wait time
+  static vector<Entry> get_statistics();
+
+ private:
+  const char *name_;
+  std::atomic<uint64> lock_count_{0};
+  std::atomic<uint64> contention_count_{0};
+  std::atomic<uint64> spin_count_{0};
+  std::atomic<uint64> wait_time_ns_{0};
+  LockStatistics *next_ = nullptr;
+};
+
+}  // namespace td
@@ -13,9 +13,11 @@
 
 #include "td/utils/format.h"
 #include "td/utils/HazardPointers.h"
+#include "td/utils/LockStatistics.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/sleep.h"
 #include "td/utils/ScopeGuard.h"
+#include "td/utils/Time.h"
 
 #include <array>
 #include <atomic>
@@ -395,6 +397,28 @@ class MpmcQueue {
     }
   }
 
+  // pushes all values, reserving slots for them with a single atomic operation in the common case
+  void push_bulk(vector<T> &values, size_t thread_id) {
+    size_t pushed_count = 0;
+    {
+      SCOPE_EXIT {
+        hazard_pointers_.clear(thread_id, 0);
+      };
+      auto node = hazard_pointers_.protect(thread_id, 0, write_pos_);
+      auto &block = node->block;
+      auto pos = block.write_pos.fetch_add(values.size());
+      // slots after the first failed one are left unused to keep the order of the values
+      while (pushed_count < values.size() && pos + pushed_count < block.data.size() &&
+             block.data[static_cast<size_t>(pos + pushed_count)].set_value(values[pushed_count])) {
+        pushed_count++;
+      }
+    }
+    for (size_t i = pushed_count; i < values.size(); i++) {
+      push(std::move(values[i]), thread_id);
+    }
+    values.clear();
+  }
+
   bool try_pop(T &value, size_t thread_id) {
     SCOPE_EXIT {
       hazard_pointers_.clear(thread_id, 0);
@@ -423,14 +447,73 @@ class MpmcQueue {
     }
   }
 
+  // appends up to max_count values to the vector, reserving slots for all ready values with a single atomic operation
+  // returns the number of popped values
+  size_t try_pop_bulk(vector<T> &values, size_t max_count, size_t thread_id) {
+    SCOPE_EXIT {
+      hazard_pointers_.clear(thread_id, 0);
+    };
+    size_t popped_count = 0;
+    while (popped_count < max_count) {
+      auto node = hazard_pointers_.protect(thread_id, 0, read_pos_);
+      auto &block = node->block;
+      auto write_pos = block.write_pos.load(std::memory_order_relaxed);
+      auto read_pos = block.read_pos.load(std::memory_order_relaxed);
+      if (write_pos <= read_pos && node->next.load(std::memory_order_relaxed) == nullptr) {
+        break;
+      }
+      // reserve no more slots than there are written values to avoid forcing writers to retry
+      uint64 count = 1;
+      if (write_pos > read_pos) {
+        count = td::min(write_pos - read_pos, static_cast<uint64>(max_count - popped_count));
+      }
+      auto pos = block.read_pos.fetch_add(count);
+      if (pos >= block.data.size()) {
+        auto next = node->next.load();
+        if (!next) {
+          break;
+        }
+        if (read_pos_.compare_exchange_strong(node, next)) {
+          hazard_pointers_.clear(thread_id, 0);
+          hazard_pointers_.retire(thread_id, node);
+        }
+        continue;
+      }
+      auto end_pos = td::min(pos + count, static_cast<uint64>(block.data.size()));
+      for (; pos < end_pos; pos++) {
+        T value;
+        if (block.data[static_cast<size_t>(pos)].get_value(value)) {
+          values.push_back(std::move(value));
+          popped_count++;
+        }
+      }
+    }
+    return popped_count;
+  }
+
   T pop(size_t thread_id) {
     T value;
+#if TD_HAVE_LOCK_STATISTICS
+    static LockStatistics statistics("MpmcQueue");
+    statistics.on_lock();
+    if (!try_pop(value, thread_id)) {
+      auto start_time = Time::now();
+      uint64 spin_count = 0;
+      do {
+        usleep_for(1);
+        spin_count++;
+      } while (!try_pop(value, thread_id));
+      statistics.on_contention(spin_count, Time::now() - start_time);
+    }
+    return value;
+#else
     while (true) {
       if (try_pop(value, thread_id)) {
         return value;
       }
       usleep_for(1);
     }
+#endif
   }
 
  private:
@@ -30,7 +30,7 @@ class MpscPollableQueue {
     }
 
     for (int i = 0; i < 2; i++) {
-      auto guard = lock_.lock();
+      auto guard = lock();
       if (writer_vector_.empty()) {
         if (i == 1) {
           reader_vector_.clear();
@@ -55,7 +55,7 @@ class MpscPollableQueue {
     //nop
   }
   void writer_put(ValueType value) {
-    auto guard = lock_.lock();
+    auto guard = lock();
     writer_vector_.push_back(std::move(value));
     if (wait_event_fd_) {
       wait_event_fd_ = false;
@@ -63,6 +63,23 @@ class MpscPollableQueue {
       event_fd_.release();
     }
   }
+  // moves all values to the queue under a single lock with at most one wakeup of the reader
+  void writer_put_batch(std::vector<ValueType> &values) {
+    auto guard = lock();
+    if (writer_vector_.empty()) {
+      std::swap(writer_vector_, values);
+    } else {
+      for (auto &value : values) {
+        writer_vector_.push_back(std::move(value));
+      }
+      values.clear();
+    }
+    if (wait_event_fd_) {
+      wait_event_fd_ = false;
+      guard.reset();
+      event_fd_.release();
+    }
+  }
   EventFd &reader_get_event_fd() {
     return event_fd_;
   }
@@ -70,8 +87,33 @@ class MpscPollableQueue {
     //nop
   }
 
+  // stops writers from signaling the event fd after reader_wait_nonblock returned 0
+  // returns false if the event fd has already been signaled or reader_wait_nonblock wasn't called
+  bool reader_disable_wakeup() {
+    auto guard = lock();
+    if (!wait_event_fd_) {
+      return false;
+    }
+    wait_event_fd_ = false;
+    return true;
+  }
+  // can be called only after successful reader_disable_wakeup
+  bool reader_has_values() {
+    auto guard = lock();
+    return !writer_vector_.empty();
+  }
+  // reverts reader_disable_wakeup; returns true if there are new values, which can be read without waiting
+  bool reader_enable_wakeup() {
+    auto guard = lock();
+    if (!writer_vector_.empty()) {
+      return true;
+    }
+    wait_event_fd_ = true;
+    return false;
+  }
+
   bool is_empty() {
-    auto guard = lock_.lock();
+    auto guard = lock();
     return writer_vector_.empty() && reader_vector_.empty();
   }
 
@@ -99,6 +141,16 @@ class MpscPollableQueue {
 
  private:
   Mutex lock_;
+
+  Mutex::Guard lock() {
+#if TD_HAVE_LOCK_STATISTICS
+    static LockStatistics statistics("MpscPollableQueue");
+    return lock_.lock(statistics);
+#else
+    return lock_.lock();
+#endif
+  }
+
   bool wait_event_fd_{false};
   EventFd event_fd_;
   std::vector<ValueType> writer_vector_;
@@ -128,10 +180,29 @@ class MpscPollableQueue {
     UNREACHABLE();
   }
 
+  void writer_put_batch(std::vector<ValueType> &values) {
+    UNREACHABLE();
+  }
+
   void writer_flush() {
     UNREACHABLE();
   }
 
+  bool reader_disable_wakeup() {
+    UNREACHABLE();
+    return false;
+  }
+
+  bool reader_has_values() {
+    UNREACHABLE();
+    return false;
+  }
+
+  bool reader_enable_wakeup() {
+    UNREACHABLE();
+    return false;
+  }
+
   int reader_wait_nonblock() {
     UNREACHABLE();
     return 0;
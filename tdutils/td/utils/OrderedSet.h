@@ -0,0 +1,201 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+namespace td {
+
+// Ordered set of unique keys, stored in contiguous sorted chunks of bounded size.
+// Lookup, insertion and removal take O(log(n) + CHUNK_SIZE), iteration reads memory sequentially.
+// Any modification invalidates all iterators.
+template <class KeyT, class Compare = std::less<KeyT>>
+class OrderedSet {
+  static constexpr size_t MAX_CHUNK_SIZE = 256;
+
+  vector<vector<KeyT>> chunks_;
+  size_t size_ = 0;
+
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = KeyT;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const KeyT *;
+    using reference = const KeyT &;
+
+    const_iterator() = default;
+
+    reference operator*() const {
+      return (*chunks_)[chunk_pos_][pos_];
+    }
+    pointer operator->() const {
+      return &(*chunks_)[chunk_pos_][pos_];
+    }
+
+    const_iterator &operator++() {
+      if (++pos_ == (*chunks_)[chunk_pos_].size()) {
+        chunk_pos_++;
+        pos_ = 0;
+      }
+      return *this;
+    }
+    const_iterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return chunk_pos_ == other.chunk_pos_ && pos_ == other.pos_;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+   private:
+    friend class OrderedSet;
+
+    const vector<vector<KeyT>> *chunks_ = nullptr;
+    size_t chunk_pos_ = 0;
+    size_t pos_ = 0;
+
+    const_iterator(const vector<vector<KeyT>> *chunks, size_t chunk_pos, size_t pos)
+        : chunks_(chunks), chunk_pos_(chunk_pos), pos_(pos) {
+      if (chunk_pos_ < chunks_->size() && pos_ == (*chunks_)[chunk_pos_].size()) {
+        chunk_pos_++;
+        pos_ = 0;
+      }
+    }
+  };
+  using iterator = const_iterator;
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  const_iterator begin() const {
+    return const_iterator(&chunks_, 0, 0);
+  }
+
+  const_iterator end() const {
+    return const_iterator(&chunks_, chunks_.size(), 0);
+  }
+
+  // returns iterator to the first key not less than the given key
+  const_iterator lower_bound(const KeyT &key) const {
+    auto chunk_pos = get_chunk_pos(key);
+    if (chunk_pos == chunks_.size()) {
+      return end();
+    }
+    auto &chunk = chunks_[chunk_pos];
+    auto pos = static_cast<size_t>(std::lower_bound(chunk.begin(), chunk.end(), key, Compare()) - chunk.begin());
+    return const_iterator(&chunks_, chunk_pos, pos);
+  }
+
+  // returns iterator to the first key greater than the given key
+  const_iterator upper_bound(const KeyT &key) const {
+    auto it = lower_bound(key);
+    if (it != end() && !Compare()(key, *it)) {
+      ++it;
+    }
+    return it;
+  }
+
+  const_iterator find(const KeyT &key) const {
+    auto it = lower_bound(key);
+    if (it != end() && !Compare()(key, *it)) {
+      return it;
+    }
+    return end();
+  }
+
+  size_t count(const KeyT &key) const {
+    return find(key) == end() ? 0 : 1;
+  }
+
+  // returns true if the key was inserted
+  bool insert(KeyT key) {
+    if (chunks_.empty()) {
+      chunks_.emplace_back();
+      chunks_[0].push_back(std::move(key));
+      size_ = 1;
+      return true;
+    }
+
+    auto chunk_pos = get_chunk_pos(key);
+    if (chunk_pos == chunks_.size()) {
+      chunk_pos--;
+    }
+    auto &chunk = chunks_[chunk_pos];
+    auto it = std::lower_bound(chunk.begin(), chunk.end(), key, Compare());
+    if (it != chunk.end() && !Compare()(key, *it)) {
+      return false;
+    }
+    chunk.insert(it, std::move(key));
+    size_++;
+
+    if (chunk.size() > MAX_CHUNK_SIZE) {
+      vector<KeyT> new_chunk(std::make_move_iterator(chunk.begin() + MAX_CHUNK_SIZE / 2),
+                             std::make_move_iterator(chunk.end()));
+      chunk.erase(chunk.begin() + MAX_CHUNK_SIZE / 2, chunk.end());
+      chunks_.insert(chunks_.begin() + chunk_pos + 1, std::move(new_chunk));
+    }
+    return true;
+  }
+
+  // returns number of removed keys
+  size_t erase(const KeyT &key) {
+    auto chunk_pos = get_chunk_pos(key);
+    if (chunk_pos == chunks_.size()) {
+      return 0;
+    }
+    auto &chunk = chunks_[chunk_pos];
+    auto it = std::lower_bound(chunk.begin(), chunk.end(), key, Compare());
+    if (it == chunk.end() || Compare()(key, *it)) {
+      return 0;
+    }
+    chunk.erase(it);
+    size_--;
+
+    if (chunk.empty()) {
+      chunks_.erase(chunks_.begin() + chunk_pos);
+    } else if (chunk_pos + 1 < chunks_.size() && chunk.size() + chunks_[chunk_pos + 1].size() <= MAX_CHUNK_SIZE / 2) {
+      // merge small adjacent chunks to keep iteration sequential
+      auto &next_chunk = chunks_[chunk_pos + 1];
+      chunk.insert(chunk.end(), std::make_move_iterator(next_chunk.begin()), std::make_move_iterator(next_chunk.end()));
+      chunks_.erase(chunks_.begin() + chunk_pos + 1);
+    }
+    return 1;
+  }
+
+  void clear() {
+    chunks_.clear();
+    size_ = 0;
+  }
+
+ private:
+  // returns position of the first chunk, which last key isn't less than the given key
+  size_t get_chunk_pos(const KeyT &key) const {
+    return static_cast<size_t>(std::lower_bound(chunks_.begin(), chunks_.end(), key,
+                                                [](const vector<KeyT> &chunk, const KeyT &key) {
+                                                  return Compare()(chunk.back(), key);
+                                                }) -
+                               chunks_.begin());
+  }
+};
+
+}  // namespace td
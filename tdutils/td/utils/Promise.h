@@ -10,6 +10,7 @@
 #include "td/utils/common.h"
 #include "td/utils/invoke.h"
 #include "td/utils/MovableValue.h"
+#include "td/utils/SmallObjectAllocator.h"
 #include "td/utils/Status.h"
 
 #include <tuple>
@@ -111,7 +112,8 @@ class LambdaPromise : public PromiseInterface<ValueT> {
   LambdaPromise &operator=(LambdaPromise &&) = default;
   ~LambdaPromise() override {
     if (state_.get() == State::Ready) {
-      do_error(Status::Error("Lost promise"));
+      static const Status lost_promise_error = Status::StaticError(0, "Lost promise");
+      do_error(lost_promise_error.clone());
     }
   }
 
@@ -119,6 +121,15 @@ class LambdaPromise : public PromiseInterface<ValueT> {
   LambdaPromise(FromT &&func) : func_(std::forward<FromT>(func)), state_(State::Ready) {
   }
 
+  // several promises are created for every request, so the memory of small implementations is reused through
+  // per-thread free lists; implementations bigger than SmallObjectAllocator::MAX_SIZE are allocated on the heap
+  static void *operator new(size_t size) {
+    return SmallObjectAllocator::allocate(size);
+  }
+  static void operator delete(void *ptr, size_t size) noexcept {
+    SmallObjectAllocator::deallocate(ptr, size);
+  }
+
  private:
   FunctionT func_;
   MovableValue<State> state_{State::Empty};
@@ -13,6 +13,10 @@
 #include <openssl/rand.h>
 #endif
 
+#if TD_HAVE_OPENSSL && TD_PORT_POSIX && !TD_EMSCRIPTEN
+#include <pthread.h>
+#endif
+
 #include <atomic>
 #include <cstring>
 #include <limits>
@@ -24,6 +28,14 @@ namespace td {
 
 namespace {
 std::atomic<int64> random_seed_generation{0};
+
+bool register_random_fork_handler() {
+#if TD_PORT_POSIX && !TD_EMSCRIPTEN
+  // buffered random bytes must not be shared between the parent and child processes
+  pthread_atfork(nullptr, nullptr, [] { random_seed_generation++; });
+#endif
+  return true;
+}
 }  // namespace
 
 void Random::secure_bytes(MutableSlice dest) {
@@ -31,11 +43,13 @@ void Random::secure_bytes(MutableSlice dest) {
 }
 
 void Random::secure_bytes(unsigned char *ptr, size_t size) {
-  constexpr size_t BUF_SIZE = 512;
+  constexpr size_t BUF_SIZE = 4096;
   static TD_THREAD_LOCAL unsigned char *buf;  // static zero-initialized
   static TD_THREAD_LOCAL size_t buf_pos;
   static TD_THREAD_LOCAL int64 generation;
   if (init_thread_local<unsigned char[]>(buf, BUF_SIZE)) {
+    static bool is_fork_handler_registered = register_random_fork_handler();
+    CHECK(is_fork_handler_registered);
     buf_pos = BUF_SIZE;
     generation = 0;
   }
@@ -0,0 +1,183 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/SharedMemoryQueue.h"
+
+#include "td/utils/as.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/FileFd.h"
+
+#include <cstring>
+#include <new>
+
+namespace td {
+
+constexpr size_t SharedMemoryQueue::MIN_CAPACITY;
+constexpr size_t SharedMemoryQueue::MAX_CAPACITY;
+constexpr uint64 SharedMemoryQueue::MAGIC;
+constexpr uint32 SharedMemoryQueue::HAS_MORE_PARTS_FLAG;
+
+SharedMemoryQueue::SharedMemoryQueue(MemoryMapping mapping) : mapping_(std::move(mapping)) {
+  auto data = mapping_.as_mutable_slice();
+  CHECK(data.size() >= sizeof(Header));
+  header_ = reinterpret_cast<Header *>(data.data());
+  data_ = data.data() + sizeof(Header);
+  capacity_ = data.size() - sizeof(Header);
+}
+
+Result<SharedMemoryQueue> SharedMemoryQueue::map(CSlice path, int64 size) {
+  int32 flags = FileFd::Read | FileFd::Write;
+  if (size > 0) {
+    flags |= FileFd::Create | FileFd::Truncate;
+  }
+  TRY_RESULT(fd, FileFd::open(path, flags));
+  if (size > 0) {
+    TRY_STATUS(fd.seek(size));
+    TRY_STATUS(fd.truncate_to_current_position(size));
+  } else {
+    TRY_RESULT_ASSIGN(size, fd.get_size());
+    if (size <= static_cast<int64>(sizeof(Header))) {
+      return Status::Error("Shared memory queue file is too small");
+    }
+  }
+  TRY_RESULT(mapping,
+             MemoryMapping::create_from_file(fd, MemoryMapping::Options().with_size(size).with_write_access()));
+  return SharedMemoryQueue(std::move(mapping));
+}
+
+bool SharedMemoryQueue::is_valid_capacity(uint64 capacity) {
+  return capacity >= MIN_CAPACITY && capacity <= MAX_CAPACITY && (capacity & (capacity - 1)) == 0;
+}
+
+Result<SharedMemoryQueue> SharedMemoryQueue::create(CSlice path, size_t capacity) {
+  if (!is_valid_capacity(capacity)) {
+    return Status::Error("Invalid shared memory queue capacity specified");
+  }
+  TRY_RESULT(queue, map(path, static_cast<int64>(sizeof(Header) + capacity)));
+  auto header = new (queue.header_) Header();
+  header->capacity = capacity;
+  header->write_pos.store(0, std::memory_order_relaxed);
+  header->read_pos.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = MAGIC;
+  return std::move(queue);
+}
+
+Result<SharedMemoryQueue> SharedMemoryQueue::open(CSlice path) {
+  TRY_RESULT(queue, map(path, 0));
+  if (queue.header_->magic != MAGIC) {
+    return Status::Error("Shared memory queue file has wrong format");
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (!is_valid_capacity(queue.header_->capacity)) {
+    return Status::Error("Shared memory queue file has invalid capacity");
+  }
+  if (queue.header_->capacity != queue.capacity_) {
+    return Status::Error("Shared memory queue file has wrong size");
+  }
+  return std::move(queue);
+}
+
+void SharedMemoryQueue::write(uint64 pos, Slice data) {
+  auto offset = static_cast<size_t>(pos & (capacity_ - 1));
+  auto first_size = td::min(data.size(), capacity_ - offset);
+  std::memcpy(data_ + offset, data.data(), first_size);
+  std::memcpy(data_, data.data() + first_size, data.size() - first_size);
+}
+
+void SharedMemoryQueue::read(uint64 pos, MutableSlice data) const {
+  auto offset = static_cast<size_t>(pos & (capacity_ - 1));
+  auto first_size = td::min(data.size(), capacity_ - offset);
+  std::memcpy(data.data(), data_ + offset, first_size);
+  std::memcpy(data.data() + first_size, data_, data.size() - first_size);
+}
+
+bool SharedMemoryQueue::try_push_part(Slice part, bool has_more_parts) {
+  auto write_pos = header_->write_pos.load(std::memory_order_relaxed);
+  auto read_pos = header_->read_pos.load(std::memory_order_acquire);
+  if (write_pos - read_pos > capacity_) {
+    is_broken_ = true;
+    return false;
+  }
+  auto free_size = capacity_ - static_cast<size_t>(write_pos - read_pos);
+  if (free_size < sizeof(uint32) + part.size()) {
+    return false;
+  }
+
+  char size_buf[sizeof(uint32)];
+  as<uint32>(size_buf) = static_cast<uint32>(part.size()) | (has_more_parts ? HAS_MORE_PARTS_FLAG : 0);
+  write(write_pos, Slice(size_buf, sizeof(size_buf)));
+  write(write_pos + sizeof(uint32), part);
+  header_->write_pos.store(write_pos + sizeof(uint32) + part.size(), std::memory_order_release);
+  return true;
+}
+
+bool SharedMemoryQueue::try_push(Slice message) {
+  if (is_broken_) {
+    return false;
+  }
+  // a part always fits in the empty queue, so big messages can't block the queue
+  auto max_part_size = capacity_ / 2;
+  CHECK(pushed_size_ <= message.size());
+  while (true) {
+    auto part = message.substr(pushed_size_, max_part_size);
+    bool has_more_parts = pushed_size_ + part.size() < message.size();
+    if (!try_push_part(part, has_more_parts)) {
+      return false;
+    }
+    if (!has_more_parts) {
+      pushed_size_ = 0;
+      return true;
+    }
+    pushed_size_ += part.size();
+  }
+}
+
+bool SharedMemoryQueue::try_pop(string &message) {
+  while (!is_broken_) {
+    auto read_pos = header_->read_pos.load(std::memory_order_relaxed);
+    auto write_pos = header_->write_pos.load(std::memory_order_acquire);
+    if (read_pos == write_pos) {
+      return false;
+    }
+    auto used_size = write_pos - read_pos;
+    if (used_size < sizeof(uint32) || used_size > capacity_) {
+      is_broken_ = true;
+      break;
+    }
+
+    char size_buf[sizeof(uint32)];
+    read(read_pos, MutableSlice(size_buf, sizeof(size_buf)));
+    auto size_flags = as<uint32>(size_buf);
+    bool has_more_parts = (size_flags & HAS_MORE_PARTS_FLAG) != 0;
+    auto size = static_cast<size_t>(size_flags & ~HAS_MORE_PARTS_FLAG);
+    if (sizeof(uint32) + size > used_size) {
+      // the size was written by another process, so it can't be trusted
+      is_broken_ = true;
+      break;
+    }
+    if (!has_more_parts && partial_message_.empty()) {
+      message.resize(size);
+      read(read_pos + sizeof(uint32), message);
+      header_->read_pos.store(read_pos + sizeof(uint32) + size, std::memory_order_release);
+      return true;
+    }
+
+    auto old_size = partial_message_.size();
+    partial_message_.resize(old_size + size);
+    read(read_pos + sizeof(uint32), MutableSlice(partial_message_).substr(old_size));
+    header_->read_pos.store(read_pos + sizeof(uint32) + size, std::memory_order_release);
+    if (!has_more_parts) {
+      message = std::move(partial_message_);
+      partial_message_.clear();
+      return true;
+    }
+  }
+  partial_message_.clear();
+  return false;
+}
+
+}  // namespace td
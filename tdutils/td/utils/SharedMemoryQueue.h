@@ -0,0 +1,89 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/port/MemoryMapping.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+#include <atomic>
+
+namespace td {
+
+// Single-producer single-consumer queue of messages stored in a memory-mapped file.
+// The producer and the consumer can be in different processes, which open the same file.
+// There is no notification about new messages, so the consumer must poll the queue.
+// Messages bigger than a half of the capacity are split into parts, which are joined by the consumer.
+class SharedMemoryQueue {
+ public:
+  static constexpr size_t MIN_CAPACITY = 1 << 12;
+  static constexpr size_t MAX_CAPACITY = static_cast<size_t>(1) << 30;
+
+  // creates a new queue, overwriting the file if it exists; capacity must be a power of 2
+  static Result<SharedMemoryQueue> create(CSlice path, size_t capacity) TD_WARN_UNUSED_RESULT;
+
+  // opens a queue created by another process
+  static Result<SharedMemoryQueue> open(CSlice path) TD_WARN_UNUSED_RESULT;
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  // returns false if there is not enough free space in the queue to push the whole message;
+  // then a part of the message can be already pushed and the same message must be passed to the next call
+  bool try_push(Slice message);
+
+  // returns false if the queue doesn't contain a whole message
+  bool try_pop(string &message);
+
+  // returns true if the other process has written inconsistent data to the queue;
+  // try_push and try_pop always fail for a broken queue
+  bool is_broken() const {
+    return is_broken_;
+  }
+
+  SharedMemoryQueue(const SharedMemoryQueue &) = delete;
+  SharedMemoryQueue &operator=(const SharedMemoryQueue &) = delete;
+  SharedMemoryQueue(SharedMemoryQueue &&) noexcept = default;
+  SharedMemoryQueue &operator=(SharedMemoryQueue &&) noexcept = default;
+  ~SharedMemoryQueue() = default;
+
+ private:
+  struct Header {
+    uint64 magic;
+    uint64 capacity;
+    char pad[TD_CONCURRENCY_PAD - 2 * sizeof(uint64)];
+    std::atomic<uint64> write_pos;
+    char pad2[TD_CONCURRENCY_PAD - sizeof(std::atomic<uint64>)];
+    std::atomic<uint64> read_pos;
+    char pad3[TD_CONCURRENCY_PAD - sizeof(std::atomic<uint64>)];
+  };
+  static constexpr uint64 MAGIC = 0x31515348444d5354;  // "TSMDHSQ1"
+  static constexpr uint32 HAS_MORE_PARTS_FLAG = static_cast<uint32>(1) << 31;
+
+  MemoryMapping mapping_;
+  Header *header_ = nullptr;
+  char *data_ = nullptr;
+  size_t capacity_ = 0;
+  size_t pushed_size_ = 0;    // producer side; size of the pushed prefix of the current message
+  string partial_message_;  // consumer side; already received parts of the current message
+  bool is_broken_ = false;
+
+  static bool is_valid_capacity(uint64 capacity);
+
+  explicit SharedMemoryQueue(MemoryMapping mapping);
+
+  static Result<SharedMemoryQueue> map(CSlice path, int64 size);
+
+  void write(uint64 pos, Slice data);
+  void read(uint64 pos, MutableSlice data) const;
+
+  bool try_push_part(Slice part, bool has_more_parts);
+};
+
+}  // namespace td
@@ -0,0 +1,148 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/SmallObjectAllocator.h"
+
+#include "td/utils/port/thread_local.h"
+
+#include <mutex>
+#include <new>
+
+namespace td {
+
+namespace {
+
+constexpr size_t SIZE_CLASS_STEP = 16;
+constexpr size_t SIZE_CLASS_COUNT = SmallObjectAllocator::MAX_SIZE / SIZE_CLASS_STEP;
+constexpr size_t BATCH_SIZE = 64;
+constexpr size_t MAX_SHARED_BATCH_COUNT = 256;
+
+struct FreeNode {
+  FreeNode *next;
+};
+
+struct FreeList {
+  FreeNode *head = nullptr;
+  size_t size = 0;
+
+  void push(FreeNode *node) {
+    node->next = head;
+    head = node;
+    size++;
+  }
+
+  FreeNode *pop() {
+    auto node = head;
+    head = node->next;
+    size--;
+    return node;
+  }
+
+  // moves the first count nodes to a separate list
+  FreeList split(size_t count) {
+    FreeList result;
+    result.head = head;
+    result.size = count;
+    auto tail = head;
+    for (size_t i = 1; i < count; i++) {
+      tail = tail->next;
+    }
+    head = tail->next;
+    size -= count;
+    tail->next = nullptr;
+    return result;
+  }
+
+  void release() {
+    while (head != nullptr) {
+      ::operator delete(pop());
+    }
+  }
+};
+
+struct SharedPool {
+  std::mutex mutex;
+  vector<FreeList> batches;
+};
+
+SharedPool *get_shared_pools() {
+  // the pools are never destroyed, because objects can be deleted until the very end of the process
+  static auto *pools = new SharedPool[SIZE_CLASS_COUNT];
+  return pools;
+}
+
+struct LocalCache {
+  FreeList free_lists[SIZE_CLASS_COUNT];
+
+  LocalCache() = default;
+  LocalCache(const LocalCache &) = delete;
+  LocalCache &operator=(const LocalCache &) = delete;
+  LocalCache(LocalCache &&) = delete;
+  LocalCache &operator=(LocalCache &&) = delete;
+  ~LocalCache() {
+    for (auto &free_list : free_lists) {
+      free_list.release();
+    }
+  }
+};
+
+TD_THREAD_LOCAL LocalCache *local_cache;
+
+size_t get_size_class(size_t size) {
+  return (size - 1) / SIZE_CLASS_STEP;
+}
+
+}  // namespace
+
+void *SmallObjectAllocator::allocate(size_t size) {
+  if (size == 0 || size > MAX_SIZE) {
+    return ::operator new(size);
+  }
+  auto size_class = get_size_class(size);
+  init_thread_local<LocalCache>(local_cache);
+  auto &free_list = local_cache->free_lists[size_class];
+  if (free_list.head == nullptr) {
+    auto &pool = get_shared_pools()[size_class];
+    std::lock_guard<std::mutex> guard(pool.mutex);
+    if (!pool.batches.empty()) {
+      free_list = pool.batches.back();
+      pool.batches.pop_back();
+    }
+  }
+  if (free_list.head == nullptr) {
+    return ::operator new((size_class + 1) * SIZE_CLASS_STEP);
+  }
+  return free_list.pop();
+}
+
+void SmallObjectAllocator::deallocate(void *ptr, size_t size) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  if (size == 0 || size > MAX_SIZE || local_cache == nullptr) {
+    // the thread-local cache can be already destroyed
+    return ::operator delete(ptr);
+  }
+  auto size_class = get_size_class(size);
+  auto &free_list = local_cache->free_lists[size_class];
+  free_list.push(static_cast<FreeNode *>(ptr));
+  if (free_list.size < 2 * BATCH_SIZE) {
+    return;
+  }
+
+  auto batch = free_list.split(BATCH_SIZE);
+  {
+    auto &pool = get_shared_pools()[size_class];
+    std::lock_guard<std::mutex> guard(pool.mutex);
+    if (pool.batches.size() < MAX_SHARED_BATCH_COUNT) {
+      pool.batches.push_back(batch);
+      return;
+    }
+  }
+  batch.release();
+}
+
+}  // namespace td
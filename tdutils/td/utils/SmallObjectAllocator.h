@@ -0,0 +1,26 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// Allocator for many short-lived small objects of different sizes with per-thread free lists grouped by rounded size.
+// Memory freed by a thread that didn't allocate it is cached by the freeing thread; surplus is returned
+// in batches to a shared pool, from which threads with empty free lists take memory back.
+class SmallObjectAllocator {
+ public:
+  static constexpr size_t MAX_SIZE = 256;
+
+  static void *allocate(size_t size);
+
+  // size must be the same as passed to allocate
+  static void deallocate(void *ptr, size_t size) noexcept;
+};
+
+}  // namespace td
@@ -6,7 +6,10 @@
 //
 #pragma once
 
+#include "td/utils/common.h"
+#include "td/utils/LockStatistics.h"
 #include "td/utils/port/sleep.h"
+#include "td/utils/Time.h"
 
 #include <atomic>
 #include <memory>
@@ -40,10 +43,25 @@ class SpinLock {
   using Lock = std::unique_ptr<SpinLock, Unlock>;
 
   Lock lock() {
+#if TD_HAVE_LOCK_STATISTICS
+    static LockStatistics statistics("SpinLock");
+    statistics.on_lock();
+    if (!try_lock()) {
+      auto start_time = Time::now();
+      uint64 spin_count = 0;
+      InfBackoff backoff;
+      while (!try_lock()) {
+        backoff.next();
+        spin_count++;
+      }
+      statistics.on_contention(spin_count, Time::now() - start_time);
+    }
+#else
     InfBackoff backoff;
     while (!try_lock()) {
       backoff.next();
     }
+#endif
     return Lock(this);
   }
   bool try_lock() {
@@ -181,6 +181,12 @@ class Status {
     return Error(0, message);
   }
 
+  // returns an error, which is never deallocated and can be cloned without memory allocation
+  // the returned error is supposed to be stored in a static variable and cloned on each use
+  static Status StaticError(int err, Slice message) TD_WARN_UNUSED_RESULT {
+    return Status(true, ErrorType::General, err, message);
+  }
+
 #if TD_PORT_WINDOWS
   static Status WindowsError(int saved_error, Slice message) TD_WARN_UNUSED_RESULT {
     return Status(false, ErrorType::Os, saved_error, message);
@@ -79,18 +79,34 @@ static char *print_uint(char *current_ptr, T x) {
     return current_ptr;
   }
 
-  auto begin_ptr = current_ptr;
-  do {
-    *current_ptr++ = static_cast<char>('0' + x % 10);
-    x /= 10;
-  } while (x > 0);
-
-  auto end_ptr = current_ptr - 1;
-  while (begin_ptr < end_ptr) {
-    std::swap(*begin_ptr++, *end_ptr--);
+  static const char DIGIT_PAIRS[] =
+      "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+      "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+      "8081828384858687888990919293949596979899";
+
+  size_t length = 3;
+  for (T y = x / 1000; y > 0; y /= 10) {
+    length++;
+  }
+  auto end_ptr = current_ptr + length;
+
+  // write two digits at a time from the end
+  auto ptr = end_ptr;
+  while (x >= 100) {
+    auto pair = static_cast<size_t>(x % 100) * 2;
+    x /= 100;
+    *--ptr = DIGIT_PAIRS[pair + 1];
+    *--ptr = DIGIT_PAIRS[pair];
+  }
+  if (x >= 10) {
+    auto pair = static_cast<size_t>(x) * 2;
+    *--ptr = DIGIT_PAIRS[pair + 1];
+    *--ptr = DIGIT_PAIRS[pair];
+  } else {
+    *--ptr = static_cast<char>('0' + x);
   }
-
-  return current_ptr;
+  DCHECK(ptr == current_ptr);
+  return end_ptr;
 }
 
 template <class T>
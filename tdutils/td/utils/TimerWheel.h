@@ -0,0 +1,255 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/bits.h"
+#include "td/utils/common.h"
+#include "td/utils/Heap.h"
+
+#include <utility>
+
+namespace td {
+
+// Hierarchical timer wheel with the same interface as KHeap<double>; timeouts are stored in HeapNode.
+// Insertion and removal are O(1). To find the earliest timeout at most one slot is scanned, and timeouts
+// from higher levels are moved to lower levels, so each timeout is moved at most LEVEL_COUNT times.
+// Position of a node isn't related to its order, so HeapNode::is_top must not be used, use is_top(node) instead.
+class TimerWheel {
+ public:
+  static constexpr int32 TICKS_PER_SECOND = 1000;
+
+  bool empty() const {
+    return size_ == 0;
+  }
+  size_t size() const {
+    return size_;
+  }
+
+  double top_key() {
+    find_top();
+    return top_key_;
+  }
+
+  const HeapNode *top() {
+    find_top();
+    return top_node_;
+  }
+
+  bool is_top(const HeapNode *node) {
+    return !empty() && top() == node;
+  }
+
+  double get_key(const HeapNode *node) const {
+    return get_item(node).key_;
+  }
+
+  HeapNode *pop() {
+    CHECK(!empty());
+    find_top();
+    HeapNode *result = top_node_;
+    erase(result);
+    return result;
+  }
+
+  void insert(double key, HeapNode *node) {
+    CHECK(!node->in_heap());
+    do_insert(Item{key, node});
+    size_++;
+    if (top_node_ != nullptr && key < top_key_) {
+      top_key_ = key;
+      top_node_ = node;
+    }
+  }
+
+  void fix(double key, HeapNode *node) {
+    erase(node);
+    insert(key, node);
+  }
+
+  void erase(HeapNode *node) {
+    CHECK(node->in_heap());
+    auto slot_id = get_slot_id(node);
+    auto pos = get_slot_pos(node);
+    auto &slot = slots_[slot_id];
+    CHECK(pos < slot.size());
+    if (pos + 1 != slot.size()) {
+      slot[pos] = slot.back();
+      slot[pos].node_->pos_ = encode_pos(slot_id, pos);
+    }
+    slot.pop_back();
+    if (slot.empty() && slot_id != OVERFLOW_SLOT_ID) {
+      occupied_[slot_id / SLOT_COUNT] &= ~(static_cast<uint64>(1) << (slot_id % SLOT_COUNT));
+    }
+    node->remove();
+    size_--;
+    if (node == top_node_) {
+      top_node_ = nullptr;
+    }
+  }
+
+  template <class F>
+  void for_each(F &&f) const {
+    for (auto &slot : slots_) {
+      for (auto &it : slot) {
+        f(it.key_, it.node_);
+      }
+    }
+  }
+
+  void check() const {
+    size_t size = 0;
+    for (size_t slot_id = 0; slot_id < TOTAL_SLOT_COUNT; slot_id++) {
+      auto &slot = slots_[slot_id];
+      for (size_t pos = 0; pos < slot.size(); pos++) {
+        CHECK(slot[pos].node_->pos_ == encode_pos(slot_id, pos));
+      }
+      if (slot_id != OVERFLOW_SLOT_ID) {
+        bool is_occupied = ((occupied_[slot_id / SLOT_COUNT] >> (slot_id % SLOT_COUNT)) & 1) != 0;
+        CHECK(is_occupied == !slot.empty());
+      }
+      size += slot.size();
+    }
+    CHECK(size == size_);
+  }
+
+ private:
+  static constexpr int32 LEVEL_BITS = 6;
+  static constexpr size_t SLOT_COUNT = static_cast<size_t>(1) << LEVEL_BITS;
+  static constexpr int32 LEVEL_COUNT = 5;  // 2^30 ticks, i.e. more than 12 days, before the overflow slot
+  static constexpr size_t OVERFLOW_SLOT_ID = LEVEL_COUNT * SLOT_COUNT;
+  static constexpr size_t TOTAL_SLOT_COUNT = OVERFLOW_SLOT_ID + 1;
+  static constexpr int32 POS_BITS = 22;
+  static constexpr int64 MAX_TICK = static_cast<int64>(1) << 62;
+
+  struct Item {
+    double key_;
+    HeapNode *node_;
+  };
+  vector<Item> slots_[TOTAL_SLOT_COUNT];
+  uint64 occupied_[LEVEL_COUNT] = {};
+  size_t size_ = 0;
+
+  // all stored timeouts, except overdue ones, which are stored in the current slot, have tick >= current_tick_
+  int64 current_tick_ = 0;
+
+  double top_key_ = 0.0;
+  HeapNode *top_node_ = nullptr;
+
+  static int32 encode_pos(size_t slot_id, size_t pos) {
+    CHECK(pos < (static_cast<size_t>(1) << POS_BITS));
+    // never return 0 to keep HeapNode::is_top false
+    return static_cast<int32>(((slot_id + 1) << POS_BITS) | pos);
+  }
+
+  static size_t get_slot_id(const HeapNode *node) {
+    return (static_cast<size_t>(node->pos_) >> POS_BITS) - 1;
+  }
+
+  static size_t get_slot_pos(const HeapNode *node) {
+    return static_cast<size_t>(node->pos_) & ((static_cast<size_t>(1) << POS_BITS) - 1);
+  }
+
+  const Item &get_item(const HeapNode *node) const {
+    CHECK(node->in_heap());
+    auto slot_id = get_slot_id(node);
+    auto pos = get_slot_pos(node);
+    CHECK(slot_id < TOTAL_SLOT_COUNT);
+    CHECK(pos < slots_[slot_id].size());
+    return slots_[slot_id][pos];
+  }
+
+  static int64 to_tick(double key) {
+    if (!(key > 0)) {
+      return 0;
+    }
+    if (key >= static_cast<double>(MAX_TICK / TICKS_PER_SECOND)) {
+      return MAX_TICK;
+    }
+    return static_cast<int64>(key * TICKS_PER_SECOND);
+  }
+
+  size_t get_slot_id(int64 tick) const {
+    auto diff = static_cast<uint64>(tick ^ current_tick_);
+    for (int32 level = 0; level < LEVEL_COUNT; level++) {
+      if ((diff >> ((level + 1) * LEVEL_BITS)) == 0) {
+        return level * SLOT_COUNT + (static_cast<size_t>(tick >> (level * LEVEL_BITS)) & (SLOT_COUNT - 1));
+      }
+    }
+    return OVERFLOW_SLOT_ID;
+  }
+
+  void do_insert(Item item) {
+    auto tick = max(to_tick(item.key_), current_tick_);
+    auto slot_id = get_slot_id(tick);
+    auto &slot = slots_[slot_id];
+    item.node_->pos_ = encode_pos(slot_id, slot.size());
+    slot.push_back(item);
+    if (slot_id != OVERFLOW_SLOT_ID) {
+      occupied_[slot_id / SLOT_COUNT] |= static_cast<uint64>(1) << (slot_id % SLOT_COUNT);
+    }
+  }
+
+  void redistribute(size_t slot_id) {
+    auto items = std::move(slots_[slot_id]);
+    slots_[slot_id] = vector<Item>();
+    if (slot_id != OVERFLOW_SLOT_ID) {
+      occupied_[slot_id / SLOT_COUNT] &= ~(static_cast<uint64>(1) << (slot_id % SLOT_COUNT));
+    }
+    for (auto &item : items) {
+      do_insert(item);
+    }
+  }
+
+  void find_top() {
+    while (top_node_ == nullptr && size_ != 0) {
+      int32 level = 0;
+      while (level < LEVEL_COUNT && occupied_[level] == 0) {
+        level++;
+      }
+
+      if (level == 0) {
+        // all timeouts in a slot of the lowest level have the same tick, unless they are overdue
+        auto &slot = slots_[count_trailing_zeroes64(occupied_[0])];
+        CHECK(!slot.empty());
+        top_key_ = slot[0].key_;
+        top_node_ = slot[0].node_;
+        for (auto &item : slot) {
+          if (item.key_ < top_key_) {
+            top_key_ = item.key_;
+            top_node_ = item.node_;
+          }
+        }
+        return;
+      }
+
+      // there are no timeouts before the first occupied slot, so the current tick can be moved to its beginning
+      int64 new_tick;
+      size_t slot_id;
+      if (level < LEVEL_COUNT) {
+        auto slot = count_trailing_zeroes64(occupied_[level]);
+        auto shift = level * LEVEL_BITS;
+        new_tick = ((current_tick_ >> (shift + LEVEL_BITS)) << (shift + LEVEL_BITS)) | (static_cast<int64>(slot) << shift);
+        slot_id = level * SLOT_COUNT + slot;
+      } else {
+        auto &slot = slots_[OVERFLOW_SLOT_ID];
+        CHECK(!slot.empty());
+        auto min_tick = MAX_TICK;
+        for (auto &item : slot) {
+          min_tick = min(min_tick, to_tick(item.key_));
+        }
+        auto shift = LEVEL_COUNT * LEVEL_BITS;
+        new_tick = (min_tick >> shift) << shift;
+        slot_id = OVERFLOW_SLOT_ID;
+      }
+      CHECK(new_tick > current_tick_);
+      current_tick_ = new_tick;
+      redistribute(slot_id);
+    }
+  }
+};
+
+}  // namespace td
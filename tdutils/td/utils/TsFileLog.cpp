@@ -9,12 +9,15 @@
 #include "td/utils/common.h"
 #include "td/utils/FileLog.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/EventFd.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 
 #include <array>
 #include <atomic>
+#include <cstring>
 #include <limits>
 #include <mutex>
 
@@ -23,14 +26,45 @@ namespace td {
 namespace detail {
 class TsFileLog final : public LogInterface {
  public:
-  Status init(string path, int64 rotate_threshold, bool redirect_stderr) {
+  TsFileLog() = default;
+  TsFileLog(const TsFileLog &) = delete;
+  TsFileLog &operator=(const TsFileLog &) = delete;
+  TsFileLog(TsFileLog &&) = delete;
+  TsFileLog &operator=(TsFileLog &&) = delete;
+  ~TsFileLog() final {
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+    if (buffer_size_ != 0) {
+      is_closing_ = true;
+      event_fd_.release();
+      writer_thread_.join();
+      event_fd_.close();
+    }
+#endif
+  }
+
+  Status init(string path, int64 rotate_threshold, bool redirect_stderr, size_t thread_buffer_size) {
     path_ = std::move(path);
     rotate_threshold_ = rotate_threshold;
     redirect_stderr_ = redirect_stderr;
     for (size_t i = 0; i < logs_.size(); i++) {
       logs_[i].id = i;
     }
-    return init_info(&logs_[0]);
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+    if (thread_buffer_size != 0) {
+      buffer_size_ = 1;
+      while (buffer_size_ < thread_buffer_size) {
+        buffer_size_ *= 2;
+      }
+    }
+#endif
+    TRY_STATUS(init_info(&logs_[0]));
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+    if (buffer_size_ != 0) {
+      event_fd_.init();
+      writer_thread_ = td::thread([this] { run_writer(); });
+    }
+#endif
+    return Status::OK();
   }
 
   void rotate() {
@@ -42,19 +76,75 @@ class TsFileLog final : public LogInterface {
   }
 
  private:
+  // single-producer single-consumer queue of bytes, which are written by the owning thread
+  class RingBuffer {
+   public:
+    explicit RingBuffer(size_t size) : data_(size), mask_(size - 1) {
+      CHECK((size & mask_) == 0);
+    }
+
+    bool try_write(Slice slice) {
+      auto write_pos = write_pos_.load(std::memory_order_relaxed);
+      auto read_pos = read_pos_.load(std::memory_order_acquire);
+      if (slice.size() > data_.size() - (write_pos - read_pos)) {
+        return false;
+      }
+      auto offset = write_pos & mask_;
+      auto first_size = td::min(slice.size(), data_.size() - offset);
+      std::memcpy(&data_[offset], slice.data(), first_size);
+      std::memcpy(&data_[0], slice.data() + first_size, slice.size() - first_size);
+      write_pos_.store(write_pos + slice.size());
+      return true;
+    }
+
+    // must not be called concurrently with itself
+    bool read_to(string &buffer) {
+      auto read_pos = read_pos_.load(std::memory_order_relaxed);
+      auto write_pos = write_pos_.load();
+      if (read_pos == write_pos) {
+        return false;
+      }
+      auto size = write_pos - read_pos;
+      auto offset = read_pos & mask_;
+      auto first_size = td::min(size, data_.size() - offset);
+      buffer.append(&data_[offset], first_size);
+      buffer.append(&data_[0], size - first_size);
+      read_pos_.store(write_pos, std::memory_order_release);
+      return true;
+    }
+
+   private:
+    vector<char> data_;
+    size_t mask_;
+    std::atomic<size_t> write_pos_{0};
+    char pad_[TD_CONCURRENCY_PAD - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> read_pos_{0};
+  };
+
   struct Info {
     FileLog log;
     std::atomic<bool> is_inited{false};
     size_t id;
+    unique_ptr<RingBuffer> buffer;
+    std::atomic<uint64> dropped_count{0};
+    std::mutex flush_mutex;  // taken by the thread, which writes data from the buffer to the log
   };
 
-  static constexpr size_t MAX_THREAD_ID = 128;
+  static constexpr size_t MAX_THREAD_ID = TD_MAX_THREAD_COUNT;
   int64 rotate_threshold_ = 0;
   bool redirect_stderr_ = false;
   std::string path_;
   std::array<Info, MAX_THREAD_ID> logs_;
   std::mutex init_mutex_;
 
+  size_t buffer_size_ = 0;
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  std::atomic<bool> has_pending_data_{false};
+  std::atomic<bool> is_closing_{false};
+  EventFd event_fd_;
+  td::thread writer_thread_;
+#endif
+
   LogInterface *get_current_logger() {
     auto *info = get_current_info();
     if (!info->is_inited.load(std::memory_order_relaxed)) {
@@ -72,10 +162,57 @@ class TsFileLog final : public LogInterface {
 
   Status init_info(Info *info) {
     TRY_STATUS(info->log.init(get_path(info), std::numeric_limits<int64>::max(), info->id == 0 && redirect_stderr_));
+    if (buffer_size_ != 0) {
+      info->buffer = make_unique<RingBuffer>(buffer_size_);
+    }
     info->is_inited = true;
     return Status::OK();
   }
 
+  // writes all buffered data of the thread to its file
+  static bool flush_info(Info *info, string &buffer) {
+    buffer.clear();
+    bool has_data = info->buffer->read_to(buffer);
+    auto dropped_count = info->dropped_count.exchange(0, std::memory_order_relaxed);
+    if (dropped_count != 0) {
+      buffer += PSTRING() << "!!! " << dropped_count << " log messages were dropped !!!\n";
+    }
+    if (buffer.empty()) {
+      return has_data;
+    }
+    static_cast<LogInterface &>(info->log).do_append(VERBOSITY_NAME(INFO), buffer);
+    return true;
+  }
+
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  void run_writer() {
+    string buffer;
+    while (true) {
+      has_pending_data_ = false;
+      bool need_close = is_closing_.load();
+      for (auto &info : logs_) {
+        if (info.is_inited.load() && info.buffer != nullptr) {
+          std::lock_guard<std::mutex> guard(info.flush_mutex);
+          flush_info(&info, buffer);
+        }
+      }
+      if (need_close) {
+        break;
+      }
+      if (!has_pending_data_.load()) {
+        event_fd_.wait(1000);
+      }
+      event_fd_.acquire();
+    }
+  }
+
+  void notify_writer() {
+    if (!has_pending_data_.load(std::memory_order_relaxed) && !has_pending_data_.exchange(true)) {
+      event_fd_.release();
+    }
+  }
+#endif
+
   string get_path(const Info *info) const {
     if (info->id == 0) {
       return path_;
@@ -84,7 +221,28 @@ class TsFileLog final : public LogInterface {
   }
 
   void do_append(int log_level, CSlice slice) final {
-    get_current_logger()->do_append(log_level, slice);
+    auto *logger = get_current_logger();
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+    auto *info = get_current_info();
+    if (info->buffer != nullptr) {
+      if (log_level != VERBOSITY_NAME(FATAL) && slice.size() <= buffer_size_) {
+        if (!info->buffer->try_write(slice)) {
+          // never block the thread on disk I/O; the writer will report the number of dropped messages
+          info->dropped_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        notify_writer();
+        return;
+      }
+
+      // fatal errors and too long messages are written synchronously after all buffered data
+      std::lock_guard<std::mutex> guard(info->flush_mutex);
+      string buffer;
+      flush_info(info, buffer);
+      logger->do_append(log_level, slice);
+      return;
+    }
+#endif
+    logger->do_append(log_level, slice);
   }
 
   vector<string> get_file_paths() final {
@@ -97,9 +255,10 @@ class TsFileLog final : public LogInterface {
 };
 }  // namespace detail
 
-Result<unique_ptr<LogInterface>> TsFileLog::create(string path, int64 rotate_threshold, bool redirect_stderr) {
+Result<unique_ptr<LogInterface>> TsFileLog::create(string path, int64 rotate_threshold, bool redirect_stderr,
+                                                   size_t thread_buffer_size) {
   auto res = make_unique<detail::TsFileLog>();
-  TRY_STATUS(res->init(std::move(path), rotate_threshold, redirect_stderr));
+  TRY_STATUS(res->init(std::move(path), rotate_threshold, redirect_stderr, thread_buffer_size));
   return std::move(res);
 }
 
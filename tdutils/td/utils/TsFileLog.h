@@ -16,8 +16,10 @@ class TsFileLog {
   static constexpr int64 DEFAULT_ROTATE_THRESHOLD = 10 * (1 << 20);
 
  public:
+  // if thread_buffer_size is non-zero, messages are stored in per-thread buffers of the specified size and are
+  // written to the files by a separate thread; messages that don't fit in a full buffer are dropped and counted
   static Result<unique_ptr<LogInterface>> create(string path, int64 rotate_threshold = DEFAULT_ROTATE_THRESHOLD,
-                                                 bool redirect_stderr = true);
+                                                 bool redirect_stderr = true, size_t thread_buffer_size = 0);
 };
 
 }  // namespace td
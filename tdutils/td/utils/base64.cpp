@@ -13,6 +13,14 @@
 #include <algorithm>
 #include <iterator>
 
+#if (TD_GCC || TD_CLANG) && defined(__x86_64__)
+#define TD_HAVE_BASE64_SSSE3 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define TD_HAVE_BASE64_SSSE3 0
+#endif
+
 namespace td {
 
 template <bool is_url>
@@ -36,31 +44,144 @@ static const unsigned char *get_character_table() {
   return char_to_value;
 }
 
+#if TD_HAVE_BASE64_SSSE3
+#define TD_BASE64_SSSE3_TARGET __attribute__((target("sse2,ssse3")))
+
+static bool has_ssse3() {
+  static const bool result = [] {
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0 && (ecx & bit_SSSE3) != 0;
+  }();
+  return result;
+}
+
+// encodes 12 bytes into 16 characters per iteration while at least 16 bytes can be read from the input;
+// returns the number of encoded 3-byte groups
+TD_BASE64_SSSE3_TARGET static size_t base64_encode_ssse3(const unsigned char *src, size_t size, char *dst,
+                                                         bool is_url) {
+  // maps index of a character range to the difference between the character and its 6-bit value
+  const __m128i shift_table = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52, (is_url ? '-' : '+') - 62,
+                                            (is_url ? '_' : '/') - 63, 'A', 0, 0);
+  size_t group_count = 0;
+  while (size >= 16) {
+    auto in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    // spread each 3 bytes a, b, c into 4 bytes b, a, c, b and extract 6-bit values with multiplications
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    auto high = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    auto low = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    auto values = _mm_or_si128(high, low);
+
+    // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+    auto range = _mm_subs_epu8(values, _mm_set1_epi8(51));
+    range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), values), _mm_set1_epi8(13)));
+    auto characters = _mm_add_epi8(values, _mm_shuffle_epi8(shift_table, range));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), characters);
+
+    src += 12;
+    dst += 16;
+    size -= 12;
+    group_count += 4;
+  }
+  return group_count;
+}
+
+static __m128i base64_in_range(__m128i in, char from, char to) {
+  return _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(static_cast<char>(from - 1))),
+                       _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(to + 1)), in));
+}
+
+// decodes 16 characters into 12 bytes per iteration while at least 16 bytes can be written to the output;
+// stops before the first group with a wrong character to leave error reporting to the scalar code;
+// returns the number of decoded 4-character groups
+TD_BASE64_SSSE3_TARGET static size_t base64_decode_ssse3(const unsigned char *src, size_t size, char *dst,
+                                                         bool is_url) {
+  const char char62 = is_url ? '-' : '+';
+  const char char63 = is_url ? '_' : '/';
+  size_t group_count = 0;
+  while (size >= 24) {
+    auto in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    // characters with the highest bit set are negative and don't belong to any range
+    auto is_upper = base64_in_range(in, 'A', 'Z');
+    auto is_lower = base64_in_range(in, 'a', 'z');
+    auto is_digit = base64_in_range(in, '0', '9');
+    auto is_62 = _mm_cmpeq_epi8(in, _mm_set1_epi8(char62));
+    auto is_63 = _mm_cmpeq_epi8(in, _mm_set1_epi8(char63));
+    auto is_valid = _mm_or_si128(_mm_or_si128(is_upper, is_lower), _mm_or_si128(is_digit, _mm_or_si128(is_62, is_63)));
+    if (_mm_movemask_epi8(is_valid) != 0xFFFF) {
+      break;
+    }
+    auto shift = _mm_or_si128(_mm_and_si128(is_upper, _mm_set1_epi8(-'A')),
+                              _mm_and_si128(is_lower, _mm_set1_epi8(static_cast<char>(26 - 'a'))));
+    shift = _mm_or_si128(shift, _mm_and_si128(is_digit, _mm_set1_epi8(static_cast<char>(52 - '0'))));
+    shift = _mm_or_si128(shift, _mm_and_si128(is_62, _mm_set1_epi8(static_cast<char>(62 - char62))));
+    shift = _mm_or_si128(shift, _mm_and_si128(is_63, _mm_set1_epi8(static_cast<char>(63 - char63))));
+    auto values = _mm_add_epi8(in, shift);
+
+    // merge 4 6-bit values into 3 bytes in each 32-bit lane and move the bytes to the beginning in big-endian order
+    auto merged = _mm_madd_epi16(_mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+    auto out = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), out);
+
+    src += 16;
+    dst += 12;
+    size -= 16;
+    group_count += 4;
+  }
+  return group_count;
+}
+#endif
+
 template <bool is_url>
 string base64_encode_impl(Slice input) {
   auto characters = get_characters<is_url>();
-  string base64;
-  base64.reserve((input.size() + 2) / 3 * 4);
-  for (size_t i = 0; i < input.size();) {
-    size_t left = min(input.size() - i, static_cast<size_t>(3));
-    int c = input.ubegin()[i++] << 16;
-    base64 += characters[c >> 18];
-    if (left != 1) {
-      c |= input.ubegin()[i++] << 8;
-    }
-    base64 += characters[(c >> 12) & 63];
-    if (left == 3) {
-      c |= input.ubegin()[i++];
+  auto full_group_count = input.size() / 3;
+  auto left = input.size() % 3;
+  size_t size = full_group_count * 4;
+  if (left != 0) {
+    size += is_url ? left + 1 : 4;
+  }
+  string base64(size, '\0');
+  if (size == 0) {
+    return base64;
+  }
+
+  auto *src = input.ubegin();
+  auto *dst = &base64[0];
+  size_t i = 0;
+#if TD_HAVE_BASE64_SSSE3
+  if (has_ssse3()) {
+    i = base64_encode_ssse3(src, input.size(), dst, is_url);
+    src += i * 3;
+    dst += i * 4;
+  }
+#endif
+  for (; i < full_group_count; i++) {
+    auto c = (static_cast<uint32>(src[0]) << 16) | (static_cast<uint32>(src[1]) << 8) | src[2];
+    dst[0] = characters[c >> 18];
+    dst[1] = characters[(c >> 12) & 63];
+    dst[2] = characters[(c >> 6) & 63];
+    dst[3] = characters[c & 63];
+    src += 3;
+    dst += 4;
+  }
+  if (left != 0) {
+    auto c = static_cast<uint32>(src[0]) << 16;
+    if (left == 2) {
+      c |= static_cast<uint32>(src[1]) << 8;
     }
-    if (left != 1) {
-      base64 += characters[(c >> 6) & 63];
+    dst[0] = characters[c >> 18];
+    dst[1] = characters[(c >> 12) & 63];
+    if (left == 2) {
+      dst[2] = characters[(c >> 6) & 63];
     } else if (!is_url) {
-      base64 += '=';
+      dst[2] = '=';
     }
-    if (left == 3) {
-      base64 += characters[c & 63];
-    } else if (!is_url) {
-      base64 += '=';
+    if (!is_url) {
+      dst[3] = '=';
     }
   }
   return base64;
@@ -93,7 +214,36 @@ Result<Slice> base64_drop_padding(Slice base64) {
   return base64;
 }
 
+template <bool is_url>
 static Status do_base64_decode_impl(Slice base64, const unsigned char *table, char *ptr) {
+  // decode full groups of 4 characters with a single check for wrong characters
+  auto full_group_count = base64.size() / 4;
+  auto *src = base64.ubegin();
+  size_t group_index = 0;
+#if TD_HAVE_BASE64_SSSE3
+  if (has_ssse3()) {
+    group_index = base64_decode_ssse3(src, base64.size(), ptr, is_url);
+    src += group_index * 4;
+    ptr += group_index * 3;
+  }
+#endif
+  for (; group_index < full_group_count; group_index++) {
+    uint32 a = table[src[0]];
+    uint32 b = table[src[1]];
+    uint32 c = table[src[2]];
+    uint32 d = table[src[3]];
+    if (((a | b | c | d) & 64) != 0) {
+      return Status::Error("Wrong character in the string");
+    }
+    auto value = (a << 18) | (b << 12) | (c << 6) | d;
+    ptr[0] = static_cast<char>(static_cast<unsigned char>(value >> 16));  // implementation-defined
+    ptr[1] = static_cast<char>(static_cast<unsigned char>(value >> 8));   // implementation-defined
+    ptr[2] = static_cast<char>(static_cast<unsigned char>(value));        // implementation-defined
+    src += 4;
+    ptr += 3;
+  }
+  base64.remove_prefix(full_group_count * 4);
+
   for (size_t i = 0; i < base64.size();) {
     size_t left = min(base64.size() - i, static_cast<size_t>(4));
     int c = 0;
@@ -141,7 +291,7 @@ static Result<T> base64_decode_impl(Slice base64) {
   TRY_RESULT_ASSIGN(base64, base64_drop_padding<is_url>(base64));
 
   T result = create_empty<T>(base64.size() / 4 * 3 + ((base64.size() & 3) + 1) / 2);
-  TRY_STATUS(do_base64_decode_impl(base64, get_character_table<is_url>(), as_mutable_slice(result).begin()));
+  TRY_STATUS(do_base64_decode_impl<is_url>(base64, get_character_table<is_url>(), as_mutable_slice(result).begin()));
   return std::move(result);
 }
 
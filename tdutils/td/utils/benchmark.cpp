@@ -0,0 +1,105 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/benchmark.h"
+
+#include "td/utils/JsonBuilder.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/StackAllocator.h"
+#include "td/utils/Status.h"
+
+#include <cstdlib>
+
+namespace td {
+namespace detail {
+
+static CSlice get_benchmark_option(const char *name) {
+  const char *value = std::getenv(name);
+  return value == nullptr ? CSlice() : CSlice(value);
+}
+
+static string get_benchmark_csv(const BenchmarkResult &result) {
+  string description;
+  for (auto c : result.description) {
+    if (c == '"') {
+      description += '"';
+    }
+    description += c;
+  }
+  return PSTRING() << result.n << ',' << result.repetition_count << ','
+                   << StringBuilder::FixedDouble(result.mean_time * 1e9, 3) << ','
+                   << StringBuilder::FixedDouble(result.stddev_time * 1e9, 3) << ','
+                   << StringBuilder::FixedDouble(result.min_time * 1e9, 3) << ','
+                   << StringBuilder::FixedDouble(result.max_time * 1e9, 3) << ','
+                   << StringBuilder::FixedDouble(result.cycles, 1) << ",\"" << description << '"';
+}
+
+static string get_benchmark_json(const BenchmarkResult &result) {
+  auto buf = StackAllocator::alloc(1 << 12);
+  JsonBuilder jb(StringBuilder(buf.as_slice(), true));
+  auto object = jb.enter_object();
+  object("description", result.description);
+  object("n", result.n);
+  object("repetitions", result.repetition_count);
+  object("mean_ns", result.mean_time * 1e9);
+  object("stddev_ns", result.stddev_time * 1e9);
+  object("min_ns", result.min_time * 1e9);
+  object("max_ns", result.max_time * 1e9);
+  object("cycles", result.cycles);
+  object.leave();
+  return jb.string_builder().as_cslice().str();
+}
+
+int get_benchmark_repetition_count() {
+  auto repetitions = get_benchmark_option("TD_BENCHMARK_REPETITIONS");
+  if (repetitions.empty()) {
+    return 2;
+  }
+  return clamp(to_integer<int>(repetitions), 1, 1000);
+}
+
+void report_benchmark_result(const BenchmarkResult &result) {
+  auto format = get_benchmark_option("TD_BENCHMARK_FORMAT");
+  if (format.empty() || format == "text") {
+    std::string pad;
+    if (result.description.size() < 40) {
+      pad = std::string(40 - result.description.size(), ' ');
+    }
+    auto ops = 1 / result.mean_time;
+    LOG(ERROR) << "Bench [" << pad << result.description << "]: " << StringBuilder::FixedDouble(ops, 3) << '['
+               << StringBuilder::FixedDouble(1 / result.max_time, 3) << '-'
+               << StringBuilder::FixedDouble(1 / result.min_time, 3) << "] ops/sec,\t"
+               << format::as_time(result.mean_time) << " [d = " << format::as_time(result.stddev_time) << ']';
+    return;
+  }
+
+  string line;
+  if (format == "csv") {
+    line = get_benchmark_csv(result);
+  } else if (format == "json") {
+    line = get_benchmark_json(result);
+  } else {
+    LOG(FATAL) << "Unsupported benchmark output format " << format;
+  }
+
+  auto output_path = get_benchmark_option("TD_BENCHMARK_OUTPUT");
+  if (output_path.empty()) {
+    LOG(PLAIN) << line;
+    return;
+  }
+  line += '\n';
+  auto r_fd = FileFd::open(output_path, FileFd::Write | FileFd::Create | FileFd::Append);
+  LOG_IF(FATAL, r_fd.is_error()) << "Can't open " << output_path << ": " << r_fd.error();
+  auto fd = r_fd.move_as_ok();
+  fd.write(line).ensure();
+  fd.close();
+}
+
+}  // namespace detail
+}  // namespace td
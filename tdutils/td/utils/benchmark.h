@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/Clocks.h"
@@ -68,65 +69,109 @@ class Benchmark {
   virtual void run(int n) = 0;
 };
 
-inline std::pair<double, double> bench_n(Benchmark &b, int n) {
-  double total = -Clocks::monotonic();
+// the result of a benchmark; all times are per iteration and are measured in seconds
+struct BenchmarkResult {
+  string description;
+  int n = 0;
+  int repetition_count = 0;
+  double mean_time = 0.0;
+  double stddev_time = 0.0;
+  double min_time = 0.0;
+  double max_time = 0.0;
+  double cycles = 0.0;  // the number of TSC ticks per iteration or 0 if it is unknown
+};
+
+namespace detail {
+
+struct BenchmarkPass {
+  double time = 0.0;
+  double total_time = 0.0;
+  uint64 cycles = 0;
+};
+
+inline uint64 get_cpu_cycles() {
+#if (TD_GCC || TD_CLANG) && (defined(__x86_64__) || defined(__i386__))
+  return __builtin_ia32_rdtsc();
+#else
+  return 0;
+#endif
+}
+
+inline BenchmarkPass bench_pass(Benchmark &b, int n) {
+  BenchmarkPass result;
+  result.total_time = -Clocks::monotonic();
   b.start_up_n(n);
-  double t = -Clocks::monotonic();
+  result.time = -Clocks::monotonic();
+  auto begin_cycles = get_cpu_cycles();
   b.run(n);
-  t += Clocks::monotonic();
+  result.cycles = get_cpu_cycles() - begin_cycles;
+  result.time += Clocks::monotonic();
   b.tear_down();
-  total += Clocks::monotonic();
+  result.total_time += Clocks::monotonic();
+  return result;
+}
+
+// returns TD_BENCHMARK_REPETITIONS or 2 if it isn't specified
+int get_benchmark_repetition_count();
+
+void report_benchmark_result(const BenchmarkResult &result);
 
-  return std::make_pair(t, total);
+}  // namespace detail
+
+inline std::pair<double, double> bench_n(Benchmark &b, int n) {
+  auto pass = detail::bench_pass(b, n);
+  return std::make_pair(pass.time, pass.total_time);
 }
 
 inline std::pair<double, double> bench_n(Benchmark &&b, int n) {
   return bench_n(b, n);
 }
 
-inline void bench(Benchmark &b, double max_time = 1.0) {
+// runs the benchmark with the number of iterations, for which it takes at least max_time seconds,
+// TD_BENCHMARK_REPETITIONS times (2 by default), and reports the result in the format specified by
+// TD_BENCHMARK_FORMAT ("text" by default, "csv" or "json") to the file TD_BENCHMARK_OUTPUT or to the log
+inline BenchmarkResult bench(Benchmark &b, double max_time = 1.0) {
   int n = 1;
-  double pass_time = 0;
-  double total_pass_time = 0;
-  while (pass_time < max_time && total_pass_time < max_time * 3 && n < (1 << 30)) {
+  detail::BenchmarkPass pass;
+  while (pass.time < max_time && pass.total_time < max_time * 3 && n < (1 << 30)) {
     n *= 2;
-    std::tie(pass_time, total_pass_time) = bench_n(b, n);
+    pass = detail::bench_pass(b, n);
   }
-  pass_time = n / pass_time;
-
-  int pass_cnt = 2;
-  double sum = pass_time;
-  double square_sum = pass_time * pass_time;
-  double min_pass_time = pass_time;
-  double max_pass_time = pass_time;
-
-  for (int i = 1; i < pass_cnt; i++) {
-    pass_time = n / bench_n(b, n).first;
-    sum += pass_time;
-    square_sum += pass_time * pass_time;
-    if (pass_time < min_pass_time) {
-      min_pass_time = pass_time;
+
+  int repetition_count = detail::get_benchmark_repetition_count();
+
+  BenchmarkResult result;
+  result.description = b.get_description();
+  result.n = n;
+  result.repetition_count = repetition_count;
+  double sum = 0.0;
+  double square_sum = 0.0;
+  double cycles_sum = 0.0;
+  for (int i = 0; i < repetition_count; i++) {
+    if (i > 0) {
+      pass = detail::bench_pass(b, n);
     }
-    if (pass_time > max_pass_time) {
-      max_pass_time = pass_time;
+    double time = pass.time / n;
+    sum += time;
+    square_sum += time * time;
+    cycles_sum += static_cast<double>(pass.cycles) / n;
+    if (i == 0 || time < result.min_time) {
+      result.min_time = time;
+    }
+    if (i == 0 || time > result.max_time) {
+      result.max_time = time;
     }
   }
-  double average = sum / pass_cnt;
-  double d = sqrt(square_sum / pass_cnt - average * average);
-
-  auto description = b.get_description();
-  std::string pad;
-  if (description.size() < 40) {
-    pad = std::string(40 - description.size(), ' ');
-  }
+  result.mean_time = sum / repetition_count;
+  result.stddev_time = std::sqrt(max(square_sum / repetition_count - result.mean_time * result.mean_time, 0.0));
+  result.cycles = cycles_sum / repetition_count;
 
-  LOG(ERROR) << "Bench [" << pad << description << "]: " << StringBuilder::FixedDouble(average, 3) << '['
-             << StringBuilder::FixedDouble(min_pass_time, 3) << '-' << StringBuilder::FixedDouble(max_pass_time, 3)
-             << "] ops/sec,\t" << format::as_time(1 / average) << " [d = " << StringBuilder::FixedDouble(d, 6) << ']';
+  detail::report_benchmark_result(result);
+  return result;
 }
 
-inline void bench(Benchmark &&b, double max_time = 1.0) {
-  bench(b, max_time);
+inline BenchmarkResult bench(Benchmark &&b, double max_time = 1.0) {
+  return bench(b, max_time);
 }
 
 }  // namespace td
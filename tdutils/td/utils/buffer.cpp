@@ -33,9 +33,22 @@ size_t BufferAllocator::get_buffer_mem() {
   return buffer_mem;
 }
 
+size_t BufferAllocator::get_thread_buffer_mem() {
+  if (buffer_raw_tls == nullptr) {
+    return 0;
+  }
+  size_t result = 0;
+  for (auto *buffer_raw : {buffer_raw_tls->buffer_raw.get(), buffer_raw_tls->arena_buffer_raw.get()}) {
+    if (buffer_raw != nullptr) {
+      result += buffer_raw->data_size_;
+    }
+  }
+  return result;
+}
+
 BufferAllocator::WriterPtr BufferAllocator::create_writer(size_t size) {
-  if (size < 512) {
-    size = 512;
+  if (size < MIN_BUFFER_SIZE) {
+    size = MIN_BUFFER_SIZE;
   }
   return create_writer_exact(size);
 }
@@ -52,7 +65,7 @@ BufferAllocator::WriterPtr BufferAllocator::create_writer(size_t size, size_t pr
 }
 
 BufferAllocator::ReaderPtr BufferAllocator::create_reader(size_t size) {
-  if (size < 512) {
+  if (size < MIN_BUFFER_SIZE) {
     return create_reader_fast(size);
   }
   auto ptr = create_writer_exact(size);
@@ -60,15 +73,30 @@ BufferAllocator::ReaderPtr BufferAllocator::create_reader(size_t size) {
   return create_reader(ptr);
 }
 
-BufferAllocator::ReaderPtr BufferAllocator::create_reader_fast(size_t size) {
-  size = (size + 7) & -8;
+BufferAllocator::ReaderPtr BufferAllocator::create_arena_reader(size_t size) {
+  if (size < MIN_BUFFER_SIZE) {
+    return create_reader_fast(size);
+  }
+  if (size > MAX_ARENA_READER_SIZE) {
+    return create_reader(size);
+  }
+  init_thread_local<BufferRawTls>(buffer_raw_tls);
+  return create_reader_from_chunk(buffer_raw_tls->arena_buffer_raw, ARENA_CHUNK_SIZE, size);
+}
 
+BufferAllocator::ReaderPtr BufferAllocator::create_reader_fast(size_t size) {
   init_thread_local<BufferRawTls>(buffer_raw_tls);
+  return create_reader_from_chunk(buffer_raw_tls->buffer_raw, FAST_READER_CHUNK_SIZE, size);
+}
+
+BufferAllocator::ReaderPtr BufferAllocator::create_reader_from_chunk(
+    std::unique_ptr<BufferRaw, BufferRawDeleter> &chunk, size_t chunk_size, size_t size) {
+  size = (size + 7) & -8;
 
-  auto buffer_raw = buffer_raw_tls->buffer_raw.get();
+  auto buffer_raw = chunk.get();
   if (buffer_raw == nullptr || buffer_raw->data_size_ - buffer_raw->end_.load(std::memory_order_relaxed) < size) {
-    buffer_raw = create_buffer_raw(4096 * 4);
-    buffer_raw_tls->buffer_raw = std::unique_ptr<BufferRaw, BufferAllocator::BufferRawDeleter>(buffer_raw);
+    buffer_raw = create_buffer_raw(chunk_size);
+    chunk = std::unique_ptr<BufferRaw, BufferAllocator::BufferRawDeleter>(buffer_raw);
   }
   buffer_raw->end_.fetch_add(size, std::memory_order_relaxed);
   buffer_raw->ref_cnt_.fetch_add(1, std::memory_order_acq_rel);
@@ -9,6 +9,7 @@
 #include "td/utils/common.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SmallObjectAllocator.h"
 
 #include <atomic>
 #include <limits>
@@ -62,6 +63,10 @@ class BufferAllocator {
 
   static ReaderPtr create_reader(size_t size);
 
+  // allocates buffers of up to 4096 bytes from big per-thread chunks, which are freed only after all buffers
+  // allocated from them are destroyed, so it must be used only for short-living buffers
+  static ReaderPtr create_arena_reader(size_t size);
+
   static ReaderPtr create_reader(const WriterPtr &raw);
 
   static ReaderPtr create_reader(const ReaderPtr &raw);
@@ -69,14 +74,25 @@ class BufferAllocator {
   static size_t get_buffer_mem();
   static int64 get_buffer_slice_size();
 
+  // returns size of per-thread chunks of the current thread, which are kept alive by the thread itself
+  static size_t get_thread_buffer_mem();
+
   static void clear_thread_local();
 
  private:
   friend class BufferSlice;
 
   static void track_buffer_slice(int64 size) {
+    (void)size;
   }
 
+  // smaller buffers are allocated from per-thread chunks of size FAST_READER_CHUNK_SIZE
+  static constexpr size_t MIN_BUFFER_SIZE = 512;
+  static constexpr size_t FAST_READER_CHUNK_SIZE = 4096 * 4;
+
+  static constexpr size_t MAX_ARENA_READER_SIZE = 4096;
+  static constexpr size_t ARENA_CHUNK_SIZE = 65536;
+
   static ReaderPtr create_reader_fast(size_t size);
 
   static WriterPtr create_writer_exact(size_t size);
@@ -88,10 +104,14 @@ class BufferAllocator {
   };
   struct BufferRawTls {
     std::unique_ptr<BufferRaw, BufferRawDeleter> buffer_raw;
+    std::unique_ptr<BufferRaw, BufferRawDeleter> arena_buffer_raw;
   };
 
   static TD_THREAD_LOCAL BufferRawTls *buffer_raw_tls;
 
+  static ReaderPtr create_reader_from_chunk(std::unique_ptr<BufferRaw, BufferRawDeleter> &chunk, size_t chunk_size,
+                                            size_t size);
+
   static void dec_ref_cnt(BufferRaw *ptr);
 
   static BufferRaw *create_buffer_raw(size_t size);
@@ -140,6 +160,14 @@ class BufferSlice {
     debug_track();
   }
 
+  // the buffer is allocated by BufferAllocator::create_arena_reader, so it keeps a whole 64 KB chunk alive;
+  // it must be used only for temporary buffers, which are destroyed before the current event handling is finished
+  static BufferSlice create_short_living(size_t size) {
+    auto buffer = BufferAllocator::create_arena_reader(size);
+    auto begin = buffer->end_.load(std::memory_order_relaxed) - ((size + 7) & -8);
+    return BufferSlice(std::move(buffer), begin, begin + size);
+  }
+
   explicit BufferSlice(Slice slice) : BufferSlice(slice.size()) {
     as_mutable_slice().copy_from(slice);
   }
@@ -408,6 +436,15 @@ struct ChainBufferNode {
   ChainBufferNode(BufferSlice slice, bool sync_flag) : slice_(std::move(slice)), sync_flag_(sync_flag) {
   }
 
+  // nodes are created and destroyed for every chunk of every network connection
+  static void *operator new(std::size_t size) {
+    return SmallObjectAllocator::allocate(size);
+  }
+
+  static void operator delete(void *ptr, std::size_t size) noexcept {
+    SmallObjectAllocator::deallocate(ptr, size);
+  }
+
   // reader
   // There are two options
   // 1. Fixed slice of Buffer
@@ -432,7 +469,6 @@ struct ChainBufferNode {
     int left = --ptr->ref_cnt_;
     if (left == 0) {
       clear_nonrecursive(std::move(ptr->next_));
-      // TODO(refact): move memory management into allocator (?)
       delete ptr;
     }
   }
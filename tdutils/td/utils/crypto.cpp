@@ -48,6 +48,16 @@
 #include "crc32c/crc32c.h"
 #endif
 
+#if TD_HAVE_OPENSSL && (TD_GCC || TD_CLANG) && defined(__x86_64__)
+#define TD_HAVE_AES_NI 1
+#define TD_HAVE_SHA_NI 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define TD_HAVE_AES_NI 0
+#define TD_HAVE_SHA_NI 0
+#endif
+
 #include <algorithm>
 #include <cerrno>
 #include <cstring>
@@ -313,6 +323,130 @@ struct AesBlock {
 static_assert(sizeof(AesBlock) == 16, "");
 static_assert(sizeof(AesBlock) == AES_BLOCK_SIZE, "");
 
+#if TD_HAVE_AES_NI
+#define TD_AES_NI_TARGET __attribute__((target("sse2,aes")))
+
+static bool has_aes_ni() {
+  static const bool result = [] {
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0 && (ecx & bit_AES) != 0;
+  }();
+  return result;
+}
+
+// AES-256 with round keys in registers; IGE is sequential in both directions, so the whole chain is processed
+// in one call without per-block calls to EVP, which dominate the cost of IGE for OpenSSL
+class AesNiKey {
+ public:
+  AesNiKey() = default;
+  AesNiKey(const AesNiKey &) = delete;
+  AesNiKey &operator=(const AesNiKey &) = delete;
+  AesNiKey(AesNiKey &&) = delete;
+  AesNiKey &operator=(AesNiKey &&) = delete;
+  ~AesNiKey() {
+    MutableSlice(reinterpret_cast<char *>(round_keys_), sizeof(round_keys_)).fill_zero_secure();
+  }
+
+  TD_AES_NI_TARGET void init(Slice key, bool encrypt) {
+    CHECK(key.size() == 32);
+    auto key_begin = reinterpret_cast<const __m128i *>(key.ubegin());
+    __m128i keys[ROUND_COUNT + 1];
+    keys[0] = _mm_loadu_si128(key_begin);
+    keys[1] = _mm_loadu_si128(key_begin + 1);
+    expand_key<0x01>(keys, 2);
+    expand_key<0x02>(keys, 4);
+    expand_key<0x04>(keys, 6);
+    expand_key<0x08>(keys, 8);
+    expand_key<0x10>(keys, 10);
+    expand_key<0x20>(keys, 12);
+    keys[14] = expand_key_even(keys[12], _mm_aeskeygenassist_si128(keys[13], 0x40));
+    if (encrypt) {
+      for (int i = 0; i <= ROUND_COUNT; i++) {
+        round_keys_[i] = keys[i];
+      }
+    } else {
+      round_keys_[0] = keys[ROUND_COUNT];
+      for (int i = 1; i < ROUND_COUNT; i++) {
+        round_keys_[i] = _mm_aesimc_si128(keys[ROUND_COUNT - i]);
+      }
+      round_keys_[ROUND_COUNT] = keys[0];
+    }
+    MutableSlice(reinterpret_cast<char *>(keys), sizeof(keys)).fill_zero_secure();
+  }
+
+  TD_AES_NI_TARGET void ige_encrypt(AesBlock &encrypted_iv, AesBlock &plaintext_iv, const uint8 *in, uint8 *out,
+                                    size_t count) const {
+    auto encrypted = load(encrypted_iv.raw());
+    auto plaintext = load(plaintext_iv.raw());
+    for (size_t i = 0; i < count; i++) {
+      auto data = load(in + i * AES_BLOCK_SIZE);
+      auto state = _mm_xor_si128(_mm_xor_si128(data, encrypted), round_keys_[0]);
+      for (int j = 1; j < ROUND_COUNT; j++) {
+        state = _mm_aesenc_si128(state, round_keys_[j]);
+      }
+      encrypted = _mm_xor_si128(_mm_aesenclast_si128(state, round_keys_[ROUND_COUNT]), plaintext);
+      plaintext = data;
+      store(out + i * AES_BLOCK_SIZE, encrypted);
+    }
+    store(encrypted_iv.raw(), encrypted);
+    store(plaintext_iv.raw(), plaintext);
+  }
+
+  TD_AES_NI_TARGET void ige_decrypt(AesBlock &encrypted_iv, AesBlock &plaintext_iv, const uint8 *in, uint8 *out,
+                                    size_t count) const {
+    auto encrypted = load(encrypted_iv.raw());
+    auto plaintext = load(plaintext_iv.raw());
+    for (size_t i = 0; i < count; i++) {
+      auto data = load(in + i * AES_BLOCK_SIZE);
+      auto state = _mm_xor_si128(_mm_xor_si128(data, plaintext), round_keys_[0]);
+      for (int j = 1; j < ROUND_COUNT; j++) {
+        state = _mm_aesdec_si128(state, round_keys_[j]);
+      }
+      plaintext = _mm_xor_si128(_mm_aesdeclast_si128(state, round_keys_[ROUND_COUNT]), encrypted);
+      encrypted = data;
+      store(out + i * AES_BLOCK_SIZE, plaintext);
+    }
+    store(encrypted_iv.raw(), encrypted);
+    store(plaintext_iv.raw(), plaintext);
+  }
+
+ private:
+  static constexpr int ROUND_COUNT = 14;
+  __m128i round_keys_[ROUND_COUNT + 1];
+
+  TD_AES_NI_TARGET static __m128i load(const uint8 *ptr) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+  }
+
+  TD_AES_NI_TARGET static void store(uint8 *ptr, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(ptr), value);
+  }
+
+  TD_AES_NI_TARGET static __m128i shift_xor(__m128i key) {
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  }
+
+  TD_AES_NI_TARGET static __m128i expand_key_even(__m128i key, __m128i assist) {
+    return _mm_xor_si128(shift_xor(key), _mm_shuffle_epi32(assist, 0xff));
+  }
+
+  TD_AES_NI_TARGET static __m128i expand_key_odd(__m128i key, __m128i prev_key) {
+    return _mm_xor_si128(shift_xor(key), _mm_shuffle_epi32(_mm_aeskeygenassist_si128(prev_key, 0x00), 0xaa));
+  }
+
+  template <int RCON>
+  TD_AES_NI_TARGET static void expand_key(__m128i *keys, int pos) {
+    keys[pos] = expand_key_even(keys[pos - 2], _mm_aeskeygenassist_si128(keys[pos - 1], RCON));
+    keys[pos + 1] = expand_key_odd(keys[pos - 1], keys[pos]);
+  }
+};
+#endif
+
 class Evp {
  public:
   Evp() {
@@ -467,10 +601,15 @@ class AesIgeStateImpl {
   void init(Slice key, Slice iv, bool encrypt) {
     CHECK(key.size() == 32);
     CHECK(iv.size() == 32);
-    if (encrypt) {
-      evp_.init_encrypt_cbc(key);
-    } else {
-      evp_.init_decrypt_ecb(key);
+    if (!init_aes_ni(key, encrypt)) {
+      if (evp_ == nullptr) {
+        evp_ = make_unique<Evp>();
+      }
+      if (encrypt) {
+        evp_->init_encrypt_cbc(key);
+      } else {
+        evp_->init_decrypt_ecb(key);
+      }
     }
 
     encrypted_iv_.load(iv.ubegin());
@@ -486,6 +625,12 @@ class AesIgeStateImpl {
   void encrypt(Slice from, MutableSlice to) {
     CHECK(from.size() % AES_BLOCK_SIZE == 0);
     CHECK(to.size() >= from.size());
+#if TD_HAVE_AES_NI
+    if (use_aes_ni_) {
+      return aes_ni_key_.ige_encrypt(encrypted_iv_, plaintext_iv_, from.ubegin(), to.ubegin(),
+                                     from.size() / AES_BLOCK_SIZE);
+    }
+#endif
     auto len = to.size() / AES_BLOCK_SIZE;
     auto in = from.ubegin();
     auto out = to.ubegin();
@@ -505,9 +650,9 @@ class AesIgeStateImpl {
         }
       }
 
-      evp_.init_iv(encrypted_iv_.as_slice());
+      evp_->init_iv(encrypted_iv_.as_slice());
       auto inlen = static_cast<int>(AES_BLOCK_SIZE * count);
-      evp_.encrypt(data_xored[0].raw(), data_xored[0].raw(), inlen);
+      evp_->encrypt(data_xored[0].raw(), data_xored[0].raw(), inlen);
 
       data_xored[0] ^= plaintext_iv_;
       for (size_t i = 1; i < count; i++) {
@@ -526,6 +671,12 @@ class AesIgeStateImpl {
   void decrypt(Slice from, MutableSlice to) {
     CHECK(from.size() % AES_BLOCK_SIZE == 0);
     CHECK(to.size() >= from.size());
+#if TD_HAVE_AES_NI
+    if (use_aes_ni_) {
+      return aes_ni_key_.ige_decrypt(encrypted_iv_, plaintext_iv_, from.ubegin(), to.ubegin(),
+                                     from.size() / AES_BLOCK_SIZE);
+    }
+#endif
     auto len = to.size() / AES_BLOCK_SIZE;
     auto in = from.ubegin();
     auto out = to.ubegin();
@@ -536,7 +687,7 @@ class AesIgeStateImpl {
       encrypted.load(in);
 
       plaintext_iv_ ^= encrypted;
-      evp_.decrypt(plaintext_iv_.raw(), plaintext_iv_.raw(), AES_BLOCK_SIZE);
+      evp_->decrypt(plaintext_iv_.raw(), plaintext_iv_.raw(), AES_BLOCK_SIZE);
       plaintext_iv_ ^= encrypted_iv_;
 
       plaintext_iv_.store(out);
@@ -549,9 +700,25 @@ class AesIgeStateImpl {
   }
 
  private:
-  Evp evp_;
+  unique_ptr<Evp> evp_;
+#if TD_HAVE_AES_NI
+  bool use_aes_ni_ = false;
+  AesNiKey aes_ni_key_;
+#endif
   AesBlock encrypted_iv_;
   AesBlock plaintext_iv_;
+
+  bool init_aes_ni(Slice key, bool encrypt) {
+#if TD_HAVE_AES_NI
+    use_aes_ni_ = has_aes_ni();
+    if (use_aes_ni_) {
+      aes_ni_key_.init(key, encrypt);
+    }
+    return use_aes_ni_;
+#else
+    return false;
+#endif
+  }
 };
 
 AesIgeState::AesIgeState() = default;
@@ -763,8 +930,242 @@ void sha1(Slice data, unsigned char output[20]) {
 #endif
 }
 
+#if TD_HAVE_SHA_NI
+#define TD_SHA_NI_TARGET __attribute__((target("sse2,ssse3,sse4.1,sha")))
+
+static bool has_sha_ni() {
+  static const bool result = [] {
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0 || (ecx & bit_SSSE3) == 0 || (ecx & bit_SSE4_1) == 0) {
+      return false;
+    }
+    return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) != 0 && (ebx & bit_SHA) != 0;
+  }();
+  return result;
+}
+
+// SHA-256 of short messages with SHA-NI instructions; there is no EVP overhead and several independent messages
+// can be hashed simultaneously to hide latency of sha256rnds2
+class Sha256Ni {
+ public:
+  static constexpr size_t BLOCK_SIZE = 64;
+  static constexpr size_t MAX_LANE_COUNT = 2;
+
+  // hashes messages with the same number of blocks simultaneously
+  TD_SHA_NI_TARGET static void hash(const Slice *data, const MutableSlice *output, size_t count) {
+    CHECK(count <= MAX_LANE_COUNT);
+    Message messages[MAX_LANE_COUNT];
+    for (size_t i = 0; i < count; i++) {
+      CHECK(output[i].size() >= 32);
+      messages[i].init(data[i]);
+      CHECK(messages[i].get_block_count() == messages[0].get_block_count());
+    }
+    if (count == 1) {
+      do_hash<1>(messages, output);
+    } else if (count == 2) {
+      do_hash<2>(messages, output);
+    }
+  }
+
+  static size_t get_block_count(size_t size) {
+    return (size + 8) / BLOCK_SIZE + 1;
+  }
+
+ private:
+  struct State {
+    __m128i abef;
+    __m128i cdgh;
+  };
+
+ public:
+  class Stream {
+   public:
+    TD_SHA_NI_TARGET void init() {
+      state_ = get_initial_state();
+      buffer_size_ = 0;
+      total_size_ = 0;
+    }
+
+    TD_SHA_NI_TARGET void feed(Slice data) {
+      total_size_ += data.size();
+      if (buffer_size_ != 0) {
+        auto size = min(BLOCK_SIZE - buffer_size_, data.size());
+        std::memcpy(buffer_ + buffer_size_, data.ubegin(), size);
+        buffer_size_ += size;
+        data.remove_prefix(size);
+        if (buffer_size_ < BLOCK_SIZE) {
+          return;
+        }
+        transform_block(buffer_);
+        buffer_size_ = 0;
+      }
+      while (data.size() >= BLOCK_SIZE) {
+        transform_block(data.ubegin());
+        data.remove_prefix(BLOCK_SIZE);
+      }
+      std::memcpy(buffer_, data.ubegin(), data.size());
+      buffer_size_ = data.size();
+    }
+
+    TD_SHA_NI_TARGET void extract(MutableSlice output) {
+      CHECK(output.size() >= 32);
+      uint8 tail[2 * BLOCK_SIZE];
+      auto tail_size = buffer_size_ + 9 <= BLOCK_SIZE ? BLOCK_SIZE : 2 * BLOCK_SIZE;
+      std::memset(tail, 0, tail_size);
+      std::memcpy(tail, buffer_, buffer_size_);
+      tail[buffer_size_] = 0x80;
+      as<uint64>(tail + tail_size - 8) = host_to_big_endian64(total_size_ * 8);
+      for (size_t i = 0; i < tail_size; i += BLOCK_SIZE) {
+        transform_block(tail + i);
+      }
+      store_state(state_, output);
+    }
+
+   private:
+    State state_;
+    uint8 buffer_[BLOCK_SIZE];
+    size_t buffer_size_ = 0;
+    uint64 total_size_ = 0;
+
+    TD_SHA_NI_TARGET void transform_block(const uint8 *block) {
+      transform<1>(&state_, &block);
+    }
+  };
+
+ private:
+
+  class Message {
+   public:
+    void init(Slice data) {
+      data_ = data.ubegin();
+      full_block_count_ = data.size() / BLOCK_SIZE;
+      auto rest = data.substr(full_block_count_ * BLOCK_SIZE);
+      auto tail_size = rest.size() + 9 <= BLOCK_SIZE ? BLOCK_SIZE : 2 * BLOCK_SIZE;
+      std::memset(tail_, 0, tail_size);
+      std::memcpy(tail_, rest.ubegin(), rest.size());
+      tail_[rest.size()] = 0x80;
+      as<uint64>(tail_ + tail_size - 8) = host_to_big_endian64(static_cast<uint64>(data.size()) * 8);
+      block_count_ = full_block_count_ + tail_size / BLOCK_SIZE;
+    }
+
+    size_t get_block_count() const {
+      return block_count_;
+    }
+
+    const uint8 *get_block(size_t i) const {
+      return i < full_block_count_ ? data_ + i * BLOCK_SIZE : tail_ + (i - full_block_count_) * BLOCK_SIZE;
+    }
+
+   private:
+    const uint8 *data_ = nullptr;
+    size_t full_block_count_ = 0;
+    size_t block_count_ = 0;
+    uint8 tail_[2 * BLOCK_SIZE];
+  };
+
+  TD_SHA_NI_TARGET static __m128i get_byte_swap_mask() {
+    return _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  }
+
+  TD_SHA_NI_TARGET static __m128i load_k(int group) {
+    alignas(16) static const uint32 K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+    return _mm_load_si128(reinterpret_cast<const __m128i *>(K + 4 * group));
+  }
+
+  TD_SHA_NI_TARGET static State get_initial_state() {
+    // ABEF and CDGH ordering of H0..H7, required by sha256rnds2
+    State state;
+    state.abef = _mm_set_epi32(0x6a09e667, 0xbb67ae85, 0x510e527f, 0x9b05688c);
+    state.cdgh = _mm_set_epi32(0x3c6ef372, 0xa54ff53a, 0x1f83d9ab, 0x5be0cd19);
+    return state;
+  }
+
+  TD_SHA_NI_TARGET static void store_state(const State &state, MutableSlice output) {
+    auto feba = _mm_shuffle_epi32(state.abef, 0x1B);
+    auto dchg = _mm_shuffle_epi32(state.cdgh, 0xB1);
+    auto dcba = _mm_blend_epi16(feba, dchg, 0xF0);
+    auto hgfe = _mm_alignr_epi8(dchg, feba, 8);
+    auto mask = get_byte_swap_mask();
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(output.ubegin()), _mm_shuffle_epi8(dcba, mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(output.ubegin() + 16), _mm_shuffle_epi8(hgfe, mask));
+  }
+
+  template <size_t N>
+  TD_SHA_NI_TARGET static void transform(State *states, const uint8 *const *blocks) {
+    auto mask = get_byte_swap_mask();
+    State saved_states[N];
+    __m128i w[N][4];
+    for (size_t lane = 0; lane < N; lane++) {
+      saved_states[lane] = states[lane];
+    }
+#pragma GCC unroll 16
+    for (int group = 0; group < 16; group++) {
+      auto k = load_k(group);
+      for (size_t lane = 0; lane < N; lane++) {
+        auto &lane_w = w[lane];
+        auto &current = lane_w[group & 3];
+        if (group < 4) {
+          current = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(blocks[lane] + 16 * group)),
+                                     mask);
+        } else {
+          // W[group] = msg2(msg1(W[group - 4], W[group - 3]) + alignr(W[group - 1], W[group - 2]), W[group - 1])
+          auto &prev = lane_w[(group - 1) & 3];
+          current = _mm_sha256msg2_epu32(
+              _mm_add_epi32(_mm_sha256msg1_epu32(current, lane_w[(group - 3) & 3]),
+                            _mm_alignr_epi8(prev, lane_w[(group - 2) & 3], 4)),
+              prev);
+        }
+        auto &state = states[lane];
+        auto msg = _mm_add_epi32(current, k);
+        state.cdgh = _mm_sha256rnds2_epu32(state.cdgh, state.abef, msg);
+        state.abef = _mm_sha256rnds2_epu32(state.abef, state.cdgh, _mm_shuffle_epi32(msg, 0x0E));
+      }
+    }
+    for (size_t lane = 0; lane < N; lane++) {
+      states[lane].abef = _mm_add_epi32(states[lane].abef, saved_states[lane].abef);
+      states[lane].cdgh = _mm_add_epi32(states[lane].cdgh, saved_states[lane].cdgh);
+    }
+  }
+
+  template <size_t N>
+  TD_SHA_NI_TARGET static void do_hash(const Message *messages, const MutableSlice *output) {
+    State states[N];
+    for (size_t lane = 0; lane < N; lane++) {
+      states[lane] = get_initial_state();
+    }
+    auto block_count = messages[0].get_block_count();
+    for (size_t i = 0; i < block_count; i++) {
+      const uint8 *blocks[N];
+      for (size_t lane = 0; lane < N; lane++) {
+        blocks[lane] = messages[lane].get_block(i);
+      }
+      transform<N>(states, blocks);
+    }
+    for (size_t lane = 0; lane < N; lane++) {
+      store_state(states[lane], output[lane]);
+    }
+  }
+};
+#endif
+
 void sha256(Slice data, MutableSlice output) {
   CHECK(output.size() >= 32);
+#if TD_HAVE_SHA_NI
+  if (has_sha_ni()) {
+    return Sha256Ni::hash(&data, &output, 1);
+  }
+#endif
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER)
   static TD_THREAD_LOCAL const EVP_MD *evp_md;
   if (unlikely(evp_md == nullptr)) {
@@ -797,6 +1198,18 @@ string sha1(Slice data) {
   return result;
 }
 
+void sha256_pair(Slice data1, Slice data2, MutableSlice output1, MutableSlice output2) {
+#if TD_HAVE_SHA_NI
+  if (has_sha_ni() && Sha256Ni::get_block_count(data1.size()) == Sha256Ni::get_block_count(data2.size())) {
+    Slice data[2] = {data1, data2};
+    MutableSlice output[2] = {output1, output2};
+    return Sha256Ni::hash(data, output, 2);
+  }
+#endif
+  sha256(data1, output1);
+  sha256(data2, output2);
+}
+
 string sha256(Slice data) {
   string result(32, '\0');
   sha256(data, result);
@@ -811,16 +1224,26 @@ string sha512(Slice data) {
 
 class Sha256State::Impl {
  public:
+#if TD_HAVE_SHA_NI
+  bool use_sha_ni_ = has_sha_ni();
+  Sha256Ni::Stream sha_ni_stream_;
+#endif
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER)
-  EVP_MD_CTX *ctx_;
+  EVP_MD_CTX *ctx_ = nullptr;
 
   Impl() {
+#if TD_HAVE_SHA_NI
+    if (use_sha_ni_) {
+      return;
+    }
+#endif
     ctx_ = EVP_MD_CTX_new();
     LOG_IF(FATAL, ctx_ == nullptr);
   }
   ~Impl() {
-    CHECK(ctx_ != nullptr);
-    EVP_MD_CTX_free(ctx_);
+    if (ctx_ != nullptr) {
+      EVP_MD_CTX_free(ctx_);
+    }
   }
 #else
   SHA256_CTX ctx_;
@@ -863,6 +1286,13 @@ void Sha256State::init() {
     impl_ = make_unique<Sha256State::Impl>();
   }
   CHECK(!is_inited_);
+#if TD_HAVE_SHA_NI
+  if (impl_->use_sha_ni_) {
+    impl_->sha_ni_stream_.init();
+    is_inited_ = true;
+    return;
+  }
+#endif
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER)
   static TD_THREAD_LOCAL const EVP_MD *evp_md;
   if (unlikely(evp_md == nullptr)) {
@@ -879,6 +1309,11 @@ void Sha256State::init() {
 void Sha256State::feed(Slice data) {
   CHECK(impl_);
   CHECK(is_inited_);
+#if TD_HAVE_SHA_NI
+  if (impl_->use_sha_ni_) {
+    return impl_->sha_ni_stream_.feed(data);
+  }
+#endif
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER)
   int err = EVP_DigestUpdate(impl_->ctx_, data.ubegin(), data.size());
 #else
@@ -891,6 +1326,16 @@ void Sha256State::extract(MutableSlice output, bool destroy) {
   CHECK(output.size() >= 32);
   CHECK(impl_);
   CHECK(is_inited_);
+#if TD_HAVE_SHA_NI
+  if (impl_->use_sha_ni_) {
+    impl_->sha_ni_stream_.extract(output);
+    is_inited_ = false;
+    if (destroy) {
+      impl_.reset();
+    }
+    return;
+  }
+#endif
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER)
   int err = EVP_DigestFinal_ex(impl_->ctx_, output.ubegin(), nullptr);
 #else
@@ -120,6 +120,9 @@ void sha1(Slice data, unsigned char output[20]);
 
 void sha256(Slice data, MutableSlice output);
 
+// computes SHA-256 of two independent messages; faster than two separate calls for short messages of similar size
+void sha256_pair(Slice data1, Slice data2, MutableSlice output1, MutableSlice output2);
+
 void sha512(Slice data, MutableSlice output);
 
 string sha1(Slice data) TD_WARN_UNUSED_RESULT;
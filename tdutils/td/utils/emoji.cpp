@@ -6,137 +6,164 @@
 //
 #include "td/utils/emoji.h"
 
-#include "td/utils/base64.h"
-#include "td/utils/FlatHashSet.h"
-#include "td/utils/Gzip.h"
+#include "td/utils/misc.h"
+
+#include <algorithm>
 
 namespace td {
 
 static constexpr size_t MAX_EMOJI_LENGTH = 28;
 
-static bool is_emoji_element(Slice str) {
-  static const FlatHashSet<Slice, SliceHash> emojis = [max_emoji_length = MAX_EMOJI_LENGTH] {
-#if TD_HAVE_ZLIB
-    Slice packed_emojis(
-        "eJxtmlly40iWRbdCs_rrr56H3WVmzBHE4A6AxCCFqiodcBFOKShSComawqyWglpAl1lvoP0wcdPK2vrDnY-mC8e75_"
-        "kkRUzLdjEtu8WUbWIbYwuxbWPbxXZYTOuX2F4XU13GVi2m5mNsn2L7HNuX2JaxJbGlsWWx5bGZ2GxsRWw_FlMbP9s_xRbHb-"
-        "P4bRyzjWN2b2N7F1t8tovjd_Hn3T62-N7uLrbH2KL2LGrO4vvO4vvOLhfTeXzneXzmPI57Hp87j3mdrxfT1_j5dRUbccz_"
-        "a3z3Nnrbni2mq5jXVbX428VPb2P3Jovd-5TO0Fm6gq6kQ_d-Rbemq-kaujZ2H3-mO0Xf6PZ0B7pbuju673QPdEe6x9h9yul42_InOkZZ_"
-        "kL3ho6slu_"
-        "o3tN9oPtI94nuM90XuiVdQkf2S3wsGXl5GhkfS3ws8bHExxIfS3ws8bHEx5LsY9Vjd0Z3TveV7oLuj3RXdNd0uFzu6G7o8LvE7xK_S_wu7-"
-        "nwu8TvEr_LJ7pnuhe6V7ofsUuwn2A_wX6C_QT7CfYT7CfYT7CfYD_BfoL9BPsJ9hPsJ9hPsJ9gP8F-gv0E-wn2E-wn2E-wn2A_wX6C_"
-        "QT7CfYT7CfYT7Cf_Inuz3S_0jm6nm6g83SXdBu6kS7QbelAl4AuAV0CugR0CegS0CWgS0CXMFUS-CXwS-CXwC-BXwK_"
-        "BHQJ6FLQpaBLQZeCLgVdCroUdCnoUtCloEtBl4IuBV0KuhR0KehS0KWgS0GXgi7Ffor9FPsp9lPsp9hPsZ9iP8V-iv0U-yn2U-yn2E-xn2I_"
-        "xX6K_RT7KfZT7KfYT7GfYj_Ffor9FPsp9lPsp0yfFAYpDDIYZDDIYJDBIINBBoMMBhkMMhhkMMhgkOE3w2-G3wy_GX4z_"
-        "Gb4zfCb4TfDb4bfDL8ZfjP8ZvjN8JvhN8Nvht8Mvxl-M_"
-        "xmGMxwlOEow1GGowxHGY4yHGU4ynGU4yjHUY6jHEc5jnIc5TjKcZTjKMdRTlVzqppT1Zyq5rjMcZnjMsdljsucBZGzIHIWRM6CyFkQOQsiZ0Hk"
-        "LIicBZGzIHIWRM6CyCGUQyiHUA6hHEI5hHII5RDKIZRDKIdQDqEcQjmEcgjlEMohlDMjcmZEzozIAZYzI3JmRM6MyOGXwy-HXw6_HH45_"
-        "HL4GdAZqBmoGagZqBmoGagZqBmoGagZqBmoGagZqBmoGagZqBmoGagZqBmoGagZqBmoGagZqBmoGagZqBmoGagZqBmoGagZqBmoGagZqBmoGag"
-        "ZqBmoGagZqBmoGagZqBmoGagZqBmoGagZqBmoGagZqBmoGagZqBmoGaiZEzVmnQWdZdZZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-"
-        "Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-Fn4WfhZ-"
-        "Fn4WfhZ-Fn4WfhZ-Fn4FfAr4FfAr4BfAb8CfgX8CvgV8CvgV8CvgF8BvwJ-BfwK-BXwK-BXwK-AXwG_An4F_"
-        "Ar4FfAr4FfAr4BfAb8CfgX8CvgV8CvgV8CvgF8BvwJ-BfwK-BXwK-BXwK-AXwG_An4F_"
-        "Ar4FfAr4FfAr4BfAb8CfgX8CvgV8CvgV8CvgF8BvwJqJdRKqJVQK6FWQq2EWgm1Emol1EqolVAroVZCrYRaCbUSaiXUSqiVUCuhVkKthFoJtRJ"
-        "qJdRKqJVQK6FWQq2EWgm1Emol1EqolVAroVZCrYRaCbUSaiXUSqiVUCuhVkKthFoJtRJqJdRKqJVQK6FWQq2EWgm1Emol1EqolVAroVZCrWTWV"
-        "divsF9hv8J-hfMK5xXOK5xXOK9wXuG8wnmF8wrnFc4rnFc4r3Be4bzCeYXzCucVziucVzivcF7hvMJ5RX4r3rHiHSska9Jdk-"
-        "6adNcskjXlril3Tblryl1T7ppy15S7ptw15a4pd025a8pd47fGb43fGr815a4xXWO6xnSN6RrTNQnVJFRjusZ0jeka0zWma0zXmK4xXWO6xnSN"
-        "6RrTNaZrHNWYrjFdY7qm3DXlril3Tblryl1T7ppy15S7ptw15a4pd025a8pdU-"
-        "6acteUu6bcNeWuwVnDr4ZfDb8afjX8Gvg18Gvg18CvgV8DvwZ-Dfwa-DXwa-DXwK-BXwO_Bn4N_"
-        "FrGaxmvZbyW8VrGaxmvZbyW8VrGaxmvZbyW8VrGaxmvZbz2NB71aKlHSz1a6tFSj5Z6tNSjpR4t9WipR0s9WurRUo-"
-        "WerTUo6UeLfVoqUdLPVrq0VKPlnq01KOlHi31aKlHSz1a6tFSj5Z6tNSjpR4t9WipR0s9WurRUo-"
-        "WerTUo6UeLfVoqUdLPVrq0VKPlnq01KOlHh38Ovh18Ovg18Gvg18HoQ4kHUg6kHSA6ADRAaLDdIfpDtMdpjuy78i-"
-        "I7WO1DpS60itI7WO1DpS60itI7ULWF3A6gJWF7C6gNUFrC5gdQGrC1hdwOoCVhe87QIujnQdBXUU1FFQR_"
-        "aO7B3ZOwrqKKjDh8OHw4ejoI6COgrqKKjDm8Obw5vDmyNJR5KOJB1JOpJ0JOlI0pGkI0lHko4kHUk6kDgK6iioo6DulDgFdRTUUVAHNQc1BzUH"
-        "NQc1BzUHNQcwRy0dtXTUsqeWPbXsqWVPLXtq2VPLnmXQswx6lkHPMuhZBj3Ueqj1UOuh1kOth1oPtR5qPdR6qPVQ66HWQ62HWg-"
-        "1Hmo91Hqo9VDrodZDrYdaD7Ueaj3Ueqj1UOuh1kOth1oPtR5qPdR6qPVQ66HWQ62HWg-"
-        "1Hmo91Hqo9VDrodZDrYdaD7WeudaDrgddD7oedAPoBtANoBtAN4BuAN3ANjLAb4DfAL8BfgP8BvgN8BvgN8BvgN8AvwF-A_wG-A3wG-A3wG-"
-        "A3wC_AX4D_Ab4DfAb4DfAb4DfAL8BfgP8BvgN8BvgN8BvgN8AvwF-A_wG-A3wG-A3wG-A3wC_AX4D_"
-        "Ab4DfAb4DfAb4DfAL8BfgP8BvgN8BvgN8DPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_"
-        "Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw8_Dz8PPw2_"
-        "DeBvG2zDehvE2jLdhvA3jbRhvw3gbxtsw3obxNow3UoCRAowUYKQAIwUYKcBIAUYKMFKAEbojdEfojtAdoTtCd4TuCN0RuiN0R-"
-        "iO0B2hO0J3hO4I3RG6I3RH6I7QHaE7QneE7gjdEbojdEfojtAdoTtCd4TuCN0RGiM0RmiM0BihMUJjhMYIjREaIzRGaIzQGE80oDsCNsAlwCXA"
-        "JcAlwCXAJTDhAhMugCSAJIAkgCSAJIAkgCSAJIAkgCSAJIAkYD9gP2A_YD9gP2A_YD9gP2A_4C3gLeAt4C3gLeAt4C3gLTws_rJZ_"
-        "OV6Mf30vJh-_rSY3v45tuNiel_GVsW2im0dWx1bE9smtnExLS8XU5bFdhVbfD77FttNbPvYHmKLY2SPiyn-ljeton4VYvu-mNY_"
-        "xfYUW3xfvOZO8ZY7xUvuFO-4U7ziTvHSOsWb6hSvolO8dU7xqjnFS-YU75hTvFhO8SI5xYvjFO-"
-        "NU7wOTvE2OMXL4BSvfFO87E3NRWzxmSbqmz62-"
-        "EwTc23iO5vXxRQvXFO8ak3xpjXFi9YU71lTvGFN8W41xavVFK9SU7wrTfEKNMUb0NR9jC36jFeTqStii_67-LOOn93Gdh9bzCNeNaaz-P6zqD-"
-        "LHM-WsSWxxWfP4jvP4jvP4vvOoqezP8V2iC0-fx49n3-ILeZ77hbT1_izeDJP8WCetu9iex_bh8Vff9rF9rL46-d1bMyMd5T4HSV-xwJ_"
-        "xzz8yOz7ePqrMhNlyfRYMj2WTI8l02PJ9FiyOpasjiWrY8nqWJ7-"
-        "onr6oyHzMGUeprwoZQqmTMGUtZiyFjO21IwtNWNLzZjhGRM5YyJnDJAxQMZEzhglY5SMUTLWdsbazhgvO43HBM2Ym9npT1iYMac_Epx-"
-        "j2Mrr9jKKxZuhfOKJyqmdMVjFdlXPFuxXCuW64qtaMVjK9Jdke6KdFcswxVcVtBYAXHFOlmdfhcD4polvGYJr1mua5brmuW6Jvs12a_"
-        "Jfg3nNWtxzVBr8luT2vp06-S9Ha_sINSxB3Ss447HOtZxx7MdhepIqKMyHQa7w-IP05tfF3_474eMz384dfOXfzx185d_OnXzl38-"
-        "dfOXfzl185d_PXXzl387dfOXfz9185f_OHXzl_88dfOX_zp185e_"
-        "XXwYYrtUsFEwKggKtgquFdwo2Cu4VfBdwb2CBwVHBY8KnhW8KGDifPB8UeAVbBSMCoKCrYIrBdcKvim4UbBXcFBwq-"
-        "C7gnsFDwqOCp4UPCt4VXBK_lLJXwrvpZK_"
-        "VM6XyvlSOV8qZ4KdghsFewUHBbcK7hTcK3hU8KTgWcGLglcFp5w3orpRYhuh2yifjdLY6O0bPT7K8ijLowYcNeAop6NSHYV3FN5RyQfRCEojKI"
-        "2gNILSCBpwqzS2mjZbkd8qn61KsFViWyW21Uu3Ir_Vu7YivxXwrWbL9u_f_qDgqOBRwbOCE_"
-        "kr2bnSK670iisNeKVxrjTOtfBey9e1fF0r52sNeK0BrwXqWjlf6xXXyvla7_qmAb9pnG96_Ju876TZieFODHdiuNPjO6Wx-_"
-        "vH7xU8K3hVcJpRNyrljUp5I-83esWNGN5owBvZuZGdG6EjeFJwetder9hr5L2o7mVwr9myl9O9nO719r3I72V5L8t7odvL-14l2CvnvXLeK-"
-        "e9ct4r571AEbwo-N3FidhBdg6yc5CLg1wc5OIghgclf1CqB6V6UIYH5XPQu27l9E4vvdO77vSuO73rTsTuROxOL737-3EOCu4VPCg4KnhWcPL-"
-        "XW-_19vv5eJej98r-Xs9_qCnCLyCSwUbBaOCrYIrBdcKvinYKbhRsFdwUHCr4F7Bg4KjgicFLwpeFZzIH5X8UTkflfNR5I_K-"
-        "aicj0r1qFSPSvWoVI9K9ahUj0r1qAyPyvAomEcl9qjEHvX2R438qJEfZflRvh71-JMef5KvJ5XgSQM-ifyTBnxScZ_l_VmveJHTV43zKhc_"
-        "9K4fyvDHbCe7_Z8__uxj-3NsfWzX8_cf__eHh9h-je32__vhfWzbWfSD34JO_wj-2-fz_Pkyf77Onz_4DeQ33enzef58mT9f588f_Jeg33Snz-"
-        "f582X-fJ0_0X2ZdV9m3ZdZ92XWfZl1y1m3nHXLWbecdctZl8y6ZNYlsy6Zdcn8D_vpu_lf_U_Bs4IXBa8KTuR-0X8R-EX_TeAX_VeBX_"
-        "TfBX6R-I3EbyR-I_Ebid9I_FbitxK_lfitxG8l_iDxB4k_SPxB4g8Sf5b4s8SfJf4s8WeJv0j8ReIvEn-R-"
-        "IvES4mXEi8lXkq8nMVG6IzQGaEzQmeEzgidETojdEbojNCZ9xK_l_i9xO8lfi-x0BmhM0JnhM4Infko8UeJP0r8UeKPEn-S-JPEnyT-"
-        "JPEniVUUo6IYFcWoKEZFMSqKUVGMimJUFKOiGBXFqChGRTEqivm9KInEicSJxInEWikmlTiVOJU4lTiVOJM4kziTOJM4kziXOJc4lziXOJd4kH"
-        "iQeJB4kHiQ2EvsJfYSe4m9xJcSX0p8KfGlxJcSbyTeSLyReCPxRuIgcZA4SBwkDhJvJd5KvJV4K_FW4iuJryS-kvhK4iuJryW-"
-        "lvha4muJryXeSbyTeCfxTuKdxDcS30h8I_GNxDcS7yXeS7yXeC_"
-        "xXuKDxAeJDxIfJD5IfCvxrcS3Et9KfCvxncR3Et9JfCfxncTfJf4u8XeJv0v8XeJ7ie8lvpf4XuJ7iR8kfpD4QeIHiR8kfpb4WeJniZ8lfp7F9"
-        "udZfAqeFbwoeFVwEmt_ttqfrfZnq_3Zan-22p-t9mer_"
-        "dlqf7ban61OWKsT1uqEtTphrU5Yq83cajO32sytNnOrzdxqM7fazK02c6vN3Gozt9qRrHYkqx3Jakey2pGskdhIbCQ2EhuJR4lHiUeJR4nHWVx"
-        "pilaaopWmaKUpWmmKVpqilaZopSlaaYpWmqLVo8SPEj9K_"
-        "Cjx4yxe5bP4FDwreFHwquAkriSuJK4kriSuJF5JvJJ4JfFK4tUsbjQ3Gs2NRnOj0dxoNDcazY1Gc6PR3Gg0NxrNjUZzo9HcaDQ3Gs2NRnOj0Qn"
-        "b6IRtdMI2OmEbnbCNTthGJ2yjE7bRCdvohG10wjY6YRudsI1O2EYnbKMTttEJ2-"
-        "iEbXTCNjphG83nRvO50XxuNJ8bzef211l8Cp4VvCh4VXASa4q2mqKtpmirKdpqiraaoq2maKsp2mqKtpqirXbRVrtoq1201S7aahftfprFp-"
-        "BZwYuCVwUnsYrSqSiditKpKJ2K4iR2EjuJncTud7E4O3F24uzE2YmzqyWuJa4lriWuJW4kbiRuJG4kbiRuJW4lbiVuJW4l7iTuJO4k7iTuJD6T"
-        "-EziM4nPJD6T-Fzic4nPJT6X-FzirxJ_lfirxF8l_irxhcQXEl9IfCHxhcS6BDpdAp0ugU6XQKdLoNtJvJN4J_"
-        "FO4p3Eusk43WScbjJONxmnm4zTTcbpJuN0k3G6yTjdZJxuMk43GaebjNNNxukm47QGndag0xp0WoNOa9BpDTqtQac16LQGndag0xp0WoNOa9Bp"
-        "DTqtQaebjNNNxukm43STcbrJON1knG4yTjcZp5uM003GHSU-SnyU-CjxUeIXiV8kfpH4ReIXiV8lfpX4VeJXiV9ncS-DvQz2MtjLYC-"
-        "DgzgP4jyI8yDOgzgP4jyI8yDOgzgP4jwI3SB0g9ANQjcI3SB0g9ANQjcI3SB0w5PETxI_"
-        "Sfwk8dMs9jqtvE4rr9PK67TyOq28Tiuv08rrtPI6rbxOK69d1GsX9dpFvXZRr13U6_bldfvyun153b68bl_"
-        "eSmwlthJbia3EhcSFxIXEhcSFxKXEpcSlxKXEpcS6I3ndkbzuSF53JK87ktcdyeuO5HVH8rojed2R_"
-        "FritcRridcSryXWAeR1AHkdQF4HkNcB5HUAeR1AXgeQ1wHkdQB5HUBeB5DXAeR1AHkdQF4HkNcB5HUAeR1AXgeQ1wHkdQB5HUBeB5DXAeR1AHk"
-        "dQF4HkNcB5HUABf2eEvR7StDvKUG_pwT9nhL0J7igP8EF_Qku6E9wQX-"
-        "CC7q4Bl1cgy6uQRfXoItr2Em8k3gn8U7incQ6gIIOoKADKOgACjqAgg6goAMo6AAKOoCCDqCgAyjoAAo6gIIOoKADKOgACjqAgg6goAMo6AAK2"
-        "hiDNsagjTFoYwzaGIM2xqCNMWhjDNoYgzbGoP05aH8O2p-D9ueg_TloFw3aRYN20aBdNPy2i_4vsAI1eQ");
-    static string all_emojis_str = gzdecode(base64url_decode(packed_emojis).ok()).as_slice().str();
-    constexpr size_t EMOJI_COUNT = 2326;
-#else
-    string all_emojis_str;
-    constexpr size_t EMOJI_COUNT = 0;
-#endif
-    FlatHashSet<Slice, SliceHash> all_emojis;
-    all_emojis.reserve(EMOJI_COUNT);
-    for (size_t i = 0; i < all_emojis_str.size(); i++) {
-      CHECK(all_emojis_str[i] != ' ');
-      CHECK(all_emojis_str[i + 1] != ' ');
-      size_t j = i + 2;
-      while (j < all_emojis_str.size() && all_emojis_str[j] != ' ') {
-        j++;
+// list of [range_begin, range_end) of code points, which are emojis by themselves
+static const uint32 emoji_code_point_ranges[] = {
+    0xA9,    0xAA,    0xAE,    0xAF,    0x203C,  0x203D,  0x2049,  0x204A,  0x2122,  0x2123,  0x2139,  0x213A,  0x2194,
+    0x219A,  0x21A9,  0x21AB,  0x231A,  0x231C,  0x2328,  0x2329,  0x23CF,  0x23D0,  0x23E9,  0x23F4,  0x23F8,  0x23FB,
+    0x24C2,  0x24C3,  0x25AA,  0x25AC,  0x25B6,  0x25B7,  0x25C0,  0x25C1,  0x25FB,  0x25FF,  0x2600,  0x2605,  0x260E,
+    0x260F,  0x2611,  0x2612,  0x2614,  0x2616,  0x2618,  0x2619,  0x261D,  0x261E,  0x2620,  0x2621,  0x2622,  0x2624,
+    0x2626,  0x2627,  0x262A,  0x262B,  0x262E,  0x2630,  0x2638,  0x263B,  0x2640,  0x2641,  0x2642,  0x2643,  0x2648,
+    0x2654,  0x265F,  0x2661,  0x2663,  0x2664,  0x2665,  0x2667,  0x2668,  0x2669,  0x267B,  0x267C,  0x267E,  0x2680,
+    0x2692,  0x2698,  0x2699,  0x269A,  0x269B,  0x269D,  0x26A0,  0x26A2,  0x26A7,  0x26A8,  0x26AA,  0x26AC,  0x26B0,
+    0x26B2,  0x26BD,  0x26BF,  0x26C4,  0x26C6,  0x26C8,  0x26C9,  0x26CE,  0x26D0,  0x26D1,  0x26D2,  0x26D3,  0x26D5,
+    0x26E9,  0x26EB,  0x26F0,  0x26F6,  0x26F7,  0x26FB,  0x26FD,  0x26FE,  0x2702,  0x2703,  0x2705,  0x2706,  0x2708,
+    0x270E,  0x270F,  0x2710,  0x2712,  0x2713,  0x2714,  0x2715,  0x2716,  0x2717,  0x271D,  0x271E,  0x2721,  0x2722,
+    0x2728,  0x2729,  0x2733,  0x2735,  0x2744,  0x2745,  0x2747,  0x2748,  0x274C,  0x274D,  0x274E,  0x274F,  0x2753,
+    0x2756,  0x2757,  0x2758,  0x2763,  0x2765,  0x2795,  0x2798,  0x27A1,  0x27A2,  0x27B0,  0x27B1,  0x27BF,  0x27C0,
+    0x2934,  0x2936,  0x2B05,  0x2B08,  0x2B1B,  0x2B1D,  0x2B50,  0x2B51,  0x2B55,  0x2B56,  0x3030,  0x3031,  0x303D,
+    0x303E,  0x3297,  0x3298,  0x3299,  0x329A,  0x1F004, 0x1F005, 0x1F0CF, 0x1F0D0, 0x1F170, 0x1F172, 0x1F17E, 0x1F180,
+    0x1F18E, 0x1F18F, 0x1F191, 0x1F19B, 0x1F201, 0x1F203, 0x1F21A, 0x1F21B, 0x1F22F, 0x1F230, 0x1F232, 0x1F23B, 0x1F250,
+    0x1F252, 0x1F300, 0x1F322, 0x1F324, 0x1F394, 0x1F396, 0x1F398, 0x1F399, 0x1F39C, 0x1F39E, 0x1F3F1, 0x1F3F3, 0x1F3F6,
+    0x1F3F7, 0x1F4FE, 0x1F4FF, 0x1F53E, 0x1F549, 0x1F54F, 0x1F550, 0x1F568, 0x1F56F, 0x1F571, 0x1F573, 0x1F57B, 0x1F587,
+    0x1F588, 0x1F58A, 0x1F58E, 0x1F590, 0x1F591, 0x1F595, 0x1F597, 0x1F5A4, 0x1F5A6, 0x1F5A8, 0x1F5A9, 0x1F5B1, 0x1F5B3,
+    0x1F5BC, 0x1F5BD, 0x1F5C2, 0x1F5C5, 0x1F5D1, 0x1F5D4, 0x1F5DC, 0x1F5DF, 0x1F5E1, 0x1F5E2, 0x1F5E3, 0x1F5E4, 0x1F5E8,
+    0x1F5E9, 0x1F5EF, 0x1F5F0, 0x1F5F3, 0x1F5F4, 0x1F5FA, 0x1F650, 0x1F680, 0x1F6C6, 0x1F6CB, 0x1F6D3, 0x1F6D5, 0x1F6D8,
+    0x1F6DC, 0x1F6E6, 0x1F6E9, 0x1F6EA, 0x1F6EB, 0x1F6ED, 0x1F6F0, 0x1F6F1, 0x1F6F3, 0x1F6FD, 0x1F7E0, 0x1F7EC, 0x1F7F0,
+    0x1F7F1, 0x1F90C, 0x1F93B, 0x1F93C, 0x1F946, 0x1F947, 0x1FA00, 0x1FA70, 0x1FA7D, 0x1FA80, 0x1FA89, 0x1FA90, 0x1FABE,
+    0x1FABF, 0x1FAC6, 0x1FACE, 0x1FADC, 0x1FAE0, 0x1FAE9, 0x1FAF0, 0x1FAF9};
+
+// list of [range_begin, range_end) of code points, which can be followed by a Fitzpatrick modifier
+static const uint32 fitzpatrick_base_ranges[] = {
+    0x261D,  0x261E,  0x26F9,  0x26FA,  0x270A,  0x270E,  0x1F385, 0x1F386, 0x1F3C2, 0x1F3C5, 0x1F3C7, 0x1F3C8, 0x1F3CA,
+    0x1F3CD, 0x1F442, 0x1F444, 0x1F446, 0x1F451, 0x1F466, 0x1F46A, 0x1F46B, 0x1F46F, 0x1F470, 0x1F479, 0x1F47C, 0x1F47D,
+    0x1F481, 0x1F484, 0x1F485, 0x1F488, 0x1F48F, 0x1F490, 0x1F491, 0x1F492, 0x1F4AA, 0x1F4AB, 0x1F574, 0x1F576, 0x1F57A,
+    0x1F57B, 0x1F590, 0x1F591, 0x1F595, 0x1F597, 0x1F645, 0x1F648, 0x1F64B, 0x1F650, 0x1F6A3, 0x1F6A4, 0x1F6B4, 0x1F6B7,
+    0x1F6C0, 0x1F6C1, 0x1F6CC, 0x1F6CD, 0x1F90C, 0x1F90D, 0x1F90F, 0x1F910, 0x1F918, 0x1F920, 0x1F926, 0x1F927, 0x1F930,
+    0x1F93A, 0x1F93D, 0x1F93F, 0x1F977, 0x1F978, 0x1F9B5, 0x1F9B7, 0x1F9B8, 0x1F9BA, 0x1F9BB, 0x1F9BC, 0x1F9CD, 0x1F9D0,
+    0x1F9D1, 0x1F9DE, 0x1FAC3, 0x1FAC6, 0x1FAF0, 0x1FAF9};
+
+// for each first regional indicator letter, a mask of second letters forming a flag emoji
+static const uint32 flag_second_letters[] = {
+    0x2DF597C, 0x36F7BFB, 0x3F2FDED, 0x2005650, 0x1E00D5,  0x25700,   0x15FB9FB, 0x1A3400,  0xF781C,   0xD010,
+    0x342B1D0, 0x13E0507, 0x3FFFCFD, 0x212C975, 0x1000,    0x14E3CF1, 0x1,       0x544010,  0x3AE7FDF, 0x26A7EED,
+    0x3043041, 0x102155,  0x40020,   0x400,     0x80010,   0x401001};
+
+template <size_t N>
+static bool is_in_ranges(const uint32 (&ranges)[N], uint32 code) {
+  static_assert(N % 2 == 0, "");
+  return (std::upper_bound(ranges, ranges + N, code) - ranges) % 2 == 1;
+}
+
+// decodes the string into at most N code points; returns 0 if the string isn't valid UTF-8 or is too long
+template <size_t N>
+static size_t get_code_points(Slice str, uint32 (&code_points)[N]) {
+  size_t count = 0;
+  size_t pos = 0;
+  while (pos < str.size()) {
+    if (count == N) {
+      return 0;
+    }
+    auto c = static_cast<unsigned char>(str[pos]);
+    size_t length;
+    uint32 code;
+    uint32 min_code;
+    if (c < 0x80) {
+      length = 1;
+      code = c;
+      min_code = 0;
+    } else if ((c & 0xE0) == 0xC0) {
+      length = 2;
+      code = c & 0x1F;
+      min_code = 0x80;
+    } else if ((c & 0xF0) == 0xE0) {
+      length = 3;
+      code = c & 0x0F;
+      min_code = 0x800;
+    } else if ((c & 0xF8) == 0xF0) {
+      length = 4;
+      code = c & 0x07;
+      min_code = 0x10000;
+    } else {
+      return 0;
+    }
+    if (pos + length > str.size()) {
+      return 0;
+    }
+    for (size_t i = 1; i < length; i++) {
+      auto next = static_cast<unsigned char>(str[pos + i]);
+      if ((next & 0xC0) != 0x80) {
+        return 0;
       }
-      CHECK(j < all_emojis_str.size());
-      all_emojis.insert(Slice(&all_emojis_str[i], &all_emojis_str[j]));
-      CHECK(j - i <= max_emoji_length);
-      i = j;
+      code = (code << 6) | (next & 0x3F);
     }
-    CHECK(all_emojis.size() == EMOJI_COUNT);
-    return all_emojis;
-  }();
-  auto len = str.size();
-  if (len > MAX_EMOJI_LENGTH + 3) {
-    return false;
-  }
-  if (emojis.count(str) != 0) {
-    return true;
+    if (code < min_code) {
+      // overlong encoding
+      return 0;
+    }
+    code_points[count++] = code;
+    pos += length;
   }
-  if (len <= 3 || str[len - 3] != '\xEF' || str[len - 2] != '\xB8' || str[len - 1] != '\x8F') {
-    return false;
+  return count;
+}
+
+static bool is_regional_indicator(uint32 code) {
+  return 0x1F1E6 <= code && code <= 0x1F1FF;
+}
+
+static bool is_keycap_base(uint32 code) {
+  return code == '#' || code == '*' || ('0' <= code && code <= '9');
+}
+
+static bool is_emoji_element(Slice str) {
+  Slice variation_selector(u8"\uFE0F");
+  if (ends_with(str, variation_selector)) {
+    str.remove_suffix(variation_selector.size());
+    if (ends_with(str, variation_selector)) {
+      return false;
+    }
   }
-  if (len >= 6 && str[len - 6] == '\xEF' && str[len - 5] == '\xB8' && str[len - 4] == '\x8F') {
-    return false;
+
+  uint32 code_points[7];
+  switch (get_code_points(str, code_points)) {
+    case 1:
+      return is_in_ranges(emoji_code_point_ranges, code_points[0]);
+    case 2:
+      if (0x1F3FB <= code_points[1] && code_points[1] <= 0x1F3FF) {
+        return is_in_ranges(fitzpatrick_base_ranges, code_points[0]);
+      }
+      if (is_regional_indicator(code_points[0]) && is_regional_indicator(code_points[1])) {
+        return ((flag_second_letters[code_points[0] - 0x1F1E6] >> (code_points[1] - 0x1F1E6)) & 1) != 0;
+      }
+      return code_points[1] == 0x20E3 && is_keycap_base(code_points[0]);
+    case 3:
+      return code_points[1] == 0xFE0F && code_points[2] == 0x20E3 && is_keycap_base(code_points[0]);
+    case 7: {
+      // subdivision flags: black flag, tag letters "gbeng", "gbsct" or "gbwls", cancel tag
+      if (code_points[0] != 0x1F3F4 || code_points[6] != 0xE007F) {
+        return false;
+      }
+      char tag[5];
+      for (size_t i = 0; i < 5; i++) {
+        auto code = code_points[i + 1];
+        if (code < 0xE0061 || code > 0xE007A) {
+          return false;
+        }
+        tag[i] = static_cast<char>(code - 0xE0000);
+      }
+      Slice subdivision(tag, 5);
+      return subdivision == "gbeng" || subdivision == "gbsct" || subdivision == "gbwls";
+    }
+    default:
+      return false;
   }
-  return emojis.count(str.substr(0, len - 3)) != 0;
 }
 
 bool is_emoji(Slice str) {
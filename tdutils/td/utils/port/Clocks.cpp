@@ -6,6 +6,7 @@
 //
 #include "td/utils/port/Clocks.h"
 
+#include "td/utils/common.h"
 #include "td/utils/port/platform.h"
 
 #include <chrono>
@@ -57,6 +58,30 @@ double Clocks::system() {
   return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) * 1e-9;
 }
 
+double Clocks::thread_cpu() {
+#if TD_PORT_POSIX
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec spec;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &spec) == 0) {
+    return static_cast<double>(spec.tv_nsec) * 1e-9 + static_cast<double>(spec.tv_sec);
+  }
+#endif
+#elif TD_PORT_WINDOWS
+  FILETIME ignored_time;
+  FILETIME kernel_time;
+  FILETIME user_time;
+  if (GetThreadTimes(GetCurrentThread(), &ignored_time, &ignored_time, &kernel_time, &user_time)) {
+    auto to_ticks = [](const FILETIME &time) {
+      return (static_cast<uint64>(time.dwHighDateTime) << 32) | static_cast<uint64>(time.dwLowDateTime);
+    };
+    return static_cast<double>(to_ticks(kernel_time) + to_ticks(user_time)) * 1e-7;
+  }
+#endif
+
+  // fallback to CPU time of the whole process
+  return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
 int Clocks::tz_offset() {
   // not thread-safe on POSIX, so calculate the offset only once
   static int offset = [] {
@@ -13,6 +13,9 @@ struct Clocks {
 
   static double system();
 
+  // returns CPU time consumed by the current thread, in seconds
+  static double thread_cpu();
+
   static int tz_offset();
 };
 
@@ -63,6 +63,7 @@ class FileFd {
 
   Status sync() TD_WARN_UNUSED_RESULT;
   Status sync_barrier() TD_WARN_UNUSED_RESULT;
+  Status sync_data() TD_WARN_UNUSED_RESULT;  // doesn't flush metadata, which isn't needed to read the data
 
   Status seek(int64 position) TD_WARN_UNUSED_RESULT;
 
@@ -9,11 +9,19 @@
 #include "td/utils/Slice.h"
 
 #if TD_PORT_POSIX
+#include <climits>
 #include <sys/uio.h>
 #endif
 
 namespace td {
 
+// maximum number of slices, which can be written by a single writev call
+#if TD_PORT_POSIX && defined(IOV_MAX)
+constexpr size_t MAX_IO_SLICE_COUNT = IOV_MAX;
+#else
+constexpr size_t MAX_IO_SLICE_COUNT = 1024;
+#endif
+
 #if TD_PORT_POSIX
 
 using IoSlice = struct iovec;
@@ -24,18 +24,31 @@ namespace td {
 
 class MemoryMapping::Impl {
  public:
-  Impl(MutableSlice data, int64 offset) : data_(data), offset_(offset) {
+  Impl(MutableSlice data, int64 offset, bool is_writable) : data_(data), offset_(offset), is_writable_(is_writable) {
+  }
+  Impl(const Impl &) = delete;
+  Impl &operator=(const Impl &) = delete;
+  Impl(Impl &&) = delete;
+  Impl &operator=(Impl &&) = delete;
+  ~Impl() {
+#if !TD_WINDOWS
+    munmap(data_.data(), data_.size());
+#endif
   }
   Slice as_slice() const {
     return data_.substr(narrow_cast<size_t>(offset_));
   }
   MutableSlice as_mutable_slice() const {
-    return {};
+    if (!is_writable_) {
+      return {};
+    }
+    return data_.substr(narrow_cast<size_t>(offset_));
   }
 
  private:
   MutableSlice data_;
   int64 offset_;
+  bool is_writable_;
 };
 
 #if !TD_WINDOWS
@@ -73,7 +86,7 @@ Result<MemoryMapping> MemoryMapping::create_from_file(const FileFd &file_fd, con
   if (options.size < 0) {
     end = stat.size_;
   } else {
-    end = begin + stat.size_;
+    end = begin + options.size;
   }
 
   TRY_RESULT(page_size, get_page_size());
@@ -82,12 +95,15 @@ Result<MemoryMapping> MemoryMapping::create_from_file(const FileFd &file_fd, con
   auto data_offset = begin - fixed_begin;
   TRY_RESULT(data_size, narrow_cast_safe<size_t>(end - fixed_begin));
 
-  void *data = mmap(nullptr, data_size, PROT_READ, MAP_PRIVATE, fd, narrow_cast<off_t>(fixed_begin));
+  int prot = options.is_writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  int flags = options.is_writable ? MAP_SHARED : MAP_PRIVATE;
+  void *data = mmap(nullptr, data_size, prot, flags, fd, narrow_cast<off_t>(fixed_begin));
   if (data == MAP_FAILED) {
     return OS_ERROR("mmap call failed");
   }
 
-  return MemoryMapping(make_unique<Impl>(MutableSlice(static_cast<char *>(data), data_size), data_offset));
+  return MemoryMapping(
+      make_unique<Impl>(MutableSlice(static_cast<char *>(data), data_size), data_offset, options.is_writable));
 #endif
 }
 
@@ -18,6 +18,7 @@ class MemoryMapping {
   struct Options {
     int64 offset{0};
     int64 size{-1};
+    bool is_writable{false};  // writable mappings are shared with other processes, which map the same file
 
     Options() {
     }
@@ -29,6 +30,10 @@ class MemoryMapping {
       size = new_size;
       return *this;
     }
+    Options &with_write_access() {
+      is_writable = true;
+      return *this;
+    }
   };
 
   static Result<MemoryMapping> create_anonymous(const Options &options = {});
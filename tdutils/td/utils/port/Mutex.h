@@ -6,7 +6,11 @@
 //
 #pragma once
 
+#include "td/utils/LockStatistics.h"
+#include "td/utils/Time.h"
+
 #include <mutex>
+#include <utility>
 
 namespace td {
 
@@ -20,7 +24,28 @@ class Mutex {
   };
 
   Guard lock() {
+#if TD_HAVE_LOCK_STATISTICS
+    static LockStatistics statistics("Mutex");
+    return lock(statistics);
+#else
+    return {std::unique_lock<std::mutex>(mutex_)};
+#endif
+  }
+
+  // accounts contention in the specified statistics instead of the common statistics of all mutexes
+  Guard lock(LockStatistics &statistics) {
+#if TD_HAVE_LOCK_STATISTICS
+    statistics.on_lock();
+    std::unique_lock<std::mutex> guard(mutex_, std::try_to_lock);
+    if (!guard.owns_lock()) {
+      auto start_time = Time::now();
+      guard.lock();
+      statistics.on_contention(1, Time::now() - start_time);
+    }
+    return {std::move(guard)};
+#else
     return {std::unique_lock<std::mutex>(mutex_)};
+#endif
   }
 
  private:
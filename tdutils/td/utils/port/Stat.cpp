@@ -127,6 +127,7 @@ Stat from_native_stat(const struct ::stat &buf) {
   res.is_dir_ = (buf.st_mode & S_IFMT) == S_IFDIR;
   res.is_reg_ = (buf.st_mode & S_IFMT) == S_IFREG;
   res.is_symbolic_link_ = (buf.st_mode & S_IFMT) == S_IFLNK;
+  res.link_count_ = static_cast<uint32>(buf.st_nlink);
   return res;
 }
 
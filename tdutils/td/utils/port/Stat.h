@@ -22,6 +22,7 @@ struct Stat {
   int64 real_size_;
   uint64 atime_nsec_;
   uint64 mtime_nsec_;
+  uint32 link_count_;
 };
 
 Result<Stat> stat(CSlice path) TD_WARN_UNUSED_RESULT;
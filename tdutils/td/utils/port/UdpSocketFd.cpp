@@ -34,6 +34,7 @@
 
 #if TD_LINUX
 #include <linux/errqueue.h>
+#include <netinet/udp.h>
 #endif
 #endif
 
@@ -389,10 +390,20 @@ class UdpSocketReceiveHelper {
   }
 
   static void from_native(msghdr &message_header, size_t message_size, UdpSocketFd::InboundMessage &message) {
+    message.segment_size = 0;
 #if TD_LINUX
     cmsghdr *cmsg;
     sock_extended_err *ee = nullptr;
+    size_t segment_size = 0;
     for (cmsg = CMSG_FIRSTHDR(&message_header); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message_header, cmsg)) {
+#ifdef UDP_GRO
+      if (cmsg->cmsg_type == UDP_GRO && cmsg->cmsg_level == SOL_UDP) {
+        int gro_size;
+        std::memcpy(&gro_size, CMSG_DATA(cmsg), sizeof(gro_size));
+        segment_size = static_cast<size_t>(gro_size);
+        continue;
+      }
+#endif
       if (cmsg->cmsg_type == IP_PKTINFO && cmsg->cmsg_level == IPPROTO_IP) {
         //auto *pi = reinterpret_cast<in_pktinfo *>(CMSG_DATA(cmsg));
       } else if (cmsg->cmsg_type == IPV6_PKTINFO && cmsg->cmsg_level == IPPROTO_IPV6) {
@@ -434,6 +445,11 @@ class UdpSocketReceiveHelper {
     CHECK(message_size <= message.data.size());
     message.data.truncate(message_size);
     CHECK(message_size == message.data.size());
+#if TD_LINUX
+    if (segment_size != 0 && segment_size < message_size) {
+      message.segment_size = segment_size;
+    }
+#endif
   }
 
  private:
@@ -452,14 +468,35 @@ class UdpSocketSendHelper {
     io_vec_.iov_len = message.data.size();
     message_header.msg_iov = &io_vec_;
     message_header.msg_iovlen = 1;
-    //TODO
     message_header.msg_control = nullptr;
     message_header.msg_controllen = 0;
     message_header.msg_flags = 0;
+    if (message.segment_size != 0) {
+#ifdef UDP_SEGMENT
+      CHECK(message.segment_size <= 0xFFFF);
+      CHECK(message.data.size() <= UdpSocketFd::MAX_SEGMENTED_MESSAGE_SIZE);
+      message_header.msg_control = control_buf_.buf;
+      message_header.msg_controllen = sizeof(control_buf_.buf);
+      auto *cmsg = CMSG_FIRSTHDR(&message_header);
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type = UDP_SEGMENT;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      auto segment_size = static_cast<uint16_t>(message.segment_size);
+      std::memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+#else
+      UNREACHABLE();
+#endif
+    }
   }
 
  private:
   iovec io_vec_;
+#ifdef UDP_SEGMENT
+  union {
+    char buf[CMSG_SPACE(sizeof(uint16_t))];
+    cmsghdr align;
+  } control_buf_;
+#endif
 };
 
 class UdpSocketFdImpl {
@@ -476,6 +513,41 @@ class UdpSocketFdImpl {
   const NativeFd &get_native_fd() const {
     return info_.native_fd();
   }
+
+  Status enable_send_offload() {
+#ifdef UDP_SEGMENT
+    // the option is supported if and only if the kernel supports segmentation offload
+    int segment_size = 0;
+    socklen_t len = sizeof(segment_size);
+    if (getsockopt(get_native_fd().socket(), SOL_UDP, UDP_SEGMENT, &segment_size, &len) != 0) {
+      return OS_SOCKET_ERROR("Failed to enable UDP segmentation offload");
+    }
+    is_send_offload_enabled_ = true;
+    return Status::OK();
+#else
+    return Status::Error("UDP segmentation offload is unsupported");
+#endif
+  }
+  bool is_send_offload_enabled() const {
+    return is_send_offload_enabled_;
+  }
+
+  Status enable_receive_offload() {
+#ifdef UDP_GRO
+    int flags = 1;
+    if (setsockopt(get_native_fd().socket(), SOL_UDP, UDP_GRO, &flags, sizeof(flags)) != 0) {
+      return OS_SOCKET_ERROR("Failed to enable UDP receive offload");
+    }
+    is_receive_offload_enabled_ = true;
+    return Status::OK();
+#else
+    return Status::Error("UDP receive offload is unsupported");
+#endif
+  }
+  bool is_receive_offload_enabled() const {
+    return is_receive_offload_enabled_;
+  }
+
   Status get_pending_error() {
     if (!get_poll_info().get_flags_local().has_pending_error()) {
       return Status::OK();
@@ -549,6 +621,7 @@ class UdpSocketFdImpl {
 
   Status send_message(const UdpSocketFd::OutboundMessage &message, bool &is_sent) {
     is_sent = false;
+    CHECK(message.segment_size == 0 || is_send_offload_enabled_);
     msghdr message_header;
     detail::UdpSocketSendHelper helper;
     helper.to_native(message, message_header);
@@ -635,6 +708,15 @@ class UdpSocketFdImpl {
 
  private:
   PollableFdInfo info_;
+  bool is_send_offload_enabled_ = false;
+  bool is_receive_offload_enabled_ = false;
+
+#if TD_HAS_MMSG
+  vector<detail::UdpSocketSendHelper> send_helpers_;
+  vector<mmsghdr> send_headers_;
+  vector<detail::UdpSocketReceiveHelper> receive_helpers_;
+  vector<mmsghdr> receive_headers_;
+#endif
 
   Status send_messages_slow(Span<UdpSocketFd::OutboundMessage> messages, size_t &cnt) {
     cnt = 0;
@@ -654,17 +736,21 @@ class UdpSocketFdImpl {
     //  msghdr msg_hdr;        [> Message header <]
     //  unsigned int msg_len;  [> Number of bytes transmitted <]
     //};
-    std::array<detail::UdpSocketSendHelper, 16> helpers;
-    std::array<mmsghdr, 16> headers;
-    size_t to_send = min(messages.size(), headers.size());
+    size_t to_send = min(messages.size(), UdpSocketFd::MAX_BATCH_SIZE);
+    if (send_headers_.size() < to_send) {
+      send_helpers_.resize(to_send);
+      send_headers_.resize(to_send);
+    }
+    auto *headers = send_headers_.data();
     for (size_t i = 0; i < to_send; i++) {
-      helpers[i].to_native(messages[i], headers[i].msg_hdr);
+      CHECK(messages[i].segment_size == 0 || is_send_offload_enabled_);
+      send_helpers_[i].to_native(messages[i], headers[i].msg_hdr);
       headers[i].msg_len = 0;
     }
 
     auto native_fd = get_native_fd().socket();
     auto sendmmsg_res =
-        detail::skip_eintr([&] { return sendmmsg(native_fd, headers.data(), narrow_cast<unsigned int>(to_send), 0); });
+        detail::skip_eintr([&] { return sendmmsg(native_fd, headers, narrow_cast<unsigned int>(to_send), 0); });
     auto sendmmsg_errno = errno;
     if (sendmmsg_res >= 0) {
       cnt = sendmmsg_res;
@@ -705,17 +791,20 @@ class UdpSocketFdImpl {
     //  msghdr msg_hdr;        [> Message header <]
     //  unsigned int msg_len;  [> Number of bytes transmitted <]
     //};
-    std::array<detail::UdpSocketReceiveHelper, 16> helpers;
-    std::array<mmsghdr, 16> headers;
-    size_t to_receive = min(messages.size(), headers.size());
+    size_t to_receive = min(messages.size(), UdpSocketFd::MAX_BATCH_SIZE);
+    if (receive_headers_.size() < to_receive) {
+      receive_helpers_.resize(to_receive);
+      receive_headers_.resize(to_receive);
+    }
+    auto *headers = receive_headers_.data();
     for (size_t i = 0; i < to_receive; i++) {
-      helpers[i].to_native(messages[i], headers[i].msg_hdr);
+      receive_helpers_[i].to_native(messages[i], headers[i].msg_hdr);
       headers[i].msg_len = 0;
     }
 
     auto native_fd = get_native_fd().socket();
     auto recvmmsg_res = detail::skip_eintr(
-        [&] { return recvmmsg(native_fd, headers.data(), narrow_cast<unsigned int>(to_receive), flags, nullptr); });
+        [&] { return recvmmsg(native_fd, headers, narrow_cast<unsigned int>(to_receive), flags, nullptr); });
     auto recvmmsg_errno = errno;
     if (recvmmsg_res >= 0) {
       cnt = narrow_cast<size_t>(recvmmsg_res);
@@ -738,6 +827,13 @@ void UdpSocketFdImplDeleter::operator()(UdpSocketFdImpl *impl) {
 #endif
 }  // namespace detail
 
+#if TD_PORT_POSIX
+constexpr size_t UdpSocketFd::MAX_BATCH_SIZE;
+constexpr size_t UdpSocketFd::MAX_SEGMENT_COUNT;
+constexpr size_t UdpSocketFd::MAX_SEGMENTED_MESSAGE_SIZE;
+constexpr size_t UdpSocketFd::MAX_COALESCED_MESSAGE_SIZE;
+#endif
+
 UdpSocketFd::UdpSocketFd() = default;
 UdpSocketFd::UdpSocketFd(UdpSocketFd &&) noexcept = default;
 UdpSocketFd &UdpSocketFd::operator=(UdpSocketFd &&) noexcept = default;
@@ -797,6 +893,19 @@ Status UdpSocketFd::receive_message(InboundMessage &message, bool &is_received)
   return impl_->receive_message(message, is_received);
 }
 
+Status UdpSocketFd::enable_send_offload() {
+  return impl_->enable_send_offload();
+}
+bool UdpSocketFd::is_send_offload_enabled() const {
+  return impl_->is_send_offload_enabled();
+}
+Status UdpSocketFd::enable_receive_offload() {
+  return impl_->enable_receive_offload();
+}
+bool UdpSocketFd::is_receive_offload_enabled() const {
+  return impl_->is_receive_offload_enabled();
+}
+
 Status UdpSocketFd::send_messages(Span<OutboundMessage> messages, size_t &count) {
   return impl_->send_messages(messages, count);
 }
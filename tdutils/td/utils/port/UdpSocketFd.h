@@ -59,16 +59,38 @@ class UdpSocketFd {
   static bool is_critical_read_error(const Status &status);
 
 #if TD_PORT_POSIX
+  // maximum number of messages, which are sent or received by one call to send_messages or receive_messages
+  static constexpr size_t MAX_BATCH_SIZE = 64;
+
+  // maximum number of segments and total size of a message sent with segmentation offload
+  static constexpr size_t MAX_SEGMENT_COUNT = 64;
+  static constexpr size_t MAX_SEGMENTED_MESSAGE_SIZE = 65000;
+
+  // maximum total size of datagrams coalesced by receive offload
+  static constexpr size_t MAX_COALESCED_MESSAGE_SIZE = 1 << 16;
+
   struct OutboundMessage {
     const IPAddress *to;
     Slice data;
+    // if non-zero, data is sent as several datagrams of segment_size bytes; the last datagram can be shorter
+    size_t segment_size = 0;
   };
   struct InboundMessage {
     IPAddress *from;
     MutableSlice data;
     Status *error;
+    // if non-zero, data contains several coalesced datagrams of segment_size bytes; the last datagram can be shorter
+    size_t segment_size = 0;
   };
 
+  // enables UDP generic segmentation offload, which allows to send messages with non-zero segment_size
+  Status enable_send_offload() TD_WARN_UNUSED_RESULT;
+  bool is_send_offload_enabled() const;
+
+  // enables UDP generic receive offload; buffers of received messages must have space for MAX_COALESCED_MESSAGE_SIZE bytes
+  Status enable_receive_offload() TD_WARN_UNUSED_RESULT;
+  bool is_receive_offload_enabled() const;
+
   Status send_message(const OutboundMessage &message, bool &is_sent) TD_WARN_UNUSED_RESULT;
   Status receive_message(InboundMessage &message, bool &is_received) TD_WARN_UNUSED_RESULT;
 
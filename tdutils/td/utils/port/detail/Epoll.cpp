@@ -14,13 +14,41 @@ char disable_linker_warning_about_empty_file_epoll_cpp TD_UNUSED;
 #include "td/utils/logging.h"
 #include "td/utils/Status.h"
 
+#include <atomic>
 #include <cerrno>
 
 #include <unistd.h>
 
 namespace td {
 namespace detail {
+
+static std::atomic<bool> is_io_uring_enabled{false};
+
+void Epoll::set_io_uring_enabled(bool is_enabled) {
+  is_io_uring_enabled.store(is_enabled, std::memory_order_relaxed);
+}
+
+bool Epoll::is_io_uring_used() const {
+#ifdef TD_POLL_IO_URING
+  return io_uring_poll_ != nullptr;
+#else
+  return false;
+#endif
+}
+
 void Epoll::init() {
+#ifdef TD_POLL_IO_URING
+  CHECK(io_uring_poll_ == nullptr);
+  if (is_io_uring_enabled.load(std::memory_order_relaxed)) {
+    auto io_uring_poll = make_unique<IoUringPoll>();
+    auto status = io_uring_poll->try_init();
+    if (status.is_ok()) {
+      io_uring_poll_ = std::move(io_uring_poll);
+      return;
+    }
+    LOG(WARNING) << "Failed to use io_uring: " << status;
+  }
+#endif
   CHECK(!epoll_fd_);
   epoll_fd_ = NativeFd(epoll_create(1));
   auto epoll_create_errno = errno;
@@ -30,6 +58,13 @@ void Epoll::init() {
 }
 
 void Epoll::clear() {
+#ifdef TD_POLL_IO_URING
+  if (io_uring_poll_ != nullptr) {
+    io_uring_poll_->clear();
+    io_uring_poll_ = nullptr;
+    return;
+  }
+#endif
   if (!epoll_fd_) {
     return;
   }
@@ -44,6 +79,11 @@ void Epoll::clear() {
 }
 
 void Epoll::subscribe(PollableFd fd, PollFlags flags) {
+#ifdef TD_POLL_IO_URING
+  if (io_uring_poll_ != nullptr) {
+    return io_uring_poll_->subscribe(std::move(fd), flags);
+  }
+#endif
   epoll_event event;
   event.events = EPOLLHUP | EPOLLERR | EPOLLET;
 #ifdef EPOLLRDHUP
@@ -67,6 +107,11 @@ void Epoll::subscribe(PollableFd fd, PollFlags flags) {
 }
 
 void Epoll::unsubscribe(PollableFdRef fd_ref) {
+#ifdef TD_POLL_IO_URING
+  if (io_uring_poll_ != nullptr) {
+    return io_uring_poll_->unsubscribe(fd_ref);
+  }
+#endif
   auto fd = fd_ref.lock();
   auto native_fd = fd.native_fd().fd();
   int err = epoll_ctl(epoll_fd_.fd(), EPOLL_CTL_DEL, native_fd, nullptr);
@@ -81,6 +126,11 @@ void Epoll::unsubscribe_before_close(PollableFdRef fd) {
 }
 
 void Epoll::run(int timeout_ms) {
+#ifdef TD_POLL_IO_URING
+  if (io_uring_poll_ != nullptr) {
+    return io_uring_poll_->run(timeout_ms);
+  }
+#endif
   int ready_n = epoll_wait(epoll_fd_.fd(), &events_[0], static_cast<int>(events_.size()), timeout_ms);
   auto epoll_wait_errno = errno;
   LOG_IF(FATAL, ready_n == -1 && epoll_wait_errno != EINTR)
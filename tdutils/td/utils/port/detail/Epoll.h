@@ -12,6 +12,7 @@
 
 #include "td/utils/common.h"
 #include "td/utils/List.h"
+#include "td/utils/port/detail/IoUringPoll.h"
 #include "td/utils/port/detail/NativeFd.h"
 #include "td/utils/port/detail/PollableFd.h"
 #include "td/utils/port/PollBase.h"
@@ -47,7 +48,15 @@ class Epoll final : public PollBase {
     return true;
   }
 
+  // if enabled, Epoll instances initialized after the call will use io_uring instead of epoll if it is supported
+  static void set_io_uring_enabled(bool is_enabled);
+
+  bool is_io_uring_used() const;
+
  private:
+#ifdef TD_POLL_IO_URING
+  unique_ptr<IoUringPoll> io_uring_poll_;
+#endif
   NativeFd epoll_fd_;
   vector<struct epoll_event> events_;
   ListNode list_root_;
@@ -0,0 +1,407 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/port/detail/IoUringPoll.h"
+
+char disable_linker_warning_about_empty_file_io_uring_poll_cpp TD_UNUSED;
+
+#ifdef TD_POLL_IO_URING
+
+#include "td/utils/algorithm.h"
+#include "td/utils/logging.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <endian.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace td {
+namespace detail {
+
+#ifdef IORING_POLL_ADD_MULTI
+
+static constexpr uint32 SQ_ENTRIES = 256;
+static constexpr uint32 CQ_ENTRIES = 4096;
+
+static uint32 load_acquire(const uint32 *ptr) {
+  return reinterpret_cast<const std::atomic<uint32> *>(ptr)->load(std::memory_order_acquire);
+}
+
+static void store_release(uint32 *ptr, uint32 value) {
+  reinterpret_cast<std::atomic<uint32> *>(ptr)->store(value, std::memory_order_release);
+}
+
+IoUringPoll::~IoUringPoll() {
+  destroy_ring();
+}
+
+Status IoUringPoll::try_init() {
+  CHECK(!ring_fd_);
+  struct io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = CQ_ENTRIES;
+  auto fd = static_cast<int>(syscall(__NR_io_uring_setup, SQ_ENTRIES, &params));
+  if (fd < 0) {
+    return OS_ERROR("io_uring_setup failed");
+  }
+  ring_fd_ = NativeFd(fd);
+
+  // multishot poll requests were added in Linux 5.13 together with IORING_FEAT_RSRC_TAGS
+  constexpr uint32 REQUIRED_FEATURES = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG | IORING_FEAT_RSRC_TAGS;
+  if ((params.features & REQUIRED_FEATURES) != REQUIRED_FEATURES) {
+    destroy_ring();
+    return Status::Error(PSLICE() << "Unsupported io_uring features " << params.features);
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool is_single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (is_single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = max(sq_ring_size_, cq_ring_size_);
+  }
+  auto map = [&](size_t size, off_t offset) -> void * {
+    auto *result = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_.fd(), offset);
+    return result == MAP_FAILED ? nullptr : result;
+  };
+  sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == nullptr) {
+    auto status = OS_ERROR("Failed to map io_uring submission queue");
+    destroy_ring();
+    return status;
+  }
+  if (is_single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = map(cq_ring_size_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == nullptr) {
+      auto status = OS_ERROR("Failed to map io_uring completion queue");
+      destroy_ring();
+      return status;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ = static_cast<struct io_uring_sqe *>(map(sqes_size_, IORING_OFF_SQES));
+  if (sqes_ == nullptr) {
+    auto status = OS_ERROR("Failed to map io_uring submission queue entries");
+    destroy_ring();
+    return status;
+  }
+
+  auto *sq_ring = static_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<uint32 *>(sq_ring + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<uint32 *>(sq_ring + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<uint32 *>(sq_ring + params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  auto *sq_array = reinterpret_cast<uint32 *>(sq_ring + params.sq_off.array);
+  for (uint32 i = 0; i < sq_entries_; i++) {
+    sq_array[i] = i;
+  }
+
+  auto *cq_ring = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<uint32 *>(cq_ring + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32 *>(cq_ring + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<uint32 *>(cq_ring + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq_ring + params.cq_off.cqes);
+  return Status::OK();
+}
+
+void IoUringPoll::init() {
+  auto status = try_init();
+  LOG_IF(FATAL, status.is_error()) << status;
+}
+
+void IoUringPoll::destroy_ring() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+  unsubmitted_count_ = 0;
+  ring_fd_.close();
+}
+
+void IoUringPoll::clear() {
+  if (!ring_fd_) {
+    return;
+  }
+  destroy_ring();
+  subscriptions_.clear();
+  delayed_events_.clear();
+
+  for (auto *list_node = list_root_.next; list_node != &list_root_;) {
+    auto pollable_fd = PollableFd::from_list_node(list_node);
+    list_node = list_node->next;
+  }
+}
+
+struct io_uring_sqe *IoUringPoll::get_sqe() {
+  auto tail = *sq_tail_;
+  if (tail - load_acquire(sq_head_) == sq_entries_) {
+    enter(0, 0);
+    CHECK(tail - load_acquire(sq_head_) < sq_entries_);
+  }
+  auto *sqe = &sqes_[tail & sq_mask_];
+  std::memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+void IoUringPoll::push_sqe() {
+  store_release(sq_tail_, *sq_tail_ + 1);
+  unsubmitted_count_++;
+}
+
+void IoUringPoll::arm_poll(ListNode *list_node, Subscription &subscription) {
+  CHECK(!subscription.is_armed);
+  auto poll_mask = subscription.poll_mask;
+#if __BYTE_ORDER == __BIG_ENDIAN
+  poll_mask = (poll_mask << 16) | (poll_mask >> 16);
+#endif
+  auto *sqe = get_sqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = subscription.native_fd;
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->poll32_events = poll_mask;
+  sqe->user_data = reinterpret_cast<uint64>(list_node);
+  push_sqe();
+  subscription.is_armed = true;
+}
+
+void IoUringPoll::enter(uint32 min_complete, int timeout_ms) {
+  if (min_complete == 0 && unsubmitted_count_ == 0) {
+    return;
+  }
+  uint32 flags = 0;
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+  std::memset(&arg, 0, sizeof(arg));
+  if (min_complete > 0) {
+    flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    if (timeout_ms >= 0) {
+      ts.tv_sec = timeout_ms / 1000;
+      ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+      arg.ts = reinterpret_cast<uint64>(&ts);
+    }
+  }
+  auto result = syscall(__NR_io_uring_enter, ring_fd_.fd(), unsubmitted_count_, min_complete, flags,
+                        min_complete > 0 ? &arg : nullptr, min_complete > 0 ? sizeof(arg) : 0);
+  if (result >= 0) {
+    CHECK(static_cast<uint32>(result) <= unsubmitted_count_);
+    unsubmitted_count_ -= static_cast<uint32>(result);
+    return;
+  }
+  auto io_uring_enter_errno = errno;
+  LOG_IF(FATAL, io_uring_enter_errno != EINTR && io_uring_enter_errno != ETIME && io_uring_enter_errno != EBUSY &&
+                    io_uring_enter_errno != EAGAIN)
+      << Status::PosixError(io_uring_enter_errno, "io_uring_enter failed");
+}
+
+template <class F>
+void IoUringPoll::reap_completions(F &&f) {
+  auto head = *cq_head_;
+  while (head != load_acquire(cq_tail_)) {
+    auto cqe = cqes_[head & cq_mask_];
+    head++;
+    store_release(cq_head_, head);
+    f(reinterpret_cast<ListNode *>(cqe.user_data), cqe.res, (cqe.flags & IORING_CQE_F_MORE) != 0);
+  }
+}
+
+PollFlags IoUringPoll::on_poll_completion(ListNode *list_node, int32 result, bool has_more) {
+  auto it = subscriptions_.find(list_node);
+  CHECK(it != subscriptions_.end());
+  auto &subscription = it->second;
+
+  PollFlags flags;
+  if (result < 0) {
+    if (result != -ECANCELED) {
+      LOG(ERROR) << Status::PosixError(-result, "io_uring poll failed") << ", fd = " << subscription.native_fd;
+      flags = PollFlags::Error();
+    }
+  } else {
+    auto events = static_cast<uint32>(result);
+    if (events & POLLIN) {
+      flags = flags | PollFlags::Read();
+    }
+    if (events & POLLOUT) {
+      flags = flags | PollFlags::Write();
+    }
+#ifdef POLLRDHUP
+    if (events & POLLRDHUP) {
+      flags = flags | PollFlags::Close();
+    }
+#endif
+    if (events & POLLHUP) {
+      flags = flags | PollFlags::Close();
+    }
+    if (events & POLLERR) {
+      flags = flags | PollFlags::Error();
+    }
+  }
+
+  if (!has_more) {
+    // the multishot request was terminated by the kernel, for example, because of completion queue overflow
+    subscription.is_armed = false;
+    if (result >= 0 || result == -ECANCELED) {
+      arm_poll(list_node, subscription);
+    }
+  }
+  return flags;
+}
+
+void IoUringPoll::process_event(ListNode *list_node, PollFlags flags) {
+  if (flags.empty()) {
+    return;
+  }
+  auto pollable_fd = PollableFd::from_list_node(list_node);
+  pollable_fd.add_flags(flags);
+  pollable_fd.release_as_list_node();
+}
+
+void IoUringPoll::subscribe(PollableFd fd, PollFlags flags) {
+  Subscription subscription;
+  subscription.native_fd = fd.native_fd().fd();
+  subscription.poll_mask = POLLHUP | POLLERR;
+#ifdef POLLRDHUP
+  subscription.poll_mask |= POLLRDHUP;
+#endif
+  if (flags.can_read()) {
+    subscription.poll_mask |= POLLIN;
+  }
+  if (flags.can_write()) {
+    subscription.poll_mask |= POLLOUT;
+  }
+  auto *list_node = fd.release_as_list_node();
+  list_root_.put(list_node);
+
+  auto &new_subscription = subscriptions_[list_node];
+  CHECK(new_subscription.poll_mask == 0);
+  new_subscription = subscription;
+  arm_poll(list_node, new_subscription);
+}
+
+void IoUringPoll::unsubscribe(PollableFdRef fd_ref) {
+  auto *list_node = fd_ref.lock().release_as_list_node();
+  auto it = subscriptions_.find(list_node);
+  CHECK(it != subscriptions_.end());
+  td::remove_if(delayed_events_, [list_node](const Event &event) { return event.list_node == list_node; });
+
+  if (it->second.is_armed) {
+    // wait for the final completion of the request, because list_node can't be used after the method returns
+    bool is_removed = false;
+    bool need_remove = true;
+    while (!is_removed) {
+      if (need_remove) {
+        auto *sqe = get_sqe();
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = reinterpret_cast<uint64>(list_node);
+        push_sqe();
+        need_remove = false;
+      }
+      enter(1, -1);
+      reap_completions([&](ListNode *node, int32 result, bool has_more) {
+        if (node == nullptr) {
+          // the request is being completed right now, so the removal must be retried
+          if (result == -EALREADY) {
+            need_remove = true;
+          }
+          return;
+        }
+        if (node == list_node) {
+          if (!has_more) {
+            is_removed = true;
+          }
+          return;
+        }
+        // observers can't be notified there, so delay the event till the next run
+        auto flags = on_poll_completion(node, result, has_more);
+        if (!flags.empty()) {
+          delayed_events_.push_back({node, flags});
+        }
+      });
+    }
+  }
+  subscriptions_.erase(list_node);
+
+  PollableFd::from_list_node(list_node);  // unlocks the fd
+}
+
+void IoUringPoll::unsubscribe_before_close(PollableFdRef fd) {
+  unsubscribe(fd);
+}
+
+void IoUringPoll::run(int timeout_ms) {
+  if (!delayed_events_.empty()) {
+    auto events = std::move(delayed_events_);
+    delayed_events_.clear();
+    for (auto &event : events) {
+      process_event(event.list_node, event.flags);
+    }
+    timeout_ms = 0;
+  }
+
+  enter(timeout_ms == 0 ? 0 : 1, timeout_ms);
+  reap_completions([&](ListNode *list_node, int32 result, bool has_more) {
+    if (list_node == nullptr) {
+      // result of IORING_OP_POLL_REMOVE
+      return;
+    }
+    process_event(list_node, on_poll_completion(list_node, result, has_more));
+  });
+}
+
+#else
+
+IoUringPoll::~IoUringPoll() = default;
+
+Status IoUringPoll::try_init() {
+  return Status::Error("io_uring multishot poll isn't supported by system headers");
+}
+
+void IoUringPoll::init() {
+  UNREACHABLE();
+}
+
+void IoUringPoll::clear() {
+}
+
+void IoUringPoll::subscribe(PollableFd fd, PollFlags flags) {
+  UNREACHABLE();
+}
+
+void IoUringPoll::unsubscribe(PollableFdRef fd) {
+  UNREACHABLE();
+}
+
+void IoUringPoll::unsubscribe_before_close(PollableFdRef fd) {
+  UNREACHABLE();
+}
+
+void IoUringPoll::run(int timeout_ms) {
+  UNREACHABLE();
+}
+
+#endif
+
+}  // namespace detail
+}  // namespace td
+
+#endif
@@ -0,0 +1,123 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/port/config.h"
+
+#if TD_LINUX && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define TD_POLL_IO_URING 1
+#endif
+#endif
+
+#ifdef TD_POLL_IO_URING
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/List.h"
+#include "td/utils/port/detail/NativeFd.h"
+#include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/port/PollBase.h"
+#include "td/utils/port/PollFlags.h"
+#include "td/utils/Status.h"
+
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+namespace td {
+namespace detail {
+
+// edge-triggered poll, which uses multishot IORING_OP_POLL_ADD requests; requests are submitted in batches
+// together with waiting for new events
+class IoUringPoll final : public PollBase {
+ public:
+  IoUringPoll() = default;
+  IoUringPoll(const IoUringPoll &) = delete;
+  IoUringPoll &operator=(const IoUringPoll &) = delete;
+  IoUringPoll(IoUringPoll &&) = delete;
+  IoUringPoll &operator=(IoUringPoll &&) = delete;
+  ~IoUringPoll() final;
+
+  // fails if io_uring or some of the needed features aren't supported by the kernel
+  Status try_init();
+
+  void init() final;
+
+  void clear() final;
+
+  void subscribe(PollableFd fd, PollFlags flags) final;
+
+  void unsubscribe(PollableFdRef fd) final;
+
+  void unsubscribe_before_close(PollableFdRef fd) final;
+
+  void run(int timeout_ms) final;
+
+  static bool is_edge_triggered() {
+    return true;
+  }
+
+ private:
+  struct Subscription {
+    int native_fd = -1;
+    uint32 poll_mask = 0;
+    bool is_armed = false;
+  };
+
+  struct Event {
+    ListNode *list_node = nullptr;
+    PollFlags flags;
+  };
+
+  NativeFd ring_fd_;
+  void *sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void *cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  struct io_uring_sqe *sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  uint32 *sq_head_ = nullptr;
+  uint32 *sq_tail_ = nullptr;
+  uint32 sq_mask_ = 0;
+  uint32 sq_entries_ = 0;
+  uint32 *cq_head_ = nullptr;
+  uint32 *cq_tail_ = nullptr;
+  uint32 cq_mask_ = 0;
+  struct io_uring_cqe *cqes_ = nullptr;
+
+  uint32 unsubmitted_count_ = 0;
+
+  ListNode list_root_;
+  FlatHashMap<ListNode *, Subscription> subscriptions_;
+  vector<Event> delayed_events_;
+
+  struct io_uring_sqe *get_sqe();
+
+  void push_sqe();
+
+  void arm_poll(ListNode *list_node, Subscription &subscription);
+
+  // submits all queued requests and waits for at least min_complete completions or until timeout expires
+  void enter(uint32 min_complete, int timeout_ms);
+
+  // calls the callback for all available completions; list_node is nullptr for IORING_OP_POLL_REMOVE requests
+  template <class F>
+  void reap_completions(F &&f);
+
+  // returns new flags of the fd and rearms the request if needed
+  PollFlags on_poll_completion(ListNode *list_node, int32 result, bool has_more);
+
+  void process_event(ListNode *list_node, PollFlags flags);
+
+  void destroy_ring();
+};
+
+}  // namespace detail
+}  // namespace td
+
+#endif
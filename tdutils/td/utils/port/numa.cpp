@@ -0,0 +1,102 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/port/numa.h"
+
+#include "td/utils/port/config.h"
+
+#if TD_LINUX
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/ScopeGuard.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Status.h"
+#endif
+
+namespace td {
+
+#if TD_LINUX
+static Result<string> read_sysfs_file(CSlice path) {
+  TRY_RESULT(fd, FileFd::open(path, FileFd::Read));
+  SCOPE_EXIT {
+    fd.close();
+  };
+
+  constexpr size_t MAX_FILE_SIZE = 4096;
+  char buf[MAX_FILE_SIZE];
+  TRY_RESULT(size, fd.read(MutableSlice(buf, MAX_FILE_SIZE)));
+  if (size == MAX_FILE_SIZE) {
+    return Status::Error("File is too big");
+  }
+  return string(buf, size);
+}
+
+// parses lists like "0-3,8,10-11" and returns mask of the first 64 elements of the list;
+// sets is_truncated to true if the list has elements, which don't fit in the mask
+static Result<uint64> parse_list_mask(Slice list, bool &is_truncated) {
+  uint64 mask = 0;
+  for (auto range : full_split(trim(list), ',')) {
+    if (range.empty()) {
+      continue;
+    }
+    auto range_ends = split(range, '-');
+    TRY_RESULT(begin, to_integer_safe<int32>(range_ends.first));
+    auto end = begin;
+    if (!range_ends.second.empty()) {
+      TRY_RESULT_ASSIGN(end, to_integer_safe<int32>(range_ends.second));
+    }
+    if (begin < 0 || end < begin) {
+      return Status::Error("Invalid list");
+    }
+    if (end >= 64) {
+      is_truncated = true;
+    }
+    for (auto i = begin; i <= end && i < 64; i++) {
+      mask |= static_cast<uint64>(1) << i;
+    }
+  }
+  return mask;
+}
+
+static Result<vector<uint64>> get_numa_node_cpu_masks_impl() {
+  TRY_RESULT(online_nodes, read_sysfs_file("/sys/devices/system/node/online"));
+  bool is_truncated = false;
+  TRY_RESULT(node_mask, parse_list_mask(online_nodes, is_truncated));
+  vector<uint64> result;
+  for (int32 node_id = 0; node_id < 64; node_id++) {
+    if (((node_mask >> node_id) & 1) == 0) {
+      continue;
+    }
+    TRY_RESULT(cpu_list, read_sysfs_file(PSLICE() << "/sys/devices/system/node/node" << node_id << "/cpulist"));
+    TRY_RESULT(cpu_mask, parse_list_mask(cpu_list, is_truncated));
+    if (cpu_mask != 0) {
+      result.push_back(cpu_mask);
+    }
+  }
+  if (is_truncated) {
+    static bool is_logged = [] {
+      LOG(WARNING) << "Ignore NUMA nodes and CPUs with identifiers 64 and more";
+      return true;
+    }();
+    CHECK(is_logged);
+  }
+  return std::move(result);
+}
+#endif
+
+vector<uint64> get_numa_node_cpu_masks() {
+#if TD_LINUX
+  auto r_masks = get_numa_node_cpu_masks_impl();
+  if (r_masks.is_ok()) {
+    return r_masks.move_as_ok();
+  }
+#endif
+  return {};
+}
+
+}  // namespace td
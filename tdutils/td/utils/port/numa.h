@@ -0,0 +1,18 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// returns masks of the first 64 CPUs of each of the first 64 NUMA nodes, which has such CPUs
+// CPUs and NUMA nodes with identifiers 64 and more are ignored with a warning
+// returns an empty vector if NUMA topology is unknown
+vector<uint64> get_numa_node_cpu_masks();
+
+}  // namespace td
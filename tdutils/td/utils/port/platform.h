@@ -114,6 +114,11 @@
 
 #define TD_CONCURRENCY_PAD 128
 
+// the maximum number of simultaneously running threads, which can use thread-local storage; can be overridden
+#ifndef TD_MAX_THREAD_COUNT
+  #define TD_MAX_THREAD_COUNT 128
+#endif
+
 #if !TD_WINDOWS && defined(__SIZEOF_INT128__)
 #define TD_HAVE_INT128 1
 #endif
@@ -199,9 +199,11 @@ class TlBufferParser : public TlParser {
   template <class T>
   T fetch_string() {
     auto result = TlParser::fetch_string<T>();
-    for (auto &c : result) {
-      if (c == '\0') {
-        c = ' ';
+    if (std::memchr(result.data(), '\0', result.size()) != nullptr) {
+      for (auto &c : result) {
+        if (c == '\0') {
+          c = ' ';
+        }
       }
     }
     if (is_valid_utf8(result)) {
@@ -7,7 +7,6 @@
 #include "td/utils/translit.h"
 
 #include "td/utils/algorithm.h"
-#include "td/utils/FlatHashMap.h"
 #include "td/utils/misc.h"
 #include "td/utils/utf8.h"
 
@@ -16,11 +15,25 @@
 
 namespace td {
 
-static const FlatHashMap<uint32, string> &get_en_to_ru_simple_rules() {
-  static const FlatHashMap<uint32, string> rules{
-      {'a', "а"}, {'b', "б"}, {'c', "к"}, {'d', "д"}, {'e', "е"}, {'f', "ф"},  {'g', "г"}, {'h', "х"}, {'i', "и"},
-      {'j', "й"}, {'k', "к"}, {'l', "л"}, {'m', "м"}, {'n', "н"}, {'o', "о"},  {'p', "п"}, {'q', "к"}, {'r', "р"},
-      {'s', "с"}, {'t', "т"}, {'u', "у"}, {'v', "в"}, {'w', "в"}, {'x', "кс"}, {'y', "и"}, {'z', "з"}};
+namespace {
+
+// replacements of consecutive characters starting from first_code_; nullptr if there is no replacement
+struct SimpleTranslitRules {
+  uint32 first_code_;
+  vector<const char *> replacements_;
+
+  const char *get_replacement(uint32 code) const {
+    code -= first_code_;
+    return code < replacements_.size() ? replacements_[code] : nullptr;
+  }
+};
+
+}  // namespace
+
+static const SimpleTranslitRules &get_en_to_ru_simple_rules() {
+  static const SimpleTranslitRules rules{
+      'a', {"а", "б", "к", "д", "е", "ф", "г", "х", "и", "й", "к", "л", "м",
+            "н", "о", "п", "к", "р", "с", "т", "у", "в", "в", "кс", "и", "з"}};
   return rules;
 }
 
@@ -32,13 +45,10 @@ static const std::vector<std::pair<string, string>> &get_en_to_ru_complex_rules(
   return rules;
 }
 
-static const FlatHashMap<uint32, string> &get_ru_to_en_simple_rules() {
-  static const FlatHashMap<uint32, string> rules{
-      {0x430, "a"},  {0x431, "b"},  {0x432, "v"},  {0x433, "g"},  {0x434, "d"},  {0x435, "e"},   {0x451, "e"},
-      {0x436, "zh"}, {0x437, "z"},  {0x438, "i"},  {0x439, "y"},  {0x43a, "k"},  {0x43b, "l"},   {0x43c, "m"},
-      {0x43d, "n"},  {0x43e, "o"},  {0x43f, "p"},  {0x440, "r"},  {0x441, "s"},  {0x442, "t"},   {0x443, "u"},
-      {0x444, "f"},  {0x445, "kh"}, {0x446, "ts"}, {0x447, "ch"}, {0x448, "sh"}, {0x449, "sch"}, {0x44a, ""},
-      {0x44b, "y"},  {0x44c, ""},   {0x44d, "e"},  {0x44e, "yu"}, {0x44f, "ya"}};
+static const SimpleTranslitRules &get_ru_to_en_simple_rules() {
+  static const SimpleTranslitRules rules{
+      0x430, {"a", "b", "v",  "g",  "d",  "e",  "zh",  "z", "i", "y", "k", "l",  "m",  "n",     "o", "p", "r",
+              "s", "t", "u",  "f",  "kh", "ts", "ch",  "sh", "sch", "", "y", "", "e", "yu", "ya", nullptr, "e"}};
   return rules;
 }
 
@@ -49,20 +59,25 @@ static const std::vector<std::pair<string, string>> &get_ru_to_en_complex_rules(
 }
 
 static void add_word_transliterations(vector<string> &result, Slice word, bool allow_partial,
-                                      const FlatHashMap<uint32, string> &simple_rules,
+                                      const SimpleTranslitRules &simple_rules,
                                       const vector<std::pair<string, string>> &complex_rules) {
   string s;
+  auto append_character = [&](const unsigned char *begin, const unsigned char *end, uint32 code) {
+    auto replacement = simple_rules.get_replacement(code);
+    if (replacement != nullptr) {
+      s += replacement;
+    } else {
+      s.append(reinterpret_cast<const char *>(begin), end - begin);
+    }
+  };
+
   auto pos = word.ubegin();
   auto end = word.uend();
   while (pos != end) {
     uint32 code;
-    pos = next_utf8_unsafe(pos, &code);
-    auto it = simple_rules.find(code);
-    if (it != simple_rules.end()) {
-      s += it->second;
-    } else {
-      append_utf8_character(s, code);
-    }
+    auto next_pos = next_utf8_unsafe(pos, &code);
+    append_character(pos, next_pos, code);
+    pos = next_pos;
   }
   if (!s.empty()) {
     result.push_back(std::move(s));
@@ -89,25 +104,23 @@ static void add_word_transliterations(vector<string> &result, Slice word, bool a
     }
 
     uint32 code;
-    pos = next_utf8_unsafe(pos, &code);
-    auto it = simple_rules.find(code);
-    if (it != simple_rules.end()) {
-      s += it->second;
-    } else {
-      append_utf8_character(s, code);
-    }
+    auto next_pos = next_utf8_unsafe(pos, &code);
+    append_character(pos, next_pos, code);
+    pos = next_pos;
   }
   if (!s.empty()) {
     result.push_back(std::move(s));
   }
 }
 
-vector<string> get_word_transliterations(Slice word, bool allow_partial) {
-  vector<string> result;
-
+void append_word_transliterations(vector<string> &result, Slice word, bool allow_partial) {
   add_word_transliterations(result, word, allow_partial, get_en_to_ru_simple_rules(), get_en_to_ru_complex_rules());
   add_word_transliterations(result, word, allow_partial, get_ru_to_en_simple_rules(), get_ru_to_en_complex_rules());
+}
 
+vector<string> get_word_transliterations(Slice word, bool allow_partial) {
+  vector<string> result;
+  append_word_transliterations(result, word, allow_partial);
   td::unique(result);
   return result;
 }
@@ -13,4 +13,7 @@ namespace td {
 
 vector<string> get_word_transliterations(Slice word, bool allow_partial);
 
+// appends unsorted transliterations of the word, which may contain duplicates and the word itself
+void append_word_transliterations(vector<string> &result, Slice word, bool allow_partial);
+
 }  // namespace td
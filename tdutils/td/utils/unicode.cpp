@@ -6,7 +6,10 @@
 //
 #include "td/utils/unicode.h"
 
+#include "td/utils/algorithm.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
 
 namespace td {
 
@@ -1275,6 +1278,29 @@ UnicodeSimpleCategory get_unicode_simple_category(uint32 code) {
   return static_cast<UnicodeSimpleCategory>(*(it - 1) & 31);
 }
 
+/**
+ * Returns the replacement of the specified character from a range with the specified type
+ */
+static uint32 get_range_replacement(int32 range_begin, int32 t, uint32 code) {
+  if (t < 0) {
+    return code - range_begin + (~t);
+  }
+  if (t <= 0x10ffff) {
+    return t;
+  }
+  switch (t - 0x200000) {
+    case 0:
+      return (code & -2);
+    case 1:
+      return (code | 1);
+    case 2:
+      return ((code - 1) | 1);
+    default:
+      LOG(FATAL) << code << " " << range_begin << " " << t;
+      return 0;
+  }
+}
+
 /**
  * Search pregenerated ranges of pairs for the replacement of specified character
  */
@@ -1296,48 +1322,111 @@ static uint32 binary_search_ranges(const int32 (&ranges)[N], uint32 code) {
     }
   }
 
-  int32 t = ranges[l + 1];
-  if (t < 0) {
-    return code - ranges[l] + (~t);
+  return get_range_replacement(ranges[l], ranges[l + 1], code);
+}
+
+namespace {
+
+/**
+ * Two-level lookup table of replacements of characters from the first two Unicode planes, which is built on first
+ * use from a pregenerated table and pregenerated ranges of pairs. Equal pages of the table are stored once, and
+ * replacements are stored as differences with the character, so most pages are shared between many blocks
+ * of characters.
+ */
+class UnicodeReplacementTable {
+ public:
+  template <size_t N>
+  UnicodeReplacementTable(const int16 (&table)[TABLE_SIZE], const int32 (&ranges)[N]) {
+    static_assert(N % 2 == 0, "");
+    CHECK(ranges[0] == static_cast<int32>(TABLE_SIZE));
+
+    FlatHashMap<string, uint16> page_ids;
+    vector<int32> page(PAGE_SIZE);
+    size_t range_pos = 0;
+    for (uint32 page_id = 0; page_id < PAGE_COUNT; page_id++) {
+      for (uint32 i = 0; i < PAGE_SIZE; i++) {
+        auto code = (page_id << PAGE_BITS) + i;
+        uint32 replacement;
+        if (code < TABLE_SIZE) {
+          replacement = table[code];
+        } else {
+          while (range_pos + 2 < N && ranges[range_pos + 2] <= static_cast<int32>(code)) {
+            range_pos += 2;
+          }
+          replacement = get_range_replacement(ranges[range_pos], ranges[range_pos + 1], code);
+        }
+        page[i] = replacement < 0x80 ? ASCII_REPLACEMENT + static_cast<int32>(replacement)
+                                     : static_cast<int32>(replacement - code);
+      }
+
+      string page_key(reinterpret_cast<const char *>(page.data()), PAGE_SIZE * sizeof(int32));
+      auto it = page_ids.emplace(std::move(page_key), narrow_cast<uint16>(page_ids.size()));
+      if (it.second) {
+        append(replacements_, page);
+      }
+      page_ids_[page_id] = it.first->second;
+    }
   }
-  if (t <= 0x10ffff) {
-    return t;
+
+  uint32 get(uint32 code) const {
+    DCHECK(contains(code));
+    auto replacement = replacements_[(static_cast<size_t>(page_ids_[code >> PAGE_BITS]) << PAGE_BITS) +
+                                     (code & (PAGE_SIZE - 1))];
+    if (replacement >= ASCII_REPLACEMENT) {
+      return static_cast<uint32>(replacement - ASCII_REPLACEMENT);
+    }
+    return code + static_cast<uint32>(replacement);
   }
-  switch (t - 0x200000) {
-    case 0:
-      return (code & -2);
-    case 1:
-      return (code | 1);
-    case 2:
-      return ((code - 1) | 1);
-    default:
-      LOG(FATAL) << code << " " << l << " " << r << " " << t;
-      return 0;
+
+  static bool contains(uint32 code) {
+    return code < (PAGE_COUNT << PAGE_BITS);
   }
-}
+
+ private:
+  static constexpr uint32 PAGE_BITS = 6;
+  static constexpr uint32 PAGE_SIZE = 1 << PAGE_BITS;
+  static constexpr uint32 PAGE_COUNT = 0x20000 >> PAGE_BITS;
+
+  // replacements with ASCII characters are stored as is to share pages with many spaces and skipped characters
+  static constexpr int32 ASCII_REPLACEMENT = 0x40000000;
+
+  uint16 page_ids_[PAGE_COUNT];
+  vector<int32> replacements_;
+};
+
+}  // namespace
 
 uint32 prepare_search_character(uint32 code) {
   if (code < TABLE_SIZE) {
     return prepare_search_character_table[code];
-  } else {
+  }
+  if (!UnicodeReplacementTable::contains(code)) {
     return binary_search_ranges(prepare_search_character_ranges, code);
   }
+  static const UnicodeReplacementTable table(prepare_search_character_table, prepare_search_character_ranges);
+  return table.get(code);
 }
 
 uint32 unicode_to_lower(uint32 code) {
   if (code < TABLE_SIZE) {
     return to_lower_table[code];
-  } else {
+  }
+  if (!UnicodeReplacementTable::contains(code)) {
     return binary_search_ranges(to_lower_ranges, code);
   }
+  static const UnicodeReplacementTable table(to_lower_table, to_lower_ranges);
+  return table.get(code);
 }
 
 uint32 remove_diacritics(uint32 code) {
   if (code < TABLE_SIZE) {
     return without_diacritics_table[code];
-  } else {
+  }
+  if (!UnicodeReplacementTable::contains(code)) {
     return binary_search_ranges(without_diacritics_ranges, code);
   }
+  static const UnicodeReplacementTable table(without_diacritics_table, without_diacritics_ranges);
+  return table.get(code);
 }
 
 }  // namespace td
@@ -6,12 +6,67 @@
 //
 #include "td/utils/utf8.h"
 
+#include "td/utils/bits.h"
 #include "td/utils/misc.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/unicode.h"
 
+#include <cstring>
+
+#if defined(__SSE2__) || (TD_MSVC && (defined(_M_X64) || (defined(_M_IX86) && _M_IX86_FP >= 2)))
+#define TD_SSE2 1
+#endif
+
+#ifdef __aarch64__
+#include <arm_neon.h>
+#endif
+
+#if TD_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace td {
 
+// SSE2 and NEON are always available on x86-64 and AArch64 respectively, so no runtime dispatch is needed
+static constexpr size_t UTF8_BLOCK_SIZE = 16;
+
+static bool is_ascii_block(const char *data) {
+#ifdef __aarch64__
+  return vmaxvq_u8(vld1q_u8(reinterpret_cast<const uint8 *>(data))) < 0x80;
+#elif TD_SSE2
+  return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data))) == 0;
+#else
+  uint64 words[2];
+  std::memcpy(words, data, sizeof(words));
+  return ((words[0] | words[1]) & static_cast<uint64>(0x8080808080808080)) == 0;
+#endif
+}
+
+// returns number of UTF-16 code units, encoded by the UTF-8 code units in the block
+static size_t get_block_utf16_length(const char *data) {
+#ifdef __aarch64__
+  auto bytes = vld1q_s8(reinterpret_cast<const int8 *>(data));
+  // first code units are greater than -65, first code units of 4-byte characters are in range [-16, -9]
+  auto first = vcgtq_s8(bytes, vdupq_n_s8(-65));
+  auto four_byte = vandq_u8(vcgtq_s8(bytes, vdupq_n_s8(-17)), vcltq_s8(bytes, vdupq_n_s8(-8)));
+  auto ones = vdupq_n_u8(1);
+  return vaddvq_u8(vandq_u8(first, ones)) + vaddvq_u8(vandq_u8(four_byte, ones));
+#elif TD_SSE2
+  auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+  auto first = _mm_cmpgt_epi8(bytes, _mm_set1_epi8(-65));
+  auto four_byte = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(-17)), _mm_cmplt_epi8(bytes, _mm_set1_epi8(-8)));
+  return count_bits32(static_cast<uint32>(_mm_movemask_epi8(first))) +
+         count_bits32(static_cast<uint32>(_mm_movemask_epi8(four_byte)));
+#else
+  size_t result = 0;
+  for (size_t i = 0; i < UTF8_BLOCK_SIZE; i++) {
+    auto c = static_cast<unsigned char>(data[i]);
+    result += is_utf8_character_first_code_unit(c) + ((c & 0xf8) == 0xf0);
+  }
+  return result;
+#endif
+}
+
 bool check_utf8(CSlice str) {
   const char *data = str.data();
   const char *data_end = data + str.size();
@@ -21,6 +76,10 @@ bool check_utf8(CSlice str) {
       if (data == data_end + 1) {
         return true;
       }
+      // ASCII characters are likely to be followed by other ASCII characters
+      while (static_cast<size_t>(data_end - data) >= UTF8_BLOCK_SIZE && is_ascii_block(data)) {
+        data += UTF8_BLOCK_SIZE;
+      }
       continue;
     }
 
@@ -113,15 +172,19 @@ string utf8_to_lower(Slice str) {
   return result;
 }
 
-vector<string> utf8_get_search_words(Slice str) {
+// calls on_character(code) for each character of search words and on_word_end() after each word
+template <class OnCharacterT, class OnWordEndT>
+static void parse_search_words(Slice str, OnCharacterT &&on_character, OnWordEndT &&on_word_end) {
   bool in_word = false;
-  string word;
-  vector<string> words;
   auto pos = str.ubegin();
   auto end = str.uend();
   while (pos != end) {
-    uint32 code;
-    pos = next_utf8_unsafe(pos, &code);
+    uint32 code = *pos;
+    if (code < 0x80) {
+      pos++;
+    } else {
+      pos = next_utf8_unsafe(pos, &code);
+    }
 
     code = prepare_search_character(code);
     if (code == 0) {
@@ -129,24 +192,49 @@ vector<string> utf8_get_search_words(Slice str) {
     }
     if (code == ' ') {
       if (in_word) {
-        words.push_back(std::move(word));
-        word.clear();
+        on_word_end();
         in_word = false;
       }
     } else {
       in_word = true;
-      code = remove_diacritics(code);
-      append_utf8_character(word, code);
+      if (code >= 0x80) {  // ASCII characters have no diacritics
+        code = remove_diacritics(code);
+      }
+      on_character(code);
     }
   }
   if (in_word) {
-    words.push_back(std::move(word));
+    on_word_end();
   }
+}
+
+vector<string> utf8_get_search_words(Slice str) {
+  string word;
+  vector<string> words;
+  parse_search_words(
+      str, [&](uint32 code) { append_utf8_character(word, code); },
+      [&] {
+        words.push_back(std::move(word));
+        word.clear();
+      });
   return words;
 }
 
 string utf8_prepare_search_string(Slice str) {
-  return implode(utf8_get_search_words(str));
+  string result;
+  result.reserve(str.size());
+  bool need_space = false;
+  parse_search_words(
+      str,
+      [&](uint32 code) {
+        if (need_space) {
+          result += ' ';
+          need_space = false;
+        }
+        append_utf8_character(result, code);
+      },
+      [&] { need_space = true; });
+  return result;
 }
 
 string utf8_encode(CSlice data) {
@@ -158,6 +246,10 @@ string utf8_encode(CSlice data) {
 
 size_t utf8_utf16_length(Slice str) {
   size_t result = 0;
+  while (str.size() >= UTF8_BLOCK_SIZE) {
+    result += get_block_utf16_length(str.data());
+    str.remove_prefix(UTF8_BLOCK_SIZE);
+  }
   for (auto c : str) {
     result += is_utf8_character_first_code_unit(c) + ((c & 0xf8) == 0xf0);
   }
@@ -90,6 +90,54 @@ TEST(ChainScheduler, Basic) {
   }
 }
 
+TEST(ChainScheduler, Limits) {
+  td::ChainScheduler<int> scheduler;
+  scheduler.set_max_active_tasks_per_chain(2);
+  scheduler.set_max_active_tasks(3);
+  td::vector<td::ChainScheduler<int>::TaskId> task_ids;
+  for (int i = 0; i < 4; i++) {
+    task_ids.push_back(scheduler.create_task({td::ChainScheduler<int>::ChainId{1}}, i));
+  }
+  for (int i = 0; i < 4; i++) {
+    task_ids.push_back(scheduler.create_task({td::ChainScheduler<int>::ChainId{static_cast<td::uint64>(i) + 2}}, i));
+  }
+  ASSERT_EQ(8u, scheduler.get_task_count());
+  ASSERT_EQ(5u, scheduler.get_chain_count());
+
+  auto start_tasks = [&] {
+    td::vector<td::ChainScheduler<int>::TaskId> result;
+    while (true) {
+      auto o_task = scheduler.start_next_task();
+      if (!o_task) {
+        break;
+      }
+      result.push_back(o_task.unwrap().task_id);
+    }
+    return result;
+  };
+  ASSERT_EQ(td::vector<td::ChainScheduler<int>::TaskId>({task_ids[0], task_ids[1], task_ids[4]}), start_tasks());
+  ASSERT_EQ(3u, scheduler.get_active_task_count());
+
+  scheduler.finish_task(task_ids[4]);
+  ASSERT_EQ(td::vector<td::ChainScheduler<int>::TaskId>({task_ids[5]}), start_tasks());
+
+  scheduler.finish_task(task_ids[0]);
+  ASSERT_EQ(td::vector<td::ChainScheduler<int>::TaskId>({task_ids[2]}), start_tasks());
+
+  scheduler.set_max_active_tasks(0);
+  ASSERT_EQ(td::vector<td::ChainScheduler<int>::TaskId>({task_ids[6], task_ids[7]}), start_tasks());
+  ASSERT_EQ(5u, scheduler.get_active_task_count());
+
+  for (auto task_id : task_ids) {
+    if (scheduler.get_task_extra(task_id) != nullptr) {
+      scheduler.finish_task(task_id);
+    }
+  }
+  ASSERT_EQ(0u, scheduler.get_task_count());
+  ASSERT_EQ(0u, scheduler.get_active_task_count());
+  ASSERT_EQ(0u, scheduler.get_chain_count());
+}
+
 struct ChainSchedulerQuery;
 using QueryPtr = std::shared_ptr<ChainSchedulerQuery>;
 using ChainId = td::ChainScheduler<QueryPtr>::ChainId;
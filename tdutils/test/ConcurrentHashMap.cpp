@@ -15,6 +15,7 @@
 #include "td/utils/tests.h"
 
 #include <atomic>
+#include <thread>
 
 #if !TD_THREAD_UNSUPPORTED
 
@@ -247,4 +248,53 @@ TEST(ConcurrentHashMap, Benchmark) {
 #endif
 }
 
+template <class ThreadT>
+static void test_concurrent_hash_map_multi_thread() {
+  td::ConcurrentHashMap<td::uint64, td::uint64> hash_map(1);
+  constexpr std::size_t threads_n = 8;
+  constexpr td::uint64 keys_n = 20000;
+  auto get_key = [](td::uint64 i) {
+    return td::Hash<td::uint64>()(i) * static_cast<td::uint64>(1000003) + i + 1;
+  };
+
+  std::atomic<std::size_t> finished_thread_count{0};
+  td::vector<ThreadT> threads;
+  for (std::size_t thread_id = 0; thread_id < threads_n; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      for (td::uint64 i = thread_id; i < keys_n; i += threads_n / 2) {
+        auto key = get_key(i);
+        ASSERT_EQ(i + 2, hash_map.insert(key, i + 2));
+        ASSERT_EQ(i + 2, hash_map.find(key, 0));
+      }
+      finished_thread_count++;
+    });
+  }
+  while (finished_thread_count.load() != threads_n) {
+    hash_map.for_each([&](td::uint64 key, td::uint64 value) { ASSERT_EQ(key, get_key(value - 2)); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  td::uint64 count = 0;
+  hash_map.for_each([&](td::uint64 key, td::uint64 value) {
+    ASSERT_EQ(key, get_key(value - 2));
+    count++;
+  });
+  ASSERT_EQ(keys_n, count);
+  for (td::uint64 i = 0; i < keys_n; i++) {
+    ASSERT_EQ(i + 2, hash_map.find(get_key(i), 0));
+  }
+  ASSERT_EQ(0u, hash_map.find(get_key(keys_n), 0));
+}
+
+TEST(ConcurrentHashMap, multi_thread) {
+  test_concurrent_hash_map_multi_thread<td::thread>();
+}
+
+TEST(ConcurrentHashMap, multi_thread_without_thread_id) {
+  // threads, which weren't created by td::thread, have the same get_thread_id()
+  test_concurrent_hash_map_multi_thread<std::thread>();
+}
+
 #endif
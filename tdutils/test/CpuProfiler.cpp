@@ -0,0 +1,61 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/tests.h"
+
+#include "td/utils/common.h"
+#include "td/utils/CpuProfiler.h"
+#include "td/utils/logging.h"
+#include "td/utils/Time.h"
+
+TEST(CpuProfiler, labels) {
+  ASSERT_TRUE(td::CpuProfiler::label_kind_ == nullptr);
+  {
+    td::CpuProfiler::Label outer("outer", 1);
+    {
+      td::CpuProfiler::Label inner("inner", 2);
+      ASSERT_STREQ("inner", td::CpuProfiler::label_kind_);
+      ASSERT_EQ(2, td::CpuProfiler::label_id_);
+    }
+    ASSERT_STREQ("outer", td::CpuProfiler::label_kind_);
+    ASSERT_EQ(1, td::CpuProfiler::label_id_);
+  }
+  ASSERT_TRUE(td::CpuProfiler::label_kind_ == nullptr);
+}
+
+TEST(CpuProfiler, sampling) {
+  if (!td::CpuProfiler::is_supported()) {
+    ASSERT_TRUE(td::CpuProfiler::set_frequency(100).is_error());
+    return;
+  }
+  ASSERT_TRUE(td::CpuProfiler::set_frequency(-1).is_error());
+  td::CpuProfiler::set_frequency(1000).ensure();
+  ASSERT_EQ(1000, td::CpuProfiler::get_frequency());
+
+  auto old_tag2 = LOG_TAG2;
+  LOG_TAG2 = "TestActor";
+  td::uint64 value = 0;
+  {
+    td::CpuProfiler::Label label("test", 0x12345678);
+    auto end_time = td::Time::now() + 0.3;
+    while (td::Time::now() < end_time) {
+      for (int i = 0; i < 10000; i++) {
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+      }
+    }
+  }
+  LOG_TAG2 = old_tag2;
+  td::CpuProfiler::set_frequency(0).ensure();
+  ASSERT_EQ(0, td::CpuProfiler::get_frequency());
+  ASSERT_TRUE(value != 1);
+
+  auto statistics = td::CpuProfiler::get_statistics();
+  ASSERT_TRUE(!statistics.empty());
+  ASSERT_EQ("TestActor", statistics[0].actor_name);
+  ASSERT_EQ("test", statistics[0].label_kind);
+  ASSERT_EQ(0x12345678, statistics[0].label_id);
+  ASSERT_TRUE(statistics[0].sample_count > 10);
+}
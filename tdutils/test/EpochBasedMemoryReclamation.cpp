@@ -4,6 +4,7 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "td/utils/algorithm.h"
 #include "td/utils/common.h"
 #include "td/utils/EpochBasedMemoryReclamation.h"
 #include "td/utils/logging.h"
@@ -12,6 +13,7 @@
 #include "td/utils/tests.h"
 
 #include <atomic>
+#include <thread>
 
 #if !TD_THREAD_UNSUPPORTED
 TEST(EpochBaseMemoryReclamation, stress) {
@@ -65,4 +67,38 @@ TEST(EpochBaseMemoryReclamation, stress) {
   }
   CHECK(ebmr.to_delete_size_unsafe() == 0);
 }
+
+TEST(EpochBaseMemoryReclamation, thread_slots) {
+  auto main_thread_slot = td::detail::get_reclamation_thread_slot();
+  constexpr std::size_t threads_n = 8;
+  std::vector<std::size_t> slots(threads_n);
+  std::atomic<std::size_t> registered_thread_count{0};
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < threads_n; i++) {
+    threads.emplace_back([&, i] {
+      slots[i] = td::detail::get_reclamation_thread_slot();
+      CHECK(slots[i] == td::detail::get_reclamation_thread_slot());
+      registered_thread_count++;
+      while (registered_thread_count.load() != threads_n) {
+        std::this_thread::yield();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (std::size_t i = 0; i < threads_n; i++) {
+    CHECK(slots[i] < static_cast<std::size_t>(TD_MAX_THREAD_COUNT));
+    CHECK(slots[i] != main_thread_slot);
+    for (std::size_t j = 0; j < i; j++) {
+      CHECK(slots[i] != slots[j]);
+    }
+  }
+
+  // slots of finished threads are reused
+  std::size_t new_slot = 0;
+  std::thread([&] { new_slot = td::detail::get_reclamation_thread_slot(); }).join();
+  CHECK(td::contains(slots, new_slot));
+}
 #endif
@@ -252,11 +252,13 @@ TEST(FlatHashMap, remove_if_basic) {
 }
 
 static constexpr size_t MAX_TABLE_SIZE = 1000;
-TEST(FlatHashMap, stress_test) {
+
+template <class TableT>
+static void test_hash_map_stress(size_t step_count) {
   td::Random::Xorshift128plus rnd(123);
   size_t max_table_size = MAX_TABLE_SIZE;  // dynamic value
   std::unordered_map<td::uint64, td::uint64, td::Hash<td::uint64>> ref;
-  td::FlatHashMap<td::uint64, td::uint64> tbl;
+  TableT tbl;
 
   auto validate = [&] {
     ASSERT_EQ(ref.empty(), tbl.empty());
@@ -364,11 +366,19 @@ TEST(FlatHashMap, stress_test) {
   });
 
   td::RandomSteps runner(std::move(steps));
-  for (size_t i = 0; i < 1000000; i++) {
+  for (size_t i = 0; i < step_count; i++) {
     runner.step(rnd);
   }
 }
 
+TEST(FlatHashMap, stress_test) {
+  test_hash_map_stress<td::FlatHashMap<td::uint64, td::uint64>>(1000000);
+}
+
+TEST(FlatHashMapChunks, stress_test) {
+  test_hash_map_stress<td::FlatHashMapChunks<td::uint64, td::uint64>>(1000000);
+}
+
 TEST(FlatHashSet, stress_test) {
   td::vector<td::RandomSteps::Step> steps;
   auto add_step = [&steps](td::Slice, td::uint32 weight, auto f) {
@@ -0,0 +1,99 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/tests.h"
+
+#include "td/utils/common.h"
+#include "td/utils/HeapProfiler.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/thread.h"
+
+#include <cstdint>
+
+static void *get_fake_pointer(std::uintptr_t id) {
+  return reinterpret_cast<void *>(0x10000 + id * 16);
+}
+
+TEST(HeapProfiler, attribution) {
+  td::HeapProfiler::on_allocation(nullptr, 0);
+  ASSERT_TRUE(td::HeapProfiler::is_supported());
+  td::HeapProfiler::set_sampling_interval(1).ensure();
+  ASSERT_EQ(1u, td::HeapProfiler::get_sampling_interval());
+
+  for (std::uintptr_t i = 0; i < 100; i++) {
+    td::HeapProfiler::on_allocation(get_fake_pointer(i), 1000);
+  }
+  auto old_tag2 = LOG_TAG2;
+  LOG_TAG2 = "TestActor";
+  for (std::uintptr_t i = 100; i < 110; i++) {
+    td::HeapProfiler::on_allocation(get_fake_pointer(i), 500);
+  }
+  LOG_TAG2 = old_tag2;
+
+  auto statistics = td::HeapProfiler::get_statistics();
+  ASSERT_EQ(2u, statistics.size());
+  ASSERT_EQ("", statistics[0].name);
+  ASSERT_EQ(100000u, statistics[0].size);
+  ASSERT_EQ(100u, statistics[0].allocation_count);
+  ASSERT_EQ("TestActor", statistics[1].name);
+  ASSERT_EQ(5000u, statistics[1].size);
+  ASSERT_EQ(10u, statistics[1].allocation_count);
+
+  for (std::uintptr_t i = 0; i < 100; i++) {
+    td::HeapProfiler::on_deallocation(get_fake_pointer(i));
+  }
+  statistics = td::HeapProfiler::get_statistics();
+  ASSERT_EQ(1u, statistics.size());
+  ASSERT_EQ("TestActor", statistics[0].name);
+
+  auto profile = td::HeapProfiler::get_pprof_profile();
+  ASSERT_TRUE(td::begins_with(profile, "heap profile: 10: 5000 [10: 5000] @ heap_v2/1\n"));
+
+  td::HeapProfiler::set_sampling_interval(0).ensure();
+  ASSERT_TRUE(td::HeapProfiler::get_statistics().empty());
+  td::HeapProfiler::on_allocation(get_fake_pointer(0), 1000);
+  ASSERT_TRUE(td::HeapProfiler::get_statistics().empty());
+}
+
+TEST(HeapProfiler, estimation) {
+  td::HeapProfiler::on_allocation(nullptr, 0);
+  td::HeapProfiler::set_sampling_interval(4096).ensure();
+
+  const std::uintptr_t ALLOCATION_COUNT = 200000;
+  for (std::uintptr_t i = 0; i < ALLOCATION_COUNT; i++) {
+    td::HeapProfiler::on_allocation(get_fake_pointer(i), i % 2 == 0 ? 100 : 1000);
+  }
+  auto expected_size = static_cast<double>(ALLOCATION_COUNT / 2 * 1100);
+  auto statistics = td::HeapProfiler::get_statistics();
+  ASSERT_EQ(1u, statistics.size());
+  ASSERT_TRUE(static_cast<double>(statistics[0].size) > expected_size * 0.9);
+  ASSERT_TRUE(static_cast<double>(statistics[0].size) < expected_size * 1.1);
+  ASSERT_TRUE(static_cast<double>(statistics[0].allocation_count) > static_cast<double>(ALLOCATION_COUNT) * 0.8);
+  ASSERT_TRUE(static_cast<double>(statistics[0].allocation_count) < static_cast<double>(ALLOCATION_COUNT) * 1.2);
+
+  td::HeapProfiler::set_sampling_interval(0).ensure();
+}
+
+TEST(HeapProfiler, first_allocation) {
+  td::HeapProfiler::on_allocation(nullptr, 0);
+  td::HeapProfiler::set_sampling_interval(static_cast<size_t>(1) << 30).ensure();
+
+  // the first allocations of a thread must not be sampled more often than any other allocations
+#if !TD_THREAD_UNSUPPORTED
+  td::vector<td::thread> threads;
+  for (std::uintptr_t i = 0; i < 10; i++) {
+    threads.emplace_back([i] { td::HeapProfiler::on_allocation(get_fake_pointer(i), 1); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+#endif
+  td::HeapProfiler::on_allocation(get_fake_pointer(100), 1);
+  ASSERT_TRUE(td::HeapProfiler::get_statistics().empty());
+
+  td::HeapProfiler::set_sampling_interval(0).ensure();
+}
@@ -0,0 +1,71 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/LockStatistics.h"
+#include "td/utils/port/Mutex.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/SpinLock.h"
+#include "td/utils/tests.h"
+
+#include <algorithm>
+
+static const td::LockStatistics::Entry *find_lock_statistics(const td::vector<td::LockStatistics::Entry> &statistics,
+                                                             const td::string &name) {
+  auto it = std::find_if(statistics.begin(), statistics.end(),
+                         [&name](const td::LockStatistics::Entry &entry) { return entry.name == name; });
+  return it == statistics.end() ? nullptr : &*it;
+}
+
+TEST(LockStatistics, aggregation) {
+  static td::LockStatistics first_statistics("TestLock");
+  static td::LockStatistics second_statistics("TestLock");
+  first_statistics.on_lock();
+  first_statistics.on_lock();
+  first_statistics.on_contention(10, 0.5);
+  second_statistics.on_lock();
+  second_statistics.on_contention(5, 0.25);
+
+  auto statistics = td::LockStatistics::get_statistics();
+  auto entry = find_lock_statistics(statistics, "TestLock");
+  ASSERT_TRUE(entry != nullptr);
+  ASSERT_EQ(3u, entry->lock_count);
+  ASSERT_EQ(2u, entry->contention_count);
+  ASSERT_EQ(15u, entry->spin_count);
+  ASSERT_TRUE(entry->wait_time > 0.74 && entry->wait_time < 0.76);
+}
+
+#if !TD_THREAD_UNSUPPORTED
+TEST(LockStatistics, locks) {
+  td::SpinLock spin_lock;
+  td::Mutex mutex;
+  static td::LockStatistics mutex_statistics("TestMutex");
+  int value = 0;
+  td::vector<td::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 10000; j++) {
+        {
+          auto guard = spin_lock.lock();
+          value++;
+        }
+        auto guard = mutex.lock(mutex_statistics);
+        value++;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(80000, value);
+
+  auto statistics = td::LockStatistics::get_statistics();
+  auto entry = find_lock_statistics(statistics, "TestMutex");
+  ASSERT_TRUE(entry != nullptr);
+  ASSERT_EQ(td::LockStatistics::is_enabled() ? 40000u : 0u, entry->lock_count);
+  ASSERT_EQ(td::LockStatistics::is_enabled(), find_lock_statistics(statistics, "SpinLock") != nullptr);
+}
+#endif
@@ -7,10 +7,12 @@
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
 #include "td/utils/MpmcQueue.h"
+#include "td/utils/port/sleep.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/tests.h"
 
 #include <algorithm>
+#include <atomic>
 #include <tuple>
 
 TEST(OneValue, simple) {
@@ -128,6 +130,38 @@ TEST(MpmcQueue, simple) {
   }
 }
 
+TEST(MpmcQueue, bulk) {
+  td::MpmcQueue<int> q(2, 1);
+  int next_value = 0;
+  int expected_value = 0;
+  td::vector<int> values;
+  for (int t = 0; t < 300; t++) {
+    for (int i = 0; i <= t % 17; i++) {
+      values.push_back(next_value++);
+    }
+    q.push_bulk(values, 0);
+    CHECK(values.empty());
+    if (t % 3 == 0) {
+      q.push(next_value++, 0);
+    }
+    if (t % 5 == 0) {
+      td::vector<int> popped_values;
+      while (q.try_pop_bulk(popped_values, 13, 0) != 0) {
+      }
+      for (auto x : popped_values) {
+        LOG_CHECK(x == expected_value) << x << " expected " << expected_value;
+        expected_value++;
+      }
+    }
+  }
+  int x;
+  while (q.try_pop(x, 0)) {
+    LOG_CHECK(x == expected_value) << x << " expected " << expected_value;
+    expected_value++;
+  }
+  CHECK(expected_value == next_value);
+}
+
 #if !TD_THREAD_UNSUPPORTED
 TEST(MpmcQueue, multi_thread) {
   size_t n = 10;
@@ -204,4 +238,78 @@ TEST(MpmcQueue, multi_thread) {
   }
   LOG_CHECK(q.hazard_pointers_to_delele_size_unsafe() == 0) << q.hazard_pointers_to_delele_size_unsafe();
 }
+
+TEST(MpmcQueue, multi_thread_bulk) {
+  size_t n = 10;
+  size_t m = 10;
+  struct Data {
+    size_t from{0};
+    size_t value{0};
+  };
+  struct ThreadData {
+    std::vector<Data> v;
+    char pad[64];
+  };
+  td::MpmcQueue<Data> q(1024, n + m);
+  std::vector<td::thread> n_threads(n);
+  std::vector<td::thread> m_threads(m);
+  std::vector<ThreadData> thread_data(m);
+  size_t qn = 100000;
+  std::atomic<size_t> popped_count{0};
+  size_t thread_id = 0;
+  for (auto &thread : m_threads) {
+    thread = td::thread([&, thread_id] {
+      while (popped_count.load() != n * qn) {
+        auto count = q.try_pop_bulk(thread_data[thread_id].v, 1 + thread_id, thread_id);
+        if (count == 0) {
+          td::usleep_for(1);
+        } else {
+          popped_count += count;
+        }
+      }
+    });
+    thread_id++;
+  }
+  for (auto &thread : n_threads) {
+    thread = td::thread([&, thread_id] {
+      std::vector<Data> values;
+      for (size_t i = 0; i < qn; i++) {
+        Data data;
+        data.from = thread_id - m;
+        data.value = i + 1;
+        values.push_back(data);
+        if (values.size() == thread_id - m + 1 || i + 1 == qn) {
+          q.push_bulk(values, thread_id);
+        }
+      }
+    });
+    thread_id++;
+  }
+  for (auto &thread : n_threads) {
+    thread.join();
+  }
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+  std::vector<Data> all;
+  for (size_t i = 0; i < m; i++) {
+    std::vector<size_t> from(n, 0);
+    for (auto &data : thread_data[i].v) {
+      all.push_back(data);
+      CHECK(data.value > from[data.from]);
+      from[data.from] = data.value;
+    }
+  }
+  LOG_CHECK(all.size() == n * qn) << all.size();
+  std::sort(all.begin(), all.end(),
+            [](const auto &a, const auto &b) { return std::tie(a.from, a.value) < std::tie(b.from, b.value); });
+  for (size_t i = 0; i < n * qn; i++) {
+    CHECK(all[i].from == i / qn);
+    CHECK(all[i].value == i % qn + 1);
+  }
+  for (size_t id = 0; id < n + m; id++) {
+    q.gc(id);
+  }
+  LOG_CHECK(q.hazard_pointers_to_delele_size_unsafe() == 0) << q.hazard_pointers_to_delele_size_unsafe();
+}
 #endif
@@ -0,0 +1,87 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/OrderedSet.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <set>
+
+TEST(OrderedSet, random) {
+  td::Random::Xorshift128plus rnd(123);
+  for (int max_key : {10, 1000, 100000}) {
+    td::OrderedSet<int> set;
+    std::set<int> reference;
+    for (int i = 0; i < 200000; i++) {
+      auto key = rnd.fast(0, max_key);
+      switch (rnd.fast(0, 3)) {
+        case 0:
+        case 1:
+          ASSERT_EQ(reference.insert(key).second, set.insert(key));
+          break;
+        case 2:
+          ASSERT_EQ(reference.erase(key), set.erase(key));
+          break;
+        case 3: {
+          auto it = set.upper_bound(key);
+          auto reference_it = reference.upper_bound(key);
+          ASSERT_EQ(reference_it == reference.end(), it == set.end());
+          if (it != set.end()) {
+            ASSERT_EQ(*reference_it, *it);
+          }
+          ASSERT_EQ(reference.count(key), set.count(key));
+          break;
+        }
+      }
+      ASSERT_EQ(reference.size(), set.size());
+    }
+
+    td::vector<int> keys(set.begin(), set.end());
+    ASSERT_EQ(td::vector<int>(reference.begin(), reference.end()), keys);
+  }
+}
+
+namespace {
+class KeyWithoutDefaultConstructor {
+ public:
+  explicit KeyWithoutDefaultConstructor(int value) : value_(value) {
+  }
+
+  int get() const {
+    return value_;
+  }
+
+  bool operator<(const KeyWithoutDefaultConstructor &other) const {
+    return value_ < other.value_;
+  }
+
+ private:
+  int value_;
+};
+}  // namespace
+
+TEST(OrderedSet, no_default_constructor) {
+  td::OrderedSet<KeyWithoutDefaultConstructor> set;
+  const int KEY_COUNT = 2000;  // enough to split chunks many times
+  for (int i = KEY_COUNT - 1; i >= 0; i--) {
+    ASSERT_TRUE(set.insert(KeyWithoutDefaultConstructor(i * 2)));
+  }
+  ASSERT_TRUE(!set.insert(KeyWithoutDefaultConstructor(10)));
+  ASSERT_EQ(static_cast<td::size_t>(KEY_COUNT), set.size());
+
+  int expected = 0;
+  for (auto &key : set) {
+    ASSERT_EQ(expected, key.get());
+    expected += 2;
+  }
+  ASSERT_EQ(10, set.upper_bound(KeyWithoutDefaultConstructor(9))->get());
+  for (int i = 0; i < KEY_COUNT; i += 2) {
+    ASSERT_EQ(static_cast<td::size_t>(1), set.erase(KeyWithoutDefaultConstructor(i * 2)));
+  }
+  ASSERT_EQ(static_cast<td::size_t>(KEY_COUNT / 2), set.size());
+  ASSERT_EQ(2, set.begin()->get());
+}
@@ -0,0 +1,138 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/as.h"
+#include "td/utils/common.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/sleep.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Random.h"
+#include "td/utils/SharedMemoryQueue.h"
+#include "td/utils/tests.h"
+
+char disable_linker_warning_about_empty_file_tdutils_test_shared_memory_queue_cpp TD_UNUSED;
+
+#if !TD_WINDOWS
+TEST(SharedMemoryQueue, simple) {
+  td::string path = "shared_memory_queue.test";
+  td::unlink(path).ignore();
+  ASSERT_TRUE(td::SharedMemoryQueue::create(path, 1000).is_error());
+  ASSERT_TRUE(td::SharedMemoryQueue::open(path).is_error());
+
+  auto producer = td::SharedMemoryQueue::create(path, td::SharedMemoryQueue::MIN_CAPACITY).move_as_ok();
+  auto consumer = td::SharedMemoryQueue::open(path).move_as_ok();
+  ASSERT_EQ(td::SharedMemoryQueue::MIN_CAPACITY, consumer.capacity());
+
+  td::string message;
+  ASSERT_TRUE(!consumer.try_pop(message));
+  ASSERT_TRUE(producer.try_push("a"));
+  ASSERT_TRUE(producer.try_push(""));
+  ASSERT_TRUE(producer.try_push("bcd"));
+  ASSERT_TRUE(consumer.try_pop(message));
+  ASSERT_EQ("a", message);
+  ASSERT_TRUE(consumer.try_pop(message));
+  ASSERT_EQ("", message);
+  ASSERT_TRUE(consumer.try_pop(message));
+  ASSERT_EQ("bcd", message);
+  ASSERT_TRUE(!consumer.try_pop(message));
+
+  td::string big(td::SharedMemoryQueue::MIN_CAPACITY / 2, 'x');
+  ASSERT_TRUE(producer.try_push(big));
+  ASSERT_TRUE(producer.try_push(""));
+  ASSERT_TRUE(consumer.try_pop(message));
+  ASSERT_EQ(big, message);
+  ASSERT_TRUE(consumer.try_pop(message));
+  ASSERT_EQ("", message);
+
+  // messages bigger than the queue are passed in parts
+  td::string huge(3 * td::SharedMemoryQueue::MIN_CAPACITY + 5, 'y');
+  huge[0] = 'a';
+  huge.back() = 'z';
+  ASSERT_TRUE(!producer.try_push(huge));
+  ASSERT_TRUE(!consumer.try_pop(message));
+  int push_count = 1;
+  while (!producer.try_push(huge)) {
+    ASSERT_TRUE(!consumer.try_pop(message));
+    push_count++;
+  }
+  ASSERT_EQ(5, push_count);
+  ASSERT_TRUE(producer.try_push("after"));
+  ASSERT_TRUE(consumer.try_pop(message));
+  ASSERT_EQ(huge, message);
+  ASSERT_TRUE(consumer.try_pop(message));
+  ASSERT_EQ("after", message);
+  ASSERT_TRUE(!consumer.try_pop(message));
+
+  td::unlink(path).ignore();
+}
+
+TEST(SharedMemoryQueue, corrupted) {
+  td::string path = "shared_memory_queue.test";
+  td::unlink(path).ignore();
+  constexpr auto capacity = td::SharedMemoryQueue::MIN_CAPACITY;
+  auto producer = td::SharedMemoryQueue::create(path, capacity).move_as_ok();
+  auto consumer = td::SharedMemoryQueue::open(path).move_as_ok();
+  ASSERT_TRUE(producer.try_push("abc"));
+
+  auto fd = td::FileFd::open(path, td::FileFd::Read | td::FileFd::Write).move_as_ok();
+  auto file_size = fd.get_size().move_as_ok();
+  auto header_size = file_size - static_cast<td::int64>(capacity);
+
+  // the size of the message is bigger than the queue content
+  char size_buf[sizeof(td::uint32)];
+  td::as<td::uint32>(size_buf) = 1000;
+  ASSERT_EQ(sizeof(size_buf), fd.pwrite(td::Slice(size_buf, sizeof(size_buf)), header_size).move_as_ok());
+  td::string message;
+  ASSERT_TRUE(!consumer.is_broken());
+  ASSERT_TRUE(!consumer.try_pop(message));
+  ASSERT_TRUE(consumer.is_broken());
+  ASSERT_TRUE(!producer.is_broken());
+
+  // the capacity isn't a power of 2, but matches the file size
+  char capacity_buf[sizeof(td::uint64)];
+  td::as<td::uint64>(capacity_buf) = 1000;
+  ASSERT_EQ(sizeof(capacity_buf), fd.pwrite(td::Slice(capacity_buf, sizeof(capacity_buf)), 8).move_as_ok());
+  fd.seek(header_size + 1000).ensure();
+  fd.truncate_to_current_position(header_size + 1000).ensure();
+  fd.close();
+  ASSERT_TRUE(td::SharedMemoryQueue::open(path).is_error());
+
+  td::unlink(path).ignore();
+}
+
+#if !TD_THREAD_UNSUPPORTED
+TEST(SharedMemoryQueue, threads) {
+  td::string path = "shared_memory_queue.test";
+  td::unlink(path).ignore();
+  auto producer = td::SharedMemoryQueue::create(path, td::SharedMemoryQueue::MIN_CAPACITY).move_as_ok();
+  auto consumer = td::SharedMemoryQueue::open(path).move_as_ok();
+
+  constexpr int MESSAGE_COUNT = 100000;
+  td::thread producer_thread([&] {
+    for (int i = 0; i < MESSAGE_COUNT; i++) {
+      auto message = td::to_string(i) + td::string(td::Random::fast(0, i % 100 == 0 ? 10000 : 100), 'a');
+      while (!producer.try_push(message)) {
+        td::usleep_for(1);
+      }
+    }
+  });
+
+  td::string message;
+  for (int i = 0; i < MESSAGE_COUNT; i++) {
+    while (!consumer.try_pop(message)) {
+      td::usleep_for(1);
+    }
+    auto prefix = td::to_string(i);
+    ASSERT_EQ(prefix, message.substr(0, prefix.size()));
+  }
+  producer_thread.join();
+  ASSERT_TRUE(!consumer.try_pop(message));
+
+  td::unlink(path).ignore();
+}
+#endif
+#endif
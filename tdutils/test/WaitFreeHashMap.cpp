@@ -93,3 +93,34 @@ TEST(WaitFreeHashMap, stress_test) {
     }
   }
 }
+
+TEST(WaitFreeHashMap, grow_and_shrink) {
+  td::WaitFreeHashMap<td::int64, td::unique_ptr<td::int64>> map;
+  for (int iteration = 0; iteration < 3; iteration++) {
+    const td::int64 key_count = 100000;
+    for (td::int64 key = 1; key <= key_count; key++) {
+      map.set(key, td::make_unique<td::int64>(key * 2));
+      ASSERT_EQ(static_cast<size_t>(key), map.calc_size());
+    }
+    for (td::int64 key = 1; key <= key_count; key++) {
+      auto *value = map.get_pointer(key);
+      ASSERT_TRUE(value != nullptr);
+      ASSERT_EQ(key * 2, *value);
+    }
+    td::int64 sum = 0;
+    map.foreach([&](const td::int64 &key, const td::unique_ptr<td::int64> &value) { sum += *value - key; });
+    ASSERT_EQ(key_count * (key_count + 1) / 2, sum);
+
+    for (td::int64 key = key_count; key >= 1; key--) {
+      ASSERT_EQ(1u, map.erase(key));
+      ASSERT_EQ(0u, map.erase(key));
+      ASSERT_EQ(static_cast<size_t>(key - 1), map.calc_size());
+      if (key % 1000 == 0) {
+        for (td::int64 other_key = 1; other_key < key; other_key += 97) {
+          ASSERT_TRUE(map.count(other_key) == 1);
+        }
+      }
+    }
+    ASSERT_TRUE(map.empty());
+  }
+}
@@ -54,3 +54,46 @@ TEST(Buffer, buffer_builder) {
     ASSERT_EQ(builder.extract().as_slice(), str);
   }
 }
+
+TEST(Buffer, short_living) {
+  auto start_mem = td::BufferAllocator::get_buffer_mem();
+  {
+    td::vector<td::BufferSlice> slices;
+    td::vector<td::string> strings;
+    for (int i = 0; i < 1000; i++) {
+      auto size = td::Random::fast(0, 10000);
+      auto str = td::rand_string('a', 'z', size);
+      auto slice = td::BufferSlice::create_short_living(str.size());
+      ASSERT_EQ(str.size(), slice.size());
+      slice.as_mutable_slice().copy_from(str);
+      slices.push_back(std::move(slice));
+      strings.push_back(std::move(str));
+    }
+    for (size_t i = 0; i < slices.size(); i++) {
+      ASSERT_EQ(strings[i], slices[i].as_slice());
+    }
+  }
+  auto extra_mem = td::BufferAllocator::get_buffer_mem() - start_mem;
+  ASSERT_TRUE(extra_mem < 200000);
+  ASSERT_TRUE(td::BufferAllocator::get_thread_buffer_mem() > 0);
+}
+
+TEST(Buffer, chain_buffer) {
+  td::ChainBufferWriter writer;
+  auto reader = writer.extract_reader();
+  td::string expected;
+  for (int i = 0; i < 1000; i++) {
+    auto str = td::rand_string('a', 'z', td::Random::fast(0, 1000));
+    writer.append(str);
+    expected += str;
+    if (td::Random::fast(0, 10) == 0) {
+      reader.sync_with_writer();
+      auto size = td::Random::fast(0, static_cast<int>(reader.size()));
+      auto prefix = reader.cut_head(size).move_as_buffer_slice();
+      ASSERT_EQ(expected.substr(0, size), prefix.as_slice());
+      expected = expected.substr(size);
+    }
+  }
+  reader.sync_with_writer();
+  ASSERT_EQ(expected, reader.move_as_buffer_slice().as_slice());
+}
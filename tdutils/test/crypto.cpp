@@ -8,6 +8,7 @@
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
+#include "td/utils/misc.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
@@ -15,6 +16,7 @@
 #include "td/utils/UInt.h"
 
 #include <limits>
+#include <utility>
 
 static td::vector<td::string> strings{"", "1", "short test string", td::string(1000000, 'a')};
 
@@ -293,6 +295,66 @@ TEST(Crypto, sha256) {
   }
 }
 
+TEST(Crypto, sha256_vectors) {
+  // FIPS 180-2 examples and messages ending around block boundaries
+  td::vector<std::pair<td::string, td::Slice>> vectors{
+      {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+      {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+      {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+       "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+      {"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+       "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+       "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"},
+      {td::string(55, 'a'), "9f4390f8d30c2dd92ec9f095b65e2b9ae9b0a925a5258e241c9f1e910f734318"},
+      {td::string(56, 'a'), "b35439a4ac6f0948b6d6f9e3c6af0f5f590ce20f1bde7090ef7970686ec6738a"},
+      {td::string(63, 'a'), "7d3e74a05d7db15bce4ad9ec0658ea98e3f06eeecf16b4c6fff2da457ddc2f34"},
+      {td::string(64, 'a'), "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb"},
+      {td::string(65, 'a'), "635361c48bb9eab14198e76ea8ab7f1a41685d6ad62aa9146d301d4f17eb0ae0"},
+      {td::string(119, 'a'), "31eba51c313a5c08226adf18d4a359cfdfd8d2e816b13f4af952f7ea6584dcfb"},
+      {td::string(120, 'a'), "2f3d335432c70b580af0e8e1b3674a7c020d683aa5f73aaaedfdc55af904c21c"},
+      {td::string(1000, 'a'), "41edece42d63e8d9bf515a9ba6932e1c20cbc9f5a5d134645adb5db1b9737ea3"},
+      {td::string(1000000, 'a'), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"}};
+
+  for (std::size_t i = 0; i < vectors.size(); i++) {
+    const auto &message = vectors[i].first;
+    const auto &answer = vectors[i].second;
+    td::string output(32, '\0');
+    td::sha256(message, output);
+    ASSERT_STREQ(answer, td::hex_encode(output));
+
+    td::Sha256State state;
+    state.init();
+    auto split_pos = message.size() / 3;
+    state.feed(td::Slice(message).substr(0, split_pos));
+    state.feed(td::Slice(message).substr(split_pos));
+    state.extract(output, true);
+    ASSERT_STREQ(answer, td::hex_encode(output));
+
+    for (std::size_t j = 0; j < vectors.size(); j++) {
+      td::string output1(32, '\0');
+      td::string output2(32, '\0');
+      td::sha256_pair(message, vectors[j].first, output1, output2);
+      ASSERT_STREQ(answer, td::hex_encode(output1));
+      ASSERT_STREQ(vectors[j].second, td::hex_encode(output2));
+    }
+  }
+}
+
+TEST(Crypto, sha256_pair) {
+  for (auto length : {0, 1, 52, 55, 56, 63, 64, 65, 119, 120, 1000}) {
+    for (auto length_diff : {0, 1, 7, 8, 9, 100}) {
+      auto s1 = td::rand_string(std::numeric_limits<char>::min(), std::numeric_limits<char>::max(), length);
+      auto s2 = td::rand_string(std::numeric_limits<char>::min(), std::numeric_limits<char>::max(),
+                                length + length_diff);
+      td::string output1(32, '\0');
+      td::string output2(32, '\0');
+      td::sha256_pair(s1, s2, output1, output2);
+      ASSERT_STREQ(td::sha256(s1), output1);
+      ASSERT_STREQ(td::sha256(s2), output2);
+    }
+  }
+}
+
 TEST(Crypto, md5) {
   td::vector<td::Slice> answers{
       "1B2M2Y8AsgTpgAmY7PhCfg==", "xMpCOKC5I4INzFCab3WEmw==", "vwBninYbDRkgk+uA7GMiIQ==", "dwfWrk4CfHDuoqk1wilvIQ=="};
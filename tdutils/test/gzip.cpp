@@ -14,6 +14,7 @@
 #include "td/utils/port/thread_local.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
+#include "td/utils/StringBuilder.h"
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
 
@@ -45,6 +46,79 @@ TEST(Gzip, gzencode) {
   }
 }
 
+TEST(Gzip, gzencode_reuse) {
+  auto compressible = td::rand_string('a', 'b', 10000);
+  auto incompressible = td::rand_string(0, 255, 10000);
+  auto first = td::gzencode(compressible, 0.9).as_slice().str();
+  ASSERT_TRUE(!first.empty());
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(td::gzencode(incompressible, 0.9).empty());
+    ASSERT_EQ(first, td::gzencode(compressible, 0.9).as_slice().str());
+    ASSERT_EQ(compressible, td::gzdecode(first));
+  }
+}
+
+TEST(Gzip, deflate_with_dictionary) {
+  td::string dictionary;
+  for (int i = 0; i < 100; i++) {
+    dictionary += "common message prefix " + td::to_string(i) + ";";
+  }
+  for (int i = 0; i < 100; i++) {
+    auto s = td::string("common message prefix ") + td::to_string(i % 10) + td::rand_string('a', 'z', i % 7);
+    auto with_dictionary = td::deflate_with_dictionary(s, dictionary, s.size() + 100);
+    auto without_dictionary = td::deflate_with_dictionary(s, td::Slice(), s.size() + 100);
+    ASSERT_TRUE(!with_dictionary.empty());
+    ASSERT_TRUE(!without_dictionary.empty());
+    ASSERT_TRUE(with_dictionary.size() < without_dictionary.size());
+    ASSERT_EQ(s, td::inflate_with_dictionary(with_dictionary.as_slice(), dictionary, s.size()).move_as_ok());
+    ASSERT_EQ(s, td::inflate_with_dictionary(without_dictionary.as_slice(), td::Slice(), s.size()).move_as_ok());
+    ASSERT_TRUE(td::inflate_with_dictionary(with_dictionary.as_slice(), td::Slice(), s.size()).is_error());
+    ASSERT_TRUE(td::inflate_with_dictionary(with_dictionary.as_slice(), dictionary, s.size() + 1).is_error());
+  }
+
+  auto incompressible = td::rand_string(0, 255, 1000);
+  ASSERT_TRUE(td::deflate_with_dictionary(incompressible, dictionary, 900).empty());
+}
+
+TEST(Gzip, reuse_streams) {
+  auto str = td::rand_string('a', 'z', 100000);
+  auto encoded = td::gzencode(str, 2).as_slice().str();
+  auto broken = encoded.substr(0, encoded.size() / 2) + td::rand_string(0, 255, 1000);
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(str, td::gzdecode(encoded).as_slice().str());
+    td::gzdecode(broken);
+    td::gzdecode(td::Slice());
+
+    td::Gzip first;
+    td::Gzip second;
+    ASSERT_TRUE(first.init_decode().is_ok());
+    ASSERT_TRUE(second.init_encode().is_ok());
+    first.set_input(broken);
+    first.close_input();
+    td::string output(1000, '\0');
+    first.set_output(output);
+    first.run().ignore();
+  }
+
+  for (int i = 0; i < 3; i++) {
+    td::ChainBufferWriter input_writer;
+    auto input = input_writer.extract_reader();
+    td::ByteFlowSource source(&input);
+    td::GzipByteFlow encode_flow(td::Gzip::Mode::Encode);
+    td::GzipByteFlow decode_flow(td::Gzip::Mode::Decode);
+    td::ByteFlowSink sink;
+    source >> encode_flow >> decode_flow >> sink;
+    for (auto &part : td::rand_split(str)) {
+      input_writer.append(part);
+      source.wakeup();
+    }
+    source.close_input(td::Status::OK());
+    ASSERT_TRUE(sink.is_ready());
+    ASSERT_TRUE(sink.status().is_ok());
+    ASSERT_EQ(str, sink.result()->move_as_buffer_slice().as_slice().str());
+  }
+}
+
 TEST(Gzip, flow) {
   auto str = td::rand_string('a', 'z', 1000000);
   auto parts = td::rand_split(str);
@@ -10,6 +10,7 @@
 #include "td/utils/Heap.h"
 #include "td/utils/Random.h"
 #include "td/utils/Span.h"
+#include "td/utils/TimerWheel.h"
 
 #include <cstdio>
 #include <set>
@@ -176,3 +177,61 @@ TEST(Heap, random_events) {
     // heap.check();
   }
 }
+
+TEST(Heap, timer_wheel_random_events) {
+  struct Node final : public td::HeapNode {
+    double key = 0.0;
+  };
+  int n = 1000;
+  td::vector<Node> nodes(n);
+  std::set<std::pair<double, int>> set_heap;
+  td::TimerWheel timer_wheel;
+
+  double now = 1e6;
+  auto random_key = [&] {
+    static const double ranges[] = {0.01, 1.0, 100.0, 1e5, 1e7};
+    return now + td::Random::fast(-1, 100) * ranges[td::Random::fast(0, 4)] / 100;
+  };
+  for (int i = 0; i < 300000; i++) {
+    int id = td::Random::fast(0, n - 1);
+    auto &node = nodes[id];
+    int x = td::Random::fast(0, 4);
+    if (x < 2) {
+      auto key = random_key();
+      if (node.in_heap()) {
+        set_heap.erase(std::make_pair(node.key, id));
+        timer_wheel.fix(key, &node);
+      } else {
+        timer_wheel.insert(key, &node);
+      }
+      node.key = key;
+      set_heap.emplace(key, id);
+    } else if (x < 3) {
+      if (node.in_heap()) {
+        timer_wheel.erase(&node);
+        set_heap.erase(std::make_pair(node.key, id));
+      }
+    } else if (!set_heap.empty()) {
+      ASSERT_EQ(set_heap.begin()->first, timer_wheel.top_key());
+      if (x < 4) {
+        auto popped_node = static_cast<Node *>(timer_wheel.pop());
+        ASSERT_TRUE(!popped_node->in_heap());
+        ASSERT_EQ(set_heap.begin()->first, popped_node->key);
+        set_heap.erase(std::make_pair(popped_node->key, static_cast<int>(popped_node - &nodes[0])));
+        now = td::max(now, popped_node->key);
+      }
+    }
+    ASSERT_EQ(set_heap.size(), timer_wheel.size());
+    if (node.in_heap()) {
+      ASSERT_EQ(node.key, timer_wheel.get_key(&node));
+    }
+    if (i % 1000 == 0) {
+      timer_wheel.check();
+    }
+  }
+  while (!timer_wheel.empty()) {
+    ASSERT_EQ(set_heap.begin()->first, static_cast<Node *>(timer_wheel.pop())->key);
+    set_heap.erase(set_heap.begin());
+  }
+  ASSERT_TRUE(set_heap.empty());
+}
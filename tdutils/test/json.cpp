@@ -9,7 +9,9 @@
 #include "td/utils/JsonBuilder.h"
 #include "td/utils/logging.h"
 #include "td/utils/Parser.h"
+#include "td/utils/Random.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tests.h"
 
@@ -249,6 +251,31 @@ TEST(JSON, bench_json_string_decode) {
   td::bench(JsonStringDecodeBenchmark(str));
 }
 
+TEST(JSON, string_encode) {
+  td::Random::Xorshift128plus rnd(123);
+  const td::string parts[] = {"a", "bcdefghijklmnopqrstuvwxyz", "\"", "\\", "\n", "\x01", "\x1f", "\x7f",
+                              "\xd1\x8f", "\xf0\x9f\xa6\x8a"};
+  for (int t = 0; t < 10000; t++) {
+    td::string str;
+    auto part_count = rnd.fast(0, 30);
+    for (int i = 0; i < part_count; i++) {
+      str += parts[rnd.fast(0, 9)];
+    }
+    for (auto is_raw : {false, true}) {
+      td::string encoded = is_raw ? PSTRING() << td::JsonRawString(str) : PSTRING() << td::JsonString(str);
+      for (auto c : encoded) {
+        ASSERT_TRUE(static_cast<unsigned char>(c) >= 0x20);
+        ASSERT_TRUE(is_raw || static_cast<unsigned char>(c) < 0x80);
+      }
+      td::Parser parser(encoded);
+      auto r_value = td::json_string_decode(parser);
+      ASSERT_TRUE(r_value.is_ok());
+      ASSERT_TRUE(parser.empty());
+      ASSERT_EQ(str, r_value.ok());
+    }
+  }
+}
+
 static void test_string_decode(td::string str, const td::string &result) {
   auto str_copy = str;
   td::Parser skip_parser(str_copy);
@@ -8,12 +8,16 @@
 #include "td/utils/benchmark.h"
 #include "td/utils/CombinedLog.h"
 #include "td/utils/FileLog.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/FlightRecorderLog.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/MemoryLog.h"
+#include "td/utils/misc.h"
 #include "td/utils/NullLog.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/thread.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/tests.h"
@@ -25,6 +29,50 @@
 
 char disable_linker_warning_about_empty_file_tdutils_test_log_cpp TD_UNUSED;
 
+namespace {
+class StringLog final : public td::LogInterface {
+ public:
+  void do_append(int log_level, td::CSlice slice) final {
+    result += slice.str();
+  }
+
+  td::string result;
+};
+}  // namespace
+
+TEST(Log, FlightRecorderLog) {
+  StringLog string_log;
+  td::FlightRecorderLog log(64);
+  log.set_log(&string_log);
+  log.set_log_verbosity_level(VERBOSITY_NAME(WARNING));
+  td::string header = PSTRING() << "!!! Recorded log of thread " << td::get_thread_id() << " !!!\n";
+  td::string footer = PSTRING() << "!!! End of recorded log of thread " << td::get_thread_id() << " !!!\n";
+
+  log.do_append(VERBOSITY_NAME(DEBUG), "debug\n");
+  log.do_append(VERBOSITY_NAME(WARNING), "warning\n");
+  log.do_append(VERBOSITY_NAME(INFO), "info\n");
+  ASSERT_EQ("warning\n", string_log.result);
+
+  log.do_append(VERBOSITY_NAME(ERROR), "error\n");
+  ASSERT_EQ("warning\n" + header + "debug\ninfo\n" + footer + "error\n", string_log.result);
+
+  string_log.result.clear();
+  log.dump();
+  ASSERT_EQ("", string_log.result);
+
+  for (int i = 0; i < 100; i++) {
+    log.do_append(VERBOSITY_NAME(DEBUG), PSLICE() << "line " << i << '\n');
+  }
+  log.dump();
+  ASSERT_EQ(header + "line 93\nline 94\nline 95\nline 96\nline 97\nline 98\nline 99\n" + footer, string_log.result);
+
+  string_log.result.clear();
+  log.do_append(VERBOSITY_NAME(DEBUG), "cleared\n");
+  log.clear();
+  log.dump();
+  ASSERT_EQ("", string_log.result);
+}
+
 #if !TD_THREAD_UNSUPPORTED
 template <class Log>
 class LogBenchmark final : public td::Benchmark {
@@ -123,6 +171,12 @@ TEST(Log, Bench) {
   bench_log("TsFileLog",
             [] { return td::TsFileLog::create("tmplog", std::numeric_limits<td::int64>::max(), false).move_as_ok(); });
 
+#if !TD_EVENTFD_UNSUPPORTED
+  bench_log("TsFileLog buffered", [] {
+    return td::TsFileLog::create("tmplog", std::numeric_limits<td::int64>::max(), false, 1 << 20).move_as_ok();
+  });
+#endif
+
   bench_log("FileLog + TsLog", [] {
     class FileLog final : public td::LogInterface {
      public:
@@ -184,4 +238,50 @@ TEST(Log, Bench) {
   });
 #endif
 }
+
+#if !TD_EVENTFD_UNSUPPORTED
+TEST(Log, TsFileLogBuffered) {
+  const int threads_n = 4;
+  const int lines_n = 10000;
+  td::Slice line = "This is a buffered log line";
+  auto log = td::TsFileLog::create("tmplog", std::numeric_limits<td::int64>::max(), false, 4096).move_as_ok();
+  auto file_paths = log->get_file_paths();
+
+  auto old_log_interface = td::log_interface;
+  td::log_interface = log.get();
+  td::vector<td::thread> threads;
+  for (int i = 0; i < threads_n; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < lines_n; j++) {
+        LOG(PLAIN) << line;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  td::log_interface = old_log_interface;
+  log.reset();
+
+  td::uint64 written_count = 0;
+  td::uint64 dropped_count = 0;
+  for (const auto &path : file_paths) {
+    auto r_content = td::read_file_str(path);
+    if (r_content.is_error()) {
+      continue;
+    }
+    for (auto str : td::full_split(td::Slice(r_content.ok()), '\n')) {
+      if (str == line) {
+        written_count++;
+      } else if (td::begins_with(str, "!!! ")) {
+        dropped_count += td::to_integer<td::uint64>(str.substr(4));
+      } else {
+        ASSERT_TRUE(str.empty());
+      }
+    }
+    td::unlink(path).ignore();
+  }
+  ASSERT_EQ(static_cast<td::uint64>(threads_n * lines_n), written_count + dropped_count);
+}
+#endif
 #endif
@@ -10,6 +10,7 @@
 #include "td/utils/benchmark.h"
 #include "td/utils/BigNum.h"
 #include "td/utils/bits.h"
+#include "td/utils/buffer.h"
 #include "td/utils/CancellationToken.h"
 #include "td/utils/common.h"
 #include "td/utils/ExitGuard.h"
@@ -19,6 +20,7 @@
 #include "td/utils/HashSet.h"
 #include "td/utils/HashTableUtils.h"
 #include "td/utils/invoke.h"
+#include "td/utils/LatencyHistogram.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/EventFd.h"
@@ -33,11 +35,13 @@
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/SmallObjectAllocator.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
+#include "td/utils/tl_parsers.h"
 #include "td/utils/translit.h"
 #include "td/utils/uint128.h"
 #include "td/utils/unicode.h"
@@ -46,6 +50,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <limits>
 #include <locale>
 #include <unordered_map>
@@ -263,6 +268,59 @@ TEST(Misc, base64) {
   ASSERT_TRUE(td::base64url_encode("ab><cd") == "YWI-PGNk");
 }
 
+static td::string base64_encode_slow(td::Slice input, bool is_url) {
+  const char *characters = is_url ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+                                  : "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  td::string result;
+  for (size_t i = 0; i < input.size(); i += 3) {
+    td::uint32 c = input.ubegin()[i] << 16;
+    if (i + 1 < input.size()) {
+      c |= input.ubegin()[i + 1] << 8;
+    }
+    if (i + 2 < input.size()) {
+      c |= input.ubegin()[i + 2];
+    }
+    auto length = td::min(input.size() - i, static_cast<size_t>(3)) + 1;
+    for (size_t j = 0; j < 4; j++) {
+      if (j < length) {
+        result += characters[(c >> (18 - 6 * j)) & 63];
+      } else if (!is_url) {
+        result += '=';
+      }
+    }
+  }
+  return result;
+}
+
+TEST(Misc, base64_long) {
+  for (int l = 0; l < 200; l++) {
+    auto s = td::rand_string(std::numeric_limits<char>::min(), std::numeric_limits<char>::max(), l);
+    ASSERT_EQ(base64_encode_slow(s, false), td::base64_encode(s));
+    ASSERT_EQ(base64_encode_slow(s, true), td::base64url_encode(s));
+  }
+
+  td::string all_characters = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  for (int t = 0; t < 3; t++) {
+    all_characters += all_characters;
+  }
+  auto decoded = td::base64_decode(all_characters);
+  ASSERT_TRUE(decoded.is_ok());
+  ASSERT_EQ(all_characters, td::base64_encode(decoded.ok()));
+
+  for (size_t i = 0; i < all_characters.size(); i++) {
+    for (auto c : {'=', '-', '_', '.', '@', '[', '`', '{', '\0', '\x80', '\xff'}) {
+      auto wrong_characters = all_characters;
+      wrong_characters[i] = c;
+      ASSERT_TRUE(td::base64_decode(wrong_characters).is_error());
+      if (c != '-' && c != '_') {
+        std::replace(wrong_characters.begin(), wrong_characters.end(), '+', '-');
+        std::replace(wrong_characters.begin(), wrong_characters.end(), '/', '_');
+        ASSERT_TRUE(td::base64url_decode(wrong_characters).is_error());
+      }
+    }
+  }
+}
+
 static void test_zero_encode(td::Slice str, td::Slice expected_zero = td::Slice(),
                              td::Slice expected_zero_one = td::Slice()) {
   auto encoded = td::zero_encode(str);
@@ -613,6 +671,12 @@ TEST(Misc, print_uint) {
   ASSERT_STREQ("2147483648", PSLICE() << 2147483648u);
   ASSERT_STREQ("2147483649", PSLICE() << 2147483649u);
   ASSERT_STREQ("9223372036854775807", PSLICE() << 9223372036854775807u);
+  ASSERT_STREQ("18446744073709551615", PSLICE() << 18446744073709551615u);
+  for (td::uint64 x = 1; x <= 1000000000000000000u; x *= 10) {
+    for (auto y : {x - 1, x, x + 1, x * 10 - 1}) {
+      ASSERT_STREQ(std::to_string(y), PSLICE() << y);
+    }
+  }
 }
 
 static void test_idn_to_ascii_one(const td::string &host, const td::string &result) {
@@ -689,6 +753,30 @@ TEST(Misc, to_wstring) {
 }
 #endif
 
+TEST(Misc, utf8) {
+  td::Random::Xorshift128plus rnd(123);
+  const td::uint32 codes[] = {'a',    ' ',    0x7F,   0x80,   0x44F,   0x7FF,   0x800,
+                              0x4E2D, 0xD7FF, 0xE000, 0xFFFF, 0x10000, 0x1F600, 0x10FFFF};
+  for (int t = 0; t < 10000; t++) {
+    td::string str;
+    size_t utf16_length = 0;
+    auto ascii_only = rnd.fast(0, 1) == 0;
+    auto length = rnd.fast(0, 100);
+    for (int i = 0; i < length; i++) {
+      auto code = ascii_only ? static_cast<td::uint32>(rnd.fast(0, 127)) : codes[rnd.fast(0, 13)];
+      td::append_utf8_character(str, code);
+      utf16_length += code >= 0x10000 ? 2 : 1;
+    }
+    ASSERT_TRUE(td::check_utf8(str));
+    ASSERT_EQ(utf16_length, td::utf8_utf16_length(str));
+    ASSERT_EQ(static_cast<size_t>(length), td::utf8_length(str));
+
+    auto pos = static_cast<size_t>(rnd.fast(0, static_cast<int>(str.size())));
+    str.insert(pos, 1, static_cast<char>(rnd.fast(0, 1) == 0 ? 0x80 : 0xFF));
+    ASSERT_TRUE(!td::check_utf8(str));
+  }
+}
+
 static void test_translit(const td::string &word, const td::vector<td::string> &result, bool allow_partial = true) {
   ASSERT_EQ(result, td::get_word_transliterations(word, allow_partial));
 }
@@ -714,6 +802,20 @@ TEST(Misc, translit) {
   test_translit("yo", {"e", "yo", "е", "ио"}, false);
 }
 
+TEST(Misc, search_words) {
+  ASSERT_EQ(td::vector<td::string>(), td::utf8_get_search_words(""));
+  ASSERT_EQ(td::vector<td::string>(), td::utf8_get_search_words(" \t,.!"));
+  ASSERT_EQ(td::vector<td::string>({"hello", "world", "123"}), td::utf8_get_search_words(" Hello,  WORLD!123"));
+  ASSERT_EQ(td::vector<td::string>({"creme", "brulee", "елка"}), td::utf8_get_search_words("Crème brûlée - Ёлка"));
+  ASSERT_EQ("hello world 123", td::utf8_prepare_search_string(" Hello,  WORLD!123 "));
+  ASSERT_EQ("creme brulee елка", td::utf8_prepare_search_string("Crème brûlée - Ёлка"));
+  ASSERT_EQ("", td::utf8_prepare_search_string("..."));
+
+  for (td::uint32 code = 0; code < 0x80; code++) {
+    ASSERT_EQ(code, td::remove_diacritics(code));
+  }
+}
+
 static void test_unicode(td::uint32 (*func)(td::uint32)) {
   for (td::uint32 i = 0; i <= 0x110000; i++) {
     auto res = func(i);
@@ -1345,10 +1447,52 @@ TEST(Misc, serialize) {
   ASSERT_EQ(td::base64_encode(td::serialize(y)), td::base64_encode(td::string("\xfe\xff\xff\xff\xff\xff\xff\xff", 8)));
 }
 
+TEST(Misc, TlBufferParser_fetch_string) {
+  auto test_fetch_string = [](td::string str, const td::string &expected) {
+    td::BufferSlice buffer(td::serialize(str));
+    td::TlBufferParser parser(&buffer);
+    ASSERT_EQ(expected, parser.fetch_string<td::string>());
+    parser.fetch_end();
+    ASSERT_TRUE(parser.get_error() == nullptr);
+  };
+  test_fetch_string("", "");
+  test_fetch_string("abacaba", "abacaba");
+  test_fetch_string(td::string(1000, 'a') + "\xd0\x9f", td::string(1000, 'a') + "\xd0\x9f");
+  test_fetch_string(td::string("a\0b\0", 4), "a b ");
+  test_fetch_string(td::string(300, '\0'), td::string(300, ' '));
+  test_fetch_string("abc\xd0", "abc");
+  test_fetch_string("\xff", "");
+}
+
 TEST(Misc, check_reset_guard) {
   CheckExitGuard check_exit_guard{false};
 }
 
+TEST(Misc, SmallObjectAllocator) {
+  td::Random::Xorshift128plus rnd(123);
+  td::vector<std::pair<char *, td::size_t>> blocks;
+  for (int i = 0; i < 100000; i++) {
+    if (blocks.empty() || rnd.fast(0, 2) != 0) {
+      auto size = static_cast<td::size_t>(rnd.fast(1, 2 * static_cast<int>(td::SmallObjectAllocator::MAX_SIZE)));
+      auto ptr = static_cast<char *>(td::SmallObjectAllocator::allocate(size));
+      std::fill(ptr, ptr + size, static_cast<char>(size));
+      blocks.emplace_back(ptr, size);
+    } else {
+      auto pos = static_cast<td::size_t>(rnd.fast(0, static_cast<int>(blocks.size()) - 1));
+      std::swap(blocks[pos], blocks.back());
+      auto block = blocks.back();
+      blocks.pop_back();
+      for (td::size_t j = 0; j < block.second; j++) {
+        ASSERT_EQ(static_cast<char>(block.second), block.first[j]);
+      }
+      td::SmallObjectAllocator::deallocate(block.first, block.second);
+    }
+  }
+  for (auto &block : blocks) {
+    td::SmallObjectAllocator::deallocate(block.first, block.second);
+  }
+}
+
 TEST(FloodControl, Fast) {
   td::FloodControlFast fc;
   fc.add_limit(1, 5);
@@ -1391,3 +1535,29 @@ TEST(UniqueValuePtr, Basic) {
   ASSERT_TRUE(c == d);
   ASSERT_TRUE(6 == **d);
 }
+
+TEST(LatencyHistogram, Quantiles) {
+  td::LatencyHistogram histogram;
+  ASSERT_EQ(0u, histogram.get_count());
+  ASSERT_TRUE(histogram.get_quantile(0.5) == 0.0);
+
+  for (int i = 1; i <= 1000; i++) {
+    histogram.add(i * 0.001);
+  }
+  histogram.add(-1.0);
+  ASSERT_EQ(1001u, histogram.get_count());
+  ASSERT_TRUE(std::abs(histogram.get_total() - 500.5) < 1e-6);
+  ASSERT_TRUE(histogram.get_max() == 1.0);
+  ASSERT_TRUE(histogram.get_quantile(1.0) == 1.0);
+  ASSERT_TRUE(histogram.get_quantile(0.0) == 1e-6);
+  for (double q : {0.1, 0.5, 0.9, 0.99}) {
+    auto expected = q * 1001 * 0.001;
+    auto quantile = histogram.get_quantile(q);
+    ASSERT_TRUE(quantile >= expected * 0.99);
+    ASSERT_TRUE(quantile <= expected * 1.2);
+  }
+
+  td::LatencyHistogram big;
+  big.add(1e6);
+  ASSERT_TRUE(big.get_quantile(0.5) == 1e6);
+}
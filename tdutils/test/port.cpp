@@ -5,18 +5,28 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 #include "td/utils/algorithm.h"
+#include "td/utils/buffer.h"
+#include "td/utils/BufferedFd.h"
+#include "td/utils/BufferedUdp.h"
 #include "td/utils/common.h"
+#include "td/utils/filesystem.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/Clocks.h"
 #include "td/utils/port/EventFd.h"
 #include "td/utils/port/FileFd.h"
+#include "td/utils/port/IPAddress.h"
 #include "td/utils/port/IoSlice.h"
+#include "td/utils/port/numa.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/Poll.h"
+#include "td/utils/port/PollFlags.h"
 #include "td/utils/port/signals.h"
 #include "td/utils/port/sleep.h"
 #include "td/utils/port/Stat.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/port/thread_local.h"
+#include "td/utils/port/UdpSocketFd.h"
 #include "td/utils/Random.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/Slice.h"
@@ -124,6 +134,26 @@ TEST(Port, SparseFiles) {
   td::unlink(path).ensure();
 }
 
+TEST(Port, HardLinks) {
+  td::CSlice path = "hard_link.txt";
+  td::CSlice link_path = "hard_link2.txt";
+  td::unlink(path).ignore();
+  td::unlink(link_path).ignore();
+  td::write_file(path, "data").ensure();
+  auto r_link = td::link(path, link_path);
+  if (r_link.is_error()) {
+    LOG(ERROR) << "Hard links aren't supported: " << r_link;
+    td::unlink(path).ensure();
+    return;
+  }
+  ASSERT_EQ(2u, td::stat(path).ok().link_count_);
+  ASSERT_TRUE(td::link(path, link_path).is_error());
+  ASSERT_EQ("data", td::read_file_str(link_path).move_as_ok());
+  td::unlink(path).ensure();
+  ASSERT_EQ(1u, td::stat(link_path).ok().link_count_);
+  td::unlink(link_path).ensure();
+}
+
 TEST(Port, LargeFiles) {
   td::CSlice path = "large.txt";
   td::unlink(path).ignore();
@@ -179,6 +209,26 @@ TEST(Port, Writev) {
   td::unlink(test_file_path).ignore();
 }
 
+TEST(Port, BufferedFdWritev) {
+  td::CSlice test_file_path = "test.txt";
+  td::unlink(test_file_path).ignore();
+  td::BufferedFd<td::FileFd> fd(
+      td::FileFd::open(test_file_path, td::FileFd::Write | td::FileFd::CreateNew).move_as_ok());
+  td::string expected_content;
+  for (int i = 0; i < 50; i++) {
+    td::string chunk(1000, static_cast<char>('a' + i % 26));
+    expected_content += chunk;
+    fd.output_buffer().append(td::BufferSlice(chunk));
+  }
+  ASSERT_EQ(expected_content.size(), fd.flush_write().move_as_ok());
+  ASSERT_EQ(1u, fd.get_write_syscall_count());
+  fd.close();
+
+  auto content = td::read_file_str(test_file_path).move_as_ok();
+  ASSERT_EQ(expected_content, content);
+  td::unlink(test_file_path).ignore();
+}
+
 #if TD_PORT_POSIX && !TD_THREAD_UNSUPPORTED
 
 static std::mutex m;
@@ -295,6 +345,67 @@ TEST(Port, EventFdAndSignals) {
 #endif
 #endif
 
+#ifdef TD_POLL_EPOLL
+TEST(Port, EpollAndIoUring) {
+  SCOPE_EXIT {
+    td::detail::Epoll::set_io_uring_enabled(false);
+  };
+  for (bool use_io_uring : {false, true}) {
+    td::detail::Epoll::set_io_uring_enabled(use_io_uring);
+    td::Poll poll;
+    poll.init();
+    if (use_io_uring && !poll.is_io_uring_used()) {
+      LOG(ERROR) << "io_uring isn't supported";
+      poll.clear();
+      continue;
+    }
+    ASSERT_EQ(use_io_uring, poll.is_io_uring_used());
+
+    td::vector<td::EventFd> event_fds(500);
+    td::vector<bool> is_subscribed(event_fds.size(), true);
+    for (auto &event_fd : event_fds) {
+      event_fd.init();
+      poll.subscribe(event_fd.get_poll_info().extract_pollable_fd(nullptr), td::PollFlags::Read());
+    }
+
+    auto check = [&](const td::vector<bool> &is_released) {
+      poll.run(0);
+      for (td::size_t i = 0; i < event_fds.size(); i++) {
+        bool can_read = event_fds[i].get_poll_info().sync_with_poll().can_read();
+        ASSERT_EQ(is_released[i] && is_subscribed[i], can_read);
+        if (is_released[i]) {
+          event_fds[i].acquire();
+        }
+      }
+    };
+
+    check(td::vector<bool>(event_fds.size(), false));
+    for (int t = 0; t < 10; t++) {
+      td::vector<bool> is_released(event_fds.size());
+      for (td::size_t i = 0; i < event_fds.size(); i++) {
+        if (td::Random::fast_bool()) {
+          is_released[i] = true;
+          event_fds[i].release();
+        }
+        if (t == 5 && td::Random::fast_bool()) {
+          poll.unsubscribe(event_fds[i].get_poll_info().get_pollable_fd_ref());
+          is_subscribed[i] = false;
+        }
+      }
+      check(is_released);
+    }
+
+    for (td::size_t i = 0; i < event_fds.size(); i++) {
+      if (is_subscribed[i]) {
+        poll.unsubscribe_before_close(event_fds[i].get_poll_info().get_pollable_fd_ref());
+      }
+      event_fds[i].close();
+    }
+    poll.clear();
+  }
+}
+#endif
+
 #if TD_HAVE_THREAD_AFFINITY
 TEST(Port, ThreadAffinityMask) {
   auto thread_id = td::this_thread::get_id();
@@ -324,3 +435,180 @@ TEST(Port, ThreadAffinityMask) {
   LOG(INFO) << old_mask;
 }
 #endif
+
+TEST(Port, NumaNodeCpuMasks) {
+  td::uint64 all_cpus_mask = 0;
+  for (auto mask : td::get_numa_node_cpu_masks()) {
+    LOG(INFO) << "NUMA node CPU mask: " << mask;
+    ASSERT_TRUE(mask != 0);
+    ASSERT_TRUE((all_cpus_mask & mask) == 0);
+    all_cpus_mask |= mask;
+  }
+}
+
+TEST(Port, ThreadCpuTime) {
+  auto start_cpu_time = td::Clocks::thread_cpu();
+  auto start_time = td::Time::now();
+  td::uint64 result = 0;
+  while (td::Time::now() < start_time + 0.05) {
+    for (int i = 0; i < 1000; i++) {
+      result = result * 31 + static_cast<td::uint64>(i);
+    }
+  }
+  ASSERT_TRUE(result != 0);
+  auto cpu_time = td::Clocks::thread_cpu() - start_cpu_time;
+  ASSERT_TRUE(cpu_time > 0.0);
+  ASSERT_TRUE(cpu_time < td::Time::now() - start_time + 0.1);
+
+  // sleeping doesn't consume CPU time
+  start_cpu_time = td::Clocks::thread_cpu();
+  td::usleep_for(100000);
+  ASSERT_TRUE(td::Clocks::thread_cpu() - start_cpu_time < 0.05);
+}
+
+#if TD_PORT_POSIX
+static td::string get_udp_test_datagram(size_t i, size_t size) {
+  td::string result(size, '\0');
+  for (size_t j = 0; j < size; j++) {
+    result[j] = static_cast<char>(i * 13 + j);
+  }
+  return result;
+}
+
+// receives datagrams until the expected number of them is received or the timeout expires
+static td::vector<td::string> receive_udp_datagrams(td::BufferedUdp &fd, size_t expected_count) {
+  td::vector<td::string> result;
+  auto end_time = td::Time::now() + 5.0;
+  while (result.size() < expected_count && td::Time::now() < end_time) {
+    fd.get_poll_info().add_flags(td::PollFlags::Read());
+    auto r_message = fd.receive();
+    LOG_IF(FATAL, r_message.is_error()) << r_message.error();
+    auto message = r_message.move_as_ok();
+    if (!message) {
+      td::usleep_for(1000);
+      continue;
+    }
+    message.value().error.ensure();
+    result.push_back(message.value().data.as_slice().str());
+  }
+  return result;
+}
+
+static void send_udp_datagrams(td::BufferedUdp &fd, const td::IPAddress &to, const td::vector<td::string> &datagrams) {
+  for (auto &datagram : datagrams) {
+    fd.send(td::UdpMessage{to, td::BufferSlice(datagram), td::Status::OK()});
+  }
+  fd.get_poll_info().add_flags(td::PollFlags::Write());
+  fd.flush_send().ensure();
+}
+
+TEST(Port, BufferedUdpBatchSize) {
+  td::IPAddress receiver_address;
+  receiver_address.init_ipv4_port("127.0.0.1", 31467).ensure();
+  td::IPAddress sender_address;
+  sender_address.init_ipv4_port("127.0.0.1", 31468).ensure();
+  td::BufferedUdp receiver(td::UdpSocketFd::open(receiver_address).move_as_ok());
+  td::BufferedUdp sender(td::UdpSocketFd::open(sender_address).move_as_ok());
+
+  for (size_t batch_size : {static_cast<size_t>(1), static_cast<size_t>(7), td::UdpSocketFd::MAX_BATCH_SIZE}) {
+    receiver.set_batch_size(batch_size);
+    sender.set_batch_size(batch_size);
+    td::vector<td::string> datagrams;
+    for (size_t i = 0; i < 100; i++) {
+      datagrams.push_back(get_udp_test_datagram(i, 1 + i * 10));
+    }
+    send_udp_datagrams(sender, receiver_address, datagrams);
+    ASSERT_EQ(datagrams, receive_udp_datagrams(receiver, datagrams.size()));
+  }
+}
+
+TEST(Port, BufferedUdpSendOffload) {
+  td::IPAddress receiver_address;
+  receiver_address.init_ipv4_port("127.0.0.1", 31469).ensure();
+  td::IPAddress sender_address;
+  sender_address.init_ipv4_port("127.0.0.1", 31470).ensure();
+  td::BufferedUdp receiver(td::UdpSocketFd::open(receiver_address).move_as_ok());
+  td::BufferedUdp sender(td::UdpSocketFd::open(sender_address).move_as_ok());
+  auto status = sender.enable_send_offload();
+  if (status.is_error()) {
+    LOG(INFO) << "Skip test: " << status;
+    return;
+  }
+  ASSERT_TRUE(sender.is_send_offload_enabled());
+
+  // datagrams of equal size are merged, but each of them must be received separately and unchanged;
+  // the total number of datagrams is kept small enough to fit in the receive buffer of the socket
+  td::vector<td::string> datagrams;
+  for (size_t i = 0; i < 50; i++) {
+    datagrams.push_back(get_udp_test_datagram(i, 1000));
+  }
+  datagrams.push_back(get_udp_test_datagram(50, 300));  // the last segment can be shorter
+  datagrams.push_back(get_udp_test_datagram(51, 1500));  // a longer datagram starts a new message
+  for (size_t i = 52; i < 80; i++) {
+    datagrams.push_back(get_udp_test_datagram(i, 1200));
+  }
+  send_udp_datagrams(sender, receiver_address, datagrams);
+  ASSERT_EQ(datagrams, receive_udp_datagrams(receiver, datagrams.size()));
+}
+
+TEST(Port, UdpReceiveOffload) {
+  td::IPAddress receiver_address;
+  receiver_address.init_ipv4_port("127.0.0.1", 31471).ensure();
+  td::IPAddress sender_address;
+  sender_address.init_ipv4_port("127.0.0.1", 31472).ensure();
+  auto receiver = td::UdpSocketFd::open(receiver_address).move_as_ok();
+  auto sender = td::UdpSocketFd::open(sender_address).move_as_ok();
+  auto status = sender.enable_send_offload();
+  if (status.is_ok()) {
+    status = receiver.enable_receive_offload();
+  }
+  if (status.is_error()) {
+    LOG(INFO) << "Skip test: " << status;
+    return;
+  }
+  ASSERT_TRUE(receiver.is_receive_offload_enabled());
+
+  const size_t segment_size = 1000;
+  const size_t segment_count = 10;
+  td::string data;
+  for (size_t i = 0; i < segment_count; i++) {
+    data += get_udp_test_datagram(i, segment_size);
+  }
+  td::UdpSocketFd::OutboundMessage outbound_message;
+  outbound_message.to = &receiver_address;
+  outbound_message.data = data;
+  outbound_message.segment_size = segment_size;
+  bool is_sent = false;
+  sender.get_poll_info().add_flags(td::PollFlags::Write());
+  sender.send_message(outbound_message, is_sent).ensure();
+  ASSERT_TRUE(is_sent);
+
+  // the datagrams can be received coalesced or one by one, but the data must be the same
+  td::string received_data;
+  td::string buffer(td::UdpSocketFd::MAX_COALESCED_MESSAGE_SIZE, '\0');
+  auto end_time = td::Time::now() + 5.0;
+  while (received_data.size() < data.size() && td::Time::now() < end_time) {
+    td::IPAddress from;
+    td::Status error;
+    td::UdpSocketFd::InboundMessage inbound_message;
+    inbound_message.from = &from;
+    inbound_message.data = td::MutableSlice(buffer);
+    inbound_message.error = &error;
+    bool is_received = false;
+    receiver.get_poll_info().add_flags(td::PollFlags::Read());
+    receiver.receive_message(inbound_message, is_received).ensure();
+    if (!is_received) {
+      td::usleep_for(1000);
+      continue;
+    }
+    error.ensure();
+    if (inbound_message.segment_size != 0) {
+      ASSERT_EQ(segment_size, inbound_message.segment_size);
+    } else {
+      ASSERT_EQ(segment_size, inbound_message.data.size());
+    }
+    received_data += inbound_message.data.str();
+  }
+  ASSERT_TRUE(received_data == data);
+}
+#endif
@@ -0,0 +1,251 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "NetworkEmulator.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/BufferedFd.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/Random.h"
+#include "td/utils/Status.h"
+#include "td/utils/Time.h"
+#include "td/utils/VectorQueue.h"
+
+namespace td {
+
+int VERBOSITY_NAME(network_emulator) = VERBOSITY_NAME(DEBUG);
+
+NetworkProfile NetworkProfile::datacenter() {
+  NetworkProfile profile;
+  profile.name = "datacenter";
+  profile.round_trip_time = 0.001;
+  profile.jitter = 0.0001;
+  profile.bandwidth = 125e6;
+  return profile;
+}
+
+NetworkProfile NetworkProfile::mobile() {
+  NetworkProfile profile;
+  profile.name = "mobile";
+  profile.round_trip_time = 0.1;
+  profile.jitter = 0.03;
+  profile.bandwidth = 1.25e6;
+  profile.loss_probability = 0.01;
+  profile.reorder_probability = 0.005;
+  return profile;
+}
+
+NetworkProfile NetworkProfile::satellite() {
+  NetworkProfile profile;
+  profile.name = "satellite";
+  profile.round_trip_time = 0.6;
+  profile.jitter = 0.05;
+  profile.bandwidth = 0.625e6;
+  profile.loss_probability = 0.005;
+  profile.reorder_probability = 0.001;
+  return profile;
+}
+
+namespace {
+
+// one direction of an emulated connection
+class NetworkEmulatorLink {
+ public:
+  NetworkEmulatorLink(const NetworkProfile &profile, uint64 seed) : profile_(profile), random_(seed) {
+  }
+
+  void push(ChainBufferReader &input, double now) {
+    while (!input.empty()) {
+      auto size = min(input.size(), MAX_SEGMENT_SIZE);
+      auto data = input.cut_head(size).move_as_buffer_slice();
+
+      auto send_time = max(now, link_free_time_);
+      link_free_time_ = send_time;
+      if (profile_.bandwidth > 0) {
+        link_free_time_ += static_cast<double>(size + SEGMENT_HEADER_SIZE) / profile_.bandwidth;
+      }
+      auto arrival_time = link_free_time_ + profile_.round_trip_time * 0.5 + profile_.jitter * get_random_double();
+      if (get_random_double() < profile_.loss_probability) {
+        // the segment is retransmitted after the retransmission timeout
+        arrival_time += max(MIN_RETRANSMISSION_TIMEOUT, 2 * profile_.round_trip_time);
+      } else if (get_random_double() < profile_.reorder_probability) {
+        arrival_time += max(profile_.jitter, profile_.round_trip_time * 0.25);
+      }
+      // the data is delivered in order, so the segment can't be received before the previous segments
+      arrival_time = max(arrival_time, last_arrival_time_);
+      last_arrival_time_ = arrival_time;
+      Segment segment;
+      segment.arrival_time = arrival_time;
+      segment.data = std::move(data);
+      segments_.push(std::move(segment));
+    }
+  }
+
+  void pop_ready(double now, ChainBufferWriter &output) {
+    while (!segments_.empty() && segments_.front().arrival_time <= now) {
+      output.append(std::move(segments_.front().data));
+      segments_.pop();
+    }
+  }
+
+  bool empty() const {
+    return segments_.empty();
+  }
+
+  double get_next_arrival_time() const {
+    CHECK(!empty());
+    return segments_.front().arrival_time;
+  }
+
+ private:
+  static constexpr size_t MAX_SEGMENT_SIZE = 1400;
+  static constexpr size_t SEGMENT_HEADER_SIZE = 52;
+  static constexpr double MIN_RETRANSMISSION_TIMEOUT = 0.2;
+
+  struct Segment {
+    double arrival_time = 0.0;
+    BufferSlice data;
+  };
+
+  const NetworkProfile &profile_;
+  Random::Xorshift128plus random_;
+  double link_free_time_ = 0.0;
+  double last_arrival_time_ = 0.0;
+  VectorQueue<Segment> segments_;
+
+  double get_random_double() {
+    return static_cast<double>(random_() >> 11) * (1.0 / static_cast<double>(static_cast<uint64>(1) << 53));
+  }
+};
+
+class NetworkEmulatorConnection final : public Actor {
+ public:
+  NetworkEmulatorConnection(SocketFd client_fd, SocketFd server_fd, NetworkProfile profile, uint64 seed,
+                            ActorShared<> parent)
+      : client_fd_(std::move(client_fd))
+      , server_fd_(std::move(server_fd))
+      , profile_(std::move(profile))
+      , to_server_(profile_, seed * 2 + 1)
+      , to_client_(profile_, seed * 2 + 2)
+      , parent_(std::move(parent)) {
+  }
+
+ private:
+  BufferedFd<SocketFd> client_fd_;
+  BufferedFd<SocketFd> server_fd_;
+  NetworkProfile profile_;
+  NetworkEmulatorLink to_server_;
+  NetworkEmulatorLink to_client_;
+  ActorShared<> parent_;
+
+  void start_up() final {
+    VLOG(network_emulator) << "Start to emulate " << profile_.name << " connection";
+    Scheduler::subscribe(client_fd_.get_poll_info().extract_pollable_fd(this));
+    Scheduler::subscribe(server_fd_.get_poll_info().extract_pollable_fd(this));
+    loop();
+  }
+
+  void tear_down() final {
+    VLOG(network_emulator) << "Finish to emulate " << profile_.name << " connection";
+    Scheduler::unsubscribe_before_close(client_fd_.get_poll_info().get_pollable_fd_ref());
+    client_fd_.close();
+    Scheduler::unsubscribe_before_close(server_fd_.get_poll_info().get_pollable_fd_ref());
+    server_fd_.close();
+  }
+
+  void hangup() final {
+    stop();
+  }
+
+  void timeout_expired() final {
+    loop();
+  }
+
+  void loop() final {
+    auto status = loop_impl();
+    if (status.is_error()) {
+      VLOG(network_emulator) << "Close connection: " << status;
+      return stop();
+    }
+    double next_arrival_time = 0.0;
+    for (auto *link : {&to_server_, &to_client_}) {
+      if (!link->empty() && (next_arrival_time == 0.0 || link->get_next_arrival_time() < next_arrival_time)) {
+        next_arrival_time = link->get_next_arrival_time();
+      }
+    }
+    if (next_arrival_time != 0.0) {
+      set_timeout_at(next_arrival_time);
+    } else {
+      cancel_timeout();
+    }
+  }
+
+  Status loop_impl() {
+    sync_with_poll(client_fd_);
+    sync_with_poll(server_fd_);
+    TRY_STATUS(client_fd_.flush_read());
+    TRY_STATUS(server_fd_.flush_read());
+
+    auto now = Time::now();
+    to_server_.push(client_fd_.input_buffer(), now);
+    to_client_.push(server_fd_.input_buffer(), now);
+    to_server_.pop_ready(now, server_fd_.output_buffer());
+    to_client_.pop_ready(now, client_fd_.output_buffer());
+
+    TRY_STATUS(client_fd_.flush_write());
+    TRY_STATUS(server_fd_.flush_write());
+    // a closed connection is closed on the other side after all sent data is delivered
+    if (can_close_local(client_fd_) && to_server_.empty() && server_fd_.ready_for_flush_write() == 0) {
+      return Status::Error("Client connection closed");
+    }
+    if (can_close_local(server_fd_) && to_client_.empty() && client_fd_.ready_for_flush_write() == 0) {
+      return Status::Error("Server connection closed");
+    }
+    return Status::OK();
+  }
+};
+
+}  // namespace
+
+NetworkEmulator::NetworkEmulator(int port, IPAddress target_address, NetworkProfile profile, ActorShared<> parent,
+                                 Slice server_address)
+    : port_(port)
+    , target_address_(std::move(target_address))
+    , profile_(std::move(profile))
+    , parent_(std::move(parent))
+    , server_address_(server_address.str()) {
+}
+
+void NetworkEmulator::start_up() {
+  listener_ = create_actor<TcpListener>("NetworkEmulatorListener", port_, actor_shared(this), server_address_);
+}
+
+void NetworkEmulator::hangup_shared() {
+  // the connection has been closed
+  connections_.erase(get_link_token());
+}
+
+void NetworkEmulator::hangup() {
+  listener_.reset();
+  connections_.clear();
+  stop();
+}
+
+void NetworkEmulator::accept(SocketFd fd) {
+  auto r_server_fd = SocketFd::open(target_address_);
+  if (r_server_fd.is_error()) {
+    LOG(ERROR) << "Failed to connect to " << target_address_ << ": " << r_server_fd.error();
+    return;
+  }
+  auto connection_id = ++connection_count_;
+  connections_[connection_id] = ActorOwn<Actor>(create_actor<NetworkEmulatorConnection>(
+      "NetworkEmulatorConnection", std::move(fd), r_server_fd.move_as_ok(), profile_,
+      profile_.seed + connection_id - 1, actor_shared(this, connection_id)));
+}
+
+}  // namespace td
@@ -0,0 +1,66 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/net/TcpListener.h"
+
+#include "td/actor/actor.h"
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/port/IPAddress.h"
+#include "td/utils/port/SocketFd.h"
+#include "td/utils/Slice.h"
+
+namespace td {
+
+extern int VERBOSITY_NAME(network_emulator);
+
+struct NetworkProfile {
+  string name;
+  double round_trip_time = 0.0;      // in seconds
+  double jitter = 0.0;               // maximum additional random one-way delay in seconds
+  double bandwidth = 0.0;            // in bytes per second in each direction; 0 means unlimited bandwidth
+  double loss_probability = 0.0;     // probability of a segment to be lost and retransmitted
+  double reorder_probability = 0.0;  // probability of a segment to be delayed after the following segments
+  uint64 seed = 1;                   // all random decisions are the same for the same seed
+
+  static NetworkProfile datacenter();
+  static NetworkProfile mobile();
+  static NetworkProfile satellite();
+};
+
+// in-process TCP proxy, which forwards connections accepted on a local port to the target address
+// under the specified network conditions; the forwarded data is split into segments, which are delayed
+// according to the profile; TCP delivers data in order, so lost and reordered segments delay all following data
+class NetworkEmulator final : public TcpListener::Callback {
+ public:
+  NetworkEmulator(int port, IPAddress target_address, NetworkProfile profile, ActorShared<> parent,
+                  Slice server_address = Slice("127.0.0.1"));
+
+  void accept(SocketFd fd) final;
+
+  size_t get_connection_count() const {
+    return connections_.size();
+  }
+
+ private:
+  int port_;
+  IPAddress target_address_;
+  NetworkProfile profile_;
+  ActorShared<> parent_;
+  string server_address_;
+  uint64 connection_count_ = 0;
+  ActorOwn<TcpListener> listener_;
+  FlatHashMap<uint64, ActorOwn<Actor>> connections_;
+
+  void start_up() final;
+  void hangup_shared() final;
+  void hangup() final;
+};
+
+}  // namespace td
@@ -6,6 +6,14 @@
 //
 #include "data.h"
 
+#include "td/telegram/DialogId.h"
+#include "td/telegram/MessageDb.h"
+#include "td/telegram/MessageFullId.h"
+#include "td/telegram/MessageId.h"
+#include "td/telegram/NotificationId.h"
+#include "td/telegram/ServerMessageId.h"
+#include "td/telegram/Version.h"
+
 #include "td/db/binlog/BinlogHelper.h"
 #include "td/db/binlog/ConcurrentBinlog.h"
 #include "td/db/BinlogKeyValue.h"
@@ -15,6 +23,7 @@
 #include "td/db/SqliteDb.h"
 #include "td/db/SqliteKeyValue.h"
 #include "td/db/SqliteKeyValueSafe.h"
+#include "td/db/SqliteWalCheckpointer.h"
 #include "td/db/TsSeqKeyValue.h"
 
 #include "td/actor/actor.h"
@@ -26,9 +35,12 @@
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/FileFd.h"
+#include "td/utils/port/sleep.h"
+#include "td/utils/port/Stat.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tests.h"
@@ -138,6 +150,60 @@ TEST(DB, binlog_encryption) {
   td::Binlog::destroy(binlog_name).ignore();
 }
 
+TEST(DB, binlog_incremental_reindex) {
+  td::CSlice binlog_name = "test_binlog";
+  td::vector<td::DbKey> db_keys;
+  db_keys.push_back(td::DbKey::empty());
+  db_keys.push_back(td::DbKey::raw_key(td::string(32, 'A')));
+  for (auto &db_key : db_keys) {
+    td::Binlog::destroy(binlog_name).ignore();
+
+    std::map<td::uint64, td::string> events;
+    auto gen_data = [] {
+      return td::string(4 * td::Random::fast(1, 250), static_cast<char>(td::Random::fast('a', 'z')));
+    };
+    {
+      td::Binlog binlog;
+      binlog.init(binlog_name.str(), [](const td::BinlogEvent &x) {}, db_key).ensure();
+      for (int i = 0; i < 20000; i++) {
+        auto type = td::Random::fast(0, 9);
+        if (events.empty() || type < 5) {
+          auto data = gen_data();
+          auto event_id = binlog.add(1, td::create_storer(data));
+          events[event_id] = std::move(data);
+        } else {
+          auto it = events.lower_bound(td::Random::fast_uint64() % (events.rbegin()->first + 1));
+          if (it == events.end()) {
+            it = events.begin();
+          }
+          if (type < 7) {
+            auto data = gen_data();
+            binlog.rewrite(it->first, 1, td::create_storer(data));
+            it->second = std::move(data);
+          } else {
+            binlog.erase(it->first);
+            events.erase(it);
+          }
+        }
+      }
+      binlog.close().ensure();
+    }
+    ASSERT_TRUE(td::stat(PSLICE() << binlog_name << ".new").is_error());
+
+    std::map<td::uint64, td::string> loaded_events;
+    {
+      td::Binlog binlog;
+      binlog
+          .init(
+              binlog_name.str(),
+              [&](const td::BinlogEvent &x) { loaded_events[x.id_] = x.get_data().str(); }, db_key)
+          .ensure();
+    }
+    ASSERT_TRUE(events == loaded_events);
+  }
+  td::Binlog::destroy(binlog_name).ignore();
+}
+
 TEST(DB, sqlite_lfs) {
   td::string path = "test_sqlite_db";
   td::SqliteDb::destroy(path).ignore();
@@ -411,6 +477,49 @@ class BaselineKV {
   SeqNo current_tid_ = 0;
 };
 
+#if !TD_THREAD_UNSUPPORTED
+TEST(DB, sqlite_wal_checkpointer) {
+  td::string path = "test_wal_checkpointer.sqlite";
+  td::SqliteDb::destroy(path).ignore();
+
+  auto db = td::SqliteDb::open_with_key(path, true, td::DbKey::empty()).move_as_ok();
+  td::SqliteConnectionSafe::init_connection(db, false, false).ensure();
+  db.exec("CREATE TABLE data (value BLOB)").ensure();
+
+  // the period is too big, so checkpoints can be triggered only by the WAL size
+  auto checkpointer = td::create_sqlite_wal_checkpointer(
+      td::SqliteDb::open_with_key(path, false, td::DbKey::empty()).move_as_ok(), path, 1e9, 1 << 20);
+  auto wait_checkpoint_count = [&checkpointer](td::int64 count) {
+    for (int i = 0; i < 100 && checkpointer->get_checkpoint_count() < count; i++) {
+      td::usleep_for(50000);
+    }
+    return checkpointer->get_checkpoint_count();
+  };
+
+  // the WAL file isn't truncated, so the size must be checked after it is overwritten from the beginning
+  for (int i = 1; i <= 3; i++) {
+    db.begin_write_transaction().ensure();
+    for (int j = 0; j < 20; j++) {
+      db.exec("INSERT INTO data VALUES(randomblob(65536))").ensure();
+    }
+    db.commit_transaction().ensure();
+    ASSERT_EQ(i, wait_checkpoint_count(i));
+  }
+
+  // all frames are already checkpointed
+  td::usleep_for(1500000);
+  ASSERT_EQ(3, checkpointer->get_checkpoint_count());
+
+  db.exec("INSERT INTO data VALUES(randomblob(16))").ensure();
+  td::usleep_for(1500000);
+  ASSERT_EQ(3, checkpointer->get_checkpoint_count());
+
+  checkpointer.reset();
+  db.close();
+  td::SqliteDb::destroy(path).ignore();
+}
+#endif
+
 TEST(DB, key_value) {
   td::vector<td::string> keys;
   td::vector<td::string> values;
@@ -807,3 +916,84 @@ TEST(DB, persistent_key_value) {
   }
   td::SqliteDb::destroy(path).ignore();
 }
+
+static td::int64 count_fts_messages(td::SqliteDb &db, td::Slice words) {
+  auto stmt = db.get_statement(PSLICE() << "SELECT count(*) FROM messages_fts WHERE messages_fts MATCH '" << words
+                                        << "'")
+                  .move_as_ok();
+  stmt.step().ensure();
+  return stmt.view_int64(0);
+}
+
+TEST(DB, message_db_fts_migration) {
+  td::string path = "test_message_db.sqlite";
+  td::SqliteDb::destroy(path).ignore();
+
+  // the database before the upgrade to AddMessageFtsPendingTable
+  {
+    auto db = td::SqliteDb::open_with_key(path, true, td::DbKey::empty()).move_as_ok();
+    db.exec("CREATE TABLE messages (dialog_id INT8, message_id INT8, unique_message_id INT4, sender_user_id INT8, "
+            "random_id INT8, data BLOB, ttl_expires_at INT4, index_mask INT4, search_id INT8, text STRING, "
+            "notification_id INT4, top_thread_message_id INT8, PRIMARY KEY (dialog_id, message_id))")
+        .ensure();
+    db.exec("CREATE VIRTUAL TABLE messages_fts USING fts5(text, content='messages', content_rowid='search_id', "
+            "tokenize = \"unicode61 remove_diacritics 0 tokenchars '\a'\")")
+        .ensure();
+    db.exec("CREATE TRIGGER trigger_fts_delete BEFORE DELETE ON messages WHEN OLD.search_id IS NOT NULL BEGIN INSERT "
+            "INTO messages_fts(messages_fts, rowid, text) VALUES('delete', OLD.search_id, OLD.text); END")
+        .ensure();
+    db.exec("CREATE TRIGGER trigger_fts_insert AFTER INSERT ON messages WHEN NEW.search_id IS NOT NULL BEGIN INSERT "
+            "INTO messages_fts(rowid, text) VALUES(NEW.search_id, NEW.text); END")
+        .ensure();
+    db.exec("CREATE TABLE scheduled_messages (dialog_id INT8, message_id INT8, server_message_id INT4, data BLOB, "
+            "PRIMARY KEY (dialog_id, message_id))")
+        .ensure();
+    for (int i = 1; i <= 10; i++) {
+      db.exec(PSLICE() << "INSERT INTO messages (dialog_id, message_id, data, search_id, text) VALUES(1, "
+                       << (i << 20) << ", x'00', " << i << ", 'hello" << i << " common')")
+          .ensure();
+    }
+
+    db.begin_write_transaction().ensure();
+    td::init_message_db(db, static_cast<td::int32>(td::DbVersion::AddMessageFtsPendingTable) - 1).ensure();
+    db.set_user_version(td::current_db_version()).ensure();
+    db.commit_transaction().ensure();
+
+    // the index must be kept as is
+    ASSERT_EQ(10, count_fts_messages(db, "common"));
+    auto stmt = db.get_statement("SELECT count(*) FROM messages_fts_pending").move_as_ok();
+    stmt.step().ensure();
+    ASSERT_EQ(0, stmt.view_int64(0));
+  }
+
+  td::ConcurrentScheduler sched(0, 0);
+  {
+    auto guard = sched.get_main_guard();
+    auto connection = std::make_shared<td::SqliteConnectionSafe>(path, td::DbKey::empty());
+    auto message_db = td::create_message_db_sync(connection);
+    auto &db = message_db->get();
+
+    auto find = [&db](td::string query) {
+      td::MessageDbFtsQuery fts_query;
+      fts_query.query = std::move(query);
+      return db.get_messages_fts(std::move(fts_query)).messages.size();
+    };
+    ASSERT_EQ(1u, find("hello3"));
+
+    // the replaced text must be removed from the index
+    td::MessageFullId message_full_id(td::DialogId(static_cast<td::int64>(1)),
+                                      td::MessageId(td::ServerMessageId(3)));
+    db.add_message(message_full_id, td::ServerMessageId(), td::DialogId(), 0, 0, 0, 3, "world", td::NotificationId(),
+                   td::MessageId(), td::BufferSlice("data"));
+    ASSERT_EQ(0u, find("hello3"));
+    ASSERT_EQ(1u, find("world"));
+    ASSERT_EQ(9u, find("common"));
+
+    db.delete_message(message_full_id);
+    ASSERT_EQ(0u, find("world"));
+    ASSERT_EQ(9u, find("common"));
+
+    connection->close();
+  }
+  td::SqliteDb::destroy(path).ignore();
+}
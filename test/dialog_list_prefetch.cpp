@@ -0,0 +1,117 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/DialogDate.h"
+#include "td/telegram/DialogId.h"
+#include "td/telegram/DialogListPrefetch.h"
+#include "td/telegram/telegram_api.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+#include "td/utils/tests.h"
+#include "td/utils/tl_parsers.h"
+
+static td::DialogListPrefetch::Page get_page() {
+  td::int32 data[2] = {td::telegram_api::messages_dialogsNotModified::ID, 0};
+  td::BufferSlice buffer(td::Slice(reinterpret_cast<const char *>(data), sizeof(data)));
+  td::TlBufferParser parser(&buffer);
+  auto page = td::telegram_api::messages_Dialogs::fetch(parser);
+  parser.fetch_end();
+  parser.get_status().ensure();
+  return page;
+}
+
+static td::Promise<td::Unit> get_counting_promise(int &ok_count, int &error_count) {
+  return td::PromiseCreator::lambda([&ok_count, &error_count](td::Result<td::Unit> result) {
+    if (result.is_ok()) {
+      ok_count++;
+    } else {
+      error_count++;
+    }
+  });
+}
+
+TEST(DialogListPrefetch, hit) {
+  td::DialogDate offset(12345, td::DialogId(static_cast<td::int64>(1)));
+  td::DialogListPrefetch prefetch(offset);
+  prefetch.set_page(get_page(), 100.0);
+  ASSERT_TRUE(prefetch.is_received());
+
+  int ok_count = 0;
+  int error_count = 0;
+  auto promise = get_counting_promise(ok_count, error_count);
+  ASSERT_TRUE(prefetch.on_request(offset, 101.0, promise) == td::DialogListPrefetch::RequestResult::UsePage);
+  ASSERT_TRUE(static_cast<bool>(promise));
+  ASSERT_TRUE(prefetch.extract_page() != nullptr);
+  promise.set_value(td::Unit());
+  ASSERT_EQ(1, ok_count);
+}
+
+TEST(DialogListPrefetch, wait) {
+  td::DialogDate offset(12345, td::DialogId(static_cast<td::int64>(1)));
+  td::DialogListPrefetch prefetch(offset);
+
+  int ok_count = 0;
+  int error_count = 0;
+  auto promise = get_counting_promise(ok_count, error_count);
+  ASSERT_TRUE(prefetch.on_request(offset, 100.0, promise) == td::DialogListPrefetch::RequestResult::Wait);
+  ASSERT_TRUE(!promise);
+  prefetch.extract_waiting_promise().set_value(td::Unit());
+  ASSERT_EQ(1, ok_count);
+  ASSERT_EQ(0, error_count);
+}
+
+TEST(DialogListPrefetch, miss) {
+  td::DialogDate offset(12345, td::DialogId(static_cast<td::int64>(1)));
+  td::DialogDate other_offset(12344, td::DialogId(static_cast<td::int64>(1)));
+  td::DialogListPrefetch prefetch(offset);
+
+  int ok_count = 0;
+  int error_count = 0;
+  auto promise = get_counting_promise(ok_count, error_count);
+  ASSERT_TRUE(prefetch.on_request(other_offset, 100.0, promise) == td::DialogListPrefetch::RequestResult::Miss);
+  ASSERT_TRUE(static_cast<bool>(promise));
+  ASSERT_TRUE(!prefetch.extract_waiting_promise());
+
+  prefetch.set_page(get_page(), 100.0);
+  ASSERT_TRUE(prefetch.on_request(other_offset, 100.0, promise) == td::DialogListPrefetch::RequestResult::Miss);
+
+  // the page has expired
+  ASSERT_TRUE(prefetch.on_request(offset, 100.0 + td::DialogListPrefetch::EXPIRE_TIME, promise) ==
+              td::DialogListPrefetch::RequestResult::Miss);
+  ASSERT_TRUE(static_cast<bool>(promise));
+  promise = {};
+  ASSERT_EQ(0, ok_count);
+}
+
+TEST(DialogListPrefetch, repeated_offset) {
+  td::DialogDate offset(12345, td::DialogId(static_cast<td::int64>(1)));
+  for (int is_error = 0; is_error < 2; is_error++) {
+    td::DialogListPrefetch prefetch(offset);
+    int ok_count = 0;
+    int error_count = 0;
+    for (int i = 0; i < 3; i++) {
+      auto promise = get_counting_promise(ok_count, error_count);
+      ASSERT_TRUE(prefetch.on_request(offset, 100.0, promise) == td::DialogListPrefetch::RequestResult::Wait);
+      ASSERT_TRUE(!promise);
+    }
+    ASSERT_EQ(0, ok_count + error_count);
+
+    auto waiting_promise = prefetch.extract_waiting_promise();
+    if (is_error) {
+      waiting_promise.set_error(td::Status::Error(400, "Error"));
+      ASSERT_EQ(0, ok_count);
+      ASSERT_EQ(3, error_count);
+    } else {
+      waiting_promise.set_value(td::Unit());
+      ASSERT_EQ(3, ok_count);
+      ASSERT_EQ(0, error_count);
+    }
+  }
+}
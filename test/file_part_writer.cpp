@@ -0,0 +1,118 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FilePartWriter.h"
+
+#include "td/actor/actor.h"
+#include "td/actor/ConcurrentScheduler.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/path.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+#include "td/utils/tests.h"
+
+static td::string get_part_data(td::int64 offset, std::size_t size) {
+  td::string result(size, '\0');
+  for (std::size_t i = 0; i < size; i++) {
+    result[i] = static_cast<char>('a' + (offset + static_cast<td::int64>(i)) % 26);
+  }
+  return result;
+}
+
+class TestFilePartWriter final : public td::Actor {
+ public:
+  TestFilePartWriter(td::string path, td::vector<std::pair<td::int64, std::size_t>> parts, std::size_t *ok_count,
+                     std::size_t *error_count)
+      : path_(std::move(path)), parts_(std::move(parts)), ok_count_(ok_count), error_count_(error_count) {
+  }
+
+ private:
+  td::string path_;
+  td::vector<std::pair<td::int64, std::size_t>> parts_;
+  std::size_t *ok_count_;
+  std::size_t *error_count_;
+  std::size_t pending_count_ = 0;
+  td::ActorOwn<td::FilePartWriter> writer_;
+
+  void start_up() final {
+    writer_ = td::create_actor_on_scheduler<td::FilePartWriter>("FilePartWriter", 1, path_);
+    pending_count_ = parts_.size();
+    for (auto &part : parts_) {
+      td::send_closure(writer_, &td::FilePartWriter::write_part, part.first,
+                       td::BufferSlice(get_part_data(part.first, part.second)),
+                       td::PromiseCreator::lambda([actor_id = actor_id(this)](td::Result<td::Unit> result) {
+                         td::send_closure(actor_id, &TestFilePartWriter::on_part_written, result.is_ok());
+                       }));
+    }
+  }
+
+  void on_part_written(bool is_ok) {
+    if (is_ok) {
+      (*ok_count_)++;
+    } else {
+      (*error_count_)++;
+    }
+    CHECK(pending_count_ > 0);
+    if (--pending_count_ == 0) {
+      writer_.reset();
+      td::Scheduler::instance()->finish();
+    }
+  }
+};
+
+static void run_file_part_writer(td::string path, td::vector<std::pair<td::int64, std::size_t>> parts,
+                                 std::size_t &ok_count, std::size_t &error_count) {
+  td::ConcurrentScheduler sched(1, 0);
+  sched.create_actor_unsafe<TestFilePartWriter>(0, "TestFilePartWriter", std::move(path), std::move(parts), &ok_count,
+                                                &error_count)
+      .release();
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+}
+
+TEST(FilePartWriter, write) {
+  td::string path = "file_part_writer_test.tmp";
+  td::unlink(path).ignore();
+  td::write_file(path, "").ensure();
+
+  // unordered, adjacent, overlapping the size limit of a single write and with gaps
+  td::vector<std::pair<td::int64, std::size_t>> parts{
+      {3 << 20, 1 << 20}, {0, 1 << 20}, {1 << 20, 1 << 20}, {2 << 20, 1 << 20}, {4 << 20, 1 << 20},
+      {(6 << 20) + 7, 1000}, {(5 << 20) + 100, 12345}};
+  std::size_t ok_count = 0;
+  std::size_t error_count = 0;
+  run_file_part_writer(path, parts, ok_count, error_count);
+  ASSERT_EQ(parts.size(), ok_count);
+  ASSERT_EQ(0u, error_count);
+
+  auto content = td::read_file_str(path).move_as_ok();
+  ASSERT_EQ(static_cast<std::size_t>((6 << 20) + 7 + 1000), content.size());
+  for (auto &part : parts) {
+    ASSERT_TRUE(td::Slice(content).substr(static_cast<std::size_t>(part.first), part.second) ==
+                get_part_data(part.first, part.second));
+  }
+  // gaps between the parts must stay zeroed
+  ASSERT_EQ('\0', content[5 << 20]);
+  ASSERT_EQ('\0', content[(6 << 20) + 6]);
+  td::unlink(path).ignore();
+}
+
+TEST(FilePartWriter, error) {
+  td::string path = "file_part_writer_test_missing_dir/file.tmp";
+  std::size_t ok_count = 0;
+  std::size_t error_count = 0;
+  run_file_part_writer(path, {{0, 100}, {100, 100}, {1000, 10}}, ok_count, error_count);
+  ASSERT_EQ(0u, ok_count);
+  ASSERT_EQ(3u, error_count);
+}
@@ -0,0 +1,201 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/DialogId.h"
+#include "td/telegram/files/FileStats.h"
+#include "td/telegram/files/FileStatsIndex.h"
+#include "td/telegram/files/FileType.h"
+
+#include "td/utils/common.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/Slice.h"
+#include "td/utils/tests.h"
+
+#include <algorithm>
+
+static const td::string INDEX_PATH = "file_stats_index_test";
+
+static void destroy_index() {
+  td::unlink(INDEX_PATH + ".bin").ignore();
+  td::unlink(INDEX_PATH + ".log").ignore();
+}
+
+static td::FullFileInfo make_file_info(td::FileType file_type, td::string path, td::int64 owner_dialog_id,
+                                       td::int64 size) {
+  td::FullFileInfo info;
+  info.file_type = file_type;
+  info.path = std::move(path);
+  info.owner_dialog_id = td::DialogId(owner_dialog_id);
+  info.size = size;
+  info.atime_nsec = static_cast<td::uint64>(size) * 1000;
+  info.mtime_nsec = static_cast<td::uint64>(size) * 2000;
+  return info;
+}
+
+static td::vector<td::FullFileInfo> get_index_files(const td::FileStatsIndex &index) {
+  auto files = index.get_file_stats(true, false).get_all_files();
+  std::sort(files.begin(), files.end(),
+            [](const td::FullFileInfo &lhs, const td::FullFileInfo &rhs) { return lhs.path < rhs.path; });
+  return files;
+}
+
+static void check_files(const td::FileStatsIndex &index, const td::vector<td::FullFileInfo> &expected_files) {
+  auto files = get_index_files(index);
+  ASSERT_EQ(expected_files.size(), files.size());
+  for (size_t i = 0; i < files.size(); i++) {
+    ASSERT_TRUE(files[i].file_type == expected_files[i].file_type);
+    ASSERT_EQ(expected_files[i].path, files[i].path);
+    ASSERT_EQ(expected_files[i].owner_dialog_id, files[i].owner_dialog_id);
+    ASSERT_EQ(expected_files[i].size, files[i].size);
+    ASSERT_EQ(expected_files[i].atime_nsec, files[i].atime_nsec);
+    ASSERT_EQ(expected_files[i].mtime_nsec, files[i].mtime_nsec);
+  }
+}
+
+static td::vector<td::FullFileInfo> create_index(double scan_date) {
+  destroy_index();
+  td::vector<td::FullFileInfo> files{make_file_info(td::FileType::Photo, "photos/a.jpg", 100, 1000),
+                                     make_file_info(td::FileType::Video, "videos/b.mp4", 200, 200000),
+                                     make_file_info(td::FileType::Document, "documents/c.txt", 0, 30)};
+  td::FileStatsIndex index;
+  index.init(INDEX_PATH);
+  index.reset(files, scan_date);
+  index.add_file(make_file_info(td::FileType::Audio, "music/d.mp3", 100, 4000));
+  index.add_file(make_file_info(td::FileType::Photo, "photos/a.jpg", 300, 1500));
+  index.remove_file("videos/b.mp4");
+  index.remove_file("videos/unknown.mp4");
+  index.close();
+
+  files[0] = make_file_info(td::FileType::Photo, "photos/a.jpg", 300, 1500);
+  files.erase(files.begin() + 1);
+  files.push_back(make_file_info(td::FileType::Audio, "music/d.mp3", 100, 4000));
+  std::sort(files.begin(), files.end(),
+            [](const td::FullFileInfo &lhs, const td::FullFileInfo &rhs) { return lhs.path < rhs.path; });
+  return files;
+}
+
+TEST(FileStatsIndex, round_trip) {
+  auto files = create_index(12345.5);
+
+  for (int i = 0; i < 2; i++) {
+    // the second load reads the snapshot with the compacted journal
+    td::FileStatsIndex index;
+    index.init(INDEX_PATH);
+    index.load();
+    ASSERT_EQ(12345.5, index.get_scan_date());
+    check_files(index, files);
+    index.close();
+  }
+  ASSERT_TRUE(td::stat(INDEX_PATH + ".log").is_error());
+
+  td::FileStatsIndex index;
+  index.init(INDEX_PATH);
+  index.load();
+  index.destroy();
+  ASSERT_EQ(0.0, index.get_scan_date());
+  ASSERT_TRUE(td::stat(INDEX_PATH + ".bin").is_error());
+  destroy_index();
+}
+
+TEST(FileStatsIndex, not_scanned) {
+  destroy_index();
+  td::FileStatsIndex index;
+  index.init(INDEX_PATH);
+  index.load();
+  ASSERT_EQ(0.0, index.get_scan_date());
+
+  // changes are ignored until the first full scan
+  index.add_file(make_file_info(td::FileType::Photo, "photos/a.jpg", 100, 1000));
+  check_files(index, {});
+  index.close();
+  ASSERT_TRUE(td::stat(INDEX_PATH + ".log").is_error());
+}
+
+TEST(FileStatsIndex, truncated_journal) {
+  destroy_index();
+  auto old_files = create_index(1.0);
+
+  td::FileStatsIndex index;
+  index.init(INDEX_PATH);
+  index.load();
+  index.add_file(make_file_info(td::FileType::Video, "videos/e.mp4", 200, 5000));
+  index.add_file(make_file_info(td::FileType::Video, "videos/f.mp4", 200, 6000));
+  index.close();
+
+  // the last record was written partially
+  auto journal = td::read_file_str(INDEX_PATH + ".log").move_as_ok();
+  td::write_file(INDEX_PATH + ".log", td::Slice(journal).substr(0, journal.size() - 3)).ensure();
+
+  auto files = old_files;
+  files.push_back(make_file_info(td::FileType::Video, "videos/e.mp4", 200, 5000));
+  index.load();
+  ASSERT_EQ(1.0, index.get_scan_date());
+  check_files(index, files);
+  index.close();
+  ASSERT_TRUE(td::stat(INDEX_PATH + ".log").is_error());
+  destroy_index();
+}
+
+TEST(FileStatsIndex, invalid_journal_record) {
+  auto files = create_index(1.0);
+
+  td::FileStatsIndex index;
+  index.init(INDEX_PATH);
+  index.load();
+  index.close();
+
+  // the record has valid length, but invalid content
+  td::string journal(4 + 8, '\xff');
+  journal[0] = '\x08';
+  journal[1] = '\0';
+  journal[2] = '\0';
+  journal[3] = '\0';
+  td::write_file(INDEX_PATH + ".log", journal).ensure();
+
+  index.load();
+  ASSERT_EQ(1.0, index.get_scan_date());
+  check_files(index, files);
+  index.close();
+  destroy_index();
+}
+
+TEST(FileStatsIndex, corrupted_snapshot) {
+  auto check_snapshot = [](td::string snapshot) {
+    td::write_file(INDEX_PATH + ".bin", snapshot).ensure();
+    td::FileStatsIndex index;
+    index.init(INDEX_PATH);
+    index.load();
+    ASSERT_EQ(0.0, index.get_scan_date());
+    check_files(index, {});
+    index.close();
+  };
+
+  create_index(1.0);
+  td::FileStatsIndex index;
+  index.init(INDEX_PATH);
+  index.load();
+  index.close();
+  auto snapshot = td::read_file_str(INDEX_PATH + ".bin").move_as_ok();
+  ASSERT_TRUE(snapshot.size() > 20);
+
+  check_snapshot(snapshot.substr(0, snapshot.size() / 2));
+  check_snapshot(snapshot + "a");
+  check_snapshot(td::string());
+
+  auto wrong_version = snapshot;
+  wrong_version[0] = static_cast<char>(wrong_version[0] + 1);
+  check_snapshot(wrong_version);
+
+  // the file type is stored after is_deleted flag of the first record
+  auto wrong_file_type = snapshot;
+  auto file_type_pos = 4 + 8 + 4 + 4;
+  wrong_file_type[file_type_pos] = '\x7f';
+  check_snapshot(wrong_file_type);
+
+  destroy_index();
+}
@@ -0,0 +1,159 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/LanguagePackSnapshot.h"
+
+#include "td/utils/common.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/FlatHashSet.h"
+#include "td/utils/port/path.h"
+#include "td/utils/Slice.h"
+#include "td/utils/tests.h"
+
+#include <cstring>
+#include <utility>
+
+static const td::string SNAPSHOT_PATH = "language_pack_snapshot_test";
+
+static const char PLURALIZED_VALUE[] = "2zero\0one\0two\0few\0many\0other";
+
+static td::vector<std::pair<td::string, td::string>> get_test_strings() {
+  return {{"key_b", "1value b"},
+          {"key_a", "1value a"},
+          {"plural", td::string(PLURALIZED_VALUE, sizeof(PLURALIZED_VALUE) - 1)},
+          {"deleted", "3"},
+          {"empty", "1"}};
+}
+
+static void check_snapshot(const td::LanguagePackSnapshot &snapshot) {
+  ASSERT_EQ(5u, snapshot.size());
+  td::vector<td::string> keys;
+  for (size_t i = 0; i < snapshot.size(); i++) {
+    keys.push_back(snapshot.get_key(i).str());
+    ASSERT_TRUE(snapshot.get(keys.back()) == snapshot.get_value(i));
+  }
+  ASSERT_TRUE(keys == td::vector<td::string>({"deleted", "empty", "key_a", "key_b", "plural"}));
+  ASSERT_EQ("1value a", snapshot.get("key_a"));
+  ASSERT_EQ("1value b", snapshot.get("key_b"));
+  ASSERT_EQ("1", snapshot.get("empty"));
+  ASSERT_EQ("3", snapshot.get("deleted"));
+  ASSERT_EQ(td::string(PLURALIZED_VALUE, sizeof(PLURALIZED_VALUE) - 1), snapshot.get("plural").str());
+  ASSERT_TRUE(snapshot.get("key").empty());
+  ASSERT_TRUE(snapshot.get("key_c").empty());
+  ASSERT_TRUE(snapshot.get("a").empty());
+  ASSERT_TRUE(snapshot.get("z").empty());
+}
+
+static td::string create_snapshot_file() {
+  td::unlink(SNAPSHOT_PATH).ignore();
+  auto snapshot = td::LanguagePackSnapshot::create(SNAPSHOT_PATH, 5, 7, get_test_strings());
+  CHECK(snapshot != nullptr);
+  return td::read_file_str(SNAPSHOT_PATH).move_as_ok();
+}
+
+static bool can_open_snapshot(const td::string &data) {
+  td::write_file(SNAPSHOT_PATH, data).ensure();
+  return td::LanguagePackSnapshot::open(SNAPSHOT_PATH, 5, 7).is_ok();
+}
+
+TEST(LanguagePackSnapshot, round_trip) {
+  td::unlink(SNAPSHOT_PATH).ignore();
+  ASSERT_TRUE(td::LanguagePackSnapshot::open(SNAPSHOT_PATH, 5, 7).is_error());
+
+  auto snapshot = td::LanguagePackSnapshot::create(SNAPSHOT_PATH, 5, 7, get_test_strings());
+  check_snapshot(*snapshot);
+  snapshot = nullptr;
+
+  auto r_snapshot = td::LanguagePackSnapshot::open(SNAPSHOT_PATH, 5, 7);
+  ASSERT_TRUE(r_snapshot.is_ok());
+  check_snapshot(*r_snapshot.ok());
+  td::unlink(SNAPSHOT_PATH).ignore();
+
+  // the snapshot is kept in memory if the file can't be written
+  snapshot = td::LanguagePackSnapshot::create("language_pack_snapshot_test_missing_dir/snapshot", 5, 7,
+                                              get_test_strings());
+  check_snapshot(*snapshot);
+
+  snapshot = td::LanguagePackSnapshot::create(SNAPSHOT_PATH, 1, 0, {});
+  ASSERT_EQ(0u, snapshot->size());
+  ASSERT_TRUE(snapshot->get("key_a").empty());
+  ASSERT_TRUE(td::LanguagePackSnapshot::open(SNAPSHOT_PATH, 1, 0).is_ok());
+  td::unlink(SNAPSHOT_PATH).ignore();
+}
+
+TEST(LanguagePackSnapshot, wrong_version) {
+  create_snapshot_file();
+  ASSERT_TRUE(td::LanguagePackSnapshot::open(SNAPSHOT_PATH, 5, 7).is_ok());
+  ASSERT_TRUE(td::LanguagePackSnapshot::open(SNAPSHOT_PATH, 6, 7).is_error());
+  ASSERT_TRUE(td::LanguagePackSnapshot::open(SNAPSHOT_PATH, 4, 7).is_error());
+  ASSERT_TRUE(td::LanguagePackSnapshot::open(SNAPSHOT_PATH, 5, 8).is_error());
+  ASSERT_TRUE(td::LanguagePackSnapshot::open(SNAPSHOT_PATH, 5, 6).is_error());
+
+  auto data = create_snapshot_file();
+  auto wrong_magic = data;
+  wrong_magic[0] = 'X';
+  ASSERT_TRUE(!can_open_snapshot(wrong_magic));
+
+  auto wrong_format_version = data;
+  wrong_format_version[4] = static_cast<char>(wrong_format_version[4] + 1);
+  ASSERT_TRUE(!can_open_snapshot(wrong_format_version));
+  td::unlink(SNAPSHOT_PATH).ignore();
+}
+
+TEST(LanguagePackSnapshot, truncated) {
+  auto data = create_snapshot_file();
+  ASSERT_TRUE(can_open_snapshot(data));
+  ASSERT_TRUE(!can_open_snapshot(td::string()));
+  for (size_t size : {static_cast<size_t>(10), static_cast<size_t>(20), static_cast<size_t>(50), data.size() / 2,
+                      data.size() - 1}) {
+    ASSERT_TRUE(!can_open_snapshot(data.substr(0, size)));
+  }
+  td::unlink(SNAPSHOT_PATH).ignore();
+}
+
+TEST(LanguagePackSnapshot, unsorted_keys) {
+  auto data = create_snapshot_file();
+
+  // swap the first two entries, which are stored right after the 20-byte header
+  const size_t header_size = 20;
+  const size_t entry_size = 16;
+  auto unsorted = data;
+  std::memcpy(&unsorted[header_size], data.data() + header_size + entry_size, entry_size);
+  std::memcpy(&unsorted[header_size + entry_size], data.data() + header_size, entry_size);
+  ASSERT_TRUE(!can_open_snapshot(unsorted));
+
+  // duplicate keys aren't allowed too
+  auto duplicate = data;
+  std::memcpy(&duplicate[header_size + entry_size], data.data() + header_size, entry_size);
+  ASSERT_TRUE(!can_open_snapshot(duplicate));
+  td::unlink(SNAPSHOT_PATH).ignore();
+}
+
+TEST(LanguagePackSnapshot, get_visible) {
+  auto snapshot = td::LanguagePackSnapshot::create(SNAPSHOT_PATH, 5, 7, get_test_strings());
+  td::unlink(SNAPSHOT_PATH).ignore();
+
+  td::FlatHashSet<td::string> deleted_strings;
+  auto has_newer_string = [&deleted_strings](const td::string &key) {
+    return deleted_strings.count(key) != 0;
+  };
+  ASSERT_EQ("1value a", snapshot->get_visible("key_a", has_newer_string));
+  ASSERT_EQ("1", snapshot->get_visible("empty", has_newer_string));
+  ASSERT_TRUE(!snapshot->get_visible("plural", has_newer_string).empty());
+  ASSERT_TRUE(snapshot->get_visible("deleted", has_newer_string).empty());
+  ASSERT_TRUE(snapshot->get_visible("unknown", has_newer_string).empty());
+
+  deleted_strings.insert("key_a");
+  deleted_strings.insert("plural");
+  deleted_strings.insert("unknown");
+  ASSERT_TRUE(snapshot->get_visible("key_a", has_newer_string).empty());
+  ASSERT_TRUE(snapshot->get_visible("plural", has_newer_string).empty());
+  ASSERT_TRUE(snapshot->get_visible("unknown", has_newer_string).empty());
+  ASSERT_EQ("1value b", snapshot->get_visible("key_b", has_newer_string));
+
+  // the snapshot itself is unchanged
+  check_snapshot(*snapshot);
+}
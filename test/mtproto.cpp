@@ -20,7 +20,9 @@
 #include "td/mtproto/ProxySecret.h"
 #include "td/mtproto/RawConnection.h"
 #include "td/mtproto/RSA.h"
+#include "td/mtproto/TcpTransport.h"
 #include "td/mtproto/TlsInit.h"
+#include "td/mtproto/TlsReaderByteFlow.h"
 #include "td/mtproto/TransportType.h"
 
 #include "td/net/GetHostByNameActor.h"
@@ -31,7 +33,9 @@
 #include "td/actor/ConcurrentScheduler.h"
 
 #include "td/utils/base64.h"
+#include "td/utils/buffer.h"
 #include "td/utils/BufferedFd.h"
+#include "td/utils/ByteFlow.h"
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
 #include "td/utils/HttpDate.h"
@@ -723,6 +727,56 @@ TEST(Mtproto, TlsTransport) {
   sched.finish();
 }
 
+TEST(Mtproto, TlsRecords) {
+  auto secret = td::mtproto::ProxySecret::from_binary("\xee"
+                                                      "0123456789secret"
+                                                      "www.google.com")
+                    .move_as_ok();
+  td::ChainBufferWriter input_writer;
+  auto input = input_writer.extract_reader();
+  td::ChainBufferWriter output_writer;
+  auto output = output_writer.extract_reader();
+  td::mtproto::tcp::ObfuscatedTransport transport(2, secret);
+  transport.init(&input, &output_writer);
+  for (size_t message_size : {16, 2800, 2900, 10000, 100000, 32}) {
+    td::BufferWriter message(message_size, transport.max_prepend_size(), transport.max_append_size());
+    message.as_mutable_slice().fill('a');
+    transport.write(std::move(message), false);
+  }
+
+  output.sync_with_writer();
+  auto data = output.move_as_buffer_slice().as_slice().str();
+  ASSERT_EQ(td::Slice("\x14\x03\x03\x00\x01\x01", 6), td::Slice(data).substr(0, 6));
+  td::Slice records = td::Slice(data).substr(6);
+
+  td::string payload;
+  td::Slice left = records;
+  while (!left.empty()) {
+    ASSERT_TRUE(left.size() >= 5);
+    ASSERT_EQ("\x17\x03\x03", left.substr(0, 3));
+    size_t length = (static_cast<td::uint8>(left[3]) << 8) | static_cast<td::uint8>(left[4]);
+    ASSERT_TRUE(length <= 2878);
+    ASSERT_TRUE(left.size() >= 5 + length);
+    payload += left.substr(5, length).str();
+    left.remove_prefix(5 + length);
+  }
+
+  td::ChainBufferWriter reader_input_writer;
+  auto reader_input = reader_input_writer.extract_reader();
+  td::ByteFlowSource source(&reader_input);
+  td::mtproto::TlsReaderByteFlow tls_reader;
+  td::ByteFlowSink sink;
+  source >> tls_reader >> sink;
+  for (auto &part : td::rand_split(records)) {
+    reader_input_writer.append(part);
+    source.wakeup();
+  }
+  source.close_input(td::Status::OK());
+  ASSERT_TRUE(sink.is_ready());
+  ASSERT_TRUE(sink.status().is_ok());
+  ASSERT_EQ(payload, sink.result()->move_as_buffer_slice().as_slice().str());
+}
+
 TEST(Mtproto, RSA) {
   auto pem = td::Slice(
       "-----BEGIN RSA PUBLIC KEY-----\n"
@@ -0,0 +1,110 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/NetQueryDeduplicator.h"
+#include "td/telegram/net/NetQueryRateModel.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Status.h"
+#include "td/utils/tests.h"
+
+static bool is_close(double lhs, double rhs) {
+  return lhs - rhs < 1e-9 && rhs - lhs < 1e-9;
+}
+
+TEST(NetQueryRateModel, flood_wait) {
+  td::NetQueryRateModel model;
+  const td::int32 method = 0x12345678;
+  const td::int32 other_method = 0x23456789;
+  ASSERT_TRUE(is_close(0.0, model.get_send_delay(method, 100.0)));
+
+  model.on_flood_wait(method, 10, 100.0);
+  ASSERT_TRUE(is_close(0.0, model.get_send_delay(other_method, 100.0)));
+
+  // queries are blocked until the flood wait ends and are paced after that
+  ASSERT_TRUE(is_close(10.0, model.get_send_delay(method, 100.0)));
+  ASSERT_TRUE(is_close(10.5, model.get_send_delay(method, 100.0)));
+  ASSERT_TRUE(is_close(1.0, model.get_send_delay(method, 110.0)));
+  ASSERT_TRUE(is_close(0.0, model.get_send_delay(method, 200.0)));
+  ASSERT_TRUE(is_close(0.5, model.get_send_delay(method, 200.0)));
+}
+
+TEST(NetQueryRateModel, interval) {
+  td::NetQueryRateModel model;
+  const td::int32 method = 0x12345678;
+
+  model.on_flood_wait(method, 1, 0.0);
+  model.on_flood_wait(method, 1, 0.0);
+  ASSERT_TRUE(is_close(0.0, model.get_send_delay(method, 1.0)));
+  ASSERT_TRUE(is_close(2 * td::NetQueryRateModel::INITIAL_INTERVAL, model.get_send_delay(method, 1.0)));
+
+  for (int i = 0; i < 10; i++) {
+    model.on_flood_wait(method, 1, 100.0);
+  }
+  ASSERT_TRUE(is_close(0.0, model.get_send_delay(method, 1000.0)));
+  ASSERT_TRUE(is_close(td::NetQueryRateModel::MAX_INTERVAL, model.get_send_delay(method, 1000.0)));
+
+  // the interval shrinks after each successful query until the pacing is stopped
+  for (int i = 0; i < 124; i++) {
+    model.on_query_ok(method, 1e4);
+  }
+  ASSERT_TRUE(is_close(0.0, model.get_send_delay(method, 1e4)));
+  ASSERT_TRUE(model.get_send_delay(method, 1e4) > td::NetQueryRateModel::MIN_INTERVAL);
+  model.on_query_ok(method, 2e4);
+  ASSERT_TRUE(is_close(0.0, model.get_send_delay(method, 3e4)));
+  ASSERT_TRUE(is_close(0.0, model.get_send_delay(method, 3e4)));
+}
+
+TEST(NetQueryDeduplicator, identical_queries) {
+  using Query = td::Promise<td::string>;
+  td::DeduplicatedQueries<Query> queries;
+  td::vector<td::string> results;
+  auto create_query = [&results](size_t query_id) {
+    return td::PromiseCreator::lambda([&results, query_id](td::Result<td::string> result) {
+      if (results.size() <= query_id) {
+        results.resize(query_id + 1);
+      }
+      results[query_id] = result.is_ok() ? result.move_as_ok() : "error";
+    });
+  };
+
+  auto first_query = create_query(0);
+  auto first_id = queries.add_query("key", first_query);
+  ASSERT_TRUE(first_id != 0);
+
+  auto second_query = create_query(1);
+  ASSERT_EQ(0u, queries.add_query("key", second_query));
+
+  auto other_query = create_query(2);
+  auto other_id = queries.add_query("other key", other_query);
+  ASSERT_TRUE(other_id != 0);
+  ASSERT_TRUE(other_id != first_id);
+
+  // only the first query is sent, and its result is copied to the identical query
+  first_query.set_value("result");
+  auto waiting_queries = queries.on_query_result(first_id);
+  ASSERT_EQ(1u, waiting_queries.size());
+  for (auto &query : waiting_queries) {
+    query.set_value("result");
+  }
+  ASSERT_EQ("result", results[0]);
+  ASSERT_EQ("result", results[1]);
+  ASSERT_TRUE(queries.on_query_result(first_id).empty());
+
+  // a query, which is added after the result is received, is sent anew
+  auto third_query = create_query(3);
+  auto third_id = queries.add_query("key", third_query);
+  ASSERT_TRUE(third_id != 0);
+  ASSERT_TRUE(third_id != first_id);
+
+  auto fourth_query = create_query(4);
+  ASSERT_EQ(0u, queries.add_query("other key", fourth_query));
+  auto cleared_queries = queries.clear();
+  ASSERT_EQ(1u, cleared_queries.size());
+  ASSERT_TRUE(queries.on_query_result(other_id).empty());
+  ASSERT_TRUE(queries.on_query_result(third_id).empty());
+}
@@ -0,0 +1,237 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "NetworkEmulator.h"
+
+#include "td/net/TcpListener.h"
+
+#include "td/actor/actor.h"
+#include "td/actor/ConcurrentScheduler.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/BufferedFd.h"
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/port/IPAddress.h"
+#include "td/utils/port/SocketFd.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+#include "td/utils/tests.h"
+#include "td/utils/Time.h"
+
+class EchoConnection final : public td::Actor {
+ public:
+  explicit EchoConnection(td::SocketFd fd) : fd_(std::move(fd)) {
+  }
+
+ private:
+  td::BufferedFd<td::SocketFd> fd_;
+
+  void start_up() final {
+    td::Scheduler::subscribe(fd_.get_poll_info().extract_pollable_fd(this));
+  }
+
+  void tear_down() final {
+    td::Scheduler::unsubscribe_before_close(fd_.get_poll_info().get_pollable_fd_ref());
+    fd_.close();
+  }
+
+  void hangup() final {
+    stop();
+  }
+
+  void loop() final {
+    td::sync_with_poll(fd_);
+    auto status = fd_.flush_read();
+    if (status.is_ok()) {
+      fd_.output_buffer().append(fd_.input_buffer().cut_head(fd_.input_buffer().size()));
+      status = fd_.flush_write();
+    }
+    if (status.is_error() || td::can_close_local(fd_)) {
+      stop();
+    }
+  }
+};
+
+class EchoServer final : public td::TcpListener::Callback {
+ public:
+  explicit EchoServer(int port) : port_(port) {
+  }
+
+  void accept(td::SocketFd fd) final {
+    connections_.push_back(td::create_actor<EchoConnection>("EchoConnection", std::move(fd)));
+  }
+
+ private:
+  int port_;
+  td::ActorOwn<td::TcpListener> listener_;
+  td::vector<td::ActorOwn<EchoConnection>> connections_;
+
+  void start_up() final {
+    listener_ = td::create_actor<td::TcpListener>("EchoServerListener", port_, actor_shared(this), "127.0.0.1");
+  }
+
+  void hangup() final {
+    listener_.reset();
+    connections_.clear();
+    stop();
+  }
+};
+
+// sends data through the emulator, checks that the same data is echoed back and closes the connection
+class EchoClient final : public td::Actor {
+ public:
+  EchoClient(td::IPAddress address, td::string data, td::Promise<double> promise)
+      : address_(std::move(address)), data_(std::move(data)), promise_(std::move(promise)) {
+  }
+
+ private:
+  td::IPAddress address_;
+  td::string data_;
+  td::Promise<double> promise_;
+  td::BufferedFd<td::SocketFd> fd_;
+  td::string received_;
+  double start_time_ = 0.0;
+
+  void start_up() final {
+    start_time_ = td::Time::now();
+    auto r_fd = td::SocketFd::open(address_);
+    if (r_fd.is_error()) {
+      promise_.set_error(r_fd.move_as_error());
+      return stop();
+    }
+    fd_ = td::BufferedFd<td::SocketFd>(r_fd.move_as_ok());
+    td::Scheduler::subscribe(fd_.get_poll_info().extract_pollable_fd(this));
+    fd_.output_buffer().append(td::Slice(data_));
+    loop();
+  }
+
+  void tear_down() final {
+    if (!fd_.empty()) {
+      td::Scheduler::unsubscribe_before_close(fd_.get_poll_info().get_pollable_fd_ref());
+      fd_.close();
+    }
+  }
+
+  void loop() final {
+    auto status = [&] {
+      td::sync_with_poll(fd_);
+      TRY_STATUS(fd_.flush_read());
+      received_ += fd_.input_buffer().cut_head(fd_.input_buffer().size()).move_as_buffer_slice().as_slice().str();
+      TRY_STATUS(fd_.flush_write());
+      if (td::can_close_local(fd_)) {
+        return td::Status::Error("Connection closed");
+      }
+      return td::Status::OK();
+    }();
+    if (status.is_error()) {
+      promise_.set_error(std::move(status));
+      return stop();
+    }
+    if (received_.size() >= data_.size()) {
+      if (received_ != data_) {
+        promise_.set_error(td::Status::Error("Received wrong data"));
+      } else {
+        promise_.set_value(td::Time::now() - start_time_);
+      }
+      return stop();
+    }
+  }
+};
+
+class NetworkEmulatorTest final : public td::Actor {
+ public:
+  NetworkEmulatorTest(int port, td::NetworkProfile profile, int connection_count)
+      : port_(port), profile_(std::move(profile)), connection_count_(connection_count) {
+  }
+
+ private:
+  int port_;
+  td::NetworkProfile profile_;
+  int connection_count_;
+  td::ActorOwn<EchoServer> server_;
+  td::ActorOwn<td::NetworkEmulator> emulator_;
+  td::ActorOwn<EchoClient> client_;
+  bool is_client_finished_ = true;
+
+  void start_up() final {
+    server_ = td::create_actor<EchoServer>("EchoServer", port_);
+    td::IPAddress server_address;
+    server_address.init_ipv4_port("127.0.0.1", port_).ensure();
+    emulator_ = td::create_actor<td::NetworkEmulator>("NetworkEmulator", port_ + 1, server_address, profile_,
+                                                      td::ActorShared<>());
+    // give the listeners time to start
+    set_timeout_in(0.1);
+  }
+
+  void timeout_expired() final {
+    if (!is_client_finished_) {
+      return;
+    }
+    if (emulator_.get_actor_unsafe()->get_connection_count() != 0) {
+      // the closed connection hasn't been pruned yet
+      set_timeout_in(0.01);
+      return;
+    }
+    if (connection_count_-- == 0) {
+      client_.reset();
+      emulator_.reset();
+      server_.reset();
+      td::Scheduler::instance()->finish();
+      return stop();
+    }
+
+    td::string data(100000, '\0');
+    for (size_t i = 0; i < data.size(); i++) {
+      data[i] = static_cast<char>(i * 7 + connection_count_);
+    }
+    td::IPAddress emulator_address;
+    emulator_address.init_ipv4_port("127.0.0.1", port_ + 1).ensure();
+    is_client_finished_ = false;
+    client_ = td::create_actor<EchoClient>(
+        "EchoClient", emulator_address, std::move(data),
+        td::PromiseCreator::lambda([actor_id = actor_id(this)](td::Result<double> r_time) {
+          send_closure(actor_id, &NetworkEmulatorTest::on_client_finished, std::move(r_time));
+        }));
+  }
+
+  void on_client_finished(td::Result<double> r_time) {
+    LOG_IF(FATAL, r_time.is_error()) << r_time.error();
+    // the data must be delayed at least by the round-trip time
+    ASSERT_TRUE(r_time.ok() >= profile_.round_trip_time);
+    client_.reset();
+    is_client_finished_ = true;
+    set_timeout_in(0.01);
+  }
+};
+
+static void run_network_emulator_test(int port, td::NetworkProfile profile) {
+  td::ConcurrentScheduler scheduler(0, 0);
+  scheduler.create_actor_unsafe<NetworkEmulatorTest>(0, "NetworkEmulatorTest", port, std::move(profile), 3).release();
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+}
+
+TEST(NetworkEmulator, echo) {
+  auto profile = td::NetworkProfile::datacenter();
+  profile.round_trip_time = 0.05;
+  run_network_emulator_test(20110, std::move(profile));
+}
+
+TEST(NetworkEmulator, loss_and_reordering) {
+  td::NetworkProfile profile;
+  profile.name = "lossy";
+  profile.round_trip_time = 0.02;
+  profile.jitter = 0.01;
+  profile.bandwidth = 10e6;
+  profile.loss_probability = 0.1;
+  profile.reorder_probability = 0.1;
+  run_network_emulator_test(20120, std::move(profile));
+}
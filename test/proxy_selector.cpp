@@ -0,0 +1,143 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/ProxySelector.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Status.h"
+#include "td/utils/tests.h"
+
+#include <map>
+
+static td::ProxySelector::ProbeInfo get_probe_info(td::int32 success_count, td::int32 consecutive_failure_count,
+                                                   double average_rtt) {
+  td::ProxySelector::ProbeInfo info;
+  info.probe_count = success_count + consecutive_failure_count;
+  info.success_count = success_count;
+  info.consecutive_failure_count = consecutive_failure_count;
+  info.average_rtt = average_rtt;
+  info.last_rtt = average_rtt;
+  return info;
+}
+
+TEST(ProxySelector, rank_proxies) {
+  std::map<td::int32, td::ProxySelector::ProbeInfo> probe_infos;
+  probe_infos[1] = get_probe_info(5, 0, 0.3);
+  probe_infos[2] = get_probe_info(1, 1, 0.1);
+  probe_infos[3] = get_probe_info(5, 2, 0.05);  // failed twice in a row
+  probe_infos[4] = get_probe_info(0, 1, 0.0);   // never answered
+  probe_infos[5] = get_probe_info(3, 0, 0.2);
+  ASSERT_EQ(td::vector<td::int32>({2, 5, 1}), td::ProxySelector::rank_proxies(probe_infos));
+}
+
+TEST(ProxySelector, choose_proxy) {
+  const double OLD_SWITCH = td::ProxySelector::MIN_SWITCH_INTERVAL;
+  std::map<td::int32, td::ProxySelector::ProbeInfo> probe_infos;
+  probe_infos[1] = get_probe_info(10, 0, 0.6);
+  probe_infos[2] = get_probe_info(3, 0, 0.3);
+  auto choose = [&probe_infos](td::int32 active_proxy_id, double time_since_last_switch) {
+    return td::ProxySelector::choose_proxy(probe_infos, active_proxy_id, time_since_last_switch);
+  };
+
+  ASSERT_EQ(2, choose(1, OLD_SWITCH));
+  ASSERT_EQ(0, choose(2, OLD_SWITCH));
+  ASSERT_EQ(0, choose(0, OLD_SWITCH));  // direct connection is never replaced
+  ASSERT_EQ(0, choose(3, OLD_SWITCH));  // the active proxy has no measurements yet
+
+  // the switch needs 10 minutes to pass since the previous switch
+  ASSERT_EQ(0, choose(1, OLD_SWITCH - 1));
+  ASSERT_EQ(0, choose(1, 0.0));
+
+  // the best proxy needs enough successful probes
+  probe_infos[2].success_count = td::ProxySelector::MIN_SWITCH_SUCCESS_COUNT - 1;
+  ASSERT_EQ(0, choose(1, OLD_SWITCH));
+  probe_infos[2].success_count = td::ProxySelector::MIN_SWITCH_SUCCESS_COUNT;
+
+  // the RTT must be at least 1.5 times lower
+  probe_infos[2].average_rtt = 0.41;
+  ASSERT_EQ(0, choose(1, OLD_SWITCH));
+  probe_infos[2].average_rtt = 0.39;
+  ASSERT_EQ(2, choose(1, OLD_SWITCH));
+
+  // and at least 50 ms lower
+  probe_infos[1].average_rtt = 0.09;
+  probe_infos[2].average_rtt = 0.05;
+  ASSERT_EQ(0, choose(1, OLD_SWITCH));
+  probe_infos[2].average_rtt = 0.03;
+  ASSERT_EQ(2, choose(1, OLD_SWITCH));
+
+  // a failed probe of the active proxy isn't enough to switch
+  probe_infos[1] = get_probe_info(10, 1, 0.6);
+  probe_infos[2] = get_probe_info(1, 0, 0.5);
+  ASSERT_EQ(0, choose(1, 0.0));
+
+  // a dead active proxy is replaced at once with the best available proxy
+  probe_infos[1] = get_probe_info(10, td::ProxySelector::MAX_PROBE_FAILURES, 0.1);
+  ASSERT_EQ(2, choose(1, 0.0));
+  probe_infos[3] = get_probe_info(1, 0, 0.4);
+  ASSERT_EQ(3, choose(1, 0.0));
+  probe_infos[3].consecutive_failure_count = td::ProxySelector::MAX_PROBE_FAILURES;
+  probe_infos[2].consecutive_failure_count = td::ProxySelector::MAX_PROBE_FAILURES;
+  ASSERT_EQ(0, choose(1, 0.0));
+}
+
+TEST(ProxySelector, probe_rounds) {
+  td::ProxySelector selector;
+  auto round = selector.start_probe_round({1, 2, 3}, 100);
+  ASSERT_TRUE(selector.on_probe_result(1, round, 0.5, 101));
+  ASSERT_TRUE(selector.on_probe_result(2, round, td::Status::Error("Failed"), 102));
+  ASSERT_TRUE(!selector.on_probe_result(1, round, 0.1, 103));  // the probe has already finished
+  ASSERT_TRUE(!selector.on_probe_result(4, round, 0.1, 103));  // the proxy wasn't probed
+
+  auto info = selector.get_probe_info(1);
+  ASSERT_EQ(1, info.probe_count);
+  ASSERT_EQ(1, info.success_count);
+  ASSERT_EQ(101, info.last_probe_date);
+  ASSERT_EQ(0.5, info.average_rtt);
+  ASSERT_EQ(1, selector.get_probe_info(2).consecutive_failure_count);
+  ASSERT_EQ(0, selector.get_probe_info(3).probe_count);
+
+  // the unfinished probe of the previous round is counted as failed, and its late result is ignored
+  auto new_round = selector.start_probe_round({1, 2, 3}, 200);
+  ASSERT_TRUE(new_round != round);
+  ASSERT_EQ(1, selector.get_probe_info(3).probe_count);
+  ASSERT_EQ(1, selector.get_probe_info(3).consecutive_failure_count);
+  ASSERT_TRUE(!selector.on_probe_result(3, round, 0.01, 201));
+  ASSERT_TRUE(selector.on_probe_result(3, new_round, 0.2, 202));
+  ASSERT_EQ(0, selector.get_probe_info(3).consecutive_failure_count);
+
+  ASSERT_TRUE(selector.on_probe_result(1, new_round, 1.0, 203));
+  info = selector.get_probe_info(1);
+  ASSERT_EQ(2, info.success_count);
+  ASSERT_EQ(1.0, info.last_rtt);
+  ASSERT_TRUE(info.average_rtt > 0.5 && info.average_rtt < 1.0);
+
+  ASSERT_TRUE(selector.on_probe_result(2, new_round, td::Status::Error("Failed"), 204));
+  ASSERT_TRUE(!td::ProxySelector::is_proxy_available(selector.get_probe_info(2)));
+  ASSERT_EQ(td::vector<td::int32>({3, 1}), selector.get_ranked_proxy_ids());
+
+  // failure streaks are forgotten after a network change
+  selector.on_network_changed();
+  ASSERT_EQ(0, selector.get_probe_info(2).consecutive_failure_count);
+  ASSERT_TRUE(!td::ProxySelector::is_proxy_available(selector.get_probe_info(2)));
+
+  selector.remove_proxy(3);
+  ASSERT_EQ(0, selector.get_probe_info(3).probe_count);
+  ASSERT_EQ(td::vector<td::int32>({1}), selector.get_ranked_proxy_ids());
+}
+
+TEST(ProxySelector, switch_interval) {
+  td::ProxySelector selector;
+  for (int i = 0; i < 3; i++) {
+    auto round = selector.start_probe_round({1, 2}, i);
+    selector.on_probe_result(1, round, 0.6, i);
+    selector.on_probe_result(2, round, 0.2, i);
+  }
+  selector.on_proxy_switched(1000.0);
+  ASSERT_EQ(0, selector.choose_proxy(1, 1000.0 + td::ProxySelector::MIN_SWITCH_INTERVAL - 1));
+  ASSERT_EQ(2, selector.choose_proxy(1, 1000.0 + td::ProxySelector::MIN_SWITCH_INTERVAL));
+  ASSERT_EQ(0, selector.choose_proxy(2, 1000.0 + td::ProxySelector::MIN_SWITCH_INTERVAL));
+}
@@ -0,0 +1,111 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/AdaptiveResourceLimit.h"
+
+#include "td/utils/common.h"
+#include "td/utils/misc.h"
+#include "td/utils/tests.h"
+
+#include <cmath>
+
+// simulates one sample period of a link with the given capacity and round-trip time
+static bool run_link_period(td::AdaptiveResourceLimit &limit, double &now, double capacity, double rtt) {
+  auto in_flight = static_cast<double>(limit.get_limit());
+  auto bandwidth = td::min(in_flight / rtt, capacity);
+  auto delay = td::max(rtt, in_flight / capacity);
+  limit.on_transferred(static_cast<td::int64>(bandwidth * td::AdaptiveResourceLimit::SAMPLE_PERIOD));
+  limit.on_delay(delay);
+  now += td::AdaptiveResourceLimit::SAMPLE_PERIOD;
+  return limit.update(now);
+}
+
+TEST(AdaptiveResourceLimit, no_samples) {
+  td::AdaptiveResourceLimit limit(1 << 21);
+  ASSERT_TRUE(!limit.update(1.0));
+  ASSERT_TRUE(!limit.update(1.5));
+  ASSERT_TRUE(!limit.update(10.0));
+  limit.on_transferred(1 << 20);
+  ASSERT_TRUE(!limit.update(20.0));
+  limit.on_delay(0.1);
+  ASSERT_TRUE(!limit.update(30.0));
+  ASSERT_EQ(1 << 21, limit.get_limit());
+}
+
+static bool is_close(td::int64 limit, double expected_limit) {
+  return std::fabs(static_cast<double>(limit) - expected_limit) < expected_limit * 0.01;
+}
+
+TEST(AdaptiveResourceLimit, growth) {
+  td::AdaptiveResourceLimit limit(1 << 20);
+  double now = 1.0;
+  limit.update(now);
+
+  // while the link isn't saturated, the limit doubles every period
+  double capacity = 64 << 20;
+  double rtt = 0.1;
+  ASSERT_TRUE(run_link_period(limit, now, capacity, rtt));
+  ASSERT_EQ(2 << 20, limit.get_limit());
+  ASSERT_TRUE(run_link_period(limit, now, capacity, rtt));
+  ASSERT_EQ(4 << 20, limit.get_limit());
+
+  // then it stops at twice the bandwidth-delay product and stays there
+  for (int i = 0; i < 100; i++) {
+    run_link_period(limit, now, capacity, rtt);
+    if (i >= 10) {
+      auto expected_limit = 2 * capacity * rtt;
+      if (limit.get_limit() < expected_limit / 2) {
+        expected_limit /= 4;  // probe
+      }
+      ASSERT_TRUE(is_close(limit.get_limit(), expected_limit));
+    }
+  }
+}
+
+TEST(AdaptiveResourceLimit, shrink) {
+  td::AdaptiveResourceLimit limit(64 << 20);
+  double now = 1.0;
+  limit.update(now);
+
+  // the link is saturated and the delay is increased by queueing, so only probes can reveal the real delay
+  double capacity = 8 << 20;
+  double rtt = 0.2;
+  for (int i = 0; i < 101; i++) {
+    run_link_period(limit, now, capacity, rtt);
+  }
+  ASSERT_TRUE(is_close(limit.get_limit(), 2 * capacity * rtt));
+
+  // the bandwidth drops; old samples must expire
+  capacity = 4 << 20;
+  for (size_t i = 0; i < td::AdaptiveResourceLimit::SAMPLE_COUNT + 1; i++) {
+    run_link_period(limit, now, capacity, rtt);
+  }
+  ASSERT_TRUE(is_close(limit.get_limit(), 2 * capacity * rtt));
+}
+
+TEST(AdaptiveResourceLimit, cap) {
+  td::AdaptiveResourceLimit limit(1 << 20);
+  double now = 1.0;
+  limit.update(now);
+
+  for (int i = 0; i < 9; i++) {
+    run_link_period(limit, now, 1e12, 1.0);
+  }
+  ASSERT_EQ(td::AdaptiveResourceLimit::MAX_LIMIT, limit.get_limit());
+
+  // the bandwidth-delay product of the link is much less than the minimum limit
+  td::AdaptiveResourceLimit slow_limit(1 << 20);
+  slow_limit.update(now);
+  bool was_min_limit = false;
+  for (int i = 0; i < 100; i++) {
+    run_link_period(slow_limit, now, 1000.0, 0.001);
+    ASSERT_TRUE(slow_limit.get_limit() >= td::AdaptiveResourceLimit::MIN_LIMIT);
+    if (slow_limit.get_limit() == td::AdaptiveResourceLimit::MIN_LIMIT) {
+      was_min_limit = true;
+    }
+  }
+  ASSERT_TRUE(was_min_limit);
+}
@@ -0,0 +1,66 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/SharedServerDataCache.h"
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/tests.h"
+
+TEST(SharedServerDataCache, get_set) {
+  td::SharedServerDataCache cache;
+  ASSERT_TRUE(cache.get("key") == nullptr);
+
+  cache.set("key", 123, "data");
+  auto value = cache.get("key");
+  ASSERT_TRUE(value != nullptr);
+  ASSERT_EQ(123, value->hash_);
+  ASSERT_EQ("data", value->data_);
+  ASSERT_TRUE(value->receive_time_ > 0);
+  ASSERT_TRUE(cache.get("other_key") == nullptr);
+
+  // the previously returned value isn't changed by the update
+  cache.set("key", 456, "new data");
+  ASSERT_EQ(123, value->hash_);
+  ASSERT_EQ("data", value->data_);
+  auto new_value = cache.get("key");
+  ASSERT_EQ(456, new_value->hash_);
+  ASSERT_EQ("new data", new_value->data_);
+}
+
+TEST(SharedServerDataCache, isolation) {
+  td::SharedServerDataCache first_cache;
+  td::SharedServerDataCache second_cache;
+  first_cache.set("key", 1, "first");
+  ASSERT_TRUE(second_cache.get("key") == nullptr);
+  second_cache.set("key", 2, "second");
+  ASSERT_EQ("first", first_cache.get("key")->data_);
+  ASSERT_EQ("second", second_cache.get("key")->data_);
+}
+
+TEST(SharedServerDataCache, threads) {
+  td::SharedServerDataCache cache;
+  td::vector<td::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&cache, i] {
+      for (int j = 0; j < 1000; j++) {
+        auto key = td::to_string(j % 10);
+        cache.set(key, i, key);
+        auto value = cache.get(key);
+        CHECK(value != nullptr);
+        CHECK(value->data_ == key);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int j = 0; j < 10; j++) {
+    ASSERT_EQ(td::to_string(j), cache.get(td::to_string(j))->data_);
+  }
+}
@@ -0,0 +1,79 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/StickerSetId.h"
+#include "td/telegram/StickerSetSearchIndex.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/common.h"
+#include "td/utils/tests.h"
+
+#include <algorithm>
+
+static td::StickerSetId get_sticker_set_id(td::int64 sticker_set_id) {
+  return td::StickerSetId(sticker_set_id);
+}
+
+static td::vector<td::int64> search(const td::StickerSetSearchIndex &index, const td::vector<td::string> &emojis,
+                                    td::Slice query) {
+  auto result = td::transform(index.search(emojis, query), [](td::StickerSetId id) { return id.get(); });
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+TEST(StickerSetSearchIndex, search) {
+  td::StickerSetSearchIndex index;
+  ASSERT_TRUE(search(index, {"a"}, "a").empty());
+
+  index.add_sticker_set(get_sticker_set_id(1), {"e1", "e2", "e2"}, {"cat", "dog"});
+  index.add_sticker_set(get_sticker_set_id(2), {"e2", "e3"}, {"category", "", "dolphin"});
+  index.add_sticker_set(get_sticker_set_id(3), {}, {"cow"});
+  index.add_sticker_set(get_sticker_set_id(4), {}, {});
+  ASSERT_EQ(3u, index.get_emoji_count());
+  ASSERT_EQ(5u, index.get_keyword_count());
+
+  using Ids = td::vector<td::int64>;
+  ASSERT_EQ(Ids({1}), search(index, {"e1"}, ""));
+  ASSERT_EQ(Ids({1, 2}), search(index, {"e2"}, ""));
+  ASSERT_EQ(Ids({1, 2}), search(index, {"e1", "e3"}, ""));
+  ASSERT_EQ(Ids(), search(index, {"e4", ""}, ""));
+  ASSERT_EQ(Ids({1, 2}), search(index, {}, "cat"));
+  ASSERT_EQ(Ids({2}), search(index, {}, "categ"));
+  ASSERT_EQ(Ids({1, 2, 3}), search(index, {}, "c"));
+  ASSERT_EQ(Ids({1, 2}), search(index, {}, "do"));
+  ASSERT_EQ(Ids(), search(index, {}, "dogs"));
+  ASSERT_EQ(Ids(), search(index, {}, "e1"));
+  ASSERT_EQ(Ids({2, 3}), search(index, {"e3"}, "cow"));
+}
+
+TEST(StickerSetSearchIndex, update) {
+  td::StickerSetSearchIndex index;
+  index.add_sticker_set(get_sticker_set_id(1), {"e1", "e2"}, {"cat", "dog"});
+  index.add_sticker_set(get_sticker_set_id(2), {"e2"}, {"cat"});
+
+  // a reloaded sticker set replaces its old emojis and keywords
+  index.add_sticker_set(get_sticker_set_id(1), {"e3"}, {"cow"});
+  using Ids = td::vector<td::int64>;
+  ASSERT_EQ(Ids(), search(index, {"e1"}, ""));
+  ASSERT_EQ(Ids({2}), search(index, {"e2"}, ""));
+  ASSERT_EQ(Ids({1}), search(index, {"e3"}, ""));
+  ASSERT_EQ(Ids({2}), search(index, {}, "cat"));
+  ASSERT_EQ(Ids(), search(index, {}, "dog"));
+  ASSERT_EQ(Ids({1}), search(index, {}, "cow"));
+  ASSERT_EQ(2u, index.get_emoji_count());
+  ASSERT_EQ(2u, index.get_keyword_count());
+
+  index.remove_sticker_set(get_sticker_set_id(2));
+  index.remove_sticker_set(get_sticker_set_id(5));
+  ASSERT_EQ(Ids(), search(index, {"e2"}, "cat"));
+  ASSERT_EQ(1u, index.get_emoji_count());
+  ASSERT_EQ(1u, index.get_keyword_count());
+
+  index.add_sticker_set(get_sticker_set_id(1), {}, {});
+  ASSERT_EQ(Ids(), search(index, {"e3"}, "c"));
+  ASSERT_EQ(0u, index.get_emoji_count());
+  ASSERT_EQ(0u, index.get_keyword_count());
+}
@@ -8,8 +8,20 @@
 
 #include "td/telegram/Client.h"
 #include "td/telegram/ClientActor.h"
+#include "td/telegram/ColdObjectEvictor.h"
+#include "td/telegram/DialogId.h"
+#include "td/telegram/FileReferenceManager.h"
 #include "td/telegram/files/PartsManager.h"
+#include "td/telegram/Global.h"
+#include "td/telegram/logevent/LogEvent.h"
+#include "td/telegram/MemoryStatistics.h"
+#include "td/telegram/MessageFullId.h"
+#include "td/telegram/MessageId.h"
+#include "td/telegram/ServerMessageId.h"
+#include "td/telegram/StartupProfiler.h"
+#include "td/telegram/Td.h"
 #include "td/telegram/td_api.h"
+#include "td/telegram/WebPageInstantView.h"
 
 #include "td/actor/actor.h"
 #include "td/actor/ConcurrentScheduler.h"
@@ -32,6 +44,9 @@
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 #include "td/utils/tests.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
+#include "td/utils/WaitFreeHashMap.h"
 
 #include <atomic>
 #include <cstdio>
@@ -930,6 +945,55 @@ TEST(Client, Multi) {
   ASSERT_EQ(8 * 1000, ok_count.load());
 }
 
+TEST(Client, InlineMulti) {
+  td::vector<td::thread> threads;
+  std::atomic<int> ok_count{0};
+  for (int i = 0; i < 2; i++) {
+    threads.emplace_back([i, &ok_count] {
+      td::Client client(true);
+      // requests can be sent from any thread, but are processed only by the thread calling receive
+      td::thread sender([&client, i] {
+        for (int j = 0; j < 100; j++) {
+          auto request_id = static_cast<td::uint64>(j + 2 + 1000 * i);
+          client.send({request_id, td::make_tl_object<td::td_api::testSquareInt>(j)});
+        }
+      });
+      sender.join();
+
+      int received_count = 0;
+      while (received_count < 100) {
+        auto result = client.receive(10);
+        if (result.id == 0) {
+          ASSERT_TRUE(result.object != nullptr);
+          continue;
+        }
+        auto j = static_cast<int>(result.id) - 2 - 1000 * i;
+        ASSERT_TRUE(0 <= j && j < 100);
+        ASSERT_EQ(td::td_api::testInt::ID, result.object->get_id());
+        ASSERT_EQ(j * j, static_cast<const td::td_api::testInt &>(*result.object).value_);
+        received_count++;
+      }
+      ok_count += received_count;
+
+      client.send({1, td::make_tl_object<td::td_api::close>()});
+      while (true) {
+        auto result = client.receive(10);
+        if (result.id == 0 && result.object != nullptr &&
+            result.object->get_id() == td::td_api::updateAuthorizationState::ID &&
+            static_cast<const td::td_api::updateAuthorizationState *>(result.object.get())
+                    ->authorization_state_->get_id() == td::td_api::authorizationStateClosed::ID) {
+          break;
+        }
+      }
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(2 * 100, ok_count.load());
+}
+
 TEST(Client, Manager) {
   td::vector<td::thread> threads;
   td::ClientManager client;
@@ -970,6 +1034,30 @@ TEST(Client, Manager) {
   }
 }
 
+TEST(Client, ManagerHighPriorityFirstRequest) {
+  td::ClientManager client;
+  int clients_n = 100;
+  for (int i = 0; i < clients_n; i++) {
+    auto id = client.create_client_id();
+    client.send(id, 2, td::make_tl_object<td::td_api::testSquareInt>(2));
+    client.send(client.create_client_id(), 3, td::make_tl_object<td::td_api::testSquareInt>(3), true);
+    client.send(id, 4, td::make_tl_object<td::td_api::testSquareInt>(4), true);
+  }
+
+  int received_n = 0;
+  while (received_n != 3 * clients_n) {
+    auto event = client.receive(10);
+    if (event.request_id == 0) {
+      continue;
+    }
+    ASSERT_TRUE(event.object != nullptr);
+    ASSERT_EQ(td::td_api::testInt::ID, event.object->get_id());
+    auto value = static_cast<int>(event.request_id);
+    ASSERT_EQ(value * value, static_cast<const td::td_api::testInt &>(*event.object).value_);
+    received_n++;
+  }
+}
+
 #if !TD_EVENTFD_UNSUPPORTED  // Client must be used from a single thread if there is no EventFd
 TEST(Client, Close) {
   std::atomic<bool> stop_send{false};
@@ -1179,6 +1267,38 @@ TEST(Client, ManagerCloseOneThread) {
   ASSERT_TRUE(sent_requests.empty());
 }
 
+TEST(Client, ManagerFastShutdown) {
+  td::ClientManager client_manager;
+  auto close_client = [&client_manager] {
+    auto client_id = client_manager.create_client_id();
+    client_manager.send(client_id, 1, td::make_tl_object<td::td_api::close>());
+    bool is_closed = false;
+    bool is_close_finished = false;
+    while (!is_closed || !is_close_finished) {
+      auto response = client_manager.receive(10.0);
+      if (response.object == nullptr || response.client_id != client_id) {
+        continue;
+      }
+      if (response.request_id == 1) {
+        ASSERT_EQ(td::td_api::ok::ID, response.object->get_id());
+        is_close_finished = true;
+      } else if (response.object->get_id() == td::td_api::updateAuthorizationState::ID) {
+        auto &update = static_cast<const td::td_api::updateAuthorizationState &>(*response.object);
+        is_closed = update.authorization_state_->get_id() == td::td_api::authorizationStateClosed::ID;
+      }
+    }
+  };
+
+  td::ClientManager::set_fast_shutdown(true);
+  ASSERT_TRUE(td::Td::is_fast_shutdown_enabled());
+  close_client();
+
+  // the mode must be disabled back, so that instances closed later free their memory
+  td::ClientManager::set_fast_shutdown(false);
+  ASSERT_TRUE(!td::Td::is_fast_shutdown_enabled());
+  close_client();
+}
+
 TEST(PartsManager, hands) {
   {
     td::PartsManager pm;
@@ -1190,3 +1310,434 @@ TEST(PartsManager, hands) {
     pm.init(1, 100000, true, 10, {0, 1, 2}, false, true).ensure_error();
   }
 }
+
+TEST(PartsManager, merged_parts) {
+  td::PartsManager pm;
+  pm.init(10 << 20, 10 << 20, true, 256 << 10, {}, false, false).ensure();
+  pm.set_max_merged_part_size(1 << 20);
+  pm.set_streaming_offset(0, 0);
+  for (int i = 0; i < 4; i++) {
+    auto part = pm.start_part(10 << 20).move_as_ok();
+    ASSERT_EQ(i, part.id);
+    ASSERT_EQ(static_cast<size_t>(256 << 10), part.size);
+    pm.on_part_ok(part.id, part.size, part.size).ensure();
+  }
+
+  auto part = pm.start_part(10 << 20).move_as_ok();
+  ASSERT_EQ(4, part.id);
+  ASSERT_EQ(1 << 20, part.offset);
+  ASSERT_EQ(static_cast<size_t>(1 << 20), part.size);
+  ASSERT_EQ(4, pm.get_pending_count());
+
+  auto small_part = pm.start_part(256 << 10).move_as_ok();
+  ASSERT_EQ(8, small_part.id);
+  ASSERT_EQ(static_cast<size_t>(256 << 10), small_part.size);
+
+  pm.on_part_failed(part.id);
+  ASSERT_EQ(1, pm.get_pending_count());
+  part = pm.start_part(10 << 20).move_as_ok();
+  ASSERT_EQ(4, part.id);
+  ASSERT_EQ(static_cast<size_t>(1 << 20), part.size);
+  pm.on_part_ok(part.id, part.size, part.size).ensure();
+  ASSERT_EQ(8, pm.get_unchecked_ready_prefix_count());
+  ASSERT_EQ(2 << 20, pm.get_ready_size());
+}
+
+namespace {
+struct CachedObject {
+  mutable bool is_recently_used = true;
+};
+}  // namespace
+
+TEST(ColdObjectEvictor, evict) {
+  td::WaitFreeHashMap<td::int64, td::unique_ptr<CachedObject>> objects;
+  for (td::int64 i = 1; i <= 10; i++) {
+    objects.set(i, td::make_unique<CachedObject>());
+  }
+  td::ColdObjectEvictor<td::int64> evictor;
+  auto can_evict = [](td::int64 key, const CachedObject *) {
+    return key != 1;
+  };
+  auto evict = [&](size_t max_object_count) {
+    auto keys = evictor.evict(objects, max_object_count, can_evict);
+    for (auto key : keys) {
+      objects.erase(key);
+    }
+    return keys.size();
+  };
+
+  // all objects were used after the creation
+  ASSERT_EQ(0u, evict(5));
+  ASSERT_EQ(10u, objects.calc_size());
+
+  // the object 2 is used again, so it gets the second chance
+  objects.get_pointer(2)->is_recently_used = true;
+  ASSERT_EQ(5u, evict(5));
+  ASSERT_EQ(5u, objects.calc_size());
+  ASSERT_EQ(5u, evictor.size());
+  ASSERT_TRUE(objects.get_pointer(1) != nullptr);
+  ASSERT_TRUE(objects.get_pointer(2) != nullptr);
+  ASSERT_TRUE(!evictor.is_evicted(1));
+  ASSERT_TRUE(!evictor.is_evicted(2));
+  ASSERT_EQ(0u, evict(5));
+
+  td::vector<td::int64> evicted_keys;
+  evictor.foreach([&](td::int64 key) { evicted_keys.push_back(key); });
+  ASSERT_EQ(5u, evicted_keys.size());
+  for (auto key : evicted_keys) {
+    ASSERT_TRUE(evictor.is_evicted(key));
+    ASSERT_TRUE(objects.get_pointer(key) == nullptr);
+  }
+
+  // a reloaded object is no longer evicted
+  auto reloaded_key = evicted_keys[0];
+  ASSERT_TRUE(evictor.on_load(reloaded_key));
+  ASSERT_TRUE(!evictor.on_load(reloaded_key));
+  ASSERT_TRUE(!evictor.is_evicted(reloaded_key));
+  ASSERT_EQ(4u, evictor.size());
+}
+
+TEST(ColdObjectEvictor, max_evicted_object_count) {
+  td::WaitFreeHashMap<td::int64, td::unique_ptr<CachedObject>> objects;
+  td::ColdObjectEvictor<td::int64> evictor;
+  auto can_evict = [](td::int64, const CachedObject *) {
+    return true;
+  };
+  size_t max_evicted_object_count = td::ColdObjectEvictor<td::int64>::MAX_EVICTED_OBJECT_COUNT_MULTIPLIER;
+  td::int64 next_key = 1;
+  for (int i = 0; i < 5; i++) {
+    while (objects.calc_size() < 2 * max_evicted_object_count) {
+      auto object = td::make_unique<CachedObject>();
+      object->is_recently_used = false;
+      objects.set(next_key++, std::move(object));
+    }
+    for (auto key : evictor.evict(objects, 1, can_evict)) {
+      objects.erase(key);
+    }
+    ASSERT_TRUE(evictor.size() <= max_evicted_object_count);
+  }
+  ASSERT_EQ(max_evicted_object_count, evictor.size());
+  ASSERT_EQ(2 * max_evicted_object_count, objects.calc_size());
+}
+
+TEST(FileReferenceManager, get_messages_in_batches) {
+  struct Query {
+    td::vector<td::MessageFullId> message_full_ids;
+    td::Promise<td::Unit> promise;
+  };
+  auto queries = std::make_shared<td::vector<Query>>();
+  auto get_messages = [queries](td::vector<td::MessageFullId> message_full_ids, td::Promise<td::Unit> promise) {
+    queries->push_back(Query{std::move(message_full_ids), std::move(promise)});
+  };
+  auto get_message_full_id = [](int i) {
+    return td::MessageFullId(td::DialogId(static_cast<td::int64>(i % 2 + 1)), td::MessageId(td::ServerMessageId(i)));
+  };
+
+  td::vector<td::MessageFullId> message_full_ids;
+  td::vector<td::Promise<td::Unit>> promises;
+  td::vector<int> results(6);  // 0 - not finished, 1 - success, 2 - error
+  for (int i = 1; i <= 6; i++) {
+    message_full_ids.push_back(get_message_full_id(i));
+    promises.push_back(td::PromiseCreator::lambda([&results, i](td::Result<td::Unit> result) {
+      results[i - 1] = result.is_ok() ? 1 : 2;
+    }));
+  }
+  td::FileReferenceManager::get_messages_in_batches(std::move(message_full_ids), std::move(promises), 4, get_messages);
+
+  ASSERT_EQ(2u, queries->size());
+  ASSERT_EQ(4u, (*queries)[0].message_full_ids.size());
+  ASSERT_TRUE((*queries)[0].message_full_ids[3] == get_message_full_id(4));
+  ASSERT_EQ(2u, (*queries)[1].message_full_ids.size());
+  ASSERT_TRUE((*queries)[1].message_full_ids[0] == get_message_full_id(5));
+
+  // a successful batch finishes all its repairs
+  (*queries)[1].promise.set_value(td::Unit());
+  ASSERT_EQ(td::vector<int>({0, 0, 0, 0, 1, 1}), results);
+
+  // messages of a failed batch are requested one by one
+  (*queries)[0].promise.set_error(td::Status::Error(400, "MESSAGE_ID_INVALID"));
+  ASSERT_EQ(6u, queries->size());
+  for (int i = 0; i < 4; i++) {
+    auto &query = (*queries)[2 + i];
+    ASSERT_EQ(1u, query.message_full_ids.size());
+    ASSERT_TRUE(query.message_full_ids[0] == get_message_full_id(i + 1));
+  }
+  (*queries)[2].promise.set_error(td::Status::Error(400, "MESSAGE_ID_INVALID"));
+  (*queries)[3].promise.set_value(td::Unit());
+  (*queries)[4].promise.set_value(td::Unit());
+  (*queries)[5].promise.set_value(td::Unit());
+  ASSERT_EQ(td::vector<int>({2, 1, 1, 1, 1, 1}), results);
+
+  // a single message is requested without batching
+  queries->clear();
+  td::FileReferenceManager::get_messages_in_batches(
+      {get_message_full_id(7)}, td::vector<td::Promise<td::Unit>>(1), 4, get_messages);
+  ASSERT_EQ(1u, queries->size());
+  ASSERT_EQ(1u, (*queries)[0].message_full_ids.size());
+}
+
+TEST(MemoryStatistics, entries) {
+  td::MemoryStatistics statistics;
+  statistics.add("FirstManager", "object", 10, 1000);
+  statistics.add_hash_map<td::int64, CachedObject>("FirstManager", "cached_object", 100);
+  statistics.add("SecondManager", "buffer", 0, 5000);
+
+  auto cached_object_size = statistics.get_total_size() - 6000;
+  ASSERT_TRUE(cached_object_size >= 100 * (sizeof(CachedObject) + sizeof(td::int64)));
+
+  auto object = statistics.get_memory_statistics_object();
+  ASSERT_EQ(3u, object->entries_.size());
+  ASSERT_EQ("FirstManager", object->entries_[0]->manager_name_);
+  ASSERT_EQ("object", object->entries_[0]->container_name_);
+  ASSERT_EQ(10, object->entries_[0]->object_count_);
+  ASSERT_EQ(1000, object->entries_[0]->estimated_size_);
+  ASSERT_EQ("cached_object", object->entries_[1]->container_name_);
+  ASSERT_EQ(100, object->entries_[1]->object_count_);
+  ASSERT_EQ(static_cast<td::int64>(cached_object_size), object->entries_[1]->estimated_size_);
+  ASSERT_EQ("SecondManager", object->entries_[2]->manager_name_);
+  ASSERT_EQ(0, object->entries_[2]->object_count_);
+
+  // entries of the same manager are grouped on one line
+  auto lines = td::full_split(object->statistics_, '\n');
+  ASSERT_EQ(3u, lines.size());
+  ASSERT_TRUE(td::begins_with(lines[0], "FirstManager: "));
+  ASSERT_TRUE(lines[0].find("[object_count:10]") != td::string::npos);
+  ASSERT_TRUE(lines[0].find("[cached_object_count:100]") != td::string::npos);
+  ASSERT_TRUE(td::begins_with(lines[1], "SecondManager: "));
+  ASSERT_TRUE(td::begins_with(lines[2], "Total: "));
+}
+
+TEST(StartupProfiler, summary) {
+  td::StartupProfiler profiler;
+  {
+    td::StartupProfiler::Phase phase(&profiler, "first_phase");
+    td::StartupProfiler::Phase ignored_phase(nullptr, "ignored_phase");
+  }
+  profiler.add_phase("multithreaded_phase", 2.0);
+  profiler.add_binlog_event(1, 10);
+  profiler.add_binlog_event(2, 1000);
+  profiler.add_binlog_event(1, 20);
+
+  td::StartupProfiler other_profiler;
+  other_profiler.add_phase("other_phase", 1.0, 0.5);
+  other_profiler.add_binlog_event(1, 30);
+  profiler.merge(std::move(other_profiler));
+
+  auto lines = td::full_split(profiler.get_summary(), '\n');
+  ASSERT_EQ(6u, lines.size());
+  ASSERT_TRUE(td::begins_with(lines[0], "first_phase: "));
+  ASSERT_TRUE(lines[0].find(" CPU") != td::string::npos);
+  ASSERT_TRUE(td::begins_with(lines[1], "multithreaded_phase: "));
+  ASSERT_TRUE(lines[1].find(" CPU") == td::string::npos);
+  ASSERT_TRUE(td::begins_with(lines[2], "other_phase: "));
+  // binlog events are aggregated by type and sorted by total size
+  ASSERT_TRUE(td::begins_with(lines[3], "Binlog events of type 2: 1 "));
+  ASSERT_TRUE(td::begins_with(lines[4], "Binlog events of type 1: 3 "));
+  ASSERT_TRUE(lines[5].empty());
+
+  ASSERT_TRUE(!profiler.is_finished());
+  profiler.finish("test");
+  ASSERT_TRUE(profiler.is_finished());
+  ASSERT_TRUE(profiler.get_summary().empty());
+
+  // nothing is recorded after the initialization is finished
+  {
+    td::StartupProfiler::Phase phase(&profiler, "late_phase");
+  }
+  profiler.add_phase("late_phase", 1.0);
+  profiler.add_binlog_event(1, 10);
+  ASSERT_TRUE(profiler.get_summary().empty());
+}
+
+namespace {
+// instant view in the layout, which was used before the header was moved before page blocks
+struct OldWebPageInstantView {
+  td::int32 hash_ = 0;
+  td::string url_;
+  td::int32 view_count_ = 0;
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    BEGIN_STORE_FLAGS();
+    STORE_FLAG(true);   // is_full
+    STORE_FLAG(true);   // is_loaded
+    STORE_FLAG(false);  // is_rtl
+    STORE_FLAG(true);   // is_v2
+    STORE_FLAG(true);   // has_url
+    STORE_FLAG(true);   // has_view_count
+    END_STORE_FLAGS();
+    td::store(td::vector<td::unique_ptr<td::WebPageBlock>>(), storer);
+    td::store(hash_, storer);
+    td::store(url_, storer);
+    td::store(view_count_, storer);
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    bool is_full;
+    bool is_loaded;
+    bool is_rtl;
+    bool is_v2;
+    bool has_url;
+    bool has_view_count;
+    BEGIN_PARSE_FLAGS();
+    PARSE_FLAG(is_full);
+    PARSE_FLAG(is_loaded);
+    PARSE_FLAG(is_rtl);
+    PARSE_FLAG(is_v2);
+    PARSE_FLAG(has_url);
+    PARSE_FLAG(has_view_count);
+    END_PARSE_FLAGS();
+    td::vector<td::unique_ptr<td::WebPageBlock>> page_blocks;
+    td::parse(page_blocks, parser);
+    td::parse(hash_, parser);
+    td::parse(url_, parser);
+    td::parse(view_count_, parser);
+  }
+};
+
+// log event parsers need the Global context
+class WebPageInstantViewTest final : public td::Actor {
+  void start_up() final {
+    auto old_context = set_context(std::make_shared<td::Global>());
+    run();
+    set_context(std::move(old_context));
+    td::Scheduler::instance()->finish();
+    stop();
+  }
+
+  static void run();
+};
+
+void WebPageInstantViewTest::run() {
+  td::WebPageInstantView instant_view;
+  instant_view.hash_ = 123;
+  instant_view.url_ = "https://telegram.org";
+  instant_view.view_count_ = 5;
+  instant_view.is_v2_ = true;
+  instant_view.is_full_ = true;
+  instant_view.is_loaded_ = true;
+  instant_view.is_empty_ = false;
+  auto value = td::log_event_store(instant_view);
+
+  // the header is parsed without page blocks, which are stored at the end
+  {
+    td::WebPageInstantView header;
+    td::LogEventParser parser(value.as_slice());
+    ASSERT_TRUE(header.parse_header(parser));
+    ASSERT_TRUE(parser.get_error() == nullptr);
+    ASSERT_EQ(123, header.hash_);
+    ASSERT_EQ("https://telegram.org", header.url_);
+    ASSERT_EQ(5, header.view_count_);
+    ASSERT_TRUE(header.is_v2_ && header.is_full_ && header.is_loaded_ && !header.is_empty_);
+    ASSERT_EQ(sizeof(td::int32), parser.get_left_len());  // the number of page blocks
+  }
+  {
+    td::WebPageInstantView parsed_instant_view;
+    td::log_event_parse(parsed_instant_view, value.as_slice()).ensure();
+    ASSERT_EQ(123, parsed_instant_view.hash_);
+    ASSERT_EQ(5, parsed_instant_view.view_count_);
+  }
+
+  // the old layout is still accepted, but page blocks are parsed together with the header
+  OldWebPageInstantView old_instant_view;
+  old_instant_view.hash_ = 456;
+  old_instant_view.url_ = "https://core.telegram.org";
+  old_instant_view.view_count_ = 7;
+  auto old_value = td::log_event_store(old_instant_view);
+  {
+    td::WebPageInstantView header;
+    td::LogEventParser parser(old_value.as_slice());
+    ASSERT_TRUE(!header.parse_header(parser));
+    ASSERT_EQ(0u, parser.get_left_len());
+    ASSERT_EQ(456, header.hash_);
+  }
+  {
+    td::WebPageInstantView parsed_instant_view;
+    td::log_event_parse(parsed_instant_view, old_value.as_slice()).ensure();
+    ASSERT_EQ(456, parsed_instant_view.hash_);
+    ASSERT_EQ("https://core.telegram.org", parsed_instant_view.url_);
+    ASSERT_EQ(7, parsed_instant_view.view_count_);
+    ASSERT_TRUE(parsed_instant_view.is_v2_ && !parsed_instant_view.is_rtl_);
+  }
+}
+}  // namespace
+
+TEST(WebPageInstantView, header_first) {
+  td::ConcurrentScheduler sched(0, 0);
+  sched.create_actor_unsafe<WebPageInstantViewTest>(0, "WebPageInstantViewTest").release();
+  sched.start();
+  while (sched.run_main(10)) {
+  }
+  sched.finish();
+}
+
+static td::string store_td_api_object(const td::td_api::Object &object) {
+  td::TlStorerCalcLength calc_length;
+  calc_length.store_int(object.get_id());
+  object.store(calc_length);
+
+  td::string result(calc_length.get_length(), '\0');
+  td::TlStorerUnsafe storer(td::MutableSlice(result).ubegin());
+  storer.store_int(object.get_id());
+  object.store(storer);
+  CHECK(storer.get_buf() == td::MutableSlice(result).uend());
+  return result;
+}
+
+TEST(Client, BinaryNullObjectRoundTrip) {
+  td::string request(256, '\0');
+  td::TlStorerUnsafe storer(td::MutableSlice(request).ubegin());
+  storer.store_int(td::td_api::sendMessage::ID);
+  storer.store_long(12345);
+  storer.store_long(0);
+  storer.store_int(0);  // reply_to
+  storer.store_int(0);  // options
+  storer.store_int(0);  // reply_markup
+  storer.store_int(1);  // input_message_content
+  storer.store_int(td::td_api::inputMessageText::ID);
+  storer.store_int(1);  // text
+  storer.store_string(td::Slice("text"));
+  storer.store_int(0);  // entities
+  storer.store_int(0);  // link_preview_options
+  storer.store_binary(static_cast<td::int32>(0x997275b5));  // clear_draft
+  request.resize(storer.get_buf() - td::MutableSlice(request).ubegin());
+
+  td::TlParser request_parser(request);
+  auto function = td::td_api::Function::fetch(request_parser);
+  request_parser.fetch_end();
+  request_parser.get_status().ensure();
+  ASSERT_TRUE(function != nullptr);
+  ASSERT_EQ(td::td_api::sendMessage::ID, function->get_id());
+  auto &parsed_request = static_cast<const td::td_api::sendMessage &>(*function);
+  ASSERT_EQ(12345, parsed_request.chat_id_);
+  ASSERT_TRUE(parsed_request.reply_to_ == nullptr);
+  ASSERT_TRUE(parsed_request.options_ == nullptr);
+  ASSERT_TRUE(parsed_request.reply_markup_ == nullptr);
+  ASSERT_TRUE(parsed_request.input_message_content_ != nullptr);
+  auto &content = static_cast<const td::td_api::inputMessageText &>(*parsed_request.input_message_content_);
+  ASSERT_TRUE(content.text_ != nullptr);
+  ASSERT_STREQ("text", content.text_->text_);
+  ASSERT_TRUE(content.link_preview_options_ == nullptr);
+  ASSERT_TRUE(content.clear_draft_);
+
+  td::td_api::venue venue(nullptr, "title", "address", "provider", "id", "type");
+  auto stored_venue = store_td_api_object(venue);
+  td::TlParser venue_parser(stored_venue);
+  auto object = td::td_api::Object::fetch(venue_parser);
+  venue_parser.fetch_end();
+  venue_parser.get_status().ensure();
+  ASSERT_TRUE(object != nullptr);
+  ASSERT_EQ(td::td_api::venue::ID, object->get_id());
+  auto &parsed_venue = static_cast<const td::td_api::venue &>(*object);
+  ASSERT_TRUE(parsed_venue.location_ == nullptr);
+  ASSERT_STREQ("title", parsed_venue.title_);
+  ASSERT_EQ(stored_venue, store_td_api_object(parsed_venue));
+
+  auto truncated_venue = stored_venue.substr(0, 4);
+  truncated_venue += td::string(4, '\x02');
+  td::TlParser bad_parser(truncated_venue);
+  td::td_api::Object::fetch(bad_parser);
+  bad_parser.fetch_end();
+  ASSERT_TRUE(bad_parser.get_error() != nullptr);
+}
@@ -21,6 +21,7 @@
 #include "td/utils/Time.h"
 
 #include <memory>
+#include <set>
 #include <utility>
 
 TEST(TQueue, hands) {
@@ -43,6 +44,38 @@ TEST(TQueue, hands) {
   ASSERT_EQ(0u, tqueue->get(qid, head, true, 0, events_span).move_as_ok());
 }
 
+TEST(TQueue, export_events) {
+  td::TQueue::Event events[100];
+  auto events_span = td::MutableSpan<td::TQueue::Event>(events, 100);
+
+  auto tqueue = td::TQueue::create();
+  auto qid = 12;
+  for (auto data : {"a", "bcd", "ef"}) {
+    tqueue->push(qid, data, 1, 0, td::TQueue::EventId()).ensure();
+  }
+  ASSERT_EQ(3u, tqueue->get(qid, tqueue->get_head(qid), false, 0, events_span).move_as_ok());
+  ASSERT_EQ(3u, events_span.size());
+
+  auto io_slices = td::TQueue::get_io_slices(events_span, ",");
+  ASSERT_EQ(5u, io_slices.size());
+  td::string joined;
+  for (auto &io_slice : io_slices) {
+    joined += td::as_slice(io_slice).str();
+  }
+  ASSERT_EQ("a,bcd,ef", joined);
+  ASSERT_EQ(3u, td::TQueue::get_io_slices(events_span).size());
+
+  td::string buffer(6, '\0');
+  size_t offsets[3];
+  ASSERT_EQ(6u, td::TQueue::copy_data(events_span, buffer, td::MutableSpan<size_t>(offsets, 3)).move_as_ok());
+  ASSERT_EQ("abcdef", buffer);
+  ASSERT_EQ(0u, offsets[0]);
+  ASSERT_EQ(1u, offsets[1]);
+  ASSERT_EQ(4u, offsets[2]);
+  td::string small_buffer(5, '\0');
+  ASSERT_TRUE(td::TQueue::copy_data(events_span, small_buffer, td::MutableSpan<size_t>(offsets, 3)).is_error());
+}
+
 class TestTQueue {
  public:
   using EventId = td::TQueue::EventId;
@@ -119,6 +152,44 @@ class TestTQueue {
     return a_id;
   }
 
+  EventId push_batch(td::TQueue::QueueId queue_id, const td::vector<td::string> &data, td::int32 expires_at,
+                     EventId new_id = EventId()) {
+    auto create_events = [&] {
+      td::vector<td::TQueue::RawEvent> events;
+      for (auto &event_data : data) {
+        td::TQueue::RawEvent event;
+        event.data = event_data;
+        event.expires_at = expires_at;
+        events.push_back(std::move(event));
+      }
+      return events;
+    };
+    auto a_id = baseline_->push_batch(queue_id, create_events(), new_id).move_as_ok();
+    auto b_id = memory_->push_batch(queue_id, create_events(), new_id).move_as_ok();
+    auto c_id = binlog_->push_batch(queue_id, create_events(), new_id).move_as_ok();
+    ASSERT_EQ(a_id, b_id);
+    ASSERT_EQ(a_id, c_id);
+    return a_id;
+  }
+
+  void push_many(const td::vector<td::TQueue::QueueId> &queue_ids, const td::string &data, td::int32 expires_at,
+                 EventId new_id = EventId()) {
+    auto a_ids = baseline_->push_many(queue_ids, data, expires_at, 0, new_id);
+    auto b_ids = memory_->push_many(queue_ids, data, expires_at, 0, new_id);
+    auto c_ids = binlog_->push_many(queue_ids, data, expires_at, 0, new_id);
+    ASSERT_EQ(queue_ids.size(), a_ids.size());
+    ASSERT_EQ(queue_ids.size(), b_ids.size());
+    ASSERT_EQ(queue_ids.size(), c_ids.size());
+    for (size_t i = 0; i < queue_ids.size(); i++) {
+      ASSERT_EQ(a_ids[i].is_ok(), b_ids[i].is_ok());
+      ASSERT_EQ(a_ids[i].is_ok(), c_ids[i].is_ok());
+      if (a_ids[i].is_ok()) {
+        ASSERT_EQ(a_ids[i].ok(), b_ids[i].ok());
+        ASSERT_EQ(a_ids[i].ok(), c_ids[i].ok());
+      }
+    }
+  }
+
   void check_head_tail(td::TQueue::QueueId qid) {
     //ASSERT_EQ(baseline_->get_head(qid), memory_->get_head(qid));
     //ASSERT_EQ(baseline_->get_head(qid), binlog_->get_head(qid));
@@ -186,6 +257,20 @@ TEST(TQueue, random) {
     }
     q.push(next_queue_id(), data, now + rnd.fast(-10, 10) * 10 + 5, next_first_id());
   };
+  auto push_event_batch = [&] {
+    td::vector<td::string> data(rnd.fast(1, 10));
+    for (auto &event_data : data) {
+      event_data = PSTRING() << rnd();
+    }
+    q.push_batch(next_queue_id(), data, now + rnd.fast(-10, 10) * 10 + 5, next_first_id());
+  };
+  auto push_event_many = [&] {
+    td::vector<td::TQueue::QueueId> queue_ids(rnd.fast(1, 5));
+    for (auto &queue_id : queue_ids) {
+      queue_id = next_queue_id();
+    }
+    q.push_many(queue_ids, PSTRING() << rnd(), now + rnd.fast(-10, 10) * 10 + 5, next_first_id());
+  };
   auto inc_now = [&] {
     now += 10;
   };
@@ -198,7 +283,13 @@ TEST(TQueue, random) {
   auto get = [&] {
     q.check_get(next_queue_id(), rnd, now);
   };
-  td::RandomSteps steps({{push_event, 100}, {check_head_tail, 10}, {get, 40}, {inc_now, 5}, {restart, 1}});
+  td::RandomSteps steps({{push_event, 100},
+                         {push_event_batch, 10},
+                         {push_event_many, 10},
+                         {check_head_tail, 10},
+                         {get, 40},
+                         {inc_now, 5},
+                         {restart, 1}});
   for (int i = 0; i < 100000; i++) {
     steps.step(rnd);
   }
@@ -258,3 +349,90 @@ TEST(TQueue, clear) {
   CHECK(tqueue->get_tail(1) == tail_id);
   CHECK(deleted_events.size() == 100000 - keep_count);
 }
+
+TEST(TQueue, forget) {
+  auto tqueue = td::TQueue::create();
+  tqueue->set_callback(td::make_unique<td::TQueueMemoryStorage>());
+
+  auto start_time = td::Time::now();
+  td::int32 now = 0;
+  td::vector<td::TQueue::EventId> ids;
+  std::set<td::int32> alive_ids;
+  td::Random::Xorshift128plus rnd(123);
+  td::TQueue::Event events[10];
+  auto check_get = [&] {
+    auto events_span = td::MutableSpan<td::TQueue::Event>(events, 10);
+    auto from_id = ids[rnd.fast(0, static_cast<int>(ids.size()) - 1)];
+    auto size = tqueue->get(1, from_id, false, now, events_span).move_as_ok();
+    ASSERT_EQ(alive_ids.size(), size);
+    auto it = alive_ids.lower_bound(from_id.value());
+    for (auto &event : events_span) {
+      ASSERT_TRUE(it != alive_ids.end());
+      ASSERT_EQ(*it, event.id.value());
+      ASSERT_EQ(td::Slice(PSLICE() << event.id.value()), event.data);
+      ++it;
+    }
+    ASSERT_TRUE(events_span.size() == 10 || it == alive_ids.end());
+  };
+  for (int i = 0; i < 300000; i++) {
+    auto event_id = tqueue->get_tail(1);
+    if (event_id.empty()) {
+      event_id = td::TQueue::EventId::from_int32(1).move_as_ok();
+    }
+    auto id = tqueue->push(1, PSTRING() << event_id.value(), now + 600000, 0, event_id).move_as_ok();
+    ASSERT_EQ(event_id, id);
+    ids.push_back(id);
+    alive_ids.insert(id.value());
+    if (alive_ids.size() > static_cast<std::size_t>(rnd.fast(0, 1000))) {
+      std::swap(ids.back(), ids[rnd.fast(0, static_cast<int>(ids.size()) - 1)]);
+      tqueue->forget(1, ids.back());
+      alive_ids.erase(ids.back().value());
+      ids.pop_back();
+    }
+    if (i % 100 == 0) {
+      check_get();
+    }
+    now++;
+  }
+  LOG(INFO) << "Pushed and forgot TQueue events in " << td::Time::now() - start_time << " seconds";
+  ASSERT_EQ(tqueue->get_head(1).value(), *alive_ids.begin());
+  check_get();
+}
+
+TEST(TQueue, gc) {
+  auto tqueue = td::TQueue::create();
+  tqueue->set_callback(td::make_unique<td::TQueueMemoryStorage>());
+  ASSERT_EQ(0, tqueue->get_next_gc_time());
+
+  td::Random::Xorshift128plus rnd(123);
+  td::int32 now = 1000;
+  td::int64 expired_event_count = 0;
+  td::int32 min_expires_at = 1000000;
+  for (td::TQueue::QueueId queue_id = 1; queue_id <= 1000; queue_id++) {
+    auto expires_at = now + rnd.fast(-100, 100);
+    for (int i = 0; i < 100; i++) {
+      expires_at += rnd.fast(0, 5);
+      if (expires_at <= now) {
+        expired_event_count++;
+      }
+      min_expires_at = td::min(min_expires_at, expires_at);
+      tqueue->push(queue_id, "a", expires_at, 0, td::TQueue::EventId()).ensure();
+    }
+  }
+  ASSERT_EQ(min_expires_at, tqueue->get_next_gc_time());
+
+  td::int64 deleted_event_count = 0;
+  int call_count = 0;
+  while (true) {
+    auto result = tqueue->run_gc(now + 1, 0.0);
+    deleted_event_count += result.first;
+    call_count++;
+    if (result.second) {
+      break;
+    }
+  }
+  LOG(INFO) << "Deleted " << deleted_event_count << " expired TQueue events in " << call_count << " calls";
+  ASSERT_EQ(expired_event_count, deleted_event_count);
+  ASSERT_TRUE(tqueue->get_next_gc_time() > now);
+  ASSERT_EQ(0, tqueue->run_gc(now + 1, 0.0).first);
+}